@@ -0,0 +1,61 @@
+<?php
+/**
+ * This file is part of Swow
+ *
+ * @link    https://github.com/swow/swow
+ * @contact twosee <twosee@php.net>
+ *
+ * For the full copyright and license information,
+ * please view the LICENSE file that was distributed with this source code
+ */
+
+declare(strict_types=1);
+
+use Swow\Channel;
+use Swow\Coroutine;
+
+$times = 1000 * 10000;
+$capacity = (int) ($argv[1] ?? 1024);
+$batch = (int) ($argv[2] ?? 64);
+
+$report = static function (string $name, float $use) use ($times): void {
+    $ns = $use * (1000 * 1000 * 1000) / $times;
+    $qps = $times * (1 / $use);
+    echo sprintf('%-10s Use %fs for %d times, %fns/t, qps=%f' . PHP_EOL, $name, $use, $times, $ns, $qps);
+};
+
+/* one by one */
+$channel = new Channel($capacity);
+Coroutine::run(static function () use ($channel): void {
+    while ($channel->pop()) {
+        continue;
+    }
+});
+$use = microtime(true);
+for ($n = $times; $n--;) {
+    $channel->push(true);
+}
+$channel->push(false);
+$use = microtime(true) - $use;
+$report('push/pop', $use);
+
+/* in batch */
+$channel = new Channel($capacity);
+Coroutine::run(static function () use ($channel, $batch): void {
+    while (true) {
+        foreach ($channel->popMany($batch) as $data) {
+            if (!$data) {
+                break 2;
+            }
+        }
+    }
+});
+$data = array_fill(0, $batch, true);
+$use = microtime(true);
+for ($n = $times; $n > 0;) {
+    $pushed = $channel->pushMany($n >= $batch ? $data : array_slice($data, 0, $n));
+    $n -= $pushed;
+}
+$channel->push(false);
+$use = microtime(true) - $use;
+$report('pushMany', $use);
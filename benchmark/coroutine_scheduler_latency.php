@@ -0,0 +1,85 @@
+<?php
+/**
+ * This file is part of Swow
+ *
+ * @link    https://github.com/swow/swow
+ * @contact twosee <twosee@php.net>
+ *
+ * For the full copyright and license information,
+ * please view the LICENSE file that was distributed with this source code
+ */
+
+declare(strict_types=1);
+
+use Swow\Coroutine;
+
+/* usage: php coroutine_scheduler_latency.php [bulk coroutines] [seconds per case] [work per slice in us] */
+$bulkCount = (int) ($argv[1] ?? 100);
+$seconds = (float) ($argv[2] ?? 2);
+$work = (int) ($argv[3] ?? 50);
+
+/* burn CPU for about $us microseconds */
+$burn = static function (int $us): void {
+    $deadline = hrtime(true) + $us * 1000;
+    while (hrtime(true) < $deadline);
+};
+
+$cases = [
+    'immediate' => [false, Coroutine::PRIORITY_NORMAL, 0, 0],
+    'ready queue' => [true, Coroutine::PRIORITY_NORMAL, 0, 0],
+    'ready queue + high' => [true, Coroutine::PRIORITY_HIGH, 0, 0],
+    'ready queue + high + 1ms budget' => [true, Coroutine::PRIORITY_HIGH, 0, 1000],
+    'ready queue + high + 16 budget' => [true, Coroutine::PRIORITY_HIGH, 16, 0],
+];
+
+echo sprintf('%-32s %10s %10s %10s %10s %12s' . PHP_EOL, 'case', 'avg(us)', 'p50(us)', 'p99(us)', 'max(us)', 'bulk slices');
+foreach ($cases as $name => [$enabled, $priority, $budgetCount, $budgetTime]) {
+    if ($enabled) {
+        Coroutine::enableReadyQueue($budgetCount, $budgetTime);
+    } else {
+        Coroutine::disableReadyQueue();
+    }
+    $running = true;
+    $slices = 0;
+    $bulks = [];
+    for ($n = 0; $n < $bulkCount; $n++) {
+        $bulks[] = Coroutine::run(static function () use (&$running, &$slices, $burn, $work): void {
+            while ($running) {
+                $burn($work);
+                $slices++;
+                msleep(0);
+            }
+        });
+    }
+    /* the probe sleeps 1ms each time and records how late it is woken up */
+    $latencies = [];
+    $probe = new Coroutine(static function () use (&$running, &$latencies, $seconds): void {
+        $end = hrtime(true) + (int) ($seconds * 1000 * 1000 * 1000);
+        while (($start = hrtime(true)) < $end) {
+            msleep(1);
+            $latencies[] = max(0, (hrtime(true) - $start) / 1000 - 1000);
+        }
+        $running = false;
+    });
+    $probe->setPriority($priority)->resume();
+    while ($running) {
+        msleep(10);
+    }
+    foreach ($bulks as $bulk) {
+        while ($bulk->isAlive()) {
+            msleep(1);
+        }
+    }
+    sort($latencies);
+    $count = count($latencies);
+    echo sprintf(
+        '%-32s %10.1f %10.1f %10.1f %10.1f %12d' . PHP_EOL,
+        $name,
+        array_sum($latencies) / $count,
+        $latencies[intdiv($count, 2)],
+        $latencies[min($count - 1, (int) ($count * 0.99))],
+        $latencies[$count - 1],
+        $slices
+    );
+}
+Coroutine::disableReadyQueue();
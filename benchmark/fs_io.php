@@ -0,0 +1,71 @@
+<?php
+/**
+ * This file is part of Swow
+ *
+ * @link    https://github.com/swow/swow
+ * @contact twosee <twosee@php.net>
+ *
+ * For the full copyright and license information,
+ * please view the LICENSE file that was distributed with this source code
+ */
+
+declare(strict_types=1);
+
+use Swow\Coroutine;
+use Swow\Sync\WaitReference;
+
+/* usage: php fs_io.php [coroutines] [operations per coroutine] [block size]
+ * run it with CAT_FS_IO_URING=0 and CAT_FS_IO_URING=1 to compare thread pool and io_uring (or use fs_io.sh) */
+$concurrency = (int) ($argv[1] ?? 64);
+$times = (int) ($argv[2] ?? 1000);
+$blockSize = (int) ($argv[3] ?? 4096);
+
+$block = str_repeat('x', $blockSize);
+$paths = [];
+for ($c = 0; $c < $concurrency; $c++) {
+    $paths[$c] = sys_get_temp_dir() . "/swow-benchmark-fs-io-{$c}";
+    file_put_contents($paths[$c], $block);
+}
+
+$cases = [
+    'write' => static function ($file, string $path) use ($block): void {
+        fseek($file, 0);
+        fwrite($file, $block);
+    },
+    'read' => static function ($file, string $path) use ($blockSize): void {
+        fseek($file, 0);
+        fread($file, $blockSize);
+    },
+    'stat' => static function ($file, string $path): void {
+        clearstatcache();
+        stat($path);
+    },
+    'open+close' => static function ($file, string $path): void {
+        fclose(fopen($path, 'r'));
+    },
+];
+
+/* io_uring is used by default if it is available */
+$backend = getenv('CAT_FS_IO_URING') === '0' ? 'threadpool' : 'io_uring';
+echo sprintf('%-10s %-12s %12s %12s' . PHP_EOL, 'backend', 'case', 'ops/s', 'us/op');
+foreach ($cases as $name => $case) {
+    $use = microtime(true);
+    $wr = new WaitReference();
+    foreach ($paths as $path) {
+        Coroutine::run(static function () use ($path, $case, $times, $wr): void {
+            $file = fopen($path, 'r+');
+            for ($n = $times; $n--;) {
+                $case($file, $path);
+            }
+            fclose($file);
+        });
+    }
+    WaitReference::wait($wr);
+    $use = microtime(true) - $use;
+    $operations = $concurrency * $times;
+    echo sprintf('%-10s %-12s %12.0f %12.2f' . PHP_EOL, $backend, $name, $operations / $use, $use * 1000 * 1000 / $operations);
+}
+
+foreach ($paths as $path) {
+    unlink($path);
+}
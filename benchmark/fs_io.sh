@@ -0,0 +1,10 @@
+#!/bin/bash
+__DIR__=$(cd "$(dirname "$0")" || exit 1; pwd); [ -z "${__DIR__}" ] && exit 1
+
+# Usage: fs_io.sh [coroutines] [operations per coroutine] [block size]
+# Runs the same file I/O workload on the thread pool and on io_uring
+# (it falls back to the thread pool if the kernel does not support io_uring).
+
+for io_uring in 0 1; do
+  CAT_FS_IO_URING=${io_uring} /usr/bin/env php -dextension=swow "${__DIR__}/fs_io.php" "$@"
+done
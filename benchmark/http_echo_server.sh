@@ -6,11 +6,16 @@ ulimit -n 8192
 export SERVER_HOST=127.0.0.1
 export SERVER_PORT=9764
 export SERVER_BACKLOG=8192
-/usr/bin/env php -dextension=swow "${__DIR__}/../examples/http_server/echo.php" &
+# e.g. PHP="php -dextension=/path/to/baseline/swow.so" to compare with another build
+PHP=${PHP:-"/usr/bin/env php -dextension=swow"}
+CONCURRENCY=${CONCURRENCY:-1024}
+REQUESTS=${REQUESTS:-1000000}
+
+${PHP} "${__DIR__}/../examples/http_server/echo.php" &
 pid=$!
 
 sleep 1
-ab -c 1024 -n 1000000 -k "http://${SERVER_HOST}:${SERVER_PORT}/"
+ab -c "${CONCURRENCY}" -n "${REQUESTS}" -k "http://${SERVER_HOST}:${SERVER_PORT}/"
 
 kill ${pid}
 wait ${pid}
@@ -0,0 +1,88 @@
+#!/bin/bash
+__DIR__=$(cd "$(dirname "$0")" || exit 1; pwd); [ -z "${__DIR__}" ] && exit 1
+
+# Usage: [WORKERS=N] [CPU_AFFINITY=0|1] http_echo_server_reuseport.sh
+# Each worker is pinned to one CPU and reports how many connections it accepted,
+# run it with CPU_AFFINITY=0 and CPU_AFFINITY=1 to compare the balance.
+
+# shellcheck disable=SC2039
+ulimit -n 10240
+
+export SERVER_HOST=127.0.0.1
+export SERVER_PORT=9764
+export SERVER_BACKLOG=8192
+export SERVER_MULTI=1
+export SERVER_STATS=1
+export SERVER_CPU_AFFINITY=${CPU_AFFINITY:-1}
+
+workers=${WORKERS:-$(nproc)}
+output=$(mktemp -d)
+
+i=0
+while [ ${i} -lt "${workers}" ]; do
+  taskset -c ${i} /usr/bin/env php -dextension=swow -dmemory_limit=1G "${__DIR__}/../examples/http_server/echo.php" > "${output}/${i}.log" &
+  processes[i]=$!;
+  # listeners join the reuseport group in order (the N-th one serves CPU N if it can not use SO_INCOMING_CPU),
+  # so wait until this one is listening before starting the next one
+  while [ "$(ss -Hltn "sport = :${SERVER_PORT}" | wc -l)" -le ${i} ]; do
+    if ! kill -0 ${processes[i]} 2>/dev/null; then
+      echo "worker ${i} exited before listening" >&2
+      cat "${output}/${i}.log" >&2
+      kill -TERM "${processes[@]}" 2>/dev/null
+      exit 1
+    fi
+    sleep 0.01
+  done
+  i=$((i+1));
+done
+
+# on loopback the connection is received on the CPU of the client,
+# so clients are spread over CPUs like what RSS does for a real NIC
+i=0
+while [ ${i} -lt "${workers}" ]; do
+  taskset -c ${i} ab -c $((4096 / workers)) -n $((200000 / workers)) "http://${SERVER_HOST}:${SERVER_PORT}/" > "${output}/ab.${i}.log" 2>&1 &
+  clients[i]=$!;
+  i=$((i+1));
+done
+i=0
+while [ ${i} -lt "${workers}" ]; do
+  wait ${clients[i]}
+  i=$((i+1));
+done
+cat "${output}"/ab.*.log | awk '/^Requests per second/ { rps += $4 } /^Failed requests/ { failed += $3 } END { printf("requests_per_second=%.2f failed=%d\n", rps, failed) }'
+
+i=0
+while [ ${i} -lt "${workers}" ]; do
+  pid=${processes[i]}
+  kill -TERM ${pid}
+  wait ${pid}
+  i=$((i+1));
+done
+
+echo "cpu_affinity=${SERVER_CPU_AFFINITY} workers=${workers}"
+i=0
+while [ ${i} -lt "${workers}" ]; do
+  grep -h "\[accept-stats\]" "${output}/${i}.log" | sed "s/^/cpu=${i} /"
+  i=$((i+1));
+done | awk '
+{
+  print;
+  for (n = 1; n <= NF; n++) {
+    if (split($n, kv, "=") == 2 && kv[1] == "count") {
+      counts[NR] = kv[2]; total += kv[2];
+    }
+  }
+}
+END {
+  if (NR == 0 || total == 0) { exit 1; }
+  min = max = counts[1];
+  for (n = 1; n <= NR; n++) {
+    if (counts[n] < min) { min = counts[n]; }
+    if (counts[n] > max) { max = counts[n]; }
+    mean = total / NR; variance += (counts[n] - mean) ^ 2;
+  }
+  printf("total=%d min=%d max=%d max/min=%.3f stddev/mean=%.3f\n",
+    total, min, max, min > 0 ? max / min : 0, sqrt(variance / NR) / mean);
+}'
+
+rm -rf "${output}"
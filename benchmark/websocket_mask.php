@@ -0,0 +1,74 @@
+<?php
+/**
+ * This file is part of Swow
+ *
+ * @link    https://github.com/swow/swow
+ * @contact twosee <twosee@php.net>
+ *
+ * For the full copyright and license information,
+ * please view the LICENSE file that was distributed with this source code
+ */
+
+declare(strict_types=1);
+
+use Swow\Buffer;
+use Swow\WebSocket\WebSocket;
+
+/* usage: php websocket_mask.php [total bytes per case in MB] */
+$total = (int) ($argv[1] ?? 256) * 1024 * 1024;
+$maskingKey = "\x12\x9a\x5c\xf0";
+$sizes = [16, 64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 16777216];
+
+$report = static function (string $implementation, string $case, int $size, int $times, float $use): void {
+    $gbps = $size * $times / $use / (1000 * 1000 * 1000);
+    $ns = $use * (1000 * 1000 * 1000) / $times;
+    echo sprintf('%-7s %-14s %9dB %10.3fGB/s %12.2fns/op' . PHP_EOL, $implementation, $case, $size, $gbps, $ns);
+};
+
+$default = WebSocket::getMaskImplementation();
+echo "default implementation: {$default}" . PHP_EOL;
+
+foreach (['scalar', 'sse2', 'avx2', 'avx512', 'neon'] as $implementation) {
+    if (!WebSocket::setMaskImplementation($implementation)) {
+        continue;
+    }
+    foreach ($sizes as $size) {
+        $times = max(intdiv($total, $size), 16);
+        $text = str_repeat('a', $size);
+        $masked = WebSocket::mask($text, maskingKey: $maskingKey);
+        $data = new Buffer($size);
+        $data->append($masked);
+        $output = new Buffer($size);
+
+        /* in place */
+        $use = microtime(true);
+        for ($n = $times; $n--;) {
+            WebSocket::unmask($data, maskingKey: $maskingKey);
+        }
+        $use = microtime(true) - $use;
+        $report($implementation, 'unmask', $size, $times, $use);
+
+        /* fused with copy */
+        $use = microtime(true);
+        for ($n = $times; $n--;) {
+            $output->clear();
+            WebSocket::unmaskTo($output, $data, maskingKey: $maskingKey);
+        }
+        $use = microtime(true) - $use;
+        $report($implementation, 'unmaskTo', $size, $times, $use);
+
+        /* fused with copy and UTF-8 validation */
+        $use = microtime(true);
+        for ($n = $times; $n--;) {
+            $output->clear();
+            $utf8State = WebSocket::UTF8_ACCEPT;
+            WebSocket::unmaskTo($output, $masked, maskingKey: $maskingKey, utf8State: $utf8State);
+        }
+        $use = microtime(true) - $use;
+        if ($utf8State !== WebSocket::UTF8_ACCEPT) {
+            throw new Error('Unexpected invalid UTF-8');
+        }
+        $report($implementation, 'unmaskTo+utf8', $size, $times, $use);
+    }
+}
+WebSocket::setMaskImplementation($default);
@@ -15,6 +15,7 @@ use Swow\Buffer;
 use Swow\Coroutine;
 use Swow\Http\Parser;
 use Swow\Http\ParserException;
+use Swow\Signal;
 use Swow\Socket;
 use Swow\SocketException;
 
@@ -22,13 +23,27 @@ $host = getenv('SERVER_HOST') ?: '127.0.0.1';
 $port = (int) (getenv('SERVER_PORT') ?: 9764);
 $backlog = (int) (getenv('SERVER_BACKLOG') ?: 8192);
 $multi = (bool) (getenv('SERVER_MULTI') ?: false);
+$cpuAffinity = (bool) (getenv('SERVER_CPU_AFFINITY') ?: false);
+$stats = (bool) (getenv('SERVER_STATS') ?: false);
 $bindFlag = Socket::BIND_FLAG_NONE;
 
 $server = new Socket(Socket::TYPE_TCP);
 if ($multi) {
-    $bindFlag |= Socket::BIND_FLAG_REUSEPORT;
+    /* the N-th listener accepts connections received on CPU N, so workers should be bound to CPUs in order */
+    $bindFlag |= $cpuAffinity ? Socket::BIND_FLAG_REUSEPORT_CPU_AFFINITY : Socket::BIND_FLAG_REUSEPORT;
 }
 $server->bind($host, $port, $bindFlag)->listen($backlog);
+if ($stats) {
+    Coroutine::run(static function () use ($server): void {
+        Signal::wait(Signal::TERM);
+        $stats = $server->getAcceptStats();
+        printf(
+            "[accept-stats] pid=%d count=%d rate=%.2f queue=%d/%d\n",
+            getmypid(), $stats['count'], $stats['rate'], $stats['queue_length'], $stats['queue_capacity']
+        );
+        $server->close();
+    });
+}
 while (true) {
     try {
         $connection = $server->accept();
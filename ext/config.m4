@@ -190,6 +190,12 @@ PHP_ARG_ENABLE([swow-curl],
   [yes], [no]
 )
 
+PHP_ARG_ENABLE([swow-zlib],
+  [whether to enable Swow zlib support],
+  [AS_HELP_STRING([--enable-swow-zlib], [Enable Swow zlib support (for WebSocket permessage-deflate)])],
+  [yes], [no]
+)
+
 PHP_ARG_ENABLE([swow-pdo-pgsql],
   [whether to enable Swow PDO_PGSQL support],
   [AS_HELP_STRING([--enable-swow-pdo-pgsql], [Enable Swow PDO_PGSQL support])],
@@ -384,6 +390,8 @@ EOF
     swow_stream.c \
     swow_stream_wrapper.c \
     swow_signal.c \
+    swow_work.c \
+    swow_thread.c \
     swow_watchdog.c \
     swow_closure.c \
     swow_ipaddress.c \
@@ -478,9 +486,11 @@ EOF
       cat_work.c \
       cat_buffer.c \
       cat_fs.c \
+      cat_io_uring.c \
       cat_signal.c \
       cat_os_wait.c \
       cat_async.c \
+      cat_thread_channel.c \
       cat_watchdog.c \
       cat_http.c \
       cat_websocket.c, SWOW_CAT_INCLUDES, SWOW_CAT_CFLAGS)
@@ -791,6 +801,18 @@ EOF
       ])
     fi
 
+    dnl zlib is used by WebSocket permessage-deflate
+    if test "x${PHP_SWOW_ZLIB}" != "xno" ; then
+      SWOW_PKG_CHECK_MODULES([ZLIB], zlib, 1.2.0.4, [PHP_SWOW_ZLIB], [
+        dnl make changes
+        AC_DEFINE([CAT_HAVE_ZLIB], 1, [Enable libcat zlib])
+        PHP_EVAL_LIBLINE($ZLIB_LIBS, SWOW_SHARED_LIBADD)
+        SWOW_CAT_INCLUDES="$SWOW_CAT_INCLUDES $ZLIB_INCL"
+      ],[
+        AC_MSG_WARN([Swow zlib support not enabled: zlib not found])
+      ])
+    fi
+
     dnl add postgresql sources
     if test "x${PHP_SWOW_PDO_PGSQL}" != "xno" ; then
       PHP_CHECK_PDO_INCLUDES([
@@ -538,7 +538,11 @@ int uv__udp_bind(uv_udp_t* handle,
   int fd;
 
   /* Check for bad flags. */
+#ifndef HAVE_LIBCAT
   if (flags & ~(UV_UDP_IPV6ONLY | UV_UDP_REUSEADDR | UV_UDP_LINUX_RECVERR))
+#else
+  if (flags & ~(UV_UDP_IPV6ONLY | UV_UDP_REUSEADDR | UV_UDP_REUSEPORT | UV_UDP_LINUX_RECVERR))
+#endif
     return UV_EINVAL;
 
   /* Cannot set IPv6-only mode on non-IPv6 socket. */
@@ -47,10 +47,60 @@ typedef struct cat_buffer_allocator_s {
 
 extern CAT_API cat_buffer_allocator_t cat_buffer_allocator;
 
+#define CAT_BUFFER_POOL_DEFAULT_SIZE 1024
+
+typedef struct cat_buffer_pool_s {
+    cat_bool_t registered;
+    /* idle values are linked by the pointer stored at the head of themselves */
+    char *head;
+    /* options */
+    size_t block_size;
+    size_t max_size;
+    /* info */
+    size_t count;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t recycles;
+} cat_buffer_pool_t;
+
+typedef struct cat_buffer_pool_stats_s {
+    cat_bool_t registered;
+    size_t block_size;
+    size_t max_size;
+    size_t count;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t recycles;
+} cat_buffer_pool_stats_t;
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_buffer) {
+    cat_buffer_pool_t pool;
+} CAT_GLOBALS_STRUCT_END(cat_buffer);
+
+extern CAT_API CAT_GLOBALS_DECLARE(cat_buffer);
+
+#define CAT_BUFFER_G(x) CAT_GLOBALS_GET(cat_buffer, x)
+
 CAT_API cat_bool_t cat_buffer_module_init(void);
+CAT_API cat_bool_t cat_buffer_module_shutdown(void);
+CAT_API cat_bool_t cat_buffer_runtime_init(void);
+CAT_API cat_bool_t cat_buffer_runtime_shutdown(void);
 
 CAT_API cat_bool_t cat_buffer_register_allocator(const cat_buffer_allocator_t *allocator);
 
+/* buffer pool keeps recycled values of block_size and serves the allocations of the same size with them,
+ * it is per-thread and works on top of the current allocator, values never cross threads.
+ * max_size is the max number of idle values kept in pool (0 means CAT_BUFFER_POOL_DEFAULT_SIZE) */
+CAT_API cat_bool_t cat_buffer_pool_register(size_t block_size, size_t max_size);
+/* release all idle values and stop pooling */
+CAT_API cat_bool_t cat_buffer_pool_unregister(void);
+/* return the value of buffer to pool (if it is the size of block and pool is not full),
+ * otherwise it is the same as buffer_close(), caller must make sure that the value is not shared */
+CAT_API cat_bool_t cat_buffer_pool_recycle(cat_buffer_t *buffer);
+/* release all idle values in pool */
+CAT_API void cat_buffer_pool_clear(void);
+CAT_API void cat_buffer_pool_get_stats(cat_buffer_pool_stats_t *stats);
+
 CAT_API size_t cat_buffer_align_size(size_t size, size_t alignment);
 
 CAT_API void cat_buffer_init(cat_buffer_t *buffer);
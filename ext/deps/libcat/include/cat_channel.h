@@ -44,12 +44,6 @@ typedef uint8_t cat_channel_data_size_t;
 
 typedef void (*cat_channel_data_dtor_t)(const cat_data_t *data);
 
-/* Note: this should be public, it's used by channel_get_storage() */
-typedef struct cat_channel_bucket_s {
-    cat_queue_node_t node;
-    char data[1];
-} cat_channel_bucket_t;
-
 typedef struct cat_channel_s {
     cat_channel_flags_t flags;
     cat_channel_data_size_t data_size;
@@ -70,7 +64,11 @@ typedef struct cat_channel_s {
             } able;
         } unbuffered;
         struct {
-            cat_queue_t storage;
+            /* ring buffer which holds (mask + 1) items,
+             * it grows on demand up to the capacity rounded up to the power of two */
+            char *storage;
+            cat_channel_size_t mask;
+            cat_channel_size_t head;
         } buffered;
     } u;
 } cat_channel_t;
@@ -82,6 +80,12 @@ CAT_API cat_channel_t *cat_channel_create(cat_channel_t *channel, cat_channel_si
 CAT_API cat_bool_t cat_channel_push(cat_channel_t *channel, const cat_data_t *data, cat_timeout_t timeout);
 CAT_API cat_bool_t cat_channel_pop(cat_channel_t *channel, cat_data_t *data, cat_timeout_t timeout);
 
+/* wait until at least one item can be transferred, then transfer as many items as possible without waiting again,
+ * return the number of transferred items, or 0 on failure.
+ * (unbuffered channel always transfers items one by one) */
+CAT_API cat_channel_size_t cat_channel_push_many(cat_channel_t *channel, const cat_data_t *data, cat_channel_size_t count, cat_timeout_t timeout);
+CAT_API cat_channel_size_t cat_channel_pop_many(cat_channel_t *channel, cat_data_t *data, cat_channel_size_t count, cat_timeout_t timeout);
+
 /* close channel without clean storage */
 CAT_API cat_bool_t cat_channel_close(cat_channel_t *channel);
 /* close channel if channel is not closed and clean storage */
@@ -131,7 +135,8 @@ CAT_API cat_channel_data_dtor_t cat_channel_set_dtor(cat_channel_t *channel, cat
 
 /* ext */
 
-CAT_API cat_queue_t *cat_channel_get_storage(cat_channel_t *channel); CAT_INTERNAL
+/* get the n-th item in the storage (from the head), return NULL if it is out of range */
+CAT_API cat_data_t *cat_channel_get_storage_item(const cat_channel_t *channel, cat_channel_size_t index); CAT_INTERNAL
 
 #ifdef __cplusplus
 }
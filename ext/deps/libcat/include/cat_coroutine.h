@@ -24,6 +24,7 @@ extern "C" {
 
 #include "cat.h"
 #include "cat_queue.h"
+#include "cat_atomic.h"
 
 #define CAT_COROUTINE_MIN_STACK_SIZE            (128UL * 1024UL)
 #define CAT_COROUTINE_RECOMMENDED_STACK_SIZE    (256UL * 1024UL)
@@ -72,6 +73,7 @@ typedef uint64_t cat_coroutine_id_t;
     /* built-in runtime (8 ~ 15) */ \
     XX(SCHEDULING,  1 << 8) \
     XX(ACCEPT_DATA, 1 << 9) \
+    XX(READY,       1 << 10) \
     /* for user (16 ~ 31) */ \
     XX(USR1,  1 << 16) XX(USR2,  1 << 17) XX(USR3,  1 << 18) XX(USR4,  1 << 19) \
     XX(USR5,  1 << 20) XX(USR6,  1 << 21) XX(USR7,  1 << 22) XX(USR8,  1 << 23) \
@@ -98,6 +100,20 @@ typedef enum cat_coroutine_state_e {
 #undef CAT_COROUTINE_STATE_GEN
 } cat_coroutine_state_t;
 
+/* coroutines of higher priority class always run first in ready queue */
+#define CAT_COROUTINE_PRIORITY_MAP(XX) \
+    XX(LOW,    0, "low") \
+    XX(NORMAL, 1, "normal") \
+    XX(HIGH,   2, "high") \
+
+typedef enum cat_coroutine_priority_e {
+#define CAT_COROUTINE_PRIORITY_GEN(name, value, unused) CAT_ENUM_GEN(CAT_COROUTINE_PRIORITY_, name, value)
+    CAT_COROUTINE_PRIORITY_MAP(CAT_COROUTINE_PRIORITY_GEN)
+#undef CAT_COROUTINE_PRIORITY_GEN
+} cat_coroutine_priority_t;
+
+#define CAT_COROUTINE_PRIORITY_COUNT (CAT_COROUTINE_PRIORITY_HIGH + 1)
+
 typedef uint64_t cat_coroutine_switches_t;
 #define CAT_COROUTINE_SWITCHES_FMT "%" PRIu64
 #define CAT_COROUTINE_SWITCHES_FMT_SPEC PRIu64
@@ -124,14 +140,19 @@ struct cat_coroutine_s
     cat_coroutine_flags_t flags;
     /* runtime info (readonly) */
     cat_coroutine_state_t state;
+    cat_coroutine_priority_t priority;
     cat_coroutine_switches_t switches;
     cat_coroutine_t *from CAT_UNSAFE;
     cat_coroutine_t *previous;
     cat_coroutine_t *next;
+    /* watchdog options (nanoseconds, they are published to globals on switch) */
+    cat_timeout_t watchdog_quantum;
+    cat_timeout_t watchdog_threshold;
     /* internal properties (readonly) */
     cat_coroutine_function_t function;
     cat_coroutine_stack_size_t stack_size;
     /* internal properties (inaccessible) */
+    cat_queue_node_t ready_node;
 #ifdef CAT_COROUTINE_USE_USER_STACK
     uint32_t virtual_memory_size;
     void *virtual_memory;
@@ -164,6 +185,69 @@ typedef void (*cat_coroutine_deadlock_callback_t)(void);
 
 typedef cat_msec_t (*cat_coroutine_msec_time_function_t)(void);
 
+#ifdef CAT_COROUTINE_USE_USER_STACK
+/* stack sizes are rounded up to the power of 2 size classes
+ * (MIN_STACK_SIZE ~ MAX_STACK_SIZE) when stack pool is enabled */
+#define CAT_COROUTINE_STACK_POOL_CLASS_COUNT      8
+#define CAT_COROUTINE_STACK_POOL_DEFAULT_SIZE     64
+#define CAT_COROUTINE_STACK_POOL_DEFAULT_HOT_SIZE 16
+
+typedef struct cat_coroutine_stack_pool_s {
+    /* idle stacks of each size class, hot (untrimmed) stacks are in front */
+    cat_queue_t stacks[CAT_COROUTINE_STACK_POOL_CLASS_COUNT];
+    /* options */
+    size_t max_size;
+    size_t hot_size;
+    /* info */
+    size_t count;
+    size_t hot_count;
+    uint64_t hits;
+    uint64_t misses;
+} cat_coroutine_stack_pool_t;
+#endif
+
+typedef struct cat_coroutine_stack_pool_stats_s {
+    size_t max_size;
+    size_t hot_size;
+    size_t count;
+    size_t hot_count;
+    uint64_t hits;
+    uint64_t misses;
+} cat_coroutine_stack_pool_stats_t;
+
+typedef void (*cat_coroutine_ready_function_t)(void);
+
+/* coroutines woken up by the scheduler are queued here instead of being resumed immediately,
+ * then scheduler runs them in priority order (FIFO in the same class) once per round */
+typedef struct cat_coroutine_ready_queue_s {
+    cat_queue_t queues[CAT_COROUTINE_PRIORITY_COUNT];
+    size_t count;
+    /* options */
+    cat_bool_t enabled;
+    /* max number of coroutines resumed in one round (0 means unlimited) */
+    size_t budget_count;
+    /* max time spent in one round (0 means unlimited) */
+    cat_usec_t budget_time;
+    /* provided by scheduler, it will be called when queue becomes non-empty */
+    cat_coroutine_ready_function_t ready;
+    /* info */
+    size_t peak_count;
+    uint64_t rounds;
+    uint64_t exhausted_rounds;
+    uint64_t resumes;
+} cat_coroutine_ready_queue_t;
+
+typedef struct cat_coroutine_ready_queue_stats_s {
+    cat_bool_t enabled;
+    size_t budget_count;
+    cat_usec_t budget_time;
+    size_t count;
+    size_t peak_count;
+    uint64_t rounds;
+    uint64_t exhausted_rounds;
+    uint64_t resumes;
+} cat_coroutine_ready_queue_stats_t;
+
 CAT_GLOBALS_STRUCT_BEGIN(cat_coroutine) {
     /* options */
     cat_coroutine_stack_size_t default_stack_size;
@@ -177,6 +261,7 @@ CAT_GLOBALS_STRUCT_BEGIN(cat_coroutine) {
     cat_coroutine_t *scheduler;
     cat_queue_t waiters;
     cat_coroutine_count_t waiter_count;
+    cat_coroutine_ready_queue_t ready_queue;
     /* functions */
     cat_coroutine_jump_t jump;
     cat_bool_t switch_denied;
@@ -187,6 +272,17 @@ CAT_GLOBALS_STRUCT_BEGIN(cat_coroutine) {
     cat_coroutine_count_t peak_count;
     /* global switches (for watchdog) */
     cat_coroutine_switches_t switches;
+    /* watchdog options of the current coroutine,
+     * watchdog thread only reads them instead of dereferencing the current coroutine */
+    cat_atomic_int64_t watchdog_quantum;
+    cat_atomic_int64_t watchdog_threshold;
+    /* the least positive coroutine quantum which has ever been set,
+     * watchdog thread never sleeps longer than it */
+    cat_atomic_int64_t watchdog_finest_quantum;
+#ifdef CAT_COROUTINE_USE_USER_STACK
+    /* recyclable stacks */
+    cat_coroutine_stack_pool_t stack_pool;
+#endif
 } CAT_GLOBALS_STRUCT_END(cat_coroutine);
 
 extern CAT_API CAT_GLOBALS_DECLARE(cat_coroutine);
@@ -215,6 +311,16 @@ CAT_API cat_log_type_t cat_coroutine_set_deadlock_log_type(cat_log_type_t type);
 CAT_API cat_coroutine_deadlock_callback_t cat_coroutine_set_deadlock_callback(cat_coroutine_deadlock_callback_t callback);
 /* function will be used for coroutine_get_start_time()/coroutine_get_end_time() (non-thread-safe) */
 CAT_API cat_coroutine_msec_time_function_t cat_coroutine_set_msec_time_function(cat_coroutine_msec_time_function_t callback);
+/* max number of idle stacks kept for reuse (0 means disable stack pool), return the original size */
+CAT_API size_t cat_coroutine_set_stack_pool_size(size_t size);
+/* max number of idle stacks kept without being trimmed, return the original size */
+CAT_API size_t cat_coroutine_set_stack_pool_hot_size(size_t size);
+/* defer coroutines woken up by scheduler to the ready queue, return the original value */
+CAT_API cat_bool_t cat_coroutine_set_ready_queue_enabled(cat_bool_t enabled);
+/* max number of coroutines resumed from ready queue in one round (0 means unlimited), return the original count */
+CAT_API size_t cat_coroutine_set_ready_queue_budget_count(size_t count);
+/* max time (in microseconds) spent on ready queue in one round (0 means unlimited), return the original time */
+CAT_API cat_usec_t cat_coroutine_set_ready_queue_budget_time(cat_usec_t time);
 
 /* globals */
 CAT_API cat_coroutine_stack_size_t cat_coroutine_get_default_stack_size(void);
@@ -228,6 +334,10 @@ CAT_API cat_coroutine_count_t cat_coroutine_get_count(void);
 CAT_API cat_coroutine_count_t cat_coroutine_get_real_count(void);
 CAT_API cat_coroutine_count_t cat_coroutine_get_peak_count(void);
 CAT_API cat_coroutine_switches_t cat_coroutine_get_global_switches(void);
+CAT_API void cat_coroutine_get_stack_pool_stats(cat_coroutine_stack_pool_stats_t *stats);
+/* release all idle stacks in pool */
+CAT_API void cat_coroutine_stack_pool_clear(void);
+CAT_API void cat_coroutine_get_ready_queue_stats(cat_coroutine_ready_queue_stats_t *stats);
 
 /* ctor and dtor */
 CAT_API cat_coroutine_t *cat_coroutine_create(cat_coroutine_t *coroutine, cat_coroutine_function_t function);
@@ -258,6 +368,11 @@ CAT_API cat_coroutine_flags_t cat_coroutine_get_flags(const cat_coroutine_t *cor
 CAT_API void cat_coroutine_set_flags(cat_coroutine_t *coroutine, cat_coroutine_flags_t flags);
 CAT_API cat_coroutine_state_t cat_coroutine_get_state(const cat_coroutine_t *coroutine);
 CAT_API const char *cat_coroutine_get_state_name(const cat_coroutine_t *coroutine);
+CAT_API const char *cat_coroutine_priority_name(cat_coroutine_priority_t priority);
+CAT_API cat_coroutine_priority_t cat_coroutine_get_priority(const cat_coroutine_t *coroutine);
+/* it takes effect next time the coroutine is queued (or immediately if it is in ready queue) */
+CAT_API cat_bool_t cat_coroutine_set_priority(cat_coroutine_t *coroutine, cat_coroutine_priority_t priority);
+CAT_API cat_bool_t cat_coroutine_is_ready(const cat_coroutine_t *coroutine);
 CAT_API cat_coroutine_switches_t cat_coroutine_get_switches(const cat_coroutine_t *coroutine);
 CAT_API cat_msec_t cat_coroutine_get_start_time(const cat_coroutine_t *coroutine);
 CAT_API cat_msec_t cat_coroutine_get_end_time(const cat_coroutine_t *coroutine);
@@ -270,10 +385,18 @@ typedef void (*cat_coroutine_deadlock_function_t)(void);
 typedef struct cat_coroutine_scheduler_s {
     cat_coroutine_schedule_function_t schedule;
     cat_coroutine_deadlock_function_t deadlock;
+    /* scheduler must call cat_coroutine_ready_queue_run() in each round after it is called,
+     * NULL means that scheduler does not support ready queue */
+    cat_coroutine_ready_function_t ready;
 } cat_coroutine_scheduler_t;
 CAT_API cat_coroutine_t *cat_coroutine_scheduler_run(cat_coroutine_t *coroutine, const cat_coroutine_scheduler_t *scheduler); CAT_INTERNAL
 CAT_API cat_coroutine_t *cat_coroutine_scheduler_close(void); CAT_INTERNAL
 
+/* push coroutine to the ready queue, it will be resumed by scheduler later */
+CAT_API cat_bool_t cat_coroutine_ready(cat_coroutine_t *coroutine); CAT_INTERNAL
+/* resume ready coroutines within budget, return the number of coroutines left in queue */
+CAT_API size_t cat_coroutine_ready_queue_run(void); CAT_INTERNAL
+
 static cat_always_inline cat_bool_t cat_coroutine__schedule(cat_coroutine_t *coroutine)
 {
     cat_coroutine_t *current_coroutine = CAT_COROUTINE_G(current);
@@ -284,12 +407,30 @@ static cat_always_inline cat_bool_t cat_coroutine__schedule(cat_coroutine_t *cor
     return ret;
 }
 
+/* coroutine may be resumed later by ready queue (if it is enabled and we are in scheduler),
+ * so waker must not touch or free the waiting context after it */
+static cat_always_inline cat_bool_t cat_coroutine__schedule_deferrable(cat_coroutine_t *coroutine)
+{
+    if (unlikely(CAT_COROUTINE_G(ready_queue).enabled) &&
+        CAT_COROUTINE_G(current) == CAT_COROUTINE_G(scheduler) &&
+        CAT_COROUTINE_G(ready_queue).ready != NULL) {
+        return cat_coroutine_ready(coroutine);
+    }
+    return cat_coroutine__schedule(coroutine);
+}
+
 #define cat_coroutine_schedule(coroutine, module_name, fmt, ...) do { \
     if (unlikely(!cat_coroutine__schedule(coroutine))) { \
         CAT_CORE_ERROR_WITH_LAST(module_name, fmt " schedule failed", ##__VA_ARGS__); \
     } \
 } while (0)
 
+#define cat_coroutine_schedule_deferrable(coroutine, module_name, fmt, ...) do { \
+    if (unlikely(!cat_coroutine__schedule_deferrable(coroutine))) { \
+        CAT_CORE_ERROR_WITH_LAST(module_name, fmt " schedule failed", ##__VA_ARGS__); \
+    } \
+} while (0)
+
 /* sync */
 CAT_API cat_bool_t cat_coroutine_wait_all(void);
 CAT_API cat_bool_t cat_coroutine_wait_all_ex(cat_timeout_t timeout);
@@ -29,12 +29,35 @@ extern "C" {
 
 #include <curl/curl.h>
 
+typedef enum cat_curl_easy_perform_flag_e {
+    CAT_CURL_EASY_PERFORM_FLAG_NONE = 0,
+    /* easy handle has its own share handle, do not attach the runtime one */
+    CAT_CURL_EASY_PERFORM_FLAG_NO_SHARE = 1 << 0,
+} cat_curl_easy_perform_flag_t;
+
+typedef uint32_t cat_curl_easy_perform_flags_t;
+
 CAT_API cat_bool_t cat_curl_module_init(void);
 CAT_API cat_bool_t cat_curl_module_shutdown(void);
 CAT_API cat_bool_t cat_curl_runtime_init(void);
 CAT_API cat_bool_t cat_curl_runtime_close(void);
 
+/* easy handles are performed on the runtime multi handle,
+ * so that connections, DNS cache and TLS sessions are reused across coroutines,
+ * callbacks of them may be called in another coroutine which is driving the multi handle
+ * (see cat_curl_easy_call()).
+ * If the caller is canceled, CURLE_ABORTED_BY_CALLBACK is returned with CAT_ECANCELED */
 CAT_API CURLcode cat_curl_easy_perform(CURL *ch);
+CAT_API CURLcode cat_curl_easy_perform_ex(CURL *ch, cat_curl_easy_perform_flags_t flags);
+
+/* call the function in the coroutine which is performing the easy handle,
+ * callbacks which may switch coroutines or depend on the calling one should be wrapped by it,
+ * returns false if the transfer has been canceled, the function is not called then */
+CAT_API cat_bool_t cat_curl_easy_call(CURL *ch, cat_data_callback_t function, cat_data_t *data);
+
+/* 0 means unlimited, return the original value */
+CAT_API long cat_curl_set_max_host_connections(long max_host_connections);
+CAT_API long cat_curl_set_max_total_connections(long max_total_connections);
 
 CAT_API CURLM *cat_curl_multi_init(void);
 CAT_API CURLMcode cat_curl_multi_cleanup(CURLM *multi);
@@ -27,11 +27,148 @@ extern "C" {
 
 /* Notice: this module is a part of Socket */
 
-/*
-typedef struct cat_dns_cache_s {
+/* cache */
+
+#define CAT_DNS_CACHE_DEFAULT_SIZE         1024
+#define CAT_DNS_CACHE_DEFAULT_TTL          (60 * 1000)
+#define CAT_DNS_CACHE_DEFAULT_NEGATIVE_TTL (5 * 1000)
 
+typedef struct cat_dns_cache_entry_s cat_dns_cache_entry_t;
+
+typedef struct cat_dns_cache_s {
+    cat_dns_cache_entry_t **buckets;
+    size_t bucket_count;
+    /* resolved entries, the most recently used one is at the front */
+    cat_queue_t lru;
+    size_t size;
+    size_t max_size;
+    /* lookups which are in flight (concurrent lookups of the same name will wait for them) */
+    size_t pending_count;
+    cat_msec_t ttl;
+    cat_msec_t negative_ttl;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t coalesced;
+    uint64_t evictions;
 } cat_dns_cache_t;
-*/
+
+typedef struct cat_dns_cache_stats_s {
+    size_t size;
+    size_t max_size;
+    size_t pending_count;
+    cat_msec_t ttl;
+    cat_msec_t negative_ttl;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t coalesced;
+    uint64_t evictions;
+} cat_dns_cache_stats_t;
+
+typedef struct cat_dns_cache_entry_info_s {
+    const char *hostname;
+    const char *service; /* may be empty */
+    int family;
+    int socktype;
+    int protocol;
+    int flags;
+    /* 0 or the error of the negative entry */
+    int status;
+    /* milliseconds left before it expires */
+    cat_msec_t ttl;
+    const struct addrinfo *response;
+} cat_dns_cache_entry_info_t;
+
+typedef void (*cat_dns_cache_walker_t)(const cat_dns_cache_entry_info_t *info, cat_data_t *data);
+
+/* resolver */
+
+typedef enum cat_dns_resolver_type_e {
+    /* getaddrinfo() in the thread pool */
+    CAT_DNS_RESOLVER_SYSTEM = 0,
+    /* DNS over UDP/TCP on the event loop */
+    CAT_DNS_RESOLVER_NATIVE = 1,
+} cat_dns_resolver_type_t;
+
+#define CAT_DNS_RESOLVER_MAX_NAMESERVERS     8
+#define CAT_DNS_RESOLVER_MAX_SEARCH_DOMAINS  6
+/* addresses of the same name in hosts file */
+#define CAT_DNS_RESOLVER_MAX_HOSTS_ADDRESSES 64
+#define CAT_DNS_RESOLVER_DEFAULT_TIMEOUT     (5 * 1000)
+#define CAT_DNS_RESOLVER_DEFAULT_ATTEMPTS    2
+#define CAT_DNS_RESOLVER_DEFAULT_NDOTS       1
+#define CAT_DNS_RESOLVER_DEFAULT_PORT        53
+
+typedef enum cat_dns_type_e {
+    CAT_DNS_TYPE_A     = 1,
+    CAT_DNS_TYPE_CNAME = 5,
+    CAT_DNS_TYPE_AAAA  = 28,
+    CAT_DNS_TYPE_SRV   = 33,
+} cat_dns_type_t;
+
+typedef struct cat_dns_record_s {
+    cat_dns_type_t type;
+    uint32_t ttl;
+    /* owner name */
+    const char *name;
+    union {
+        struct in_addr a;
+        struct in6_addr aaaa;
+        const char *cname;
+        struct {
+            uint16_t priority;
+            uint16_t weight;
+            uint16_t port;
+            const char *target;
+        } srv;
+    } data;
+} cat_dns_record_t;
+
+/* response is allocated in one memory block, release it by cat_dns_response_free() */
+typedef struct cat_dns_response_s {
+    /* the name at the end of CNAME chain */
+    const char *canonical_name;
+    /* the minimum TTL of answers */
+    uint32_t ttl;
+    size_t count;
+    cat_dns_record_t *records;
+} cat_dns_response_t;
+
+typedef struct cat_dns_hosts_entry_s cat_dns_hosts_entry_t;
+typedef struct cat_dns_query_s cat_dns_query_t;
+
+typedef struct cat_dns_resolver_s {
+    cat_dns_resolver_type_t type;
+    cat_bool_t config_loaded;
+    cat_sockaddr_inet_info_t nameservers[CAT_DNS_RESOLVER_MAX_NAMESERVERS];
+    size_t nameserver_count;
+    char *search_domains[CAT_DNS_RESOLVER_MAX_SEARCH_DOMAINS];
+    size_t search_domain_count;
+    unsigned int ndots;
+    unsigned int attempts;
+    /* timeout of each attempt */
+    cat_timeout_t timeout;
+    cat_dns_hosts_entry_t *hosts;
+    size_t hosts_count;
+    /* query ids drawn from CSPRNG which have not been used yet */
+    uint16_t random_ids[32];
+    uint8_t random_id_offset;
+} cat_dns_resolver_t;
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_dns) {
+    cat_dns_cache_t cache;
+    cat_dns_resolver_t resolver;
+} CAT_GLOBALS_STRUCT_END(cat_dns);
+
+extern CAT_API CAT_GLOBALS_DECLARE(cat_dns);
+
+#define CAT_DNS_G(x) CAT_GLOBALS_GET(cat_dns, x)
+
+/* module initialization (called by socket module) */
+
+CAT_API cat_bool_t cat_dns_module_init(void);
+CAT_API cat_bool_t cat_dns_module_shutdown(void);
+CAT_API cat_bool_t cat_dns_runtime_init(void);
+CAT_API cat_bool_t cat_dns_runtime_shutdown(void);
 
 CAT_API struct addrinfo *cat_dns_getaddrinfo(const char *hostname, const char *service, const struct addrinfo *hints);
 CAT_API struct addrinfo *cat_dns_getaddrinfo_ex(const char *hostname, const char *service, const struct addrinfo *hints, cat_timeout_t timeout);
@@ -40,6 +177,28 @@ CAT_API void cat_dns_freeaddrinfo(struct addrinfo *response);
 CAT_API cat_bool_t cat_dns_get_ip(char *buffer, size_t buffer_size, const char *name, int af);
 CAT_API cat_bool_t cat_dns_get_ip_ex(char *buffer, size_t buffer_size, const char *name, int af, cat_timeout_t timeout);
 
+/* resolver (cat_dns_getaddrinfo() falls back to system resolver if native one can not handle the request) */
+CAT_API cat_dns_resolver_type_t cat_dns_set_resolver(cat_dns_resolver_type_t type);
+CAT_API cat_dns_resolver_type_t cat_dns_get_resolver(void);
+/* NULL means the default path (/etc/resolv.conf and /etc/hosts), empty string means none */
+CAT_API cat_bool_t cat_dns_resolver_load_config(const char *resolv_conf, const char *hosts);
+/* e.g. "127.0.0.1, 127.0.0.1:5353, ::1, [::1]:5353" */
+CAT_API cat_bool_t cat_dns_resolver_set_nameservers(const char *nameservers);
+/* query records of the given type by native resolver (hosts file is not involved) */
+CAT_API cat_dns_response_t *cat_dns_query(const char *name, cat_dns_type_t type);
+CAT_API cat_dns_response_t *cat_dns_query_ex(const char *name, cat_dns_type_t type, cat_timeout_t timeout);
+CAT_API void cat_dns_response_free(cat_dns_response_t *response);
+CAT_API const char *cat_dns_type_name(cat_dns_type_t type);
+
+/* cache (size 0 means that cache is disabled), setters return the original value */
+CAT_API size_t cat_dns_cache_set_size(size_t max_size);
+CAT_API cat_msec_t cat_dns_cache_set_ttl(cat_msec_t ttl);
+CAT_API cat_msec_t cat_dns_cache_set_negative_ttl(cat_msec_t ttl);
+CAT_API void cat_dns_cache_get_stats(cat_dns_cache_stats_t *stats);
+CAT_API void cat_dns_cache_walk(cat_dns_cache_walker_t walker, cat_data_t *data);
+/* flush entries of the given hostname (all entries if it is NULL), return number of flushed entries */
+CAT_API size_t cat_dns_cache_flush(const char *hostname);
+
 #ifdef __cplusplus
 }
 #endif
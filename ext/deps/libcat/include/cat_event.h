@@ -38,12 +38,47 @@ typedef void (*cat_event_loop_defer_callback_t)(cat_event_loop_defer_task_t *tas
 typedef struct cat_event_io_defer_task_s cat_event_io_defer_task_t;
 typedef void (*cat_event_io_defer_callback_t)(cat_event_io_defer_task_t *task, cat_data_t *data);
 
+typedef struct cat_event_timer_s cat_event_timer_t;
+typedef void (*cat_event_timer_callback_t)(cat_event_timer_t *timer);
+
+/* intrusive timer node, it can be embedded anywhere (even on the C stack),
+ * arming and disarming it are O(1) and never allocate memory */
+struct cat_event_timer_s {
+    cat_queue_node_t node;
+    cat_msec_t expire;
+    cat_event_timer_callback_t callback;
+};
+
+/* hierarchical timing wheel, the first level has 1ms resolution,
+ * each upper level covers the whole range of the level below it,
+ * timers are cascaded down level by level so that they never fire early,
+ * and timers which are out of range will be parked in the last level */
+#define CAT_EVENT_TIMER_WHEEL_SLOT_BITS   6
+#define CAT_EVENT_TIMER_WHEEL_SLOT_COUNT  (1 << CAT_EVENT_TIMER_WHEEL_SLOT_BITS)
+#define CAT_EVENT_TIMER_WHEEL_SLOT_MASK   (CAT_EVENT_TIMER_WHEEL_SLOT_COUNT - 1)
+#define CAT_EVENT_TIMER_WHEEL_LEVEL_COUNT 4
+
+typedef struct cat_event_timer_wheel_s {
+    /* the only uv timer, it is armed for the nearest tick and stopped if wheel is empty */
+    uv_timer_t driver;
+    /* the next tick which has not been processed yet */
+    cat_msec_t time;
+    /* the tick which driver is scheduled for */
+    cat_msec_t next_tick;
+    size_t count;
+    uint64_t bitmaps[CAT_EVENT_TIMER_WHEEL_LEVEL_COUNT];
+    cat_queue_t slots[CAT_EVENT_TIMER_WHEEL_LEVEL_COUNT][CAT_EVENT_TIMER_WHEEL_SLOT_COUNT];
+} cat_event_timer_wheel_t;
+
 CAT_GLOBALS_STRUCT_BEGIN(cat_event) {
     uv_loop_t loop;
     uv_timer_t deadlock;
     cat_queue_t runtime_shutdown_tasks;
     cat_queue_t io_defer_tasks;
     uv_check_t io_defer_check;
+    /* keep event loop from blocking while there are coroutines in ready queue */
+    uv_idle_t ready_queue_idle;
+    cat_event_timer_wheel_t timer_wheel;
 } CAT_GLOBALS_STRUCT_END(cat_event);
 
 extern CAT_API CAT_GLOBALS_DECLARE(cat_event);
@@ -88,6 +123,14 @@ CAT_API cat_event_io_defer_task_t *cat_event_io_defer_task_create(
  * if task callback has been called, it will return true, otherwise false. */
 CAT_API cat_bool_t cat_event_io_defer_task_close(cat_event_io_defer_task_t *task);
 
+/* timer callback will be called in the timer phase of event loop after timeout ms,
+ * timer is stopped before callback is called, so it can be restarted in callback. */
+CAT_API void cat_event_timer_init(cat_event_timer_t *timer, cat_event_timer_callback_t callback);
+CAT_API void cat_event_timer_start(cat_event_timer_t *timer, cat_msec_t timeout);
+CAT_API void cat_event_timer_stop(cat_event_timer_t *timer);
+CAT_API cat_bool_t cat_event_timer_is_active(const cat_event_timer_t *timer);
+CAT_API size_t cat_event_timer_get_count(void);
+
 CAT_API void cat_event_fork(void);
 
 CAT_API void cat_event_print_all_handles(cat_os_fd_t output);
@@ -67,6 +67,29 @@ typedef int cat_fs_open_flags_t;
 #define CAT_FS_OPEN_FLAGS_FMT "%d"
 #define CAT_FS_OPEN_FLAGS_FMT_SPEC "d"
 
+/* io_uring backend (Linux >= 5.6, see cat_io_uring.h),
+ * open/close/read/write/pread/pwrite/fsync/fdatasync/stat/lstat/fstat are submitted to it if it is available,
+ * and others (or all of them if it is unavailable) are still done in thread pool */
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_fs) {
+    /* options */
+    cat_bool_t io_uring_enabled;
+} CAT_GLOBALS_STRUCT_END(cat_fs);
+
+extern CAT_API CAT_GLOBALS_DECLARE(cat_fs);
+
+#define CAT_FS_G(x) CAT_GLOBALS_GET(cat_fs, x)
+
+/* module initialization (called by event module) */
+
+CAT_API cat_bool_t cat_fs_module_init(void);
+CAT_API cat_bool_t cat_fs_module_shutdown(void);
+CAT_API cat_bool_t cat_fs_runtime_init(void);
+CAT_API cat_bool_t cat_fs_runtime_shutdown(void);
+
+/* it returns the original value, new requests go to thread pool after it is disabled */
+CAT_API cat_bool_t cat_fs_set_io_uring_enabled(cat_bool_t enabled);
+
 CAT_API cat_file_t cat_fs_open(const char *path, cat_fs_open_flags_t flags, ...);
 CAT_API int cat_fs_close(cat_file_t fd);
 CAT_API ssize_t cat_fs_read(cat_file_t fd, void *buffer, size_t size);
@@ -0,0 +1,162 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#ifndef CAT_IO_URING_H
+#define CAT_IO_URING_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cat.h"
+#include "cat_queue.h"
+
+/* io_uring (Linux >= 5.6) which is shared by fs and socket modules,
+ * it is created when it is used for the first time,
+ * requests issued in the same round of event loop are submitted in batch with one syscall (in prepare phase),
+ * and completions are reaped when its eventfd becomes readable in event loop */
+
+#if defined(__linux__) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+#  include <linux/io_uring.h>
+#  include <sys/syscall.h>
+#  if defined(__NR_io_uring_setup) && defined(IORING_FEAT_RW_CUR_POS) && defined(IO_URING_OP_SUPPORTED)
+#   define CAT_HAVE_IO_URING 1
+/* provided buffer ring, multishot recv and zero-copy send (Linux >= 6.0) */
+#   if defined(IORING_RECV_MULTISHOT) && defined(IORING_CQE_F_NOTIF)
+#    define CAT_HAVE_IO_URING_MULTISHOT 1
+#   endif
+#  endif
+# endif
+#endif
+
+#define CAT_IO_URING_DEFAULT_ENTRIES 256
+#define CAT_IO_URING_MAX_ENTRIES     4096
+
+typedef struct cat_io_uring_s cat_io_uring_t;
+
+typedef struct cat_io_uring_stats_s {
+    /* false if it is not supported or its setup has failed */
+    cat_bool_t available;
+    cat_bool_t running;
+    unsigned int entries;
+    size_t pending;
+    size_t inflight;
+    /* number of io_uring_enter() calls and SQEs submitted by them */
+    uint64_t enters;
+    uint64_t submissions;
+    uint64_t completions;
+    size_t max_batch;
+    /* submissions of the opcodes which are used by socket engine */
+    uint64_t recv_multishot;
+    uint64_t accept_multishot;
+    uint64_t send_zc;
+} cat_io_uring_stats_t;
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_io_uring) {
+    /* options */
+    unsigned int entries;
+    /* it is created when it is used for the first time */
+    cat_io_uring_t *ring;
+    /* setup failed or it has been closed in child process */
+    cat_bool_t unavailable;
+} CAT_GLOBALS_STRUCT_END(cat_io_uring);
+
+extern CAT_API CAT_GLOBALS_DECLARE(cat_io_uring);
+
+#define CAT_IO_URING_G(x) CAT_GLOBALS_GET(cat_io_uring, x)
+
+/* module initialization (called by event module) */
+
+CAT_API cat_bool_t cat_io_uring_module_init(void);
+CAT_API cat_bool_t cat_io_uring_module_shutdown(void);
+CAT_API cat_bool_t cat_io_uring_runtime_init(void);
+CAT_API cat_bool_t cat_io_uring_runtime_shutdown(void);
+/* io_uring is shared with parent, child process must not use it */
+CAT_API void cat_io_uring_fork(void); CAT_INTERNAL
+
+CAT_API cat_bool_t cat_io_uring_get_stats(cat_io_uring_stats_t *stats);
+
+#ifdef CAT_HAVE_IO_URING
+typedef struct cat_io_uring_request_s cat_io_uring_request_t;
+
+/* flags are the flags of CQE, request is still in flight if IORING_CQE_F_MORE is set */
+typedef void (*cat_io_uring_callback_t)(cat_io_uring_request_t *request, int32_t result, uint32_t flags);
+
+typedef enum cat_io_uring_request_state_e {
+    CAT_IO_URING_REQUEST_STATE_NONE,
+    CAT_IO_URING_REQUEST_STATE_PENDING,
+    CAT_IO_URING_REQUEST_STATE_INFLIGHT,
+} cat_io_uring_request_state_t;
+
+/* it must be the first member of the object allocated by request_create() */
+struct cat_io_uring_request_s {
+    cat_queue_node_t node;
+    cat_io_uring_callback_t callback;
+    /* owner and ring (while it is pending or in flight) hold references */
+    unsigned int refcount;
+    /* it is set to NONE before the last callback,
+     * or when ring is closed (then callback will never be called) */
+    uint8_t state;
+    /* it is copied to SQ when it is submitted */
+    struct io_uring_sqe sqe;
+};
+
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+/* provided buffers which are picked by kernel (IOSQE_BUFFER_SELECT) */
+typedef struct cat_io_uring_buffer_ring_s {
+    cat_queue_node_t node;
+    struct io_uring_buf_ring *ring;
+    size_t ring_size;
+    char *buffers;
+    size_t buffer_size;
+    unsigned int count;
+    uint16_t group_id;
+    uint16_t tail;
+} cat_io_uring_buffer_ring_t;
+#endif
+
+/* it returns false if io_uring or opcode is unavailable, io_uring will be created if it does not exist */
+CAT_API cat_bool_t cat_io_uring_is_available(uint8_t opcode);
+
+/* size is the size of the whole object which starts with request */
+CAT_API cat_io_uring_request_t *cat_io_uring_request_create(size_t size, uint8_t opcode, int fd, cat_io_uring_callback_t callback);
+CAT_API void cat_io_uring_request_release(cat_io_uring_request_t *request);
+
+/* request will be submitted in batch in prepare phase (ring holds a reference until the last CQE) */
+CAT_API cat_bool_t cat_io_uring_submit(cat_io_uring_request_t *request);
+/* request which is pending is removed immediately, callback will not be called,
+ * otherwise it is canceled asynchronously (best effort), and callback will be called with -ECANCELED if it was canceled */
+CAT_API void cat_io_uring_cancel(cat_io_uring_request_t *request);
+/* callbacks of completions which are available now are called without waiting for event loop
+ * (e.g. try-style operations which would race with the requests in flight) */
+CAT_API void cat_io_uring_reap(void);
+
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+/* buffer ring is registered with the specified group when it is used for the first time,
+ * count must be power of 2, it returns NULL if provided buffer ring is unsupported (Linux < 5.19) */
+CAT_API cat_io_uring_buffer_ring_t *cat_io_uring_get_buffer_ring(uint16_t group_id, unsigned int count, size_t buffer_size);
+CAT_API char *cat_io_uring_buffer_ring_get_buffer(const cat_io_uring_buffer_ring_t *buffer_ring, uint16_t buffer_id);
+/* give the buffer back to kernel */
+CAT_API void cat_io_uring_buffer_ring_recycle(cat_io_uring_buffer_ring_t *buffer_ring, uint16_t buffer_id);
+#endif
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAT_IO_URING_H */
@@ -75,6 +75,26 @@ CAT_API int cat_poll(cat_pollfd_t *fds, cat_nfds_t nfds, cat_timeout_t timeout);
  * @see: same with poll_one() note. */
 CAT_API int cat_select(cat_os_socket_t max_fd, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
 
+/** poll watcher keeps fd being watched in event loop across waits,
+ * so waiting on the same fd for the same events repeatedly costs
+ * no more epoll_ctl() (or the like) calls.
+ * @note: it watches a duplicated fd on Unix, fd can be closed before the watcher,
+ * but the watcher should be closed as soon as possible then. */
+typedef struct cat_poll_watcher_s cat_poll_watcher_t;
+
+CAT_API cat_poll_watcher_t *cat_poll_watcher_create(cat_os_socket_t fd);
+/* it is safe to close the watcher when someone is waiting for it, waiter will get POLLERR */
+CAT_API void cat_poll_watcher_close(cat_poll_watcher_t *watcher);
+CAT_API cat_os_socket_t cat_poll_watcher_get_fd(const cat_poll_watcher_t *watcher);
+/* same with poll_one(), but only one coroutine can wait for the watcher at the same time */
+CAT_API cat_ret_t cat_poll_watcher_wait(cat_poll_watcher_t *watcher, cat_pollfd_events_t events, cat_pollfd_events_t *revents, cat_timeout_t timeout);
+
+/* same with poll(), watchers[i] is used to wait for fds[i] if it is not NULL,
+ * a watcher which is busy is ignored and fds[i] is polled in the usual way */
+CAT_API int cat_poll_ex(cat_pollfd_t *fds, cat_poll_watcher_t *const *watchers, cat_nfds_t nfds, cat_timeout_t timeout);
+/* same with select(), watchers of fds in sets are used, they must be sorted by fd */
+CAT_API int cat_select_ex(cat_os_socket_t max_fd, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout, cat_poll_watcher_t *const *watchers, size_t nwatchers);
+
 /** poll emulation APIs */
 typedef cat_ret_t (*cat_poll_one_emulate_t)(cat_os_socket_t fd, cat_pollfd_events_t events, cat_pollfd_events_t *revents);
 typedef int (*cat_poll_emulate_t)(cat_pollfd_t *fds, cat_nfds_t nfds);
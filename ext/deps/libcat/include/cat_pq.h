@@ -31,6 +31,8 @@ extern "C" {
 #include <libpq/libpq-fs.h>
 // #include <libpq-int.h>
 
+CAT_API cat_bool_t cat_pq_module_init(void);
+CAT_API cat_bool_t cat_pq_module_shutdown(void);
 CAT_API cat_bool_t cat_pq_runtime_init(void);
 CAT_API cat_bool_t cat_pq_runtime_close(void);
 
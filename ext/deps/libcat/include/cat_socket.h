@@ -25,8 +25,8 @@ extern "C" {
 #include "cat.h"
 #include "cat_ref.h"
 #include "cat_coroutine.h"
-#include "cat_dns.h"
 #include "cat_ssl.h"
+#include "cat_buffer.h"
 
 #ifdef CAT_OS_UNIX_LIKE
 #include <sys/socket.h>
@@ -268,6 +268,8 @@ typedef enum cat_socket_type_e {
     XX(TCP_DELAY,     1 << 0)  /* (disable tcp_nodelay) */ \
     XX(TCP_KEEPALIVE, 1 << 1)  /* (enable keep-alive) */ \
     XX(UDP_BROADCAST, 1 << 2)  /* (enable broadcast) TODO: support it or remove */ \
+    /* 9 ~ 16 (stream-extra) */ \
+    XX(WRITE_COALESCING, 1 << 8)  /* (gather concurrent writes into one writev) */ \
 
 typedef enum cat_socket_option_flag_e {
 #define CAT_SOCKET_OPTION_FLAG_GEN(name, value) CAT_ENUM_GEN(CAT_SOCKET_OPTION_FLAG_, name, value)
@@ -310,10 +312,22 @@ typedef uint32_t cat_socket_flags_t;
     /* socket may be a pipe file, which is created by pipe2()
      * and can only work with read()/write() */ \
     XX(NOT_SOCK,          1 << 3) \
+    /* socket is in the internal tree, so poll module can find it by fd */ \
+    XX(IN_TREE,           1 << 4) \
+    /* io_uring engine must not be used anymore (e.g. kTLS writes to fd directly),
+     * data which has been read ahead is still consumed before falling back to libuv */ \
+    XX(NO_IO_URING,       1 << 5) \
     /* 20 ~ 23 (stream (tcp|pipe|tty)) */ \
     XX(SERVER,            1 << 20) \
     XX(SERVER_CONNECTION, 1 << 21) \
     XX(CLIENT,            1 << 22) \
+    /* reuseport CPU affinity program will be attached on listen
+     * (TCP sockets can only join the reuseport group after listen) */ \
+    XX(REUSEPORT_CPU_AFFINITY, 1 << 23) \
+    /* 24 ~ 27 (dgram (udp|udg)) */ \
+    XX(UDP_GSO_CHECKED,     1 << 24) \
+    /* kernel or device does not support UDP_SEGMENT */ \
+    XX(UDP_GSO_UNAVAILABLE, 1 << 25) \
 
 typedef enum cat_socket_internal_flag_e {
 #define CAT_SOCKET_INTERNAL_FLAG_GEN(name, value) CAT_ENUM_GEN(CAT_SOCKET_INTERNAL_FLAG_, name, value)
@@ -345,6 +359,10 @@ typedef uint8_t cat_socket_io_flags_t;
     XX(IPV6ONLY, 1 << 0) \
     XX(REUSEADDR, 1 << 1) \
     XX(REUSEPORT, 1 << 2) \
+    /* implies REUSEPORT, connections will be dispatched to the listener which serves the receiving CPU,
+     * that is the CPU the listener thread is bound to (by SO_INCOMING_CPU, Linux >= 6.2),
+     * or the index of the listener in the reuseport group */ \
+    XX(REUSEPORT_CPU_AFFINITY, 1 << 3) \
 
 typedef enum cat_socket_bind_flag_e {
 #define CAT_SOCKET_BIND_FLAG_GEN(name, value) CAT_ENUM_GEN(CAT_SOCKET_BIND_FLAG_, name, value)
@@ -384,10 +402,115 @@ typedef struct cat_socket_context_s {
     cat_coroutine_t *coroutine;
 } cat_socket_context_t;
 
+#ifndef CAT_SOCKET_WRITE_COALESCING_MAX_VECTORS
+# ifdef IOV_MAX
+#  define CAT_SOCKET_WRITE_COALESCING_MAX_VECTORS IOV_MAX
+# else
+#  define CAT_SOCKET_WRITE_COALESCING_MAX_VECTORS 1024
+# endif
+#endif
+
+#ifndef CAT_SOCKET_WRITE_COALESCING_MAX_BYTES
+#define CAT_SOCKET_WRITE_COALESCING_MAX_BYTES (1024 * 1024)
+#endif
+
+/* corked data will be flushed automatically if it reaches this size */
+#ifndef CAT_SOCKET_CORK_BUFFER_MAX_SIZE
+#define CAT_SOCKET_CORK_BUFFER_MAX_SIZE (64 * 1024)
+#endif
+
+typedef struct cat_socket_write_batch_s cat_socket_write_batch_t;
+
 typedef struct cat_socket_write_context_s {
     cat_queue_t coroutines;
+    /* number of stream write requests in flight */
+    unsigned int requests;
+    /* writes waiting for in-flight requests (write coalescing) */
+    cat_socket_write_batch_t *batch;
+    /* data held back until uncork */
+    cat_buffer_t cork_buffer;
+    cat_bool_t corked;
 } cat_socket_write_context_t;
 
+#ifndef CAT_SOCKET_READER_BUFFER_DEFAULT_SIZE
+#define CAT_SOCKET_READER_BUFFER_DEFAULT_SIZE CAT_BUFFER_COMMON_SIZE
+#endif
+
+/* read-ahead buffer of buffered reader, it is allocated on the first use */
+typedef struct cat_socket_reader_s {
+    cat_buffer_t buffer;
+    /* start of the unconsumed data */
+    size_t offset;
+} cat_socket_reader_t;
+
+/* describes a length-prefixed frame:
+ * frame_length = length_field_offset + length_field_size + value_of_length_field + length_adjustment */
+typedef struct cat_socket_frame_spec_s {
+    /* bytes before the length field */
+    size_t length_field_offset;
+    /* 1 ~ 8 */
+    uint8_t length_field_size;
+    cat_bool_t length_field_little_endian;
+    /* e.g. -(length_field_offset + length_field_size) if the length field counts the whole frame */
+    int64_t length_adjustment;
+    /* bytes skipped from the beginning of the returned frame */
+    size_t initial_bytes_to_strip;
+} cat_socket_frame_spec_t;
+
+/* io_uring engine (Linux >= 6.0, opt-in) for stream sockets:
+ * connections are accepted by multishot accept, data is received by multishot recv into provided buffers
+ * and read ahead into per-socket buffer (poll() reports POLLIN for read-ahead data and sticky errors),
+ * large writes are sent by zero-copy send, small writes still go through libuv (and write coalescing),
+ * a zero-copy write never returns before kernel releases its data, if it times out or is canceled,
+ * the connection is reset to release the data queued in socket */
+#ifndef CAT_SOCKET_IO_URING_DEFAULT_BUFFER_SIZE
+#define CAT_SOCKET_IO_URING_DEFAULT_BUFFER_SIZE (16 * 1024)
+#endif
+
+#ifndef CAT_SOCKET_IO_URING_DEFAULT_BUFFER_COUNT
+#define CAT_SOCKET_IO_URING_DEFAULT_BUFFER_COUNT 256
+#endif
+
+/* writes which are not smaller than it are sent by zero-copy send, 0 means disabled */
+#ifndef CAT_SOCKET_IO_URING_DEFAULT_ZEROCOPY_THRESHOLD
+#define CAT_SOCKET_IO_URING_DEFAULT_ZEROCOPY_THRESHOLD (16 * 1024)
+#endif
+
+/* multishot recv will be paused if read-ahead data reaches this size */
+#ifndef CAT_SOCKET_IO_URING_READ_AHEAD_MAX_SIZE
+#define CAT_SOCKET_IO_URING_READ_AHEAD_MAX_SIZE (256 * 1024)
+#endif
+
+/* multishot accept will be paused if accepted connections reach this number */
+#ifndef CAT_SOCKET_IO_URING_ACCEPT_QUEUE_MAX_SIZE
+#define CAT_SOCKET_IO_URING_ACCEPT_QUEUE_MAX_SIZE 128
+#endif
+
+typedef struct cat_socket_io_uring_s cat_socket_io_uring_t;
+
+typedef struct cat_socket_io_uring_options_s {
+    cat_bool_t enabled;
+    /* size and number of provided buffers (shared by all sockets) */
+    size_t buffer_size;
+    unsigned int buffer_count;
+    size_t zerocopy_threshold;
+} cat_socket_io_uring_options_t;
+
+/* one datagram of batch I/O */
+typedef struct cat_socket_datagram_s {
+    /* buffer to receive into, or data to send */
+    char *buffer;
+    /* size of buffer (recv), or length of data (send) */
+    size_t size;
+    /* length of received data (recv only) */
+    size_t length;
+    /* source address (recv), or destination address (send, zero length means the connected peer) */
+    cat_sockaddr_info_t address;
+} cat_socket_datagram_t;
+
+/* max number of datagrams handled by one recvmmsg()/sendmmsg() */
+#define CAT_SOCKET_DATAGRAM_BATCH_MAX_COUNT 64
+
 typedef struct cat_socket_write_request_s {
     int error;
     union {
@@ -408,6 +531,28 @@ typedef struct uv_udg_s {
 typedef struct cat_socket_s cat_socket_t;
 typedef struct cat_socket_internal_s cat_socket_internal_t;
 
+typedef struct cat_socket_accept_stats_s {
+    /* number of accepted connections */
+    uint64_t count;
+    /* number of accept rounds (wakeups which accepted connections) */
+    uint64_t rounds;
+    /* connections accepted in the last round */
+    uint32_t last_batch_size;
+    /* max connections accepted in one round */
+    uint32_t max_batch_size;
+    /* loop time (msec) when listening started */
+    cat_msec_t listen_time;
+    /* loop time (msec) of the last successful accept */
+    cat_msec_t last_accept_time;
+    /* connections waiting in the accept queue (TCP on Linux only, otherwise 0) */
+    uint32_t queue_length;
+    /* max length of the accept queue (TCP on Linux only, otherwise 0) */
+    uint32_t queue_capacity;
+    /* system-wide TcpExt ListenOverflows and ListenDrops counters (Linux only, otherwise 0) */
+    uint64_t listen_overflows;
+    uint64_t listen_drops;
+} cat_socket_accept_stats_t;
+
 typedef struct cat_socket_options_s {
     cat_socket_timeout_options_t timeout;
     unsigned int tcp_keepalive_delay;
@@ -449,7 +594,15 @@ struct cat_socket_internal_s
         cat_sockaddr_info_t *peername;
         int recv_buffer_size;
         int send_buffer_size;
+        /* error which arrived after data had been delivered, it is reported by the next read */
+        int read_error;
     } cache;
+    /* buffered reader */
+    cat_socket_reader_t reader;
+    /* accept statistics (allocated on listen) */
+    cat_socket_accept_stats_t *accept_stats;
+    /* io_uring engine (created on the first use) */
+    cat_socket_io_uring_t *io_uring;
     /* ext */
 #ifdef CAT_SSL
     cat_ssl_t *ssl;
@@ -513,12 +666,11 @@ CAT_GLOBALS_STRUCT_BEGIN(cat_socket) {
         cat_socket_timeout_options_t timeout;
         unsigned int tcp_keepalive_delay;
     } options;
+    cat_socket_io_uring_options_t io_uring;
     /* In theory, all internal socket objects should be maintained in the tree,
      * but currently only the internal sockets that need to be used are stored
-     * e.g., server sockets for poll module. */
+     * e.g., server sockets and sockets which may have pending input for poll module. */
     struct cat_socket_internal_tree_s internal_tree;
-    /* dns */
-    // TODO: dns_cache (we should implement lru_cache)
 } CAT_GLOBALS_STRUCT_END(cat_socket);
 
 extern CAT_API CAT_GLOBALS_DECLARE(cat_socket);
@@ -591,6 +743,12 @@ CAT_API cat_bool_t cat_socket_bind_to_ex(cat_socket_t *socket, const char *name,
 CAT_API cat_bool_t cat_socket_listen(cat_socket_t *socket, int backlog);
 CAT_API cat_bool_t cat_socket_accept(cat_socket_t *server, cat_socket_t *client);
 CAT_API cat_bool_t cat_socket_accept_ex(cat_socket_t *server, cat_socket_t *client, cat_timeout_t timeout);
+/* accept a pending connection without waiting, it fails with CAT_EAGAIN if there is none */
+CAT_API cat_bool_t cat_socket_try_accept(cat_socket_t *server, cat_socket_t *client);
+/* accept_multiple() waits until at least one connection arrives and then drains the accept queue without blocking,
+ * clients must be lazy sockets, returns the number of accepted connections or -1 on error */
+CAT_API ssize_t cat_socket_accept_multiple(cat_socket_t *server, cat_socket_t **clients, size_t count);
+CAT_API ssize_t cat_socket_accept_multiple_ex(cat_socket_t *server, cat_socket_t **clients, size_t count, cat_timeout_t timeout);
 
 CAT_API cat_bool_t cat_socket_connect(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length);
 CAT_API cat_bool_t cat_socket_connect_ex(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout);
@@ -624,6 +782,13 @@ typedef struct cat_socket_crypto_options_s {
     cat_bool_t no_ticket;
     cat_bool_t no_compression;
     cat_bool_t no_client_ca_list;
+    cat_bool_t ktls;
+    /* session resumption (server side only) */
+    cat_bool_t session_cache;
+    size_t session_cache_size; /* 0 means the default size */
+    long session_timeout; /* seconds */
+    const char *session_ticket_key_file;
+    long session_ticket_key_rotation; /* seconds, 0 means the default value */
 } cat_socket_crypto_options_t;
 
 CAT_API void cat_socket_crypto_options_init(cat_socket_crypto_options_t *options, cat_bool_t is_client);
@@ -686,12 +851,54 @@ CAT_API ssize_t cat_socket_peekfrom_ex(const cat_socket_t *socket, char *buffer,
 CAT_API ssize_t cat_socket_peek_from(const cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port);
 CAT_API ssize_t cat_socket_peek_from_ex(const cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port, cat_timeout_t timeout);
 
+/* datagram batch I/O (dgram only):
+ * recv_multiple() waits until at least one datagram arrives and then receives as many as possible without blocking,
+ * it returns the number of received datagrams;
+ * send_multiple() sends all datagrams and returns the number of sent datagrams,
+ * which may be less than count if error occurred after some datagrams have been sent. */
+CAT_API ssize_t cat_socket_recv_multiple(cat_socket_t *socket, cat_socket_datagram_t *datagrams, size_t count);
+CAT_API ssize_t cat_socket_recv_multiple_ex(cat_socket_t *socket, cat_socket_datagram_t *datagrams, size_t count, cat_timeout_t timeout);
+CAT_API ssize_t cat_socket_send_multiple(cat_socket_t *socket, const cat_socket_datagram_t *datagrams, size_t count);
+CAT_API ssize_t cat_socket_send_multiple_ex(cat_socket_t *socket, const cat_socket_datagram_t *datagrams, size_t count, cat_timeout_t timeout);
+
+/* buffered reader (stream only):
+ * data is read ahead into the internal buffer of socket and all the other reads consume buffered data first,
+ * the returned pointer refers to the internal buffer and is only valid until the next read operation.
+ * max_length limits the length of message (0 means unlimited), delimiter is not included in the message. */
+#ifndef CAT_SOCKET_DEFAULT_MAX_FRAME_LENGTH
+/* length field is sent by peer, frames should always be limited unless peer is trusted */
+#define CAT_SOCKET_DEFAULT_MAX_FRAME_LENGTH (16 * 1024 * 1024)
+#endif
+CAT_API const char *cat_socket_read_until(cat_socket_t *socket, const char *delimiter, size_t delimiter_length, size_t max_length, size_t *length);
+CAT_API const char *cat_socket_read_until_ex(cat_socket_t *socket, const char *delimiter, size_t delimiter_length, size_t max_length, size_t *length, cat_timeout_t timeout);
+/* line ends with "\n" or "\r\n" */
+CAT_API const char *cat_socket_read_line(cat_socket_t *socket, size_t max_length, size_t *length);
+CAT_API const char *cat_socket_read_line_ex(cat_socket_t *socket, size_t max_length, size_t *length, cat_timeout_t timeout);
+CAT_API const char *cat_socket_read_frame(cat_socket_t *socket, const cat_socket_frame_spec_t *spec, size_t max_length, size_t *length);
+CAT_API const char *cat_socket_read_frame_ex(cat_socket_t *socket, const cat_socket_frame_spec_t *spec, size_t max_length, size_t *length, cat_timeout_t timeout);
+/* make sure that at least length (> 0) bytes of data are buffered and return all buffered data without consuming,
+ * it can be consumed by cat_socket_read_skip() or the following reads */
+CAT_API const char *cat_socket_read_ahead(cat_socket_t *socket, size_t length, size_t *buffered_length);
+CAT_API const char *cat_socket_read_ahead_ex(cat_socket_t *socket, size_t length, size_t *buffered_length, cat_timeout_t timeout);
+/* consume buffered data, return the length of consumed data */
+CAT_API size_t cat_socket_read_skip(cat_socket_t *socket, size_t length);
+CAT_API size_t cat_socket_get_read_buffered_length(const cat_socket_t *socket);
+
 CAT_API cat_bool_t cat_socket_send_handle(cat_socket_t *socket, cat_socket_t *handle);
 CAT_API cat_bool_t cat_socket_send_handle_ex(cat_socket_t *socket, cat_socket_t *handle, cat_timeout_t timeout);
 
 CAT_API ssize_t cat_socket_send_file(cat_socket_t *socket, const char *filename, int64_t offset, size_t length);
 CAT_API ssize_t cat_socket_send_file_ex(cat_socket_t *socket, const char *filename, int64_t offset, size_t length, cat_timeout_t timeout);
 
+/* writes on corked stream socket are buffered until uncork() (or buffer is full),
+ * so that header and body can be sent by one syscall (and one SSL record).
+ * @note close() never blocks, it tries to flush corked data once and drops the rest with a warning,
+ * so uncork() it before close() if all data must be sent */
+CAT_API cat_bool_t cat_socket_cork(cat_socket_t *socket);
+CAT_API cat_bool_t cat_socket_uncork(cat_socket_t *socket);
+CAT_API cat_bool_t cat_socket_uncork_ex(cat_socket_t *socket, cat_timeout_t timeout);
+CAT_API cat_bool_t cat_socket_is_corked(const cat_socket_t *socket);
+
 /* @note last_error will not be updated when close failed,  */
 CAT_API cat_bool_t cat_socket_close(cat_socket_t *socket);
 
@@ -703,6 +910,8 @@ CAT_API cat_bool_t cat_socket_is_established(const cat_socket_t *socket);
 #ifdef CAT_SSL
 CAT_API cat_bool_t cat_socket_has_crypto(const cat_socket_t *socket);
 CAT_API cat_bool_t cat_socket_is_encrypted(const cat_socket_t *socket);
+CAT_API cat_bool_t cat_socket_is_ktls_send_enabled(const cat_socket_t *socket);
+CAT_API cat_bool_t cat_socket_is_ktls_recv_enabled(const cat_socket_t *socket);
 #endif
 CAT_API cat_bool_t cat_socket_is_server(const cat_socket_t *socket);
 CAT_API cat_bool_t cat_socket_is_server_connection(const cat_socket_t *socket);
@@ -745,6 +954,24 @@ CAT_API cat_bool_t cat_socket_set_tcp_keepalive(cat_socket_t *socket, cat_bool_t
 CAT_API cat_bool_t cat_socket_get_udp_broadcast(const cat_socket_t *socket);
 CAT_API cat_bool_t cat_socket_set_udp_broadcast(cat_socket_t *socket, cat_bool_t enable);
 
+/* writes from different coroutines will be merged into one writev if previous write is still in progress */
+CAT_API cat_bool_t cat_socket_get_write_coalescing(const cat_socket_t *socket);
+CAT_API cat_bool_t cat_socket_set_write_coalescing(cat_socket_t *socket, cat_bool_t enable);
+
+/* attach a reuseport program which dispatches connections to the listener whose index in the group
+ * (bind order for UDP, listen order for TCP) is receiving CPU % group_size, 0 means number of CPUs */
+CAT_API cat_bool_t cat_socket_set_reuseport_cpu_affinity(cat_socket_t *socket, uint32_t group_size);
+/* returns -1 on error (or if CPU is unknown) */
+CAT_API int cat_socket_get_incoming_cpu(const cat_socket_t *socket);
+CAT_API cat_bool_t cat_socket_set_incoming_cpu(cat_socket_t *socket, int cpu);
+
+CAT_API cat_bool_t cat_socket_get_accept_stats(const cat_socket_t *socket, cat_socket_accept_stats_t *stats);
+
+/* it only affects sockets which have not used io_uring yet, returns the original value */
+CAT_API cat_bool_t cat_socket_set_io_uring_enabled(cat_bool_t enabled);
+/* it becomes false if the engine is found to be unavailable when it is used for the first time */
+CAT_API cat_bool_t cat_socket_is_io_uring_enabled(void);
+
 /* helper */
 
 CAT_API int cat_socket_get_local_free_port(void);
@@ -766,4 +993,8 @@ CAT_API cat_bool_t cat_pipe(cat_os_fd_t fds[2], cat_pipe_flags read_flags, cat_p
 #ifdef __cplusplus
 }
 #endif
+
+/* dns module is a part of socket, and it depends on socket types */
+#include "cat_dns.h"
+
 #endif /* CAT_SOCKET_H */
@@ -29,6 +29,7 @@ extern "C" {
 #define CAT_SSL 1
 
 #include "cat_buffer.h"
+#include "cat_queue.h"
 
 #ifdef _MSC_VER
 # pragma warning(disable:4191) /* FIXME: workaround for MSVC bug */
@@ -126,6 +127,11 @@ extern "C" {
 # endif
 #endif
 
+/* kernel TLS offload needs the kTLS BIO support of OpenSSL 3 and the TLS ULP of Linux */
+#if defined(__linux__) && defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+#define CAT_SSL_HAVE_KTLS 1
+#endif
+
 typedef enum cat_ssl_flag_e {
     CAT_SSL_FLAG_NONE                  = 0,
     CAT_SSL_FLAG_ALLOC                 = 1 << 0,
@@ -134,6 +140,12 @@ typedef enum cat_ssl_flag_e {
     CAT_SSL_FLAG_HANDSHAKE_OK          = 1 << 3,
     CAT_SSL_FLAG_RENEGOTIATION         = 1 << 4,
     CAT_SSL_FLAG_HANDSHAKE_BUFFER_SET  = 1 << 5,
+    /* handshake records are written to the socket directly for kTLS */
+    CAT_SSL_FLAG_KTLS                  = 1 << 6,
+    /* records are encrypted by the kernel, plain data can be written to the socket */
+    CAT_SSL_FLAG_KTLS_SEND             = 1 << 7,
+    /* SSL_read() has records to write but the socket is not writable */
+    CAT_SSL_FLAG_KTLS_WANT_WRITE       = 1 << 8,
     CAT_SSL_FLAG_UNRECOVERABLE_ERROR   = 1 << 31,
 } cat_ssl_flag_t;
 
@@ -212,7 +224,100 @@ typedef enum cat_ssl_ret_e {
     CAT_SSL_RET_WANT_IO = CAT_SSL_RET_WANT_READ | CAT_SSL_RET_WANT_WRITE,
 } cat_ssl_ret_t;
 
+/* session resumption (server side) */
+
+#define CAT_SSL_SESSION_CACHE_DEFAULT_SIZE        20480
+#define CAT_SSL_SESSION_DEFAULT_TIMEOUT           300  /* seconds */
+#define CAT_SSL_TICKET_KEY_DEFAULT_ROTATION       3600 /* seconds */
+#define CAT_SSL_TICKET_KEY_MAX_COUNT              8
+#define CAT_SSL_TICKET_KEY_NAME_SIZE              16
+/* same as nginx, 80 bytes for AES256 (48 bytes for AES128): name, HMAC key and AES key */
+#define CAT_SSL_TICKET_KEY_FILE_ENTRY_SIZE        80
+#define CAT_SSL_TICKET_KEY_FILE_ENTRY_SIZE_AES128 48
+
+typedef struct cat_ssl_session_cache_entry_s cat_ssl_session_cache_entry_t;
+
+typedef struct cat_ssl_session_cache_s {
+    cat_ssl_session_cache_entry_t **buckets;
+    size_t bucket_count;
+    /* the most recently used one is at the front */
+    cat_queue_t lru;
+    size_t size;
+    size_t max_size;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t timeouts;
+    uint64_t evictions;
+} cat_ssl_session_cache_t;
+
+typedef struct cat_ssl_ticket_key_s {
+    size_t size; /* 32 (AES256) or 16 (AES128) */
+    unsigned char name[CAT_SSL_TICKET_KEY_NAME_SIZE];
+    unsigned char hmac_key[32];
+    unsigned char aes_key[32];
+} cat_ssl_ticket_key_t;
+
+typedef struct cat_ssl_ticket_keys_s {
+    /* the first one is used to encrypt, all of them can be used to decrypt */
+    cat_ssl_ticket_key_t keys[CAT_SSL_TICKET_KEY_MAX_COUNT];
+    size_t count;
+    /* keys are loaded from file if it is set, otherwise they are generated and rotated automatically */
+    char *file;
+    cat_msec_t file_checked;
+    int64_t file_mtime;
+    uint64_t file_size;
+    cat_msec_t rotation;
+    cat_msec_t rotated;
+    uint64_t issued;
+    uint64_t decrypted;
+    uint64_t renewed;
+    uint64_t unknown;
+} cat_ssl_ticket_keys_t;
+
+/* session cache and ticket keys are shared by the servers with the same configuration in the current thread,
+ * SSL_CTX holds a reference of the store, and the store is released on runtime shutdown */
+typedef struct cat_ssl_session_store_s {
+    CAT_REF_FIELD;
+    cat_queue_node_t node;
+    /* SHA256 digest of configuration */
+    unsigned char id[32];
+    cat_ssl_session_cache_t cache;
+    cat_ssl_ticket_keys_t ticket_keys;
+} cat_ssl_session_store_t;
+
+typedef struct cat_ssl_session_stats_s {
+    /* handshakes of server side connections */
+    uint64_t handshakes;
+    uint64_t resumed;
+    /* session ID cache */
+    size_t cache_size;
+    size_t cache_max_size;
+    uint64_t cache_hits;
+    uint64_t cache_misses; /* including timeouts */
+    uint64_t cache_timeouts;
+    uint64_t cache_evictions;
+    /* session tickets */
+    size_t ticket_key_count;
+    uint64_t ticket_issued;
+    uint64_t ticket_decrypted;
+    uint64_t ticket_renewed; /* decrypted by old keys */
+    uint64_t ticket_unknown; /* keys were not found */
+} cat_ssl_session_stats_t;
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_ssl) {
+    cat_queue_t session_stores;
+    uint64_t handshakes;
+    uint64_t resumed;
+} CAT_GLOBALS_STRUCT_END(cat_ssl);
+
+extern CAT_API CAT_GLOBALS_DECLARE(cat_ssl);
+
+#define CAT_SSL_G(x) CAT_GLOBALS_GET(cat_ssl, x)
+
 CAT_API cat_bool_t cat_ssl_module_init(void);
+CAT_API cat_bool_t cat_ssl_module_shutdown(void);
+CAT_API cat_bool_t cat_ssl_runtime_init(void);
+CAT_API cat_bool_t cat_ssl_runtime_shutdown(void);
 
 /* context */
 
@@ -240,6 +345,15 @@ CAT_API void cat_ssl_context_set_security_level(cat_ssl_context_t *context, int
 #ifdef CAT_SSL_HAVE_TLS_ALPN
 CAT_API cat_bool_t cas_ssl_context_set_alpn_protocols(cat_ssl_context_t *context, cat_bool_t is_client, const char *alpn_protocols);
 #endif
+/* sessions of different server configurations must not be resumed by each other,
+ * data would be digested to fit the length limit */
+CAT_API cat_bool_t cat_ssl_context_set_session_id_context(cat_ssl_context_t *context, const char *data, size_t length);
+/* seconds */
+CAT_API void cat_ssl_context_set_session_timeout(cat_ssl_context_t *context, long timeout);
+/* use the session cache of store instead of the internal one of context */
+CAT_API cat_bool_t cat_ssl_context_enable_session_cache(cat_ssl_context_t *context, cat_ssl_session_store_t *store);
+/* use the ticket keys of store instead of the ones of context */
+CAT_API cat_bool_t cat_ssl_context_enable_session_tickets(cat_ssl_context_t *context, cat_ssl_session_store_t *store);
 
 /* connection */
 
@@ -255,6 +369,12 @@ CAT_API cat_bool_t cat_ssl_is_established(const cat_ssl_t *ssl);
 
 CAT_API cat_ssl_ret_t cat_ssl_handshake(cat_ssl_t *ssl);
 
+/* must be called before handshake, handshake may return WANT_WRITE after that,
+ * it is not an error if kernel can not take over the encryption at last */
+CAT_API cat_bool_t cat_ssl_enable_ktls(cat_ssl_t *ssl, cat_os_socket_t fd);
+CAT_API cat_bool_t cat_ssl_is_ktls_send_enabled(const cat_ssl_t *ssl);
+CAT_API cat_bool_t cat_ssl_is_ktls_recv_enabled(const cat_ssl_t *ssl);
+
 CAT_API cat_bool_t cat_ssl_verify_peer(cat_ssl_t *ssl, cat_bool_t allow_self_signed);
 CAT_API cat_bool_t cat_ssl_check_host(cat_ssl_t *ssl, const char *name, size_t name_length);
 
@@ -287,6 +407,20 @@ CAT_API cat_bool_t cat_ssl_shutdown(cat_ssl_t *ssl);
 
 /* errors */
 
+/* session resumption (size 0 means that cache is disabled), setters return the original value */
+
+/* the store with the same configuration data is returned if it exists, otherwise a new one is created */
+CAT_API cat_ssl_session_store_t *cat_ssl_session_store_get(const char *data, size_t length);
+CAT_API size_t cat_ssl_session_cache_set_size(cat_ssl_session_store_t *store, size_t max_size);
+CAT_API size_t cat_ssl_session_cache_flush(cat_ssl_session_store_t *store);
+/* keys file can be shared by multi processes, it is reloaded if it was changed (checked once per second),
+ * NULL means that keys are generated and rotated automatically */
+CAT_API cat_bool_t cat_ssl_ticket_keys_set_file(cat_ssl_session_store_t *store, const char *file);
+/* rotation interval (milliseconds) of generated keys */
+CAT_API cat_msec_t cat_ssl_ticket_keys_set_rotation(cat_ssl_session_store_t *store, cat_msec_t rotation);
+/* stats of all stores in the current thread */
+CAT_API void cat_ssl_get_session_stats(cat_ssl_session_stats_t *stats);
+
 CAT_API CAT_COLD void cat_ssl_update_last_error(cat_errno_t code, const char *format, ...);
 CAT_API CAT_COLD cat_bool_t cat_ssl_is_down(const cat_ssl_t *ssl);
 CAT_API CAT_COLD void cat_ssl_unrecoverable_error(cat_ssl_t *ssl);
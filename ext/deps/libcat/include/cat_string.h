@@ -131,6 +131,7 @@ static cat_always_inline void cat_string_move_uncleaned(cat_string_t *from, cat_
 
 CAT_API size_t cat_strnlen(const char *s, size_t n);
 CAT_API const char *cat_strlchr(const char *s, const char *last, char c);
+CAT_API const char *cat_memmem(const char *haystack, size_t haystack_length, const char *needle, size_t needle_length);
 CAT_API char *cat_stpcpy(char *dest, const char *src);
 
 CAT_API char *cat_vsprintf(const char *format, va_list args); CAT_FREE
@@ -0,0 +1,71 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#ifndef CAT_THREAD_CHANNEL_H
+#define CAT_THREAD_CHANNEL_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cat.h"
+#include "cat_channel.h"
+#include "cat_atomic.h"
+
+/* A bounded lock-free MPMC queue which can be shared between OS threads,
+ * it is owned by the thread (runtime) which creates it.
+ * Any thread can push into it or try_pop from it without blocking,
+ * coroutines of the owner thread can also wait on it,
+ * they are woken up through one uv_async_t, and producers only notify it
+ * once per burst (when there are waiters sleeping on it). */
+
+typedef struct cat_thread_channel_s cat_thread_channel_t;
+
+/* owner thread only */
+
+/* capacity will be rounded up to the power of two */
+CAT_API cat_thread_channel_t *cat_thread_channel_create(cat_channel_size_t capacity, cat_channel_data_size_t data_size, cat_channel_data_dtor_t dtor);
+/* wait until an item is available (or channel closed) */
+CAT_API cat_bool_t cat_thread_channel_pop(cat_thread_channel_t *channel, cat_data_t *data, cat_timeout_t timeout);
+/* reject further pushes and wake up all waiters,
+ * items in the channel can still be popped */
+CAT_API cat_bool_t cat_thread_channel_close(cat_thread_channel_t *channel);
+/* close channel, destruct items and release it,
+ * Notice: producers must not access it any more */
+CAT_API void cat_thread_channel_free(cat_thread_channel_t *channel);
+
+/* thread-safe, never block,
+ * Notice: we can not update last error here, because they maybe called in other threads */
+
+/* return cat_false if it is full or closed */
+CAT_API cat_bool_t cat_thread_channel_push(cat_thread_channel_t *channel, const cat_data_t *data);
+/* push items until it is full, waiters are notified only once,
+ * return the number of pushed items */
+CAT_API cat_channel_size_t cat_thread_channel_push_many(cat_thread_channel_t *channel, const cat_data_t *data, cat_channel_size_t count);
+/* return cat_false if it is empty */
+CAT_API cat_bool_t cat_thread_channel_try_pop(cat_thread_channel_t *channel, cat_data_t *data);
+
+/* status (length is only a snapshot if other threads are working on it) */
+
+CAT_API cat_channel_size_t cat_thread_channel_get_capacity(const cat_thread_channel_t *channel);
+CAT_API cat_channel_size_t cat_thread_channel_get_length(const cat_thread_channel_t *channel);
+CAT_API cat_bool_t cat_thread_channel_is_available(const cat_thread_channel_t *channel);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAT_THREAD_CHANNEL_H */
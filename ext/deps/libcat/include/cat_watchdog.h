@@ -28,8 +28,11 @@ extern "C" {
 #include "cat_atomic.h"
 
 #define CAT_WATCH_DOG_DEFAULT_QUANTUM    (5 * 1000 * 1000)
+/* quantum less than it is not meaningful for the timer resolution, it will be rounded up */
+#define CAT_WATCH_DOG_MIN_QUANTUM        (1 * 1000 * 1000)
 #define CAT_WATCH_DOG_DEFAULT_THRESHOLD  (10 * 1000 * 1000)
 #define CAT_WATCH_DOG_THRESHOLD_DISABLED -1
+#define CAT_WATCH_DOG_QUANTUM_DISABLED   -1
 
 #ifndef CAT_THREAD_SAFE
 #define CAT_WATCH_DOG_ROLE_NAME "process"
@@ -61,8 +64,15 @@ struct cat_watchdog_s
     /* do something if blocking time is greater than threshold (nano secondes) */
     cat_timeout_t threshold;
     cat_watchdog_alerter_t alerter;
+    /* info (readonly, they are only meaningful in alerter) */
+    /* how long the current coroutine has been running without switching (nano secondes) */
+    cat_timeout_t blocking_time;
+    /* quantum and threshold of the current coroutine (its own ones or the watchdog ones) */
+    cat_timeout_t effective_quantum;
+    cat_timeout_t effective_threshold;
     /* private */
     cat_alert_count_t alert_count;
+    cat_nsec_t last_check_time;
     cat_bool_t allocated;
     cat_atomic_bool_t stop;
     uv_pid_t pid; /* TODO: cat_pid_t */
@@ -88,6 +98,15 @@ CAT_API cat_bool_t cat_watchdog_is_running(void);
 CAT_API cat_timeout_t cat_watchdog_get_quantum(void);
 CAT_API cat_timeout_t cat_watchdog_get_threshold(void);
 
+/* per-coroutine options (nano secondes), 0 means using the watchdog ones,
+ * and a negative value disables it for the coroutine, setters return the original value.
+ * Notice: watchdog checks at the granularity of the lesser of its own quantum and the least coroutine one
+ * which has ever been set, a positive coroutine quantum less than CAT_WATCH_DOG_MIN_QUANTUM will be rounded up to it. */
+CAT_API cat_timeout_t cat_watchdog_get_coroutine_quantum(const cat_coroutine_t *coroutine);
+CAT_API cat_timeout_t cat_watchdog_set_coroutine_quantum(cat_coroutine_t *coroutine, cat_timeout_t quantum);
+CAT_API cat_timeout_t cat_watchdog_get_coroutine_threshold(const cat_coroutine_t *coroutine);
+CAT_API cat_timeout_t cat_watchdog_set_coroutine_threshold(cat_coroutine_t *coroutine, cat_timeout_t threshold);
+
 #ifdef __cplusplus
 }
 #endif
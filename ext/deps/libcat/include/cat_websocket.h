@@ -23,6 +23,8 @@ extern "C" {
 #endif
 
 #include "cat.h"
+#include "cat_buffer.h"
+#include "cat_socket.h"
 
 #define CAT_WEBSOCKET_VERSION                   13
 #define CAT_WEBSOCKET_SECRET_KEY_LENGTH         16
@@ -37,6 +39,7 @@ extern "C" {
 #define CAT_WEBSOCKET_MASKING_KEY_LENGTH        4
 #define CAT_WEBSOCKET_EMPTY_MASKING_KEY         "\0\0\0\0"
 #define CAT_WEBSOCKET_DEFAULT_MASKING_KEY       "258E"
+#define CAT_WEBSOCKET_MASKING_KEY_POOL_SIZE     (CAT_WEBSOCKET_MASKING_KEY_LENGTH * 16)
 
 #define CAT_WEBSOCKET_OPCODE_MAP(XX) \
     XX(CONTINUATION, 0x0) \
@@ -157,6 +160,136 @@ CAT_API void cat_websocket_mask_ex(const char *from, char *to, uint64_t length,
 CAT_API void cat_websocket_unmask(char *data, uint64_t length, const char *masking_key);
 CAT_API void cat_websocket_unmask_ex(char *data, uint64_t length, const char *masking_key, uint64_t index);
 
+/* masking is done by the widest SIMD implementation which is supported by CPU,
+ * (avx512, avx2, sse2, neon or scalar), it can be changed for benchmarking */
+CAT_API const char *cat_websocket_mask_get_implementation(void);
+CAT_API cat_bool_t cat_websocket_mask_set_implementation(const char *name);
+
+/* UTF-8 validation state of text frames, it can be carried across fragments,
+ * and payload data is valid only if the state is ACCEPT at the end of the message */
+#define CAT_WEBSOCKET_UTF8_ACCEPT 0
+#define CAT_WEBSOCKET_UTF8_REJECT 12
+/* states are multiples of 12 in [0, 96] */
+#define CAT_WEBSOCKET_UTF8_STATE_MAX 96
+#define CAT_WEBSOCKET_UTF8_STATE_IS_VALID(state) ((state) <= CAT_WEBSOCKET_UTF8_STATE_MAX && ((state) % 12) == 0)
+
+typedef uint32_t cat_websocket_utf8_state_t;
+
+/* state must be valid (see CAT_WEBSOCKET_UTF8_STATE_IS_VALID()) */
+CAT_API cat_bool_t cat_websocket_utf8_validate(const char *data, uint64_t length, cat_websocket_utf8_state_t *state);
+
+/* unmask data into another place and validate it as UTF-8 at the same time if utf8_state is not NULL,
+ * data is always unmasked completely, return false if it is not valid UTF-8 */
+CAT_API cat_bool_t cat_websocket_unmask_to(const char *from, char *to, uint64_t length, const char *masking_key, uint64_t index, cat_websocket_utf8_state_t *utf8_state);
+
+/* permessage-deflate (RFC 7692) */
+
+#define CAT_WEBSOCKET_DEFLATE_EXTENSION_NAME "permessage-deflate"
+/* what client offers in Sec-WebSocket-Extensions by default */
+#define CAT_WEBSOCKET_DEFLATE_DEFAULT_OFFER  CAT_WEBSOCKET_DEFLATE_EXTENSION_NAME "; client_max_window_bits"
+/* zlib does not support 8 bits window for deflate */
+#define CAT_WEBSOCKET_DEFLATE_MIN_WINDOW_BITS 9
+#define CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS 15
+/* it is not worth compressing tiny messages */
+#define CAT_WEBSOCKET_DEFLATE_DEFAULT_THRESHOLD 64
+
+typedef struct cat_websocket_deflate_options_s {
+    cat_bool_t server_no_context_takeover;
+    cat_bool_t client_no_context_takeover;
+    uint8_t server_max_window_bits;
+    uint8_t client_max_window_bits;
+} cat_websocket_deflate_options_t;
+
+CAT_API void cat_websocket_deflate_options_init(cat_websocket_deflate_options_t *options);
+/* parse the first acceptable permessage-deflate offer (or response) of Sec-WebSocket-Extensions value,
+ * return false if there is no acceptable one */
+CAT_API cat_bool_t cat_websocket_deflate_options_parse(cat_websocket_deflate_options_t *options, const char *extensions, size_t length);
+/* as a server, accept the client offer and output the response of Sec-WebSocket-Extensions value */
+CAT_API cat_bool_t cat_websocket_deflate_options_negotiate(cat_websocket_deflate_options_t *options, const char *offer, size_t length, cat_buffer_t *response);
+CAT_API cat_bool_t cat_websocket_deflate_options_format(const cat_websocket_deflate_options_t *options, cat_buffer_t *buffer);
+
+/* frame codec:
+ * it reads frames from stream socket and reassembles fragmented messages,
+ * control frames may be answered automatically, and messages can be compressed by permessage-deflate.
+ * the connection should be closed after any error occurred except timed out while waiting for a new frame. */
+
+#define CAT_WEBSOCKET_CODEC_FLAG_MAP(XX) \
+    XX(NONE,          0) \
+    /* frames sent are masked and frames received must be unmasked, otherwise, it is a server */ \
+    XX(CLIENT,        1 << 0) \
+    /* reply pong to ping and drop pong */ \
+    XX(AUTO_PONG,     1 << 1) \
+    /* reply close to close, and send close with status code before returning protocol error */ \
+    XX(AUTO_CLOSE,    1 << 2) \
+    /* text message and close reason must be valid UTF-8 */ \
+    XX(VALIDATE_UTF8, 1 << 3) \
+    XX(DEFAULT,       (1 << 1) | (1 << 2) | (1 << 3)) \
+
+typedef enum cat_websocket_codec_flag_e {
+#define CAT_WEBSOCKET_CODEC_FLAG_GEN(name, value) CAT_ENUM_GEN(CAT_WEBSOCKET_CODEC_FLAG_, name, value)
+    CAT_WEBSOCKET_CODEC_FLAG_MAP(CAT_WEBSOCKET_CODEC_FLAG_GEN)
+#undef CAT_WEBSOCKET_CODEC_FLAG_GEN
+} cat_websocket_codec_flag_t;
+
+typedef uint32_t cat_websocket_codec_flags_t;
+
+#ifndef CAT_WEBSOCKET_DEFAULT_MAX_MESSAGE_LENGTH
+#define CAT_WEBSOCKET_DEFAULT_MAX_MESSAGE_LENGTH (16 * 1024 * 1024)
+#endif
+
+typedef struct cat_websocket_codec_s {
+    cat_websocket_codec_flags_t flags;
+    /* max length of (decompressed) message, 0 means unlimited (it must be opted in explicitly) */
+    uint64_t max_message_length;
+    /* receiving state of the fragmented message */
+    cat_websocket_opcode_t message_opcode;
+    cat_bool_t message_compressed;
+    size_t message_offset;
+    cat_websocket_utf8_state_t utf8_state;
+    /* the payload of the last control frame which is returned */
+    uint8_t control_payload_length;
+    char control_payload[CAT_WEBSOCKET_CONTROL_FRAME_MAX_PAYLOAD_LENGTH];
+    cat_bool_t close_sent;
+    cat_bool_t close_received;
+    /* error occurred in the middle of a frame */
+    cat_bool_t broken;
+    /* masking keys drawn from CSPRNG which have not been used yet */
+    uint8_t masking_key_pool_offset;
+    char masking_key_pool[CAT_WEBSOCKET_MASKING_KEY_POOL_SIZE];
+    /* compressed payload of received frames, or masked/compressed payload of message to send */
+    cat_buffer_t recv_buffer;
+    cat_buffer_t send_buffer;
+    cat_bool_t sending;
+    /* permessage-deflate */
+    cat_bool_t deflate_enabled;
+    int deflate_level;
+    size_t deflate_threshold;
+    cat_bool_t deflate_no_context_takeover;
+    cat_bool_t inflate_no_context_takeover;
+    void *deflate_stream;
+    void *inflate_stream;
+} cat_websocket_codec_t;
+
+CAT_API void cat_websocket_codec_init(cat_websocket_codec_t *codec, cat_websocket_codec_flags_t flags);
+/* enable permessage-deflate with negotiated options, level is compression level of zlib (-1 means default) */
+CAT_API cat_bool_t cat_websocket_codec_enable_deflate(cat_websocket_codec_t *codec, const cat_websocket_deflate_options_t *options, int level);
+CAT_API void cat_websocket_codec_close(cat_websocket_codec_t *codec);
+
+/* receive a whole message and append its payload to the buffer, return the opcode or -1 on error,
+ * data message (TEXT or BINARY) is appended to the buffer,
+ * control frames which are not answered automatically are returned (PING, PONG and CLOSE),
+ * and their payload can be got by cat_websocket_codec_get_control_payload(),
+ * if a control frame is returned in the middle of a fragmented message,
+ * the same buffer should be passed in the next call to continue receiving the message. */
+CAT_API int cat_websocket_recv_message(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_buffer_t *buffer);
+CAT_API int cat_websocket_recv_message_ex(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_buffer_t *buffer, cat_timeout_t timeout);
+CAT_API const char *cat_websocket_codec_get_control_payload(const cat_websocket_codec_t *codec, size_t *length);
+/* send a message in a single frame, data message may be compressed */
+CAT_API cat_bool_t cat_websocket_send_message(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_websocket_opcode_t opcode, const char *data, size_t length);
+CAT_API cat_bool_t cat_websocket_send_message_ex(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_websocket_opcode_t opcode, const char *data, size_t length, cat_timeout_t timeout);
+CAT_API cat_bool_t cat_websocket_send_close(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_websocket_status_code_t code, const char *reason, size_t reason_length);
+CAT_API cat_bool_t cat_websocket_send_close_ex(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_websocket_status_code_t code, const char *reason, size_t reason_length, cat_timeout_t timeout);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,6 +23,7 @@ extern "C" {
 #endif
 
 #include "cat.h"
+#include "cat_queue.h"
 
 typedef cat_data_callback_t cat_work_function_t;
 typedef cat_data_callback_t cat_work_cleanup_callback_t;
@@ -33,7 +34,80 @@ typedef enum cat_work_kind_e {
   CAT_WORK_KIND_SLOW_IO = UV_WORK_SLOW_IO,
 } cat_work_kind_t;
 
+#define CAT_WORK_KIND_COUNT 3
+
+#define CAT_WORK_POOL_MAX_SIZE 1024
+
+/* works are run in separated thread pools by kind,
+ * pools are shared by all runtimes in the process,
+ * size can be set by env CAT_WORK_{CPU,FAST_IO,SLOW_IO}_POOL_SIZE */
+
+typedef struct cat_work_job_s {
+    cat_work_function_t function;
+    /* it would be called after the waiter was resumed, or work was canceled */
+    cat_work_cleanup_callback_t cleanup;
+    cat_data_t *data;
+    /* output: 0 or error code (e.g. CAT_ECANCELED) */
+    int status;
+} cat_work_job_t;
+
+typedef struct cat_work_pool_stats_s {
+    /* max number of works running at the same time */
+    unsigned int size;
+    /* number of threads started */
+    unsigned int threads;
+    /* number of works running */
+    unsigned int running;
+    /* queue depth */
+    size_t queued;
+    size_t max_queued;
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t canceled;
+    /* latency in nanoseconds (queued time and running time) */
+    uint64_t wait_time;
+    uint64_t max_wait_time;
+    uint64_t run_time;
+    uint64_t max_run_time;
+} cat_work_pool_stats_t;
+
+typedef struct cat_work_context_s cat_work_context_t;
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_work) {
+    /* finished works are posted back by pool threads */
+    uv_mutex_t mutex;
+    cat_queue_t done;
+    uv_async_t async;
+    /* works which are not finished yet */
+    size_t inflight;
+    /* runtime is shutting down, close it once all works are posted back */
+    cat_bool_t closing;
+    /* recycled contexts */
+    cat_queue_t free_contexts;
+    cat_queue_t slabs;
+} CAT_GLOBALS_STRUCT_END(cat_work);
+
+extern CAT_API CAT_GLOBALS_DECLARE(cat_work);
+
+#define CAT_WORK_G(x) CAT_GLOBALS_GET(cat_work, x)
+
+/* module initialization (called by event module) */
+
+CAT_API cat_bool_t cat_work_module_init(void);
+CAT_API cat_bool_t cat_work_module_shutdown(void);
+CAT_API cat_bool_t cat_work_runtime_init(void);
+CAT_API cat_bool_t cat_work_runtime_shutdown(void);
+
 CAT_API cat_bool_t cat_work(cat_work_kind_t kind, cat_work_function_t function, cat_work_cleanup_callback_t cleanup, cat_data_t *data, cat_timeout_t timeout);
+/* submit all jobs and wait for all of them with one yield,
+ * if it was timedout or canceled, works which have not been started would be canceled,
+ * and the rest of them would be cleaned up after they are done.
+ * Notice: it returns true even if some of jobs failed, check their status */
+CAT_API cat_bool_t cat_work_many(cat_work_kind_t kind, cat_work_job_t *jobs, size_t count, cat_timeout_t timeout);
+
+CAT_API unsigned int cat_work_pool_get_size(cat_work_kind_t kind);
+CAT_API cat_bool_t cat_work_pool_set_size(cat_work_kind_t kind, unsigned int size);
+CAT_API cat_bool_t cat_work_pool_get_stats(cat_work_kind_t kind, cat_work_pool_stats_t *stats);
 
 #ifdef __cplusplus
 }
@@ -61,6 +61,10 @@ CAT_API cat_bool_t cat_module_shutdown_all(void)
     ret = cat_os_wait_module_shutdown() && ret;
 #endif
     ret = cat_socket_module_shutdown() && ret;
+#ifdef CAT_SSL
+    ret = cat_ssl_module_shutdown() && ret;
+#endif
+    ret = cat_buffer_module_shutdown() && ret;
     ret = cat_event_module_shutdown() && ret;
     ret = cat_coroutine_module_shutdown() && ret;
     ret = cat_module_shutdown() && ret;
@@ -73,7 +77,11 @@ CAT_API cat_bool_t cat_runtime_init_all(void)
     return cat_runtime_init() &&
            cat_coroutine_runtime_init() &&
            cat_event_runtime_init() &&
+           cat_buffer_runtime_init() &&
            cat_socket_runtime_init() &&
+#ifdef CAT_SSL
+           cat_ssl_runtime_init() &&
+#endif
 #ifdef CAT_OS_WAIT
            cat_os_wait_runtime_init() &&
 #endif
@@ -90,6 +98,7 @@ CAT_API cat_bool_t cat_runtime_shutdown_all(void)
     ret = cat_os_wait_runtime_shutdown() && ret;
 #endif
     ret = cat_event_runtime_shutdown() && ret;
+    ret = cat_buffer_runtime_shutdown() && ret;
     ret = cat_coroutine_runtime_shutdown() && ret;
     ret = cat_runtime_shutdown() && ret;
 
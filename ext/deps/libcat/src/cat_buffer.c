@@ -62,11 +62,36 @@ CAT_API cat_bool_t cat_buffer_module_init(void)
         cat_buffer_free_standard
     };
 
+    CAT_GLOBALS_REGISTER(cat_buffer);
+
     cat_buffer_allocator = allocator;
 
     return cat_true;
 }
 
+CAT_API cat_bool_t cat_buffer_module_shutdown(void)
+{
+    CAT_GLOBALS_UNREGISTER(cat_buffer);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_buffer_runtime_init(void)
+{
+    memset(&CAT_BUFFER_G(pool), 0, sizeof(CAT_BUFFER_G(pool)));
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_buffer_runtime_shutdown(void)
+{
+    if (CAT_BUFFER_G(pool).registered) {
+        (void) cat_buffer_pool_unregister();
+    }
+
+    return cat_true;
+}
+
 CAT_API cat_bool_t cat_buffer_register_allocator(const cat_buffer_allocator_t *allocator)
 {
     if (
@@ -77,6 +102,10 @@ CAT_API cat_bool_t cat_buffer_register_allocator(const cat_buffer_allocator_t *a
         cat_update_last_error(CAT_EINVAL, "Allocator must be filled (except update)");
         return cat_false;
     }
+    if (unlikely(CAT_BUFFER_G(pool).registered)) {
+        cat_update_last_error(CAT_EMISUSE, "Allocator can not be changed while buffer pool is registered");
+        return cat_false;
+    }
     cat_buffer_allocator = *allocator;
 
     return cat_true;
@@ -89,6 +118,117 @@ static cat_always_inline void cat_buffer__init(cat_buffer_t *buffer)
     buffer->length = 0;
 }
 
+/* buffer pool */
+
+CAT_API CAT_GLOBALS_DECLARE(cat_buffer);
+
+#define cat_buffer_pool_next(value) (*((char **) (value)))
+
+static char *cat_buffer_pool_alloc(cat_buffer_pool_t *pool, size_t size)
+{
+    char *value;
+
+    if (size != pool->block_size) {
+        return cat_buffer_allocator.alloc_function(size);
+    }
+    value = pool->head;
+    if (value == NULL) {
+        pool->misses++;
+        return cat_buffer_allocator.alloc_function(size);
+    }
+    pool->head = cat_buffer_pool_next(value);
+    pool->count--;
+    pool->hits++;
+    /* it is a new value for the caller */
+    if (cat_buffer_allocator.update_function != NULL) {
+        cat_buffer_allocator.update_function(value, 0);
+    }
+
+    return value;
+}
+
+CAT_API cat_bool_t cat_buffer_pool_register(size_t block_size, size_t max_size)
+{
+    cat_buffer_pool_t *pool = &CAT_BUFFER_G(pool);
+
+    if (unlikely(pool->registered)) {
+        cat_update_last_error(CAT_EMISUSE, "Buffer pool has been registered");
+        return cat_false;
+    }
+    if (unlikely(block_size < sizeof(char *))) {
+        cat_update_last_error(CAT_EINVAL, "Buffer pool block size should be at least %zu", sizeof(char *));
+        return cat_false;
+    }
+    memset(pool, 0, sizeof(*pool));
+    pool->registered = cat_true;
+    pool->block_size = block_size;
+    pool->max_size = max_size != 0 ? max_size : CAT_BUFFER_POOL_DEFAULT_SIZE;
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_buffer_pool_unregister(void)
+{
+    cat_buffer_pool_t *pool = &CAT_BUFFER_G(pool);
+
+    if (unlikely(!pool->registered)) {
+        cat_update_last_error(CAT_EMISUSE, "Buffer pool has not been registered");
+        return cat_false;
+    }
+    cat_buffer_pool_clear();
+    pool->registered = cat_false;
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_buffer_pool_recycle(cat_buffer_t *buffer)
+{
+    cat_buffer_pool_t *pool = &CAT_BUFFER_G(pool);
+    char *value = buffer->value;
+
+    if (
+        value == NULL ||
+        !pool->registered ||
+        buffer->size != pool->block_size ||
+        pool->count >= pool->max_size
+    ) {
+        cat_buffer_close(buffer);
+        return cat_false;
+    }
+    cat_buffer_pool_next(value) = pool->head;
+    pool->head = value;
+    pool->count++;
+    pool->recycles++;
+    cat_buffer__init(buffer);
+
+    return cat_true;
+}
+
+CAT_API void cat_buffer_pool_clear(void)
+{
+    cat_buffer_pool_t *pool = &CAT_BUFFER_G(pool);
+    char *value;
+
+    while ((value = pool->head) != NULL) {
+        pool->head = cat_buffer_pool_next(value);
+        cat_buffer_allocator.free_function(value);
+    }
+    pool->count = 0;
+}
+
+CAT_API void cat_buffer_pool_get_stats(cat_buffer_pool_stats_t *stats)
+{
+    const cat_buffer_pool_t *pool = &CAT_BUFFER_G(pool);
+
+    stats->registered = pool->registered;
+    stats->block_size = pool->block_size;
+    stats->max_size = pool->max_size;
+    stats->count = pool->count;
+    stats->hits = pool->hits;
+    stats->misses = pool->misses;
+    stats->recycles = pool->recycles;
+}
+
 static cat_always_inline cat_bool_t cat_buffer__alloc(cat_buffer_t *buffer, size_t size)
 {
     char *value;
@@ -98,7 +238,11 @@ static cat_always_inline cat_bool_t cat_buffer__alloc(cat_buffer_t *buffer, size
         return cat_true;
     }
 
-    value = cat_buffer_allocator.alloc_function(size);
+    if (unlikely(CAT_BUFFER_G(pool).registered)) {
+        value = cat_buffer_pool_alloc(&CAT_BUFFER_G(pool), size);
+    } else {
+        value = cat_buffer_allocator.alloc_function(size);
+    }
 
     if (unlikely(value == NULL)) {
         return cat_false;
@@ -256,55 +256,129 @@ static cat_bool_t cat_channel_unbuffered_pop(cat_channel_t *channel, cat_data_t
     return cat_true;
 }
 
-static cat_always_inline cat_channel_bucket_t *cat_channel_buffered_bucket_create(const cat_data_t *data, size_t data_size)
+#define CAT_CHANNEL_BUFFERED_MIN_SIZE 8
+
+static cat_always_inline char *cat_channel_buffered_slot(const cat_channel_t *channel, cat_channel_size_t index)
 {
-    cat_channel_bucket_t *bucket;
+    return channel->u.buffered.storage + ((size_t) (index & channel->u.buffered.mask)) * channel->data_size;
+}
 
-    bucket = (cat_channel_bucket_t *) cat_malloc(offsetof(cat_channel_bucket_t, data) + data_size);
+static cat_always_inline uint64_t cat_channel_buffered_size(const cat_channel_t *channel)
+{
+    return channel->u.buffered.storage != NULL ? ((uint64_t) channel->u.buffered.mask) + 1 : 0;
+}
 
+static cat_never_inline cat_bool_t cat_channel_buffered_grow(cat_channel_t *channel, uint64_t required_size)
+{
+    uint64_t old_size = cat_channel_buffered_size(channel);
+    uint64_t size = old_size != 0 ? old_size : CAT_CHANNEL_BUFFERED_MIN_SIZE;
+    uint64_t max_size = 1;
+    cat_channel_size_t head = channel->u.buffered.head;
+    size_t data_size = channel->data_size;
+    char *storage;
+
+    /* the ring size is always a power of two, so that index can be masked */
+    while (max_size < channel->capacity) {
+        max_size <<= 1;
+    }
+    while (size < required_size) {
+        size <<= 1;
+    }
+    if (size > max_size) {
+        size = max_size;
+    }
+    CAT_ASSERT(size > old_size && size >= required_size);
+    if (unlikely(size > SIZE_MAX / data_size)) {
+        cat_update_last_error(CAT_ENOMEM, "Channel storage size overflow");
+        return cat_false;
+    }
+
+    storage = (char *) cat_realloc(channel->u.buffered.storage, (size_t) (size * data_size));
 #if CAT_ALLOC_HANDLE_ERRORS
-    if (unlikely(bucket == NULL)) {
-        cat_update_last_error_of_syscall("Malloc for channel bucket failed");
-        return NULL;
+    if (unlikely(storage == NULL)) {
+        cat_update_last_error_of_syscall("Realloc for channel storage failed");
+        return cat_false;
     }
 #endif
 
-    memcpy(bucket->data, data, data_size);
+    /* move the wrapped part behind the old end, items are contiguous again */
+    if ((uint64_t) head + channel->length > old_size) {
+        size_t wrapped = (size_t) (head + channel->length - old_size);
+        memcpy(storage + old_size * data_size, storage, wrapped * data_size);
+    }
+    channel->u.buffered.storage = storage;
+    channel->u.buffered.mask = (cat_channel_size_t) (size - 1);
 
-    return bucket;
+    return cat_true;
 }
 
-static cat_always_inline cat_bool_t cat_channel_buffered_push_data(cat_channel_t *channel, const cat_data_t *data)
+static cat_always_inline cat_bool_t cat_channel_buffered_push_data_many(cat_channel_t *channel, const cat_data_t *data, cat_channel_size_t count)
 {
-    cat_channel_bucket_t *bucket;
+    size_t data_size = channel->data_size;
+    cat_channel_size_t tail;
+    uint64_t size, n;
 
-    bucket = cat_channel_buffered_bucket_create(data, channel->data_size);
-
-#if CAT_ALLOC_HANDLE_ERRORS
-    if (unlikely(bucket == NULL)) {
-        return cat_false;
+    CAT_ASSERT(count > 0 && count <= channel->capacity - channel->length);
+    size = cat_channel_buffered_size(channel);
+    if (unlikely(((uint64_t) channel->length) + count > size)) {
+        if (unlikely(!cat_channel_buffered_grow(channel, ((uint64_t) channel->length) + count))) {
+            return cat_false;
+        }
+        size = cat_channel_buffered_size(channel);
     }
-#endif
-
-    cat_queue_push_back(&channel->u.buffered.storage, &bucket->node);
-    channel->length++;
+    tail = (channel->u.buffered.head + channel->length) & channel->u.buffered.mask;
+    n = CAT_MIN(count, size - tail);
+    memcpy(cat_channel_buffered_slot(channel, tail), data, (size_t) n * data_size);
+    if (n < count) {
+        memcpy(channel->u.buffered.storage, ((const char *) data) + n * data_size, (size_t) (count - n) * data_size);
+    }
+    channel->length += count;
 
     return cat_true;
 }
 
+static cat_always_inline cat_bool_t cat_channel_buffered_push_data(cat_channel_t *channel, const cat_data_t *data)
+{
+    return cat_channel_buffered_push_data_many(channel, data, 1);
+}
+
 static cat_always_inline void cat_channel_buffered_pop_data(cat_channel_t *channel, cat_data_t *data)
 {
-    cat_channel_bucket_t *bucket;
+    const char *item = cat_channel_buffered_slot(channel, channel->u.buffered.head);
 
-    bucket = cat_queue_front_data(&channel->u.buffered.storage, cat_channel_bucket_t, node);
-    cat_queue_remove(&bucket->node);
     if (data != NULL) {
-        memcpy(data, bucket->data, channel->data_size);
-    } else if (channel->dtor != NULL) {
-        channel->dtor(bucket->data);
+        memcpy(data, item, channel->data_size);
     }
-    cat_free(bucket);
+    channel->u.buffered.head = (channel->u.buffered.head + 1) & channel->u.buffered.mask;
     channel->length--;
+    if (data == NULL && channel->dtor != NULL) {
+        /* the slot may be reused by dtor, so make a copy first */
+        char buffer[CAT_CHANNEL_DATA_SIZE_MAX];
+        memcpy(buffer, item, channel->data_size);
+        channel->dtor(buffer);
+    }
+}
+
+static cat_always_inline void cat_channel_buffered_pop_data_many(cat_channel_t *channel, cat_data_t *data, cat_channel_size_t count)
+{
+    size_t data_size = channel->data_size;
+    cat_channel_size_t head = channel->u.buffered.head;
+    uint64_t n;
+
+    CAT_ASSERT(count > 0 && count <= channel->length);
+    if (data == NULL) {
+        while (count--) {
+            cat_channel_buffered_pop_data(channel, NULL);
+        }
+        return;
+    }
+    n = CAT_MIN(count, cat_channel_buffered_size(channel) - head);
+    memcpy(data, cat_channel_buffered_slot(channel, head), (size_t) n * data_size);
+    if (n < count) {
+        memcpy(((char *) data) + n * data_size, channel->u.buffered.storage, (size_t) (count - n) * data_size);
+    }
+    channel->u.buffered.head = (head + count) & channel->u.buffered.mask;
+    channel->length -= count;
 }
 
 static cat_always_inline void cat_channel_notify_possible_consumer(cat_channel_t *channel)
@@ -327,6 +401,28 @@ static cat_always_inline void cat_channel_notify_possible_producer(cat_channel_t
     }
 }
 
+static cat_always_inline void cat_channel_notify_possible_consumers(cat_channel_t *channel, cat_channel_size_t count)
+{
+    cat_coroutine_t *consumer;
+
+    /* consumers may do anything after resumed, so check the state every time */
+    while (count-- > 0 && !cat_channel__is_empty(channel) &&
+           (consumer = cat_queue_front_data(&channel->consumers, cat_coroutine_t, waiter.node)) != NULL) {
+        cat_channel_resume_waiter(consumer, "Consumer");
+    }
+}
+
+static cat_always_inline void cat_channel_notify_possible_producers(cat_channel_t *channel, cat_channel_size_t count)
+{
+    cat_coroutine_t *producer;
+
+    /* producers may do anything after resumed, so check the state every time */
+    while (count-- > 0 && !cat_channel__is_full(channel) &&
+           (producer = cat_queue_front_data(&channel->producers, cat_coroutine_t, waiter.node)) != NULL) {
+        cat_channel_resume_waiter(producer, "Producer");
+    }
+}
+
 static cat_bool_t cat_channel_buffered_push(cat_channel_t *channel, const cat_data_t *data, cat_timeout_t timeout)
 {
     /* if it is full, just wait */
@@ -347,13 +443,9 @@ static cat_bool_t cat_channel_buffered_push(cat_channel_t *channel, const cat_da
     } else {
         CAT_ASSERT(!cat_channel__has_producers(channel));
         /* push data to the storage queue */
-#if CAT_ALLOC_HANDLE_ERRORS
         if (unlikely(!cat_channel_buffered_push_data(channel, data))) {
             return cat_false;
         }
-#else
-        (void) cat_channel_buffered_push_data(channel, data);
-#endif
         /* try to notify one for balance */
         cat_channel_notify_possible_consumer(channel);
         return cat_true;
@@ -388,6 +480,56 @@ static cat_bool_t cat_channel_buffered_pop(cat_channel_t *channel, cat_data_t *d
     return cat_true;
 }
 
+static cat_channel_size_t cat_channel_buffered_push_many(cat_channel_t *channel, const cat_data_t *data, cat_channel_size_t count, cat_timeout_t timeout)
+{
+    /* if it is full, just wait */
+    if (cat_channel__is_full(channel)) {
+        if (unlikely(!cat_channel_wait_on(channel, &channel->producers, timeout))) {
+            /* sleep failed or timedout */
+            cat_update_last_error_with_previous("Channel wait consumer failed");
+            return 0;
+        }
+        if (unlikely(cat_channel__is_full(channel))) {
+            /* still full, must be canceled */
+            cat_update_last_error(CAT_ECANCELED, "Channel push has been canceled");
+            return 0;
+        }
+    }
+    /* push as many as possible to the storage queue */
+    count = CAT_MIN(count, channel->capacity - channel->length);
+    if (unlikely(!cat_channel_buffered_push_data_many(channel, data, count))) {
+        return 0;
+    }
+    /* try to notify consumers for balance */
+    cat_channel_notify_possible_consumers(channel, count);
+
+    return count;
+}
+
+static cat_channel_size_t cat_channel_buffered_pop_many(cat_channel_t *channel, cat_data_t *data, cat_channel_size_t count, cat_timeout_t timeout)
+{
+    /* if it is empty, just wait */
+    if (cat_channel__is_empty(channel)) {
+        if (unlikely(!cat_channel_wait_on(channel, &channel->consumers, timeout))) {
+            /* sleep failed or timedout */
+            cat_update_last_error_with_previous("Channel wait producer failed");
+            return 0;
+        }
+        if (unlikely(cat_channel__is_empty(channel))) {
+            /* still empty, must be canceled */
+            cat_update_last_error(CAT_ECANCELED, "Channel pop has been canceled");
+            return 0;
+        }
+    }
+    /* pop as many as possible from the storage queue */
+    count = CAT_MIN(count, channel->length);
+    cat_channel_buffered_pop_data_many(channel, data, count);
+    /* try to notify producers for balance */
+    cat_channel_notify_possible_producers(channel, count);
+
+    return count;
+}
+
 /* common */
 
 CAT_API cat_channel_t *cat_channel_create(cat_channel_t *channel, cat_channel_size_t capacity, cat_channel_data_size_t data_size, cat_channel_data_dtor_t dtor)
@@ -402,7 +544,10 @@ CAT_API cat_channel_t *cat_channel_create(cat_channel_t *channel, cat_channel_si
     if (cat_channel__is_unbuffered(channel)) {
         memset(&channel->u.unbuffered, 0, sizeof(channel->u.unbuffered));
     } else {
-        cat_queue_init(&channel->u.buffered.storage);
+        /* storage will be allocated on demand */
+        channel->u.buffered.storage = NULL;
+        channel->u.buffered.mask = 0;
+        channel->u.buffered.head = 0;
     }
 
     return channel;
@@ -431,6 +576,37 @@ CAT_API cat_bool_t cat_channel_pop(cat_channel_t *channel, cat_data_t *data, cat
     }
 }
 
+CAT_API cat_channel_size_t cat_channel_push_many(cat_channel_t *channel, const cat_data_t *data, cat_channel_size_t count, cat_timeout_t timeout)
+{
+    CAT_CHANNEL_CHECK_STATE(channel, return 0);
+    CAT_ASSERT(data != NULL);
+
+    if (unlikely(count == 0)) {
+        cat_update_last_error(CAT_EINVAL, "Channel push count can not be zero");
+        return 0;
+    }
+    if (cat_channel__is_unbuffered(channel)) {
+        return cat_channel_unbuffered_push(channel, data, timeout) ? 1 : 0;
+    } else {
+        return cat_channel_buffered_push_many(channel, data, count, timeout);
+    }
+}
+
+CAT_API cat_channel_size_t cat_channel_pop_many(cat_channel_t *channel, cat_data_t *data, cat_channel_size_t count, cat_timeout_t timeout)
+{
+    CAT_CHANNEL_CHECK_STATE_FOR_READING(channel, return 0);
+
+    if (unlikely(count == 0)) {
+        cat_update_last_error(CAT_EINVAL, "Channel pop count can not be zero");
+        return 0;
+    }
+    if (cat_channel__is_unbuffered(channel)) {
+        return cat_channel_unbuffered_pop(channel, data, timeout) ? 1 : 0;
+    } else {
+        return cat_channel_buffered_pop_many(channel, data, count, timeout);
+    }
+}
+
 CAT_API cat_bool_t cat_channel_close(cat_channel_t *channel)
 {
     CAT_CHANNEL_CHECK_STATE(channel, return cat_false);
@@ -459,19 +635,17 @@ CAT_API void cat_channel_cleanup(cat_channel_t *channel)
         (void) cat_channel_close(channel);
     }
 
-    /* clean up the data bucket (no more consumers) */
+    /* clean up the data storage (no more consumers) */
     if (!cat_channel__is_unbuffered(channel)) {
-        cat_queue_t *storage = &channel->u.buffered.storage;
-        cat_channel_data_dtor_t dtor = channel->dtor;
-        cat_channel_bucket_t *bucket;
-        while ((bucket = cat_queue_front_data(storage, cat_channel_bucket_t, node))) {
-            cat_queue_remove(&bucket->node);
-            if (dtor != NULL) {
-                dtor(bucket->data);
-            }
-            cat_free(bucket);
-            channel->length--;
+        while (!cat_channel__is_empty(channel)) {
+            cat_channel_buffered_pop_data(channel, NULL);
+        }
+        if (channel->u.buffered.storage != NULL) {
+            cat_free(channel->u.buffered.storage);
+            channel->u.buffered.storage = NULL;
         }
+        channel->u.buffered.mask = 0;
+        channel->u.buffered.head = 0;
     }
 
     /* everything will be reset after close */
@@ -657,10 +831,10 @@ CAT_API cat_channel_data_dtor_t cat_channel_set_dtor(cat_channel_t *channel, cat
 
 /* ext */
 
-CAT_API cat_queue_t *cat_channel_get_storage(cat_channel_t *channel)
+CAT_API cat_data_t *cat_channel_get_storage_item(const cat_channel_t *channel, cat_channel_size_t index)
 {
-    if (unlikely(cat_channel__is_unbuffered(channel))) {
+    if (unlikely(cat_channel__is_unbuffered(channel) || index >= channel->length)) {
         return NULL;
     }
-    return &channel->u.buffered.storage;
+    return cat_channel_buffered_slot(channel, channel->u.buffered.head + index);
 }
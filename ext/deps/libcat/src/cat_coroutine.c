@@ -154,6 +154,255 @@ static cat_coroutine_stack_size_t cat_coroutine_align_stack_size(size_t size)
     return (cat_coroutine_stack_size_t) size;
 }
 
+#ifdef CAT_COROUTINE_USE_USER_STACK
+/* stack */
+
+static void *cat_coroutine_stack_alloc(size_t virtual_memory_size)
+{
+    void *virtual_memory;
+
+#if defined(CAT_COROUTINE_USE_MMAP)
+    virtual_memory = mmap(NULL, virtual_memory_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+#elif defined(CAT_COROUTINE_USE_VIRTUAL_ALLOC)
+    virtual_memory = VirtualAlloc(0, virtual_memory_size, MEM_COMMIT, PAGE_READWRITE);
+#else // if defined(CAT_COROUTINE_USE_SYS_MALLOC)
+    virtual_memory = cat_sys_malloc_recoverable(virtual_memory_size);
+#endif
+    if (unlikely(virtual_memory == CAT_COROUTINE_MEMORY_INVALID)) {
+        cat_update_last_error_of_syscall("Allocate virtual memory for coroutine stack failed with size %zu", virtual_memory_size);
+        return NULL;
+    }
+
+#ifdef CAT_COROUTINE_MEMORY_PROTECT_SUPPORT
+    /* protect a page of memory after the stack top
+     * to notify stack overflow */
+    if (cat_coroutine_use_memory_protect) {
+        void *page = virtual_memory;
+        cat_bool_t ret;
+# ifdef CAT_COROUTINE_USE_SYS_MALLOC
+        /* mallocated memory is not aligned with the page */
+        page = cat_getpageafter(page);
+# endif
+# ifndef CAT_OS_WIN
+        ret = mprotect(page, cat_getpagesize(), PROT_NONE) == 0;
+# else
+        DWORD old_protect;
+        ret = VirtualProtect(page, cat_getpagesize(), PAGE_NOACCESS /* PAGE_READWRITE | PAGE_GUARD */, &old_protect) != 0;
+# endif
+        CAT_LOG_DEBUG_V2(COROUTINE, "Protect stack page at %p with %zu bytes %s", page, cat_getpagesize(), ret ? "successfully" : "failed");
+        if (unlikely(!ret)) {
+            CAT_SYSCALL_FAILURE(NOTICE, COROUTINE, "Protect stack page failed");
+        }
+    }
+#endif /* CAT_COROUTINE_MEMORY_PROTECT_SUPPORT */
+
+    return virtual_memory;
+}
+
+static void cat_coroutine_stack_free(void *virtual_memory, size_t virtual_memory_size)
+{
+#if defined(CAT_COROUTINE_MEMORY_PROTECT_SUPPORT) && defined(CAT_COROUTINE_USE_SYS_MALLOC)
+    if (cat_coroutine_use_memory_protect) {
+        void *page = cat_getpageafter(virtual_memory);
+        cat_bool_t ret;
+# ifndef CAT_OS_WIN
+        ret = mprotect(page, cat_getpagesize(), PROT_READ | PROT_WRITE) == 0;
+# else
+        DWORD old_protect;
+        ret = VirtualProtect(page, cat_getpagesize(), PAGE_READWRITE, &old_protect) != 0;
+# endif
+        CAT_LOG_DEBUG_V2(COROUTINE, "Unprotect stack page at %p with %zu bytes %s", page, cat_getpagesize(), ret ? "successfully" : "failed");
+        if (unlikely(!ret)) {
+            CAT_SYSCALL_FAILURE(NOTICE, COROUTINE, "Unprotect stack page failed");
+        }
+    }
+#endif
+#if defined(CAT_COROUTINE_USE_MMAP)
+    munmap(virtual_memory, virtual_memory_size);
+#elif defined(CAT_COROUTINE_USE_VIRTUAL_ALLOC)
+    VirtualFree(virtual_memory, 0, MEM_RELEASE);
+#elif defined(CAT_COROUTINE_USE_SYS_MALLOC)
+    (void) virtual_memory_size;
+    cat_sys_free(virtual_memory);
+#endif
+}
+
+/* stack pool */
+
+/* Pooled Stack Virtual Memory
+ * - the pool node is stored on the top page of the stack,
+ *   it will be overwritten by the next owner of the stack
+ * - only [stack, top page) will be trimmed, so the node is always available,
+ *   and guard page (if any) is kept in place during reuse
+ + - - - - +----------------------------------+-----------+
+ : PADDING :              STACK               : TOP PAGE  :
+ + - - - - +----------------------------------+-----------+
+ *                                                   node ^ */
+typedef struct cat_coroutine_stack_node_s {
+    cat_queue_node_t node;
+    cat_bool_t trimmed;
+} cat_coroutine_stack_node_t;
+
+#ifdef CAT_COROUTINE_USE_MMAP
+# if defined(MADV_FREE)
+static int cat_coroutine_stack_trim_advice = MADV_FREE;
+# elif defined(MADV_DONTNEED)
+static int cat_coroutine_stack_trim_advice = MADV_DONTNEED;
+# endif
+#endif
+
+static cat_always_inline cat_coroutine_stack_node_t *cat_coroutine_stack_node(void *virtual_memory, size_t virtual_memory_size)
+{
+    return (cat_coroutine_stack_node_t *) (((char *) virtual_memory) + virtual_memory_size - sizeof(cat_coroutine_stack_node_t));
+}
+
+static cat_always_inline void *cat_coroutine_stack_node_get_virtual_memory(cat_coroutine_stack_node_t *node, size_t virtual_memory_size)
+{
+    return ((char *) node) + sizeof(*node) - virtual_memory_size;
+}
+
+static cat_always_inline size_t cat_coroutine_stack_pool_class_size(size_t index)
+{
+    return CAT_COROUTINE_MIN_STACK_SIZE << index;
+}
+
+static cat_always_inline size_t cat_coroutine_stack_pool_get_virtual_memory_size(size_t index)
+{
+    return cat_getpagesize() * CAT_COROUTINE_STACK_PADDING_PAGE_COUNT + cat_coroutine_stack_pool_class_size(index);
+}
+
+/* return the class index of the stack, or -1 if it can not be pooled */
+static int cat_coroutine_stack_pool_get_class(size_t stack_size)
+{
+    int index;
+
+    for (index = 0; index < CAT_COROUTINE_STACK_POOL_CLASS_COUNT; index++) {
+        if (cat_coroutine_stack_pool_class_size(index) == stack_size) {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+static size_t cat_coroutine_stack_pool_align_stack_size(size_t stack_size)
+{
+    size_t class_size = CAT_COROUTINE_MIN_STACK_SIZE;
+
+    while (class_size < stack_size) {
+        class_size <<= 1;
+    }
+
+    return class_size;
+}
+
+static void cat_coroutine_stack_trim(void *virtual_memory, size_t virtual_memory_size)
+{
+#if defined(CAT_COROUTINE_USE_MMAP) && (defined(MADV_FREE) || defined(MADV_DONTNEED))
+    size_t page_size = cat_getpagesize();
+    size_t padding_size = page_size * CAT_COROUTINE_STACK_PADDING_PAGE_COUNT;
+    void *stack = ((char *) virtual_memory) + padding_size;
+    size_t length = virtual_memory_size - padding_size - page_size;
+    int ret;
+
+    ret = madvise(stack, length, cat_coroutine_stack_trim_advice);
+# if defined(MADV_FREE) && defined(MADV_DONTNEED)
+    if (unlikely(ret != 0 && errno == EINVAL && cat_coroutine_stack_trim_advice == MADV_FREE)) {
+        /* MADV_FREE is not supported by kernel (< 4.5), fallback to MADV_DONTNEED */
+        cat_coroutine_stack_trim_advice = MADV_DONTNEED;
+        ret = madvise(stack, length, cat_coroutine_stack_trim_advice);
+    }
+# endif
+    CAT_LOG_DEBUG_V2(COROUTINE, "Trim stack at %p with %zu bytes %s", stack, length, ret == 0 ? "successfully" : "failed");
+    if (unlikely(ret != 0)) {
+        CAT_SYSCALL_FAILURE(NOTICE, COROUTINE, "Trim stack failed");
+    }
+#else
+    (void) virtual_memory;
+    (void) virtual_memory_size;
+#endif
+}
+
+static void *cat_coroutine_stack_pool_acquire(size_t stack_size, size_t virtual_memory_size)
+{
+    cat_coroutine_stack_pool_t *pool = &CAT_COROUTINE_G(stack_pool);
+    cat_coroutine_stack_node_t *node;
+    int index;
+
+    if (pool->max_size == 0) {
+        return cat_coroutine_stack_alloc(virtual_memory_size);
+    }
+    index = cat_coroutine_stack_pool_get_class(stack_size);
+    CAT_ASSERT(index >= 0 && "Stack size should have been aligned to the size class");
+    node = cat_queue_front_data(&pool->stacks[index], cat_coroutine_stack_node_t, node);
+    if (node == NULL) {
+        pool->misses++;
+        return cat_coroutine_stack_alloc(virtual_memory_size);
+    }
+    cat_queue_remove(&node->node);
+    pool->count--;
+    if (!node->trimmed) {
+        pool->hot_count--;
+    }
+    pool->hits++;
+
+    return cat_coroutine_stack_node_get_virtual_memory(node, virtual_memory_size);
+}
+
+static void cat_coroutine_stack_pool_release(void *virtual_memory, size_t virtual_memory_size, size_t stack_size)
+{
+    cat_coroutine_stack_pool_t *pool = &CAT_COROUTINE_G(stack_pool);
+    cat_coroutine_stack_node_t *node;
+    int index;
+
+    if (pool->count >= pool->max_size) {
+        goto _free;
+    }
+    index = cat_coroutine_stack_pool_get_class(stack_size);
+    if (unlikely(index < 0)) {
+        /* created when stack pool was disabled */
+        goto _free;
+    }
+    node = cat_coroutine_stack_node(virtual_memory, virtual_memory_size);
+    if (pool->hot_count < pool->hot_size) {
+        node->trimmed = cat_false;
+        cat_queue_push_front(&pool->stacks[index], &node->node);
+        pool->hot_count++;
+    } else {
+        cat_coroutine_stack_trim(virtual_memory, virtual_memory_size);
+        node->trimmed = cat_true;
+        cat_queue_push_back(&pool->stacks[index], &node->node);
+    }
+    pool->count++;
+
+    return;
+
+    _free:
+    cat_coroutine_stack_free(virtual_memory, virtual_memory_size);
+}
+
+static void cat_coroutine_stack_pool_shrink(size_t size)
+{
+    cat_coroutine_stack_pool_t *pool = &CAT_COROUTINE_G(stack_pool);
+    int index;
+
+    /* release cold (trimmed) and big stacks first */
+    for (index = CAT_COROUTINE_STACK_POOL_CLASS_COUNT - 1; index >= 0 && pool->count > size; index--) {
+        size_t virtual_memory_size = cat_coroutine_stack_pool_get_virtual_memory_size(index);
+        cat_coroutine_stack_node_t *node;
+        while (pool->count > size &&
+            (node = cat_queue_back_data(&pool->stacks[index], cat_coroutine_stack_node_t, node)) != NULL) {
+            cat_queue_remove(&node->node);
+            pool->count--;
+            if (!node->trimmed) {
+                pool->hot_count--;
+            }
+            cat_coroutine_stack_free(cat_coroutine_stack_node_get_virtual_memory(node, virtual_memory_size), virtual_memory_size);
+        }
+    }
+}
+#endif /* CAT_COROUTINE_USE_USER_STACK */
+
 CAT_API CAT_GLOBALS_DECLARE(cat_coroutine);
 
 CAT_API cat_bool_t cat_coroutine_module_init(void)
@@ -197,10 +446,13 @@ CAT_API cat_bool_t cat_coroutine_runtime_init(void)
         main_coroutine->end_time = 0;
         main_coroutine->flags = CAT_COROUTINE_FLAG_NONE;
         main_coroutine->state = CAT_COROUTINE_STATE_RUNNING;
+        main_coroutine->priority = CAT_COROUTINE_PRIORITY_NORMAL;
         main_coroutine->switches = 0;
         main_coroutine->from = NULL;
         main_coroutine->previous = NULL;
         main_coroutine->next = NULL;
+        main_coroutine->watchdog_quantum = 0;
+        main_coroutine->watchdog_threshold = 0;
         main_coroutine->stack_size = 0;
         main_coroutine->function = NULL;
 #ifdef CAT_COROUTINE_USE_USER_STACK
@@ -232,11 +484,58 @@ CAT_API cat_bool_t cat_coroutine_runtime_init(void)
         CAT_COROUTINE_G(peak_count)++;
     } while (0);
 
+    /* watchdog */
+    cat_atomic_int64_init(&CAT_COROUTINE_G(watchdog_quantum), 0);
+    cat_atomic_int64_init(&CAT_COROUTINE_G(watchdog_threshold), 0);
+    cat_atomic_int64_init(&CAT_COROUTINE_G(watchdog_finest_quantum), 0);
+
     /* scheduler */
     CAT_COROUTINE_G(scheduler) = NULL;
     cat_queue_init(&CAT_COROUTINE_G(waiters));
     CAT_COROUTINE_G(waiter_count) = 0;
 
+    /* ready queue */
+    do {
+        cat_coroutine_ready_queue_t *queue = &CAT_COROUTINE_G(ready_queue);
+        int index;
+        for (index = 0; index < CAT_COROUTINE_PRIORITY_COUNT; index++) {
+            cat_queue_init(&queue->queues[index]);
+        }
+        queue->count = 0;
+        queue->enabled = cat_env_is_true("CAT_COROUTINE_READY_QUEUE", cat_false);
+        queue->budget_count = (size_t) cat_env_get_i("CAT_COROUTINE_READY_QUEUE_BUDGET_COUNT", 0);
+        queue->budget_time = (cat_usec_t) cat_env_get_i("CAT_COROUTINE_READY_QUEUE_BUDGET_TIME", 0);
+        queue->ready = NULL;
+        queue->peak_count = 0;
+        queue->rounds = 0;
+        queue->exhausted_rounds = 0;
+        queue->resumes = 0;
+    } while (0);
+
+#ifdef CAT_COROUTINE_USE_USER_STACK
+    /* stack pool */
+    do {
+        cat_coroutine_stack_pool_t *pool = &CAT_COROUTINE_G(stack_pool);
+        size_t default_size;
+        int index;
+        for (index = 0; index < CAT_COROUTINE_STACK_POOL_CLASS_COUNT; index++) {
+            cat_queue_init(&pool->stacks[index]);
+        }
+#ifndef CAT_COROUTINE_USE_ASAN
+        default_size = CAT_COROUTINE_STACK_POOL_DEFAULT_SIZE;
+#else
+        /* dead coroutines leave poisoned frames on their stacks */
+        default_size = 0;
+#endif
+        pool->max_size = (size_t) cat_env_get_i("CAT_COROUTINE_STACK_POOL_SIZE", (int) default_size);
+        pool->hot_size = (size_t) cat_env_get_i("CAT_COROUTINE_STACK_POOL_HOT_SIZE", CAT_COROUTINE_STACK_POOL_DEFAULT_HOT_SIZE);
+        pool->count = 0;
+        pool->hot_count = 0;
+        pool->hits = 0;
+        pool->misses = 0;
+    } while (0);
+#endif
+
     return cat_true;
 }
 
@@ -248,8 +547,15 @@ CAT_API cat_bool_t cat_coroutine_runtime_shutdown(void)
     CAT_ASSERT(cat_queue_empty(&CAT_COROUTINE_G(waiters)) && CAT_COROUTINE_G(waiter_count) == 0 &&
         "Coroutine waiter should be empty");
     CAT_ASSERT(cat_coroutine_get_scheduler() == NULL && "Coroutine scheduler should have been stopped");
+    CAT_ASSERT(CAT_COROUTINE_G(ready_queue).count == 0 && "Coroutine ready queue should be empty");
     CAT_ASSERT(CAT_COROUTINE_G(count) == 1 && "Coroutine count should be 1");
 
+#ifdef CAT_COROUTINE_USE_USER_STACK
+    /* coroutines may still be freed after runtime shutdown (e.g. GC), disable stack pool for them */
+    cat_coroutine_stack_pool_clear();
+    CAT_COROUTINE_G(stack_pool).max_size = 0;
+#endif
+
     return cat_true;
 }
 
@@ -281,6 +587,53 @@ CAT_API cat_coroutine_msec_time_function_t cat_coroutine_set_msec_time_function(
     return original_function;
 }
 
+CAT_API size_t cat_coroutine_set_stack_pool_size(size_t size)
+{
+#ifdef CAT_COROUTINE_USE_USER_STACK
+    size_t original_size = CAT_COROUTINE_G(stack_pool).max_size;
+    CAT_COROUTINE_G(stack_pool).max_size = size;
+    cat_coroutine_stack_pool_shrink(size);
+    return original_size;
+#else
+    (void) size;
+    return 0;
+#endif
+}
+
+CAT_API size_t cat_coroutine_set_stack_pool_hot_size(size_t size)
+{
+#ifdef CAT_COROUTINE_USE_USER_STACK
+    size_t original_size = CAT_COROUTINE_G(stack_pool).hot_size;
+    CAT_COROUTINE_G(stack_pool).hot_size = size;
+    return original_size;
+#else
+    (void) size;
+    return 0;
+#endif
+}
+
+CAT_API cat_bool_t cat_coroutine_set_ready_queue_enabled(cat_bool_t enabled)
+{
+    cat_bool_t original_enabled = CAT_COROUTINE_G(ready_queue).enabled;
+    /* coroutines which have been queued will still be resumed by scheduler */
+    CAT_COROUTINE_G(ready_queue).enabled = enabled;
+    return original_enabled;
+}
+
+CAT_API size_t cat_coroutine_set_ready_queue_budget_count(size_t count)
+{
+    size_t original_count = CAT_COROUTINE_G(ready_queue).budget_count;
+    CAT_COROUTINE_G(ready_queue).budget_count = count;
+    return original_count;
+}
+
+CAT_API cat_usec_t cat_coroutine_set_ready_queue_budget_time(cat_usec_t time)
+{
+    cat_usec_t original_time = CAT_COROUTINE_G(ready_queue).budget_time;
+    CAT_COROUTINE_G(ready_queue).budget_time = time;
+    return original_time;
+}
+
 CAT_API cat_coroutine_jump_t cat_coroutine_register_jump(cat_coroutine_jump_t jump)
 {
     cat_coroutine_jump_t original_jump = cat_coroutine_jump;
@@ -386,6 +739,41 @@ CAT_API cat_coroutine_switches_t cat_coroutine_get_global_switches(void)
     return CAT_COROUTINE_G(switches);
 }
 
+CAT_API void cat_coroutine_get_stack_pool_stats(cat_coroutine_stack_pool_stats_t *stats)
+{
+#ifdef CAT_COROUTINE_USE_USER_STACK
+    const cat_coroutine_stack_pool_t *pool = &CAT_COROUTINE_G(stack_pool);
+    stats->max_size = pool->max_size;
+    stats->hot_size = pool->hot_size;
+    stats->count = pool->count;
+    stats->hot_count = pool->hot_count;
+    stats->hits = pool->hits;
+    stats->misses = pool->misses;
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+CAT_API void cat_coroutine_stack_pool_clear(void)
+{
+#ifdef CAT_COROUTINE_USE_USER_STACK
+    cat_coroutine_stack_pool_shrink(0);
+#endif
+}
+
+CAT_API void cat_coroutine_get_ready_queue_stats(cat_coroutine_ready_queue_stats_t *stats)
+{
+    const cat_coroutine_ready_queue_t *queue = &CAT_COROUTINE_G(ready_queue);
+    stats->enabled = queue->enabled;
+    stats->budget_count = queue->budget_count;
+    stats->budget_time = queue->budget_time;
+    stats->count = queue->count;
+    stats->peak_count = queue->peak_count;
+    stats->rounds = queue->rounds;
+    stats->exhausted_rounds = queue->exhausted_rounds;
+    stats->resumes = queue->resumes;
+}
+
 static void cat_coroutine_context_function(cat_coroutine_transfer_t transfer)
 {
     cat_coroutine_t *coroutine;
@@ -472,6 +860,11 @@ CAT_API cat_coroutine_t *cat_coroutine_create_ex(cat_coroutine_t *coroutine, cat
 
     /* align stack size and add padding */
     stack_size = cat_coroutine_align_stack_size(stack_size);
+#ifdef CAT_COROUTINE_USE_USER_STACK
+    if (CAT_COROUTINE_G(stack_pool).max_size > 0) {
+        stack_size = cat_coroutine_stack_pool_align_stack_size(stack_size);
+    }
+#endif
 
 #ifdef CAT_COROUTINE_USE_THREAD_CONTEXT
     int error = uv_sem_init(&coroutine->sem, 0);
@@ -508,16 +901,9 @@ CAT_API cat_coroutine_t *cat_coroutine_create_ex(cat_coroutine_t *coroutine, cat
     *       stack                                         stack_start
     */
     virtual_memory_size = padding_size + stack_size;
-    /* alloc memory */
-#if defined(CAT_COROUTINE_USE_MMAP)
-    virtual_memory = mmap(NULL, virtual_memory_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
-#elif defined(CAT_COROUTINE_USE_VIRTUAL_ALLOC)
-    virtual_memory = VirtualAlloc(0, virtual_memory_size, MEM_COMMIT, PAGE_READWRITE);
-#else // if defined(CAT_COROUTINE_USE_SYS_MALLOC)
-    virtual_memory = cat_sys_malloc_recoverable(virtual_memory_size);
-#endif
-    if (unlikely(virtual_memory == CAT_COROUTINE_MEMORY_INVALID)) {
-        cat_update_last_error_of_syscall("Allocate virtual memory for coroutine stack failed with size %zu", virtual_memory_size);
+    /* alloc memory (or reuse it from stack pool) */
+    virtual_memory = cat_coroutine_stack_pool_acquire(stack_size, virtual_memory_size);
+    if (unlikely(virtual_memory == NULL)) {
         if (flags & CAT_COROUTINE_FLAG_ALLOCATED) {
             cat_free(coroutine);
         }
@@ -525,29 +911,6 @@ CAT_API cat_coroutine_t *cat_coroutine_create_ex(cat_coroutine_t *coroutine, cat
     }
     stack = ((char *) virtual_memory) + padding_size;
     stack_start = ((char *) stack) + stack_size;
-
-#ifdef CAT_COROUTINE_MEMORY_PROTECT_SUPPORT
-    /* protect a page of memory after the stack top
-     * to notify stack overflow */
-    if (cat_coroutine_use_memory_protect) {
-        void *page = virtual_memory;
-        cat_bool_t ret;
-# ifdef CAT_COROUTINE_USE_SYS_MALLOC
-        /* mallocated memory is not aligned with the page */
-        page = cat_getpageafter(page);
-# endif
-# ifndef CAT_OS_WIN
-        ret = mprotect(page, cat_getpagesize(), PROT_NONE) == 0;
-# else
-        DWORD old_protect;
-        ret = VirtualProtect(page, cat_getpagesize(), PAGE_NOACCESS /* PAGE_READWRITE | PAGE_GUARD */, &old_protect) != 0;
-# endif
-        CAT_LOG_DEBUG_V2(COROUTINE, "Protect stack page at %p with %zu bytes %s", page, cat_getpagesize(), ret ? "successfully" : "failed");
-        if (unlikely(!ret)) {
-            CAT_SYSCALL_FAILURE(NOTICE, COROUTINE, "Protect stack page failed");
-        }
-    }
-#endif /* CAT_COROUTINE_MEMORY_PROTECT_SUPPORT */
 #endif /* CAT_COROUTINE_USE_USER_STACK */
 
     /* make context */
@@ -565,10 +928,13 @@ CAT_API cat_coroutine_t *cat_coroutine_create_ex(cat_coroutine_t *coroutine, cat
     coroutine->id = CAT_COROUTINE_G(last_id)++;
     coroutine->flags = flags | CAT_COROUTINE_FLAG_ACCEPT_DATA;
     coroutine->state = CAT_COROUTINE_STATE_WAITING;
+    coroutine->priority = CAT_COROUTINE_PRIORITY_NORMAL;
     coroutine->switches = 0;
     coroutine->from = NULL;
     coroutine->previous = NULL;
     coroutine->next = NULL;
+    coroutine->watchdog_quantum = 0;
+    coroutine->watchdog_threshold = 0;
     coroutine->start_time = 0;
     coroutine->end_time = 0;
     coroutine->stack_size = (cat_coroutine_stack_size_t) stack_size;
@@ -608,6 +974,7 @@ CAT_API void cat_coroutine_free(cat_coroutine_t *coroutine)
 {
     CAT_LOG_DEBUG(COROUTINE, "coroutine_close(id: " CAT_COROUTINE_ID_FMT ")", coroutine->id);
     CAT_ASSERT(!cat_coroutine_is_alive(coroutine) && "Coroutine can not be forced to close when it is running or waiting");
+    CAT_ASSERT(!(coroutine->flags & CAT_COROUTINE_FLAG_READY) && "Coroutine can not be closed when it is in ready queue");
 #ifdef CAT_COROUTINE_USE_THREAD_CONTEXT
     if (coroutine->start_time == 0) {
         coroutine->state = CAT_COROUTINE_STATE_DEAD;
@@ -618,28 +985,8 @@ CAT_API void cat_coroutine_free(cat_coroutine_t *coroutine)
 #ifdef CAT_HAVE_VALGRIND
     VALGRIND_STACK_DEREGISTER(coroutine->valgrind_stack_id);
 #endif
-#if defined(CAT_COROUTINE_MEMORY_PROTECT_SUPPORT) && defined(CAT_COROUTINE_USE_SYS_MALLOC)
-    if (cat_coroutine_use_memory_protect) {
-        void *page = cat_getpageafter(coroutine->virtual_memory);
-        cat_bool_t ret;
-# ifndef CAT_OS_WIN
-        ret = mprotect(page, cat_getpagesize(), PROT_READ | PROT_WRITE) == 0;
-# else
-        DWORD old_protect;
-        ret = VirtualProtect(page, cat_getpagesize(), PAGE_READWRITE, &old_protect) != 0;
-# endif
-        CAT_LOG_DEBUG_V2(COROUTINE, "Unprotect stack page at %p with %zu bytes %s", page, cat_getpagesize(), ret ? "successfully" : "failed");
-        if (unlikely(!ret)) {
-            CAT_SYSCALL_FAILURE(NOTICE, COROUTINE, "Unprotect stack page failed");
-        }
-    }
-#endif
-#if defined(CAT_COROUTINE_USE_MMAP)
-    munmap(coroutine->virtual_memory, coroutine->virtual_memory_size);
-#elif defined(CAT_COROUTINE_USE_VIRTUAL_ALLOC)
-    VirtualFree(coroutine->virtual_memory, 0, MEM_RELEASE);
-#elif defined(CAT_COROUTINE_USE_SYS_MALLOC)
-    cat_sys_free(coroutine->virtual_memory);
+#ifdef CAT_COROUTINE_USE_USER_STACK
+    cat_coroutine_stack_pool_release(coroutine->virtual_memory, coroutine->virtual_memory_size, coroutine->stack_size);
 #endif
     if (coroutine->flags & CAT_COROUTINE_FLAG_ALLOCATED) {
         cat_free(coroutine);
@@ -674,6 +1021,13 @@ CAT_API void cat_coroutine_jump_standard(cat_coroutine_t *coroutine, cat_data_t
     current_coroutine->switches++;
     /* swap ptr */
     CAT_COROUTINE_G(current) = coroutine;
+    /* publish watchdog options (globals always hold the ones of current) */
+    if (unlikely(coroutine->watchdog_quantum != current_coroutine->watchdog_quantum)) {
+        cat_atomic_int64_store(&CAT_COROUTINE_G(watchdog_quantum), coroutine->watchdog_quantum);
+    }
+    if (unlikely(coroutine->watchdog_threshold != current_coroutine->watchdog_threshold)) {
+        cat_atomic_int64_store(&CAT_COROUTINE_G(watchdog_threshold), coroutine->watchdog_threshold);
+    }
     /* update from */
     coroutine->from = current_coroutine;
     /* update current coroutine state */
@@ -775,12 +1129,23 @@ static cat_always_inline cat_bool_t cat_coroutine_check_resumability(const cat_c
         } \
     });
 
+static cat_always_inline void cat_coroutine_ready_queue_remove(cat_coroutine_t *coroutine)
+{
+    coroutine->flags ^= CAT_COROUTINE_FLAG_READY;
+    cat_queue_remove(&coroutine->ready_node);
+    CAT_COROUTINE_G(ready_queue).count--;
+}
+
 CAT_API cat_bool_t cat_coroutine_resume(cat_coroutine_t *coroutine, cat_data_t *data, cat_data_t **retval)
 {
     CAT_COROUTINE_SWITCH_PRECHECK(return cat_false);
     if (unlikely(!cat_coroutine_check_resumability(coroutine))) {
         return cat_false;
     }
+    /* it was resumed by others before scheduler got to it */
+    if (unlikely(coroutine->flags & CAT_COROUTINE_FLAG_READY)) {
+        cat_coroutine_ready_queue_remove(coroutine);
+    }
 
     CAT_COROUTINE_SWITCH_LOG(resume, coroutine);
 
@@ -937,6 +1302,41 @@ CAT_API const char *cat_coroutine_state_name(cat_coroutine_state_t state)
     CAT_NEVER_HERE("Unknown state");
 }
 
+CAT_API const char *cat_coroutine_priority_name(cat_coroutine_priority_t priority)
+{
+    switch (priority) {
+#define CAT_COROUTINE_PRIORITY_NAME_GEN(name, unused, value) case CAT_COROUTINE_PRIORITY_##name: return value;
+    CAT_COROUTINE_PRIORITY_MAP(CAT_COROUTINE_PRIORITY_NAME_GEN)
+#undef CAT_COROUTINE_PRIORITY_NAME_GEN
+    }
+    return "unknown";
+}
+
+CAT_API cat_coroutine_priority_t cat_coroutine_get_priority(const cat_coroutine_t *coroutine)
+{
+    return coroutine->priority;
+}
+
+CAT_API cat_bool_t cat_coroutine_set_priority(cat_coroutine_t *coroutine, cat_coroutine_priority_t priority)
+{
+    if (unlikely((unsigned int) priority >= CAT_COROUTINE_PRIORITY_COUNT)) {
+        cat_update_last_error(CAT_EINVAL, "Coroutine priority %d is invalid", (int) priority);
+        return cat_false;
+    }
+    if (coroutine->flags & CAT_COROUTINE_FLAG_READY && coroutine->priority != priority) {
+        cat_queue_remove(&coroutine->ready_node);
+        cat_queue_push_back(&CAT_COROUTINE_G(ready_queue).queues[priority], &coroutine->ready_node);
+    }
+    coroutine->priority = priority;
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_coroutine_is_ready(const cat_coroutine_t *coroutine)
+{
+    return !!(coroutine->flags & CAT_COROUTINE_FLAG_READY);
+}
+
 CAT_API cat_coroutine_state_t cat_coroutine_get_state(const cat_coroutine_t *coroutine)
 {
     return coroutine->state;
@@ -1005,6 +1405,7 @@ static cat_data_t *cat_coroutine_scheduler_function(cat_data_t *data)
     cat_coroutine_scheduler_t scheduler = *((cat_coroutine_scheduler_t *) data);
 
     CAT_COROUTINE_G(scheduler) = coroutine;
+    CAT_COROUTINE_G(ready_queue).ready = scheduler.ready;
     CAT_COROUTINE_G(count)--;
 
     cat_coroutine_yield(NULL, NULL);
@@ -1031,7 +1432,9 @@ static cat_data_t *cat_coroutine_scheduler_function(cat_data_t *data)
         cat_coroutine_notify_all();
     }
 
+    CAT_ASSERT(CAT_COROUTINE_G(ready_queue).count == 0);
     CAT_COROUTINE_G(count)++;
+    CAT_COROUTINE_G(ready_queue).ready = NULL;
     CAT_COROUTINE_G(scheduler) = NULL;
 
     return NULL;
@@ -1088,6 +1491,78 @@ CAT_API cat_coroutine_t *cat_coroutine_scheduler_close(void)
     return coroutine;
 }
 
+CAT_API cat_bool_t cat_coroutine_ready(cat_coroutine_t *coroutine)
+{
+    cat_coroutine_ready_queue_t *queue = &CAT_COROUTINE_G(ready_queue);
+
+    if (unlikely(!cat_coroutine_check_resumability(coroutine))) {
+        return cat_false;
+    }
+    if (coroutine->flags & CAT_COROUTINE_FLAG_READY) {
+        /* it has been woken up by others in this round, wake up it only once */
+        return cat_true;
+    }
+
+    coroutine->flags |= CAT_COROUTINE_FLAG_READY;
+    cat_queue_push_back(&queue->queues[coroutine->priority], &coroutine->ready_node);
+    if (queue->count++ == 0) {
+        queue->ready();
+    }
+    if (unlikely(queue->count > queue->peak_count)) {
+        queue->peak_count = queue->count;
+    }
+
+    return cat_true;
+}
+
+static cat_always_inline cat_coroutine_t *cat_coroutine_ready_queue_front(cat_coroutine_ready_queue_t *queue)
+{
+    int index;
+
+    for (index = CAT_COROUTINE_PRIORITY_COUNT - 1; index >= 0; index--) {
+        cat_coroutine_t *coroutine = cat_queue_front_data(&queue->queues[index], cat_coroutine_t, ready_node);
+        if (coroutine != NULL) {
+            return coroutine;
+        }
+    }
+
+    return NULL;
+}
+
+CAT_API size_t cat_coroutine_ready_queue_run(void)
+{
+    cat_coroutine_ready_queue_t *queue = &CAT_COROUTINE_G(ready_queue);
+    cat_coroutine_t *coroutine;
+    cat_nsec_t deadline = 0;
+    size_t budget_count, n = 0;
+
+    if (queue->count == 0) {
+        return 0;
+    }
+    queue->rounds++;
+    /* the rest of coroutines will wait for the next round if budget is exhausted,
+     * so that new IO events and coroutines of higher priority have a chance to run */
+    budget_count = queue->budget_count;
+    if (queue->budget_time > 0) {
+        deadline = cat_time_nsec() + queue->budget_time * 1000;
+    }
+    while ((coroutine = cat_coroutine_ready_queue_front(queue)) != NULL) {
+        if (unlikely(
+            (budget_count > 0 && n == budget_count) ||
+            (deadline > 0 && n > 0 && cat_time_nsec() >= deadline)
+        )) {
+            queue->exhausted_rounds++;
+            break;
+        }
+        cat_coroutine_ready_queue_remove(coroutine);
+        n++;
+        cat_coroutine_schedule(coroutine, COROUTINE, "Ready queue");
+    }
+    queue->resumes += n;
+
+    return queue->count;
+}
+
 CAT_API cat_bool_t cat_coroutine_wait_all(void)
 {
     return cat_coroutine_wait_all_ex(CAT_TIMEOUT_FOREVER);
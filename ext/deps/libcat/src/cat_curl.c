@@ -21,6 +21,7 @@
 #ifdef CAT_CURL
 
 #include "cat_coroutine.h"
+#include "cat_env.h"
 #include "cat_event.h"
 #include "cat_poll.h"
 #include "cat_queue.h"
@@ -65,10 +66,97 @@ RB_GENERATE_STATIC(cat_curl_multi_context_tree_s,
                    cat_curl_multi_context_s, tree_entry,
                    cat_curl__multi_context_compare);
 
+/* a callback which is handed over from driver to the owner of transfer */
+typedef struct cat_curl_call_s {
+    cat_data_callback_t function;
+    cat_data_t *data;
+    /* driver which is waiting for the call if the function yielded */
+    cat_coroutine_t *waiter;
+    cat_bool_t done;
+} cat_curl_call_t;
+
+typedef struct cat_curl_transfer_s {
+    RB_ENTRY(cat_curl_transfer_s) tree_entry;
+    CURL *ch;
+    /* the coroutine which is performing the transfer */
+    cat_coroutine_t *owner;
+    /* the coroutine which is waiting for the transfer */
+    cat_coroutine_t *coroutine;
+    cat_queue_node_t node;
+    cat_curl_call_t *call;
+    cat_bool_t woken;
+    cat_bool_t canceled;
+    CURLcode code;
+    cat_bool_t done;
+} cat_curl_transfer_t;
+
+RB_HEAD(cat_curl_transfer_tree_s, cat_curl_transfer_s);
+
+static int cat_curl__transfer_compare(cat_curl_transfer_t* t1, cat_curl_transfer_t* t2)
+{
+    uintptr_t ch1 = (uintptr_t) t1->ch;
+    uintptr_t ch2 = (uintptr_t) t2->ch;
+    if (ch1 < ch2) {
+        return -1;
+    }
+    if (ch1 > ch2) {
+        return 1;
+    }
+    return 0;
+}
+
+RB_GENERATE_STATIC(cat_curl_transfer_tree_s,
+                   cat_curl_transfer_s, tree_entry,
+                   cat_curl__transfer_compare);
+
+typedef struct cat_curl_shared_socket_s {
+    uv_poll_t poll;
+    /* node in sockets */
+    cat_queue_node_t node;
+    /* node in ready sockets */
+    cat_queue_node_t ready_node;
+    curl_socket_t sockfd;
+    /* CURL_POLL_* which is wanted by cURL */
+    int action;
+    /* CURL_CSELECT_* which has not been reported to cURL yet */
+    int ready_action;
+    cat_bool_t ready;
+} cat_curl_shared_socket_t;
+
+/* the runtime multi handle which is shared by all easy handles,
+ * it is driven by event loop, and cURL actions are always called in one of
+ * the waiting coroutines (driver) instead of the scheduler,
+ * because cURL callbacks may call coroutine APIs */
+typedef struct cat_curl_shared_s {
+    CURLM *multi;
+    CURLSH *share;
+    uv_timer_t timer;
+    cat_queue_t sockets;
+    cat_queue_t ready_sockets;
+    size_t socket_count;
+    cat_bool_t timeout_pending;
+    cat_bool_t driving;
+    cat_coroutine_t *driver;
+    /* cURL APIs can not be called while someone is in cURL callbacks */
+    cat_bool_t in_action;
+    /* the coroutine which is calling callbacks of its transfer on behalf of driver */
+    cat_coroutine_t *delegate;
+    /* coroutines which are waiting for their transfers */
+    cat_queue_t waiters;
+    /* coroutines which are waiting for the end of cURL action */
+    cat_queue_t action_waiters;
+    struct cat_curl_transfer_tree_s transfers;
+    size_t transfer_count;
+} cat_curl_shared_t;
+
 /* globals */
 
 CAT_GLOBALS_STRUCT_BEGIN(cat_curl) {
     struct cat_curl_multi_context_tree_s multi_tree;
+    cat_curl_shared_t *shared;
+    cat_bool_t shared_enabled;
+    long max_host_connections;
+    long max_total_connections;
 } CAT_GLOBALS_STRUCT_END(cat_curl);
 
 CAT_GLOBALS_DECLARE(cat_curl);
@@ -152,7 +240,8 @@ static const char *cat_curl_action_name(int action)
 
 static CURLMcode cat_curl_multi_wait_impl(CURLM *multi, int timeout_ms, int *numfds, int *running_handles);
 
-static CURLcode cat_curl_easy_perform_impl(CURL *ch)
+/* perform on a temporary multi handle, it is used when runtime multi handle is disabled */
+static CURLcode cat_curl_easy_perform_isolated(CURL *ch)
 {
     CURLM *multi;
     CURLMsg *message = NULL;
@@ -187,7 +276,8 @@ static CURLcode cat_curl_easy_perform_impl(CURL *ch)
             break;
         }
         if (numfds == 0) {
-            // timedout or cancelled
+            /* no timeout was set, so it was canceled */
+            code = CURLE_ABORTED_BY_CALLBACK;
             goto _error;
         }
     }
@@ -212,17 +302,574 @@ static CURLcode cat_curl_easy_perform_impl(CURL *ch)
     return code;
 }
 
+/* shared multi */
+
+static void cat_curl_shared_poll_callback(uv_poll_t *poll, int status, int events);
+
+static void cat_curl_shared_wake_driver(cat_curl_shared_t *shared)
+{
+    cat_curl_transfer_t *transfer;
+
+    if (shared->driving) {
+        /* driver will handle it before it leaves */
+        return;
+    }
+    transfer = cat_queue_front_data(&shared->waiters, cat_curl_transfer_t, node);
+    if (transfer != NULL) {
+        transfer->woken = cat_true;
+        cat_coroutine_schedule(transfer->coroutine, CURL, "Multi driver");
+    }
+}
+
+static void cat_curl_shared_socket_watch(cat_curl_shared_socket_t *socket)
+{
+    int events = 0;
+
+    if (socket->ready) {
+        /* it will be watched again after cURL has handled it */
+        return;
+    }
+    if (socket->action == CURL_POLL_IN || socket->action == CURL_POLL_INOUT) {
+        events |= UV_READABLE;
+    }
+    if (socket->action == CURL_POLL_OUT || socket->action == CURL_POLL_INOUT) {
+        events |= UV_WRITABLE;
+    }
+    if (events == 0) {
+        (void) uv_poll_stop(&socket->poll);
+    } else {
+        (void) uv_poll_start(&socket->poll, events, cat_curl_shared_poll_callback);
+    }
+}
+
+static void cat_curl_shared_poll_callback(uv_poll_t *poll, int status, int events)
+{
+    cat_curl_shared_socket_t *socket = cat_container_of(poll, cat_curl_shared_socket_t, poll);
+    cat_curl_shared_t *shared = CAT_CURL_G(shared);
+    int action = CURL_CSELECT_NONE;
+
+    if (unlikely(status < 0)) {
+        action |= CURL_CSELECT_ERR;
+    } else {
+        if (events & (UV_READABLE | UV_DISCONNECT)) {
+            action |= CURL_CSELECT_IN;
+        }
+        if (events & UV_WRITABLE) {
+            action |= CURL_CSELECT_OUT;
+        }
+    }
+    /* stop watching until cURL has handled it, otherwise level-triggered events would spin */
+    (void) uv_poll_stop(poll);
+    socket->ready_action |= action;
+    if (!socket->ready) {
+        socket->ready = cat_true;
+        cat_queue_push_back(&shared->ready_sockets, &socket->ready_node);
+    }
+    cat_curl_shared_wake_driver(shared);
+}
+
+static void cat_curl_shared_socket_close_callback(uv_handle_t *handle)
+{
+    cat_curl_shared_socket_t *socket = cat_container_of(handle, cat_curl_shared_socket_t, poll);
+    cat_free(socket);
+}
+
+static void cat_curl_shared_socket_close(cat_curl_shared_t *shared, cat_curl_shared_socket_t *socket)
+{
+    cat_queue_remove(&socket->node);
+    if (socket->ready) {
+        cat_queue_remove(&socket->ready_node);
+    }
+    shared->socket_count--;
+    uv_close((uv_handle_t *) &socket->poll, cat_curl_shared_socket_close_callback);
+}
+
+static int cat_curl_shared_socket_function(
+    CURL *ch, curl_socket_t sockfd, int action,
+    cat_curl_shared_t *shared, cat_curl_shared_socket_t *socket)
+{
+    (void) ch;
+
+    CAT_LOG_DEBUG_V2(CURL, "libcurl::curl_multi_socket_function(shared, sockfd: %d, action=%s), sockets=%zu",
+        (int) sockfd, cat_curl_action_name(action), shared->socket_count);
+
+    if (action == CURL_POLL_REMOVE) {
+        if (socket != NULL) {
+            curl_multi_assign(shared->multi, sockfd, NULL);
+            cat_curl_shared_socket_close(shared, socket);
+        }
+        return 0;
+    }
+    if (socket == NULL) {
+        int error;
+        socket = (cat_curl_shared_socket_t *) cat_malloc(sizeof(*socket));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(socket == NULL)) {
+            return -1;
+        }
+#endif
+        error = uv_poll_init_socket(&CAT_EVENT_G(loop), &socket->poll, sockfd);
+        if (unlikely(error != 0)) {
+            CAT_LOG_DEBUG(CURL, "uv_poll_init_socket(sockfd: %d) failed, reason: %s", (int) sockfd, uv_strerror(error));
+            cat_free(socket);
+            return -1;
+        }
+        if (shared->transfer_count == 0) {
+            uv_unref((uv_handle_t *) &socket->poll);
+        }
+        socket->sockfd = sockfd;
+        socket->ready_action = CURL_CSELECT_NONE;
+        socket->ready = cat_false;
+        cat_queue_push_back(&shared->sockets, &socket->node);
+        shared->socket_count++;
+        curl_multi_assign(shared->multi, sockfd, socket);
+    }
+    socket->action = action;
+    cat_curl_shared_socket_watch(socket);
+
+    return 0;
+}
+
+static void cat_curl_shared_timer_callback(uv_timer_t *timer)
+{
+    cat_curl_shared_t *shared = cat_container_of(timer, cat_curl_shared_t, timer);
+
+    shared->timeout_pending = cat_true;
+    cat_curl_shared_wake_driver(shared);
+}
+
+static int cat_curl_shared_timer_function(CURLM *multi, long timeout, cat_curl_shared_t *shared)
+{
+    (void) multi;
+    CAT_LOG_DEBUG_V2(CURL, "libcurl::curl_multi_timeout_function(shared, timeout=%ld)", timeout);
+
+    if (timeout < 0) {
+        (void) uv_timer_stop(&shared->timer);
+    } else {
+        (void) uv_timer_start(&shared->timer, cat_curl_shared_timer_callback, (uint64_t) timeout, 0);
+    }
+
+    return 0;
+}
+
+/* handles should keep event loop alive only if someone is waiting for transfers,
+ * idle connections in cache should not */
+static void cat_curl_shared_set_active(cat_curl_shared_t *shared, cat_bool_t active)
+{
+    void (*update)(uv_handle_t *) = active ? uv_ref : uv_unref;
+
+    update((uv_handle_t *) &shared->timer);
+    CAT_QUEUE_FOREACH_DATA_START(&shared->sockets, cat_curl_shared_socket_t, node, socket) {
+        update((uv_handle_t *) &socket->poll);
+    } CAT_QUEUE_FOREACH_DATA_END();
+}
+
+static void cat_curl_shared_action(cat_curl_shared_t *shared, curl_socket_t sockfd, int action)
+{
+    cat_coroutine_t *waiter;
+    CURLMcode mcode;
+    int running_handles;
+
+    shared->in_action = cat_true;
+    mcode = curl_multi_socket_action(shared->multi, sockfd, action, &running_handles);
+    shared->in_action = cat_false;
+    CAT_LOG_DEBUG_V2(CURL, "libcurl::curl_multi_socket_action(shared, fd: %d, action: %d) = %d (%s), running_handles: %d",
+        (int) sockfd, action, mcode, curl_multi_strerror(mcode), running_handles);
+    (void) mcode;
+
+    /* let coroutines which are waiting for the end of cURL action continue */
+    while ((waiter = cat_queue_front_data(&shared->action_waiters, cat_coroutine_t, waiter.node))) {
+        cat_coroutine_schedule(waiter, CURL, "Multi action");
+    }
+}
+
+static void cat_curl_shared_read_info(cat_curl_shared_t *shared)
+{
+    CURLMsg *message;
+    int pending;
+
+    while ((message = curl_multi_info_read(shared->multi, &pending)) != NULL) {
+        cat_curl_transfer_t lookup, *transfer;
+        CURL *ch = message->easy_handle;
+        CURLcode code = message->data.result;
+        if (message->msg != CURLMSG_DONE) {
+            continue;
+        }
+        /* message is invalid after the handle has been removed */
+        (void) curl_multi_remove_handle(shared->multi, ch);
+        lookup.ch = ch;
+        transfer = RB_FIND(cat_curl_transfer_tree_s, &shared->transfers, &lookup);
+        if (unlikely(transfer == NULL)) {
+            continue;
+        }
+        transfer->code = code;
+        transfer->done = cat_true;
+        if (transfer->coroutine != NULL) {
+            transfer->woken = cat_true;
+            cat_coroutine_schedule(transfer->coroutine, CURL, "Multi transfer");
+        }
+    }
+}
+
+static void cat_curl_shared_drive(cat_curl_shared_t *shared)
+{
+    shared->driving = cat_true;
+    shared->driver = CAT_COROUTINE_G(current);
+    while (1) {
+        cat_curl_shared_socket_t *socket;
+        if (shared->timeout_pending) {
+            shared->timeout_pending = cat_false;
+            cat_curl_shared_action(shared, CURL_SOCKET_TIMEOUT, 0);
+        } else if ((socket = cat_queue_front_data(&shared->ready_sockets, cat_curl_shared_socket_t, ready_node)) != NULL) {
+            /* socket may be removed during the action */
+            curl_socket_t sockfd = socket->sockfd;
+            int action = socket->ready_action;
+            cat_queue_remove(&socket->ready_node);
+            socket->ready = cat_false;
+            socket->ready_action = CURL_CSELECT_NONE;
+            cat_curl_shared_socket_watch(socket);
+            cat_curl_shared_action(shared, sockfd, action);
+        } else {
+            break;
+        }
+        cat_curl_shared_read_info(shared);
+    }
+    shared->driving = cat_false;
+    shared->driver = NULL;
+}
+
+static cat_always_inline cat_bool_t cat_curl_shared_has_pending_work(const cat_curl_shared_t *shared)
+{
+    return shared->timeout_pending || !cat_queue_empty(&shared->ready_sockets);
+}
+
+static cat_always_inline cat_bool_t cat_curl_shared_in_callbacks(const cat_curl_shared_t *shared)
+{
+    cat_coroutine_t *current = CAT_COROUTINE_G(current);
+
+    return shared->in_action && (shared->driver == current || shared->delegate == current);
+}
+
+static void cat_curl_shared_transfer_call(cat_curl_shared_t *shared, cat_curl_transfer_t *transfer)
+{
+    cat_curl_call_t *call = transfer->call;
+
+    transfer->call = NULL;
+    shared->delegate = CAT_COROUTINE_G(current);
+    call->function(call->data);
+    shared->delegate = NULL;
+    call->done = cat_true;
+    if (call->waiter != NULL) {
+        /* function has yielded, driver is waiting for us */
+        cat_coroutine_schedule(call->waiter, CURL, "Multi callback done");
+    }
+}
+
+static cat_bool_t cat_curl_shared_wait_action(cat_curl_shared_t *shared)
+{
+    while (shared->in_action) {
+        cat_bool_t ret;
+        cat_queue_push_back(&shared->action_waiters, &CAT_COROUTINE_G(current)->waiter.node);
+        ret = cat_time_wait(-1);
+        cat_queue_remove(&CAT_COROUTINE_G(current)->waiter.node);
+        if (unlikely(!ret)) {
+            return cat_false;
+        }
+        if (unlikely(shared->in_action)) {
+            cat_update_last_error(CAT_ECANCELED, "Waiting for cURL action has been canceled");
+            return cat_false;
+        }
+    }
+
+    return cat_true;
+}
+
+static void cat_curl_shared_close(cat_data_t *data);
+
+static cat_curl_shared_t *cat_curl_shared_get(void)
+{
+    cat_curl_shared_t *shared = CAT_CURL_G(shared);
+
+    if (likely(shared != NULL)) {
+        return shared;
+    }
+    shared = (cat_curl_shared_t *) cat_malloc(sizeof(*shared));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(shared == NULL)) {
+        return NULL;
+    }
+#endif
+    shared->multi = curl_multi_init();
+    if (unlikely(shared->multi == NULL)) {
+        cat_free(shared);
+        return NULL;
+    }
+    /* connections are shared by multi handle itself */
+    shared->share = curl_share_init();
+    if (shared->share != NULL) {
+        (void) curl_share_setopt(shared->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        (void) curl_share_setopt(shared->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+    cat_curl_multi_configure(
+        shared->multi,
+        (void *) cat_curl_shared_socket_function,
+        (void *) cat_curl_shared_timer_function,
+        shared
+    );
+#ifdef CURLPIPE_MULTIPLEX
+    (void) curl_multi_setopt(shared->multi, CURLMOPT_PIPELINING, (long) CURLPIPE_MULTIPLEX);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x071e00 /* Available since 7.30.0 */
+    (void) curl_multi_setopt(shared->multi, CURLMOPT_MAX_HOST_CONNECTIONS, CAT_CURL_G(max_host_connections));
+    (void) curl_multi_setopt(shared->multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, CAT_CURL_G(max_total_connections));
+#endif
+    (void) uv_timer_init(&CAT_EVENT_G(loop), &shared->timer);
+    uv_unref((uv_handle_t *) &shared->timer);
+    cat_queue_init(&shared->sockets);
+    cat_queue_init(&shared->ready_sockets);
+    shared->socket_count = 0;
+    shared->timeout_pending = cat_false;
+    shared->driving = cat_false;
+    shared->driver = NULL;
+    shared->in_action = cat_false;
+    shared->delegate = NULL;
+    cat_queue_init(&shared->waiters);
+    cat_queue_init(&shared->action_waiters);
+    RB_INIT(&shared->transfers);
+    shared->transfer_count = 0;
+    if (unlikely(cat_event_register_runtime_shutdown_task(cat_curl_shared_close, NULL) == NULL)) {
+        CAT_LOG_DEBUG(CURL, "Register runtime shutdown task for multi failed");
+    }
+    CAT_CURL_G(shared) = shared;
+
+    return shared;
+}
+
+static void cat_curl_shared_timer_close_callback(uv_handle_t *handle)
+{
+    cat_curl_shared_t *shared = cat_container_of(handle, cat_curl_shared_t, timer);
+    cat_free(shared);
+}
+
+static void cat_curl_shared_close(cat_data_t *data)
+{
+    cat_curl_shared_t *shared = CAT_CURL_G(shared);
+    cat_curl_shared_socket_t *socket;
+    (void) data;
+
+    if (shared == NULL) {
+        return;
+    }
+    CAT_ASSERT(shared->transfer_count == 0);
+    /* sockets of cached connections would be removed in socket function */
+    (void) curl_multi_cleanup(shared->multi);
+    while ((socket = cat_queue_front_data(&shared->sockets, cat_curl_shared_socket_t, node))) {
+        cat_curl_shared_socket_close(shared, socket);
+    }
+    if (shared->share != NULL) {
+        (void) curl_share_cleanup(shared->share);
+    }
+    CAT_CURL_G(shared) = NULL;
+    uv_close((uv_handle_t *) &shared->timer, cat_curl_shared_timer_close_callback);
+}
+
+static CURLcode cat_curl_easy_perform_shared(cat_curl_shared_t *shared, CURL *ch, cat_curl_easy_perform_flags_t flags)
+{
+    cat_bool_t use_share = shared->share != NULL && !(flags & CAT_CURL_EASY_PERFORM_FLAG_NO_SHARE);
+    cat_curl_transfer_t transfer;
+    CURLMcode mcode;
+
+    if (unlikely(cat_curl_shared_in_callbacks(shared))) {
+        /* we are in cURL callbacks */
+        return cat_curl_easy_perform_isolated(ch);
+    }
+    if (unlikely(!cat_curl_shared_wait_action(shared))) {
+        return CURLE_ABORTED_BY_CALLBACK;
+    }
+    if (use_share) {
+        (void) curl_easy_setopt(ch, CURLOPT_SHARE, shared->share);
+    }
+    mcode = curl_multi_add_handle(shared->multi, ch);
+    if (unlikely(mcode != CURLM_OK)) {
+        if (use_share) {
+            (void) curl_easy_setopt(ch, CURLOPT_SHARE, NULL);
+        }
+#if LIBCURL_VERSION_NUM >= 0x072001 /* Available since 7.32.1 */
+        if (mcode == CURLM_ADDED_ALREADY) {
+            /* cURL is busy with IO,
+             * and can not find appropriate error code. */
+            return CURLE_AGAIN;
+        }
+#endif
+        return CURLE_RECV_ERROR;
+    }
+    transfer.ch = ch;
+    transfer.owner = CAT_COROUTINE_G(current);
+    transfer.coroutine = NULL;
+    transfer.call = NULL;
+    transfer.woken = cat_false;
+    transfer.canceled = cat_false;
+    transfer.code = CURLE_RECV_ERROR;
+    transfer.done = cat_false;
+    RB_INSERT(cat_curl_transfer_tree_s, &shared->transfers, &transfer);
+    if (shared->transfer_count++ == 0) {
+        cat_curl_shared_set_active(shared, cat_true);
+    }
+    /* kick it off without waiting for the next round of event loop */
+    shared->timeout_pending = cat_true;
+
+    while (!transfer.done) {
+        cat_bool_t ret;
+        if (transfer.call != NULL) {
+            cat_curl_shared_transfer_call(shared, &transfer);
+            continue;
+        }
+        if (!shared->driving && cat_curl_shared_has_pending_work(shared)) {
+            cat_curl_shared_drive(shared);
+            continue;
+        }
+        transfer.coroutine = CAT_COROUTINE_G(current);
+        transfer.woken = cat_false;
+        cat_queue_push_back(&shared->waiters, &transfer.node);
+        ret = cat_time_wait(-1);
+        cat_queue_remove(&transfer.node);
+        transfer.coroutine = NULL;
+        if (transfer.call != NULL) {
+            /* driver hands callbacks of our transfer over to us */
+            continue;
+        }
+        if (unlikely(!ret || !transfer.woken)) {
+            if (ret) {
+                cat_update_last_error(CAT_ECANCELED, "cURL transfer has been canceled");
+            }
+            transfer.code = CURLE_ABORTED_BY_CALLBACK;
+            transfer.canceled = cat_true;
+            break;
+        }
+    }
+
+    if (unlikely(!transfer.done)) {
+        /* easy handle must be removed before it is released,
+         * so we can not be canceled anymore */
+        while (!cat_curl_shared_wait_action(shared));
+        (void) curl_multi_remove_handle(shared->multi, ch);
+    }
+    RB_REMOVE(cat_curl_transfer_tree_s, &shared->transfers, &transfer);
+    if (--shared->transfer_count == 0) {
+        cat_curl_shared_set_active(shared, cat_false);
+    }
+    if (use_share) {
+        /* share handle would be released in runtime shutdown,
+         * but easy handle may live longer */
+        (void) curl_easy_setopt(ch, CURLOPT_SHARE, NULL);
+    }
+    if (!shared->driving && cat_curl_shared_has_pending_work(shared)) {
+        /* we may have been woken up as driver */
+        cat_curl_shared_wake_driver(shared);
+    }
+
+    return transfer.code;
+}
+
 CAT_API CURLcode cat_curl_easy_perform(CURL *ch)
 {
+    return cat_curl_easy_perform_ex(ch, CAT_CURL_EASY_PERFORM_FLAG_NONE);
+}
+
+CAT_API CURLcode cat_curl_easy_perform_ex(CURL *ch, cat_curl_easy_perform_flags_t flags)
+{
+    cat_curl_shared_t *shared = NULL;
+    CURLcode code;
+
     CAT_LOG_DEBUG(CURL, "curl_easy_perform(ch: %p) = " CAT_LOG_UNFINISHED_STR, ch);
 
-    CURLcode code = cat_curl_easy_perform_impl(ch);
+    if (CAT_CURL_G(shared_enabled)) {
+        shared = cat_curl_shared_get();
+    }
+    if (likely(shared != NULL)) {
+        code = cat_curl_easy_perform_shared(shared, ch, flags);
+    } else {
+        code = cat_curl_easy_perform_isolated(ch);
+    }
 
     CAT_LOG_DEBUG(CURL, "curl_easy_perform(ch: %p) = %d (%s)", ch, code, curl_easy_strerror(code));
 
     return code;
 }
 
+CAT_API cat_bool_t cat_curl_easy_call(CURL *ch, cat_data_callback_t function, cat_data_t *data)
+{
+    cat_curl_shared_t *shared = CAT_CURL_G(shared);
+    cat_curl_transfer_t lookup, *transfer;
+    cat_curl_call_t call;
+
+    if (shared == NULL || !shared->in_action || shared->driver != CAT_COROUTINE_G(current)) {
+        /* we are not driving the runtime multi handle */
+        goto _call;
+    }
+    lookup.ch = ch;
+    transfer = RB_FIND(cat_curl_transfer_tree_s, &shared->transfers, &lookup);
+    if (transfer == NULL || transfer->owner == CAT_COROUTINE_G(current)) {
+        goto _call;
+    }
+    if (unlikely(transfer->canceled)) {
+        cat_update_last_error(CAT_ECANCELED, "cURL transfer has been canceled");
+        return cat_false;
+    }
+
+    call.function = function;
+    call.data = data;
+    call.waiter = NULL;
+    call.done = cat_false;
+    transfer->call = &call;
+    /* owner may not be waiting if it is the one who resumed us after the last call,
+     * it would find the call after we yield */
+    if (transfer->coroutine != NULL) {
+        transfer->woken = cat_true;
+        cat_coroutine_schedule(transfer->coroutine, CURL, "Multi callback");
+    }
+    /* cURL is in the middle of action, we can not go back until the call is done */
+    while (!call.done) {
+        call.waiter = CAT_COROUTINE_G(current);
+        (void) cat_time_wait(-1);
+        call.waiter = NULL;
+    }
+
+    return cat_true;
+
+    _call:
+    function(data);
+    return cat_true;
+}
+
+CAT_API long cat_curl_set_max_host_connections(long max_host_connections)
+{
+    long original_max_host_connections = CAT_CURL_G(max_host_connections);
+
+    CAT_CURL_G(max_host_connections) = max_host_connections;
+#if LIBCURL_VERSION_NUM >= 0x071e00 /* Available since 7.30.0 */
+    if (CAT_CURL_G(shared) != NULL) {
+        (void) curl_multi_setopt(CAT_CURL_G(shared)->multi, CURLMOPT_MAX_HOST_CONNECTIONS, max_host_connections);
+    }
+#endif
+
+    return original_max_host_connections;
+}
+
+CAT_API long cat_curl_set_max_total_connections(long max_total_connections)
+{
+    long original_max_total_connections = CAT_CURL_G(max_total_connections);
+
+    CAT_CURL_G(max_total_connections) = max_total_connections;
+#if LIBCURL_VERSION_NUM >= 0x071e00 /* Available since 7.30.0 */
+    if (CAT_CURL_G(shared) != NULL) {
+        (void) curl_multi_setopt(CAT_CURL_G(shared)->multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, max_total_connections);
+    }
+#endif
+
+    return original_max_total_connections;
+}
+
 /* multi */
 
 static int cat_curl_multi_socket_function(
@@ -681,6 +1328,10 @@ CAT_API cat_bool_t cat_curl_module_shutdown(void)
 
 CAT_API cat_bool_t cat_curl_runtime_init(void)
 {
+    CAT_CURL_G(shared) = NULL;
+    CAT_CURL_G(shared_enabled) = cat_env_is_true("CAT_CURL_SHARED_MULTI", cat_true);
+    CAT_CURL_G(max_host_connections) = cat_env_get_i("CAT_CURL_MAX_HOST_CONNECTIONS", 0);
+    CAT_CURL_G(max_total_connections) = cat_env_get_i("CAT_CURL_MAX_TOTAL_CONNECTIONS", 0);
 
     return cat_true;
 }
@@ -688,6 +1339,7 @@ CAT_API cat_bool_t cat_curl_runtime_init(void)
 CAT_API cat_bool_t cat_curl_runtime_close(void)
 {
     CAT_ASSERT(RB_MIN(cat_curl_multi_context_tree_s, &CAT_CURL_G(multi_tree)) == NULL);
+    CAT_ASSERT(CAT_CURL_G(shared) == NULL);
 
     return cat_true;
 }
@@ -20,6 +20,7 @@
 #include "cat_coroutine.h"
 #include "cat_event.h"
 #include "cat_time.h"
+#include "cat_env.h"
 
 typedef struct cat_getaddrinfo_context_s {
     union {
@@ -46,12 +47,8 @@ static void cat_dns_getaddrinfo_callback(uv_getaddrinfo_t* request, int status,
     cat_free(context);
 }
 
-CAT_API struct addrinfo *cat_dns_getaddrinfo(const char *hostname, const char *service, const struct addrinfo *hints)
-{
-    return cat_dns_getaddrinfo_ex(hostname, service, hints, cat_socket_get_global_dns_timeout());
-}
-
-CAT_API struct addrinfo *cat_dns_getaddrinfo_ex(const char *hostname, const char *service, const struct addrinfo *hints, cat_timeout_t timeout)
+/* status will be set only if resolver has answered */
+static struct addrinfo *cat_dns_system_getaddrinfo(const char *hostname, const char *service, const struct addrinfo *hints, cat_timeout_t timeout, int *status)
 {
     cat_getaddrinfo_context_t *context = (cat_getaddrinfo_context_t *) cat_malloc(sizeof(*context));
     cat_bool_t ret;
@@ -83,52 +80,2107 @@ CAT_API struct addrinfo *cat_dns_getaddrinfo_ex(const char *hostname, const char
             cat_update_last_error(CAT_ECANCELED, "DNS getaddrinfo has been canceled");
             (void) uv_cancel(&context->request.req);
         } else {
+            *status = context->status;
             cat_update_last_error_with_reason(context->status, "DNS getaddrinfo failed");
         }
         return NULL;
     }
+    *status = 0;
 
     return context->response;
 }
 
-CAT_API void cat_dns_freeaddrinfo(struct addrinfo *response)
+/* the whole list is copied into one memory block, so that it can be released by cat_free() */
+static struct addrinfo *cat_dns_addrinfo_dup(const struct addrinfo *response)
 {
-    uv_freeaddrinfo(response);
+    const struct addrinfo *ai;
+    struct addrinfo *copy, *prev = NULL;
+    size_t size = 0;
+    char *p;
+
+    for (ai = response; ai != NULL; ai = ai->ai_next) {
+        size += CAT_MEMORY_ALIGNED_SIZE(sizeof(*ai));
+        size += CAT_MEMORY_ALIGNED_SIZE(ai->ai_addrlen);
+        if (ai->ai_canonname != NULL) {
+            size += CAT_MEMORY_ALIGNED_SIZE(strlen(ai->ai_canonname) + 1);
+        }
+    }
+    p = (char *) cat_malloc(size);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(p == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for DNS response failed");
+        return NULL;
+    }
+#endif
+    copy = (struct addrinfo *) p;
+    for (ai = response; ai != NULL; ai = ai->ai_next) {
+        struct addrinfo *node = (struct addrinfo *) p;
+        p += CAT_MEMORY_ALIGNED_SIZE(sizeof(*ai));
+        memcpy(node, ai, sizeof(*node));
+        node->ai_next = NULL;
+        if (ai->ai_addr != NULL) {
+            node->ai_addr = (struct sockaddr *) p;
+            memcpy(node->ai_addr, ai->ai_addr, ai->ai_addrlen);
+        }
+        p += CAT_MEMORY_ALIGNED_SIZE(ai->ai_addrlen);
+        if (ai->ai_canonname != NULL) {
+            size_t length = strlen(ai->ai_canonname) + 1;
+            node->ai_canonname = p;
+            memcpy(node->ai_canonname, ai->ai_canonname, length);
+            p += CAT_MEMORY_ALIGNED_SIZE(length);
+        }
+        if (prev != NULL) {
+            prev->ai_next = node;
+        }
+        prev = node;
+    }
+
+    return copy;
 }
 
-CAT_API cat_bool_t cat_dns_get_ip(char *buffer, size_t buffer_size, const char *name, int af)
+/* native resolver */
+
+#define CAT_DNS_HEADER_SIZE         12
+#define CAT_DNS_MAX_NAME_LENGTH     255
+#define CAT_DNS_MAX_LABEL_LENGTH    63
+#define CAT_DNS_MAX_UDP_PACKET_SIZE 4096
+#define CAT_DNS_MAX_CNAME_CHAIN     16
+#define CAT_DNS_CLASS_IN            1
+
+#define CAT_DNS_FLAG_QR 0x8000
+#define CAT_DNS_FLAG_TC 0x0200
+#define CAT_DNS_FLAG_RD 0x0100
+
+enum cat_dns_rcode_e {
+    CAT_DNS_RCODE_NOERROR  = 0,
+    CAT_DNS_RCODE_FORMERR  = 1,
+    CAT_DNS_RCODE_SERVFAIL = 2,
+    CAT_DNS_RCODE_NXDOMAIN = 3,
+    CAT_DNS_RCODE_NOTIMP   = 4,
+    CAT_DNS_RCODE_REFUSED  = 5,
+};
+
+struct cat_dns_hosts_entry_s {
+    char *name;
+    int family;
+    union {
+        struct in_addr in;
+        struct in6_addr in6;
+    } address;
+};
+
+struct cat_dns_query_s {
+    /* each query has its own socket, so the source port is picked by kernel at random (RFC 5452) */
+    cat_socket_t *socket;
+    uint16_t id;
+    cat_bool_t done;
+    const cat_sockaddr_inet_info_t *nameserver;
+    char *answer;
+    size_t answer_length;
+};
+
+static const char *cat_dns_default_resolv_conf_path(void)
 {
-    return cat_dns_get_ip_ex(buffer, buffer_size, name, af, cat_socket_get_global_dns_timeout());
+#ifndef CAT_OS_WIN
+    return "/etc/resolv.conf";
+#else
+    return "";
+#endif
 }
 
-CAT_API cat_bool_t cat_dns_get_ip_ex(char *buffer, size_t buffer_size, const char *name, int af, cat_timeout_t timeout)
+static const char *cat_dns_default_hosts_path(void)
 {
-    struct addrinfo hints = {0};
-    struct addrinfo *response;
-    int error;
+#ifndef CAT_OS_WIN
+    return "/etc/hosts";
+#else
+    return "C:\\Windows\\System32\\drivers\\etc\\hosts";
+#endif
+}
 
-    hints.ai_family = af;
-    response = cat_dns_getaddrinfo_ex(name, NULL, &hints, timeout);
-    if (unlikely(response == NULL)) {
-        cat_update_last_error_with_previous("DNS get ip failed");
+CAT_API const char *cat_dns_type_name(cat_dns_type_t type)
+{
+    switch (type) {
+        case CAT_DNS_TYPE_A:
+            return "A";
+        case CAT_DNS_TYPE_CNAME:
+            return "CNAME";
+        case CAT_DNS_TYPE_AAAA:
+            return "AAAA";
+        case CAT_DNS_TYPE_SRV:
+            return "SRV";
+    }
+    return "UNKNOWN";
+}
+
+static void cat_dns_resolver_init(cat_dns_resolver_t *resolver)
+{
+    resolver->type = cat_env_is("CAT_DNS_RESOLVER", "native", cat_false) ?
+        CAT_DNS_RESOLVER_NATIVE : CAT_DNS_RESOLVER_SYSTEM;
+    resolver->config_loaded = cat_false;
+    resolver->nameserver_count = 0;
+    resolver->search_domain_count = 0;
+    resolver->ndots = CAT_DNS_RESOLVER_DEFAULT_NDOTS;
+    resolver->attempts = CAT_DNS_RESOLVER_DEFAULT_ATTEMPTS;
+    resolver->timeout = CAT_DNS_RESOLVER_DEFAULT_TIMEOUT;
+    resolver->hosts = NULL;
+    resolver->hosts_count = 0;
+    resolver->random_id_offset = CAT_ARRAY_SIZE(resolver->random_ids);
+}
+
+static void cat_dns_resolver_clear_config(cat_dns_resolver_t *resolver)
+{
+    size_t n;
+
+    for (n = 0; n < resolver->search_domain_count; n++) {
+        cat_free(resolver->search_domains[n]);
+    }
+    resolver->search_domain_count = 0;
+    for (n = 0; n < resolver->hosts_count; n++) {
+        cat_free(resolver->hosts[n].name);
+    }
+    if (resolver->hosts != NULL) {
+        cat_free(resolver->hosts);
+        resolver->hosts = NULL;
+    }
+    resolver->hosts_count = 0;
+    resolver->nameserver_count = 0;
+    resolver->ndots = CAT_DNS_RESOLVER_DEFAULT_NDOTS;
+    resolver->attempts = CAT_DNS_RESOLVER_DEFAULT_ATTEMPTS;
+    resolver->timeout = CAT_DNS_RESOLVER_DEFAULT_TIMEOUT;
+    resolver->config_loaded = cat_false;
+}
+
+static void cat_dns_resolver_close(cat_dns_resolver_t *resolver)
+{
+    cat_dns_resolver_clear_config(resolver);
+}
+
+/* query id must be unpredictable (RFC 5452), a batch of them is drawn from CSPRNG at once */
+static uint16_t cat_dns_resolver_random_id(cat_dns_resolver_t *resolver)
+{
+    if (resolver->random_id_offset == CAT_ARRAY_SIZE(resolver->random_ids)) {
+        if (unlikely(uv_random(NULL, NULL, resolver->random_ids, sizeof(resolver->random_ids), 0, NULL) != 0)) {
+            /* it never happens on supported platforms, the random source port still protects us */
+            size_t n;
+            uint64_t x = uv_hrtime() ^ (uint64_t) (uintptr_t) resolver;
+            for (n = 0; n < CAT_ARRAY_SIZE(resolver->random_ids); n++) {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                resolver->random_ids[n] = (uint16_t) (x >> 48);
+            }
+        }
+        resolver->random_id_offset = 0;
+    }
+
+    return resolver->random_ids[resolver->random_id_offset++];
+}
+
+/* parse "1.1.1.1", "1.1.1.1:53", "::1", "[::1]:53" */
+static cat_bool_t cat_dns_resolver_parse_nameserver(cat_sockaddr_inet_info_t *nameserver, const char *text, size_t length)
+{
+    char ip[CAT_SOCKET_IP_BUFFER_SIZE];
+    const char *end = text + length, *ip_end = end, *port_text = NULL, *p;
+    int port = CAT_DNS_RESOLVER_DEFAULT_PORT;
+    char *zone;
+
+    if (length > 0 && text[0] == '[') {
+        text++;
+        ip_end = (const char *) memchr(text, ']', end - text);
+        if (ip_end == NULL) {
+            return cat_false;
+        }
+        if (ip_end + 1 != end) {
+            if (ip_end[1] != ':') {
+                return cat_false;
+            }
+            port_text = ip_end + 2;
+        }
+    } else {
+        p = (const char *) memchr(text, ':', length);
+        /* only one colon means IPv4 with port */
+        if (p != NULL && memchr(p + 1, ':', end - (p + 1)) == NULL) {
+            ip_end = p;
+            port_text = p + 1;
+        }
+    }
+    if (port_text != NULL) {
+        port = 0;
+        for (p = port_text; p < end; p++) {
+            if (*p < '0' || *p > '9' || (port = port * 10 + (*p - '0')) > 65535) {
+                return cat_false;
+            }
+        }
+        if (port_text == end || port == 0) {
+            return cat_false;
+        }
+    }
+    if (ip_end == text || (size_t) (ip_end - text) >= sizeof(ip)) {
         return cat_false;
     }
-    switch (response->ai_family) {
-        case AF_INET:
-            error = uv_ip4_name((struct sockaddr_in *) response->ai_addr, buffer, buffer_size);
+    memcpy(ip, text, ip_end - text);
+    ip[ip_end - text] = '\0';
+    /* zone index is not supported yet */
+    if ((zone = strchr(ip, '%')) != NULL) {
+        *zone = '\0';
+    }
+    if (uv_ip4_addr(ip, port, &nameserver->address.in) == 0) {
+        nameserver->length = sizeof(nameserver->address.in);
+        return cat_true;
+    }
+    if (uv_ip6_addr(ip, port, &nameserver->address.in6) == 0) {
+        nameserver->length = sizeof(nameserver->address.in6);
+        return cat_true;
+    }
+
+    return cat_false;
+}
+
+static char *cat_dns_resolver_next_token(char **cursor)
+{
+    char *p = *cursor, *token;
+
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+    if (*p == '\0' || *p == '#' || *p == ';') {
+        *cursor = p;
+        return NULL;
+    }
+    token = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+        p++;
+    }
+    if (*p != '\0') {
+        *p++ = '\0';
+    }
+    *cursor = p;
+
+    return token;
+}
+
+static void cat_dns_resolver_load_resolv_conf(cat_dns_resolver_t *resolver, const char *path)
+{
+    char line[1024];
+    FILE *file;
+
+    if (path[0] == '\0' || (file = fopen(path, "r")) == NULL) {
+        return;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char *cursor = line, *keyword, *value;
+        keyword = cat_dns_resolver_next_token(&cursor);
+        if (keyword == NULL) {
+            continue;
+        }
+        if (strcmp(keyword, "nameserver") == 0) {
+            value = cat_dns_resolver_next_token(&cursor);
+            if (value != NULL && resolver->nameserver_count < CAT_DNS_RESOLVER_MAX_NAMESERVERS &&
+                cat_dns_resolver_parse_nameserver(&resolver->nameservers[resolver->nameserver_count], value, strlen(value))) {
+                resolver->nameserver_count++;
+            }
+        } else if (strcmp(keyword, "search") == 0 || strcmp(keyword, "domain") == 0) {
+            /* the last one wins */
+            size_t n;
+            for (n = 0; n < resolver->search_domain_count; n++) {
+                cat_free(resolver->search_domains[n]);
+            }
+            resolver->search_domain_count = 0;
+            while ((value = cat_dns_resolver_next_token(&cursor)) != NULL &&
+                   resolver->search_domain_count < CAT_DNS_RESOLVER_MAX_SEARCH_DOMAINS) {
+                if (strcmp(value, ".") == 0) {
+                    continue;
+                }
+                resolver->search_domains[resolver->search_domain_count++] = cat_strdup(value);
+            }
+        } else if (strcmp(keyword, "options") == 0) {
+            while ((value = cat_dns_resolver_next_token(&cursor)) != NULL) {
+                if (strncmp(value, "ndots:", sizeof("ndots:") - 1) == 0) {
+                    resolver->ndots = (unsigned int) atoi(value + sizeof("ndots:") - 1);
+                    if (resolver->ndots > 15) {
+                        resolver->ndots = 15;
+                    }
+                } else if (strncmp(value, "timeout:", sizeof("timeout:") - 1) == 0) {
+                    int timeout = atoi(value + sizeof("timeout:") - 1);
+                    if (timeout > 0) {
+                        resolver->timeout = (cat_timeout_t) timeout * 1000;
+                    }
+                } else if (strncmp(value, "attempts:", sizeof("attempts:") - 1) == 0) {
+                    int attempts = atoi(value + sizeof("attempts:") - 1);
+                    if (attempts > 0) {
+                        resolver->attempts = attempts > 5 ? 5 : (unsigned int) attempts;
+                    }
+                }
+            }
+        }
+    }
+    fclose(file);
+}
+
+static void cat_dns_resolver_load_hosts(cat_dns_resolver_t *resolver, const char *path)
+{
+    char line[1024];
+    size_t size = 0;
+    FILE *file;
+
+    if (path[0] == '\0' || (file = fopen(path, "r")) == NULL) {
+        return;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char *cursor = line, *ip, *name;
+        cat_dns_hosts_entry_t entry;
+        ip = cat_dns_resolver_next_token(&cursor);
+        if (ip == NULL) {
+            continue;
+        }
+        if (uv_inet_pton(AF_INET, ip, &entry.address.in) == 0) {
+            entry.family = AF_INET;
+        } else if (uv_inet_pton(AF_INET6, ip, &entry.address.in6) == 0) {
+            entry.family = AF_INET6;
+        } else {
+            continue;
+        }
+        while ((name = cat_dns_resolver_next_token(&cursor)) != NULL) {
+            if (resolver->hosts_count == size) {
+                cat_dns_hosts_entry_t *hosts;
+                size = size == 0 ? 16 : size * 2;
+                hosts = (cat_dns_hosts_entry_t *) cat_realloc(resolver->hosts, sizeof(*hosts) * size);
+#if CAT_ALLOC_HANDLE_ERRORS
+                if (unlikely(hosts == NULL)) {
+                    fclose(file);
+                    return;
+                }
+#endif
+                resolver->hosts = hosts;
+            }
+            entry.name = cat_strdup(name);
+            resolver->hosts[resolver->hosts_count++] = entry;
+        }
+    }
+    fclose(file);
+}
+
+CAT_API cat_bool_t cat_dns_resolver_load_config(const char *resolv_conf, const char *hosts)
+{
+    cat_dns_resolver_t *resolver = &CAT_DNS_G(resolver);
+    char *env_resolv_conf = NULL, *env_hosts = NULL;
+
+    if (resolv_conf == NULL) {
+        env_resolv_conf = cat_env_get_silent("CAT_DNS_RESOLV_CONF", NULL);
+        resolv_conf = env_resolv_conf != NULL ? env_resolv_conf : cat_dns_default_resolv_conf_path();
+    }
+    if (hosts == NULL) {
+        env_hosts = cat_env_get_silent("CAT_DNS_HOSTS", NULL);
+        hosts = env_hosts != NULL ? env_hosts : cat_dns_default_hosts_path();
+    }
+    cat_dns_resolver_clear_config(resolver);
+    cat_dns_resolver_load_resolv_conf(resolver, resolv_conf);
+    cat_dns_resolver_load_hosts(resolver, hosts);
+    resolver->config_loaded = cat_true;
+    if (env_resolv_conf != NULL) {
+        cat_free(env_resolv_conf);
+    }
+    if (env_hosts != NULL) {
+        cat_free(env_hosts);
+    }
+
+    return cat_true;
+}
+
+static cat_always_inline void cat_dns_resolver_ensure_config(cat_dns_resolver_t *resolver)
+{
+    if (unlikely(!resolver->config_loaded)) {
+        (void) cat_dns_resolver_load_config(NULL, NULL);
+    }
+}
+
+CAT_API cat_bool_t cat_dns_resolver_set_nameservers(const char *nameservers)
+{
+    cat_dns_resolver_t *resolver = &CAT_DNS_G(resolver);
+    cat_sockaddr_inet_info_t list[CAT_DNS_RESOLVER_MAX_NAMESERVERS];
+    size_t count = 0;
+    const char *p = nameservers;
+
+    while (*p != '\0') {
+        size_t length;
+        while (*p == ',' || *p == ' ' || *p == '\t') {
+            p++;
+        }
+        length = strcspn(p, ", \t");
+        if (length == 0) {
             break;
-        case AF_INET6:
-            error = uv_ip6_name((struct sockaddr_in6 *) response->ai_addr, buffer, buffer_size);
+        }
+        if (unlikely(count == CAT_DNS_RESOLVER_MAX_NAMESERVERS)) {
+            cat_update_last_error(CAT_E2BIG, "Too many nameservers (max %d)", CAT_DNS_RESOLVER_MAX_NAMESERVERS);
+            return cat_false;
+        }
+        if (unlikely(!cat_dns_resolver_parse_nameserver(&list[count], p, length))) {
+            cat_update_last_error(CAT_EINVAL, "Invalid nameserver \"%.*s\"", (int) length, p);
+            return cat_false;
+        }
+        count++;
+        p += length;
+    }
+    cat_dns_resolver_ensure_config(resolver);
+    memcpy(resolver->nameservers, list, sizeof(list[0]) * count);
+    resolver->nameserver_count = count;
+
+    return cat_true;
+}
+
+CAT_API cat_dns_resolver_type_t cat_dns_set_resolver(cat_dns_resolver_type_t type)
+{
+    cat_dns_resolver_type_t original_type = CAT_DNS_G(resolver).type;
+    CAT_DNS_G(resolver).type = type;
+    return original_type;
+}
+
+CAT_API cat_dns_resolver_type_t cat_dns_get_resolver(void)
+{
+    return CAT_DNS_G(resolver).type;
+}
+
+/* message */
+
+static cat_always_inline uint16_t cat_dns_read_u16(const unsigned char *p)
+{
+    return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+static cat_always_inline uint32_t cat_dns_read_u32(const unsigned char *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static cat_always_inline void cat_dns_write_u16(unsigned char *p, uint16_t value)
+{
+    p[0] = (unsigned char) (value >> 8);
+    p[1] = (unsigned char) value;
+}
+
+static size_t cat_dns_build_query(unsigned char *buffer, uint16_t id, const char *name, uint16_t type)
+{
+    unsigned char *p = buffer + CAT_DNS_HEADER_SIZE;
+    const char *label = name;
+
+    memset(buffer, 0, CAT_DNS_HEADER_SIZE);
+    cat_dns_write_u16(buffer, id);
+    cat_dns_write_u16(buffer + 2, CAT_DNS_FLAG_RD);
+    cat_dns_write_u16(buffer + 4, 1);
+    while (*label != '\0') {
+        size_t length = strcspn(label, ".");
+        *p++ = (unsigned char) length;
+        memcpy(p, label, length);
+        p += length;
+        label += length;
+        if (*label == '.') {
+            label++;
+        }
+    }
+    *p++ = 0;
+    cat_dns_write_u16(p, type);
+    cat_dns_write_u16(p + 2, CAT_DNS_CLASS_IN);
+    p += 4;
+
+    return p - buffer;
+}
+
+static cat_bool_t cat_dns_check_name(const char *name)
+{
+    size_t length = strlen(name);
+    const char *label = name;
+
+    if (length > 0 && name[length - 1] == '.') {
+        length--;
+    }
+    if (length == 0 || length > CAT_DNS_MAX_NAME_LENGTH - 2) {
+        return cat_false;
+    }
+    while (label < name + length) {
+        size_t label_length = strcspn(label, ".");
+        if (label_length == 0 || label_length > CAT_DNS_MAX_LABEL_LENGTH) {
+            return cat_false;
+        }
+        label += label_length + 1;
+    }
+
+    return cat_true;
+}
+
+/* read (maybe compressed) name at *offset into out (dotted, without trailing dot) */
+static cat_bool_t cat_dns_read_name(const unsigned char *message, size_t length, size_t *offset, char *out)
+{
+    size_t position = *offset, out_length = 0;
+    cat_bool_t jumped = cat_false;
+    unsigned int jumps = 0;
+
+    while (1) {
+        unsigned int label_length;
+        if (position >= length) {
+            return cat_false;
+        }
+        label_length = message[position];
+        if ((label_length & 0xc0) == 0xc0) {
+            if (position + 1 >= length || ++jumps > 32) {
+                return cat_false;
+            }
+            if (!jumped) {
+                *offset = position + 2;
+                jumped = cat_true;
+            }
+            position = ((label_length & 0x3f) << 8) | message[position + 1];
+            continue;
+        }
+        if (label_length & 0xc0) {
+            return cat_false;
+        }
+        position++;
+        if (label_length == 0) {
             break;
+        }
+        if (position + label_length > length || out_length + label_length + 1 > CAT_DNS_MAX_NAME_LENGTH) {
+            return cat_false;
+        }
+        if (out_length > 0) {
+            out[out_length++] = '.';
+        }
+        memcpy(out + out_length, message + position, label_length);
+        out_length += label_length;
+        position += label_length;
+    }
+    out[out_length] = '\0';
+    if (!jumped) {
+        *offset = position;
+    }
+
+    return cat_true;
+}
+
+static cat_bool_t cat_dns_name_equals(const char *name1, const char *name2)
+{
+    size_t length1 = strlen(name1), length2 = strlen(name2);
+
+    if (length1 > 0 && name1[length1 - 1] == '.') {
+        length1--;
+    }
+    if (length2 > 0 && name2[length2 - 1] == '.') {
+        length2--;
+    }
+
+    return length1 == length2 && cat_strncasecmp(name1, name2, length1) == 0;
+}
+
+static cat_errno_t cat_dns_rcode_to_error(unsigned int rcode)
+{
+    switch (rcode) {
+        case CAT_DNS_RCODE_NXDOMAIN:
+            return CAT_EAI_NONAME;
+        case CAT_DNS_RCODE_SERVFAIL:
+            return CAT_EAI_AGAIN;
         default:
-            error = CAT_EAFNOSUPPORT;
+            return CAT_EAI_FAIL;
+    }
+}
+
+/* parse answers of the response to the query of (name, type) */
+static cat_dns_response_t *cat_dns_parse_response(const unsigned char *message, size_t length, const char *name, uint16_t type)
+{
+    cat_dns_response_t *response = NULL;
+    cat_dns_record_t *record;
+    char owner[CAT_DNS_MAX_NAME_LENGTH + 1], target[CAT_DNS_MAX_NAME_LENGTH + 1];
+    char canonical_name[CAT_DNS_MAX_NAME_LENGTH + 1];
+    size_t offset, answers_offset, strings_size = 0, count = 0, n, pass;
+    unsigned int flags, question_count, answer_count, cname_jumps = 0;
+    uint32_t min_ttl = UINT32_MAX;
+    cat_bool_t has_data = cat_false;
+    char *strings;
+
+    flags = cat_dns_read_u16(message + 2);
+    question_count = cat_dns_read_u16(message + 4);
+    answer_count = cat_dns_read_u16(message + 6);
+    if ((flags & 0xf) != CAT_DNS_RCODE_NOERROR) {
+        cat_update_last_error(cat_dns_rcode_to_error(flags & 0xf), "DNS query for %s %s failed with rcode %u",
+            name, cat_dns_type_name((cat_dns_type_t) type), flags & 0xf);
+        return NULL;
+    }
+    offset = CAT_DNS_HEADER_SIZE;
+    for (n = 0; n < question_count; n++) {
+        if (!cat_dns_read_name(message, length, &offset, owner) || offset + 4 > length) {
+            goto _malformed;
+        }
+        offset += 4;
+    }
+    answers_offset = offset;
+    strings = NULL;
+    /* the first pass counts, and the second pass fills */
+    for (pass = 0; pass < 2; pass++) {
+        offset = answers_offset;
+        count = 0;
+        for (n = 0; n < answer_count; n++) {
+            uint16_t rr_type, rr_class, rr_length;
+            uint32_t ttl;
+            size_t data_offset, owner_length;
+            if (!cat_dns_read_name(message, length, &offset, owner) || offset + 10 > length) {
+                goto _malformed;
+            }
+            rr_type = cat_dns_read_u16(message + offset);
+            rr_class = cat_dns_read_u16(message + offset + 2);
+            ttl = cat_dns_read_u32(message + offset + 4);
+            rr_length = cat_dns_read_u16(message + offset + 8);
+            offset += 10;
+            data_offset = offset;
+            if (offset + rr_length > length) {
+                goto _malformed;
+            }
+            offset += rr_length;
+            if (rr_class != CAT_DNS_CLASS_IN) {
+                continue;
+            }
+            owner_length = strlen(owner) + 1;
+            switch (rr_type) {
+                case CAT_DNS_TYPE_A:
+                    if (rr_length != 4) {
+                        goto _malformed;
+                    }
+                    break;
+                case CAT_DNS_TYPE_AAAA:
+                    if (rr_length != 16) {
+                        goto _malformed;
+                    }
+                    break;
+                case CAT_DNS_TYPE_CNAME: {
+                    size_t target_offset = data_offset;
+                    if (!cat_dns_read_name(message, length, &target_offset, target)) {
+                        goto _malformed;
+                    }
+                    break;
+                }
+                case CAT_DNS_TYPE_SRV: {
+                    size_t target_offset = data_offset + 6;
+                    if (rr_length < 7 || !cat_dns_read_name(message, length, &target_offset, target)) {
+                        goto _malformed;
+                    }
+                    break;
+                }
+                default:
+                    continue;
+            }
+            if (pass == 0) {
+                strings_size += owner_length;
+                if (rr_type == CAT_DNS_TYPE_CNAME || rr_type == CAT_DNS_TYPE_SRV) {
+                    strings_size += strlen(target) + 1;
+                }
+                count++;
+                continue;
+            }
+            record = &response->records[count++];
+            record->type = (cat_dns_type_t) rr_type;
+            record->ttl = ttl;
+            memcpy(strings, owner, owner_length);
+            record->name = strings;
+            strings += owner_length;
+            switch (rr_type) {
+                case CAT_DNS_TYPE_A:
+                    memcpy(&record->data.a, message + data_offset, 4);
+                    break;
+                case CAT_DNS_TYPE_AAAA:
+                    memcpy(&record->data.aaaa, message + data_offset, 16);
+                    break;
+                case CAT_DNS_TYPE_CNAME: {
+                    size_t target_length = strlen(target) + 1;
+                    memcpy(strings, target, target_length);
+                    record->data.cname = strings;
+                    strings += target_length;
+                    break;
+                }
+                case CAT_DNS_TYPE_SRV: {
+                    size_t target_length = strlen(target) + 1;
+                    record->data.srv.priority = cat_dns_read_u16(message + data_offset);
+                    record->data.srv.weight = cat_dns_read_u16(message + data_offset + 2);
+                    record->data.srv.port = cat_dns_read_u16(message + data_offset + 4);
+                    memcpy(strings, target, target_length);
+                    record->data.srv.target = strings;
+                    strings += target_length;
+                    break;
+                }
+            }
+        }
+        if (pass == 0) {
+            response = (cat_dns_response_t *) cat_malloc(
+                CAT_MEMORY_ALIGNED_SIZE(sizeof(*response)) +
+                sizeof(cat_dns_record_t) * count +
+                strings_size + CAT_DNS_MAX_NAME_LENGTH + 1
+            );
+#if CAT_ALLOC_HANDLE_ERRORS
+            if (unlikely(response == NULL)) {
+                cat_update_last_error_of_syscall("Malloc for DNS response failed");
+                return NULL;
+            }
+#endif
+            response->records = (cat_dns_record_t *) (((char *) response) + CAT_MEMORY_ALIGNED_SIZE(sizeof(*response)));
+            response->count = 0;
+            strings = (char *) (response->records + count);
+        }
+    }
+    response->count = count;
+    /* follow the CNAME chain */
+    strcpy(canonical_name, name);
+    n = strlen(canonical_name);
+    if (n > 0 && canonical_name[n - 1] == '.') {
+        canonical_name[n - 1] = '\0';
+    }
+    while (1) {
+        cat_bool_t jumped = cat_false;
+        for (n = 0; n < response->count; n++) {
+            record = &response->records[n];
+            if (!cat_dns_name_equals(record->name, canonical_name)) {
+                continue;
+            }
+            if (record->type == type) {
+                has_data = cat_true;
+                if (record->ttl < min_ttl) {
+                    min_ttl = record->ttl;
+                }
+            } else if (record->type == CAT_DNS_TYPE_CNAME && type != CAT_DNS_TYPE_CNAME && !jumped) {
+                if (record->ttl < min_ttl) {
+                    min_ttl = record->ttl;
+                }
+                strcpy(canonical_name, record->data.cname);
+                jumped = cat_true;
+            }
+        }
+        if (!jumped || has_data || ++cname_jumps > CAT_DNS_MAX_CNAME_CHAIN) {
             break;
+        }
     }
-    cat_dns_freeaddrinfo(response);
-    if (unlikely(error != 0)) {
-        cat_update_last_error_with_reason(error, "DNS convert address to IP name failed");
+    strcpy(strings, canonical_name);
+    response->canonical_name = strings;
+    response->ttl = min_ttl == UINT32_MAX ? 0 : min_ttl;
+    if (!has_data) {
+        cat_free(response);
+        cat_update_last_error(CAT_EAI_NODATA, "DNS query for %s %s has no answer", name, cat_dns_type_name((cat_dns_type_t) type));
+        return NULL;
+    }
+
+    return response;
+
+    _malformed:
+    if (response != NULL) {
+        cat_free(response);
+    }
+    cat_update_last_error(CAT_EAI_FAIL, "DNS response for %s %s is malformed", name, cat_dns_type_name((cat_dns_type_t) type));
+    return NULL;
+}
+
+/* transport */
+
+static cat_bool_t cat_dns_resolver_same_address(const cat_sockaddr_inet_info_t *nameserver, const cat_sockaddr_union_t *address, cat_socklen_t length)
+{
+    if (address->common.sa_family != nameserver->address.common.sa_family) {
         return cat_false;
     }
+    if (address->common.sa_family == AF_INET) {
+        return length >= (cat_socklen_t) sizeof(address->in) &&
+               address->in.sin_port == nameserver->address.in.sin_port &&
+               memcmp(&address->in.sin_addr, &nameserver->address.in.sin_addr, sizeof(address->in.sin_addr)) == 0;
+    }
+    return length >= (cat_socklen_t) sizeof(address->in6) &&
+           address->in6.sin6_port == nameserver->address.in6.sin6_port &&
+           memcmp(&address->in6.sin6_addr, &nameserver->address.in6.sin6_addr, sizeof(address->in6.sin6_addr)) == 0;
+}
+
+static cat_bool_t cat_dns_resolver_query_start(cat_dns_resolver_t *resolver, cat_dns_query_t *query, const cat_sockaddr_inet_info_t *nameserver, const char *name, uint16_t type, cat_timeout_t timeout)
+{
+    unsigned char packet[CAT_DNS_HEADER_SIZE + CAT_DNS_MAX_NAME_LENGTH + 1 + 4];
+    cat_socket_t *socket;
+    size_t length;
+
+    socket = cat_socket_create(NULL, nameserver->address.common.sa_family == AF_INET ? CAT_SOCKET_TYPE_UDP4 : CAT_SOCKET_TYPE_UDP6);
+    if (unlikely(socket == NULL)) {
+        cat_update_last_error_with_previous("DNS create socket failed");
+        return cat_false;
+    }
+    query->socket = socket;
+    query->id = cat_dns_resolver_random_id(resolver);
+    query->done = cat_false;
+    query->nameserver = nameserver;
+    query->answer = NULL;
+    query->answer_length = 0;
+    length = cat_dns_build_query(packet, query->id, name, type);
+    if (unlikely(!cat_socket_sendto_ex(socket, (const char *) packet, length, &nameserver->address.common, nameserver->length, timeout))) {
+        (void) cat_socket_close(socket);
+        query->socket = NULL;
+        cat_update_last_error_with_previous("DNS send query failed");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+static cat_bool_t cat_dns_resolver_query_wait(cat_dns_resolver_t *resolver, cat_dns_query_t *query, cat_timeout_t timeout)
+{
+    (void) resolver;
+
+    while (!query->done) {
+        char buffer[CAT_DNS_MAX_UDP_PACKET_SIZE];
+        cat_sockaddr_union_t address;
+        cat_socklen_t address_length = sizeof(address);
+        ssize_t nread;
+        CAT_TIME_WAIT_START() {
+            nread = cat_socket_recvfrom_ex(query->socket, buffer, sizeof(buffer), &address.common, &address_length, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(nread < 0)) {
+            cat_update_last_error_with_previous("DNS receive answer failed");
+            return cat_false;
+        }
+        /* drop what is not the answer from the nameserver to this query (stale or forged) */
+        if ((size_t) nread < CAT_DNS_HEADER_SIZE ||
+            !(cat_dns_read_u16((const unsigned char *) buffer + 2) & CAT_DNS_FLAG_QR) ||
+            cat_dns_read_u16((const unsigned char *) buffer) != query->id ||
+            !cat_dns_resolver_same_address(query->nameserver, &address, address_length)) {
+            continue;
+        }
+        query->answer = (char *) cat_malloc(nread);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(query->answer == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for DNS answer failed");
+            return cat_false;
+        }
+#endif
+        memcpy(query->answer, buffer, nread);
+        query->answer_length = (size_t) nread;
+        query->done = cat_true;
+    }
 
     return cat_true;
 }
+
+static void cat_dns_resolver_query_end(cat_dns_resolver_t *resolver, cat_dns_query_t *query)
+{
+    (void) resolver;
+
+    (void) cat_socket_close(query->socket);
+    query->socket = NULL;
+    if (query->answer != NULL) {
+        cat_free(query->answer);
+        query->answer = NULL;
+    }
+}
+
+static cat_bool_t cat_dns_resolver_query_tcp(const cat_sockaddr_inet_info_t *nameserver, const char *name, uint16_t type, cat_timeout_t timeout, char **answer, size_t *answer_length)
+{
+    unsigned char packet[2 + CAT_DNS_HEADER_SIZE + CAT_DNS_MAX_NAME_LENGTH + 1 + 4];
+    unsigned char length_buffer[2];
+    cat_socket_t *socket;
+    size_t length;
+    ssize_t nread;
+    char *buffer = NULL;
+    uint16_t id;
+    cat_bool_t ret = cat_false;
+
+    socket = cat_socket_create(NULL, nameserver->address.common.sa_family == AF_INET ? CAT_SOCKET_TYPE_TCP4 : CAT_SOCKET_TYPE_TCP6);
+    if (unlikely(socket == NULL)) {
+        return cat_false;
+    }
+    id = cat_dns_resolver_random_id(&CAT_DNS_G(resolver));
+    length = cat_dns_build_query(packet + 2, id, name, type);
+    cat_dns_write_u16(packet, (uint16_t) length);
+    CAT_TIME_WAIT_START() {
+        ret = cat_socket_connect_ex(socket, &nameserver->address.common, nameserver->length, timeout);
+    } CAT_TIME_WAIT_END(timeout);
+    if (unlikely(!ret)) {
+        goto _out;
+    }
+    CAT_TIME_WAIT_START() {
+        ret = cat_socket_send_ex(socket, (const char *) packet, length + 2, timeout);
+    } CAT_TIME_WAIT_END(timeout);
+    if (unlikely(!ret)) {
+        goto _out;
+    }
+    ret = cat_false;
+    CAT_TIME_WAIT_START() {
+        nread = cat_socket_read_ex(socket, (char *) length_buffer, sizeof(length_buffer), timeout);
+    } CAT_TIME_WAIT_END(timeout);
+    if (unlikely(nread != sizeof(length_buffer))) {
+        if (nread >= 0) {
+            cat_update_last_error(CAT_ECONNRESET, "DNS TCP connection closed by nameserver");
+        }
+        goto _out;
+    }
+    length = cat_dns_read_u16(length_buffer);
+    buffer = (char *) cat_malloc(length == 0 ? 1 : length);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(buffer == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for DNS answer failed");
+        goto _out;
+    }
+#endif
+    CAT_TIME_WAIT_START() {
+        nread = cat_socket_read_ex(socket, buffer, length, timeout);
+    } CAT_TIME_WAIT_END(timeout);
+    if (unlikely(nread != (ssize_t) length)) {
+        if (nread >= 0) {
+            cat_update_last_error(CAT_ECONNRESET, "DNS TCP connection closed by nameserver");
+        }
+        cat_free(buffer);
+        goto _out;
+    }
+    if (unlikely(length < 2 || cat_dns_read_u16((const unsigned char *) buffer) != id)) {
+        cat_update_last_error(CAT_EAI_FAIL, "DNS TCP response id does not match the query");
+        cat_free(buffer);
+        goto _out;
+    }
+    *answer = buffer;
+    *answer_length = length;
+    ret = cat_true;
+
+    _out:
+    (void) cat_socket_close(socket);
+    return ret;
+}
+
+/* check the answer of query, return NULL and set last error if it has no data */
+static cat_dns_response_t *cat_dns_resolver_handle_answer(const cat_sockaddr_inet_info_t *nameserver, const char *name, uint16_t type, cat_timeout_t timeout, char *answer, size_t answer_length, cat_bool_t *retry)
+{
+    const unsigned char *message = (const unsigned char *) answer;
+    char *tcp_answer = NULL;
+    cat_dns_response_t *response;
+    char question_name[CAT_DNS_MAX_NAME_LENGTH + 1];
+    size_t offset = CAT_DNS_HEADER_SIZE;
+    unsigned int flags, rcode;
+
+    *retry = cat_false;
+    flags = cat_dns_read_u16(message + 2);
+    if (flags & CAT_DNS_FLAG_TC) {
+        size_t tcp_answer_length;
+        if (!cat_dns_resolver_query_tcp(nameserver, name, type, timeout, &tcp_answer, &tcp_answer_length)) {
+            cat_update_last_error_with_previous("DNS query over TCP failed");
+            *retry = cat_true;
+            return NULL;
+        }
+        message = (const unsigned char *) tcp_answer;
+        answer_length = tcp_answer_length;
+        if (answer_length < CAT_DNS_HEADER_SIZE) {
+            cat_free(tcp_answer);
+            cat_update_last_error(CAT_EAI_FAIL, "DNS response for %s is malformed", name);
+            *retry = cat_true;
+            return NULL;
+        }
+        flags = cat_dns_read_u16(message + 2);
+    }
+    rcode = flags & 0xf;
+    /* the question must be echoed */
+    if (cat_dns_read_u16(message + 4) != 1 ||
+        !cat_dns_read_name(message, answer_length, &offset, question_name) ||
+        offset + 4 > answer_length ||
+        !cat_dns_name_equals(question_name, name) ||
+        cat_dns_read_u16(message + offset) != type) {
+        if (tcp_answer != NULL) {
+            cat_free(tcp_answer);
+        }
+        cat_update_last_error(CAT_EAI_FAIL, "DNS response for %s does not match the question", name);
+        *retry = cat_true;
+        return NULL;
+    }
+    if (rcode == CAT_DNS_RCODE_SERVFAIL || rcode == CAT_DNS_RCODE_REFUSED ||
+        rcode == CAT_DNS_RCODE_NOTIMP || rcode == CAT_DNS_RCODE_FORMERR) {
+        /* try the next nameserver */
+        *retry = cat_true;
+    }
+    response = cat_dns_parse_response(message, answer_length, name, type);
+    if (tcp_answer != NULL) {
+        cat_free(tcp_answer);
+    }
+
+    return response;
+}
+
+/* query all types concurrently on each nameserver, answers[n] will be NULL if it failed, errors[n] holds the reason */
+static void cat_dns_resolver_resolve(cat_dns_resolver_t *resolver, const char *name, const uint16_t *types, size_t type_count, cat_dns_response_t **responses, cat_errno_t *errors, cat_timeout_t timeout)
+{
+    cat_dns_query_t queries[2];
+    cat_bool_t pending[2], started[2];
+    unsigned int attempt;
+    size_t server, n;
+
+    CAT_ASSERT(type_count <= CAT_ARRAY_SIZE(queries));
+    for (n = 0; n < type_count; n++) {
+        responses[n] = NULL;
+        errors[n] = CAT_EAI_AGAIN;
+        pending[n] = cat_true;
+    }
+    if (unlikely(resolver->nameserver_count == 0)) {
+        for (n = 0; n < type_count; n++) {
+            errors[n] = CAT_EAI_FAIL;
+        }
+        cat_update_last_error(CAT_EAI_FAIL, "DNS resolver has no nameserver");
+        return;
+    }
+    for (attempt = 0; attempt < resolver->attempts; attempt++) {
+        for (server = 0; server < resolver->nameserver_count; server++) {
+            const cat_sockaddr_inet_info_t *nameserver = &resolver->nameservers[server];
+            cat_timeout_t attempt_timeout;
+            cat_msec_t attempt_start;
+            cat_bool_t has_pending = cat_false;
+            if (timeout == 0) {
+                for (n = 0; n < type_count; n++) {
+                    if (pending[n]) {
+                        errors[n] = CAT_ETIMEDOUT;
+                    }
+                }
+                cat_update_last_error(CAT_ETIMEDOUT, "DNS query for %s timed out", name);
+                return;
+            }
+            attempt_timeout = (timeout < 0 || timeout > resolver->timeout) ? resolver->timeout : timeout;
+            attempt_start = cat_time_msec_cached();
+            for (n = 0; n < type_count; n++) {
+                started[n] = cat_false;
+                if (!pending[n]) {
+                    continue;
+                }
+                started[n] = cat_dns_resolver_query_start(resolver, &queries[n], nameserver, name, types[n], attempt_timeout);
+                if (!started[n]) {
+                    errors[n] = cat_get_last_error_code();
+                }
+            }
+            for (n = 0; n < type_count; n++) {
+                cat_timeout_t wait_timeout = attempt_timeout;
+                cat_bool_t retry;
+                if (!started[n]) {
+                    continue;
+                }
+                /* queries were sent at the same time, they share the time of this attempt */
+                if (wait_timeout > 0) {
+                    cat_msec_t elapsed = cat_time_msec_cached() - attempt_start;
+                    wait_timeout = elapsed < (cat_msec_t) wait_timeout ? wait_timeout - (cat_timeout_t) elapsed : 0;
+                }
+                CAT_TIME_WAIT_START() {
+                    (void) cat_dns_resolver_query_wait(resolver, &queries[n], wait_timeout);
+                } CAT_TIME_WAIT_END(timeout);
+                if (!queries[n].done) {
+                    errors[n] = cat_get_last_error_code();
+                    if (errors[n] == CAT_ETIMEDOUT) {
+                        /* the next attempt */
+                        errors[n] = CAT_EAI_AGAIN;
+                    } else if (errors[n] == CAT_ECANCELED) {
+                        /* stop all */
+                        for (; n < type_count; n++) {
+                            if (started[n]) {
+                                cat_dns_resolver_query_end(resolver, &queries[n]);
+                            }
+                            errors[n] = CAT_ECANCELED;
+                        }
+                        cat_update_last_error(CAT_ECANCELED, "DNS query has been canceled");
+                        return;
+                    }
+                    cat_dns_resolver_query_end(resolver, &queries[n]);
+                    continue;
+                }
+                CAT_TIME_WAIT_START() {
+                    responses[n] = cat_dns_resolver_handle_answer(nameserver, name, types[n], timeout < 0 ? resolver->timeout : timeout, queries[n].answer, queries[n].answer_length, &retry);
+                } CAT_TIME_WAIT_END(timeout);
+                cat_dns_resolver_query_end(resolver, &queries[n]);
+                if (responses[n] != NULL) {
+                    pending[n] = cat_false;
+                    errors[n] = 0;
+                } else {
+                    errors[n] = cat_get_last_error_code();
+                    pending[n] = retry;
+                }
+            }
+            for (n = 0; n < type_count; n++) {
+                if (pending[n]) {
+                    has_pending = cat_true;
+                }
+            }
+            if (!has_pending) {
+                return;
+            }
+        }
+    }
+}
+
+static cat_always_inline cat_bool_t cat_dns_resolver_need_search(const cat_dns_resolver_t *resolver, const char *name)
+{
+    size_t length = strlen(name);
+    return resolver->search_domain_count > 0 && length > 0 && name[length - 1] != '.';
+}
+
+static cat_bool_t cat_dns_resolver_get_candidate(const cat_dns_resolver_t *resolver, const char *name, size_t index, char *buffer)
+{
+    size_t dots = 0, n;
+    const char *p;
+    cat_bool_t as_is_first;
+
+    for (p = name; *p != '\0'; p++) {
+        if (*p == '.') {
+            dots++;
+        }
+    }
+    if (!cat_dns_resolver_need_search(resolver, name)) {
+        if (index > 0) {
+            return cat_false;
+        }
+        strcpy(buffer, name);
+        return cat_true;
+    }
+    as_is_first = dots >= resolver->ndots;
+    if (as_is_first) {
+        if (index == 0) {
+            strcpy(buffer, name);
+            return cat_true;
+        }
+        n = index - 1;
+    } else {
+        if (index == resolver->search_domain_count) {
+            strcpy(buffer, name);
+            return cat_true;
+        }
+        n = index;
+    }
+    if (n >= resolver->search_domain_count) {
+        return cat_false;
+    }
+    if (strlen(name) + 1 + strlen(resolver->search_domains[n]) > CAT_DNS_MAX_NAME_LENGTH - 1) {
+        buffer[0] = '\0';
+        return cat_true;
+    }
+    sprintf(buffer, "%s.%s", name, resolver->search_domains[n]);
+
+    return cat_true;
+}
+
+CAT_API cat_dns_response_t *cat_dns_query(const char *name, cat_dns_type_t type)
+{
+    return cat_dns_query_ex(name, type, cat_socket_get_global_dns_timeout());
+}
+
+CAT_API cat_dns_response_t *cat_dns_query_ex(const char *name, cat_dns_type_t type, cat_timeout_t timeout)
+{
+    cat_dns_resolver_t *resolver = &CAT_DNS_G(resolver);
+    char candidate[CAT_DNS_MAX_NAME_LENGTH + 1];
+    cat_dns_response_t *response = NULL;
+    uint16_t types[1] = { (uint16_t) type };
+    cat_errno_t error = CAT_EAI_NONAME;
+    size_t index;
+
+    if (unlikely(!cat_dns_check_name(name))) {
+        cat_update_last_error(CAT_EINVAL, "DNS name \"%s\" is invalid", name);
+        return NULL;
+    }
+    cat_dns_resolver_ensure_config(resolver);
+    for (index = 0; cat_dns_resolver_get_candidate(resolver, name, index, candidate); index++) {
+        if (candidate[0] == '\0') {
+            continue;
+        }
+        CAT_TIME_WAIT_START() {
+            cat_dns_resolver_resolve(resolver, candidate, types, 1, &response, &error, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (response != NULL || (error != CAT_EAI_NONAME && error != CAT_EAI_NODATA)) {
+            break;
+        }
+    }
+    if (response == NULL) {
+        cat_update_last_error_with_previous("DNS query failed");
+    }
+
+    return response;
+}
+
+CAT_API void cat_dns_response_free(cat_dns_response_t *response)
+{
+    cat_free(response);
+}
+
+static cat_bool_t cat_dns_parse_numeric_service(const char *service, int *port)
+{
+    const char *p;
+
+    *port = 0;
+    if (service == NULL || service[0] == '\0') {
+        return cat_true;
+    }
+    for (p = service; *p != '\0'; p++) {
+        if (*p < '0' || *p > '9') {
+            return cat_false;
+        }
+        *port = *port * 10 + (*p - '0');
+        if (*port > 65535) {
+            return cat_false;
+        }
+    }
+
+    return cat_true;
+}
+
+typedef struct cat_dns_address_s {
+    int family;
+    union {
+        struct in_addr in;
+        struct in6_addr in6;
+    } u;
+} cat_dns_address_t;
+
+/* addresses are on stack at first, they are moved to heap if there are too many */
+#define CAT_DNS_LOCAL_ADDRESSES 8
+
+static cat_bool_t cat_dns_addresses_grow(cat_dns_address_t **addresses, size_t *size, const cat_dns_address_t *local_addresses, size_t count)
+{
+    cat_dns_address_t *new_addresses = (cat_dns_address_t *) cat_malloc(sizeof(**addresses) * *size * 2);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(new_addresses == NULL)) {
+        return cat_false;
+    }
+#endif
+    memcpy(new_addresses, *addresses, sizeof(**addresses) * count);
+    if (*addresses != local_addresses) {
+        cat_free(*addresses);
+    }
+    *addresses = new_addresses;
+    *size *= 2;
+
+    return cat_true;
+}
+
+/* same as what system getaddrinfo() returns for each address */
+static const struct {
+    int socktype;
+    int protocol;
+} cat_dns_addrinfo_socktypes[] = {
+    { SOCK_STREAM, IPPROTO_TCP },
+    { SOCK_DGRAM, IPPROTO_UDP },
+    { SOCK_RAW, 0 },
+};
+
+static struct addrinfo *cat_dns_build_addrinfo(const cat_dns_address_t *addresses, size_t count, int port, const struct addrinfo *hints, const char *canonical_name)
+{
+    int socktypes[CAT_ARRAY_SIZE(cat_dns_addrinfo_socktypes)], protocols[CAT_ARRAY_SIZE(cat_dns_addrinfo_socktypes)];
+    size_t size = 0, socktype_count = 0, n, m;
+    struct addrinfo *response, *prev = NULL;
+    char *p;
+
+    for (n = 0; n < CAT_ARRAY_SIZE(cat_dns_addrinfo_socktypes); n++) {
+        if ((hints->ai_socktype == 0 || hints->ai_socktype == cat_dns_addrinfo_socktypes[n].socktype) &&
+            (hints->ai_protocol == 0 || hints->ai_protocol == cat_dns_addrinfo_socktypes[n].protocol)) {
+            socktypes[socktype_count] = cat_dns_addrinfo_socktypes[n].socktype;
+            protocols[socktype_count] = cat_dns_addrinfo_socktypes[n].protocol;
+            socktype_count++;
+        }
+    }
+    if (socktype_count == 0) {
+        socktypes[0] = hints->ai_socktype;
+        protocols[0] = hints->ai_protocol;
+        socktype_count = 1;
+    }
+    for (n = 0; n < count; n++) {
+        size += CAT_MEMORY_ALIGNED_SIZE(sizeof(struct addrinfo)) * socktype_count;
+        size += CAT_MEMORY_ALIGNED_SIZE(addresses[n].family == AF_INET ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6)) * socktype_count;
+    }
+    if (canonical_name != NULL) {
+        size += strlen(canonical_name) + 1;
+    }
+    p = (char *) cat_malloc(size);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(p == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for DNS response failed");
+        return NULL;
+    }
+#endif
+    response = (struct addrinfo *) p;
+    for (n = 0; n < count; n++) {
+        for (m = 0; m < socktype_count; m++) {
+            struct addrinfo *ai = (struct addrinfo *) p;
+            p += CAT_MEMORY_ALIGNED_SIZE(sizeof(*ai));
+            memset(ai, 0, sizeof(*ai));
+            ai->ai_family = addresses[n].family;
+            ai->ai_socktype = socktypes[m];
+            ai->ai_protocol = protocols[m];
+            ai->ai_addr = (struct sockaddr *) p;
+            if (addresses[n].family == AF_INET) {
+                struct sockaddr_in *in = (struct sockaddr_in *) p;
+                memset(in, 0, sizeof(*in));
+                in->sin_family = AF_INET;
+                in->sin_port = htons((uint16_t) port);
+                in->sin_addr = addresses[n].u.in;
+                ai->ai_addrlen = sizeof(*in);
+            } else {
+                struct sockaddr_in6 *in6 = (struct sockaddr_in6 *) p;
+                memset(in6, 0, sizeof(*in6));
+                in6->sin6_family = AF_INET6;
+                in6->sin6_port = htons((uint16_t) port);
+                in6->sin6_addr = addresses[n].u.in6;
+                ai->ai_addrlen = sizeof(*in6);
+            }
+            p += CAT_MEMORY_ALIGNED_SIZE(ai->ai_addrlen);
+            if (prev != NULL) {
+                prev->ai_next = ai;
+            }
+            prev = ai;
+        }
+    }
+    if (canonical_name != NULL) {
+        strcpy(p, canonical_name);
+        response->ai_canonname = p;
+    }
+
+    return response;
+}
+
+/* return cat_false if native resolver can not handle it, *status will be set only if resolver has answered */
+static cat_bool_t cat_dns_native_getaddrinfo(const char *hostname, const char *service, const struct addrinfo *hints, cat_timeout_t timeout, struct addrinfo **response, int *status, uint32_t *ttl)
+{
+    cat_dns_resolver_t *resolver = &CAT_DNS_G(resolver);
+    cat_dns_address_t local_addresses[CAT_DNS_LOCAL_ADDRESSES], *addresses = local_addresses;
+    size_t address_count = 0, address_size = CAT_ARRAY_SIZE(local_addresses), index;
+    char candidate[CAT_DNS_MAX_NAME_LENGTH + 1];
+    const char *canonical_name = NULL;
+    cat_dns_response_t *responses[2] = { NULL, NULL };
+    cat_errno_t errors[2] = { CAT_EAI_NONAME, CAT_EAI_NONAME };
+    uint16_t types[2];
+    size_t type_count = 0, n, m;
+    int port;
+
+    if (hostname == NULL ||
+        (hints->ai_flags & ~(AI_PASSIVE | AI_CANONNAME | AI_NUMERICHOST | AI_ADDRCONFIG
+#ifdef AI_NUMERICSERV
+        | AI_NUMERICSERV
+#endif
+        )) != 0 ||
+        (hints->ai_family != AF_UNSPEC && hints->ai_family != AF_INET && hints->ai_family != AF_INET6) ||
+        !cat_dns_parse_numeric_service(service, &port)) {
+        return cat_false;
+    }
+    cat_dns_resolver_ensure_config(resolver);
+    if (resolver->nameserver_count == 0) {
+        return cat_false;
+    }
+    *ttl = UINT32_MAX;
+    /* numeric host */
+    do {
+        cat_dns_address_t address;
+        if (hints->ai_family != AF_INET6 && uv_inet_pton(AF_INET, hostname, &address.u.in) == 0) {
+            address.family = AF_INET;
+        } else if (hints->ai_family != AF_INET && uv_inet_pton(AF_INET6, hostname, &address.u.in6) == 0) {
+            address.family = AF_INET6;
+        } else {
+            break;
+        }
+        *response = cat_dns_build_addrinfo(&address, 1, port, hints, (hints->ai_flags & AI_CANONNAME) ? hostname : NULL);
+        *status = 0;
+        return cat_true;
+    } while (0);
+    if (hints->ai_flags & AI_NUMERICHOST) {
+        *response = NULL;
+        *status = CAT_EAI_NONAME;
+        cat_update_last_error(CAT_EAI_NONAME, "DNS getaddrinfo failed, host \"%s\" is not numeric", hostname);
+        return cat_true;
+    }
+    if (!cat_dns_check_name(hostname)) {
+        *response = NULL;
+        *status = CAT_EAI_NONAME;
+        cat_update_last_error(CAT_EAI_NONAME, "DNS getaddrinfo failed, host \"%s\" is invalid", hostname);
+        return cat_true;
+    }
+    /* hosts file */
+    for (n = 0; n < resolver->hosts_count; n++) {
+        const cat_dns_hosts_entry_t *entry = &resolver->hosts[n];
+        if (!cat_dns_name_equals(entry->name, hostname) ||
+            (hints->ai_family != AF_UNSPEC && hints->ai_family != entry->family)) {
+            continue;
+        }
+        if (address_count == CAT_DNS_RESOLVER_MAX_HOSTS_ADDRESSES) {
+            break;
+        }
+        if (address_count == address_size &&
+            !cat_dns_addresses_grow(&addresses, &address_size, local_addresses, address_count)) {
+            break;
+        }
+        addresses[address_count].family = entry->family;
+        memcpy(&addresses[address_count].u, &entry->address, sizeof(entry->address));
+        address_count++;
+    }
+    if (address_count > 0) {
+        *response = cat_dns_build_addrinfo(addresses, address_count, port, hints, (hints->ai_flags & AI_CANONNAME) ? hostname : NULL);
+        *status = 0;
+        if (addresses != local_addresses) {
+            cat_free(addresses);
+        }
+        return cat_true;
+    }
+    /* A first, then AAAA */
+    if (hints->ai_family != AF_INET6) {
+        types[type_count++] = CAT_DNS_TYPE_A;
+    }
+    if (hints->ai_family != AF_INET) {
+        types[type_count++] = CAT_DNS_TYPE_AAAA;
+    }
+    for (index = 0; cat_dns_resolver_get_candidate(resolver, hostname, index, candidate); index++) {
+        cat_bool_t found = cat_false, again = cat_false;
+        if (candidate[0] == '\0') {
+            continue;
+        }
+        CAT_TIME_WAIT_START() {
+            cat_dns_resolver_resolve(resolver, candidate, types, type_count, responses, errors, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        for (n = 0; n < type_count; n++) {
+            if (responses[n] != NULL) {
+                found = cat_true;
+            } else if (errors[n] != CAT_EAI_NONAME && errors[n] != CAT_EAI_NODATA) {
+                again = cat_true;
+            }
+        }
+        if (found || again) {
+            break;
+        }
+    }
+    for (n = 0; n < type_count; n++) {
+        if (responses[n] == NULL) {
+            continue;
+        }
+        if (canonical_name == NULL) {
+            canonical_name = responses[n]->canonical_name;
+        }
+        if (responses[n]->ttl < *ttl) {
+            *ttl = responses[n]->ttl;
+        }
+        for (m = 0; m < responses[n]->count; m++) {
+            const cat_dns_record_t *record = &responses[n]->records[m];
+            if ((record->type != CAT_DNS_TYPE_A && record->type != CAT_DNS_TYPE_AAAA) ||
+                !cat_dns_name_equals(record->name, responses[n]->canonical_name)) {
+                continue;
+            }
+            if (address_count == address_size &&
+                !cat_dns_addresses_grow(&addresses, &address_size, local_addresses, address_count)) {
+                break;
+            }
+            if (record->type == CAT_DNS_TYPE_A) {
+                addresses[address_count].family = AF_INET;
+                addresses[address_count].u.in = record->data.a;
+            } else {
+                addresses[address_count].family = AF_INET6;
+                addresses[address_count].u.in6 = record->data.aaaa;
+            }
+            address_count++;
+        }
+    }
+    if (address_count > 0) {
+        *response = cat_dns_build_addrinfo(addresses, address_count, port, hints, (hints->ai_flags & AI_CANONNAME) ? canonical_name : NULL);
+        *status = 0;
+    } else {
+        cat_errno_t error = errors[0];
+        /* NODATA of one family and NONAME of another one means NODATA */
+        for (n = 1; n < type_count; n++) {
+            if (error == CAT_EAI_NONAME || error == CAT_EAI_NODATA) {
+                if (errors[n] != CAT_EAI_NONAME) {
+                    error = errors[n];
+                }
+            }
+        }
+        *response = NULL;
+        if (error != CAT_ETIMEDOUT && error != CAT_ECANCELED) {
+            *status = error;
+        }
+        cat_update_last_error(error, "DNS getaddrinfo failed for host \"%s\"", hostname);
+    }
+    for (n = 0; n < type_count; n++) {
+        if (responses[n] != NULL) {
+            cat_dns_response_free(responses[n]);
+        }
+    }
+    if (addresses != local_addresses) {
+        cat_free(addresses);
+    }
+
+    return cat_true;
+}
+
+/* status will be set only if resolver has answered, response is released by cat_free() */
+static struct addrinfo *cat_dns_getaddrinfo_uncached(const char *hostname, const char *service, const struct addrinfo *hints, cat_timeout_t timeout, int *status, uint32_t *ttl)
+{
+    struct addrinfo *response, *copy;
+
+    *ttl = UINT32_MAX;
+    if (CAT_DNS_G(resolver).type == CAT_DNS_RESOLVER_NATIVE &&
+        cat_dns_native_getaddrinfo(hostname, service, hints, timeout, &response, status, ttl)) {
+        return response;
+    }
+    response = cat_dns_system_getaddrinfo(hostname, service, hints, timeout, status);
+    if (response == NULL) {
+        return NULL;
+    }
+    copy = cat_dns_addrinfo_dup(response);
+    uv_freeaddrinfo(response);
+    if (unlikely(copy == NULL)) {
+        cat_update_last_error_with_previous("DNS getaddrinfo failed");
+    }
+
+    return copy;
+}
+
+/* cache */
+
+struct cat_dns_cache_entry_s {
+    /* hash chain */
+    cat_dns_cache_entry_t *next;
+    /* lru node (resolved) */
+    cat_queue_node_t node;
+    /* coroutines which are waiting for the pending lookup */
+    cat_queue_t waiters;
+    uint32_t hash;
+    uint32_t refcount;
+    cat_bool_t linked;
+    cat_bool_t pending;
+    /* lookup was abandoned by leader (e.g. timed out), waiters should try again */
+    cat_bool_t abandoned;
+    int status;
+    cat_msec_t expire;
+    struct addrinfo *response;
+    int family;
+    int socktype;
+    int protocol;
+    int flags;
+    /* lowercase hostname + '\0' + service + '\0' */
+    size_t hostname_length;
+    size_t key_length;
+    char key[1];
+};
+
+CAT_API CAT_GLOBALS_DECLARE(cat_dns);
+
+CAT_API cat_bool_t cat_dns_module_init(void)
+{
+    CAT_GLOBALS_REGISTER(cat_dns);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_dns_module_shutdown(void)
+{
+    CAT_GLOBALS_UNREGISTER(cat_dns);
+
+    return cat_true;
+}
+
+static void cat_dns_runtime_shutdown_callback(cat_data_t *data)
+{
+    (void) data;
+    (void) cat_dns_runtime_shutdown();
+}
+
+CAT_API cat_bool_t cat_dns_runtime_init(void)
+{
+    cat_dns_cache_t *cache = &CAT_DNS_G(cache);
+
+    cache->buckets = NULL;
+    cache->bucket_count = 0;
+    cat_queue_init(&cache->lru);
+    cache->size = 0;
+    cache->max_size = (size_t) cat_env_get_i("CAT_DNS_CACHE_SIZE", CAT_DNS_CACHE_DEFAULT_SIZE);
+    cache->pending_count = 0;
+    cache->ttl = (cat_msec_t) cat_env_get_i("CAT_DNS_CACHE_TTL", CAT_DNS_CACHE_DEFAULT_TTL);
+    cache->negative_ttl = (cat_msec_t) cat_env_get_i("CAT_DNS_CACHE_NEGATIVE_TTL", CAT_DNS_CACHE_DEFAULT_NEGATIVE_TTL);
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->coalesced = 0;
+    cache->evictions = 0;
+    cat_dns_resolver_init(&CAT_DNS_G(resolver));
+
+    if (unlikely(cat_event_register_runtime_shutdown_task(cat_dns_runtime_shutdown_callback, NULL) == NULL)) {
+        cat_update_last_error_with_previous("DNS register runtime shutdown task failed");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_dns_runtime_shutdown(void)
+{
+    cat_dns_cache_t *cache = &CAT_DNS_G(cache);
+
+    (void) cat_dns_cache_flush(NULL);
+    if (cache->buckets != NULL) {
+        cat_free(cache->buckets);
+        cache->buckets = NULL;
+        cache->bucket_count = 0;
+    }
+    cache->max_size = 0;
+    cat_dns_resolver_close(&CAT_DNS_G(resolver));
+
+    return cat_true;
+}
+
+static uint32_t cat_dns_cache_hash(const char *key, size_t length, int family, int socktype, int protocol, int flags)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    size_t n;
+
+    for (n = 0; n < length; n++) {
+        hash ^= (unsigned char) key[n];
+        hash *= 16777619u;
+    }
+    hash ^= (uint32_t) family;
+    hash *= 16777619u;
+    hash ^= (uint32_t) socktype;
+    hash *= 16777619u;
+    hash ^= (uint32_t) protocol;
+    hash *= 16777619u;
+    hash ^= (uint32_t) flags;
+    hash *= 16777619u;
+
+    return hash;
+}
+
+static void cat_dns_cache_entry_release(cat_dns_cache_entry_t *entry)
+{
+    if (--entry->refcount != 0) {
+        return;
+    }
+    CAT_ASSERT(!entry->linked);
+    CAT_ASSERT(cat_queue_empty(&entry->waiters));
+    if (entry->response != NULL) {
+        cat_free(entry->response);
+    }
+    cat_free(entry);
+}
+
+static cat_dns_cache_entry_t **cat_dns_cache_bucket(cat_dns_cache_t *cache, uint32_t hash)
+{
+    return &cache->buckets[hash & (cache->bucket_count - 1)];
+}
+
+static cat_bool_t cat_dns_cache_resize(cat_dns_cache_t *cache, size_t max_size)
+{
+    cat_dns_cache_entry_t **buckets, *entry, *next;
+    size_t bucket_count = 16, n;
+
+    while (bucket_count < max_size) {
+        bucket_count <<= 1;
+    }
+    if (bucket_count == cache->bucket_count) {
+        return cat_true;
+    }
+    buckets = (cat_dns_cache_entry_t **) cat_malloc(sizeof(*buckets) * bucket_count);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(buckets == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for DNS cache buckets failed");
+        return cat_false;
+    }
+#endif
+    memset(buckets, 0, sizeof(*buckets) * bucket_count);
+    for (n = 0; n < cache->bucket_count; n++) {
+        for (entry = cache->buckets[n]; entry != NULL; entry = next) {
+            next = entry->next;
+            entry->next = buckets[entry->hash & (bucket_count - 1)];
+            buckets[entry->hash & (bucket_count - 1)] = entry;
+        }
+    }
+    if (cache->buckets != NULL) {
+        cat_free(cache->buckets);
+    }
+    cache->buckets = buckets;
+    cache->bucket_count = bucket_count;
+
+    return cat_true;
+}
+
+static void cat_dns_cache_unlink(cat_dns_cache_t *cache, cat_dns_cache_entry_t *entry)
+{
+    cat_dns_cache_entry_t **p = cat_dns_cache_bucket(cache, entry->hash);
+
+    CAT_ASSERT(entry->linked);
+    while (*p != entry) {
+        p = &(*p)->next;
+    }
+    *p = entry->next;
+    entry->next = NULL;
+    entry->linked = cat_false;
+    if (entry->pending) {
+        cache->pending_count--;
+    } else {
+        cat_queue_remove(&entry->node);
+        cache->size--;
+    }
+    cat_dns_cache_entry_release(entry);
+}
+
+static void cat_dns_cache_evict(cat_dns_cache_t *cache)
+{
+    while (cache->size > cache->max_size) {
+        cat_dns_cache_entry_t *entry = cat_queue_back_data(&cache->lru, cat_dns_cache_entry_t, node);
+        cat_dns_cache_unlink(cache, entry);
+        cache->evictions++;
+    }
+}
+
+static cat_dns_cache_entry_t *cat_dns_cache_find(cat_dns_cache_t *cache, const char *key, size_t key_length, uint32_t hash, const struct addrinfo *hints)
+{
+    cat_dns_cache_entry_t *entry;
+
+    if (cache->buckets == NULL) {
+        return NULL;
+    }
+    for (entry = *cat_dns_cache_bucket(cache, hash); entry != NULL; entry = entry->next) {
+        if (entry->hash == hash &&
+            entry->key_length == key_length &&
+            entry->family == hints->ai_family &&
+            entry->socktype == hints->ai_socktype &&
+            entry->protocol == hints->ai_protocol &&
+            entry->flags == hints->ai_flags &&
+            memcmp(entry->key, key, key_length) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static cat_always_inline cat_bool_t cat_dns_cache_is_cacheable_error(int status)
+{
+    return status == CAT_EAI_NONAME || status == CAT_EAI_NODATA;
+}
+
+static struct addrinfo *cat_dns_cache_response(const cat_dns_cache_entry_t *entry)
+{
+    struct addrinfo *response;
+
+    if (entry->status != 0) {
+        cat_update_last_error_with_reason(entry->status, "DNS getaddrinfo failed");
+        return NULL;
+    }
+    response = cat_dns_addrinfo_dup(entry->response);
+    if (unlikely(response == NULL)) {
+        cat_update_last_error_with_previous("DNS getaddrinfo failed");
+    }
+
+    return response;
+}
+
+static struct addrinfo *cat_dns_cache_getaddrinfo(cat_dns_cache_t *cache, const char *hostname, const char *service, const struct addrinfo *hints, cat_timeout_t timeout)
+{
+    struct addrinfo *response;
+    cat_dns_cache_entry_t *entry;
+    size_t hostname_length = strlen(hostname);
+    size_t service_length = service != NULL ? strlen(service) : 0;
+    size_t key_length = hostname_length + 1 + service_length + 1;
+    char *key, key_buffer[512];
+    uint32_t hash;
+    cat_bool_t ret;
+    uint32_t ttl;
+    size_t n;
+    int status;
+
+    if (unlikely(key_length > sizeof(key_buffer))) {
+        return cat_dns_getaddrinfo_uncached(hostname, service, hints, timeout, &status, &ttl);
+    }
+    key = key_buffer;
+    for (n = 0; n < hostname_length; n++) {
+        key[n] = (char) tolower((unsigned char) hostname[n]);
+    }
+    key[hostname_length] = '\0';
+    if (service_length > 0) {
+        memcpy(key + hostname_length + 1, service, service_length);
+    }
+    key[key_length - 1] = '\0';
+    hash = cat_dns_cache_hash(key, key_length, hints->ai_family, hints->ai_socktype, hints->ai_protocol, hints->ai_flags);
+
+    while (1) {
+        entry = cat_dns_cache_find(cache, key, key_length, hash, hints);
+        if (entry == NULL) {
+            break;
+        }
+        if (!entry->pending) {
+            if (entry->expire > cat_time_msec_cached()) {
+                cache->hits++;
+                cat_queue_remove(&entry->node);
+                cat_queue_push_front(&cache->lru, &entry->node);
+                return cat_dns_cache_response(entry);
+            }
+            cat_dns_cache_unlink(cache, entry);
+            break;
+        }
+        /* someone is resolving the same name, wait for it */
+        cache->coalesced++;
+        entry->refcount++;
+        cat_queue_push_back(&entry->waiters, &CAT_COROUTINE_G(current)->waiter.node);
+        CAT_TIME_WAIT_START() {
+            ret = cat_time_wait(timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (entry->pending) {
+            cat_queue_remove(&CAT_COROUTINE_G(current)->waiter.node);
+            if (ret) {
+                cat_update_last_error(CAT_ECANCELED, "DNS getaddrinfo has been canceled");
+            } else {
+                cat_update_last_error_with_previous("DNS getaddrinfo wait failed");
+            }
+            cat_dns_cache_entry_release(entry);
+            return NULL;
+        }
+        if (entry->abandoned) {
+            cat_dns_cache_entry_release(entry);
+            if (unlikely(timeout == 0)) {
+                cat_update_last_error(CAT_ETIMEDOUT, "DNS getaddrinfo timed out");
+                return NULL;
+            }
+            continue;
+        }
+        response = cat_dns_cache_response(entry);
+        cat_dns_cache_entry_release(entry);
+        return response;
+    }
+
+    /* we are the leader of this name */
+    cache->misses++;
+    if (unlikely(cache->buckets == NULL && !cat_dns_cache_resize(cache, cache->max_size))) {
+        return cat_dns_getaddrinfo_uncached(hostname, service, hints, timeout, &status, &ttl);
+    }
+    entry = (cat_dns_cache_entry_t *) cat_malloc(offsetof(cat_dns_cache_entry_t, key) + key_length);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(entry == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for DNS cache entry failed");
+        return NULL;
+    }
+#endif
+    cat_queue_init(&entry->waiters);
+    entry->hash = hash;
+    entry->refcount = 2; /* table and leader */
+    entry->pending = cat_true;
+    entry->abandoned = cat_false;
+    entry->status = CAT_ECANCELED;
+    entry->expire = 0;
+    entry->response = NULL;
+    entry->family = hints->ai_family;
+    entry->socktype = hints->ai_socktype;
+    entry->protocol = hints->ai_protocol;
+    entry->flags = hints->ai_flags;
+    entry->hostname_length = hostname_length;
+    entry->key_length = key_length;
+    memcpy(entry->key, key, key_length);
+    entry->next = *cat_dns_cache_bucket(cache, hash);
+    *cat_dns_cache_bucket(cache, hash) = entry;
+    entry->linked = cat_true;
+    cache->pending_count++;
+
+    status = CAT_ECANCELED;
+    response = cat_dns_getaddrinfo_uncached(hostname, service, hints, timeout, &status, &ttl);
+
+    if (entry->linked) {
+        cat_dns_cache_entry_t **p = cat_dns_cache_bucket(cache, hash);
+        /* detach it from the pending state */
+        while (*p != entry) {
+            p = &(*p)->next;
+        }
+        *p = entry->next;
+        entry->next = NULL;
+        entry->linked = cat_false;
+        cache->pending_count--;
+        entry->refcount--;
+    }
+    entry->pending = cat_false;
+    entry->status = status;
+    entry->response = response;
+    if (status == CAT_ECANCELED) {
+        entry->abandoned = cat_true;
+    } else if ((status == 0 || cat_dns_cache_is_cacheable_error(status)) && cache->max_size > 0 &&
+               /* it may be flushed and resolved by others during the lookup */
+               cat_dns_cache_find(cache, key, key_length, hash, hints) == NULL) {
+        cat_msec_t entry_ttl = status == 0 ? cache->ttl : cache->negative_ttl;
+        /* never keep it longer than the record says */
+        if (ttl != UINT32_MAX && (cat_msec_t) ttl * 1000 < entry_ttl) {
+            entry_ttl = (cat_msec_t) ttl * 1000;
+        }
+        entry->expire = cat_time_msec_cached() + entry_ttl;
+        entry->next = *cat_dns_cache_bucket(cache, hash);
+        *cat_dns_cache_bucket(cache, hash) = entry;
+        entry->linked = cat_true;
+        entry->refcount++;
+        cat_queue_push_front(&cache->lru, &entry->node);
+        cache->size++;
+        cat_dns_cache_evict(cache);
+    }
+    /* wake up all waiters, they will get the result from entry */
+    if (!cat_queue_empty(&entry->waiters)) {
+        cat_coroutine_t *waiter;
+        /* waiters may overwrite the last error */
+        cat_errno_t error = response == NULL ? cat_get_last_error_code() : 0;
+        const char *message = response == NULL ? cat_get_last_error_message() : NULL;
+        char *error_message = message != NULL ? cat_strdup(message) : NULL;
+        while ((waiter = cat_queue_front_data(&entry->waiters, cat_coroutine_t, waiter.node))) {
+            cat_queue_remove(&waiter->waiter.node);
+            cat_coroutine_schedule(waiter, DNS, "DNS cache waiter");
+        }
+        if (response == NULL) {
+            cat_set_last_error(error, error_message);
+        }
+    }
+    entry->response = NULL;
+    if (response != NULL && entry->linked) {
+        /* entry owns the response now */
+        entry->response = response;
+        response = cat_dns_addrinfo_dup(response);
+        if (unlikely(response == NULL)) {
+            cat_update_last_error_with_previous("DNS getaddrinfo failed");
+        }
+        cat_dns_cache_entry_release(entry);
+        return response;
+    }
+    cat_dns_cache_entry_release(entry);
+
+    return response;
+}
+
+CAT_API struct addrinfo *cat_dns_getaddrinfo(const char *hostname, const char *service, const struct addrinfo *hints)
+{
+    return cat_dns_getaddrinfo_ex(hostname, service, hints, cat_socket_get_global_dns_timeout());
+}
+
+CAT_API struct addrinfo *cat_dns_getaddrinfo_ex(const char *hostname, const char *service, const struct addrinfo *hints, cat_timeout_t timeout)
+{
+    cat_dns_cache_t *cache = &CAT_DNS_G(cache);
+    struct addrinfo zero_hints = {0};
+    uint32_t ttl;
+    int status;
+
+    if (hints == NULL) {
+        hints = &zero_hints;
+    }
+    if (hostname != NULL && cache->max_size > 0) {
+        return cat_dns_cache_getaddrinfo(cache, hostname, service, hints, timeout);
+    }
+
+    return cat_dns_getaddrinfo_uncached(hostname, service, hints, timeout, &status, &ttl);
+}
+
+CAT_API void cat_dns_freeaddrinfo(struct addrinfo *response)
+{
+    cat_free(response);
+}
+
+CAT_API cat_bool_t cat_dns_get_ip(char *buffer, size_t buffer_size, const char *name, int af)
+{
+    return cat_dns_get_ip_ex(buffer, buffer_size, name, af, cat_socket_get_global_dns_timeout());
+}
+
+CAT_API cat_bool_t cat_dns_get_ip_ex(char *buffer, size_t buffer_size, const char *name, int af, cat_timeout_t timeout)
+{
+    struct addrinfo hints = {0};
+    struct addrinfo *response;
+    int error;
+
+    hints.ai_family = af;
+    response = cat_dns_getaddrinfo_ex(name, NULL, &hints, timeout);
+    if (unlikely(response == NULL)) {
+        cat_update_last_error_with_previous("DNS get ip failed");
+        return cat_false;
+    }
+    switch (response->ai_family) {
+        case AF_INET:
+            error = uv_ip4_name((struct sockaddr_in *) response->ai_addr, buffer, buffer_size);
+            break;
+        case AF_INET6:
+            error = uv_ip6_name((struct sockaddr_in6 *) response->ai_addr, buffer, buffer_size);
+            break;
+        default:
+            error = CAT_EAFNOSUPPORT;
+            break;
+    }
+    cat_dns_freeaddrinfo(response);
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "DNS convert address to IP name failed");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+CAT_API size_t cat_dns_cache_set_size(size_t max_size)
+{
+    cat_dns_cache_t *cache = &CAT_DNS_G(cache);
+    size_t original_max_size = cache->max_size;
+
+    cache->max_size = max_size;
+    if (max_size == 0) {
+        (void) cat_dns_cache_flush(NULL);
+    } else {
+        cat_dns_cache_evict(cache);
+        if (cache->buckets != NULL) {
+            (void) cat_dns_cache_resize(cache, max_size);
+        }
+    }
+
+    return original_max_size;
+}
+
+CAT_API cat_msec_t cat_dns_cache_set_ttl(cat_msec_t ttl)
+{
+    cat_msec_t original_ttl = CAT_DNS_G(cache).ttl;
+    CAT_DNS_G(cache).ttl = ttl;
+    return original_ttl;
+}
+
+CAT_API cat_msec_t cat_dns_cache_set_negative_ttl(cat_msec_t ttl)
+{
+    cat_msec_t original_ttl = CAT_DNS_G(cache).negative_ttl;
+    CAT_DNS_G(cache).negative_ttl = ttl;
+    return original_ttl;
+}
+
+CAT_API void cat_dns_cache_get_stats(cat_dns_cache_stats_t *stats)
+{
+    cat_dns_cache_t *cache = &CAT_DNS_G(cache);
+
+    stats->size = cache->size;
+    stats->max_size = cache->max_size;
+    stats->pending_count = cache->pending_count;
+    stats->ttl = cache->ttl;
+    stats->negative_ttl = cache->negative_ttl;
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->coalesced = cache->coalesced;
+    stats->evictions = cache->evictions;
+}
+
+CAT_API void cat_dns_cache_walk(cat_dns_cache_walker_t walker, cat_data_t *data)
+{
+    cat_dns_cache_t *cache = &CAT_DNS_G(cache);
+    cat_msec_t now = cat_time_msec_cached();
+
+    CAT_QUEUE_FOREACH_DATA_START(&cache->lru, cat_dns_cache_entry_t, node, entry) {
+        cat_dns_cache_entry_info_t info;
+        if (entry->expire <= now) {
+            continue;
+        }
+        info.hostname = entry->key;
+        info.service = entry->key + entry->hostname_length + 1;
+        info.family = entry->family;
+        info.socktype = entry->socktype;
+        info.protocol = entry->protocol;
+        info.flags = entry->flags;
+        info.status = entry->status;
+        info.ttl = entry->expire - now;
+        info.response = entry->response;
+        walker(&info, data);
+    } CAT_QUEUE_FOREACH_DATA_END();
+}
+
+CAT_API size_t cat_dns_cache_flush(const char *hostname)
+{
+    cat_dns_cache_t *cache = &CAT_DNS_G(cache);
+    size_t hostname_length = hostname != NULL ? strlen(hostname) : 0;
+    size_t count = 0, n;
+
+    for (n = 0; n < cache->bucket_count; n++) {
+        cat_dns_cache_entry_t *entry = cache->buckets[n], *next;
+        for (; entry != NULL; entry = next) {
+            next = entry->next;
+            if (hostname != NULL &&
+                (entry->hostname_length != hostname_length ||
+                 cat_strncasecmp(entry->key, hostname, hostname_length) != 0)) {
+                continue;
+            }
+            /* pending lookups are only detached, they will not be cached */
+            cat_dns_cache_unlink(cache, entry);
+            count++;
+        }
+    }
+
+    return count;
+}
@@ -17,6 +17,9 @@
  */
 
 #include "cat_event.h"
+#include "cat_work.h"
+#include "cat_io_uring.h"
+#include "cat_fs.h"
 
 #ifdef CAT_IDE_HELPER
 #include "uv-common.h"
@@ -47,17 +50,34 @@ struct cat_event_io_defer_task_s {
 
 CAT_API CAT_GLOBALS_DECLARE(cat_event);
 
-static void cat_event_do_io_defer_tasks(uv_check_t *check);
+static void cat_event_check_callback(uv_check_t *check);
+static void cat_event_ready_queue_idle_callback(uv_idle_t *idle);
+
+static void cat_event_timer_wheel_init(cat_event_timer_wheel_t *wheel);
+static void cat_event_timer_wheel_close(cat_event_timer_wheel_t *wheel);
 
 CAT_API cat_bool_t cat_event_module_init(void)
 {
     CAT_GLOBALS_REGISTER(cat_event);
 
+    if (unlikely(!cat_work_module_init())) {
+        return cat_false;
+    }
+    if (unlikely(!cat_io_uring_module_init())) {
+        return cat_false;
+    }
+    if (unlikely(!cat_fs_module_init())) {
+        return cat_false;
+    }
+
     return cat_true;
 }
 
 CAT_API cat_bool_t cat_event_module_shutdown(void)
 {
+    (void) cat_fs_module_shutdown();
+    (void) cat_io_uring_module_shutdown();
+    (void) cat_work_module_shutdown();
     CAT_GLOBALS_UNREGISTER(cat_event);
 
     return cat_true;
@@ -79,10 +99,29 @@ CAT_API cat_bool_t cat_event_runtime_init(void)
     do {
         uv_check_t *check = &CAT_EVENT_G(io_defer_check);
         (void) uv_check_init(&CAT_EVENT_G(loop), check);
-        (void) uv_check_start(check, cat_event_do_io_defer_tasks);
+        (void) uv_check_start(check, cat_event_check_callback);
         uv_unref((uv_handle_t *) check);
         check->flags |= UV_HANDLE_INTERNAL;
     } while (0);
+    do {
+        uv_idle_t *idle = &CAT_EVENT_G(ready_queue_idle);
+        (void) uv_idle_init(&CAT_EVENT_G(loop), idle);
+        idle->flags |= UV_HANDLE_INTERNAL;
+    } while (0);
+    cat_event_timer_wheel_init(&CAT_EVENT_G(timer_wheel));
+
+    if (unlikely(!cat_work_runtime_init())) {
+        CAT_WARN_WITH_LAST(EVENT, "Work runtime init failed");
+        return cat_false;
+    }
+    if (unlikely(!cat_io_uring_runtime_init())) {
+        CAT_WARN_WITH_LAST(EVENT, "io_uring runtime init failed");
+        return cat_false;
+    }
+    if (unlikely(!cat_fs_runtime_init())) {
+        CAT_WARN_WITH_LAST(EVENT, "File-System runtime init failed");
+        return cat_false;
+    }
 
     return cat_true;
 }
@@ -104,6 +143,8 @@ CAT_API cat_bool_t cat_event_runtime_shutdown(void)
     cat_event_schedule();
 
     uv_close((uv_handle_t *) &CAT_EVENT_G(io_defer_check), NULL);
+    uv_close((uv_handle_t *) &CAT_EVENT_G(ready_queue_idle), NULL);
+    cat_event_timer_wheel_close(&CAT_EVENT_G(timer_wheel));
 
     CAT_ASSERT(cat_queue_empty(&CAT_EVENT_G(runtime_shutdown_tasks)));
     CAT_ASSERT(cat_queue_empty(&CAT_EVENT_G(io_defer_tasks)));
@@ -138,11 +179,32 @@ CAT_API cat_event_round_t cat_event_get_round(void)
     return CAT_EVENT_G(loop).round;
 }
 
+static void cat_event_ready_queue_idle_callback(uv_idle_t *idle)
+{
+    /* nothing to do, ready queue will be run in the check phase */
+    (void) idle;
+}
+
+static void cat_event_ready(void)
+{
+    /* poll will not block as long as there is an active idle handle,
+     * it also keeps event loop alive even if ready queue is filled by close callbacks */
+    (void) uv_idle_start(&CAT_EVENT_G(ready_queue_idle), cat_event_ready_queue_idle_callback);
+}
+
+static void cat_event_run_ready_queue(void)
+{
+    if (cat_coroutine_ready_queue_run() == 0) {
+        (void) uv_idle_stop(&CAT_EVENT_G(ready_queue_idle));
+    }
+}
+
 CAT_API cat_coroutine_t *cat_event_scheduler_run(cat_coroutine_t *coroutine)
 {
     const cat_coroutine_scheduler_t scheduler = {
         cat_event_schedule,
-        NULL
+        NULL,
+        cat_event_ready
     };
 
     return cat_coroutine_scheduler_run(coroutine, &scheduler);
@@ -210,12 +272,11 @@ CAT_API cat_bool_t cat_event_loop_defer_task_close(cat_event_loop_defer_task_t *
     return called;
 }
 
-static void cat_event_do_io_defer_tasks(uv_check_t *check)
+static void cat_event_do_io_defer_tasks(void)
 {
     cat_queue_t *tasks = &CAT_EVENT_G(io_defer_tasks);
     cat_event_io_defer_task_t *task;
 
-    (void) check;
     /* execute tasks of current round */
     while ((task = cat_queue_front_data(tasks, cat_event_io_defer_task_t, node)) != NULL) {
         cat_queue_remove(&task->node);
@@ -225,6 +286,14 @@ static void cat_event_do_io_defer_tasks(uv_check_t *check)
     }
 }
 
+static void cat_event_check_callback(uv_check_t *check)
+{
+    (void) check;
+    cat_event_do_io_defer_tasks();
+    /* all IO events of this round have been collected */
+    cat_event_run_ready_queue();
+}
+
 CAT_API cat_event_io_defer_task_t *cat_event_io_defer_task_create(
     cat_event_io_defer_callback_t callback,
     cat_data_t *data
@@ -247,6 +316,256 @@ CAT_API cat_bool_t cat_event_io_defer_task_close(cat_event_io_defer_task_t *task
     return called;
 }
 
+/* timer wheel */
+
+#define CAT_EVENT_TIMER_WHEEL_LEVEL_SHIFT(level) ((level) * CAT_EVENT_TIMER_WHEEL_SLOT_BITS)
+#define CAT_EVENT_TIMER_WHEEL_LEVEL_SPAN(level)  (((cat_msec_t) 1) << CAT_EVENT_TIMER_WHEEL_LEVEL_SHIFT(level))
+#define CAT_EVENT_TIMER_WHEEL_NO_TICK            UINT64_MAX
+
+static void cat_event_timer_wheel_driver_callback(uv_timer_t *driver);
+
+static cat_always_inline unsigned int cat_event_timer_wheel_ctz(uint64_t bitmap)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int) __builtin_ctzll(bitmap);
+#else
+    unsigned int n = 0;
+    while (!(bitmap & 1)) {
+        bitmap >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static cat_always_inline void cat_event_timer_wheel_queue_move(cat_queue_t *from, cat_queue_t *to)
+{
+    if (cat_queue_empty(from)) {
+        cat_queue_init(to);
+    } else {
+        cat_queue_next(to) = cat_queue_next(from);
+        cat_queue_prev(to) = cat_queue_prev(from);
+        cat_queue_next_prev(to) = to;
+        cat_queue_prev_next(to) = to;
+        cat_queue_init(from);
+    }
+}
+
+static void cat_event_timer_wheel_init(cat_event_timer_wheel_t *wheel)
+{
+    size_t level, index;
+
+    (void) uv_timer_init(&CAT_EVENT_G(loop), &wheel->driver);
+    wheel->driver.flags |= UV_HANDLE_INTERNAL;
+    wheel->time = CAT_EVENT_G(loop).time;
+    wheel->next_tick = CAT_EVENT_TIMER_WHEEL_NO_TICK;
+    wheel->count = 0;
+    for (level = 0; level < CAT_EVENT_TIMER_WHEEL_LEVEL_COUNT; level++) {
+        wheel->bitmaps[level] = 0;
+        for (index = 0; index < CAT_EVENT_TIMER_WHEEL_SLOT_COUNT; index++) {
+            cat_queue_init(&wheel->slots[level][index]);
+        }
+    }
+}
+
+static void cat_event_timer_wheel_close(cat_event_timer_wheel_t *wheel)
+{
+    CAT_ASSERT(wheel->count == 0 && "Timer wheel should be empty");
+    uv_close((uv_handle_t *) &wheel->driver, NULL);
+}
+
+/* link timer to the slot which covers its expire time, and return the tick when it should be processed */
+static cat_msec_t cat_event_timer_wheel_link(cat_event_timer_wheel_t *wheel, cat_event_timer_t *timer)
+{
+    cat_msec_t expire = timer->expire, delta;
+    unsigned int level = 0, shift, index;
+
+    if (unlikely(expire < wheel->time)) {
+        expire = wheel->time;
+    }
+    delta = expire - wheel->time;
+    if (unlikely(delta >= CAT_EVENT_TIMER_WHEEL_LEVEL_SPAN(CAT_EVENT_TIMER_WHEEL_LEVEL_COUNT))) {
+        /* park it in the furthest slot, it will be re-linked when cascading */
+        delta = CAT_EVENT_TIMER_WHEEL_LEVEL_SPAN(CAT_EVENT_TIMER_WHEEL_LEVEL_COUNT) - 1;
+        expire = wheel->time + delta;
+    }
+    while (level < CAT_EVENT_TIMER_WHEEL_LEVEL_COUNT - 1 && delta >= CAT_EVENT_TIMER_WHEEL_LEVEL_SPAN(level + 1)) {
+        level++;
+    }
+    shift = CAT_EVENT_TIMER_WHEEL_LEVEL_SHIFT(level);
+    index = (unsigned int) ((expire >> shift) & CAT_EVENT_TIMER_WHEEL_SLOT_MASK);
+    cat_queue_push_back(&wheel->slots[level][index], &timer->node);
+    wheel->bitmaps[level] |= ((uint64_t) 1) << index;
+
+    return (expire >> shift) << shift;
+}
+
+/* find the nearest tick which has timers to expire or to cascade,
+ * bits of empty slots are cleared lazily here since stop() does not know the slot */
+static cat_msec_t cat_event_timer_wheel_next_tick(cat_event_timer_wheel_t *wheel)
+{
+    cat_msec_t next_tick = CAT_EVENT_TIMER_WHEEL_NO_TICK;
+    unsigned int level;
+
+    for (level = 0; level < CAT_EVENT_TIMER_WHEEL_LEVEL_COUNT; level++) {
+        unsigned int shift = CAT_EVENT_TIMER_WHEEL_LEVEL_SHIFT(level);
+        /* the first period which has not been processed yet */
+        cat_msec_t period = (wheel->time + CAT_EVENT_TIMER_WHEEL_LEVEL_SPAN(level) - 1) >> shift;
+        unsigned int offset = (unsigned int) (period & CAT_EVENT_TIMER_WHEEL_SLOT_MASK);
+        while (wheel->bitmaps[level] != 0) {
+            uint64_t bitmap = wheel->bitmaps[level];
+            unsigned int distance, index;
+            if (offset != 0) {
+                bitmap = (bitmap >> offset) | (bitmap << (CAT_EVENT_TIMER_WHEEL_SLOT_COUNT - offset));
+            }
+            distance = cat_event_timer_wheel_ctz(bitmap);
+            index = (offset + distance) & CAT_EVENT_TIMER_WHEEL_SLOT_MASK;
+            if (cat_queue_empty(&wheel->slots[level][index])) {
+                wheel->bitmaps[level] &= ~(((uint64_t) 1) << index);
+                continue;
+            }
+            if (((period + distance) << shift) < next_tick) {
+                next_tick = (period + distance) << shift;
+            }
+            break;
+        }
+    }
+
+    return next_tick;
+}
+
+static void cat_event_timer_wheel_schedule(cat_event_timer_wheel_t *wheel, cat_msec_t tick)
+{
+    cat_msec_t now = CAT_EVENT_G(loop).time;
+
+    wheel->next_tick = tick;
+    (void) uv_timer_start(&wheel->driver, cat_event_timer_wheel_driver_callback, tick > now ? tick - now : 0, 0);
+}
+
+static void cat_event_timer_wheel_process(cat_event_timer_wheel_t *wheel, cat_msec_t tick)
+{
+    cat_queue_t queue;
+    cat_event_timer_t *timer;
+    unsigned int level, index;
+
+    wheel->time = tick;
+    /* cascade timers of the periods which start from this tick to lower levels */
+    for (level = CAT_EVENT_TIMER_WHEEL_LEVEL_COUNT - 1; level > 0; level--) {
+        unsigned int shift = CAT_EVENT_TIMER_WHEEL_LEVEL_SHIFT(level);
+        if ((tick & (CAT_EVENT_TIMER_WHEEL_LEVEL_SPAN(level) - 1)) != 0) {
+            continue;
+        }
+        index = (unsigned int) ((tick >> shift) & CAT_EVENT_TIMER_WHEEL_SLOT_MASK);
+        cat_event_timer_wheel_queue_move(&wheel->slots[level][index], &queue);
+        wheel->bitmaps[level] &= ~(((uint64_t) 1) << index);
+        while ((timer = cat_queue_front_data(&queue, cat_event_timer_t, node))) {
+            cat_queue_remove(&timer->node);
+            (void) cat_event_timer_wheel_link(wheel, timer);
+        }
+    }
+    index = (unsigned int) (tick & CAT_EVENT_TIMER_WHEEL_SLOT_MASK);
+    cat_event_timer_wheel_queue_move(&wheel->slots[0][index], &queue);
+    wheel->bitmaps[0] &= ~(((uint64_t) 1) << index);
+    /* timers which are started in callbacks should never be linked to this tick */
+    wheel->time = tick + 1;
+    while ((timer = cat_queue_front_data(&queue, cat_event_timer_t, node))) {
+        cat_queue_remove(&timer->node);
+        cat_queue_init(&timer->node);
+        wheel->count--;
+        timer->callback(timer);
+        /* note: do not access the timer anymore,
+         * it may be released or restarted in callback,
+         * and the others in queue may be stopped as well. */
+    }
+}
+
+static void cat_event_timer_wheel_driver_callback(uv_timer_t *driver)
+{
+    cat_event_timer_wheel_t *wheel = cat_container_of(driver, cat_event_timer_wheel_t, driver);
+    cat_msec_t now = CAT_EVENT_G(loop).time;
+    cat_msec_t tick;
+
+    while (1) {
+        if (wheel->count == 0) {
+            tick = CAT_EVENT_TIMER_WHEEL_NO_TICK;
+            break;
+        }
+        tick = cat_event_timer_wheel_next_tick(wheel);
+        if (tick > now) {
+            break;
+        }
+        cat_event_timer_wheel_process(wheel, tick);
+    }
+    if (wheel->time <= now) {
+        /* nothing in [time, now], skip them */
+        wheel->time = now + 1;
+    }
+    if (tick == CAT_EVENT_TIMER_WHEEL_NO_TICK) {
+        (void) uv_timer_stop(driver);
+        wheel->next_tick = CAT_EVENT_TIMER_WHEEL_NO_TICK;
+    } else {
+        cat_event_timer_wheel_schedule(wheel, tick);
+    }
+}
+
+CAT_API void cat_event_timer_init(cat_event_timer_t *timer, cat_event_timer_callback_t callback)
+{
+    cat_queue_init(&timer->node);
+    timer->expire = 0;
+    timer->callback = callback;
+}
+
+CAT_API void cat_event_timer_start(cat_event_timer_t *timer, cat_msec_t timeout)
+{
+    cat_event_timer_wheel_t *wheel = &CAT_EVENT_G(timer_wheel);
+    cat_msec_t now = CAT_EVENT_G(loop).time;
+    cat_msec_t tick;
+
+    if (cat_event_timer_is_active(timer)) {
+        cat_event_timer_stop(timer);
+    }
+    if (wheel->count == 0 && wheel->time < now) {
+        /* wheel is empty, it is safe to move it forward to the current time directly */
+        wheel->time = now;
+    }
+    timer->expire = now + timeout;
+    if (unlikely(timer->expire < now)) {
+        timer->expire = UINT64_MAX;
+    }
+    tick = cat_event_timer_wheel_link(wheel, timer);
+    wheel->count++;
+    /* if driver is running callback, next_tick must be <= now, it will be rescheduled later */
+    if (tick < wheel->next_tick) {
+        cat_event_timer_wheel_schedule(wheel, tick);
+    }
+}
+
+CAT_API void cat_event_timer_stop(cat_event_timer_t *timer)
+{
+    cat_event_timer_wheel_t *wheel = &CAT_EVENT_G(timer_wheel);
+
+    if (!cat_event_timer_is_active(timer)) {
+        return;
+    }
+    cat_queue_remove(&timer->node);
+    cat_queue_init(&timer->node);
+    if (--wheel->count == 0) {
+        /* do not keep the event loop alive */
+        (void) uv_timer_stop(&wheel->driver);
+        wheel->next_tick = CAT_EVENT_TIMER_WHEEL_NO_TICK;
+    }
+}
+
+CAT_API cat_bool_t cat_event_timer_is_active(const cat_event_timer_t *timer)
+{
+    return !cat_queue_empty(&timer->node);
+}
+
+CAT_API size_t cat_event_timer_get_count(void)
+{
+    return CAT_EVENT_G(timer_wheel).count;
+}
+
 CAT_API void cat_event_fork(void)
 {
 #ifndef CAT_COROUTINE_USE_THREAD_CONTEXT
@@ -255,6 +574,7 @@ CAT_API void cat_event_fork(void)
     if (error != 0) {
         CAT_CORE_ERROR_WITH_REASON(EVENT, error, "Event loop fork failed");
     }
+    cat_io_uring_fork();
 #else
     CAT_ERROR(EVENT, "Function fork() is disabled for internal reasons when using thread-context");
 #endif
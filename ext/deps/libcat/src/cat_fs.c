@@ -23,6 +23,7 @@
 #include "cat_time.h"
 #include "cat_work.h"
 #include "cat_async.h"
+#include "cat_io_uring.h"
 
 #ifdef CAT_ENABLE_DEBUG_LOG
 #include "cat_buffer.h" // for buffer_export_str()
@@ -32,6 +33,10 @@
 # include <winternl.h>
 #endif // CAT_OS_WIN
 
+#ifdef CAT_HAVE_IO_URING
+# include <sys/sysmacros.h>
+#endif
+
 #ifdef CAT_OS_WIN
 # ifdef _WIN64
 #  define fseeko _fseeki64
@@ -156,6 +161,292 @@ static void cat_fs_callback(uv_fs_t *fs)
     cat_free(context);
 }
 
+/* io_uring backend */
+
+CAT_API CAT_GLOBALS_DECLARE(cat_fs);
+
+#ifdef CAT_HAVE_IO_URING
+
+#ifndef AT_EMPTY_PATH
+# define AT_EMPTY_PATH 0x1000
+#endif
+#define CAT_FS_IO_URING_STATX_MASK 0xfff /* STATX_BASIC_STATS | STATX_BTIME */
+/* the same as the max count of bytes read(2)/write(2) can transfer */
+#define CAT_FS_IO_URING_MAX_RW_SIZE 0x7ffff000
+
+/* the same as struct statx of kernel */
+typedef struct cat_fs_statx_timestamp_s {
+    int64_t tv_sec;
+    uint32_t tv_nsec;
+    int32_t unused0;
+} cat_fs_statx_timestamp_t;
+
+typedef struct cat_fs_statx_s {
+    uint32_t stx_mask;
+    uint32_t stx_blksize;
+    uint64_t stx_attributes;
+    uint32_t stx_nlink;
+    uint32_t stx_uid;
+    uint32_t stx_gid;
+    uint16_t stx_mode;
+    uint16_t unused0;
+    uint64_t stx_ino;
+    uint64_t stx_size;
+    uint64_t stx_blocks;
+    uint64_t stx_attributes_mask;
+    cat_fs_statx_timestamp_t stx_atime;
+    cat_fs_statx_timestamp_t stx_btime;
+    cat_fs_statx_timestamp_t stx_ctime;
+    cat_fs_statx_timestamp_t stx_mtime;
+    uint32_t stx_rdev_major;
+    uint32_t stx_rdev_minor;
+    uint32_t stx_dev_major;
+    uint32_t stx_dev_minor;
+    uint64_t unused1[14];
+} cat_fs_statx_t;
+
+typedef struct cat_fs_io_uring_request_s {
+    cat_io_uring_request_t request;
+    cat_coroutine_t *coroutine;
+    int32_t result;
+    /* they must outlive the waiter (request may be canceled) */
+    cat_fs_statx_t statxbuf;
+    char path[1];
+} cat_fs_io_uring_request_t;
+
+static cat_always_inline cat_bool_t cat_fs_io_uring_is_available(uint8_t opcode)
+{
+    if (unlikely(!CAT_FS_G(io_uring_enabled))) {
+        return cat_false;
+    }
+
+    return cat_io_uring_is_available(opcode);
+}
+
+static void cat_fs_io_uring_callback(cat_io_uring_request_t *ring_request, int32_t result, uint32_t flags)
+{
+    cat_fs_io_uring_request_t *request = (cat_fs_io_uring_request_t *) ring_request;
+    cat_coroutine_t *coroutine = request->coroutine;
+    (void) flags;
+
+    request->result = result;
+    if (coroutine != NULL) {
+        request->coroutine = NULL;
+        /* waiter still holds the reference of request */
+        cat_coroutine_schedule_deferrable(coroutine, FS, "File-System");
+    }
+}
+
+static cat_fs_io_uring_request_t *cat_fs_io_uring_request_create(uint8_t opcode, int fd, const char *path)
+{
+    cat_fs_io_uring_request_t *request;
+    size_t path_length = path != NULL ? strlen(path) : 0;
+
+    request = (cat_fs_io_uring_request_t *) cat_io_uring_request_create(
+        offsetof(cat_fs_io_uring_request_t, path) + path_length + 1,
+        opcode, fd, cat_fs_io_uring_callback
+    );
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(request == NULL)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+#endif
+    if (path != NULL) {
+        memcpy(request->path, path, path_length + 1);
+        request->request.sqe.addr = (uint64_t) (uintptr_t) request->path;
+    }
+
+    return request;
+}
+
+/* request is released by this function unless it returns true,
+ * then caller should read result and release it */
+static cat_bool_t cat_fs_io_uring_wait(cat_fs_io_uring_request_t *request, const char *operation)
+{
+    cat_bool_t done;
+    cat_bool_t ret;
+
+    if (unlikely(!cat_io_uring_submit(&request->request))) {
+        cat_update_last_error_with_previous("File-System %s failed", operation);
+        errno = cat_orig_errno(cat_get_last_error_code());
+        cat_io_uring_request_release(&request->request);
+        return cat_false;
+    }
+    request->coroutine = CAT_COROUTINE_G(current);
+    ret = cat_time_wait(CAT_TIMEOUT_FOREVER);
+    done = request->coroutine == NULL;
+    request->coroutine = NULL;
+    if (unlikely(!ret || !done)) {
+        if (!ret) {
+            cat_update_last_error_with_previous("File-System %s wait failed", operation);
+        } else {
+            cat_update_last_error(CAT_ECANCELED, "File-System %s has been canceled", operation);
+        }
+        errno = cat_orig_errno(cat_get_last_error_code());
+        cat_io_uring_cancel(&request->request);
+        cat_io_uring_request_release(&request->request);
+        return cat_false;
+    }
+    if (unlikely(request->result < 0)) {
+        cat_update_last_error_with_reason((cat_errno_t) request->result, "File-System %s failed", operation);
+        errno = cat_orig_errno((cat_errno_t) request->result);
+        cat_io_uring_request_release(&request->request);
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+static cat_always_inline int64_t cat_fs_io_uring_do(cat_fs_io_uring_request_t *request, const char *operation)
+{
+    int64_t result;
+
+    if (unlikely(!cat_fs_io_uring_wait(request, operation))) {
+        return -1;
+    }
+    result = request->result;
+    cat_io_uring_request_release(&request->request);
+
+    return result;
+}
+
+static cat_always_inline int64_t cat_fs_io_uring_rw(uint8_t opcode, cat_file_t fd, const void *buffer, size_t size, uint64_t offset, const char *operation)
+{
+    cat_fs_io_uring_request_t *request = cat_fs_io_uring_request_create(opcode, fd, NULL);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(request == NULL)) {
+        return -1;
+    }
+#endif
+    request->request.sqe.addr = (uint64_t) (uintptr_t) buffer;
+    request->request.sqe.len = (uint32_t) CAT_MIN(size, CAT_FS_IO_URING_MAX_RW_SIZE);
+    request->request.sqe.off = offset;
+
+    return cat_fs_io_uring_do(request, operation);
+}
+
+static int cat_fs_io_uring_stat(int dirfd, const char *path, int flags, cat_stat_t *statbuf, const char *operation)
+{
+    cat_fs_io_uring_request_t *request = cat_fs_io_uring_request_create(IORING_OP_STATX, dirfd, path);
+    cat_fs_statx_t *statxbuf;
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(request == NULL)) {
+        return -1;
+    }
+#endif
+    request->request.sqe.len = CAT_FS_IO_URING_STATX_MASK;
+    request->request.sqe.off = (uint64_t) (uintptr_t) &request->statxbuf;
+    request->request.sqe.statx_flags = flags;
+    if (unlikely(!cat_fs_io_uring_wait(request, operation))) {
+        return -1;
+    }
+    statxbuf = &request->statxbuf;
+    statbuf->st_dev = makedev(statxbuf->stx_dev_major, statxbuf->stx_dev_minor);
+    statbuf->st_mode = statxbuf->stx_mode;
+    statbuf->st_nlink = statxbuf->stx_nlink;
+    statbuf->st_uid = statxbuf->stx_uid;
+    statbuf->st_gid = statxbuf->stx_gid;
+    statbuf->st_rdev = makedev(statxbuf->stx_rdev_major, statxbuf->stx_rdev_minor);
+    statbuf->st_ino = statxbuf->stx_ino;
+    statbuf->st_size = statxbuf->stx_size;
+    statbuf->st_blksize = statxbuf->stx_blksize;
+    statbuf->st_blocks = statxbuf->stx_blocks;
+    statbuf->st_atim.tv_sec = statxbuf->stx_atime.tv_sec;
+    statbuf->st_atim.tv_nsec = statxbuf->stx_atime.tv_nsec;
+    statbuf->st_mtim.tv_sec = statxbuf->stx_mtime.tv_sec;
+    statbuf->st_mtim.tv_nsec = statxbuf->stx_mtime.tv_nsec;
+    statbuf->st_ctim.tv_sec = statxbuf->stx_ctime.tv_sec;
+    statbuf->st_ctim.tv_nsec = statxbuf->stx_ctime.tv_nsec;
+    statbuf->st_birthtim.tv_sec = statxbuf->stx_btime.tv_sec;
+    statbuf->st_birthtim.tv_nsec = statxbuf->stx_btime.tv_nsec;
+    statbuf->st_flags = 0;
+    statbuf->st_gen = 0;
+    cat_io_uring_request_release(&request->request);
+
+    return 0;
+}
+
+static cat_always_inline int64_t cat_fs_io_uring_open(const char *path, cat_fs_open_flags_t flags, int mode)
+{
+    cat_fs_io_uring_request_t *request = cat_fs_io_uring_request_create(IORING_OP_OPENAT, AT_FDCWD, path);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(request == NULL)) {
+        return -1;
+    }
+#endif
+    /* the same as what libuv does */
+    request->request.sqe.open_flags = flags | O_CLOEXEC;
+    request->request.sqe.len = mode;
+
+    return cat_fs_io_uring_do(request, "open");
+}
+
+static cat_always_inline int64_t cat_fs_io_uring_fd(uint8_t opcode, cat_file_t fd, uint32_t fsync_flags, const char *operation)
+{
+    cat_fs_io_uring_request_t *request = cat_fs_io_uring_request_create(opcode, fd, NULL);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(request == NULL)) {
+        return -1;
+    }
+#endif
+    request->request.sqe.fsync_flags = fsync_flags;
+
+    return cat_fs_io_uring_do(request, operation);
+}
+
+/* do it with io_uring if it is available, otherwise go on to do it in thread pool */
+#define CAT_FS_IO_URING_DO(opcode, call) do { \
+    if (cat_fs_io_uring_is_available(opcode)) { \
+        return call; \
+    } \
+} while (0)
+
+#else
+# define CAT_FS_IO_URING_DO(opcode, call)
+#endif /* CAT_HAVE_IO_URING */
+
+CAT_API cat_bool_t cat_fs_module_init(void)
+{
+    CAT_GLOBALS_REGISTER(cat_fs);
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_fs_module_shutdown(void)
+{
+    CAT_GLOBALS_UNREGISTER(cat_fs);
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_fs_runtime_init(void)
+{
+#ifdef CAT_HAVE_IO_URING
+    CAT_FS_G(io_uring_enabled) = cat_env_is_true("CAT_FS_IO_URING", cat_true);
+#else
+    CAT_FS_G(io_uring_enabled) = cat_false;
+#endif
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_fs_runtime_shutdown(void)
+{
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_fs_set_io_uring_enabled(cat_bool_t enabled)
+{
+    cat_bool_t original_enabled = CAT_FS_G(io_uring_enabled);
+
+#ifdef CAT_HAVE_IO_URING
+    CAT_FS_G(io_uring_enabled) = enabled;
+#else
+    (void) enabled;
+#endif
+
+    return original_enabled;
+}
+
 #ifdef CAT_OS_WIN
 # define wrappath(_path, path) \
 char path##buf[(32767/*hard limit*/ + 4/* \\?\ */ + 1/* \0 */)*sizeof(wchar_t)] = {'\\', '\\', '?', '\\'}; \
@@ -415,6 +706,7 @@ static cat_always_inline cat_file_t cat_fs_open_impl(const char *_path, cat_fs_o
 {
     wrappath(_path, path);
 
+    CAT_FS_IO_URING_DO(IORING_OP_OPENAT, (cat_file_t) cat_fs_io_uring_open(path, flags, mode));
     CAT_FS_DO_RESULT(cat_file_t, open, path, flags, mode);
 }
 
@@ -450,6 +742,7 @@ CAT_API cat_file_t cat_fs_open(const char *path, cat_fs_open_flags_t flags, ...)
 
 static cat_always_inline int cat_fs_close_impl(cat_file_t fd)
 {
+    CAT_FS_IO_URING_DO(IORING_OP_CLOSE, (int) cat_fs_io_uring_fd(IORING_OP_CLOSE, fd, 0, "close"));
     CAT_FS_DO_RESULT(int, close, fd);
 }
 
@@ -490,6 +783,7 @@ static void cat_fs_read_cb(cat_data_t *ptr)
 
 static cat_always_inline ssize_t cat_fs_read_impl(cat_file_t fd, void *buf, size_t size)
 {
+    CAT_FS_IO_URING_DO(IORING_OP_READ, (ssize_t) cat_fs_io_uring_rw(IORING_OP_READ, fd, buf, size, (uint64_t) -1, "read"));
     cat_fs_read_data_t *data = (cat_fs_read_data_t *) cat_malloc(sizeof(*data));
 #if CAT_ALLOC_HANDLE_ERRORS
     if (data == NULL) {
@@ -546,6 +840,7 @@ static void cat_fs_write_cb(cat_data_t *ptr)
 
 static cat_always_inline ssize_t cat_fs_write_impl(cat_file_t fd, const void *buf, size_t length)
 {
+    CAT_FS_IO_URING_DO(IORING_OP_WRITE, (ssize_t) cat_fs_io_uring_rw(IORING_OP_WRITE, fd, buf, length, (uint64_t) -1, "write"));
     cat_fs_write_data_t *data = (cat_fs_write_data_t *) cat_malloc(sizeof(*data));
 #if CAT_ALLOC_HANDLE_ERRORS
     if (data == NULL) {
@@ -587,6 +882,7 @@ CAT_API ssize_t cat_fs_write(cat_file_t fd, const void *buffer, size_t length)
 
 static cat_always_inline ssize_t cat_fs_pread_impl(cat_file_t fd, void *buffer, size_t size, off_t offset)
 {
+    CAT_FS_IO_URING_DO(IORING_OP_READ, (ssize_t) cat_fs_io_uring_rw(IORING_OP_READ, fd, buffer, size, (uint64_t) offset, "read"));
     uv_buf_t buf = uv_buf_init((char *) buffer, (unsigned int) size);
 
     CAT_FS_DO_RESULT(ssize_t, read, fd, &buf, 1, offset);
@@ -613,6 +909,7 @@ CAT_API ssize_t cat_fs_pread(cat_file_t fd, void *buffer, size_t size, off_t off
 
 static cat_always_inline ssize_t cat_fs_pwrite_impl(cat_file_t fd, const void *buffer, size_t length, off_t offset)
 {
+    CAT_FS_IO_URING_DO(IORING_OP_WRITE, (ssize_t) cat_fs_io_uring_rw(IORING_OP_WRITE, fd, buffer, length, (uint64_t) offset, "write"));
     uv_buf_t buf = uv_buf_init((char *) buffer, (unsigned int) length);
 
     CAT_FS_DO_RESULT(ssize_t, write, fd, &buf, 1, offset);
@@ -687,6 +984,7 @@ CAT_API off_t cat_fs_lseek(cat_file_t fd, off_t offset, int whence)
 
 static cat_always_inline int cat_fs_fsync_impl(cat_file_t fd)
 {
+    CAT_FS_IO_URING_DO(IORING_OP_FSYNC, (int) cat_fs_io_uring_fd(IORING_OP_FSYNC, fd, 0, "fsync"));
     CAT_FS_DO_RESULT(int, fsync, fd);
 }
 
@@ -701,6 +999,7 @@ CAT_API int cat_fs_fsync(cat_file_t fd)
 
 static cat_always_inline int cat_fs_fdatasync_impl(cat_file_t fd)
 {
+    CAT_FS_IO_URING_DO(IORING_OP_FSYNC, (int) cat_fs_io_uring_fd(IORING_OP_FSYNC, fd, IORING_FSYNC_DATASYNC, "fdatasync"));
     CAT_FS_DO_RESULT(int, fdatasync, fd);
 }
 
@@ -911,6 +1210,7 @@ CAT_API int cat_fs_access(const char *path, int mode)
 static cat_always_inline int cat_fs_stat_impl(const char *_path, cat_stat_t *statbuf)
 {
     wrappath(_path, path);
+    CAT_FS_IO_URING_DO(IORING_OP_STATX, cat_fs_io_uring_stat(AT_FDCWD, path, 0, statbuf, "stat"));
     CAT_FS_DO_STAT(stat, path);
 }
 
@@ -927,6 +1227,7 @@ CAT_API int cat_fs_stat(const char *path, cat_stat_t *statbuf)
 static cat_always_inline int cat_fs_lstat_impl(const char *_path, cat_stat_t *statbuf)
 {
     wrappath(_path, path);
+    CAT_FS_IO_URING_DO(IORING_OP_STATX, cat_fs_io_uring_stat(AT_FDCWD, path, AT_SYMLINK_NOFOLLOW, statbuf, "lstat"));
     CAT_FS_DO_STAT(lstat, path);
 }
 
@@ -942,6 +1243,7 @@ CAT_API int cat_fs_lstat(const char *path, cat_stat_t *statbuf)
 
 static cat_always_inline int cat_fs_fstat_impl(cat_file_t fd, cat_stat_t *statbuf)
 {
+    CAT_FS_IO_URING_DO(IORING_OP_STATX, cat_fs_io_uring_stat(fd, "", AT_EMPTY_PATH, statbuf, "fstat"));
     CAT_FS_DO_STAT(fstat, fd);
 }
 
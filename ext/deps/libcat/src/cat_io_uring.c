@@ -0,0 +1,788 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "cat_io_uring.h"
+#include "cat_event.h"
+#include "cat_env.h"
+
+#ifdef CAT_HAVE_IO_URING
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#ifdef CAT_IDE_HELPER
+#include "uv-common.h"
+#else
+#include "../deps/libuv/src/uv-common.h"
+#endif
+#endif
+
+CAT_API CAT_GLOBALS_DECLARE(cat_io_uring);
+
+#ifdef CAT_HAVE_IO_URING
+
+struct cat_io_uring_s {
+    int fd;
+    int event_fd;
+    uint32_t features;
+    uint64_t ops;
+    unsigned int entries;
+    /* SQ */
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int *sq_mask;
+    unsigned int *sq_flags;
+    unsigned int *sq_array;
+    struct io_uring_sqe *sqes;
+    /* CQ */
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    struct io_uring_cqe *cqes;
+    /* mappings */
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    /* requests which are waiting to be submitted in prepare phase */
+    cat_queue_t pending;
+    size_t pending_count;
+    /* requests which have been submitted, ring holds references of them until the last CQE */
+    cat_queue_t inflight;
+    size_t inflight_count;
+    /* registered provided buffer rings */
+    cat_queue_t buffer_rings;
+    uv_prepare_t prepare;
+    uv_poll_t poll;
+    unsigned int closing;
+    /* stats */
+    uint64_t enters;
+    uint64_t submissions;
+    uint64_t completions;
+    size_t max_batch;
+    uint64_t recv_multishot;
+    uint64_t accept_multishot;
+    uint64_t send_zc;
+};
+
+typedef struct cat_io_uring_cancel_request_s {
+    cat_io_uring_request_t request;
+    /* request which is canceled by this request */
+    cat_io_uring_request_t *target;
+} cat_io_uring_cancel_request_t;
+
+static cat_always_inline int cat_io_uring_setup(unsigned int entries, struct io_uring_params *params)
+{
+    return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+static cat_always_inline int cat_io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+{
+    return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static cat_always_inline int cat_io_uring_register(int fd, unsigned int opcode, const void *arg, unsigned int nr_args)
+{
+    return (int) syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void cat_io_uring_unmap(cat_io_uring_t *ring)
+{
+    if (ring->sqes != NULL) {
+        (void) munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring) {
+        (void) munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring != NULL) {
+        (void) munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+}
+
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+static void cat_io_uring_buffer_ring_free(cat_io_uring_buffer_ring_t *buffer_ring)
+{
+    (void) munmap(buffer_ring->ring, buffer_ring->ring_size);
+    cat_free(buffer_ring);
+}
+#endif
+
+static void cat_io_uring_free(cat_io_uring_t *ring)
+{
+    cat_io_uring_unmap(ring);
+    if (ring->event_fd != -1) {
+        (void) close(ring->event_fd);
+    }
+    if (ring->fd != -1) {
+        (void) close(ring->fd);
+    }
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    do {
+        cat_io_uring_buffer_ring_t *buffer_ring;
+        /* they are unregistered by kernel when io_uring is closed */
+        while ((buffer_ring = cat_queue_front_data(&ring->buffer_rings, cat_io_uring_buffer_ring_t, node)) != NULL) {
+            cat_queue_remove(&buffer_ring->node);
+            cat_io_uring_buffer_ring_free(buffer_ring);
+        }
+    } while (0);
+#endif
+    cat_free(ring);
+}
+
+static void cat_io_uring_poll_callback(uv_poll_t *poll, int status, int events);
+
+static cat_io_uring_t *cat_io_uring_create(unsigned int entries)
+{
+    cat_io_uring_t *ring;
+    struct io_uring_params params;
+    struct io_uring_probe *probe;
+    size_t probe_size;
+    char *sq_ring, *cq_ring;
+    unsigned int n;
+    int error;
+
+    ring = (cat_io_uring_t *) cat_malloc(sizeof(*ring));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(ring == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for io_uring failed");
+        return NULL;
+    }
+#endif
+    memset(ring, 0, sizeof(*ring));
+    ring->event_fd = -1;
+    cat_queue_init(&ring->buffer_rings);
+
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 2;
+    ring->fd = cat_io_uring_setup(entries, &params);
+    if (unlikely(ring->fd < 0)) {
+        cat_update_last_error_of_syscall("io_uring setup failed");
+        goto _error;
+    }
+    /* CQEs are never dropped, they are kept in overflow list when CQ is full (it was introduced in 5.5) */
+    if (unlikely(!(params.features & IORING_FEAT_NODROP))) {
+        cat_update_last_error(CAT_ENOTSUP, "io_uring is too old");
+        goto _error;
+    }
+    ring->features = params.features;
+    ring->entries = params.sq_entries;
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->sq_ring_size = ring->cq_ring_size = CAT_MAX(ring->sq_ring_size, ring->cq_ring_size);
+    }
+    sq_ring = (char *) mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (unlikely(sq_ring == MAP_FAILED)) {
+        cat_update_last_error_of_syscall("io_uring mmap SQ failed");
+        goto _error;
+    }
+    ring->sq_ring = sq_ring;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ring = sq_ring;
+    } else {
+        cq_ring = (char *) mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (unlikely(cq_ring == MAP_FAILED)) {
+            cat_update_last_error_of_syscall("io_uring mmap CQ failed");
+            goto _error;
+        }
+    }
+    ring->cq_ring = cq_ring;
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *) mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (unlikely(ring->sqes == MAP_FAILED)) {
+        ring->sqes = NULL;
+        cat_update_last_error_of_syscall("io_uring mmap SQEs failed");
+        goto _error;
+    }
+    ring->sq_head = (unsigned int *) (sq_ring + params.sq_off.head);
+    ring->sq_tail = (unsigned int *) (sq_ring + params.sq_off.tail);
+    ring->sq_mask = (unsigned int *) (sq_ring + params.sq_off.ring_mask);
+    ring->sq_flags = (unsigned int *) (sq_ring + params.sq_off.flags);
+    ring->sq_array = (unsigned int *) (sq_ring + params.sq_off.array);
+    ring->cq_head = (unsigned int *) (cq_ring + params.cq_off.head);
+    ring->cq_tail = (unsigned int *) (cq_ring + params.cq_off.tail);
+    ring->cq_mask = (unsigned int *) (cq_ring + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq_ring + params.cq_off.cqes);
+
+    /* find out which operations are supported (it was introduced in 5.6,
+     * as well as reading/writing at current file position) */
+    probe_size = sizeof(*probe) + 256 * sizeof(struct io_uring_probe_op);
+    probe = (struct io_uring_probe *) cat_malloc(probe_size);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(probe == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for io_uring probe failed");
+        goto _error;
+    }
+#endif
+    memset(probe, 0, probe_size);
+    if (unlikely(cat_io_uring_register(ring->fd, IORING_REGISTER_PROBE, probe, 256) < 0)) {
+        cat_update_last_error_of_syscall("io_uring probe failed");
+        cat_free(probe);
+        goto _error;
+    }
+    for (n = 0; n < probe->ops_len && n < 64; n++) {
+        if (probe->ops[n].flags & IO_URING_OP_SUPPORTED) {
+            ring->ops |= ((uint64_t) 1) << probe->ops[n].op;
+        }
+    }
+    cat_free(probe);
+
+    /* completions are harvested when eventfd becomes readable in event loop */
+    ring->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (unlikely(ring->event_fd < 0)) {
+        cat_update_last_error_of_syscall("io_uring create eventfd failed");
+        goto _error;
+    }
+    if (unlikely(cat_io_uring_register(ring->fd, IORING_REGISTER_EVENTFD, &ring->event_fd, 1) < 0)) {
+        cat_update_last_error_of_syscall("io_uring register eventfd failed");
+        goto _error;
+    }
+    error = uv_poll_init(&CAT_EVENT_G(loop), &ring->poll, ring->event_fd);
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "io_uring poll init failed");
+        goto _error;
+    }
+    (void) uv_poll_start(&ring->poll, UV_READABLE, cat_io_uring_poll_callback);
+    /* it only keeps loop alive when there are requests in flight */
+    uv_unref((uv_handle_t *) &ring->poll);
+    ring->poll.flags |= UV_HANDLE_INTERNAL;
+    (void) uv_prepare_init(&CAT_EVENT_G(loop), &ring->prepare);
+    ring->prepare.flags |= UV_HANDLE_INTERNAL;
+
+    cat_queue_init(&ring->pending);
+    cat_queue_init(&ring->inflight);
+
+    return ring;
+
+    _error:
+    cat_io_uring_free(ring);
+    return NULL;
+}
+
+static void cat_io_uring_close_callback(uv_handle_t *handle)
+{
+    cat_io_uring_t *ring = (cat_io_uring_t *) handle->data;
+
+    if (--ring->closing == 0) {
+        cat_io_uring_free(ring);
+    }
+}
+
+static void cat_io_uring_detach_requests(cat_queue_t *queue)
+{
+    cat_io_uring_request_t *request;
+
+    /* callbacks will never be called, owners see that they are not in flight anymore */
+    while ((request = cat_queue_front_data(queue, cat_io_uring_request_t, node)) != NULL) {
+        cat_queue_remove(&request->node);
+        request->state = CAT_IO_URING_REQUEST_STATE_NONE;
+        cat_io_uring_request_release(request);
+    }
+}
+
+static void cat_io_uring_close(cat_io_uring_t *ring)
+{
+    cat_io_uring_detach_requests(&ring->pending);
+    cat_io_uring_detach_requests(&ring->inflight);
+    ring->pending_count = 0;
+    ring->inflight_count = 0;
+    ring->poll.data = ring;
+    ring->prepare.data = ring;
+    ring->closing = 2;
+    uv_close((uv_handle_t *) &ring->poll, cat_io_uring_close_callback);
+    uv_close((uv_handle_t *) &ring->prepare, cat_io_uring_close_callback);
+}
+
+static cat_always_inline cat_io_uring_t *cat_io_uring_get(void)
+{
+    cat_io_uring_t *ring = CAT_IO_URING_G(ring);
+
+    if (unlikely(ring == NULL)) {
+        if (CAT_IO_URING_G(unavailable)) {
+            return NULL;
+        }
+        ring = cat_io_uring_create(CAT_IO_URING_G(entries));
+        if (unlikely(ring == NULL)) {
+            CAT_LOG_DEBUG(IO_URING, "io_uring is unavailable (%s)", cat_get_last_error_message());
+            CAT_IO_URING_G(unavailable) = cat_true;
+            return NULL;
+        }
+        CAT_IO_URING_G(ring) = ring;
+    }
+
+    return ring;
+}
+
+CAT_API cat_bool_t cat_io_uring_is_available(uint8_t opcode)
+{
+    cat_io_uring_t *ring = cat_io_uring_get();
+
+    if (unlikely(ring == NULL)) {
+        return cat_false;
+    }
+
+    return opcode < 64 && (ring->ops & (((uint64_t) 1) << opcode));
+}
+
+CAT_API cat_io_uring_request_t *cat_io_uring_request_create(size_t size, uint8_t opcode, int fd, cat_io_uring_callback_t callback)
+{
+    cat_io_uring_request_t *request;
+
+    CAT_ASSERT(size >= sizeof(*request));
+    request = (cat_io_uring_request_t *) cat_malloc(size);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(request == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for io_uring request failed");
+        return NULL;
+    }
+#endif
+    memset(request, 0, size);
+    request->callback = callback;
+    request->refcount = 1;
+    request->state = CAT_IO_URING_REQUEST_STATE_NONE;
+    request->sqe.opcode = opcode;
+    request->sqe.fd = fd;
+
+    return request;
+}
+
+CAT_API void cat_io_uring_request_release(cat_io_uring_request_t *request)
+{
+    if (--request->refcount == 0) {
+        cat_free(request);
+    }
+}
+
+static void cat_io_uring_prepare_callback(uv_prepare_t *prepare);
+
+CAT_API cat_bool_t cat_io_uring_submit(cat_io_uring_request_t *request)
+{
+    cat_io_uring_t *ring = cat_io_uring_get();
+
+    CAT_ASSERT(request->state == CAT_IO_URING_REQUEST_STATE_NONE);
+    if (unlikely(ring == NULL)) {
+        cat_update_last_error(CAT_ENOTSUP, "io_uring is unavailable");
+        return cat_false;
+    }
+    request->refcount++;
+    request->state = CAT_IO_URING_REQUEST_STATE_PENDING;
+    cat_queue_push_back(&ring->pending, &request->node);
+    if (ring->pending_count++ == 0) {
+        (void) uv_prepare_start(&ring->prepare, cat_io_uring_prepare_callback);
+    }
+
+    return cat_true;
+}
+
+static cat_always_inline void cat_io_uring_count_opcode(cat_io_uring_t *ring, const struct io_uring_sqe *sqe)
+{
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    switch (sqe->opcode) {
+        case IORING_OP_RECV:
+            if (sqe->ioprio & IORING_RECV_MULTISHOT) {
+                ring->recv_multishot++;
+            }
+            break;
+        case IORING_OP_ACCEPT:
+            if (sqe->ioprio & IORING_ACCEPT_MULTISHOT) {
+                ring->accept_multishot++;
+            }
+            break;
+        case IORING_OP_SEND_ZC:
+        case IORING_OP_SENDMSG_ZC:
+            ring->send_zc++;
+            break;
+        default:
+            break;
+    }
+#else
+    (void) ring;
+    (void) sqe;
+#endif
+}
+
+/* copy pending requests to SQ and submit them with one syscall (or more if SQ is full) */
+static void cat_io_uring_submit_pending(cat_io_uring_t *ring)
+{
+    while (1) {
+        const unsigned int mask = *ring->sq_mask;
+        unsigned int head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        unsigned int tail = *ring->sq_tail;
+        cat_io_uring_request_t *request;
+        int n;
+
+        while (tail - head < ring->entries &&
+            (request = cat_queue_front_data(&ring->pending, cat_io_uring_request_t, node)) != NULL) {
+            unsigned int index = tail & mask;
+            cat_queue_remove(&request->node);
+            ring->pending_count--;
+            ring->sqes[index] = request->sqe;
+            ring->sqes[index].user_data = (uint64_t) (uintptr_t) request;
+            ring->sq_array[index] = index;
+            request->state = CAT_IO_URING_REQUEST_STATE_INFLIGHT;
+            cat_queue_push_back(&ring->inflight, &request->node);
+            ring->inflight_count++;
+            cat_io_uring_count_opcode(ring, &request->sqe);
+            tail++;
+        }
+        __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+        if (tail == head) {
+            break;
+        }
+        n = cat_io_uring_enter(ring->fd, tail - head, 0, 0);
+        ring->enters++;
+        if (unlikely(n < 0)) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* EAGAIN/EBUSY: kernel is out of resources or CQ overflowed,
+             * SQEs are still in SQ and we will retry in the next round */
+            if (errno != EAGAIN && errno != EBUSY) {
+                CAT_WARN_WITH_REASON(IO_URING, cat_translate_sys_error(errno), "io_uring submit failed");
+            }
+            break;
+        }
+        ring->submissions += n;
+        if ((size_t) n > ring->max_batch) {
+            ring->max_batch = n;
+        }
+        if (n == 0 || ring->pending_count == 0) {
+            break;
+        }
+    }
+    if (ring->pending_count == 0 && *ring->sq_tail == __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE)) {
+        (void) uv_prepare_stop(&ring->prepare);
+    }
+    if (ring->inflight_count > 0) {
+        uv_ref((uv_handle_t *) &ring->poll);
+    }
+}
+
+static void cat_io_uring_prepare_callback(uv_prepare_t *prepare)
+{
+    cat_io_uring_t *ring = cat_container_of(prepare, cat_io_uring_t, prepare);
+
+    cat_io_uring_submit_pending(ring);
+}
+
+static void cat_io_uring_complete(cat_io_uring_t *ring, cat_io_uring_request_t *request, int32_t result, uint32_t flags)
+{
+    ring->completions++;
+    if (flags & IORING_CQE_F_MORE) {
+        request->callback(request, result, flags);
+        return;
+    }
+    cat_queue_remove(&request->node);
+    ring->inflight_count--;
+    request->state = CAT_IO_URING_REQUEST_STATE_NONE;
+    /* coroutine may be resumed here, and it may issue new requests */
+    request->callback(request, result, flags);
+    cat_io_uring_request_release(request);
+}
+
+static void cat_io_uring_poll_callback(uv_poll_t *poll, int status, int events)
+{
+    cat_io_uring_t *ring = cat_container_of(poll, cat_io_uring_t, poll);
+    uint64_t value;
+    (void) status;
+    (void) events;
+
+    (void) read(ring->event_fd, &value, sizeof(value));
+    while (1) {
+        unsigned int head = *ring->cq_head;
+        struct io_uring_cqe *cqe;
+        cat_io_uring_request_t *request;
+        int32_t result;
+        uint32_t flags;
+        if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+            /* flush CQEs which were kept in overflow list when CQ was full */
+            if (unlikely(__atomic_load_n(ring->sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW)) {
+                ring->enters++;
+                if (cat_io_uring_enter(ring->fd, 0, 0, IORING_ENTER_GETEVENTS) == 0 &&
+                    head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+                    continue;
+                }
+            }
+            break;
+        }
+        cqe = &ring->cqes[head & *ring->cq_mask];
+        request = (cat_io_uring_request_t *) (uintptr_t) cqe->user_data;
+        result = cqe->res;
+        flags = cqe->flags;
+        __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+        cat_io_uring_complete(ring, request, result, flags);
+        /* ring may be closed in callback (e.g. fork) */
+        if (unlikely(CAT_IO_URING_G(ring) != ring)) {
+            return;
+        }
+    }
+    if (ring->inflight_count == 0) {
+        uv_unref((uv_handle_t *) &ring->poll);
+    }
+}
+
+CAT_API void cat_io_uring_reap(void)
+{
+    cat_io_uring_t *ring = CAT_IO_URING_G(ring);
+
+    if (ring == NULL || ring->inflight_count == 0) {
+        return;
+    }
+    if (*ring->cq_head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        /* completions may be posted by task work which runs when we enter the kernel */
+        ring->enters++;
+        (void) cat_io_uring_enter(ring->fd, 0, 0, IORING_ENTER_GETEVENTS);
+    }
+    cat_io_uring_poll_callback(&ring->poll, 0, UV_READABLE);
+}
+
+static void cat_io_uring_cancel_callback(cat_io_uring_request_t *request, int32_t result, uint32_t flags)
+{
+    cat_io_uring_cancel_request_t *cancel_request = (cat_io_uring_cancel_request_t *) request;
+    (void) result;
+    (void) flags;
+
+    cat_io_uring_request_release(cancel_request->target);
+}
+
+CAT_API void cat_io_uring_cancel(cat_io_uring_request_t *request)
+{
+    cat_io_uring_t *ring = CAT_IO_URING_G(ring);
+    cat_io_uring_cancel_request_t *cancel_request;
+
+    if (request->state == CAT_IO_URING_REQUEST_STATE_NONE) {
+        return;
+    }
+    CAT_ASSERT(ring != NULL);
+    if (request->state == CAT_IO_URING_REQUEST_STATE_PENDING) {
+        cat_queue_remove(&request->node);
+        request->state = CAT_IO_URING_REQUEST_STATE_NONE;
+        if (--ring->pending_count == 0) {
+            (void) uv_prepare_stop(&ring->prepare);
+        }
+        cat_io_uring_request_release(request);
+        return;
+    }
+    if (!(ring->ops & (((uint64_t) 1) << IORING_OP_ASYNC_CANCEL))) {
+        return;
+    }
+    /* target will be freed after both of them are completed */
+    cancel_request = (cat_io_uring_cancel_request_t *) cat_io_uring_request_create(
+        sizeof(*cancel_request), IORING_OP_ASYNC_CANCEL, -1, cat_io_uring_cancel_callback
+    );
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(cancel_request == NULL)) {
+        return;
+    }
+#endif
+    request->refcount++;
+    cancel_request->target = request;
+    cancel_request->request.sqe.addr = (uint64_t) (uintptr_t) request;
+    (void) cat_io_uring_submit(&cancel_request->request);
+    cat_io_uring_request_release(&cancel_request->request);
+}
+
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+CAT_API cat_io_uring_buffer_ring_t *cat_io_uring_get_buffer_ring(uint16_t group_id, unsigned int count, size_t buffer_size)
+{
+    cat_io_uring_t *ring = cat_io_uring_get();
+    cat_io_uring_buffer_ring_t *buffer_ring;
+    struct io_uring_buf_reg reg;
+    size_t ring_size;
+    unsigned int n;
+    void *memory;
+
+    if (unlikely(ring == NULL)) {
+        return NULL;
+    }
+    CAT_QUEUE_FOREACH_DATA_START(&ring->buffer_rings, cat_io_uring_buffer_ring_t, node, buffer_ring) {
+        if (buffer_ring->group_id == group_id) {
+            return buffer_ring;
+        }
+    } CAT_QUEUE_FOREACH_DATA_END();
+
+    CAT_ASSERT(count > 0 && (count & (count - 1)) == 0 && count <= 32768);
+    /* ring entries and buffers are in the same mapping, ring must be page aligned */
+    ring_size = cat_getpagesize();
+    ring_size = CAT_MEMORY_ALIGNED_SIZE_EX(count * sizeof(struct io_uring_buf), ring_size) + count * buffer_size;
+    memory = mmap(NULL, ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (unlikely(memory == MAP_FAILED)) {
+        cat_update_last_error_of_syscall("io_uring mmap buffer ring failed");
+        return NULL;
+    }
+    buffer_ring = (cat_io_uring_buffer_ring_t *) cat_malloc(sizeof(*buffer_ring));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(buffer_ring == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for io_uring buffer ring failed");
+        (void) munmap(memory, ring_size);
+        return NULL;
+    }
+#endif
+    buffer_ring->ring = (struct io_uring_buf_ring *) memory;
+    buffer_ring->ring_size = ring_size;
+    buffer_ring->buffers = (char *) memory + CAT_MEMORY_ALIGNED_SIZE_EX(count * sizeof(struct io_uring_buf), cat_getpagesize());
+    buffer_ring->buffer_size = buffer_size;
+    buffer_ring->count = count;
+    buffer_ring->group_id = group_id;
+    buffer_ring->tail = 0;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t) (uintptr_t) memory;
+    reg.ring_entries = count;
+    reg.bgid = group_id;
+    if (unlikely(cat_io_uring_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)) {
+        cat_update_last_error_of_syscall("io_uring register buffer ring failed");
+        cat_io_uring_buffer_ring_free(buffer_ring);
+        return NULL;
+    }
+    for (n = 0; n < count; n++) {
+        struct io_uring_buf *buffer = &buffer_ring->ring->bufs[n];
+        buffer->addr = (uint64_t) (uintptr_t) (buffer_ring->buffers + n * buffer_size);
+        buffer->len = (uint32_t) buffer_size;
+        buffer->bid = (uint16_t) n;
+    }
+    buffer_ring->tail = (uint16_t) count;
+    __atomic_store_n(&buffer_ring->ring->tail, buffer_ring->tail, __ATOMIC_RELEASE);
+    cat_queue_push_back(&ring->buffer_rings, &buffer_ring->node);
+
+    return buffer_ring;
+}
+
+CAT_API char *cat_io_uring_buffer_ring_get_buffer(const cat_io_uring_buffer_ring_t *buffer_ring, uint16_t buffer_id)
+{
+    return buffer_ring->buffers + buffer_id * buffer_ring->buffer_size;
+}
+
+CAT_API void cat_io_uring_buffer_ring_recycle(cat_io_uring_buffer_ring_t *buffer_ring, uint16_t buffer_id)
+{
+    struct io_uring_buf *buffer = &buffer_ring->ring->bufs[buffer_ring->tail & (buffer_ring->count - 1)];
+
+    buffer->addr = (uint64_t) (uintptr_t) cat_io_uring_buffer_ring_get_buffer(buffer_ring, buffer_id);
+    buffer->len = (uint32_t) buffer_ring->buffer_size;
+    buffer->bid = buffer_id;
+    buffer_ring->tail++;
+    __atomic_store_n(&buffer_ring->ring->tail, buffer_ring->tail, __ATOMIC_RELEASE);
+}
+#endif
+
+#endif /* CAT_HAVE_IO_URING */
+
+CAT_API cat_bool_t cat_io_uring_module_init(void)
+{
+    CAT_GLOBALS_REGISTER(cat_io_uring);
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_io_uring_module_shutdown(void)
+{
+    CAT_GLOBALS_UNREGISTER(cat_io_uring);
+    return cat_true;
+}
+
+static void cat_io_uring_runtime_shutdown_callback(cat_data_t *data)
+{
+    (void) data;
+    (void) cat_io_uring_runtime_shutdown();
+}
+
+CAT_API cat_bool_t cat_io_uring_runtime_init(void)
+{
+    long entries;
+
+    entries = cat_env_get_i("CAT_IO_URING_ENTRIES", CAT_IO_URING_DEFAULT_ENTRIES);
+    if (entries < 1) {
+        entries = 1;
+    } else if (entries > CAT_IO_URING_MAX_ENTRIES) {
+        entries = CAT_IO_URING_MAX_ENTRIES;
+    }
+    CAT_IO_URING_G(entries) = (unsigned int) entries;
+    CAT_IO_URING_G(ring) = NULL;
+#ifdef CAT_HAVE_IO_URING
+    CAT_IO_URING_G(unavailable) = cat_false;
+#else
+    CAT_IO_URING_G(unavailable) = cat_true;
+#endif
+
+    if (unlikely(cat_event_register_runtime_shutdown_task(cat_io_uring_runtime_shutdown_callback, NULL) == NULL)) {
+        cat_update_last_error_with_previous("io_uring register runtime shutdown task failed");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_io_uring_runtime_shutdown(void)
+{
+#ifdef CAT_HAVE_IO_URING
+    cat_io_uring_t *ring = CAT_IO_URING_G(ring);
+
+    if (ring == NULL) {
+        return cat_true;
+    }
+    CAT_IO_URING_G(ring) = NULL;
+    CAT_IO_URING_G(unavailable) = cat_true;
+    /* there should be no waiters now, kernel cancels in-flight requests when io_uring is closed */
+    cat_io_uring_close(ring);
+#endif
+
+    return cat_true;
+}
+
+CAT_API void cat_io_uring_fork(void)
+{
+#ifdef CAT_HAVE_IO_URING
+    cat_io_uring_t *ring = CAT_IO_URING_G(ring);
+
+    if (ring == NULL) {
+        return;
+    }
+    /* requests of parent are left as they are (like thread pool does),
+     * and new requests in child fall back to the other ways */
+    CAT_IO_URING_G(ring) = NULL;
+    CAT_IO_URING_G(unavailable) = cat_true;
+    cat_io_uring_close(ring);
+#endif
+}
+
+CAT_API cat_bool_t cat_io_uring_get_stats(cat_io_uring_stats_t *stats)
+{
+#ifdef CAT_HAVE_IO_URING
+    cat_io_uring_t *ring = CAT_IO_URING_G(ring);
+#endif
+
+    memset(stats, 0, sizeof(*stats));
+#ifdef CAT_HAVE_IO_URING
+    stats->available = !CAT_IO_URING_G(unavailable);
+    if (ring != NULL) {
+        stats->running = cat_true;
+        stats->entries = ring->entries;
+        stats->pending = ring->pending_count;
+        stats->inflight = ring->inflight_count;
+        stats->enters = ring->enters;
+        stats->submissions = ring->submissions;
+        stats->completions = ring->completions;
+        stats->max_batch = ring->max_batch;
+        stats->recv_multishot = ring->recv_multishot;
+        stats->accept_multishot = ring->accept_multishot;
+        stats->send_zc = ring->send_zc;
+    }
+#endif
+
+    return cat_true;
+}
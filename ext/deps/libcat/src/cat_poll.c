@@ -232,6 +232,51 @@ static void cat_poll_one_callback(uv_poll_t* handle, int status, uv_events_t eve
     }
 }
 
+static cat_ret_t cat_poll_one_translate_result(
+    cat_ret_t ret, int status, uv_events_t uv_events,
+    cat_pollfd_events_t events, cat_pollfd_events_t *revents)
+{
+    switch (ret) {
+        /* delay canceled */
+        case CAT_RET_NONE: {
+            if (unlikely(status < 0)) {
+                if (status == CAT_ECANCELED) {
+                    cat_update_last_error(CAT_ECANCELED, "Poll has been canceled");
+                    ret = CAT_RET_ERROR;
+                }
+#ifndef CAT_OS_WIN
+                else if (status == CAT_EBADF) {
+                    /* see: https://github.com/libuv/libuv/pull/1040#discussion_r80087447 */
+                    *revents = POLLERR;
+                    ret = CAT_RET_OK;
+                }
+#endif
+                else {
+                    cat_update_last_error_with_reason(status, "Poll failed");
+                    *revents = cat_poll_translate_error_to_sys_events(events, status);
+                    ret = CAT_RET_ERROR;
+                }
+            } else {
+                ret = CAT_RET_OK;
+                *revents = cat_poll_translate_uv_events_to_sys_events(uv_events);
+            }
+            break;
+        }
+        /* timedout */
+        case CAT_RET_OK:
+            ret = CAT_RET_NONE;
+            break;
+        /* error */
+        case CAT_RET_ERROR:
+            cat_update_last_error_with_previous("Poll wait failed");
+            break;
+        default:
+            CAT_NEVER_HERE("Impossible");
+    }
+
+    return ret;
+}
+
 #define CAT_POLL_ONE_EMULATE(fd, events, revents) do { \
     if (cat_poll_one_emulate != NULL) { \
         cat_ret_t ret = cat_poll_one_emulate(fd, events, revents); \
@@ -307,45 +352,7 @@ static cat_ret_t cat_poll_one_impl(cat_os_socket_t fd, cat_pollfd_events_t event
     }
 #endif
 
-    switch (ret) {
-        /* delay canceled */
-        case CAT_RET_NONE: {
-            if (unlikely(poll->ret.status < 0)) {
-                if (poll->ret.status == CAT_ECANCELED) {
-                    cat_update_last_error(CAT_ECANCELED, "Poll has been canceled");
-                    ret = CAT_RET_ERROR;
-                }
-#ifndef CAT_OS_WIN
-                else if (poll->ret.status == CAT_EBADF) {
-                    /* see: https://github.com/libuv/libuv/pull/1040#discussion_r80087447 */
-                    *revents = POLLERR;
-                    ret = CAT_RET_OK;
-                }
-#endif
-                else {
-                    cat_update_last_error_with_reason(poll->ret.status, "Poll failed");
-                    *revents = cat_poll_translate_error_to_sys_events(events, poll->ret.status);
-                    ret = CAT_RET_ERROR;
-                }
-            } else {
-                ret = CAT_RET_OK;
-                *revents = cat_poll_translate_uv_events_to_sys_events(poll->ret.events);
-            }
-            break;
-        }
-        /* timedout */
-        case CAT_RET_OK:
-            ret = CAT_RET_NONE;
-            break;
-        /* error */
-        case CAT_RET_ERROR:
-            cat_update_last_error_with_previous("Poll wait failed");
-            break;
-        default:
-            CAT_NEVER_HERE("Impossible");
-    }
-
-    return ret;
+    return cat_poll_one_translate_result(ret, poll->ret.status, poll->ret.events, events, revents);
 }
 
 CAT_API cat_ret_t cat_poll_one(cat_os_socket_t fd, cat_pollfd_events_t events, cat_pollfd_events_t *revents, cat_timeout_t timeout)
@@ -399,6 +406,8 @@ typedef struct {
 #ifdef CAT_OS_UNIX_LIKE
     cat_os_fd_t fd_dup;
 #endif
+    /* registered watcher, handle is not used if it is not NULL */
+    cat_poll_watcher_t *watcher;
 } cat_poll_t;
 
 static void cat_poll_close_callback(uv_handle_t *handle)
@@ -456,6 +465,249 @@ static void cat_poll_callback(uv_poll_t* handle, int status, uv_events_t events)
     }
 }
 
+/* poll watcher */
+
+struct cat_poll_watcher_s {
+    union {
+        uv_handle_t handle;
+        uv_poll_t poll;
+    } u;
+    cat_os_socket_t fd;
+#ifdef CAT_OS_UNIX_LIKE
+    cat_os_fd_t fd_dup;
+#endif
+    /* events which are being watched */
+    uv_events_t events;
+    /* context of the waiting coroutine, NULL if nobody is waiting */
+    cat_poll_context_t *context;
+    struct {
+        int status; // uv status
+        uv_events_t events; // uv events, e.g UV_EVENT_READABLE, UV_EVENT_WRITABLE...
+    } ret;
+    cat_bool_t closing;
+};
+
+static void cat_poll_watcher_callback(uv_poll_t* handle, int status, uv_events_t events)
+{
+    cat_poll_watcher_t *watcher = cat_container_of(handle, cat_poll_watcher_t, u.poll);
+    cat_poll_context_t *context = watcher->context;
+
+    CAT_LOG_DEBUG_VA_WITH_LEVEL(POLL, 2, {
+        char *events_str = cat_poll_uv_events_str(events);
+        CAT_LOG_DEBUG_D(POLL, "poll_watcher_callback(fd: " CAT_OS_SOCKET_FMT ", status: %d" CAT_LOG_STRERRNO_FMT ", events: %s, waiting: %s)",
+            watcher->fd, status, CAT_LOG_STRERRNO_C(status == 0, status), events_str, context != NULL ? "yes" : "no");
+        cat_buffer_str_free(events_str);
+    });
+
+    if (unlikely(status < 0)) {
+        /* handle has been stopped by libuv */
+        watcher->events = UV_EVENT_NONE;
+    }
+    if (context == NULL) {
+        /* nobody is waiting for it, stop watching until the next wait,
+         * otherwise level-triggered events would keep coming */
+        if (watcher->events != UV_EVENT_NONE) {
+            (void) uv_poll_stop(handle);
+            watcher->events = UV_EVENT_NONE;
+        }
+        return;
+    }
+
+    watcher->ret.status = status;
+    /* Note: uv may return multi events in multi callbacks */
+    watcher->ret.events |= events;
+
+    if (context->done_task == NULL) {
+        context->done_task = cat_event_io_defer_task_create(cat_poll_done_callback, context);
+    }
+}
+
+static int cat_poll_watcher_start(cat_poll_watcher_t *watcher, uv_events_t events)
+{
+    int error;
+
+    if (watcher->events == events) {
+        /* it is still being watched, nothing to do */
+        return 0;
+    }
+    error = uv_poll_start(&watcher->u.poll, events, cat_poll_watcher_callback);
+    if (unlikely(error != 0)) {
+        watcher->events = UV_EVENT_NONE;
+        return error;
+    }
+    watcher->events = events;
+
+    return 0;
+}
+
+static void cat_poll_watcher_attach(cat_poll_watcher_t *watcher, cat_poll_context_t *context)
+{
+    watcher->context = context;
+    watcher->ret.status = CAT_ECANCELED;
+    watcher->ret.events = UV_EVENT_NONE;
+    /* watcher only keeps event loop alive when someone is waiting for it */
+    uv_ref(&watcher->u.handle);
+}
+
+static void cat_poll_watcher_close_handle(cat_poll_watcher_t *watcher);
+
+static void cat_poll_watcher_detach(cat_poll_watcher_t *watcher)
+{
+    watcher->context = NULL;
+    uv_unref(&watcher->u.handle);
+}
+
+static void cat_poll_watcher_close_callback(uv_handle_t *handle)
+{
+    cat_poll_watcher_t *watcher = cat_container_of(handle, cat_poll_watcher_t, u.handle);
+
+#ifdef CAT_OS_UNIX_LIKE
+    uv__close(watcher->fd_dup);
+#endif
+    cat_free(watcher);
+}
+
+static void cat_poll_watcher_close_handle(cat_poll_watcher_t *watcher)
+{
+    uv_close(&watcher->u.handle, cat_poll_watcher_close_callback);
+}
+
+CAT_API cat_poll_watcher_t *cat_poll_watcher_create(cat_os_socket_t fd)
+{
+    cat_poll_watcher_t *watcher;
+    cat_os_socket_t fd_no = fd;
+    int error;
+
+    watcher = (cat_poll_watcher_t *) cat_malloc(sizeof(*watcher));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(watcher == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for poll watcher failed");
+        return NULL;
+    }
+#endif
+#ifdef CAT_OS_UNIX_LIKE
+    /* watch on a duplicated fd, so that it never conflicts with other handles
+     * which are using the same fd, and it is not affected by reusing of fd number */
+    watcher->fd_dup = dup(fd);
+    if (unlikely(watcher->fd_dup == CAT_OS_INVALID_FD)) {
+        cat_update_last_error_of_syscall("Dup for poll watcher failed");
+        cat_free(watcher);
+        return NULL;
+    }
+    fd_no = watcher->fd_dup;
+#endif
+    error = uv_poll_init_socket(&CAT_EVENT_G(loop), &watcher->u.poll, fd_no);
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "Poll watcher init failed");
+#ifdef CAT_OS_UNIX_LIKE
+        uv__close(watcher->fd_dup);
+#endif
+        cat_free(watcher);
+        return NULL;
+    }
+    uv_unref(&watcher->u.handle);
+    watcher->fd = fd;
+    watcher->events = UV_EVENT_NONE;
+    watcher->context = NULL;
+    watcher->ret.status = 0;
+    watcher->ret.events = UV_EVENT_NONE;
+    watcher->closing = cat_false;
+
+    CAT_LOG_DEBUG(POLL, "poll_watcher_create(fd: " CAT_OS_SOCKET_FMT ") = %p", fd, watcher);
+
+    return watcher;
+}
+
+CAT_API void cat_poll_watcher_close(cat_poll_watcher_t *watcher)
+{
+    CAT_LOG_DEBUG(POLL, "poll_watcher_close(%p, fd: " CAT_OS_SOCKET_FMT ")", watcher, watcher->fd);
+
+    if (unlikely(watcher->context != NULL)) {
+        /* someone is waiting for it, wake it up and close it after that */
+        cat_poll_context_t *context = watcher->context;
+        watcher->closing = cat_true;
+        watcher->ret.status = CAT_EBADF;
+        if (context->done_task == NULL) {
+            context->done_task = cat_event_io_defer_task_create(cat_poll_done_callback, context);
+        }
+        return;
+    }
+    cat_poll_watcher_close_handle(watcher);
+}
+
+CAT_API cat_os_socket_t cat_poll_watcher_get_fd(const cat_poll_watcher_t *watcher)
+{
+    return watcher->fd;
+}
+
+static cat_ret_t cat_poll_watcher_wait_impl(cat_poll_watcher_t *watcher, cat_pollfd_events_t events, cat_pollfd_events_t *revents, cat_timeout_t timeout)
+{
+    CAT_POLL_ONE_EMULATE(watcher->fd, events, revents);
+    CAT_POLL_CHECK_TIMEOUT(timeout);
+    cat_poll_context_t context;
+    cat_ret_t ret;
+    int error;
+
+    *revents = POLLNONE;
+
+    if (unlikely(watcher->context != NULL || watcher->closing)) {
+        cat_update_last_error(CAT_EBUSY, "Poll watcher is busy");
+        return CAT_RET_ERROR;
+    }
+    error = cat_poll_watcher_start(watcher, cat_poll_translate_sys_events_to_uv_events(events));
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "Poll start failed");
+        *revents = cat_poll_translate_error_to_sys_events(events, error);
+        return CAT_RET_ERROR;
+    }
+    context.coroutine = CAT_COROUTINE_G(current);
+    context.done_task = NULL;
+    cat_poll_watcher_attach(watcher, &context);
+
+    ret = cat_time_delay(timeout);
+
+    if (context.done_task != NULL) {
+        cat_event_io_defer_task_close(context.done_task);
+    }
+    cat_poll_watcher_detach(watcher);
+
+    ret = cat_poll_one_translate_result(ret, watcher->ret.status, watcher->ret.events, events, revents);
+
+    if (unlikely(watcher->closing)) {
+        cat_poll_watcher_close_handle(watcher);
+    }
+
+    return ret;
+}
+
+CAT_API cat_ret_t cat_poll_watcher_wait(cat_poll_watcher_t *watcher, cat_pollfd_events_t events, cat_pollfd_events_t *revents, cat_timeout_t timeout)
+{
+    cat_pollfd_events_t _revents;
+    if (revents == NULL) {
+        revents = &_revents;
+    }
+
+    CAT_LOG_DEBUG_VA(POLL, {
+        char *events_str = cat_pollfd_events_str(events);
+        CAT_LOG_DEBUG_D(POLL, "poll_watcher_wait(fd: " CAT_OS_SOCKET_FMT ", events: %s, *revents: " CAT_LOG_UNFILLED_STR ", timeout: " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            watcher->fd, events_str, timeout);
+        cat_buffer_str_free(events_str);
+    });
+
+    cat_ret_t ret = cat_poll_watcher_wait_impl(watcher, events, revents, timeout);
+
+    CAT_LOG_DEBUG_VA(POLL, {
+        char *events_str = cat_pollfd_events_str(events);
+        char *revents_str = cat_pollfd_events_str(*revents);
+        CAT_LOG_DEBUG_D(POLL, "poll_watcher_wait(fd: " CAT_OS_SOCKET_FMT ", events: %s, *revents: %s, timeout: " CAT_TIMEOUT_FMT ") = " CAT_LOG_RET_RET_FMT,
+            watcher->fd, events_str, revents_str, timeout, CAT_LOG_RET_RET_C(ret));
+        cat_buffer_str_free(revents_str);
+        cat_buffer_str_free(events_str);
+    });
+
+    return ret;
+}
+
 #define CAT_POLL_EMULATE(fds, nfds) do { \
     if (cat_poll_emulate != NULL) { \
         int n; \
@@ -468,7 +720,7 @@ static void cat_poll_callback(uv_poll_t* handle, int status, uv_events_t events)
 
 CAT_API cat_poll_emulate_t cat_poll_emulate;
 
-static int cat_poll_impl(cat_pollfd_t *fds, cat_nfds_t nfds, cat_timeout_t timeout)
+static int cat_poll_impl(cat_pollfd_t *fds, cat_poll_watcher_t *const *watchers, cat_nfds_t nfds, cat_timeout_t timeout)
 {
     CAT_POLL_EMULATE(fds, nfds);
     CAT_POLL_CHECK_TIMEOUT(timeout);
@@ -502,8 +754,33 @@ static int cat_poll_impl(cat_pollfd_t *fds, cat_nfds_t nfds, cat_timeout_t timeo
         poll->initialized = cat_false;
         poll->ret.events = UV_EVENT_NONE;
         poll->u.context = context;
+        poll->watcher = watchers != NULL ? watchers[i] : NULL;
         do {
             cat_os_socket_t fd_no = fd->fd;
+            if (poll->watcher != NULL) {
+                cat_poll_watcher_t *watcher = poll->watcher;
+                if (likely(watcher->context == NULL && !watcher->closing)) {
+                    if (e > 0) {
+                        /* fast return without starting watcher */
+                        poll->watcher = NULL;
+                        poll->ret.status = CAT_ECANCELED;
+                        break;
+                    }
+                    error = cat_poll_watcher_start(watcher, cat_poll_translate_sys_events_to_uv_events(fd->events));
+                    if (unlikely(error != 0)) {
+                        poll->watcher = NULL;
+                        poll->ret.status = error;
+                        e++;
+                        break;
+                    }
+                    cat_poll_watcher_attach(watcher, context);
+                    poll->ret.status = CAT_ECANCELED;
+                    break;
+                }
+                /* watcher is busy (someone else is waiting on it, or the same fd appears twice),
+                 * fall back to the one-shot poll */
+                poll->watcher = NULL;
+            }
 #ifdef CAT_OS_UNIX_LIKE
             poll->fd_dup = CAT_OS_INVALID_FD;
             if (unlikely(uv__fd_exists(&CAT_EVENT_G(loop), fd->fd))) {
@@ -560,6 +837,14 @@ static int cat_poll_impl(cat_pollfd_t *fds, cat_nfds_t nfds, cat_timeout_t timeo
         cat_poll_t *poll = &polls[i];
         if (poll->initialized) {
             uv_close(&poll->u.handle, cat_poll_close_callback);
+        } else if (poll->watcher != NULL && poll->watcher->context == context) {
+            cat_poll_watcher_t *watcher = poll->watcher;
+            cat_poll_watcher_detach(watcher);
+            poll->ret.status = watcher->ret.status;
+            poll->ret.events = watcher->ret.events;
+            if (unlikely(watcher->closing)) {
+                cat_poll_watcher_close_handle(watcher);
+            }
         }
         if (unlikely(ret == CAT_RET_ERROR)) {
             /* just close handle and go to the next one */
@@ -623,6 +908,11 @@ static CAT_BUFFER_STR_FREE char *cat_pollfds_str(cat_pollfd_t *fds, cat_nfds_t n
 #endif
 
 CAT_API int cat_poll(cat_pollfd_t *fds, cat_nfds_t nfds, cat_timeout_t timeout)
+{
+    return cat_poll_ex(fds, NULL, nfds, timeout);
+}
+
+CAT_API int cat_poll_ex(cat_pollfd_t *fds, cat_poll_watcher_t *const *watchers, cat_nfds_t nfds, cat_timeout_t timeout)
 {
     CAT_LOG_DEBUG_VA(POLL, {
         char *fds_str = cat_pollfds_str(fds, nfds, cat_false);
@@ -630,7 +920,7 @@ CAT_API int cat_poll(cat_pollfd_t *fds, cat_nfds_t nfds, cat_timeout_t timeout)
         cat_buffer_str_free(fds_str);
     });
 
-    int ret = cat_poll_impl(fds, nfds, timeout);
+    int ret = cat_poll_impl(fds, watchers, nfds, timeout);
 
     CAT_LOG_DEBUG_VA(POLL, {
         char *fds_str = cat_pollfds_str(fds, nfds, cat_true);
@@ -656,9 +946,16 @@ CAT_API int cat_poll(cat_pollfd_t *fds, cat_nfds_t nfds, cat_timeout_t timeout)
 #define SAFE_FD_ISSET(fd, set) (set != NULL && FD_ISSET(fd, set))
 
 CAT_API int cat_select(cat_os_socket_t max_fd, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout)
+{
+    return cat_select_ex(max_fd, readfds, writefds, exceptfds, timeout, NULL, 0);
+}
+
+CAT_API int cat_select_ex(cat_os_socket_t max_fd, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout, cat_poll_watcher_t *const *watchers, size_t nwatchers)
 {
     cat_pollfd_t *pfds, *pfd;
+    cat_poll_watcher_t **pwatchers = NULL;
     cat_nfds_t nfds = 0, ifds;
+    size_t iwatchers = 0;
     int fd, ret;
 
     if (unlikely((int) max_fd < 0)) {
@@ -685,14 +982,17 @@ CAT_API int cat_select(cat_os_socket_t max_fd, fd_set *readfds, fd_set *writefds
         return 0;
     }
 
-    /* malloc for poll fds */
-    pfds = (cat_pollfd_t *) cat_malloc(sizeof(*pfds) * nfds);
+    /* malloc for poll fds (and watchers) */
+    pfds = (cat_pollfd_t *) cat_malloc((sizeof(*pfds) + (nwatchers > 0 ? sizeof(*pwatchers) : 0)) * nfds);
 #if CAT_ALLOC_HANDLE_ERRORS
     if (unlikely(pfds == NULL)) {
         cat_update_last_error_of_syscall("Malloc for poll fds failed");
         return -1;
     }
 #endif
+    if (nwatchers > 0) {
+        pwatchers = (cat_poll_watcher_t **) (pfds + nfds);
+    }
 
     /* translate from select structure to pollfd structure */
     ifds = 0;
@@ -711,11 +1011,18 @@ CAT_API int cat_select(cat_os_socket_t max_fd, fd_set *readfds, fd_set *writefds
         pfd->fd = (cat_os_socket_t) fd;
         pfd->events = events;
         pfd->revents = POLLNONE;
+        if (pwatchers != NULL) {
+            /* both of them are in ascending order of fd */
+            while (iwatchers < nwatchers && (int) watchers[iwatchers]->fd < fd) {
+                iwatchers++;
+            }
+            pwatchers[ifds] = (iwatchers < nwatchers && (int) watchers[iwatchers]->fd == fd) ? watchers[iwatchers] : NULL;
+        }
         ifds++;
     }
     CAT_ASSERT(ifds == nfds);
 
-    ret = cat_poll(pfds, nfds, cat_time_tv2to(timeout));
+    ret = cat_poll_ex(pfds, pwatchers, nfds, cat_time_tv2to(timeout));
 
     if (unlikely(ret < 0)) {
         goto _out;
@@ -21,29 +21,177 @@
 #ifdef CAT_PQ
 
 #include "cat_poll.h"
+#include "cat_event.h"
+
+#include <libpq-events.h>
+
+/* connection which has a registered poll watcher,
+ * so waiting on it costs no more epoll_ctl() calls per query */
+typedef struct cat_pq_connection_s {
+    cat_queue_node_t node;
+    PGconn *conn;
+    cat_poll_watcher_t *watcher;
+} cat_pq_connection_t;
+
+CAT_GLOBALS_STRUCT_BEGIN(cat_pq) {
+    cat_queue_t connections;
+} CAT_GLOBALS_STRUCT_END(cat_pq);
+
+CAT_GLOBALS_DECLARE(cat_pq);
+
+#define CAT_PQ_G(x) CAT_GLOBALS_GET(cat_pq, x)
+
+static int cat_pq_event_proc(PGEventId id, void *info, void *data);
+
+static void cat_pq_connection_free(cat_pq_connection_t *connection)
+{
+    CAT_LOG_DEBUG(PQ, "Release poll watcher of conn=%p", connection->conn);
+    cat_queue_remove(&connection->node);
+    cat_poll_watcher_close(connection->watcher);
+    (void) PQsetInstanceData(connection->conn, cat_pq_event_proc, NULL);
+    cat_free(connection);
+}
+
+static int cat_pq_event_proc(PGEventId id, void *info, void *data)
+{
+    cat_pq_connection_t *connection;
+    PGconn *conn;
+    (void) data;
+
+    switch (id) {
+        case PGEVT_CONNRESET:
+            conn = ((PGEventConnReset *) info)->conn;
+            break;
+        case PGEVT_CONNDESTROY:
+            conn = ((PGEventConnDestroy *) info)->conn;
+            break;
+        default:
+            return 1;
+    }
+    /* socket has been changed or closed */
+    connection = (cat_pq_connection_t *) PQinstanceData(conn, cat_pq_event_proc);
+    if (connection != NULL) {
+        cat_pq_connection_free(connection);
+    }
+
+    return 1;
+}
+
+static cat_poll_watcher_t *cat_pq_get_watcher(PGconn *conn)
+{
+    cat_pq_connection_t *connection;
+    int fd = PQsocket(conn);
+
+    connection = (cat_pq_connection_t *) PQinstanceData(conn, cat_pq_event_proc);
+    if (likely(connection != NULL)) {
+        if (likely(cat_poll_watcher_get_fd(connection->watcher) == fd)) {
+            return connection->watcher;
+        }
+        cat_pq_connection_free(connection);
+    }
+    if (unlikely(fd < 0)) {
+        return NULL;
+    }
+    connection = (cat_pq_connection_t *) cat_malloc(sizeof(*connection));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(connection == NULL)) {
+        return NULL;
+    }
+#endif
+    /* it fails if it has been registered (e.g. in the previous runtime), that is fine */
+    (void) PQregisterEventProc(conn, cat_pq_event_proc, "cat_pq", NULL);
+    if (unlikely(!PQsetInstanceData(conn, cat_pq_event_proc, connection))) {
+        cat_free(connection);
+        return NULL;
+    }
+    connection->watcher = cat_poll_watcher_create(fd);
+    if (unlikely(connection->watcher == NULL)) {
+        (void) PQsetInstanceData(conn, cat_pq_event_proc, NULL);
+        cat_free(connection);
+        return NULL;
+    }
+    connection->conn = conn;
+    cat_queue_push_back(&CAT_PQ_G(connections), &connection->node);
+    CAT_LOG_DEBUG(PQ, "Create poll watcher for conn=%p, fd=%d", conn, fd);
+
+    return connection->watcher;
+}
+
+static cat_bool_t cat_pq_poll(PGconn *conn, cat_pollfd_events_t events, cat_pollfd_events_t *revents)
+{
+    cat_poll_watcher_t *watcher = cat_pq_get_watcher(conn);
+    cat_ret_t ret;
+
+    if (likely(watcher != NULL)) {
+        ret = cat_poll_watcher_wait(watcher, events, revents, -1);
+    } else {
+        ret = cat_poll_one(PQsocket(conn), events, revents, -1);
+    }
+
+    return ret != CAT_RET_ERROR;
+}
+
+CAT_API cat_bool_t cat_pq_module_init(void)
+{
+    CAT_GLOBALS_REGISTER(cat_pq);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_pq_module_shutdown(void)
+{
+    CAT_GLOBALS_UNREGISTER(cat_pq);
+
+    return cat_true;
+}
+
+static void cat_pq_runtime_shutdown(cat_data_t *data)
+{
+    cat_pq_connection_t *connection;
+    (void) data;
+
+    /* watchers must be closed before event loop is closed,
+     * but connections may be persistent */
+    while ((connection = cat_queue_front_data(&CAT_PQ_G(connections), cat_pq_connection_t, node))) {
+        cat_pq_connection_free(connection);
+    }
+}
 
 CAT_API cat_bool_t cat_pq_runtime_init(void)
 {
+    cat_queue_init(&CAT_PQ_G(connections));
+    if (unlikely(cat_event_register_runtime_shutdown_task(cat_pq_runtime_shutdown, NULL) == NULL)) {
+        return cat_false;
+    }
+
     return cat_true;
 }
 
 CAT_API cat_bool_t cat_pq_runtime_close(void)
 {
+    CAT_ASSERT(cat_queue_empty(&CAT_PQ_G(connections)));
+
     return cat_true;
 }
 
 static int cat_pq_flush(PGconn *conn)
 {
-    int flush_ret = -1;
-
-    do {
-        cat_ret_t poll_ret = cat_poll_one(PQsocket(conn), POLLOUT, NULL, -1);
-        if (unlikely(poll_ret == CAT_RET_ERROR)) {
+    int flush_ret;
+
+    CAT_LOG_DEBUG(PQ, "PQflush(conn=%p)", conn);
+    while ((flush_ret = PQflush(conn)) == 1) {
+        cat_pollfd_events_t revents;
+        /* wait for the socket to be write-ready to send the rest of data,
+         * but server may be blocked on sending to us, so we also wait for read-ready
+         * and consume input then (as libpq document says) */
+        if (unlikely(!cat_pq_poll(conn, POLLOUT | POLLIN, &revents))) {
+            return -1;
+        }
+        if ((revents & (POLLIN | POLLHUP | POLLERR)) && unlikely(!PQconsumeInput(conn))) {
             return -1;
         }
         CAT_LOG_DEBUG(PQ, "PQflush(conn=%p)", conn);
-        flush_ret = PQflush(conn);
-    } while (flush_ret == 1);
+    }
 
     return flush_ret;
 }
@@ -51,13 +199,24 @@ static int cat_pq_flush(PGconn *conn)
 static PGresult *cat_pq_get_result(PGconn *conn)
 {
     PGresult *result, *last_result = NULL;
-    cat_ret_t poll_ret = cat_poll_one(PQsocket(conn), POLLIN, NULL, -1);
-    if (unlikely(poll_ret == CAT_RET_ERROR)) {
-        return NULL;
-    }
 
-    CAT_LOG_DEBUG(PQ, "PQgetResult(conn=%p)", conn);
-    while ((result = PQgetResult(conn))) {
+    while (1) {
+        /* PQgetResult() would block if it is busy, all of query has been flushed,
+         * so we only wait for the socket to be read-ready here */
+        while (PQisBusy(conn)) {
+            if (unlikely(!cat_pq_poll(conn, POLLIN, NULL))) {
+                PQclear(last_result);
+                return NULL;
+            }
+            if (unlikely(!PQconsumeInput(conn))) {
+                break;
+            }
+        }
+        CAT_LOG_DEBUG(PQ, "PQgetResult(conn=%p)", conn);
+        result = PQgetResult(conn);
+        if (result == NULL) {
+            break;
+        }
         PQclear(last_result);
         last_result = result;
     }
@@ -25,6 +25,7 @@
 #include "cat_poll.h"
 
 #include "cat_fs.h" /* for sendfile */
+#include "cat_io_uring.h"
 
 #ifdef CAT_IDE_HELPER
 #include "uv-common.h"
@@ -68,6 +69,31 @@
 #define CAT_SOCKET_RETRY_ON_WRITE_ERROR(errno) (errno == EINTR)
 #endif /* defined(__APPLE__) */
 
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+/* recvmmsg() and sendmmsg() are available */
+#define CAT_SOCKET_HAVE_MMSG 1
+/* for UDP_SEGMENT */
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#endif
+
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+#define CAT_SOCKET_HAVE_REUSEPORT_CBPF 1
+#include <linux/filter.h>
+#endif
+
+#if defined(__linux__) && defined(SO_INCOMING_CPU)
+/* for listener CPU detection of reuseport CPU affinity */
+#define CAT_SOCKET_HAVE_REUSEPORT_INCOMING_CPU 1
+#include <sched.h>
+#include <sys/utsname.h>
+#endif
+
+#if defined(__linux__) && !defined(CAT_OS_WIN)
+/* for TCP_INFO */
+#include <netinet/tcp.h>
+#endif
+
 #define CAT_SOCKET_IS_TRANSIENT_WRITE_ERROR(errno) \
     (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)
 
@@ -466,6 +492,10 @@ CAT_API cat_bool_t cat_socket_module_init(void)
 {
     CAT_GLOBALS_REGISTER(cat_socket);
 
+    if (unlikely(!cat_dns_module_init())) {
+        return cat_false;
+    }
+
     original_cat_poll_one_emulate = cat_poll_one_emulate;
     original_cat_poll_emulate = cat_poll_emulate;
     cat_poll_one_emulate = cat_socket_poll_one_emulate;
@@ -476,6 +506,7 @@ CAT_API cat_bool_t cat_socket_module_init(void)
 
 CAT_API cat_bool_t cat_socket_module_shutdown(void)
 {
+    (void) cat_dns_module_shutdown();
     CAT_GLOBALS_UNREGISTER(cat_socket);
     return cat_true;
 }
@@ -485,6 +516,30 @@ CAT_API cat_bool_t cat_socket_runtime_init(void)
     CAT_SOCKET_G(last_id) = 0;
     CAT_SOCKET_G(options.timeout) = cat_socket_default_global_timeout_options;
     CAT_SOCKET_G(options.tcp_keepalive_delay) = 60;
+    do {
+        cat_socket_io_uring_options_t *options = &CAT_SOCKET_G(io_uring);
+        int buffer_size, buffer_count, zerocopy_threshold;
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+        options->enabled = cat_env_is_true("CAT_SOCKET_IO_URING", cat_false);
+#else
+        options->enabled = cat_false;
+#endif
+        buffer_size = cat_env_get_i("CAT_SOCKET_IO_URING_BUFFER_SIZE", CAT_SOCKET_IO_URING_DEFAULT_BUFFER_SIZE);
+        options->buffer_size = (size_t) CAT_MIN(CAT_MAX(buffer_size, 1024), 1024 * 1024);
+        /* number of provided buffers must be power of 2 */
+        buffer_count = cat_env_get_i("CAT_SOCKET_IO_URING_BUFFER_COUNT", CAT_SOCKET_IO_URING_DEFAULT_BUFFER_COUNT);
+        buffer_count = CAT_MIN(CAT_MAX(buffer_count, 1), 32768);
+        options->buffer_count = 1;
+        while (options->buffer_count < (unsigned int) buffer_count) {
+            options->buffer_count <<= 1;
+        }
+        zerocopy_threshold = cat_env_get_i("CAT_SOCKET_IO_URING_ZEROCOPY_THRESHOLD", CAT_SOCKET_IO_URING_DEFAULT_ZEROCOPY_THRESHOLD);
+        options->zerocopy_threshold = (size_t) CAT_MAX(zerocopy_threshold, 0);
+    } while (0);
+
+    if (unlikely(!cat_dns_runtime_init())) {
+        return cat_false;
+    }
 
     return cat_true;
 }
@@ -659,6 +714,14 @@ RB_GENERATE_STATIC(cat_socket_internal_tree_s,
                    cat_socket_internal_s, tree_entry,
                    cat_socket__internal_compare);
 
+static void cat_socket_internal_tree_insert(cat_socket_internal_t *socket_i)
+{
+    if (!(socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_IN_TREE)) {
+        RB_INSERT(cat_socket_internal_tree_s, &CAT_SOCKET_G(internal_tree), socket_i);
+        socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_IN_TREE;
+    }
+}
+
 static cat_always_inline cat_timeout_t cat_socket_internal_get_dns_timeout(const cat_socket_internal_t *socket_i);
 static cat_always_inline cat_sa_family_t cat_socket_internal_get_af(const cat_socket_internal_t *socket_i);
 static const cat_sockaddr_info_t *cat_socket_internal_getname_fast(cat_socket_internal_t *socket_i, cat_bool_t is_peer, int *error_ptr);
@@ -939,6 +1002,10 @@ static cat_always_inline cat_socket_t *cat_socket_create_impl(cat_socket_t *sock
     socket_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
     memset(&socket_i->context.io.read, 0, sizeof(socket_i->context.io.read));
     cat_queue_init(&socket_i->context.io.write.coroutines);
+    socket_i->context.io.write.requests = 0;
+    socket_i->context.io.write.batch = NULL;
+    cat_buffer_init(&socket_i->context.io.write.cork_buffer);
+    socket_i->context.io.write.corked = cat_false;
     /* part of cache */
     socket_i->cache.fd = CAT_SOCKET_INVALID_FD;
     socket_i->cache.write_request = NULL;
@@ -947,6 +1014,12 @@ static cat_always_inline cat_socket_t *cat_socket_create_impl(cat_socket_t *sock
     socket_i->cache.peername = NULL;
     socket_i->cache.recv_buffer_size = -1;
     socket_i->cache.send_buffer_size = -1;
+    socket_i->cache.read_error = 0;
+    /* buffered reader */
+    cat_buffer_init(&socket_i->reader.buffer);
+    socket_i->reader.offset = 0;
+    socket_i->accept_stats = NULL;
+    socket_i->io_uring = NULL;
     /* options */
     socket_i->option_flags = CAT_SOCKET_OPTION_FLAG_NONE;
     socket_i->options.timeout = cat_socket_default_timeout_options;
@@ -1434,6 +1507,9 @@ static CAT_BUFFER_STR_FREE char *cat_socket_bind_flags_str(cat_socket_bind_flags
 }
 #endif
 
+static cat_bool_t cat_socket_internal_set_reuseport_cpu_affinity(cat_socket_internal_t *socket_i, uint32_t group_size);
+static cat_bool_t cat_socket_internal_enable_reuseport_cpu_affinity(cat_socket_internal_t *socket_i);
+
 static cat_bool_t cat_socket_internal_bind(
     cat_socket_internal_t *socket_i,
     const cat_sockaddr_t *address, cat_socklen_t address_length,
@@ -1442,10 +1518,16 @@ static cat_bool_t cat_socket_internal_bind(
 {
     CAT_SOCKET_CHECK_INPUT_ADDRESS_REQUIRED(address, address_length, return cat_false);
     cat_socket_type_t type = socket_i->type;
+    cat_bool_t cpu_affinity = cat_false;
     int error = CAT_EINVAL;
 
     if (!(type & CAT_SOCKET_TYPE_FLAG_LOCAL)) {
         int uv_flags = 0;
+        if (flags & CAT_SOCKET_BIND_FLAG_REUSEPORT_CPU_AFFINITY) {
+            flags ^= CAT_SOCKET_BIND_FLAG_REUSEPORT_CPU_AFFINITY;
+            flags |= CAT_SOCKET_BIND_FLAG_REUSEPORT;
+            cpu_affinity = cat_true;
+        }
         /* check flags */
         if ((type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP) {
             if (flags & CAT_SOCKET_BIND_FLAG_IPV6ONLY) {
@@ -1503,6 +1585,14 @@ static cat_bool_t cat_socket_internal_bind(
         cat_free(socket_i->cache.sockname);
         socket_i->cache.sockname = NULL;
     }
+    if (cpu_affinity) {
+        if ((type & CAT_SOCKET_TYPE_FLAG_STREAM)) {
+            socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_REUSEPORT_CPU_AFFINITY;
+        } else if (unlikely(!cat_socket_internal_enable_reuseport_cpu_affinity(socket_i))) {
+            cat_update_last_error_with_previous("Socket bind failed");
+            return cat_false;
+        }
+    }
 
     return cat_true;
 }
@@ -1594,2714 +1684,5219 @@ CAT_API cat_bool_t cat_socket_bind_to_ex(cat_socket_t *socket, const char *name,
     return ret;
 }
 
-static void cat_socket_accept_connection_callback(uv_stream_t *stream, int status)
-{
-    cat_socket_internal_t *server_i = cat_container_of(stream, cat_socket_internal_t, u.stream);
-
-    if (server_i->io_flags == CAT_SOCKET_IO_FLAG_ACCEPT) {
-        cat_coroutine_t *coroutine = server_i->context.accept.coroutine;
-        CAT_ASSERT(coroutine != NULL);
-        server_i->context.accept.data.status = status;
-        cat_coroutine_schedule(coroutine, SOCKET, "Accept");
-    }
-    // else we can call uv_accept to get it later
-}
-
-#define CAT_LOG_DEBUG_SOCKET_ESTABLISHED_SOCK_ONLY(socket, action, ret) \
-    CAT_LOG_DEBUG_VA(SOCKET, if (ret) { \
-        char sock_address[CAT_SOCKADDR_MAX_PATH] = "unknown"; \
-        size_t sock_address_length = sizeof(sock_address); \
-        cat_socket_get_sock_address(socket, sock_address, &sock_address_length); \
-        CAT_LOG_DEBUG_D(SOCKET, #action " %s { sock: {\"%.*s\", %d} }", \
-            cat_socket_get_type_name(socket), \
-            (int) sock_address_length, sock_address, cat_socket_get_sock_port(socket)); \
-    });
-
-static cat_always_inline cat_bool_t cat_socket_listen_impl(cat_socket_t *socket, int backlog)
+#ifndef CAT_OS_WIN
+/* open the connection which was accepted by ourselves rather than libuv */
+static int cat_socket_internal_open_accepted_fd(cat_socket_internal_t *connection_i, cat_socket_fd_t fd)
 {
-    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
     int error;
 
-    error = uv_listen(&socket_i->u.stream, backlog, cat_socket_accept_connection_callback);
+    error = uv__stream_open(&connection_i->u.stream, fd, UV_HANDLE_READABLE | UV_HANDLE_WRITABLE);
     if (unlikely(error != 0)) {
-        cat_update_last_error_with_reason(error, "Socket listen(%d) failed", backlog);
-        return cat_false;
-    }
-    /* note: socket maybe copied from the other one, so it may have already unref and in the internal tree. */
-    if (!(socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_SERVER)) {
-        uv_unref(&socket_i->u.handle);
-        RB_INSERT(cat_socket_internal_tree_s, &CAT_SOCKET_G(internal_tree), socket_i);
-        socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_SERVER;
+        uv__close(fd);
+    } else {
+        connection_i->u.stream.flags |= UV_HANDLE_BOUND;
     }
 
-    CAT_LOG_DEBUG_SOCKET_ESTABLISHED_SOCK_ONLY(socket, listened, cat_true);
-
-    return cat_true;
+    return error;
 }
+#endif
 
-CAT_API cat_bool_t cat_socket_listen(cat_socket_t *socket, int backlog)
-{
-    cat_bool_t ret = cat_socket_listen_impl(socket, backlog);
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+/* io_uring engine */
+
+#define CAT_SOCKET_IO_URING_BUFFER_GROUP_ID 1
+
+typedef struct cat_socket_io_uring_request_s {
+    cat_io_uring_request_t request;
+    /* it is set to NULL when socket is closed */
+    cat_socket_internal_t *socket;
+    /* cancellation has been requested (back pressure) */
+    cat_bool_t canceled;
+    union {
+        /* recv */
+        cat_io_uring_buffer_ring_t *buffer_ring;
+        /* zero-copy send */
+        struct {
+            cat_coroutine_t *coroutine;
+            int32_t result;
+            struct msghdr msg;
+        } send;
+    } u;
+    struct iovec vectors[1];
+} cat_socket_io_uring_request_t;
+
+struct cat_socket_io_uring_s {
+    struct {
+        /* multishot recv, it is re-armed until EOF or error */
+        cat_socket_io_uring_request_t *request;
+        /* read-ahead data */
+        cat_buffer_t buffer;
+        size_t offset;
+        /* it is sticky, CAT_EOF means that peer has closed the connection */
+        cat_errno_t error;
+        /* data is copied to the waiting reader directly */
+        char *target;
+        size_t size;
+        size_t nread;
+        cat_bool_t once;
+        cat_bool_t waiting;
+        /* engine has been detached, it is never re-armed, readers fall back to libuv after read-ahead data */
+        cat_bool_t detached;
+    } recv;
+    struct {
+        /* multishot accept, it is armed by accept() */
+        cat_socket_io_uring_request_t *request;
+        /* connections accepted in advance */
+        cat_socket_fd_t *fds;
+        unsigned int count;
+        unsigned int size;
+        /* it will be reported by the next accept() */
+        cat_errno_t error;
+    } accept;
+    struct {
+        /* zero-copy send in flight */
+        cat_socket_io_uring_request_t *request;
+        /* writers which are waiting for the zero-copy send (data order) */
+        cat_queue_t waiters;
+        cat_bool_t unsupported;
+        /* socket was closed while the zero-copy send was being drained, writer will free it */
+        cat_bool_t close_pending;
+    } send;
+};
 
-    CAT_LOG_DEBUG(SOCKET, "listen(" CAT_SOCKET_ID_FMT ", %d) = " CAT_LOG_BOOL_RET_FMT,
-        socket->id, backlog, CAT_LOG_BOOL_RET_C(ret));
+static void cat_socket_internal_free(cat_socket_internal_t *socket_i);
 
-    return ret;
-}
+CAT_STATIC_ASSERT(sizeof(cat_socket_write_vector_t) == sizeof(struct iovec));
 
-static cat_bool_t cat_socket_internal_accept(
-    cat_socket_internal_t *server_i, cat_socket_internal_t *connection_i,
-    cat_socket_inheritance_info_t *handle_info, cat_timeout_t timeout
-) {
-    int error;
+static cat_socket_io_uring_t *cat_socket_internal_get_io_uring(cat_socket_internal_t *socket_i)
+{
+    cat_socket_io_uring_t *engine = socket_i->io_uring;
+    cat_socket_fd_t fd;
 
-    if (handle_info == NULL) {
-        cat_socket_type_t server_type = cat_socket_type_simplify(server_i->type);
-        cat_socket_type_t connection_type = connection_i->type;
-        if (unlikely((server_type & connection_type) != server_type)) {
-            cat_update_last_error(CAT_EINVAL, "Socket accept connection type mismatch, expect %s but got %s",
-                cat_socket_type_get_name(server_type), cat_socket_type_get_name(connection_type));
-            return cat_false;
-        }
+    if (likely(engine != NULL)) {
+        return engine;
     }
-
-    while (1) {
-        cat_bool_t ret;
-        error = uv_accept(&server_i->u.stream, &connection_i->u.stream);
-        if (error == 0) {
-            /* init client properties */
-            connection_i->flags |= (CAT_SOCKET_INTERNAL_FLAG_ESTABLISHED | CAT_SOCKET_INTERNAL_FLAG_SERVER_CONNECTION);
-            /* TODO: socket_extends() ? */
-            memcpy(&connection_i->options, handle_info == NULL ? &server_i->options : &handle_info->options, sizeof(connection_i->options));
-            cat_socket_internal_on_open(connection_i, cat_socket_type_to_af(handle_info == NULL ? server_i->type : handle_info->type));
-            return cat_true;
-        }
-        if (unlikely(error != CAT_EAGAIN)) {
-            cat_update_last_error_with_reason(error, "Socket accept failed");
-            break;
-        }
-        uv_ref(&server_i->u.handle);
-        server_i->context.accept.data.status = CAT_ECANCELED;
-        server_i->context.accept.coroutine = CAT_COROUTINE_G(current);
-        server_i->io_flags = CAT_SOCKET_IO_FLAG_ACCEPT;
-        ret = cat_time_wait(timeout);
-        server_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
-        server_i->context.accept.coroutine = NULL;
-        uv_unref(&server_i->u.handle);
-        if (unlikely(!ret)) {
-            cat_update_last_error_with_previous("Socket accept wait failed");
-            break;
+    if (!CAT_SOCKET_G(io_uring.enabled)) {
+        return NULL;
+    }
+    if (socket_i->u.handle.type != UV_TCP &&
+        !(socket_i->u.handle.type == UV_NAMED_PIPE && !socket_i->u.pipe.ipc)) {
+        return NULL;
+    }
+    if (socket_i->flags & (CAT_SOCKET_INTERNAL_FLAG_NOT_SOCK | CAT_SOCKET_INTERNAL_FLAG_CLOSED | CAT_SOCKET_INTERNAL_FLAG_NO_IO_URING)) {
+        return NULL;
+    }
+    fd = cat_socket_internal_get_fd_fast(socket_i);
+    if (fd == CAT_SOCKET_INVALID_FD) {
+        return NULL;
+    }
+    if (socket_i->u.handle.type == UV_NAMED_PIPE) {
+        /* pipe may be opened from a fd which is not a socket */
+        int type;
+        socklen_t length = sizeof(type);
+        if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &length) != 0) {
+            if (errno == ENOTSOCK) {
+                socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_NOT_SOCK;
+            }
+            return NULL;
         }
-        if (unlikely(server_i->context.accept.data.status == CAT_ECANCELED)) {
-            cat_update_last_error(CAT_ECANCELED, "Socket accept has been canceled");
-            break;
+        if (type != SOCK_STREAM) {
+            return NULL;
         }
     }
+    /* multishot recv and zero-copy send are available since Linux 6.0 */
+    if (!cat_io_uring_is_available(IORING_OP_SEND_ZC) ||
+        cat_io_uring_get_buffer_ring(
+            CAT_SOCKET_IO_URING_BUFFER_GROUP_ID,
+            CAT_SOCKET_G(io_uring.buffer_count), CAT_SOCKET_G(io_uring.buffer_size)
+        ) == NULL) {
+        CAT_LOG_DEBUG(SOCKET, "Socket io_uring engine is unavailable, fallback to libuv");
+        CAT_SOCKET_G(io_uring.enabled) = cat_false;
+        return NULL;
+    }
+    engine = (cat_socket_io_uring_t *) cat_malloc(sizeof(*engine));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(engine == NULL)) {
+        return NULL;
+    }
+#endif
+    memset(engine, 0, sizeof(*engine));
+    cat_buffer_init(&engine->recv.buffer);
+    cat_queue_init(&engine->send.waiters);
+    socket_i->io_uring = engine;
+    /* read-ahead data is invisible to kernel, poll module should find it by fd */
+    cat_socket_internal_tree_insert(socket_i);
 
-    return cat_false;
+    return engine;
 }
 
-static cat_bool_t cat_socket_internal_recv_handle(cat_socket_internal_t *socket_i, cat_socket_internal_t *ihandle, cat_timeout_t timeout);
-
-static cat_always_inline cat_bool_t cat_socket_accept_impl(cat_socket_t *server, cat_socket_t *connection, cat_timeout_t timeout)
+static cat_socket_io_uring_request_t *cat_socket_io_uring_request_create(
+    cat_socket_internal_t *socket_i, size_t size, uint8_t opcode, cat_io_uring_callback_t callback
+)
 {
-    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(server, server_i, CAT_SOCKET_IO_FLAG_ACCEPT, return cat_false);
-    if (!(server_i->type & CAT_SOCKET_TYPE_FLAG_IPC)) {
-        CAT_SOCKET_INTERNAL_SERVER_ONLY(server_i, return cat_false);
-    }
+    cat_socket_io_uring_request_t *request;
 
-    CAT_SOCKET_INTERNAL_GETTER_SILENT(connection, connection_i, {
-        cat_update_last_error(CAT_EINVAL, "Socket accept can not act on an unavailable socket");
-        return cat_false;
-    });
-    if (unlikely(cat_socket_is_open(connection))) {
-        cat_update_last_error(CAT_EMISUSE, "Socket accept can only act on a lazy socket");
-        return cat_false;
+    request = (cat_socket_io_uring_request_t *) cat_io_uring_request_create(
+        size, opcode, cat_socket_internal_get_fd_fast(socket_i), callback
+    );
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(request == NULL)) {
+        return NULL;
     }
+#endif
+    request->socket = socket_i;
 
-    if (!(server_i->type & CAT_SOCKET_TYPE_FLAG_IPC)) {
-        return cat_socket_internal_accept(server_i, connection_i, NULL, timeout);
-    } else {
-        CAT_LOG_DEBUG_V2(SOCKET, "accept() via IPC");
-        return cat_socket_internal_recv_handle(server_i, connection_i, timeout);
+    return request;
+}
+
+static void cat_socket_io_uring_request_detach(cat_socket_io_uring_request_t *request)
+{
+    if (request == NULL) {
+        return;
     }
+    /* callback may still be called until it is canceled */
+    request->socket = NULL;
+    cat_io_uring_cancel(&request->request);
+    cat_io_uring_request_release(&request->request);
 }
 
-#define CAT_LOG_DEBUG_SOCKET_ESTABLISHED(socket, action, ret) \
-    CAT_LOG_DEBUG_VA(SOCKET, if (ret) { \
-        char sock_address[CAT_SOCKADDR_MAX_PATH] = "unknown", peer_address[CAT_SOCKADDR_MAX_PATH] = "unknown"; \
-        size_t sock_address_length = sizeof(sock_address), peer_address_length = sizeof(peer_address); \
-        cat_socket_get_sock_address(socket, sock_address, &sock_address_length); \
-        cat_socket_get_peer_address(socket, peer_address, &peer_address_length); \
-        CAT_LOG_DEBUG_D(SOCKET, #action " %s { sock: {\"%.*s\", %d}, peer: {\"%.*s\", %d} }", \
-            cat_socket_get_type_name(socket), \
-            (int) sock_address_length, sock_address, cat_socket_get_sock_port(socket), \
-            (int) peer_address_length, peer_address, cat_socket_get_peer_port(socket)); \
-    });
+/* recv */
 
-CAT_API cat_bool_t cat_socket_accept(cat_socket_t *server, cat_socket_t *connection)
+static cat_always_inline size_t cat_socket_io_uring_get_recv_buffered_length(const cat_socket_io_uring_t *engine)
 {
-    return cat_socket_accept_ex(server, connection, cat_socket_get_accept_timeout_fast(server));
+    return engine->recv.buffer.length - engine->recv.offset;
 }
 
-CAT_API cat_bool_t cat_socket_accept_ex(cat_socket_t *server, cat_socket_t *connection, cat_timeout_t timeout)
+static size_t cat_socket_io_uring_recv_consume(cat_socket_io_uring_t *engine, char *buffer, size_t size, cat_bool_t peek)
 {
-    CAT_LOG_DEBUG(SOCKET, "accept(" CAT_SOCKET_ID_FMT ", " CAT_TIMEOUT_FMT ") = "  CAT_LOG_UNFINISHED_STR,
-        server->id, timeout);
+    cat_buffer_t *recv_buffer = &engine->recv.buffer;
+    size_t n = CAT_MIN(cat_socket_io_uring_get_recv_buffered_length(engine), size);
 
-    cat_bool_t ret = cat_socket_accept_impl(server, connection, timeout);
-
-    CAT_LOG_DEBUG(SOCKET, "accept(" CAT_SOCKET_ID_FMT ", " CAT_TIMEOUT_FMT ") = " CAT_SOCKET_ID_FMT  CAT_LOG_STRERRNO_FMT,
-        server->id, timeout, ret ? connection->id : CAT_SOCKET_INVALID_ID, CAT_LOG_STRERRNO_C(ret, cat_get_last_error_code()));
-    CAT_LOG_DEBUG_SOCKET_ESTABLISHED(connection, accepted, ret);
+    if (n == 0) {
+        return 0;
+    }
+    memcpy(buffer, recv_buffer->value + engine->recv.offset, n);
+    if (!peek) {
+        engine->recv.offset += n;
+        if (engine->recv.offset == recv_buffer->length) {
+            engine->recv.offset = 0;
+            recv_buffer->length = 0;
+            /* do not hold the memory which was extended for large message */
+            if (recv_buffer->size > CAT_SOCKET_READER_BUFFER_DEFAULT_SIZE * 8) {
+                cat_buffer_close(recv_buffer);
+            }
+        }
+    }
 
-    return ret;
+    return n;
 }
 
-static cat_always_inline void cat_socket_internal_on_connect_done(cat_socket_internal_t *socket_i, cat_sa_family_t af)
+static void cat_socket_io_uring_recv_store(cat_socket_io_uring_t *engine, const char *data, size_t length)
 {
-    /* connect done successfully, we can do something here before transfer data */
-    socket_i->flags |= (CAT_SOCKET_INTERNAL_FLAG_ESTABLISHED | CAT_SOCKET_INTERNAL_FLAG_CLIENT);
-    cat_socket_internal_on_open(socket_i, af);
-    /* clear previous cache (maybe impossible here) */
-    if (unlikely(socket_i->cache.peername)) {
-        cat_free(socket_i->cache.peername);
-        socket_i->cache.peername = NULL;
+    cat_buffer_t *recv_buffer = &engine->recv.buffer;
+    size_t buffered_length = cat_socket_io_uring_get_recv_buffered_length(engine);
+
+    if (engine->recv.waiting && engine->recv.target != NULL && buffered_length == 0) {
+        size_t n = CAT_MIN(length, engine->recv.size - engine->recv.nread);
+        memcpy(engine->recv.target + engine->recv.nread, data, n);
+        engine->recv.nread += n;
+        data += n;
+        length -= n;
+    }
+    if (length == 0) {
+        return;
+    }
+    if (recv_buffer->size - recv_buffer->length < length && engine->recv.offset != 0) {
+        /* move data to the beginning */
+        memmove(recv_buffer->value, recv_buffer->value + engine->recv.offset, buffered_length);
+        recv_buffer->length = buffered_length;
+        engine->recv.offset = 0;
+    }
+    if (unlikely(!cat_buffer_append(recv_buffer, data, length))) {
+        engine->recv.error = CAT_ENOMEM;
     }
 }
 
-static void cat_socket_internal_connect_callback(uv_connect_t* request, int status)
+static cat_bool_t cat_socket_internal_io_uring_recv_arm(cat_socket_internal_t *socket_i, cat_socket_io_uring_t *engine);
+
+static void cat_socket_io_uring_recv_callback(cat_io_uring_request_t *io_uring_request, int32_t result, uint32_t flags)
 {
-    cat_socket_internal_t *socket_i = cat_container_of(request->handle, cat_socket_internal_t, u.stream);
+    cat_socket_io_uring_request_t *request = (cat_socket_io_uring_request_t *) io_uring_request;
+    cat_socket_internal_t *socket_i = request->socket;
+    cat_socket_io_uring_t *engine;
+    size_t buffered_length;
+    cat_bool_t wakeup = cat_false;
 
-    /* if status == ECANCELED means that socket is closed (now in uv__stream_destroy())
-     * and handle->close_cb() always after the uv__stream_destroy() */
-    if (socket_i->io_flags == CAT_SOCKET_IO_FLAG_CONNECT) {
-        cat_coroutine_t *coroutine = socket_i->context.connect.coroutine;
+    if (result > 0) {
+        cat_io_uring_buffer_ring_t *buffer_ring = request->u.buffer_ring;
+        uint16_t buffer_id = (uint16_t) (flags >> IORING_CQE_BUFFER_SHIFT);
+        CAT_ASSERT(flags & IORING_CQE_F_BUFFER);
+        if (socket_i != NULL) {
+            cat_socket_io_uring_recv_store(
+                socket_i->io_uring,
+                cat_io_uring_buffer_ring_get_buffer(buffer_ring, buffer_id), (size_t) result
+            );
+        }
+        cat_io_uring_buffer_ring_recycle(buffer_ring, buffer_id);
+    }
+    if (socket_i == NULL) {
+        return;
+    }
+    engine = socket_i->io_uring;
+    if (result == 0) {
+        engine->recv.error = CAT_EOF;
+    } else if (result < 0 && result != -ENOBUFS && result != -ECANCELED) {
+        engine->recv.error = cat_translate_sys_error(-result);
+    }
+    buffered_length = cat_socket_io_uring_get_recv_buffered_length(engine);
+    if (!(flags & IORING_CQE_F_MORE)) {
+        /* it was terminated by kernel (e.g. run out of provided buffers) or canceled by us */
+        if (engine->recv.error == 0 && buffered_length < CAT_SOCKET_IO_URING_READ_AHEAD_MAX_SIZE) {
+            if (unlikely(!cat_socket_internal_io_uring_recv_arm(socket_i, engine))) {
+                /* reader will fallback to libuv */
+                wakeup = cat_true;
+            }
+        }
+    } else if (buffered_length >= CAT_SOCKET_IO_URING_READ_AHEAD_MAX_SIZE && !request->canceled) {
+        /* back pressure, it will be re-armed after data is consumed */
+        request->canceled = cat_true;
+        cat_io_uring_cancel(&request->request);
+    }
+    if (engine->recv.waiting && (
+        wakeup || engine->recv.error != 0 ||
+        /* detacher is waiting for the last completion */
+        (engine->recv.detached && !(flags & IORING_CQE_F_MORE)) ||
+        (engine->recv.target == NULL ? buffered_length > 0 :
+            (engine->recv.nread == engine->recv.size || (engine->recv.once && engine->recv.nread > 0)))
+    )) {
+        cat_coroutine_t *coroutine = socket_i->context.io.read.coroutine;
         CAT_ASSERT(coroutine != NULL);
-        socket_i->context.connect.data.status = status;
-        cat_coroutine_schedule(coroutine, SOCKET, "Connect");
+        engine->recv.waiting = cat_false;
+        cat_coroutine_schedule_deferrable(coroutine, SOCKET, "Stream read");
     }
-
-    cat_free(request);
 }
 
-static void cat_socket_internal_try_connect_callback(uv_connect_t* request, int status)
+/* it returns false if multishot recv can not be armed, then we should fallback to libuv */
+static cat_bool_t cat_socket_internal_io_uring_recv_arm(cat_socket_internal_t *socket_i, cat_socket_io_uring_t *engine)
 {
-#ifndef CAT_OS_DARWIN
-    cat_socket_internal_t *socket_i = cat_container_of(request->handle, cat_socket_internal_t, u.stream);
+    cat_socket_io_uring_request_t *request = engine->recv.request;
 
-    if (status == 0) {
-        cat_socket_internal_on_connect_done(socket_i, (cat_sa_family_t) (intptr_t) request->data);
+    if (unlikely(engine->recv.detached)) {
+        return cat_false;
     }
-#endif
-
-    cat_free(request);
-}
-
-static cat_bool_t cat_socket_internal_connect(
-    cat_socket_internal_t *socket_i,
-    const cat_sockaddr_t *address, cat_socklen_t address_length,
-    cat_timeout_t timeout, cat_bool_t is_try
-)
-{
-    CAT_SOCKET_CHECK_INPUT_ADDRESS_REQUIRED(address, address_length, return cat_false);
-    cat_socket_type_t type = socket_i->type;
-    uv_connect_t *request;
-    int error = 0;
-
-    /* only TCP and PIPE need request */
-    if (((type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP) || (type & CAT_SOCKET_TYPE_FLAG_LOCAL)) {
-        /* malloc for request (we must free it in the callback if it has been started) */
-        request = (uv_connect_t *) cat_malloc(sizeof(*request));
+    if (request == NULL) {
+        cat_io_uring_buffer_ring_t *buffer_ring = cat_io_uring_get_buffer_ring(
+            CAT_SOCKET_IO_URING_BUFFER_GROUP_ID,
+            CAT_SOCKET_G(io_uring.buffer_count), CAT_SOCKET_G(io_uring.buffer_size)
+        );
+        if (unlikely(buffer_ring == NULL)) {
+            return cat_false;
+        }
+        request = cat_socket_io_uring_request_create(
+            socket_i, sizeof(*request), IORING_OP_RECV, cat_socket_io_uring_recv_callback
+        );
 #if CAT_ALLOC_HANDLE_ERRORS
         if (unlikely(request == NULL)) {
-            cat_update_last_error_of_syscall("Malloc for Socket connect request failed");
             return cat_false;
         }
 #endif
-    } else {
-        request = NULL;
+        request->request.sqe.ioprio = IORING_RECV_MULTISHOT;
+        request->request.sqe.flags = IOSQE_BUFFER_SELECT;
+        request->request.sqe.buf_group = CAT_SOCKET_IO_URING_BUFFER_GROUP_ID;
+        request->u.buffer_ring = buffer_ring;
+        engine->recv.request = request;
+    } else if (request->request.state != CAT_IO_URING_REQUEST_STATE_NONE) {
+        /* it is in flight, or it is being canceled and will be re-armed on the last completion */
+        return cat_true;
     }
-    if ((type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP) {
-        error = uv_tcp_connect(
-            request, &socket_i->u.tcp, address,
-            !is_try ? cat_socket_internal_connect_callback : cat_socket_internal_try_connect_callback
-        );
-        if (unlikely(error != 0)) {
-            cat_update_last_error_with_reason(error, "Tcp connect init failed");
-            cat_free(request);
-            return cat_false;
-        }
-    } else if ((type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP) {
-        error = uv_udp_connect(&socket_i->u.udp, address);
-    } else if (type & CAT_SOCKET_TYPE_FLAG_LOCAL) {
-        const char *name = address->sa_data;
-        size_t name_length = address_length - CAT_SOCKADDR_HEADER_LENGTH;
-        if (!cat_sockaddr_is_linux_abstract_name(name, name_length)) {
-            name_length = cat_strnlen(name, name_length);
-        }
-        (void) uv_pipe_connect_ex(
-            request, &socket_i->u.pipe, name, name_length,
-            !is_try ? cat_socket_internal_connect_callback : cat_socket_internal_try_connect_callback
-        );
-    } else {
-        error = CAT_EAFNOSUPPORT;
+    if (engine->recv.error != 0 ||
+        cat_socket_io_uring_get_recv_buffered_length(engine) >= CAT_SOCKET_IO_URING_READ_AHEAD_MAX_SIZE) {
+        return cat_true;
     }
-    if (request != NULL) {
-        if (!is_try) {
-            cat_bool_t ret;
-            socket_i->context.connect.data.status = CAT_ECANCELED;
-            socket_i->context.connect.coroutine = CAT_COROUTINE_G(current);
-            socket_i->io_flags = CAT_SOCKET_IO_FLAG_CONNECT;
-            ret = cat_time_wait(timeout);
-            socket_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
-            socket_i->context.connect.coroutine = NULL;
-            if (unlikely(!ret)) {
-                cat_update_last_error_with_previous("Socket connect wait failed");
-                /* interrupt can not recover */
-                cat_socket_internal_unrecoverable_io_error(socket_i);
-                return cat_false;
-            }
-            error = socket_i->context.connect.data.status;
-            if (error == CAT_ECANCELED) {
-                cat_update_last_error(CAT_ECANCELED, "Socket connect has been canceled");
-                /* interrupt can not recover */
-                cat_socket_internal_unrecoverable_io_error(socket_i);
-                return cat_false;
+    request->canceled = cat_false;
+
+    return cat_io_uring_submit(&request->request);
+}
+
+/* target of the reader is set by caller */
+static cat_errno_t cat_socket_internal_io_uring_recv_wait(cat_socket_internal_t *socket_i, cat_socket_io_uring_t *engine, cat_timeout_t timeout)
+{
+    cat_bool_t ret;
+
+    engine->recv.waiting = cat_true;
+    socket_i->context.io.read.coroutine = CAT_COROUTINE_G(current);
+    socket_i->io_flags |= CAT_SOCKET_IO_FLAG_READ;
+    ret = cat_time_wait(timeout);
+    socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_READ;
+    socket_i->context.io.read.coroutine = NULL;
+    if (unlikely(engine->recv.waiting)) {
+        engine->recv.waiting = cat_false;
+        return ret ? CAT_ECANCELED : CAT_EPREV;
+    }
+
+    return 0;
+}
+
+/* it returns CAT_EAGAIN if we should fallback to libuv, nread is always updated */
+static cat_errno_t cat_socket_internal_io_uring_read(
+    cat_socket_internal_t *socket_i, cat_socket_io_uring_t *engine,
+    char *buffer, size_t size, size_t *nread,
+    cat_timeout_t timeout, cat_bool_t once
+)
+{
+    while (1) {
+        cat_errno_t error;
+        *nread += cat_socket_io_uring_recv_consume(engine, buffer + *nread, size - *nread, cat_false);
+        if (*nread == size || (once && *nread > 0)) {
+            /* keep reading ahead */
+            (void) cat_socket_internal_io_uring_recv_arm(socket_i, engine);
+            return 0;
+        }
+        error = engine->recv.error;
+        if (error != 0) {
+            if (error == CAT_EOF) {
+                return once ? 0 : CAT_ECONNRESET;
             }
+            return error;
         }
-#ifndef CAT_OS_DARWIN
-        else {
-            request->data = (void *) (intptr_t) address->sa_family;
+        if (unlikely(!cat_socket_internal_io_uring_recv_arm(socket_i, engine))) {
+            return CAT_EAGAIN;
+        }
+        engine->recv.target = buffer;
+        engine->recv.size = size;
+        engine->recv.nread = *nread;
+        engine->recv.once = once;
+        error = cat_socket_internal_io_uring_recv_wait(socket_i, engine, timeout);
+        *nread = engine->recv.nread;
+        engine->recv.target = NULL;
+        if (unlikely(error != 0)) {
+            return error;
         }
-#endif
-    }
-    if (unlikely(error != 0)) {
-        cat_update_last_error_with_reason(error, "Socket connect failed");
-        return cat_false;
-    }
-#ifndef CAT_OS_DARWIN /* connect done is later than POLLOUT event on macOS */
-    if (!is_try)
-#endif
-    {
-        cat_socket_internal_on_connect_done(socket_i, address->sa_family);
     }
-
-    return cat_true;
 }
 
-static cat_bool_t cat_socket_connect_impl(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout, cat_bool_t is_try)
+/* it returns CAT_ENOTSUP if we should fallback to syscall */
+static ssize_t cat_socket_internal_io_uring_try_recv(cat_socket_internal_t *socket_i, cat_socket_io_uring_t *engine, char *buffer, size_t size)
 {
-    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(socket, socket_i, CAT_SOCKET_IO_FLAG_CONNECT, return cat_false);
-    CAT_SOCKET_INTERNAL_ESTABLISHED_ONCE(socket_i, return cat_false);
+    size_t nread = cat_socket_io_uring_recv_consume(engine, buffer, size, cat_false);
+    cat_bool_t armed = cat_socket_internal_io_uring_recv_arm(socket_i, engine);
 
-    return cat_socket_internal_connect(socket_i, address, address_length, timeout, is_try);
+    if (nread > 0) {
+        return (ssize_t) nread;
+    }
+    if (engine->recv.error != 0) {
+        return engine->recv.error == CAT_EOF ? 0 : engine->recv.error;
+    }
+    if (unlikely(!armed)) {
+        return CAT_ENOTSUP;
+    }
+    /* data which is not read ahead yet will be delivered asynchronously */
+    return CAT_EAGAIN;
 }
 
-static cat_bool_t cat_socket_connect_to_impl(cat_socket_t *socket, const char *name, size_t name_length, int port, cat_timeout_t timeout, cat_bool_t is_try)
+/* it returns CAT_ENOTSUP if we should fallback to syscall */
+static ssize_t cat_socket_internal_io_uring_peek(cat_socket_internal_t *socket_i, cat_socket_io_uring_t *engine, char *buffer, size_t size, cat_timeout_t timeout)
 {
-    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(socket, socket_i, CAT_SOCKET_IO_FLAG_CONNECT, return cat_false);
-    CAT_SOCKET_INTERNAL_ESTABLISHED_ONCE(socket_i, return cat_false);
-
-    /* address can be NULL if it's UDP */
-    if (name_length == 0 && ((socket_i->type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP)) {
-        return cat_socket_internal_connect(socket_i, NULL, 0, timeout, is_try);
+    while (1) {
+        size_t nread = cat_socket_io_uring_recv_consume(engine, buffer, size, cat_true);
+        cat_errno_t error;
+        if (nread > 0) {
+            return (ssize_t) nread;
+        }
+        error = engine->recv.error;
+        if (error != 0) {
+            if (error == CAT_EOF) {
+                return 0;
+            }
+            cat_update_last_error_with_reason(error, "Socket peek failed");
+            return -1;
+        }
+        if (unlikely(!cat_socket_internal_io_uring_recv_arm(socket_i, engine))) {
+            return CAT_ENOTSUP;
+        }
+        if (timeout == 0) {
+            return 0;
+        }
+        engine->recv.target = NULL;
+        error = cat_socket_internal_io_uring_recv_wait(socket_i, engine, timeout);
+        if (unlikely(error != 0)) {
+            if (error == CAT_ECANCELED) {
+                cat_update_last_error(CAT_ECANCELED, "Socket peek has been canceled");
+            } else if (cat_get_last_error_code() == CAT_ETIMEDOUT) {
+                cat_update_last_error(CAT_ETIMEDOUT, "Socket peek wait readable timedout");
+            } else {
+                cat_update_last_error_with_previous("Socket peek wait readable failed");
+            }
+            return 0;
+        }
     }
+}
 
-    /* otherwise we resolve address */
-    cat_sa_family_t af = cat_socket_internal_get_af(socket_i);
-    cat_sockaddr_info_t address_info;
-    cat_bool_t ret = cat_false;
-    int error;
-    address_info.length = sizeof(address_info.address);
-    address_info.address.common.sa_family = af;
-    error = cat_sockaddr__getbyname(&address_info.address.common, &address_info.length, name, name_length, port);
-    if (error == 0) {
-        return cat_socket_internal_connect(socket_i, &address_info.address.common, address_info.length, timeout, is_try);
-    }
-    if (unlikely(error != CAT_EINVAL)) {
-        cat_update_last_error_with_reason(error, "Socket connect failed, reason: Socket get address by name failed");
-        return cat_false;
-    }
+/* it returns CAT_EAGAIN if liveness should be checked by fd */
+static cat_errno_t cat_socket_internal_io_uring_get_connection_error(const cat_socket_internal_t *socket_i)
+{
+    const cat_socket_io_uring_t *engine = socket_i->io_uring;
 
-    /* the input addr name is a domain name, do a ns look-up */
-    struct addrinfo *responses, *response;
-    struct addrinfo hints = {0};
-    if (af != AF_UNSPEC) {
-        // the socket is already specified or bound
-        hints.ai_family = af;
+    if (engine == NULL) {
+        return CAT_EAGAIN;
     }
-    if (socket_i->type & CAT_SOCKET_TYPE_FLAG_STREAM) {
-        hints.ai_socktype = SOCK_STREAM;
-    } else if (socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM) {
-        hints.ai_socktype = SOCK_DGRAM;
-    } else {
-        hints.ai_socktype = 0;
+    if (cat_socket_io_uring_get_recv_buffered_length(engine) > 0) {
+        return 0;
     }
-    socket_i->context.connect.coroutine = CAT_COROUTINE_G(current);
-    socket_i->io_flags = CAT_SOCKET_IO_FLAG_CONNECT;
-    responses = cat_dns_getaddrinfo_ex(name, NULL, &hints, cat_socket_get_dns_timeout_fast(socket));
-    socket_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
-    socket_i->context.connect.coroutine = NULL;
-    if (unlikely(responses == NULL)) {
-        cat_update_last_error_with_previous("Socket connect failed");
-        return cat_false;
+    if (engine->recv.error == CAT_EOF) {
+        return CAT_ECONNRESET;
     }
-    /* Try to connect to all address results until successful */
-    cat_sa_family_t last_af = responses->ai_addr->sa_family;
-    cat_bool_t is_initialized = cat_socket_internal_get_fd_fast(socket_i) != CAT_SOCKET_INVALID_FD;
-    response = responses;
-    do {
-        CAT_ASSERT(((response->ai_addr->sa_family == AF_INET && response->ai_addrlen == sizeof(struct sockaddr_in)) ||
-                   (response->ai_addr->sa_family == AF_INET6 && response->ai_addrlen == sizeof(struct sockaddr_in6))) &&
-                   "GAI should only return inet and inet6 addresses");
-        memcpy(&address_info.address.common, response->ai_addr, response->ai_addrlen);
-        if (response->ai_addr->sa_family == AF_INET) {
-            address_info.address.in.sin_port = htons((uint16_t) port);
-        } else if (response->ai_addr->sa_family == AF_INET6) {
-            address_info.address.in6.sin6_port = htons((uint16_t) port);
-        } else {
-            continue; // should never here
+    if (engine->recv.error != 0) {
+        return engine->recv.error;
+    }
+
+    return CAT_EAGAIN;
+}
+
+/* accept */
+
+static void cat_socket_io_uring_accept_callback(cat_io_uring_request_t *io_uring_request, int32_t result, uint32_t flags)
+{
+    cat_socket_io_uring_request_t *request = (cat_socket_io_uring_request_t *) io_uring_request;
+    cat_socket_internal_t *server_i = request->socket;
+    cat_socket_io_uring_t *engine;
+
+    if (unlikely(server_i == NULL)) {
+        if (result >= 0) {
+            uv__close(result);
         }
-        if (response->ai_family != last_af) {
-            CAT_ASSERT(af == AF_UNSPEC);
-            // af changed and socket has not been initialized yet, recreate socket_i
-            cat_socket_type_t type = socket_i->type; // TODO: Implement socket_dup()
-            // FIXME: multi bound sockets, make them all available
-            cat_socket_internal_close(socket_i, NULL, cat_true);
-            ret = cat_socket_create(socket, type) != NULL;
-            if (!ret) {
-                cat_update_last_error_with_previous("Socket connect recreate failed");
-                break;
+        return;
+    }
+    engine = server_i->io_uring;
+    if (result >= 0) {
+        if (engine->accept.count == engine->accept.size) {
+            unsigned int size = CAT_MAX(engine->accept.size * 2, 16);
+            cat_socket_fd_t *fds = (cat_socket_fd_t *) cat_realloc(engine->accept.fds, sizeof(*fds) * size);
+#if CAT_ALLOC_HANDLE_ERRORS
+            if (unlikely(fds == NULL)) {
+                uv__close(result);
+                engine->accept.error = CAT_ENOMEM;
+                goto _wakeup;
             }
-            socket_i = socket->internal;
+#endif
+            engine->accept.fds = fds;
+            engine->accept.size = size;
         }
-        ret = cat_socket_internal_connect(
-            socket_i,
-            &address_info.address.common,
-            (cat_socklen_t) response->ai_addrlen,
-            timeout,
-            is_try
-        );
-        if (ret || is_initialized || !cat_socket_is_available(socket)) {
-            break;
+        engine->accept.fds[engine->accept.count++] = result;
+        if (engine->accept.count >= CAT_SOCKET_IO_URING_ACCEPT_QUEUE_MAX_SIZE &&
+            (flags & IORING_CQE_F_MORE) && !request->canceled) {
+            /* back pressure, it will be re-armed after connections are taken */
+            request->canceled = cat_true;
+            cat_io_uring_cancel(&request->request);
         }
-    } while ((response = response->ai_next));
-    cat_dns_freeaddrinfo(responses);
-
-#ifdef CAT_SSL
-    if (ret) {
-        socket_i->ssl_peer_name = cat_strndup(name, name_length);
+    } else if (result != -ECANCELED) {
+        engine->accept.error = cat_translate_sys_error(-result);
     }
+#if CAT_ALLOC_HANDLE_ERRORS
+    _wakeup:
 #endif
+    if (server_i->io_flags == CAT_SOCKET_IO_FLAG_ACCEPT) {
+        cat_coroutine_t *coroutine = server_i->context.accept.coroutine;
+        CAT_ASSERT(coroutine != NULL);
+        server_i->context.accept.data.status = 0;
+        cat_coroutine_schedule_deferrable(coroutine, SOCKET, "Accept");
+    }
+}
 
-    return ret;
+static cat_always_inline cat_bool_t cat_socket_io_uring_accept_is_armed(const cat_socket_io_uring_t *engine)
+{
+    return engine->accept.request != NULL && engine->accept.request->request.state != CAT_IO_URING_REQUEST_STATE_NONE;
 }
 
-CAT_API cat_bool_t cat_socket_connect(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length)
+/* connections should be accepted by io_uring only, but libuv starts watching again after uv_accept() */
+static cat_always_inline void cat_socket_internal_io_uring_on_uv_accepted(cat_socket_internal_t *server_i)
 {
-    return cat_socket_connect_ex(socket, address, address_length, cat_socket_get_connect_timeout_fast(socket));
+    cat_socket_io_uring_t *engine = server_i->io_uring;
+
+    if (engine != NULL && cat_socket_io_uring_accept_is_armed(engine)) {
+        uv__io_stop(&CAT_EVENT_G(loop), &server_i->u.stream.io_watcher, POLLIN);
+    }
 }
 
-CAT_API cat_bool_t cat_socket_connect_ex(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout)
+static cat_bool_t cat_socket_internal_io_uring_accept_arm(cat_socket_internal_t *server_i, cat_socket_io_uring_t *engine)
 {
-#ifdef CAT_ENABLE_DEBUG_LOG
-    char name[CAT_SOCKADDR_MAX_PATH];
-    size_t name_length = sizeof(name);
-    int port = 0;
-#endif
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
-            break;
-        }
-        CAT_LOG_DEBUG_D(SOCKET, "connect(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, (int) name_length, name, port, timeout);
-    });
+    cat_socket_io_uring_request_t *request = engine->accept.request;
 
-    cat_bool_t ret = cat_socket_connect_impl(socket, address, address_length, timeout, cat_false);
+    if (request == NULL) {
+        request = cat_socket_io_uring_request_create(
+            server_i, sizeof(*request), IORING_OP_ACCEPT, cat_socket_io_uring_accept_callback
+        );
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(request == NULL)) {
+            goto _fallback;
+        }
+#endif
+        request->request.sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+        request->request.sqe.accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        engine->accept.request = request;
+    } else if (request->request.state != CAT_IO_URING_REQUEST_STATE_NONE) {
+        return cat_true;
+    }
+    if (engine->accept.count >= CAT_SOCKET_IO_URING_ACCEPT_QUEUE_MAX_SIZE) {
+        return cat_true;
+    }
+    request->canceled = cat_false;
+    if (unlikely(!cat_io_uring_submit(&request->request))) {
+        goto _fallback;
+    }
+    uv__io_stop(&CAT_EVENT_G(loop), &server_i->u.stream.io_watcher, POLLIN);
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "connect(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
-            socket->id, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
-    });
-    CAT_LOG_DEBUG_SOCKET_ESTABLISHED(socket, connected, ret);
+    return cat_true;
 
-    return ret;
+    _fallback:
+    /* let libuv accept connections */
+    if (server_i->u.stream.accepted_fd == -1) {
+        uv__io_start(&CAT_EVENT_G(loop), &server_i->u.stream.io_watcher, POLLIN);
+    }
+    return cat_false;
 }
 
-CAT_API cat_bool_t cat_socket_connect_to(cat_socket_t *socket, const char *name, size_t name_length, int port)
+/* it returns CAT_EAGAIN if there is no connection yet */
+static int cat_socket_internal_io_uring_accept(cat_socket_internal_t *server_i, cat_socket_io_uring_t *engine, cat_socket_internal_t *connection_i)
 {
-    return cat_socket_connect_to_ex(socket, name, name_length, port, cat_socket_get_connect_timeout_fast(socket));
+    if (engine->accept.count > 0) {
+        cat_socket_fd_t fd = engine->accept.fds[0];
+        engine->accept.count--;
+        memmove(engine->accept.fds, engine->accept.fds + 1, sizeof(*engine->accept.fds) * engine->accept.count);
+        (void) cat_socket_internal_io_uring_accept_arm(server_i, engine);
+        return cat_socket_internal_open_accepted_fd(connection_i, fd);
+    }
+    if (unlikely(engine->accept.error != 0)) {
+        cat_errno_t error = engine->accept.error;
+        engine->accept.error = 0;
+        return error;
+    }
+    (void) cat_socket_internal_io_uring_accept_arm(server_i, engine);
+
+    return CAT_EAGAIN;
 }
 
-CAT_API cat_bool_t cat_socket_connect_to_ex(cat_socket_t *socket, const char *name, size_t name_length, int port, cat_timeout_t timeout)
+/* zero-copy send */
+
+static void cat_socket_io_uring_send_callback(cat_io_uring_request_t *io_uring_request, int32_t result, uint32_t flags)
 {
-    CAT_LOG_DEBUG(SOCKET, "connect_to(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-        socket->id, (int) name_length, name, port, timeout);
+    cat_socket_io_uring_request_t *request = (cat_socket_io_uring_request_t *) io_uring_request;
 
-    cat_bool_t ret = cat_socket_connect_to_impl(socket, name, name_length, port, timeout, cat_false);
-
-    CAT_LOG_DEBUG(SOCKET, "connect_to(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
-        socket->id, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
-    CAT_LOG_DEBUG_SOCKET_ESTABLISHED(socket, connected, ret);
-
-    return ret;
+    /* the first CQE carries the result, buffers can be reused after the notification (F_NOTIF) */
+    if (!(flags & IORING_CQE_F_NOTIF)) {
+        request->u.send.result = result;
+    }
+    if (!(flags & IORING_CQE_F_MORE) && request->u.send.coroutine != NULL) {
+        cat_coroutine_schedule_deferrable(request->u.send.coroutine, SOCKET, "Zero-copy send");
+    }
 }
 
-CAT_API cat_bool_t cat_socket_try_connect(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length)
+static cat_always_inline cat_bool_t cat_socket_io_uring_send_is_busy(const cat_socket_io_uring_t *engine)
 {
-#ifdef CAT_ENABLE_DEBUG_LOG
-    char name[CAT_SOCKADDR_MAX_PATH];
-    size_t name_length = sizeof(name);
-    int port = 0;
-#endif
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
-            break;
-        }
-        CAT_LOG_DEBUG_D(SOCKET, "try_connect_to(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d) = " CAT_LOG_UNFINISHED_STR,
-            socket->id, (int) name_length, name, port);
-    });
+    return engine->send.request != NULL || !cat_queue_empty(&engine->send.waiters);
+}
 
-    cat_bool_t ret = cat_socket_connect_impl(socket, address, address_length, CAT_TIMEOUT_INVALID, cat_true);
+static cat_bool_t cat_socket_internal_io_uring_send_wait(cat_socket_internal_t *socket_i, cat_socket_io_uring_t *engine, cat_timeout_t timeout)
+{
+    cat_coroutine_t *coroutine = CAT_COROUTINE_G(current);
+    cat_bool_t ret;
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "try_connect_to(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d) = " CAT_LOG_BOOL_RET_FMT,
-            socket->id, (int) name_length, name, port, CAT_LOG_BOOL_RET_C(ret));
-    });
+    cat_queue_push_back(&engine->send.waiters, &coroutine->waiter.node);
+    ret = cat_time_wait(timeout);
+    cat_queue_remove(&coroutine->waiter.node);
+    if (unlikely(!ret)) {
+        cat_update_last_error_with_previous("Socket write wait failed");
+        return cat_false;
+    }
+    if (unlikely(socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_CLOSED)) {
+        cat_update_last_error(CAT_ECANCELED, "Socket write has been canceled");
+        return cat_false;
+    }
 
-    return ret;
+    return cat_true;
 }
 
-CAT_API cat_bool_t cat_socket_try_connect_to(cat_socket_t *socket, const char *name, size_t name_length, int port)
+static void cat_socket_io_uring_send_notify(cat_socket_io_uring_t *engine)
 {
-    CAT_LOG_DEBUG(SOCKET, "try_connect(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d) = " CAT_LOG_UNFINISHED_STR,
-        socket->id, (int) name_length, name, port);
-
-    cat_bool_t ret = cat_socket_connect_to_impl(socket, name, name_length, port, CAT_TIMEOUT_INVALID, cat_true);
-
-    CAT_LOG_DEBUG(SOCKET, "try_connect(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d) = " CAT_LOG_BOOL_RET_FMT,
-        socket->id, (int) name_length, name, port, CAT_LOG_BOOL_RET_C(ret));
+    cat_coroutine_t *waiter;
 
-    return ret;
+    /* resume writers in order until one of them starts a new zero-copy send */
+    while (engine->send.request == NULL &&
+        (waiter = cat_queue_front_data(&engine->send.waiters, cat_coroutine_t, waiter.node)) != NULL) {
+        cat_coroutine_schedule(waiter, SOCKET, "Zero-copy send");
+    }
 }
 
-#ifdef CAT_SSL
-CAT_API void cat_socket_crypto_options_init(cat_socket_crypto_options_t *options, cat_bool_t is_client)
+static void cat_socket_internal_io_uring_send_abort(cat_socket_internal_t *socket_i, cat_socket_io_uring_t *engine)
 {
-    options->is_client = is_client;
-    options->peer_name = NULL;
-    options->ca_file = NULL;
-    options->ca_path = NULL;
-    options->certificate = NULL;
-    options->certificate_key = NULL;
-    options->passphrase = NULL;
-#ifdef CAT_SSL_HAVE_SECURITY_LEVEL
-    options->security_level = CAT_SSL_DEFAULT_SECURITY_LEVEL;
-#endif
-#ifdef CAT_SSL_HAVE_TLS_ALPN
-    options->alpn_protocols = NULL;
-#endif
-    options->protocols = CAT_SSL_PROTOCOLS_DEFAULT;
-    options->verify_depth = CAT_SSL_DEFAULT_STREAM_VERIFY_DEPTH;
-    options->verify_peer = is_client;
-    options->verify_peer_name = is_client;
-    options->allow_self_signed = cat_false;
-    options->no_ticket = cat_false;
-    options->no_compression = cat_false;
-    options->no_client_ca_list = cat_false;
-}
+    cat_socket_io_uring_request_t *request = engine->send.request;
+    struct sockaddr address;
 
-/* TODO: Support non-blocking SSL handshake? (just for PHP, stupid design) */
+    if (request == NULL || request->canceled) {
+        return;
+    }
+    request->canceled = cat_true;
+    cat_io_uring_cancel(&request->request);
+    /* data which has been queued in socket can not be canceled, kernel references it until peer acknowledges it,
+     * so we reset the connection (connect(AF_UNSPEC) disconnects TCP and purges the write queue) to release it */
+    memset(&address, 0, sizeof(address));
+    address.sa_family = AF_UNSPEC;
+    (void) connect(cat_socket_internal_get_fd_fast(socket_i), &address, sizeof(address));
+}
 
-static cat_bool_t cat_socket_enable_crypto_impl(cat_socket_t *socket, const cat_socket_crypto_options_t *options, cat_timeout_t timeout)
+/* it returns CAT_RET_NONE if data should be sent by libuv */
+static cat_ret_t cat_socket_internal_io_uring_write(
+    cat_socket_internal_t *socket_i,
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    cat_timeout_t timeout
+)
 {
-    /* TODO: DTLS support */
-    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(socket, socket_i, CAT_SOCKET_IO_FLAG_RDWR, return cat_false);
-    CAT_SOCKET_INTERNAL_INET_STREAM_ONLY(socket_i, return cat_false);
-    if (unlikely(socket_i->ssl != NULL && cat_ssl_is_established(socket_i->ssl))) {
-        CAT_SOCKET_INTERNAL_ESTABLISHED_ONCE(socket_i, return cat_false);
-    } else {
-        CAT_SOCKET_INTERNAL_ESTABLISHED_ONLY(socket_i, return cat_false);
+    cat_socket_write_context_t *context = &socket_i->context.io.write;
+    cat_coroutine_t *coroutine = CAT_COROUTINE_G(current);
+    cat_socket_io_uring_t *engine;
+    cat_socket_io_uring_request_t *request;
+    cat_ret_t ret = CAT_RET_ERROR;
+    cat_bool_t abandoned = cat_false;
+    size_t length = 0, sent = 0;
+    unsigned int n, offset = 0;
+
+    /* small writes are coalesced or written by libuv, also wait for in-flight writes to keep the order of data,
+     * AF_UNIX does not support zero-copy */
+    if (CAT_SOCKET_G(io_uring.zerocopy_threshold) == 0 ||
+        socket_i->u.handle.type != UV_TCP ||
+        context->requests != 0 || context->batch != NULL ||
+        socket_i->u.stream.write_queue_size != 0 ||
+        vector_count > CAT_SOCKET_WRITE_COALESCING_MAX_VECTORS) {
+        return CAT_RET_NONE;
     }
-    cat_ssl_t *ssl;
-    cat_ssl_context_t *context = NULL;
-    cat_buffer_t *buffer;
-    cat_socket_crypto_options_t ioptions;
-    cat_bool_t use_tmp_context;
-    cat_bool_t ret = cat_false;
-
-    /* check options */
-    if (options == NULL) {
-        cat_bool_t is_client = !cat_socket_is_server_connection(socket);
-        cat_socket_crypto_options_init(&ioptions, is_client);
-    } else {
-        ioptions = *options;
+#ifdef CAT_SSL
+    if (socket_i->ssl != NULL) {
+        return CAT_RET_NONE;
     }
-    if (ioptions.peer_name == NULL) {
-        ioptions.peer_name = socket_i->ssl_peer_name;
+#endif
+    for (n = 0; n < vector_count; n++) {
+        length += vector[n].length;
     }
-    if (ioptions.verify_peer_name && ioptions.peer_name == NULL) {
-        cat_update_last_error(CAT_EINVAL, "SSL verify peer name is enabled but peer name is empty");
-        goto _prepare_error;
+    if (length < CAT_SOCKET_G(io_uring.zerocopy_threshold)) {
+        return CAT_RET_NONE;
+    }
+    engine = cat_socket_internal_get_io_uring(socket_i);
+    if (engine == NULL || engine->send.unsupported) {
+        return CAT_RET_NONE;
+    }
+    if (vector_count > 1 && !cat_io_uring_is_available(IORING_OP_SENDMSG_ZC)) {
+        return CAT_RET_NONE;
     }
 
-    /* check context (TODO: support context from arg?) */
-    use_tmp_context = context == NULL;
-    if (use_tmp_context) {
-        cat_ssl_method_t method;
-        if (socket_i->type & CAT_SOCKET_TYPE_FLAG_STREAM) {
-            method = CAT_SSL_METHOD_TLS;
-        } else /* if (socket->type & CAT_SOCKET_TYPE_FLAG_DGRAM) */ {
-            method = CAT_SSL_METHOD_DTLS;
-        }
-        context = cat_ssl_context_create(method, ioptions.protocols);
-        if (unlikely(context == NULL)) {
-            goto _prepare_error;
-        }
+    request = cat_socket_io_uring_request_create(
+        socket_i, offsetof(cat_socket_io_uring_request_t, vectors) + sizeof(struct iovec) * CAT_MAX(vector_count, 1),
+        vector_count == 1 ? IORING_OP_SEND_ZC : IORING_OP_SENDMSG_ZC, cat_socket_io_uring_send_callback
+    );
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(request == NULL)) {
+        return CAT_RET_NONE;
     }
+#endif
+    memcpy(request->vectors, vector, sizeof(*vector) * vector_count);
+    request->request.sqe.msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+    engine->send.request = request;
+    socket_i->io_flags |= CAT_SOCKET_IO_FLAG_WRITE;
+    cat_queue_push_back(&context->coroutines, &coroutine->waiter.node);
 
-    if (ioptions.verify_peer) {
-        if (!ioptions.is_client && !ioptions.no_client_ca_list && ioptions.ca_file != NULL) {
-            if (!cat_ssl_context_set_client_ca_list(context, ioptions.ca_file)) {
-                goto _setup_error;
+    while (1) {
+        struct io_uring_sqe *sqe = &request->request.sqe;
+        cat_bool_t wait_ret;
+        int32_t result;
+
+        if (sqe->opcode == IORING_OP_SEND_ZC) {
+            sqe->addr = (uint64_t) (uintptr_t) request->vectors[offset].iov_base;
+            sqe->len = (uint32_t) request->vectors[offset].iov_len;
+        } else {
+            request->u.send.msg.msg_iov = request->vectors + offset;
+            request->u.send.msg.msg_iovlen = vector_count - offset;
+            sqe->addr = (uint64_t) (uintptr_t) &request->u.send.msg;
+            sqe->len = 1;
+        }
+        request->u.send.result = -ECANCELED;
+        request->u.send.coroutine = coroutine;
+        if (unlikely(!cat_io_uring_submit(&request->request))) {
+            if (sent == 0) {
+                engine->send.unsupported = cat_true;
+                ret = CAT_RET_NONE;
+            } else {
+                cat_update_last_error_with_previous("Socket write failed");
             }
+            break;
         }
-        if (ioptions.ca_file  != NULL || ioptions.ca_path != NULL) {
-            if (!cat_ssl_context_load_verify_locations(context, ioptions.ca_file, ioptions.ca_path)) {
-                goto _setup_error;
+        CAT_TIME_WAIT_START() {
+            wait_ret = cat_time_wait(timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(request->request.state != CAT_IO_URING_REQUEST_STATE_NONE)) {
+            /* timed out or canceled, but kernel keeps referencing the data until the notification (F_NOTIF),
+             * caller may free or reuse it as soon as we return, so we must wait for it without timeout */
+            cat_errno_t error = wait_ret ? CAT_ECANCELED : cat_get_last_error_code();
+            /* we should not be canceled by socket_close() again */
+            cat_queue_remove(&coroutine->waiter.node);
+            abandoned = cat_true;
+            cat_socket_internal_io_uring_send_abort(socket_i, engine);
+            do {
+                (void) cat_time_wait(-1);
+            } while (request->request.state != CAT_IO_URING_REQUEST_STATE_NONE);
+            if (error == CAT_ECANCELED) {
+                cat_update_last_error(CAT_ECANCELED, "Socket write has been canceled");
+            } else {
+                cat_update_last_error(error, "Socket write wait failed");
             }
-        } else {
-#ifndef CAT_OS_WIN
-            /* check context related options */
-            if (ioptions.is_client && !cat_ssl_context_set_default_verify_paths(context)) {
-                goto _setup_error;
+            break;
+        }
+        request->u.send.coroutine = NULL;
+        result = request->u.send.result;
+        if (unlikely(result <= 0)) {
+            if (result == -EOPNOTSUPP && sent == 0) {
+                /* e.g. kTLS, fallback to libuv */
+                engine->send.unsupported = cat_true;
+                ret = CAT_RET_NONE;
+            } else {
+                cat_update_last_error_with_reason(result == 0 ? CAT_ECONNRESET : cat_translate_sys_error(-result), "Socket write failed");
             }
-#else
-            cat_ssl_context_configure_cert_verify_callback(context);
-#endif
+            break;
         }
-        cat_ssl_context_set_verify_depth(context, ioptions.verify_depth);
-        cat_ssl_context_enable_verify_peer(context);
-    } else {
-        cat_ssl_context_disable_verify_peer(context);
-    }
-    if (ioptions.passphrase != NULL) {
-        if (!cat_ssl_context_set_passphrase(context, ioptions.passphrase, strlen(ioptions.passphrase))) {
-            goto _setup_error;
+        sent += (size_t) result;
+        while (offset < vector_count && (size_t) result >= request->vectors[offset].iov_len) {
+            result -= (int32_t) request->vectors[offset].iov_len;
+            offset++;
         }
-    }
-    if (ioptions.certificate != NULL) {
-        if (!cat_ssl_context_set_certificate(context, ioptions.certificate, ioptions.certificate_key)) {
-            goto _setup_error;
+        if (offset == vector_count) {
+            ret = CAT_RET_OK;
+            break;
         }
+        request->vectors[offset].iov_base = (char *) request->vectors[offset].iov_base + result;
+        request->vectors[offset].iov_len -= result;
     }
-    if (ioptions.no_ticket) {
-        cat_ssl_context_set_no_ticket(context);
+
+    if (likely(!abandoned)) {
+        cat_queue_remove(&coroutine->waiter.node);
     }
-    if (ioptions.no_compression) {
-        cat_ssl_context_set_no_compression(context);
+    engine->send.request = NULL;
+    cat_io_uring_request_release(&request->request);
+    if (unlikely(engine->send.close_pending)) {
+        /* socket has been closed during draining */
+        cat_socket_internal_free(socket_i);
+        return ret;
     }
-#ifdef CAT_SSL_HAVE_SECURITY_LEVEL
-    cat_ssl_context_set_security_level(context, ioptions.security_level);
-#endif
-#ifdef CAT_SSL_HAVE_TLS_ALPN
-    if (ioptions.alpn_protocols != NULL) {
-        if (!cas_ssl_context_set_alpn_protocols(context, ioptions.is_client, ioptions.alpn_protocols)) {
-            goto _setup_error;
-        }
+    if (cat_queue_empty(&context->coroutines)) {
+        socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_WRITE;
     }
-#endif
-    /* create ssl connection */
-    ssl = cat_ssl_create(NULL, context);
-    if (use_tmp_context) {
-        /* deref/free context */
-        cat_ssl_context_close(context);
+    if (unlikely(abandoned)) {
+        cat_socket_internal_unrecoverable_io_error(socket_i);
+    } else {
+        cat_socket_io_uring_send_notify(engine);
     }
-    if (unlikely(ssl == NULL)) {
-        goto _prepare_error;
+
+    return ret;
+}
+
+/* detach */
+
+/* stop using io_uring on the socket (e.g. before kTLS takes over the fd),
+ * it waits for the last completion of multishot recv so that no data is lost,
+ * data which has been read ahead is still consumed by readers before they fall back to libuv,
+ * caller must make sure that socket is not being read or written */
+static cat_bool_t cat_socket_internal_io_uring_detach(cat_socket_internal_t *socket_i, cat_timeout_t timeout)
+{
+    cat_socket_io_uring_t *engine = socket_i->io_uring;
+    cat_socket_io_uring_request_t *request;
+
+    socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_NO_IO_URING;
+    if (engine == NULL) {
+        return cat_true;
+    }
+    if (unlikely(cat_socket_io_uring_send_is_busy(engine))) {
+        cat_update_last_error(CAT_EBUSY, "Socket io_uring engine is busy with zero-copy send");
+        return cat_false;
+    }
+    engine->send.unsupported = cat_true;
+    engine->recv.detached = cat_true;
+    request = engine->recv.request;
+    if (request == NULL || request->request.state == CAT_IO_URING_REQUEST_STATE_NONE) {
+        return cat_true;
+    }
+    if (!request->canceled) {
+        request->canceled = cat_true;
+        cat_io_uring_cancel(&request->request);
     }
+    /* data may still arrive until the last completion */
+    do {
+        cat_errno_t error;
+        engine->recv.target = NULL;
+        error = cat_socket_internal_io_uring_recv_wait(socket_i, engine, timeout);
+        if (unlikely(error != 0)) {
+            if (error == CAT_ECANCELED) {
+                cat_update_last_error(CAT_ECANCELED, "Socket io_uring engine detaching has been canceled");
+            } else {
+                cat_update_last_error_with_previous("Socket io_uring engine detaching failed");
+            }
+            return cat_false;
+        }
+    } while (request->request.state != CAT_IO_URING_REQUEST_STATE_NONE);
 
-    /* set state */
-    if (!ioptions.is_client) {
-        cat_ssl_set_accept_state(ssl);
-    } else {
-        cat_ssl_set_connect_state(ssl);
+    return cat_true;
+}
+
+/* close */
+
+static void cat_socket_internal_io_uring_close(cat_socket_internal_t *socket_i)
+{
+    cat_socket_io_uring_t *engine = socket_i->io_uring;
+    cat_coroutine_t *waiter;
+    unsigned int n;
+
+    if (engine == NULL) {
+        return;
+    }
+    cat_socket_io_uring_request_detach(engine->recv.request);
+    engine->recv.request = NULL;
+    cat_socket_io_uring_request_detach(engine->accept.request);
+    engine->accept.request = NULL;
+    /* fd will be closed soon, release data of the zero-copy send in flight while we can */
+    cat_socket_internal_io_uring_send_abort(socket_i, engine);
+    while ((waiter = cat_queue_front_data(&engine->send.waiters, cat_coroutine_t, waiter.node))) {
+        cat_coroutine_schedule(waiter, SOCKET, "Cancel write");
     }
+    for (n = 0; n < engine->accept.count; n++) {
+        uv__close(engine->accept.fds[n]);
+    }
+    engine->accept.count = 0;
+}
 
-    /* connection related options */
-    if (ioptions.is_client && ioptions.peer_name != NULL) {
-        cat_ssl_set_sni_server_name(ssl, ioptions.peer_name);
+static void cat_socket_io_uring_free(cat_socket_io_uring_t *engine)
+{
+    cat_buffer_close(&engine->recv.buffer);
+    if (engine->accept.fds != NULL) {
+        cat_free(engine->accept.fds);
     }
-    ssl->allow_self_signed = ioptions.allow_self_signed;
+    cat_free(engine);
+}
+#endif /* CAT_HAVE_IO_URING_MULTISHOT */
 
-    buffer = &ssl->read_buffer;
+static void cat_socket_accept_connection_callback(uv_stream_t *stream, int status)
+{
+    cat_socket_internal_t *server_i = cat_container_of(stream, cat_socket_internal_t, u.stream);
 
-    while (1) {
-        ssize_t n;
-        cat_ssl_ret_t ssl_ret;
+    if (server_i->io_flags == CAT_SOCKET_IO_FLAG_ACCEPT) {
+        cat_coroutine_t *coroutine = server_i->context.accept.coroutine;
+        CAT_ASSERT(coroutine != NULL);
+        server_i->context.accept.data.status = status;
+        cat_coroutine_schedule_deferrable(coroutine, SOCKET, "Accept");
+    }
+    // else we can call uv_accept to get it later
+}
 
-        ssl_ret = cat_ssl_handshake(ssl);
-        if (unlikely(ssl_ret == CAT_SSL_RET_ERROR)) {
-            break;
-        }
-        /* ssl_read_encrypted_bytes() may return n > 0
-         * after ssl_handshake() return OK */
-        n = cat_ssl_read_encrypted_bytes(ssl, buffer->value, buffer->size);
-        if (unlikely(n == CAT_RET_ERROR)) {
-            break;
-        }
-        if (n > 0) {
-            cat_bool_t ret;
-            CAT_TIME_WAIT_START() {
-                ret = cat_socket_send_ex(socket, buffer->value, n, timeout);
-            } CAT_TIME_WAIT_END(timeout);
-            if (unlikely(!ret)) {
-                break;
-            }
+#define CAT_LOG_DEBUG_SOCKET_ESTABLISHED_SOCK_ONLY(socket, action, ret) \
+    CAT_LOG_DEBUG_VA(SOCKET, if (ret) { \
+        char sock_address[CAT_SOCKADDR_MAX_PATH] = "unknown"; \
+        size_t sock_address_length = sizeof(sock_address); \
+        cat_socket_get_sock_address(socket, sock_address, &sock_address_length); \
+        CAT_LOG_DEBUG_D(SOCKET, #action " %s { sock: {\"%.*s\", %d} }", \
+            cat_socket_get_type_name(socket), \
+            (int) sock_address_length, sock_address, cat_socket_get_sock_port(socket)); \
+    });
+
+static cat_always_inline cat_bool_t cat_socket_listen_impl(cat_socket_t *socket, int backlog)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    int error;
+
+    if (socket_i->accept_stats == NULL) {
+        socket_i->accept_stats = (cat_socket_accept_stats_t *) cat_malloc(sizeof(*socket_i->accept_stats));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(socket_i->accept_stats == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for socket accept stats failed");
+            return cat_false;
         }
-#if 0   /* FIXME: Disable it for now because we do not sure that whether it still works now,
-         * and it make SSL handshake hang on recv() forever on Linux. */
-        /* Notice: if it's client and it write something to the server,
-         * it means server will response something later, so, we need to recv it then returns,
-         * otherwise it will lead errors on Windows */
-#define CAT_SOCKET_SSL_HANDSHAKE_WORKAROUND_FOR_WINDOWS() !(n > 0 && ioptions.is_client)
-#else
-#define CAT_SOCKET_SSL_HANDSHAKE_WORKAROUND_FOR_WINDOWS() 1
 #endif
-        if (ssl_ret == CAT_SSL_RET_OK && CAT_SOCKET_SSL_HANDSHAKE_WORKAROUND_FOR_WINDOWS()) {
-            CAT_LOG_DEBUG(SOCKET, "Socket SSL handshake completed");
-            ret = cat_true;
-            break;
-        }
-        {
-            ssize_t nread, nwrite;
-            CAT_TIME_WAIT_START() {
-                nread = cat_socket_recv_ex(socket, buffer->value, buffer->size, timeout);
-            } CAT_TIME_WAIT_END(timeout);
-            if (unlikely(nread <= 0)) {
-                if (nread == 0) {
-                    cat_update_last_error_by_code(CAT_ECONNRESET);
-                }
-                break;
-            }
-            nwrite = cat_ssl_write_encrypted_bytes(ssl, buffer->value, nread);
-            if (unlikely(nwrite != nread)) {
-                break;
-            }
-            continue;
-        }
+        memset(socket_i->accept_stats, 0, sizeof(*socket_i->accept_stats));
     }
-
-    if (unlikely(!ret)) {
-        /* Notice: io error can not recover */
-        goto _unrecoverable_error;
+    error = uv_listen(&socket_i->u.stream, backlog, cat_socket_accept_connection_callback);
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "Socket listen(%d) failed", backlog);
+        return cat_false;
     }
-
-    if (ioptions.verify_peer) {
-        if (!cat_ssl_verify_peer(ssl, ioptions.allow_self_signed)) {
-            goto _unrecoverable_error;
-        }
+    socket_i->accept_stats->listen_time = cat_time_msec_cached();
+    /* note: socket maybe copied from the other one, so it may have already unref and in the internal tree. */
+    if (!(socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_SERVER)) {
+        uv_unref(&socket_i->u.handle);
+        cat_socket_internal_tree_insert(socket_i);
+        socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_SERVER;
     }
-    if (ioptions.verify_peer_name) {
-        if (!cat_ssl_check_host(ssl, ioptions.peer_name, strlen(ioptions.peer_name))) {
-            goto _unrecoverable_error;
+    if (socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_REUSEPORT_CPU_AFFINITY) {
+        if (unlikely(!cat_socket_internal_enable_reuseport_cpu_affinity(socket_i))) {
+            cat_update_last_error_with_previous("Socket listen(%d) failed", backlog);
+            return cat_false;
         }
+        socket_i->flags ^= CAT_SOCKET_INTERNAL_FLAG_REUSEPORT_CPU_AFFINITY;
     }
 
-    socket_i->ssl = ssl;
+    CAT_LOG_DEBUG_SOCKET_ESTABLISHED_SOCK_ONLY(socket, listened, cat_true);
 
     return cat_true;
-
-    _unrecoverable_error:
-    cat_socket_internal_unrecoverable_io_error(socket_i);
-    cat_ssl_close(ssl);
-    if (0) {
-        _setup_error:
-        cat_ssl_context_close(context);
-    }
-    _prepare_error:
-    cat_update_last_error_with_previous("Socket enable crypto failed");
-
-    return cat_false;
 }
 
-#define CAT_SOCKET_CRYPTO_OPTIONS_FMT \
-    "{ " \
-    "peer_name: \"%s\", " \
-    "ca_file: \"%s\", " \
-    "ca_path: \"%s\", " \
-    "certificate: \"%s\", " \
-    "certificate_key: \"%s\", " \
-    "passphrase: \"%s\", " \
-    "protocols: %s, " \
-    "verify_depth: %d, " \
-    "is_client: %s, " \
-    "verify_peer: %s, " \
-    "verify_peer_name: %s, " \
-    "allow_self_signed: %s, " \
-    "no_ticket: %s, " \
-    "no_compression: %s, " \
-    "no_client_ca_list: %s" \
-    " }"
+CAT_API cat_bool_t cat_socket_listen(cat_socket_t *socket, int backlog)
+{
+    cat_bool_t ret = cat_socket_listen_impl(socket, backlog);
 
-#define CAT_SOCKET_CRYPTO_OPTIONS_C(options, protocols_str) \
-    CAT_NULLABLE_STR_C(options.peer_name), \
-    CAT_NULLABLE_STR_C(options.ca_file), \
-    CAT_NULLABLE_STR_C(options.ca_path), \
-    CAT_NULLABLE_STR_C(options.certificate), \
-    CAT_NULLABLE_STR_C(options.certificate_key), \
-    CAT_NULLABLE_STR_C(options.passphrase), \
-    protocols_str, \
-    options.verify_depth, \
-    cat_bool_str(options.is_client), \
-    cat_bool_str(options.verify_peer), \
-    cat_bool_str(options.verify_peer_name), \
-    cat_bool_str(options.allow_self_signed), \
-    cat_bool_str(options.no_ticket), \
-    cat_bool_str(options.no_compression), \
-    cat_bool_str(options.no_client_ca_list)
+    CAT_LOG_DEBUG(SOCKET, "listen(" CAT_SOCKET_ID_FMT ", %d) = " CAT_LOG_BOOL_RET_FMT,
+        socket->id, backlog, CAT_LOG_BOOL_RET_C(ret));
 
-CAT_API cat_bool_t cat_socket_enable_crypto(cat_socket_t *socket, const cat_socket_crypto_options_t *options)
-{
-    return cat_socket_enable_crypto_ex(socket, options, cat_socket_get_handshake_timeout_fast(socket));
+    return ret;
 }
 
-CAT_API cat_bool_t cat_socket_enable_crypto_ex(cat_socket_t *socket, const cat_socket_crypto_options_t *options, cat_timeout_t timeout)
+static cat_always_inline cat_bool_t cat_socket_internal_check_accept_type(const cat_socket_internal_t *server_i, const cat_socket_internal_t *connection_i)
 {
-#ifdef CAT_ENABLE_DEBUG_LOG
-    cat_socket_crypto_options_t log_options = { 0 };
-    char *protocols_str = NULL;
-#endif
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        if (options == NULL) {
-            cat_socket_crypto_options_init(&log_options, !cat_socket_is_server_connection(socket));
-        } else {
-            log_options = *options;
-        }
-        protocols_str = cat_ssl_protocols_str(log_options.protocols);
-        CAT_LOG_DEBUG_D(SOCKET, "enable_crypto(" CAT_SOCKET_ID_FMT ", " \
-            "options: " CAT_SOCKET_CRYPTO_OPTIONS_FMT ", " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, CAT_SOCKET_CRYPTO_OPTIONS_C(log_options, protocols_str), timeout);
-    });
+    cat_socket_type_t server_type = cat_socket_type_simplify(server_i->type);
+    cat_socket_type_t connection_type = connection_i->type;
 
-    cat_bool_t ret = cat_socket_enable_crypto_impl(socket, options, timeout);
+    if (unlikely((server_type & connection_type) != server_type)) {
+        cat_update_last_error(CAT_EINVAL, "Socket accept connection type mismatch, expect %s but got %s",
+            cat_socket_type_get_name(server_type), cat_socket_type_get_name(connection_type));
+        return cat_false;
+    }
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "enable_crypto(" CAT_SOCKET_ID_FMT ", " \
-            "options: " CAT_SOCKET_CRYPTO_OPTIONS_FMT ", " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
-            socket->id, CAT_SOCKET_CRYPTO_OPTIONS_C(log_options, protocols_str), timeout, CAT_LOG_BOOL_RET_C(ret));
-        cat_buffer_str_free(protocols_str);
-    });
+    return cat_true;
+}
 
-    return ret;
+static cat_always_inline void cat_socket_internal_on_accepted(
+    cat_socket_internal_t *server_i, cat_socket_internal_t *connection_i,
+    cat_socket_inheritance_info_t *handle_info
+) {
+    /* init client properties */
+    connection_i->flags |= (CAT_SOCKET_INTERNAL_FLAG_ESTABLISHED | CAT_SOCKET_INTERNAL_FLAG_SERVER_CONNECTION);
+    /* TODO: socket_extends() ? */
+    memcpy(&connection_i->options, handle_info == NULL ? &server_i->options : &handle_info->options, sizeof(connection_i->options));
+    cat_socket_internal_on_open(connection_i, cat_socket_type_to_af(handle_info == NULL ? server_i->type : handle_info->type));
 }
 
-#if 0
-/* TODO: BIO SSL shutdown
- * we must cancel all IO operations and mark this socket unavailable temporarily,
- * then read or write on it to shutdown SSL connection */
-CAT_API cat_bool_t cat_socket_disable_crypto(cat_socket_t *socket)
-{
-    if (!cat_socket_is_encrypted(socket)) {
-        return cat_true;
+static cat_bool_t cat_socket_internal_accept(
+    cat_socket_internal_t *server_i, cat_socket_internal_t *connection_i,
+    cat_socket_inheritance_info_t *handle_info, cat_timeout_t timeout
+) {
+    int error;
+
+    if (handle_info == NULL) {
+        if (unlikely(!cat_socket_internal_check_accept_type(server_i, connection_i))) {
+            return cat_false;
+        }
     }
-    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(socket, socket_i, CAT_SOCKET_IO_FLAG_RDWR, return cat_false);
-    cat_ssl_t *ssl = socket_i->ssl;
 
     while (1) {
-        cat_ssl_ret_t ret = cat_ssl_shutdown(ssl);
-        if (ret == 1) {
-            cat_ssl_close(ssl);
+        cat_bool_t ret;
+        error = uv_accept(&server_i->u.stream, &connection_i->u.stream);
+        if (error == 0) {
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+            cat_socket_internal_io_uring_on_uv_accepted(server_i);
+#endif
+            cat_socket_internal_on_accepted(server_i, connection_i, handle_info);
             return cat_true;
         }
-        // read or write...
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+        if (error == CAT_EAGAIN && handle_info == NULL) {
+            cat_socket_io_uring_t *engine = cat_socket_internal_get_io_uring(server_i);
+            if (engine != NULL) {
+                error = cat_socket_internal_io_uring_accept(server_i, engine, connection_i);
+                if (error == 0) {
+                    cat_socket_internal_on_accepted(server_i, connection_i, handle_info);
+                    return cat_true;
+                }
+            }
+        }
+#endif
+        if (unlikely(error != CAT_EAGAIN)) {
+            cat_update_last_error_with_reason(error, "Socket accept failed");
+            break;
+        }
+        uv_ref(&server_i->u.handle);
+        server_i->context.accept.data.status = CAT_ECANCELED;
+        server_i->context.accept.coroutine = CAT_COROUTINE_G(current);
+        server_i->io_flags = CAT_SOCKET_IO_FLAG_ACCEPT;
+        ret = cat_time_wait(timeout);
+        server_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
+        server_i->context.accept.coroutine = NULL;
+        uv_unref(&server_i->u.handle);
+        if (unlikely(!ret)) {
+            cat_update_last_error_with_previous("Socket accept wait failed");
+            break;
+        }
+        if (unlikely(server_i->context.accept.data.status == CAT_ECANCELED)) {
+            cat_update_last_error(CAT_ECANCELED, "Socket accept has been canceled");
+            break;
+        }
     }
+
+    return cat_false;
 }
+
+/* accept without waiting, it drains the accept queue of kernel if libuv has not accepted one in advance */
+static cat_bool_t cat_socket_internal_try_accept(cat_socket_internal_t *server_i, cat_socket_internal_t *connection_i)
+{
+    int error;
+
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    cat_socket_io_uring_t *engine = server_i->io_uring;
+
+    if (engine != NULL && engine->accept.count == 0 && engine->accept.request != NULL &&
+        engine->accept.request->request.state == CAT_IO_URING_REQUEST_STATE_INFLIGHT) {
+        /* accept queue of kernel is drained by io_uring */
+        cat_io_uring_reap();
+    }
+    if (engine != NULL && engine->accept.count > 0) {
+        error = cat_socket_internal_io_uring_accept(server_i, engine, connection_i);
+    } else
+#endif
+    error = uv_accept(&server_i->u.stream, &connection_i->u.stream);
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    if (error == 0) {
+        cat_socket_internal_io_uring_on_uv_accepted(server_i);
+    }
 #endif
+#ifndef CAT_OS_WIN
+    if (error == CAT_EAGAIN) {
+        int fd;
+        do {
+            fd = uv__accept(server_i->u.stream.io_watcher.fd);
+        } while (unlikely(fd == CAT_ECONNABORTED));
+        if (fd >= 0) {
+            error = cat_socket_internal_open_accepted_fd(connection_i, fd);
+        } else {
+            error = fd;
+        }
+    }
 #endif
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "Socket try accept failed");
+        return cat_false;
+    }
+    cat_socket_internal_on_accepted(server_i, connection_i, NULL);
 
-static int cat_socket_internal_getname(const cat_socket_internal_t *socket_i, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_bool_t is_peer)
+    return cat_true;
+}
+
+static cat_always_inline void cat_socket_internal_on_accept_stats(cat_socket_internal_t *server_i, cat_bool_t new_round)
 {
-    cat_socket_type_t type = socket_i->type;
-    cat_sockaddr_info_t *cache = !is_peer ? socket_i->cache.sockname : socket_i->cache.peername;
-    int error;
+    cat_socket_accept_stats_t *stats = server_i->accept_stats;
 
-    if (address_length != NULL && ((int) *address_length) < 0) {
-        error = CAT_EINVAL;
-    } else if (cache != NULL) {
-        /* use cache */
-        error = cat_sockaddr_copy(address, address_length, &cache->address.common, cache->length);
-    } else {
-        error = CAT_EAFNOSUPPORT;
-        if (type & CAT_SOCKET_TYPE_FLAG_INET) {
-            int length = *address_length; /* sizeof(cat_socklen_t) is not always equal to sizeof(int) */
-            if ((type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP)  {
-                if (!is_peer) {
-                    error = uv_tcp_getsockname(&socket_i->u.tcp, address, &length);
-                } else {
-                    error = uv_tcp_getpeername(&socket_i->u.tcp, address, &length);
-                }
-            } else if ((type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP) {
-                if (!is_peer) {
-                    error = uv_udp_getsockname(&socket_i->u.udp, address, &length);
-                } else {
-                    error = uv_udp_getpeername(&socket_i->u.udp, address, &length);
-                }
-            }
-            *address_length = length;
-        } else if (type & CAT_SOCKET_TYPE_FLAG_LOCAL) {
-            cat_sockaddr_local_t local;
-            size_t length = sizeof(local.sl_path);
-            if (!is_peer) {
-                error = uv_pipe_getsockname(&socket_i->u.pipe, local.sl_path, &length);
-            } else {
-                error = uv_pipe_getpeername(&socket_i->u.pipe, local.sl_path, &length);
-            }
-            if (error == 0 || error == CAT_ENOBUFS) {
-                local.sl_family = AF_LOCAL;
-                /* Notice: the returned length no longer includes the terminating null byte,
-                * and the buffer is not null terminated only if it's linux abstract name. */
-                length = CAT_SOCKADDR_HEADER_LENGTH + length + !cat_sockaddr_is_linux_abstract_name(local.sl_path, length);
-                memcpy(address, &local, CAT_MIN((size_t) *address_length, length));
-                *address_length = (cat_socklen_t) length;
-            }
-        }
+    if (unlikely(stats == NULL)) {
+        return;
     }
-
-    return error;
+    stats->count++;
+    if (new_round) {
+        stats->rounds++;
+        stats->last_batch_size = 0;
+    }
+    stats->last_batch_size++;
+    if (stats->last_batch_size > stats->max_batch_size) {
+        stats->max_batch_size = stats->last_batch_size;
+    }
+    stats->last_accept_time = cat_time_msec_cached();
 }
 
-static const cat_sockaddr_info_t *cat_socket_internal_getname_fast(cat_socket_internal_t *socket_i, cat_bool_t is_peer, int *error_ptr)
+static cat_always_inline cat_socket_internal_t *cat_socket_accept_get_connection_internal(cat_socket_t *connection)
 {
-    cat_sockaddr_info_t *cache, **cache_ptr;
-    cat_sockaddr_info_t tmp;
-    size_t size;
-    int error = 0;
-
-    if (!is_peer) {
-        cache_ptr = &socket_i->cache.sockname;
-    } else {
-        cache_ptr = &socket_i->cache.peername;
-    }
-    cache = *cache_ptr;
-    if (cache != NULL) {
-        goto _out;
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(connection, connection_i, {
+        cat_update_last_error(CAT_EINVAL, "Socket accept can not act on an unavailable socket");
+        return NULL;
+    });
+    if (unlikely(cat_socket_is_open(connection))) {
+        cat_update_last_error(CAT_EMISUSE, "Socket accept can only act on a lazy socket");
+        return NULL;
     }
-    tmp.length = sizeof(tmp.address);
-    error = cat_socket_internal_getname(socket_i, &tmp.address.common, &tmp.length, is_peer);
-    if (unlikely(error != 0 && error != CAT_ENOSPC)) {
-        goto _out;
+
+    return connection_i;
+}
+
+static cat_bool_t cat_socket_internal_recv_handle(cat_socket_internal_t *socket_i, cat_socket_internal_t *ihandle, cat_timeout_t timeout);
+
+static cat_always_inline cat_bool_t cat_socket_accept_impl(cat_socket_t *server, cat_socket_t *connection, cat_timeout_t timeout)
+{
+    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(server, server_i, CAT_SOCKET_IO_FLAG_ACCEPT, return cat_false);
+    if (!(server_i->type & CAT_SOCKET_TYPE_FLAG_IPC)) {
+        CAT_SOCKET_INTERNAL_SERVER_ONLY(server_i, return cat_false);
     }
-    size = offsetof(cat_sockaddr_info_t, address) + tmp.length;
-    cache = (cat_sockaddr_info_t *) cat_malloc(size);
-#if CAT_ALLOC_HANDLE_ERRORS
-    if (unlikely(cache == NULL)) {
-        error = cat_translate_sys_error(cat_sys_errno);
-        goto _out;
+    cat_socket_internal_t *connection_i = cat_socket_accept_get_connection_internal(connection);
+    if (unlikely(connection_i == NULL)) {
+        return cat_false;
     }
-#endif
-    if (error != 0) {
-        /* ENOSPC, retry now */
-        error = cat_socket_internal_getname(socket_i, &cache->address.common, &cache->length, is_peer);
-        if (unlikely(error != 0)) {
-            /* almost impossible */
-            cat_free(cache);
-            goto _out;
+
+    if (!(server_i->type & CAT_SOCKET_TYPE_FLAG_IPC)) {
+        if (unlikely(!cat_socket_internal_accept(server_i, connection_i, NULL, timeout))) {
+            return cat_false;
         }
+        cat_socket_internal_on_accept_stats(server_i, cat_true);
+        return cat_true;
     } else {
-        memcpy(cache, &tmp, size);
+        CAT_LOG_DEBUG_V2(SOCKET, "accept() via IPC");
+        return cat_socket_internal_recv_handle(server_i, connection_i, timeout);
     }
-    *cache_ptr = cache;
+}
 
-    _out:
-    if (error_ptr != NULL) {
-        *error_ptr = error;
-    }
-    if (unlikely(error != 0)) {
-        return NULL;
-    }
-    return cache;
+#define CAT_LOG_DEBUG_SOCKET_ESTABLISHED(socket, action, ret) \
+    CAT_LOG_DEBUG_VA(SOCKET, if (ret) { \
+        char sock_address[CAT_SOCKADDR_MAX_PATH] = "unknown", peer_address[CAT_SOCKADDR_MAX_PATH] = "unknown"; \
+        size_t sock_address_length = sizeof(sock_address), peer_address_length = sizeof(peer_address); \
+        cat_socket_get_sock_address(socket, sock_address, &sock_address_length); \
+        cat_socket_get_peer_address(socket, peer_address, &peer_address_length); \
+        CAT_LOG_DEBUG_D(SOCKET, #action " %s { sock: {\"%.*s\", %d}, peer: {\"%.*s\", %d} }", \
+            cat_socket_get_type_name(socket), \
+            (int) sock_address_length, sock_address, cat_socket_get_sock_port(socket), \
+            (int) peer_address_length, peer_address, cat_socket_get_peer_port(socket)); \
+    });
+
+CAT_API cat_bool_t cat_socket_accept(cat_socket_t *server, cat_socket_t *connection)
+{
+    return cat_socket_accept_ex(server, connection, cat_socket_get_accept_timeout_fast(server));
 }
 
-CAT_API cat_bool_t cat_socket_getname(const cat_socket_t *socket, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_bool_t is_peer)
+CAT_API cat_bool_t cat_socket_accept_ex(cat_socket_t *server, cat_socket_t *connection, cat_timeout_t timeout)
 {
-    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
-    int error;
+    CAT_LOG_DEBUG(SOCKET, "accept(" CAT_SOCKET_ID_FMT ", " CAT_TIMEOUT_FMT ") = "  CAT_LOG_UNFINISHED_STR,
+        server->id, timeout);
 
-    error = cat_socket_internal_getname(socket_i, address, address_length, is_peer);
+    cat_bool_t ret = cat_socket_accept_impl(server, connection, timeout);
 
-    if (unlikely(error != 0)) {
-        cat_update_last_error_with_reason(error, "Socket get%sname failed", !is_peer ? "sock" : "peer");
+    CAT_LOG_DEBUG(SOCKET, "accept(" CAT_SOCKET_ID_FMT ", " CAT_TIMEOUT_FMT ") = " CAT_SOCKET_ID_FMT  CAT_LOG_STRERRNO_FMT,
+        server->id, timeout, ret ? connection->id : CAT_SOCKET_INVALID_ID, CAT_LOG_STRERRNO_C(ret, cat_get_last_error_code()));
+    CAT_LOG_DEBUG_SOCKET_ESTABLISHED(connection, accepted, ret);
+
+    return ret;
+}
+
+static cat_always_inline cat_bool_t cat_socket_try_accept_impl(cat_socket_t *server, cat_socket_t *connection)
+{
+    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(server, server_i, CAT_SOCKET_IO_FLAG_ACCEPT, return cat_false);
+    CAT_SOCKET_INTERNAL_SERVER_ONLY(server_i, return cat_false);
+    cat_socket_internal_t *connection_i = cat_socket_accept_get_connection_internal(connection);
+    if (unlikely(connection_i == NULL)) {
+        return cat_false;
+    }
+    if (unlikely(!cat_socket_internal_check_accept_type(server_i, connection_i))) {
+        return cat_false;
+    }
+
+    if (!cat_socket_internal_try_accept(server_i, connection_i)) {
         return cat_false;
     }
+    cat_socket_internal_on_accept_stats(server_i, cat_false);
 
     return cat_true;
 }
 
-CAT_API cat_bool_t cat_socket_getsockname(const cat_socket_t *socket, cat_sockaddr_t *address, cat_socklen_t *length)
+CAT_API cat_bool_t cat_socket_try_accept(cat_socket_t *server, cat_socket_t *connection)
 {
-    return cat_socket_getname(socket, address, length, cat_false);
-}
+    cat_bool_t ret = cat_socket_try_accept_impl(server, connection);
 
-CAT_API cat_bool_t cat_socket_getpeername(const cat_socket_t *socket, cat_sockaddr_t *address, cat_socklen_t *length)
-{
-    return cat_socket_getname(socket, address, length, cat_true);
+    CAT_LOG_DEBUG(SOCKET, "try_accept(" CAT_SOCKET_ID_FMT ") = " CAT_SOCKET_ID_FMT  CAT_LOG_STRERRNO_FMT,
+        server->id, ret ? connection->id : CAT_SOCKET_INVALID_ID, CAT_LOG_STRERRNO_C(ret, cat_get_last_error_code()));
+    CAT_LOG_DEBUG_SOCKET_ESTABLISHED(connection, accepted, ret);
+
+    return ret;
 }
 
-CAT_API const cat_sockaddr_info_t *cat_socket_getname_fast(cat_socket_t *socket, cat_bool_t is_peer)
+static cat_always_inline ssize_t cat_socket_accept_multiple_impl(cat_socket_t *server, cat_socket_t **connections, size_t count, cat_timeout_t timeout)
 {
-    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return NULL);
-    const cat_sockaddr_info_t *cache;
-    int error;
+    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(server, server_i, CAT_SOCKET_IO_FLAG_ACCEPT, return -1);
+    CAT_SOCKET_INTERNAL_SERVER_ONLY(server_i, return -1);
+    cat_socket_internal_t *connection_i;
+    size_t n;
 
-    cache = cat_socket_internal_getname_fast(socket_i, is_peer, &error);
+    if (unlikely(count == 0)) {
+        cat_update_last_error(CAT_EINVAL, "Socket accept multiple count can not be zero");
+        return -1;
+    }
+    for (n = 0; n < count; n++) {
+        connection_i = cat_socket_accept_get_connection_internal(connections[n]);
+        if (unlikely(connection_i == NULL)) {
+            return -1;
+        }
+        if (unlikely(!cat_socket_internal_check_accept_type(server_i, connection_i))) {
+            return -1;
+        }
+    }
 
-    if (cache == NULL) {
-        cat_update_last_error_with_reason(error, "Socket get%sname fast failed", !is_peer ? "sock" : "peer");
+    if (unlikely(!cat_socket_internal_accept(server_i, connections[0]->internal, NULL, timeout))) {
+        return -1;
+    }
+    cat_socket_internal_on_accept_stats(server_i, cat_true);
+    /* drain the accept queue in the same round */
+    for (n = 1; n < count; n++) {
+        if (!cat_socket_internal_try_accept(server_i, connections[n]->internal)) {
+            break;
+        }
+        cat_socket_internal_on_accept_stats(server_i, cat_false);
     }
 
-    return cache;
+    return n;
 }
 
-CAT_API const cat_sockaddr_info_t *cat_socket_getsockname_fast(cat_socket_t *socket)
+CAT_API ssize_t cat_socket_accept_multiple(cat_socket_t *server, cat_socket_t **connections, size_t count)
 {
-    return cat_socket_getname_fast(socket, cat_false);
+    return cat_socket_accept_multiple_ex(server, connections, count, cat_socket_get_accept_timeout_fast(server));
 }
 
-CAT_API const cat_sockaddr_info_t *cat_socket_getpeername_fast(cat_socket_t *socket)
+CAT_API ssize_t cat_socket_accept_multiple_ex(cat_socket_t *server, cat_socket_t **connections, size_t count, cat_timeout_t timeout)
 {
-    return cat_socket_getname_fast(socket, cat_true);
-}
+    CAT_LOG_DEBUG(SOCKET, "accept_multiple(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+        server->id, count, timeout);
 
-typedef struct cat_socket_read_context_s {
-    cat_bool_t once;
-    char *buffer;
-    size_t size;
-    size_t nread;
-    cat_sockaddr_t *address;
-    cat_socklen_t *address_length;
-    ssize_t error;
-} cat_socket_read_context_t;
+    ssize_t n = cat_socket_accept_multiple_impl(server, connections, count, timeout);
 
-static void cat_socket_read_alloc_callback(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
-{
-    (void) suggested_size;
-    cat_socket_internal_t *socket_i = cat_container_of(handle, cat_socket_internal_t, u.handle);
-    cat_socket_read_context_t *context = (cat_socket_read_context_t *) socket_i->context.io.read.data.ptr;
+    CAT_LOG_DEBUG(SOCKET, "accept_multiple(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+        server->id, count, timeout, CAT_LOG_SSIZE_RET_C(n));
 
-    buf->base = context->buffer + context->nread;
-    buf->len =  (cat_socket_vector_length_t) (context->size - context->nread);
+    return n;
 }
 
-static void cat_socket_read_callback(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
+static cat_always_inline void cat_socket_internal_on_connect_done(cat_socket_internal_t *socket_i, cat_sa_family_t af)
 {
-    (void) buf;
-    cat_socket_internal_t *socket_i = cat_container_of(stream, cat_socket_internal_t, u.stream);
-    cat_socket_read_context_t *context = (cat_socket_read_context_t *) socket_i->context.io.read.data.ptr;
-
-    CAT_ASSERT(context != NULL);
-
-    /* 0 == EAGAIN */
-    if (nread == 0) {
-        return;
+    /* connect done successfully, we can do something here before transfer data */
+    socket_i->flags |= (CAT_SOCKET_INTERNAL_FLAG_ESTABLISHED | CAT_SOCKET_INTERNAL_FLAG_CLIENT);
+    cat_socket_internal_on_open(socket_i, af);
+    /* clear previous cache (maybe impossible here) */
+    if (unlikely(socket_i->cache.peername)) {
+        cat_free(socket_i->cache.peername);
+        socket_i->cache.peername = NULL;
     }
+}
 
-    if (nread > 0) {
-        context->nread += nread;
-    }
-    if (unlikely(nread == CAT_EOF)) {
-        if (!context->once && context->nread != context->size) {
-            context->error = CAT_ECONNRESET;
-        } else {
-            /* connection closed normally */
-            context->error = 0;
-        }
-    } else if (unlikely(nread < 0 && nread != CAT_ENOBUFS)) {
-        /* io error */
-        context->error = nread;
-    } else {
-        /* success (may buffer full) or eof */
-        context->error = 0;
-    }
-    /* read once or buffer full (got all data) or error occurred */
-    if (context->once || context->nread == context->size || context->error != 0) {
-        cat_coroutine_t *coroutine = socket_i->context.io.read.coroutine;
+static void cat_socket_internal_connect_callback(uv_connect_t* request, int status)
+{
+    cat_socket_internal_t *socket_i = cat_container_of(request->handle, cat_socket_internal_t, u.stream);
+
+    /* if status == ECANCELED means that socket is closed (now in uv__stream_destroy())
+     * and handle->close_cb() always after the uv__stream_destroy() */
+    if (socket_i->io_flags == CAT_SOCKET_IO_FLAG_CONNECT) {
+        cat_coroutine_t *coroutine = socket_i->context.connect.coroutine;
         CAT_ASSERT(coroutine != NULL);
-        cat_coroutine_schedule(coroutine, SOCKET, "Stream read");
+        socket_i->context.connect.data.status = status;
+        cat_coroutine_schedule_deferrable(coroutine, SOCKET, "Connect");
     }
+
+    cat_free(request);
 }
 
-static void cat_socket_udp_recv_callback(uv_udp_t *udp, ssize_t nread, const uv_buf_t *buf, const struct sockaddr *address, unsigned flags)
+static void cat_socket_internal_try_connect_callback(uv_connect_t* request, int status)
 {
-    (void) buf;
-    (void) flags;
-    cat_socket_internal_t *socket_i = cat_container_of(udp, cat_socket_internal_t, u.udp);
-    cat_socket_read_context_t *context = (cat_socket_read_context_t *) socket_i->context.io.read.data.ptr;
+#ifndef CAT_OS_DARWIN
+    cat_socket_internal_t *socket_i = cat_container_of(request->handle, cat_socket_internal_t, u.stream);
 
-    CAT_ASSERT(context != NULL);
+    if (status == 0) {
+        cat_socket_internal_on_connect_done(socket_i, (cat_sa_family_t) (intptr_t) request->data);
+    }
+#endif
 
-    /* FIXME: flags & UV_UDP_PARTIAL */
+    cat_free(request);
+}
+
+static cat_bool_t cat_socket_internal_connect(
+    cat_socket_internal_t *socket_i,
+    const cat_sockaddr_t *address, cat_socklen_t address_length,
+    cat_timeout_t timeout, cat_bool_t is_try
+)
+{
+    CAT_SOCKET_CHECK_INPUT_ADDRESS_REQUIRED(address, address_length, return cat_false);
+    cat_socket_type_t type = socket_i->type;
+    uv_connect_t *request;
+    int error = 0;
+
+    /* only TCP and PIPE need request */
+    if (((type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP) || (type & CAT_SOCKET_TYPE_FLAG_LOCAL)) {
+        /* malloc for request (we must free it in the callback if it has been started) */
+        request = (uv_connect_t *) cat_malloc(sizeof(*request));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(request == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for Socket connect request failed");
+            return cat_false;
+        }
+#endif
+    } else {
+        request = NULL;
+    }
+    if ((type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP) {
+        error = uv_tcp_connect(
+            request, &socket_i->u.tcp, address,
+            !is_try ? cat_socket_internal_connect_callback : cat_socket_internal_try_connect_callback
+        );
+        if (unlikely(error != 0)) {
+            cat_update_last_error_with_reason(error, "Tcp connect init failed");
+            cat_free(request);
+            return cat_false;
+        }
+    } else if ((type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP) {
+        error = uv_udp_connect(&socket_i->u.udp, address);
+    } else if (type & CAT_SOCKET_TYPE_FLAG_LOCAL) {
+        const char *name = address->sa_data;
+        size_t name_length = address_length - CAT_SOCKADDR_HEADER_LENGTH;
+        if (!cat_sockaddr_is_linux_abstract_name(name, name_length)) {
+            name_length = cat_strnlen(name, name_length);
+        }
+        (void) uv_pipe_connect_ex(
+            request, &socket_i->u.pipe, name, name_length,
+            !is_try ? cat_socket_internal_connect_callback : cat_socket_internal_try_connect_callback
+        );
+    } else {
+        error = CAT_EAFNOSUPPORT;
+    }
+    if (request != NULL) {
+        if (!is_try) {
+            cat_bool_t ret;
+            socket_i->context.connect.data.status = CAT_ECANCELED;
+            socket_i->context.connect.coroutine = CAT_COROUTINE_G(current);
+            socket_i->io_flags = CAT_SOCKET_IO_FLAG_CONNECT;
+            ret = cat_time_wait(timeout);
+            socket_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
+            socket_i->context.connect.coroutine = NULL;
+            if (unlikely(!ret)) {
+                cat_update_last_error_with_previous("Socket connect wait failed");
+                /* interrupt can not recover */
+                cat_socket_internal_unrecoverable_io_error(socket_i);
+                return cat_false;
+            }
+            error = socket_i->context.connect.data.status;
+            if (error == CAT_ECANCELED) {
+                cat_update_last_error(CAT_ECANCELED, "Socket connect has been canceled");
+                /* interrupt can not recover */
+                cat_socket_internal_unrecoverable_io_error(socket_i);
+                return cat_false;
+            }
+        }
+#ifndef CAT_OS_DARWIN
+        else {
+            request->data = (void *) (intptr_t) address->sa_family;
+        }
+#endif
+    }
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "Socket connect failed");
+        return cat_false;
+    }
+#ifndef CAT_OS_DARWIN /* connect done is later than POLLOUT event on macOS */
+    if (!is_try)
+#endif
+    {
+        cat_socket_internal_on_connect_done(socket_i, address->sa_family);
+    }
+
+    return cat_true;
+}
+
+static cat_bool_t cat_socket_connect_impl(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout, cat_bool_t is_try)
+{
+    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(socket, socket_i, CAT_SOCKET_IO_FLAG_CONNECT, return cat_false);
+    CAT_SOCKET_INTERNAL_ESTABLISHED_ONCE(socket_i, return cat_false);
+
+    return cat_socket_internal_connect(socket_i, address, address_length, timeout, is_try);
+}
+
+static cat_bool_t cat_socket_connect_to_impl(cat_socket_t *socket, const char *name, size_t name_length, int port, cat_timeout_t timeout, cat_bool_t is_try)
+{
+    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(socket, socket_i, CAT_SOCKET_IO_FLAG_CONNECT, return cat_false);
+    CAT_SOCKET_INTERNAL_ESTABLISHED_ONCE(socket_i, return cat_false);
+
+    /* address can be NULL if it's UDP */
+    if (name_length == 0 && ((socket_i->type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP)) {
+        return cat_socket_internal_connect(socket_i, NULL, 0, timeout, is_try);
+    }
+
+    /* otherwise we resolve address */
+    cat_sa_family_t af = cat_socket_internal_get_af(socket_i);
+    cat_sockaddr_info_t address_info;
+    cat_bool_t ret = cat_false;
+    int error;
+    address_info.length = sizeof(address_info.address);
+    address_info.address.common.sa_family = af;
+    error = cat_sockaddr__getbyname(&address_info.address.common, &address_info.length, name, name_length, port);
+    if (error == 0) {
+        return cat_socket_internal_connect(socket_i, &address_info.address.common, address_info.length, timeout, is_try);
+    }
+    if (unlikely(error != CAT_EINVAL)) {
+        cat_update_last_error_with_reason(error, "Socket connect failed, reason: Socket get address by name failed");
+        return cat_false;
+    }
+
+    /* the input addr name is a domain name, do a ns look-up */
+    struct addrinfo *responses, *response;
+    struct addrinfo hints = {0};
+    if (af != AF_UNSPEC) {
+        // the socket is already specified or bound
+        hints.ai_family = af;
+    }
+    if (socket_i->type & CAT_SOCKET_TYPE_FLAG_STREAM) {
+        hints.ai_socktype = SOCK_STREAM;
+    } else if (socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM) {
+        hints.ai_socktype = SOCK_DGRAM;
+    } else {
+        hints.ai_socktype = 0;
+    }
+    socket_i->context.connect.coroutine = CAT_COROUTINE_G(current);
+    socket_i->io_flags = CAT_SOCKET_IO_FLAG_CONNECT;
+    responses = cat_dns_getaddrinfo_ex(name, NULL, &hints, cat_socket_get_dns_timeout_fast(socket));
+    socket_i->io_flags = CAT_SOCKET_IO_FLAG_NONE;
+    socket_i->context.connect.coroutine = NULL;
+    if (unlikely(responses == NULL)) {
+        cat_update_last_error_with_previous("Socket connect failed");
+        return cat_false;
+    }
+    /* Try to connect to all address results until successful */
+    cat_sa_family_t last_af = responses->ai_addr->sa_family;
+    cat_bool_t is_initialized = cat_socket_internal_get_fd_fast(socket_i) != CAT_SOCKET_INVALID_FD;
+    response = responses;
+    do {
+        CAT_ASSERT(((response->ai_addr->sa_family == AF_INET && response->ai_addrlen == sizeof(struct sockaddr_in)) ||
+                   (response->ai_addr->sa_family == AF_INET6 && response->ai_addrlen == sizeof(struct sockaddr_in6))) &&
+                   "GAI should only return inet and inet6 addresses");
+        memcpy(&address_info.address.common, response->ai_addr, response->ai_addrlen);
+        if (response->ai_addr->sa_family == AF_INET) {
+            address_info.address.in.sin_port = htons((uint16_t) port);
+        } else if (response->ai_addr->sa_family == AF_INET6) {
+            address_info.address.in6.sin6_port = htons((uint16_t) port);
+        } else {
+            continue; // should never here
+        }
+        if (response->ai_family != last_af) {
+            CAT_ASSERT(af == AF_UNSPEC);
+            // af changed and socket has not been initialized yet, recreate socket_i
+            cat_socket_type_t type = socket_i->type; // TODO: Implement socket_dup()
+            // FIXME: multi bound sockets, make them all available
+            cat_socket_internal_close(socket_i, NULL, cat_true);
+            ret = cat_socket_create(socket, type) != NULL;
+            if (!ret) {
+                cat_update_last_error_with_previous("Socket connect recreate failed");
+                break;
+            }
+            socket_i = socket->internal;
+        }
+        ret = cat_socket_internal_connect(
+            socket_i,
+            &address_info.address.common,
+            (cat_socklen_t) response->ai_addrlen,
+            timeout,
+            is_try
+        );
+        if (ret || is_initialized || !cat_socket_is_available(socket)) {
+            break;
+        }
+    } while ((response = response->ai_next));
+    cat_dns_freeaddrinfo(responses);
+
+#ifdef CAT_SSL
+    if (ret) {
+        socket_i->ssl_peer_name = cat_strndup(name, name_length);
+    }
+#endif
+
+    return ret;
+}
+
+CAT_API cat_bool_t cat_socket_connect(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length)
+{
+    return cat_socket_connect_ex(socket, address, address_length, cat_socket_get_connect_timeout_fast(socket));
+}
+
+CAT_API cat_bool_t cat_socket_connect_ex(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout)
+{
+#ifdef CAT_ENABLE_DEBUG_LOG
+    char name[CAT_SOCKADDR_MAX_PATH];
+    size_t name_length = sizeof(name);
+    int port = 0;
+#endif
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
+            break;
+        }
+        CAT_LOG_DEBUG_D(SOCKET, "connect(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, (int) name_length, name, port, timeout);
+    });
+
+    cat_bool_t ret = cat_socket_connect_impl(socket, address, address_length, timeout, cat_false);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        CAT_LOG_DEBUG_D(SOCKET, "connect(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
+            socket->id, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
+    });
+    CAT_LOG_DEBUG_SOCKET_ESTABLISHED(socket, connected, ret);
+
+    return ret;
+}
+
+CAT_API cat_bool_t cat_socket_connect_to(cat_socket_t *socket, const char *name, size_t name_length, int port)
+{
+    return cat_socket_connect_to_ex(socket, name, name_length, port, cat_socket_get_connect_timeout_fast(socket));
+}
+
+CAT_API cat_bool_t cat_socket_connect_to_ex(cat_socket_t *socket, const char *name, size_t name_length, int port, cat_timeout_t timeout)
+{
+    CAT_LOG_DEBUG(SOCKET, "connect_to(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+        socket->id, (int) name_length, name, port, timeout);
+
+    cat_bool_t ret = cat_socket_connect_to_impl(socket, name, name_length, port, timeout, cat_false);
+
+    CAT_LOG_DEBUG(SOCKET, "connect_to(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
+        socket->id, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
+    CAT_LOG_DEBUG_SOCKET_ESTABLISHED(socket, connected, ret);
+
+    return ret;
+}
+
+CAT_API cat_bool_t cat_socket_try_connect(cat_socket_t *socket, const cat_sockaddr_t *address, cat_socklen_t address_length)
+{
+#ifdef CAT_ENABLE_DEBUG_LOG
+    char name[CAT_SOCKADDR_MAX_PATH];
+    size_t name_length = sizeof(name);
+    int port = 0;
+#endif
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
+            break;
+        }
+        CAT_LOG_DEBUG_D(SOCKET, "try_connect_to(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d) = " CAT_LOG_UNFINISHED_STR,
+            socket->id, (int) name_length, name, port);
+    });
+
+    cat_bool_t ret = cat_socket_connect_impl(socket, address, address_length, CAT_TIMEOUT_INVALID, cat_true);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        CAT_LOG_DEBUG_D(SOCKET, "try_connect_to(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d) = " CAT_LOG_BOOL_RET_FMT,
+            socket->id, (int) name_length, name, port, CAT_LOG_BOOL_RET_C(ret));
+    });
+
+    return ret;
+}
+
+CAT_API cat_bool_t cat_socket_try_connect_to(cat_socket_t *socket, const char *name, size_t name_length, int port)
+{
+    CAT_LOG_DEBUG(SOCKET, "try_connect(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d) = " CAT_LOG_UNFINISHED_STR,
+        socket->id, (int) name_length, name, port);
+
+    cat_bool_t ret = cat_socket_connect_to_impl(socket, name, name_length, port, CAT_TIMEOUT_INVALID, cat_true);
+
+    CAT_LOG_DEBUG(SOCKET, "try_connect(" CAT_SOCKET_ID_FMT ", \"%.*s\", %d) = " CAT_LOG_BOOL_RET_FMT,
+        socket->id, (int) name_length, name, port, CAT_LOG_BOOL_RET_C(ret));
+
+    return ret;
+}
+
+#ifdef CAT_SSL
+CAT_API void cat_socket_crypto_options_init(cat_socket_crypto_options_t *options, cat_bool_t is_client)
+{
+    options->is_client = is_client;
+    options->peer_name = NULL;
+    options->ca_file = NULL;
+    options->ca_path = NULL;
+    options->certificate = NULL;
+    options->certificate_key = NULL;
+    options->passphrase = NULL;
+#ifdef CAT_SSL_HAVE_SECURITY_LEVEL
+    options->security_level = CAT_SSL_DEFAULT_SECURITY_LEVEL;
+#endif
+#ifdef CAT_SSL_HAVE_TLS_ALPN
+    options->alpn_protocols = NULL;
+#endif
+    options->protocols = CAT_SSL_PROTOCOLS_DEFAULT;
+    options->verify_depth = CAT_SSL_DEFAULT_STREAM_VERIFY_DEPTH;
+    options->verify_peer = is_client;
+    options->verify_peer_name = is_client;
+    options->allow_self_signed = cat_false;
+    options->no_ticket = cat_false;
+    options->no_compression = cat_false;
+    options->no_client_ca_list = cat_false;
+    options->ktls = cat_false;
+    options->session_cache = cat_false;
+    options->session_cache_size = 0;
+    options->session_timeout = CAT_SSL_SESSION_DEFAULT_TIMEOUT;
+    options->session_ticket_key_file = NULL;
+    options->session_ticket_key_rotation = 0;
+}
+
+static cat_bool_t cat_socket_crypto_enable_session_resumption(cat_ssl_context_t *context, const cat_socket_crypto_options_t *options)
+{
+    cat_ssl_session_store_t *store;
+    char *id;
+    size_t id_length;
+    cat_bool_t ret;
+
+    /* sessions can only be resumed by the servers with the same configuration */
+    id = cat_slprintf("%s\n%s\n%s\n%s\n%u\n%d", &id_length,
+        options->certificate != NULL ? options->certificate : "",
+        options->certificate_key != NULL ? options->certificate_key : "",
+        options->ca_file != NULL ? options->ca_file : "",
+        options->ca_path != NULL ? options->ca_path : "",
+        options->protocols, options->verify_peer);
+    if (unlikely(id == NULL)) {
+        cat_update_last_error_with_previous("Socket build SSL session id context failed");
+        return cat_false;
+    }
+    ret = cat_ssl_context_set_session_id_context(context, id, id_length);
+    cat_free(id);
+    if (unlikely(!ret)) {
+        return cat_false;
+    }
+    cat_ssl_context_set_session_timeout(context, options->session_timeout);
+
+    /* servers with different resumption options do not share the store, so they never change the settings of each other */
+    id = cat_slprintf("%s\n%s\n%s\n%s\n%u\n%d\n%d\n%zu\n%d\n%s\n%ld", &id_length,
+        options->certificate != NULL ? options->certificate : "",
+        options->certificate_key != NULL ? options->certificate_key : "",
+        options->ca_file != NULL ? options->ca_file : "",
+        options->ca_path != NULL ? options->ca_path : "",
+        options->protocols, options->verify_peer,
+        options->session_cache, options->session_cache_size,
+        options->no_ticket,
+        options->session_ticket_key_file != NULL ? options->session_ticket_key_file : "",
+        options->session_ticket_key_rotation);
+    if (unlikely(id == NULL)) {
+        cat_update_last_error_with_previous("Socket build SSL session store id failed");
+        return cat_false;
+    }
+    store = cat_ssl_session_store_get(id, id_length);
+    cat_free(id);
+    if (unlikely(store == NULL)) {
+        return cat_false;
+    }
+    if (options->session_cache) {
+        if (options->session_cache_size != 0) {
+            (void) cat_ssl_session_cache_set_size(store, options->session_cache_size);
+        }
+        if (unlikely(!cat_ssl_context_enable_session_cache(context, store))) {
+            return cat_false;
+        }
+    }
+    if (!options->no_ticket) {
+        if (options->session_ticket_key_file != NULL) {
+            if (unlikely(!cat_ssl_ticket_keys_set_file(store, options->session_ticket_key_file))) {
+                return cat_false;
+            }
+        } else if (options->session_ticket_key_rotation > 0) {
+            (void) cat_ssl_ticket_keys_set_rotation(store, (cat_msec_t) options->session_ticket_key_rotation * 1000);
+        }
+        if (unlikely(!cat_ssl_context_enable_session_tickets(context, store))) {
+            return cat_false;
+        }
+    }
+
+    return cat_true;
+}
+
+/* TODO: Support non-blocking SSL handshake? (just for PHP, stupid design) */
+
+static cat_bool_t cat_socket_enable_crypto_impl(cat_socket_t *socket, const cat_socket_crypto_options_t *options, cat_timeout_t timeout)
+{
+    /* TODO: DTLS support */
+    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(socket, socket_i, CAT_SOCKET_IO_FLAG_RDWR, return cat_false);
+    CAT_SOCKET_INTERNAL_INET_STREAM_ONLY(socket_i, return cat_false);
+    if (unlikely(socket_i->ssl != NULL && cat_ssl_is_established(socket_i->ssl))) {
+        CAT_SOCKET_INTERNAL_ESTABLISHED_ONCE(socket_i, return cat_false);
+    } else {
+        CAT_SOCKET_INTERNAL_ESTABLISHED_ONLY(socket_i, return cat_false);
+    }
+    cat_ssl_t *ssl;
+    cat_ssl_context_t *context = NULL;
+    cat_buffer_t *buffer;
+    cat_socket_crypto_options_t ioptions;
+    cat_bool_t use_tmp_context;
+    cat_bool_t ret = cat_false;
+
+    /* check options */
+    if (options == NULL) {
+        cat_bool_t is_client = !cat_socket_is_server_connection(socket);
+        cat_socket_crypto_options_init(&ioptions, is_client);
+    } else {
+        ioptions = *options;
+    }
+    if (ioptions.peer_name == NULL) {
+        ioptions.peer_name = socket_i->ssl_peer_name;
+    }
+    if (ioptions.verify_peer_name && ioptions.peer_name == NULL) {
+        cat_update_last_error(CAT_EINVAL, "SSL verify peer name is enabled but peer name is empty");
+        goto _prepare_error;
+    }
+
+    /* check context (TODO: support context from arg?) */
+    use_tmp_context = context == NULL;
+    if (use_tmp_context) {
+        cat_ssl_method_t method;
+        if (socket_i->type & CAT_SOCKET_TYPE_FLAG_STREAM) {
+            method = CAT_SSL_METHOD_TLS;
+        } else /* if (socket->type & CAT_SOCKET_TYPE_FLAG_DGRAM) */ {
+            method = CAT_SSL_METHOD_DTLS;
+        }
+        context = cat_ssl_context_create(method, ioptions.protocols);
+        if (unlikely(context == NULL)) {
+            goto _prepare_error;
+        }
+    }
+
+    if (ioptions.verify_peer) {
+        if (!ioptions.is_client && !ioptions.no_client_ca_list && ioptions.ca_file != NULL) {
+            if (!cat_ssl_context_set_client_ca_list(context, ioptions.ca_file)) {
+                goto _setup_error;
+            }
+        }
+        if (ioptions.ca_file  != NULL || ioptions.ca_path != NULL) {
+            if (!cat_ssl_context_load_verify_locations(context, ioptions.ca_file, ioptions.ca_path)) {
+                goto _setup_error;
+            }
+        } else {
+#ifndef CAT_OS_WIN
+            /* check context related options */
+            if (ioptions.is_client && !cat_ssl_context_set_default_verify_paths(context)) {
+                goto _setup_error;
+            }
+#else
+            cat_ssl_context_configure_cert_verify_callback(context);
+#endif
+        }
+        cat_ssl_context_set_verify_depth(context, ioptions.verify_depth);
+        cat_ssl_context_enable_verify_peer(context);
+    } else {
+        cat_ssl_context_disable_verify_peer(context);
+    }
+    if (ioptions.passphrase != NULL) {
+        if (!cat_ssl_context_set_passphrase(context, ioptions.passphrase, strlen(ioptions.passphrase))) {
+            goto _setup_error;
+        }
+    }
+    if (ioptions.certificate != NULL) {
+        if (!cat_ssl_context_set_certificate(context, ioptions.certificate, ioptions.certificate_key)) {
+            goto _setup_error;
+        }
+    }
+    if (ioptions.no_ticket) {
+        cat_ssl_context_set_no_ticket(context);
+    }
+    if (ioptions.no_compression) {
+        cat_ssl_context_set_no_compression(context);
+    }
+#ifdef CAT_SSL_HAVE_SECURITY_LEVEL
+    cat_ssl_context_set_security_level(context, ioptions.security_level);
+#endif
+#ifdef CAT_SSL_HAVE_TLS_ALPN
+    if (ioptions.alpn_protocols != NULL) {
+        if (!cas_ssl_context_set_alpn_protocols(context, ioptions.is_client, ioptions.alpn_protocols)) {
+            goto _setup_error;
+        }
+    }
+#endif
+    if (!ioptions.is_client && (ioptions.session_cache || ioptions.session_ticket_key_file != NULL)) {
+        if (!cat_socket_crypto_enable_session_resumption(context, &ioptions)) {
+            goto _setup_error;
+        }
+    }
+    /* create ssl connection */
+    ssl = cat_ssl_create(NULL, context);
+    if (use_tmp_context) {
+        /* deref/free context */
+        cat_ssl_context_close(context);
+    }
+    if (unlikely(ssl == NULL)) {
+        goto _prepare_error;
+    }
+
+    /* set state */
+    if (!ioptions.is_client) {
+        cat_ssl_set_accept_state(ssl);
+    } else {
+        cat_ssl_set_connect_state(ssl);
+    }
+
+    /* connection related options */
+    if (ioptions.is_client && ioptions.peer_name != NULL) {
+        cat_ssl_set_sni_server_name(ssl, ioptions.peer_name);
+    }
+    ssl->allow_self_signed = ioptions.allow_self_signed;
+#ifdef CAT_SSL_HAVE_KTLS
+    if (ioptions.ktls && !(socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM)) {
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+        /* records are written to fd directly by SSL from now, they must not race with io_uring,
+         * data which has been read ahead (e.g. after STARTTLS) is still fed to SSL by the handshake */
+        if (unlikely(!cat_socket_internal_io_uring_detach(socket_i, timeout))) {
+            goto _unrecoverable_error;
+        }
+#endif
+        /* whether kernel takes over the encryption is known after handshake, it falls back to BIO pair if not */
+        if (unlikely(!cat_ssl_enable_ktls(ssl, cat_socket_internal_get_fd_fast(socket_i)))) {
+            goto _unrecoverable_error;
+        }
+    }
+#endif
+
+    buffer = &ssl->read_buffer;
+
+    while (1) {
+        ssize_t n;
+        cat_ssl_ret_t ssl_ret;
+
+        ssl_ret = cat_ssl_handshake(ssl);
+        if (unlikely(ssl_ret == CAT_SSL_RET_ERROR)) {
+            break;
+        }
+#ifdef CAT_SSL_HAVE_KTLS
+        if (ssl_ret == CAT_SSL_RET_WANT_WRITE) {
+            /* handshake records are written to the socket directly in kTLS mode */
+            cat_ret_t poll_ret;
+            CAT_TIME_WAIT_START() {
+                poll_ret = cat_poll_one(cat_socket_internal_get_fd_fast(socket_i), POLLOUT, NULL, timeout);
+            } CAT_TIME_WAIT_END(timeout);
+            if (unlikely(poll_ret != CAT_RET_OK)) {
+                if (poll_ret == CAT_RET_ERROR) {
+                    cat_update_last_error_with_previous("Socket SSL handshake failed when poll writable");
+                } else {
+                    cat_update_last_error(CAT_ETIMEDOUT, "Socket SSL handshake timedout when poll writable");
+                }
+                break;
+            }
+            continue;
+        }
+#endif
+        /* ssl_read_encrypted_bytes() may return n > 0
+         * after ssl_handshake() return OK */
+        n = cat_ssl_read_encrypted_bytes(ssl, buffer->value, buffer->size);
+        if (unlikely(n == CAT_RET_ERROR)) {
+            break;
+        }
+        if (n > 0) {
+            cat_bool_t ret;
+            CAT_TIME_WAIT_START() {
+                ret = cat_socket_send_ex(socket, buffer->value, n, timeout);
+            } CAT_TIME_WAIT_END(timeout);
+            if (unlikely(!ret)) {
+                break;
+            }
+        }
+#if 0   /* FIXME: Disable it for now because we do not sure that whether it still works now,
+         * and it make SSL handshake hang on recv() forever on Linux. */
+        /* Notice: if it's client and it write something to the server,
+         * it means server will response something later, so, we need to recv it then returns,
+         * otherwise it will lead errors on Windows */
+#define CAT_SOCKET_SSL_HANDSHAKE_WORKAROUND_FOR_WINDOWS() !(n > 0 && ioptions.is_client)
+#else
+#define CAT_SOCKET_SSL_HANDSHAKE_WORKAROUND_FOR_WINDOWS() 1
+#endif
+        if (ssl_ret == CAT_SSL_RET_OK && CAT_SOCKET_SSL_HANDSHAKE_WORKAROUND_FOR_WINDOWS()) {
+            CAT_LOG_DEBUG(SOCKET, "Socket SSL handshake completed");
+            ret = cat_true;
+            break;
+        }
+        {
+            ssize_t nread, nwrite;
+            CAT_TIME_WAIT_START() {
+                nread = cat_socket_recv_ex(socket, buffer->value, buffer->size, timeout);
+            } CAT_TIME_WAIT_END(timeout);
+            if (unlikely(nread <= 0)) {
+                if (nread == 0) {
+                    cat_update_last_error_by_code(CAT_ECONNRESET);
+                }
+                break;
+            }
+            nwrite = cat_ssl_write_encrypted_bytes(ssl, buffer->value, nread);
+            if (unlikely(nwrite != nread)) {
+                break;
+            }
+            continue;
+        }
+    }
+
+    if (unlikely(!ret)) {
+        /* Notice: io error can not recover */
+        goto _unrecoverable_error;
+    }
+
+    if (ioptions.verify_peer) {
+        if (!cat_ssl_verify_peer(ssl, ioptions.allow_self_signed)) {
+            goto _unrecoverable_error;
+        }
+    }
+    if (ioptions.verify_peer_name) {
+        if (!cat_ssl_check_host(ssl, ioptions.peer_name, strlen(ioptions.peer_name))) {
+            goto _unrecoverable_error;
+        }
+    }
+
+    socket_i->ssl = ssl;
+
+    return cat_true;
+
+    _unrecoverable_error:
+    cat_socket_internal_unrecoverable_io_error(socket_i);
+    cat_ssl_close(ssl);
+    if (0) {
+        _setup_error:
+        cat_ssl_context_close(context);
+    }
+    _prepare_error:
+    cat_update_last_error_with_previous("Socket enable crypto failed");
+
+    return cat_false;
+}
+
+#define CAT_SOCKET_CRYPTO_OPTIONS_FMT \
+    "{ " \
+    "peer_name: \"%s\", " \
+    "ca_file: \"%s\", " \
+    "ca_path: \"%s\", " \
+    "certificate: \"%s\", " \
+    "certificate_key: \"%s\", " \
+    "passphrase: \"%s\", " \
+    "protocols: %s, " \
+    "verify_depth: %d, " \
+    "is_client: %s, " \
+    "verify_peer: %s, " \
+    "verify_peer_name: %s, " \
+    "allow_self_signed: %s, " \
+    "no_ticket: %s, " \
+    "no_compression: %s, " \
+    "no_client_ca_list: %s, " \
+    "ktls: %s, " \
+    "session_cache: %s, " \
+    "session_cache_size: %zu, " \
+    "session_timeout: %ld, " \
+    "session_ticket_key_file: \"%s\", " \
+    "session_ticket_key_rotation: %ld" \
+    " }"
+
+#define CAT_SOCKET_CRYPTO_OPTIONS_C(options, protocols_str) \
+    CAT_NULLABLE_STR_C(options.peer_name), \
+    CAT_NULLABLE_STR_C(options.ca_file), \
+    CAT_NULLABLE_STR_C(options.ca_path), \
+    CAT_NULLABLE_STR_C(options.certificate), \
+    CAT_NULLABLE_STR_C(options.certificate_key), \
+    CAT_NULLABLE_STR_C(options.passphrase), \
+    protocols_str, \
+    options.verify_depth, \
+    cat_bool_str(options.is_client), \
+    cat_bool_str(options.verify_peer), \
+    cat_bool_str(options.verify_peer_name), \
+    cat_bool_str(options.allow_self_signed), \
+    cat_bool_str(options.no_ticket), \
+    cat_bool_str(options.no_compression), \
+    cat_bool_str(options.no_client_ca_list), \
+    cat_bool_str(options.ktls), \
+    cat_bool_str(options.session_cache), \
+    options.session_cache_size, \
+    options.session_timeout, \
+    CAT_NULLABLE_STR_C(options.session_ticket_key_file), \
+    options.session_ticket_key_rotation
+
+CAT_API cat_bool_t cat_socket_enable_crypto(cat_socket_t *socket, const cat_socket_crypto_options_t *options)
+{
+    return cat_socket_enable_crypto_ex(socket, options, cat_socket_get_handshake_timeout_fast(socket));
+}
+
+CAT_API cat_bool_t cat_socket_enable_crypto_ex(cat_socket_t *socket, const cat_socket_crypto_options_t *options, cat_timeout_t timeout)
+{
+#ifdef CAT_ENABLE_DEBUG_LOG
+    cat_socket_crypto_options_t log_options = { 0 };
+    char *protocols_str = NULL;
+#endif
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        if (options == NULL) {
+            cat_socket_crypto_options_init(&log_options, !cat_socket_is_server_connection(socket));
+        } else {
+            log_options = *options;
+        }
+        protocols_str = cat_ssl_protocols_str(log_options.protocols);
+        CAT_LOG_DEBUG_D(SOCKET, "enable_crypto(" CAT_SOCKET_ID_FMT ", " \
+            "options: " CAT_SOCKET_CRYPTO_OPTIONS_FMT ", " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, CAT_SOCKET_CRYPTO_OPTIONS_C(log_options, protocols_str), timeout);
+    });
+
+    cat_bool_t ret = cat_socket_enable_crypto_impl(socket, options, timeout);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        CAT_LOG_DEBUG_D(SOCKET, "enable_crypto(" CAT_SOCKET_ID_FMT ", " \
+            "options: " CAT_SOCKET_CRYPTO_OPTIONS_FMT ", " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
+            socket->id, CAT_SOCKET_CRYPTO_OPTIONS_C(log_options, protocols_str), timeout, CAT_LOG_BOOL_RET_C(ret));
+        cat_buffer_str_free(protocols_str);
+    });
+
+    return ret;
+}
+
+#if 0
+/* TODO: BIO SSL shutdown
+ * we must cancel all IO operations and mark this socket unavailable temporarily,
+ * then read or write on it to shutdown SSL connection */
+CAT_API cat_bool_t cat_socket_disable_crypto(cat_socket_t *socket)
+{
+    if (!cat_socket_is_encrypted(socket)) {
+        return cat_true;
+    }
+    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(socket, socket_i, CAT_SOCKET_IO_FLAG_RDWR, return cat_false);
+    cat_ssl_t *ssl = socket_i->ssl;
+
+    while (1) {
+        cat_ssl_ret_t ret = cat_ssl_shutdown(ssl);
+        if (ret == 1) {
+            cat_ssl_close(ssl);
+            return cat_true;
+        }
+        // read or write...
+    }
+}
+#endif
+#endif
+
+static int cat_socket_internal_getname(const cat_socket_internal_t *socket_i, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_bool_t is_peer)
+{
+    cat_socket_type_t type = socket_i->type;
+    cat_sockaddr_info_t *cache = !is_peer ? socket_i->cache.sockname : socket_i->cache.peername;
+    int error;
+
+    if (address_length != NULL && ((int) *address_length) < 0) {
+        error = CAT_EINVAL;
+    } else if (cache != NULL) {
+        /* use cache */
+        error = cat_sockaddr_copy(address, address_length, &cache->address.common, cache->length);
+    } else {
+        error = CAT_EAFNOSUPPORT;
+        if (type & CAT_SOCKET_TYPE_FLAG_INET) {
+            int length = *address_length; /* sizeof(cat_socklen_t) is not always equal to sizeof(int) */
+            if ((type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP)  {
+                if (!is_peer) {
+                    error = uv_tcp_getsockname(&socket_i->u.tcp, address, &length);
+                } else {
+                    error = uv_tcp_getpeername(&socket_i->u.tcp, address, &length);
+                }
+            } else if ((type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP) {
+                if (!is_peer) {
+                    error = uv_udp_getsockname(&socket_i->u.udp, address, &length);
+                } else {
+                    error = uv_udp_getpeername(&socket_i->u.udp, address, &length);
+                }
+            }
+            *address_length = length;
+        } else if (type & CAT_SOCKET_TYPE_FLAG_LOCAL) {
+            cat_sockaddr_local_t local;
+            size_t length = sizeof(local.sl_path);
+            if (!is_peer) {
+                error = uv_pipe_getsockname(&socket_i->u.pipe, local.sl_path, &length);
+            } else {
+                error = uv_pipe_getpeername(&socket_i->u.pipe, local.sl_path, &length);
+            }
+            if (error == 0 || error == CAT_ENOBUFS) {
+                local.sl_family = AF_LOCAL;
+                /* Notice: the returned length no longer includes the terminating null byte,
+                * and the buffer is not null terminated only if it's linux abstract name. */
+                length = CAT_SOCKADDR_HEADER_LENGTH + length + !cat_sockaddr_is_linux_abstract_name(local.sl_path, length);
+                memcpy(address, &local, CAT_MIN((size_t) *address_length, length));
+                *address_length = (cat_socklen_t) length;
+            }
+        }
+    }
+
+    return error;
+}
+
+static const cat_sockaddr_info_t *cat_socket_internal_getname_fast(cat_socket_internal_t *socket_i, cat_bool_t is_peer, int *error_ptr)
+{
+    cat_sockaddr_info_t *cache, **cache_ptr;
+    cat_sockaddr_info_t tmp;
+    size_t size;
+    int error = 0;
+
+    if (!is_peer) {
+        cache_ptr = &socket_i->cache.sockname;
+    } else {
+        cache_ptr = &socket_i->cache.peername;
+    }
+    cache = *cache_ptr;
+    if (cache != NULL) {
+        goto _out;
+    }
+    tmp.length = sizeof(tmp.address);
+    error = cat_socket_internal_getname(socket_i, &tmp.address.common, &tmp.length, is_peer);
+    if (unlikely(error != 0 && error != CAT_ENOSPC)) {
+        goto _out;
+    }
+    size = offsetof(cat_sockaddr_info_t, address) + tmp.length;
+    cache = (cat_sockaddr_info_t *) cat_malloc(size);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(cache == NULL)) {
+        error = cat_translate_sys_error(cat_sys_errno);
+        goto _out;
+    }
+#endif
+    if (error != 0) {
+        /* ENOSPC, retry now */
+        error = cat_socket_internal_getname(socket_i, &cache->address.common, &cache->length, is_peer);
+        if (unlikely(error != 0)) {
+            /* almost impossible */
+            cat_free(cache);
+            goto _out;
+        }
+    } else {
+        memcpy(cache, &tmp, size);
+    }
+    *cache_ptr = cache;
+
+    _out:
+    if (error_ptr != NULL) {
+        *error_ptr = error;
+    }
+    if (unlikely(error != 0)) {
+        return NULL;
+    }
+    return cache;
+}
+
+CAT_API cat_bool_t cat_socket_getname(const cat_socket_t *socket, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_bool_t is_peer)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    int error;
+
+    error = cat_socket_internal_getname(socket_i, address, address_length, is_peer);
+
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "Socket get%sname failed", !is_peer ? "sock" : "peer");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_socket_getsockname(const cat_socket_t *socket, cat_sockaddr_t *address, cat_socklen_t *length)
+{
+    return cat_socket_getname(socket, address, length, cat_false);
+}
+
+CAT_API cat_bool_t cat_socket_getpeername(const cat_socket_t *socket, cat_sockaddr_t *address, cat_socklen_t *length)
+{
+    return cat_socket_getname(socket, address, length, cat_true);
+}
+
+CAT_API const cat_sockaddr_info_t *cat_socket_getname_fast(cat_socket_t *socket, cat_bool_t is_peer)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return NULL);
+    const cat_sockaddr_info_t *cache;
+    int error;
+
+    cache = cat_socket_internal_getname_fast(socket_i, is_peer, &error);
+
+    if (cache == NULL) {
+        cat_update_last_error_with_reason(error, "Socket get%sname fast failed", !is_peer ? "sock" : "peer");
+    }
+
+    return cache;
+}
+
+CAT_API const cat_sockaddr_info_t *cat_socket_getsockname_fast(cat_socket_t *socket)
+{
+    return cat_socket_getname_fast(socket, cat_false);
+}
+
+CAT_API const cat_sockaddr_info_t *cat_socket_getpeername_fast(cat_socket_t *socket)
+{
+    return cat_socket_getname_fast(socket, cat_true);
+}
+
+typedef struct cat_socket_read_context_s {
+    cat_bool_t once;
+    char *buffer;
+    size_t size;
+    size_t nread;
+    cat_sockaddr_t *address;
+    cat_socklen_t *address_length;
+    ssize_t error;
+    cat_bool_t scheduled;
+} cat_socket_read_context_t;
+
+static void cat_socket_read_alloc_callback(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
+{
+    (void) suggested_size;
+    cat_socket_internal_t *socket_i = cat_container_of(handle, cat_socket_internal_t, u.handle);
+    cat_socket_read_context_t *context = (cat_socket_read_context_t *) socket_i->context.io.read.data.ptr;
+
+    buf->base = context->buffer + context->nread;
+    buf->len =  (cat_socket_vector_length_t) (context->size - context->nread);
+}
+
+static void cat_socket_read_callback(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
+{
+    (void) buf;
+    cat_socket_internal_t *socket_i = cat_container_of(stream, cat_socket_internal_t, u.stream);
+    cat_socket_read_context_t *context = (cat_socket_read_context_t *) socket_i->context.io.read.data.ptr;
+
+    CAT_ASSERT(context != NULL);
+
+    /* 0 == EAGAIN */
+    if (nread == 0) {
+        return;
+    }
+
+    if (nread > 0) {
+        context->nread += nread;
+    }
+    if (context->scheduled) {
+        /* data has been delivered and the reader is going to be resumed,
+         * error which arrives later must not override its result */
+        if (unlikely(nread < 0 && nread != CAT_EOF && nread != CAT_ENOBUFS)) {
+            socket_i->cache.read_error = (int) nread;
+            cat_socket_internal_tree_insert(socket_i);
+        }
+        return;
+    }
+    if (unlikely(nread == CAT_EOF)) {
+        if (!context->once && context->nread != context->size) {
+            context->error = CAT_ECONNRESET;
+        } else {
+            /* connection closed normally */
+            context->error = 0;
+        }
+    } else if (unlikely(nread < 0 && nread != CAT_ENOBUFS)) {
+        /* io error */
+        context->error = nread;
+    } else {
+        /* success (may buffer full) or eof */
+        context->error = 0;
+    }
+    /* read once or buffer full (got all data) or error occurred */
+    if (context->once || context->nread == context->size || context->error != 0) {
+        cat_coroutine_t *coroutine = socket_i->context.io.read.coroutine;
+        CAT_ASSERT(coroutine != NULL);
+        /* more data may be appended to buffer before it is resumed */
+        context->scheduled = cat_true;
+        cat_coroutine_schedule_deferrable(coroutine, SOCKET, "Stream read");
+    }
+}
+
+static void cat_socket_udp_recv_callback(uv_udp_t *udp, ssize_t nread, const uv_buf_t *buf, const struct sockaddr *address, unsigned flags)
+{
+    (void) buf;
+    (void) flags;
+    cat_socket_internal_t *socket_i = cat_container_of(udp, cat_socket_internal_t, u.udp);
+    cat_socket_read_context_t *context = (cat_socket_read_context_t *) socket_i->context.io.read.data.ptr;
+
+    CAT_ASSERT(context != NULL);
+
+    /* FIXME: flags & UV_UDP_PARTIAL */
     if (unlikely(nread == 0 && address == NULL)) {
         return; // EAGAIN (if address is non-empty, it is a empty UDP packet)
     }
-    if (address != NULL) {
-        cat_socklen_t address_length;
-        switch (address->sa_family) {
-            case AF_INET:
-                address_length = sizeof(struct sockaddr_in);
-                break;
-            case AF_INET6:
-                address_length = sizeof(struct sockaddr_in6);
-                break;
-#ifdef CAT_OS_UNIX_LIKE
-            case AF_UNIX:
-                address_length = sizeof(struct sockaddr_un);
-                break;
+    if (address != NULL) {
+        cat_socklen_t address_length;
+        switch (address->sa_family) {
+            case AF_INET:
+                address_length = sizeof(struct sockaddr_in);
+                break;
+            case AF_INET6:
+                address_length = sizeof(struct sockaddr_in6);
+                break;
+#ifdef CAT_OS_UNIX_LIKE
+            case AF_UNIX:
+                address_length = sizeof(struct sockaddr_un);
+                break;
+#endif
+            default:
+                address_length = 0;
+        }
+        /* it can handle empty context->address internally */
+        (void) cat_sockaddr_copy(context->address, context->address_length, address, address_length);
+    } else {
+        if (context->address_length != NULL) {
+            *context->address_length = 0;
+        }
+    }
+    if (nread >= 0) {
+        context->nread = nread;
+        context->error = 0;
+    } else {
+        context->error = nread;
+    }
+    do {
+        cat_coroutine_t *coroutine = socket_i->context.io.read.coroutine;
+        CAT_ASSERT(coroutine != NULL);
+        cat_coroutine_schedule(coroutine, SOCKET, "UDP recv");
+    } while (0);
+}
+
+#ifdef CAT_OS_UNIX_LIKE
+static int cat_socket_internal_udg_wait_readable(cat_socket_internal_t *socket_i, cat_socket_fd_t fd, cat_timeout_t timeout)
+{
+    cat_ret_t ret;
+    if (socket_i->u.udg.readfd == CAT_OS_INVALID_FD) {
+        socket_i->u.udg.readfd = dup(fd);
+        if (unlikely(socket_i->u.udg.readfd == CAT_OS_INVALID_FD)) {
+            return cat_translate_sys_error(cat_sys_errno);
+        }
+    }
+    socket_i->context.io.read.coroutine = CAT_COROUTINE_G(current);
+    socket_i->io_flags |= CAT_SOCKET_IO_FLAG_READ;
+    ret = cat_poll_one(socket_i->u.udg.readfd, POLLIN, NULL, timeout);
+    socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_READ;
+    socket_i->context.io.read.coroutine = NULL;
+    if (ret == CAT_RET_OK) {
+        return 0;
+    } else if (ret == CAT_RET_NONE) {
+        return CAT_ETIMEDOUT;
+    } else {
+        return CAT_EPREV;
+    }
+}
+#endif
+
+static cat_always_inline cat_bool_t cat_socket_internal_support_inline_read(const cat_socket_internal_t *socket_i)
+{
+    return socket_i->u.handle.type != UV_TTY &&
+           !(socket_i->u.handle.type == UV_NAMED_PIPE && socket_i->u.pipe.ipc);
+}
+
+static ssize_t cat_socket_internal_read_raw(
+    cat_socket_internal_t *socket_i,
+    char *buffer, size_t size,
+    cat_sockaddr_t *address, cat_socklen_t *address_length,
+    cat_timeout_t timeout,
+    cat_bool_t once
+)
+{
+    cat_bool_t is_dgram = (socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM);
+    cat_bool_t is_udp = ((socket_i->type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP);
+#ifdef CAT_OS_UNIX_LIKE
+    cat_bool_t is_udg = (socket_i->type & CAT_SOCKET_TYPE_UDG) == CAT_SOCKET_TYPE_UDG;
+#endif
+    size_t nread = 0;
+    ssize_t error;
+
+    if (unlikely(size == 0)) {
+        error = CAT_ENOBUFS;
+        goto _error;
+    }
+
+    if (!is_dgram) {
+        if (unlikely(address_length != NULL)) {
+            *address_length = 0;
+        }
+    } else {
+        once = cat_true;
+    }
+
+    if (unlikely(socket_i->cache.read_error != 0)) {
+        error = socket_i->cache.read_error;
+        socket_i->cache.read_error = 0;
+        goto _error;
+    }
+
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    if (!is_dgram) {
+        cat_socket_io_uring_t *engine = cat_socket_internal_get_io_uring(socket_i);
+        if (engine != NULL) {
+            error = cat_socket_internal_io_uring_read(socket_i, engine, buffer, size, &nread, timeout, once);
+            if (error == 0) {
+                return (ssize_t) nread;
+            }
+            if (error == CAT_EPREV) {
+                goto _wait_error;
+            }
+            if (error != CAT_EAGAIN) {
+                goto _error;
+            }
+        }
+    }
+#endif
+
+#ifdef CAT_OS_UNIX_LIKE /* Do not inline read on WIN, proactor way is faster */
+    /* Notice: when IO is low/slow, this is de-optimization,
+     * because recv usually returns EAGAIN error,
+     * and there is an additional system call overhead */
+    if (likely(cat_socket_internal_support_inline_read(socket_i))) {
+        cat_socket_fd_t fd = cat_socket_internal_get_fd_fast(socket_i);
+        if (unlikely(fd == CAT_SOCKET_INVALID_FD)) {
+            CAT_ASSERT(is_dgram && "only dgram fd creation is lazy");
+        } else while (1) {
+            while (1) {
+                if (socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_NOT_SOCK) {
+                    error = read(fd, buffer + nread, size - nread);
+                } else if (!is_dgram) {
+                    error = recv(fd, buffer + nread, size - nread, 0);
+                } else {
+                    error = recvfrom(fd, buffer, size, 0, address, address_length);
+                }
+                if (error < 0) {
+                    if (likely(cat_sys_errno == EAGAIN)) {
+                        break;
+                    }
+                    if (unlikely(cat_sys_errno == EINTR)) {
+                        continue;
+                    }
+                    if (unlikely(cat_sys_errno == ENOTSOCK)) {
+                        socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_NOT_SOCK;
+                        continue;
+                    }
+                    error = cat_translate_sys_error(cat_sys_errno);
+                    goto _error;
+                }
+                if (once) {
+                    return error;
+                }
+                nread += error;
+                if (nread == size) {
+                    return (ssize_t) nread;
+                }
+                if (error == 0) {
+                    error = CAT_ECONNRESET;
+                    goto _error;
+                }
+                break; /* next call must be EAGAIN */
+            }
+            if (is_udg) {
+                error = cat_socket_internal_udg_wait_readable(socket_i, fd, timeout);
+                if (unlikely(error != 0)) {
+                    if (error != CAT_EPREV) {
+                        goto _error;
+                    } else {
+                        goto _wait_error;
+                    }
+                } else {
+                    continue;
+                }
+            }
+            break;
+        }
+    }
+#endif
+
+    /* async read */
+    {
+        cat_socket_read_context_t context;
+        cat_bool_t ret;
+        /* construct context */
+        context.once = once;
+        context.buffer = buffer;
+        context.size = size;
+        context.nread = (size_t) nread;
+        if (is_dgram) {
+            context.address = address;
+            context.address_length = address_length;
+        }
+        context.error = CAT_ECANCELED;
+        context.scheduled = cat_false;
+        /* wait */
+        socket_i->context.io.read.data.ptr = &context;
+        socket_i->context.io.read.coroutine = CAT_COROUTINE_G(current);
+        socket_i->io_flags |= CAT_SOCKET_IO_FLAG_READ;
+        /* Notice: we must put (read/recv)_start here,
+         * because read_alloc_callback may triggered immediately on Windows,
+         * and it requires some data from context. */
+        if (!is_udp) {
+            error = uv_read_start(&socket_i->u.stream, cat_socket_read_alloc_callback, cat_socket_read_callback);
+        } else {
+            error = uv_udp_recv_start(&socket_i->u.udp, cat_socket_read_alloc_callback, cat_socket_udp_recv_callback);
+        }
+        ret = error == 0 && cat_time_wait(timeout);
+        socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_READ;
+        socket_i->context.io.read.coroutine = NULL;
+        socket_i->context.io.read.data.ptr = NULL;
+        if (unlikely(error != 0)) {
+            goto _error;
+        }
+        /* read stop after wait done */
+        if (!is_udp) {
+            uv_read_stop(&socket_i->u.stream);
+        } else {
+            uv_udp_recv_stop(&socket_i->u.udp);
+        }
+        /* handle error */
+        if (unlikely(!ret)) {
+            goto _wait_error;
+        }
+        nread = context.nread;
+        error = context.error;
+        if (unlikely(error != 0)) {
+            goto _error;
+        }
+    }
+
+    return (ssize_t) nread;
+
+    _error:
+    if (error == CAT_ECANCELED) {
+        cat_update_last_error(CAT_ECANCELED, "Socket read has been canceled");
+    } else if (1) {
+        cat_update_last_error_with_reason((cat_errno_t) error, "Socket read %s", nread != 0 ? "uncompleted" : "failed");
+    } else {
+        _wait_error:
+        cat_update_last_error_with_previous("Socket read wait failed");
+    }
+    if (nread != 0) {
+        /* for possible data */
+        return (ssize_t) nread;
+    } else {
+        if (is_dgram && address_length != NULL) {
+            *address_length = 0;
+        }
+        return -1;
+    }
+}
+
+static ssize_t cat_socket_internal_try_recv_raw(
+    cat_socket_internal_t *socket_i,
+    char *buffer, size_t size,
+    cat_sockaddr_t *address, cat_socklen_t *address_length
+)
+{
+    cat_socket_fd_t fd;
+    ssize_t nread;
+
+    if (unlikely(!cat_socket_internal_support_inline_read(socket_i))) {
+        return CAT_EMISUSE;
+    }
+    fd = cat_socket_internal_get_fd_fast(socket_i);
+    if (unlikely(fd == CAT_SOCKET_INVALID_FD)) {
+        return CAT_EBADF;
+    }
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    if (!(socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM) && socket_i->io_uring != NULL) {
+        nread = cat_socket_internal_io_uring_try_recv(socket_i, socket_i->io_uring, buffer, size);
+        if (nread != CAT_ENOTSUP) {
+            if (address_length != NULL) {
+                *address_length = 0;
+            }
+            return nread;
+        }
+    }
+#endif
+
+    while (1) {
+        nread = recvfrom(
+            fd, buffer, (cat_socket_recv_length_t) size, 0,
+            address, address_length
+        );
+        if (nread < 0) {
+#ifdef CAT_OS_UNIX_LIKE
+            if (unlikely(cat_sys_errno == EINTR)) {
+                continue;
+            }
+#endif
+            return cat_translate_sys_error(cat_sys_errno);
+        }
+        break;
+    }
+
+    return nread;
+}
+
+#ifdef CAT_SSL
+#ifdef CAT_SSL_HAVE_KTLS
+/* SSL_read() writes records (alert, KeyUpdate) to the fd directly in kTLS mode,
+ * data queued by libuv must go first to keep the order of records, so we wait until
+ * the write queue is drained and the fd is writable, then SSL_read() can flush them */
+static cat_bool_t cat_socket_internal_ssl_ktls_wait_writable(cat_socket_internal_t *socket_i, cat_timeout_t timeout)
+{
+    do {
+        cat_ret_t ret;
+        CAT_TIME_WAIT_START() {
+            ret = cat_poll_one(cat_socket_internal_get_fd_fast(socket_i), POLLOUT, NULL, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(ret != CAT_RET_OK)) {
+            if (ret == CAT_RET_ERROR) {
+                cat_update_last_error_with_previous("Socket SSL read failed when poll writable");
+            } else {
+                cat_update_last_error(CAT_ETIMEDOUT, "Socket SSL read timedout when poll writable");
+            }
+            return cat_false;
+        }
+    } while (socket_i->u.stream.write_queue_size != 0);
+
+    return cat_true;
+}
+#endif
+
+static ssize_t cat_socket_internal_read_decrypted(
+    cat_socket_internal_t *socket_i,
+    char *buffer, size_t size,
+    cat_sockaddr_t *address, cat_socklen_t *address_length,
+    cat_timeout_t timeout,
+    cat_bool_t once
+)
+{
+    cat_ssl_t *ssl = socket_i->ssl; CAT_ASSERT(ssl != NULL);
+    cat_buffer_t *read_buffer = &ssl->read_buffer;
+    size_t nread = 0;
+    cat_bool_t eof;
+
+    while (1) {
+        size_t out_length = size - nread;
+        ssize_t n;
+
+        if (!cat_ssl_decrypt(ssl, buffer + nread, &out_length, &eof)) {
+            cat_update_last_error_with_previous("Socket SSL decrypt failed");
+            goto _error;
+        }
+
+        if (out_length > 0) {
+            nread += out_length;
+            if (once) {
+                break;
+            }
+            if (nread == size) {
+                break;
+            }
+        }
+        if (eof) {
+            if (once) {
+                /* do not treat it as error */
+                break;
+            }
+            goto _error;
+        }
+#ifdef CAT_SSL_HAVE_KTLS
+        if (unlikely(ssl->flags & CAT_SSL_FLAG_KTLS_WANT_WRITE)) {
+            cat_bool_t ret;
+            CAT_TIME_WAIT_START() {
+                ret = cat_socket_internal_ssl_ktls_wait_writable(socket_i, timeout);
+            } CAT_TIME_WAIT_END(timeout);
+            if (unlikely(!ret)) {
+                goto _error;
+            }
+            continue;
+        }
+#endif
+
+        CAT_TIME_WAIT_START() {
+            n = cat_socket_internal_read_raw(
+                socket_i, read_buffer->value + read_buffer->length, read_buffer->size - read_buffer->length,
+                address, address_length, timeout, cat_true
+            );
+        } CAT_TIME_WAIT_END(timeout);
+
+        if (unlikely(n <= 0)) {
+            if (once && n == 0) {
+                /* do not treat it as error */
+                break;
+            }
+            goto _error;
+        }
+
+        read_buffer->length += n;
+    }
+
+    return (ssize_t) nread;
+
+    _error:
+    cat_socket_internal_ssl_recoverability_check(socket_i);
+    if (nread == 0) {
+        return -1;
+    }
+    return (ssize_t) nread;
+}
+
+static ssize_t cat_socket_internal_try_recv_decrypted(
+    cat_socket_internal_t *socket_i,
+    char *buffer, size_t size,
+    cat_sockaddr_t *address, cat_socklen_t *address_length
+)
+{
+    cat_ssl_t *ssl = socket_i->ssl; CAT_ASSERT(ssl != NULL);
+    cat_buffer_t *read_buffer = &ssl->read_buffer;
+
+    while (1) {
+        size_t out_length = size;
+        ssize_t nread;
+        cat_errno_t error = 0;
+        cat_bool_t decrypted, eof;
+
+        CAT_PROTECT_LAST_ERROR_START() {
+            decrypted = cat_ssl_decrypt(ssl, buffer, &out_length, &eof);
+            if (!decrypted) {
+                error = cat_get_last_error_code();
+            }
+        } CAT_PROTECT_LAST_ERROR_END();
+        if (!decrypted) {
+            cat_socket_internal_ssl_recoverability_check(socket_i);
+            return error;
+        }
+
+        if (out_length > 0) {
+            return out_length;
+        }
+        if (eof) {
+            return 0;
+        }
+#ifdef CAT_SSL_HAVE_KTLS
+        if (unlikely(ssl->flags & CAT_SSL_FLAG_KTLS_WANT_WRITE)) {
+            /* records are still pending, SSL_read() will retry to write them next time */
+            return CAT_EAGAIN;
+        }
+#endif
+
+        nread = cat_socket_internal_try_recv_raw(
+            socket_i,
+            read_buffer->value + read_buffer->length,
+            read_buffer->size - read_buffer->length,
+            address, address_length
+        );
+
+        if (unlikely(nread <= 0)) {
+            return nread;
+        }
+
+        read_buffer->length += nread;
+    }
+}
+#endif
+
+static cat_always_inline ssize_t cat_socket_internal_read_unbuffered(
+    cat_socket_internal_t *socket_i,
+    char *buffer, size_t size,
+    cat_sockaddr_t *address, cat_socklen_t *address_length,
+    cat_timeout_t timeout,
+    cat_bool_t once
+)
+{
+#ifdef CAT_SSL
+    if (socket_i->ssl != NULL) {
+        return cat_socket_internal_read_decrypted(socket_i, buffer, size, address, address_length, timeout, once);
+    }
+#endif
+    return cat_socket_internal_read_raw(socket_i, buffer, size, address, address_length, timeout, once);
+}
+
+/* buffered reader */
+
+static cat_always_inline size_t cat_socket_internal_get_read_buffered_length(const cat_socket_internal_t *socket_i)
+{
+    return socket_i->reader.buffer.length - socket_i->reader.offset;
+}
+
+/* consume buffered data */
+static cat_always_inline size_t cat_socket_internal_reader_read(cat_socket_internal_t *socket_i, char *buffer, size_t size, cat_bool_t peek)
+{
+    cat_socket_reader_t *reader = &socket_i->reader;
+    size_t n = CAT_MIN(cat_socket_internal_get_read_buffered_length(socket_i), size);
+
+    memcpy(buffer, reader->buffer.value + reader->offset, n);
+    if (!peek) {
+        reader->offset += n;
+    }
+
+    return n;
+}
+
+/* read more data into the reader buffer, make sure that it can hold expected_length bytes of data */
+static cat_bool_t cat_socket_internal_reader_fill(cat_socket_internal_t *socket_i, size_t expected_length, cat_timeout_t timeout)
+{
+    cat_socket_reader_t *reader = &socket_i->reader;
+    cat_buffer_t *buffer = &reader->buffer;
+    size_t length = cat_socket_internal_get_read_buffered_length(socket_i);
+    ssize_t n;
+
+    if (length == 0) {
+        reader->offset = 0;
+        buffer->length = 0;
+        /* do not hold the memory which was extended for large message */
+        if (buffer->size > CAT_SOCKET_READER_BUFFER_DEFAULT_SIZE * 8) {
+            cat_buffer_close(buffer);
+        }
+    }
+    if (buffer->value == NULL) {
+        if (unlikely(!cat_buffer_create(buffer, CAT_MAX(expected_length, CAT_SOCKET_READER_BUFFER_DEFAULT_SIZE)))) {
+            cat_update_last_error_with_previous("Socket reader buffer create failed");
+            return cat_false;
+        }
+    } else if (buffer->size - reader->offset < expected_length || buffer->length == buffer->size) {
+        if (reader->offset != 0) {
+            /* move data to the beginning */
+            memmove(buffer->value, buffer->value + reader->offset, length);
+            buffer->length = length;
+            reader->offset = 0;
+        }
+        if (buffer->size < expected_length || buffer->length == buffer->size) {
+            if (unlikely(!cat_buffer_extend(buffer, CAT_MAX(expected_length, buffer->size + 1)))) {
+                cat_update_last_error_with_previous("Socket reader buffer extend failed");
+                return cat_false;
+            }
+        }
+    }
+
+    n = cat_socket_internal_read_unbuffered(
+        socket_i, buffer->value + buffer->length, buffer->size - buffer->length,
+        NULL, NULL, timeout, cat_true
+    );
+    if (unlikely(n <= 0)) {
+        if (n == 0) {
+            cat_update_last_error(CAT_ECONNRESET, "Socket read uncompleted, connection closed before message was complete");
+        }
+        return cat_false;
+    }
+    buffer->length += n;
+
+    return cat_true;
+}
+
+static cat_never_inline ssize_t cat_socket_internal_read_buffered(
+    cat_socket_internal_t *socket_i,
+    char *buffer, size_t size,
+    cat_sockaddr_t *address, cat_socklen_t *address_length,
+    cat_timeout_t timeout,
+    cat_bool_t once
+)
+{
+    size_t nread = cat_socket_internal_reader_read(socket_i, buffer, size, cat_false);
+    ssize_t n;
+
+    if (once || nread == size) {
+        return (ssize_t) nread;
+    }
+    n = cat_socket_internal_read_unbuffered(socket_i, buffer + nread, size - nread, address, address_length, timeout, once);
+    if (unlikely(n < 0)) {
+        /* for possible data (last error has been updated) */
+        return (ssize_t) nread;
+    }
+
+    return (ssize_t) (nread + n);
+}
+
+static cat_always_inline ssize_t cat_socket_internal_read(
+    cat_socket_internal_t *socket_i,
+    char *buffer, size_t size,
+    cat_sockaddr_t *address, cat_socklen_t *address_length,
+    cat_timeout_t timeout,
+    cat_bool_t once
+)
+{
+    if (unlikely(cat_socket_internal_get_read_buffered_length(socket_i) != 0)) {
+        return cat_socket_internal_read_buffered(socket_i, buffer, size, address, address_length, timeout, once);
+    }
+    return cat_socket_internal_read_unbuffered(socket_i, buffer, size, address, address_length, timeout, once);
+}
+
+static cat_always_inline ssize_t cat_socket_internal_try_recv(
+    cat_socket_internal_t *socket_i,
+    char *buffer, size_t size,
+    cat_sockaddr_t *address, cat_socklen_t *address_length
+)
+{
+    if (unlikely(cat_socket_internal_get_read_buffered_length(socket_i) != 0)) {
+        return (ssize_t) cat_socket_internal_reader_read(socket_i, buffer, size, cat_false);
+    }
+#ifdef CAT_SSL
+    if (socket_i->ssl != NULL) {
+        return cat_socket_internal_try_recv_decrypted(socket_i, buffer, size, address, address_length);
+    }
 #endif
-            default:
-                address_length = 0;
+    return cat_socket_internal_try_recv_raw(socket_i, buffer, size, address, address_length);
+}
+
+CAT_STATIC_ASSERT(sizeof(cat_socket_write_vector_t) == sizeof(uv_buf_t));
+CAT_STATIC_ASSERT(offsetof(cat_socket_write_vector_t, base) == offsetof(uv_buf_t, base));
+CAT_STATIC_ASSERT(offsetof(cat_socket_write_vector_t, length) == offsetof(uv_buf_t, len));
+
+CAT_API size_t cat_socket_write_vector_length(const cat_socket_write_vector_t *vector, unsigned int vector_count)
+{
+    return cat_io_vector_length((const cat_io_vector_t *) vector, vector_count);
+}
+
+#ifdef CAT_ENABLE_DEBUG_LOG
+static CAT_BUFFER_STR_FREE char *cat_socket_write_vector_str(const cat_socket_write_vector_t *vector, unsigned int vector_count)
+{
+    cat_buffer_t buffer;
+    unsigned int i;
+    cat_buffer_create(&buffer, 256);
+    cat_buffer_append_char(&buffer, '[');
+    for (i = 0; i < vector_count; i++) {
+        size_t show_length = CAT_MIN(vector[i].length, CAT_LOG_G(str_size));
+        size_t need_size = cat_str_quote_size(show_length, CAT_STR_QUOTE_STYLE_FLAG_NONE);
+        if (i > 0) {
+            cat_buffer_append_str(&buffer, ", ");
         }
-        /* it can handle empty context->address internally */
-        (void) cat_sockaddr_copy(context->address, context->address_length, address, address_length);
-    } else {
-        if (context->address_length != NULL) {
-            *context->address_length = 0;
+        cat_buffer_append_char(&buffer, '{');
+        if (cat_buffer_prepare(&buffer, need_size)) {
+            size_t length = buffer.size - buffer.length;
+            cat_str_quote_ex2(vector[i].base, show_length, buffer.value + buffer.length, &length, CAT_STR_QUOTE_STYLE_FLAG_NONE, NULL);
+            buffer.length += length;
         }
+        cat_buffer_append_str(&buffer, ", ");
+        cat_buffer_append_unsigned(&buffer, vector[i].length);
+        cat_buffer_append_char(&buffer, '}');
     }
-    if (nread >= 0) {
-        context->nread = nread;
-        context->error = 0;
+    cat_buffer_append_char(&buffer, ']');
+    return cat_buffer_export_str(&buffer);
+}
+#endif
+
+/* IOCP/io_uring may not support wait writable */
+static cat_always_inline void cat_socket_internal_write_callback(cat_socket_internal_t *socket_i, cat_socket_write_request_t *request, int status)
+{
+    cat_coroutine_t *coroutine = request->u.coroutine;
+
+    if (coroutine != NULL) {
+        CAT_ASSERT(socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE);
+        request->error = status;
+        /* just resume and it will retry to send on while loop */
+        if (request == socket_i->cache.write_request) {
+            cat_coroutine_schedule_deferrable(coroutine, SOCKET, "Write");
+        } else {
+            /* request will be free'd soon */
+            cat_coroutine_schedule(coroutine, SOCKET, "Write");
+        }
+    }
+
+    if (request != socket_i->cache.write_request) {
+        cat_free(request);
+    }
+}
+
+/* write coalescing */
+
+struct cat_socket_write_batch_s {
+    uv_write_t request;
+    cat_queue_t members;
+    size_t length;
+    unsigned int vector_count;
+    unsigned int vector_size;
+    cat_socket_write_vector_t *vectors;
+};
+
+typedef struct cat_socket_write_batch_member_s {
+    cat_queue_node_t node;
+    /* it will be set to NULL when batch is done */
+    cat_coroutine_t *coroutine;
+    int error;
+} cat_socket_write_batch_member_t;
+
+static void cat_socket_write_batch_callback(uv_write_t *request, int status);
+
+static void cat_socket_write_batch_done(cat_socket_write_batch_t *batch, int status)
+{
+    cat_socket_write_batch_member_t *member;
+
+    while ((member = cat_queue_front_data(&batch->members, cat_socket_write_batch_member_t, node))) {
+        cat_coroutine_t *coroutine = member->coroutine;
+        cat_queue_remove(&member->node);
+        member->coroutine = NULL;
+        member->error = status;
+        cat_coroutine_schedule_deferrable(coroutine, SOCKET, "Write");
+    }
+    if (batch->vectors != NULL) {
+        cat_free(batch->vectors);
+    }
+    cat_free(batch);
+}
+
+/* submit pending batch to the write queue of libuv, data order is kept */
+static void cat_socket_internal_write_batch_submit(cat_socket_internal_t *socket_i)
+{
+    cat_socket_write_context_t *context = &socket_i->context.io.write;
+    cat_socket_write_batch_t *batch = context->batch;
+    int error;
+
+    if (batch == NULL) {
+        return;
+    }
+    context->batch = NULL;
+    if (unlikely(batch->vector_count == 0)) {
+        error = 0;
+        cat_socket_write_batch_done(batch, error);
+        return;
+    }
+    if (unlikely(uv_is_closing(&socket_i->u.handle))) {
+        error = CAT_ECANCELED;
     } else {
-        context->error = nread;
+        error = uv_write(
+            &batch->request, &socket_i->u.stream,
+            (const uv_buf_t *) batch->vectors, batch->vector_count,
+            cat_socket_write_batch_callback
+        );
+    }
+    if (unlikely(error != 0)) {
+        cat_socket_write_batch_done(batch, error);
+        return;
+    }
+    context->requests++;
+}
+
+static void cat_socket_write_batch_callback(uv_write_t *request, int status)
+{
+    cat_socket_write_batch_t *batch = cat_container_of(request, cat_socket_write_batch_t, request);
+    cat_socket_internal_t *socket_i = cat_container_of(request->handle, cat_socket_internal_t, u.stream);
+
+    socket_i->context.io.write.requests--;
+    cat_socket_internal_write_batch_submit(socket_i);
+    cat_socket_write_batch_done(batch, status);
+}
+
+static void cat_socket_write_callback(uv_write_t *request, int status)
+{
+    cat_socket_write_request_t *context = cat_container_of(request, cat_socket_write_request_t, u.stream);
+    cat_socket_internal_t *socket_i = cat_container_of(context->u.stream.handle, cat_socket_internal_t, u.stream);
+    socket_i->context.io.write.requests--;
+    /* submit writes which were queued before resuming the writer */
+    cat_socket_internal_write_batch_submit(socket_i);
+    cat_socket_internal_write_callback(socket_i, context, status);
+}
+
+static void cat_socket_udp_send_callback(uv_udp_send_t *request, int status)
+{
+    cat_socket_write_request_t *context = cat_container_of(request, cat_socket_write_request_t, u.udp);
+    cat_socket_internal_t *socket_i = cat_container_of(context->u.udp.handle, cat_socket_internal_t, u.udp);
+    cat_socket_internal_write_callback(socket_i, context, status);
+}
+
+#ifdef CAT_OS_UNIX_LIKE
+static cat_never_inline cat_bool_t cat_socket_internal_udg_write(
+    cat_socket_internal_t *socket_i,
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    const cat_sockaddr_t *address, cat_socklen_t address_length,
+    cat_timeout_t timeout
+)
+{
+    cat_socket_fd_t fd = cat_socket_internal_get_fd_fast(socket_i);
+    cat_queue_t *queue = &socket_i->context.io.write.coroutines;
+    cat_bool_t ret = cat_false;
+    ssize_t error;
+
+    if (socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE) {
+        cat_bool_t wait_ret;
+        cat_queue_push_back(queue, &CAT_COROUTINE_G(current)->waiter.node);
+        CAT_TIME_WAIT_START() {
+            wait_ret = cat_time_wait(timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        cat_queue_remove(&CAT_COROUTINE_G(current)->waiter.node);
+        if (unlikely(!wait_ret)) {
+            cat_update_last_error_with_previous("Socket write failed");
+            return cat_false;
+        }
+        if (cat_queue_front_data(queue, cat_coroutine_t, waiter.node) != CAT_COROUTINE_G(current)) {
+            cat_update_last_error(CAT_ECANCELED, "Socket write has been canceled");
+            return cat_false;
+        }
+    }
+    socket_i->io_flags |= CAT_SOCKET_IO_FLAG_WRITE;
+
+    while (1) {
+        struct msghdr msg;
+        msg.msg_name = (struct sockaddr *) address;
+        msg.msg_namelen = address_length;
+        msg.msg_iov = (struct iovec *) vector;
+        msg.msg_iovlen = vector_count;
+        msg.msg_control = NULL;
+        msg.msg_controllen = 0;
+        msg.msg_flags = 0;
+        do {
+            error = sendmsg(fd, &msg, 0);
+        } while (error < 0 && CAT_SOCKET_RETRY_ON_WRITE_ERROR(cat_sys_errno));
+        if (unlikely(error < 0)) {
+            if (CAT_SOCKET_IS_TRANSIENT_WRITE_ERROR(cat_sys_errno)) {
+                if (unlikely(socket_i->u.udg.writefd == CAT_OS_INVALID_FD)) {
+                    socket_i->u.udg.writefd = dup(fd);
+                    if (unlikely(socket_i->u.udg.writefd == CAT_OS_INVALID_FD)) {
+                        goto _syscall_error;
+                    }
+                }
+                cat_ret_t poll_ret = cat_poll_one(socket_i->u.udg.writefd, POLLOUT, NULL, timeout);
+                if (poll_ret == CAT_RET_OK) {
+                    continue;
+                } else if (poll_ret == CAT_RET_NONE) {
+                    cat_update_last_error(CAT_ETIMEDOUT, "Socket UDG poll writable timedout");
+                } else {
+                    cat_update_last_error_with_previous("Socket UDG poll writable failed");
+                }
+            } else {
+                _syscall_error:
+                cat_update_last_error_of_syscall("Socket write failed");
+            }
+        } else {
+            ret = cat_true;
+        }
+        break;
+    }
+
+    socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_WRITE;
+    if (!cat_queue_empty(queue)) {
+        /* resume queued coroutines */
+        cat_coroutine_t *waiter = cat_queue_front_data(queue, cat_coroutine_t, waiter.node);
+        cat_coroutine_schedule(waiter, SOCKET, "UDG write");
     }
-    do {
-        cat_coroutine_t *coroutine = socket_i->context.io.read.coroutine;
-        CAT_ASSERT(coroutine != NULL);
-        cat_coroutine_schedule(coroutine, SOCKET, "UDP recv");
-    } while (0);
+
+    return ret;
 }
+#endif
 
-#ifdef CAT_OS_UNIX_LIKE
-static int cat_socket_internal_udg_wait_readable(cat_socket_internal_t *socket_i, cat_socket_fd_t fd, cat_timeout_t timeout)
+/* join the pending batch and wait for it to be done,
+ * return CAT_RET_NONE if data is too large to be coalesced */
+static cat_never_inline cat_ret_t cat_socket_internal_write_coalesced(
+    cat_socket_internal_t *socket_i,
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    cat_timeout_t timeout
+)
 {
-    cat_ret_t ret;
-    if (socket_i->u.udg.readfd == CAT_OS_INVALID_FD) {
-        socket_i->u.udg.readfd = dup(fd);
-        if (unlikely(socket_i->u.udg.readfd == CAT_OS_INVALID_FD)) {
-            return cat_translate_sys_error(cat_sys_errno);
-        }
+    cat_socket_write_context_t *context = &socket_i->context.io.write;
+    cat_socket_write_batch_t *batch = context->batch;
+    cat_socket_write_batch_member_t member;
+    size_t length = 0;
+    unsigned int n;
+    cat_bool_t ret;
+
+    for (n = 0; n < vector_count; n++) {
+        length += vector[n].length;
     }
-    socket_i->context.io.read.coroutine = CAT_COROUTINE_G(current);
-    socket_i->io_flags |= CAT_SOCKET_IO_FLAG_READ;
-    ret = cat_poll_one(socket_i->u.udg.readfd, POLLIN, NULL, timeout);
-    socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_READ;
-    socket_i->context.io.read.coroutine = NULL;
-    if (ret == CAT_RET_OK) {
-        return 0;
-    } else if (ret == CAT_RET_NONE) {
-        return CAT_ETIMEDOUT;
-    } else {
-        return CAT_EPREV;
+    if (unlikely(vector_count > CAT_SOCKET_WRITE_COALESCING_MAX_VECTORS || length > CAT_SOCKET_WRITE_COALESCING_MAX_BYTES)) {
+        cat_socket_internal_write_batch_submit(socket_i);
+        return CAT_RET_NONE;
     }
-}
+    if (batch != NULL && (
+        batch->vector_count + vector_count > CAT_SOCKET_WRITE_COALESCING_MAX_VECTORS ||
+        batch->length + length > CAT_SOCKET_WRITE_COALESCING_MAX_BYTES
+    )) {
+        /* batch is full, send it and start a new one */
+        cat_socket_internal_write_batch_submit(socket_i);
+        batch = NULL;
+    }
+    if (batch == NULL) {
+        batch = (cat_socket_write_batch_t *) cat_malloc(sizeof(*batch));
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(batch == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for write batch failed");
+            return CAT_RET_ERROR;
+        }
 #endif
+        cat_queue_init(&batch->members);
+        batch->length = 0;
+        batch->vector_count = 0;
+        batch->vector_size = 0;
+        batch->vectors = NULL;
+        context->batch = batch;
+    }
+    if (batch->vector_count + vector_count > batch->vector_size) {
+        unsigned int vector_size = CAT_MAX(batch->vector_size * 2, 16);
+        cat_socket_write_vector_t *vectors;
+        while (vector_size < batch->vector_count + vector_count) {
+            vector_size *= 2;
+        }
+        vector_size = CAT_MIN(vector_size, CAT_SOCKET_WRITE_COALESCING_MAX_VECTORS);
+        vectors = (cat_socket_write_vector_t *) cat_realloc(batch->vectors, sizeof(*vectors) * vector_size);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(vectors == NULL)) {
+            cat_update_last_error_of_syscall("Realloc for write batch vectors failed");
+            return CAT_RET_ERROR;
+        }
+#endif
+        batch->vectors = vectors;
+        batch->vector_size = vector_size;
+    }
+    memcpy(batch->vectors + batch->vector_count, vector, sizeof(*vector) * vector_count);
+    batch->vector_count += vector_count;
+    batch->length += length;
 
-static cat_always_inline cat_bool_t cat_socket_internal_support_inline_read(const cat_socket_internal_t *socket_i)
-{
-    return socket_i->u.handle.type != UV_TTY &&
-           !(socket_i->u.handle.type == UV_NAMED_PIPE && socket_i->u.pipe.ipc);
+    member.coroutine = CAT_COROUTINE_G(current);
+    member.error = CAT_ECANCELED;
+    cat_queue_push_back(&batch->members, &member.node);
+    socket_i->io_flags |= CAT_SOCKET_IO_FLAG_WRITE;
+    cat_queue_push_back(&context->coroutines, &CAT_COROUTINE_G(current)->waiter.node);
+    ret = cat_time_wait(timeout);
+    cat_queue_remove(&CAT_COROUTINE_G(current)->waiter.node);
+    if (cat_queue_empty(&context->coroutines)) {
+        socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_WRITE;
+    }
+    if (unlikely(member.coroutine != NULL)) {
+        /* our data is still referenced by the batch,
+         * it can only be cancelled by socket_close() */
+        cat_queue_remove(&member.node);
+        cat_socket_internal_unrecoverable_io_error(socket_i);
+        if (unlikely(!ret)) {
+            cat_update_last_error_with_previous("Socket write wait failed");
+        } else {
+            cat_update_last_error(CAT_ECANCELED, "Socket write has been canceled");
+        }
+        return CAT_RET_ERROR;
+    }
+    if (unlikely(member.error != 0)) {
+        if (member.error == CAT_ECANCELED) {
+            cat_update_last_error(CAT_ECANCELED, "Socket write has been canceled");
+        } else {
+            cat_update_last_error_with_reason((cat_errno_t) member.error, "Socket write failed");
+        }
+        return CAT_RET_ERROR;
+    }
+
+    return CAT_RET_OK;
 }
 
-static ssize_t cat_socket_internal_read_raw(
+static cat_bool_t cat_socket_internal_write_raw(
     cat_socket_internal_t *socket_i,
-    char *buffer, size_t size,
-    cat_sockaddr_t *address, cat_socklen_t *address_length,
-    cat_timeout_t timeout,
-    cat_bool_t once
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    const cat_sockaddr_t *address, cat_socklen_t address_length,
+    cat_socket_t *send_handle,
+    cat_timeout_t timeout
 )
 {
-    cat_bool_t is_dgram = (socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM);
+    CAT_SOCKET_CHECK_INPUT_ADDRESS(address, address_length, return cat_false);
     cat_bool_t is_udp = ((socket_i->type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP);
-#ifdef CAT_OS_UNIX_LIKE
-    cat_bool_t is_udg = (socket_i->type & CAT_SOCKET_TYPE_UDG) == CAT_SOCKET_TYPE_UDG;
-#endif
-    size_t nread = 0;
+    cat_bool_t is_dgram = (socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM);
+    cat_bool_t ret = cat_false;
+    cat_socket_write_request_t *request;
+    size_t context_size;
     ssize_t error;
 
-    if (unlikely(size == 0)) {
-        error = CAT_ENOBUFS;
-        goto _error;
-    }
-
-    if (!is_dgram) {
-        if (unlikely(address_length != NULL)) {
-            *address_length = 0;
-        }
-    } else {
-        once = cat_true;
+#ifdef CAT_OS_UNIX_LIKE
+    /* libuv does not support dynamic address length */
+    CAT_ASSERT(
+        (!is_udp || address == NULL || address->sa_family != AF_UNIX || address_length >= sizeof(struct sockaddr_un)) &&
+        "Socket does not support variable size UNIX address on UDP"
+    );
+    if (is_dgram && !is_udp) {
+        ret = cat_socket_internal_udg_write(socket_i, vector, vector_count, address, address_length, timeout);
+        goto _out;
     }
+#endif
 
-#ifdef CAT_OS_UNIX_LIKE /* Do not inline read on WIN, proactor way is faster */
-    /* Notice: when IO is low/slow, this is de-optimization,
-     * because recv usually returns EAGAIN error,
-     * and there is an additional system call overhead */
-    if (likely(cat_socket_internal_support_inline_read(socket_i))) {
-        cat_socket_fd_t fd = cat_socket_internal_get_fd_fast(socket_i);
-        if (unlikely(fd == CAT_SOCKET_INVALID_FD)) {
-            CAT_ASSERT(is_dgram && "only dgram fd creation is lazy");
-        } else while (1) {
-            while (1) {
-                if (socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_NOT_SOCK) {
-                    error = read(fd, buffer + nread, size - nread);
-                } else if (!is_dgram) {
-                    error = recv(fd, buffer + nread, size - nread, 0);
-                } else {
-                    error = recvfrom(fd, buffer, size, 0, address, address_length);
-                }
-                if (error < 0) {
-                    if (likely(cat_sys_errno == EAGAIN)) {
-                        break;
-                    }
-                    if (unlikely(cat_sys_errno == EINTR)) {
-                        continue;
-                    }
-                    if (unlikely(cat_sys_errno == ENOTSOCK)) {
-                        socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_NOT_SOCK;
-                        continue;
-                    }
-                    error = cat_translate_sys_error(cat_sys_errno);
-                    goto _error;
-                }
-                if (once) {
-                    return error;
-                }
-                nread += error;
-                if (nread == size) {
-                    return (ssize_t) nread;
-                }
-                if (error == 0) {
-                    error = CAT_ECONNRESET;
-                    goto _error;
-                }
-                break; /* next call must be EAGAIN */
-            }
-            if (is_udg) {
-                error = cat_socket_internal_udg_wait_readable(socket_i, fd, timeout);
-                if (unlikely(error != 0)) {
-                    if (error != CAT_EPREV) {
-                        goto _error;
-                    } else {
-                        goto _wait_error;
-                    }
-                } else {
-                    continue;
-                }
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    if (!is_dgram && send_handle == NULL) {
+        cat_ret_t sent;
+        /* keep the order of data with the zero-copy send in flight */
+        if (socket_i->io_uring != NULL && cat_socket_io_uring_send_is_busy(socket_i->io_uring)) {
+            cat_bool_t wait_ret;
+            CAT_TIME_WAIT_START() {
+                wait_ret = cat_socket_internal_io_uring_send_wait(socket_i, socket_i->io_uring, timeout);
+            } CAT_TIME_WAIT_END(timeout);
+            if (unlikely(!wait_ret)) {
+                goto _out;
             }
-            break;
+        }
+        sent = cat_socket_internal_io_uring_write(socket_i, vector, vector_count, timeout);
+        if (sent != CAT_RET_NONE) {
+            ret = sent == CAT_RET_OK;
+            goto _out;
         }
     }
 #endif
 
-    /* async read */
-    {
-        cat_socket_read_context_t context;
-        cat_bool_t ret;
-        /* construct context */
-        context.once = once;
-        context.buffer = buffer;
-        context.size = size;
-        context.nread = (size_t) nread;
-        if (is_dgram) {
-            context.address = address;
-            context.address_length = address_length;
+    if (
+        (socket_i->option_flags & CAT_SOCKET_OPTION_FLAG_WRITE_COALESCING) &&
+        socket_i->context.io.write.requests != 0 &&
+        !is_dgram && send_handle == NULL
+    ) {
+        cat_ret_t coalesced = cat_socket_internal_write_coalesced(socket_i, vector, vector_count, timeout);
+        if (coalesced != CAT_RET_NONE) {
+            ret = coalesced == CAT_RET_OK;
+            goto _out;
         }
-        context.error = CAT_ECANCELED;
-        /* wait */
-        socket_i->context.io.read.data.ptr = &context;
-        socket_i->context.io.read.coroutine = CAT_COROUTINE_G(current);
-        socket_i->io_flags |= CAT_SOCKET_IO_FLAG_READ;
-        /* Notice: we must put (read/recv)_start here,
-         * because read_alloc_callback may triggered immediately on Windows,
-         * and it requires some data from context. */
+    }
+
+    if (!(socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE)) {
+        request = socket_i->cache.write_request;
+    } else {
+        request = NULL;
+    }
+    if (unlikely(request == NULL)) {
+        /* why we do not try write: on high-traffic scenarios, is_try_write will instead lead to performance */
         if (!is_udp) {
-            error = uv_read_start(&socket_i->u.stream, cat_socket_read_alloc_callback, cat_socket_read_callback);
+            context_size = cat_offsize_of(cat_socket_write_request_t, u.stream);
         } else {
-            error = uv_udp_recv_start(&socket_i->u.udp, cat_socket_read_alloc_callback, cat_socket_udp_recv_callback);
+            context_size = cat_offsize_of(cat_socket_write_request_t, u.udp);
         }
-        ret = error == 0 && cat_time_wait(timeout);
-        socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_READ;
-        socket_i->context.io.read.coroutine = NULL;
-        socket_i->context.io.read.data.ptr = NULL;
-        if (unlikely(error != 0)) {
-            goto _error;
+        request = (cat_socket_write_request_t *) cat_malloc(context_size);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(request == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for write request failed");
+            goto _out;
         }
-        /* read stop after wait done */
-        if (!is_udp) {
-            uv_read_stop(&socket_i->u.stream);
-        } else {
-            uv_udp_recv_stop(&socket_i->u.udp);
+#endif
+        if (!(socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE)) {
+            socket_i->cache.write_request = request;
+        }
+    }
+    if (!is_dgram) {
+        error = uv_write2(
+            &request->u.stream, &socket_i->u.stream,
+            (const uv_buf_t *) vector, vector_count,
+            send_handle == NULL ? NULL : &send_handle->internal->u.stream,
+            cat_socket_write_callback
+        );
+    } else {
+        error = uv_udp_send(
+            &request->u.udp, &socket_i->u.udp,
+            (const uv_buf_t *) vector, vector_count, address,
+            cat_socket_udp_send_callback
+        );
+    }
+    if (likely(error == 0)) {
+        if (!is_dgram) {
+            socket_i->context.io.write.requests++;
+        }
+        request->error = CAT_ECANCELED;
+        request->u.coroutine = CAT_COROUTINE_G(current);
+        socket_i->io_flags |= CAT_SOCKET_IO_FLAG_WRITE;
+        cat_queue_push_back(&socket_i->context.io.write.coroutines, &CAT_COROUTINE_G(current)->waiter.node);
+        ret = cat_time_wait(timeout);
+        cat_queue_remove(&CAT_COROUTINE_G(current)->waiter.node);
+        request->u.coroutine = NULL;
+        error = request->error;
+        if (cat_queue_empty(&socket_i->context.io.write.coroutines)) {
+            socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_WRITE;
         }
         /* handle error */
-        if (unlikely(!ret)) {
-            goto _wait_error;
+        if (unlikely(!ret || request->error == CAT_ECANCELED)) {
+            /* write request is in progress, it can not be cancelled gracefully,
+             * so we must cancel it by socket_close(), it's unrecoverable.
+             * TODO: should we wait for close done here?
+             * Release buffers before write operation is totally over is dangerous on Windows */
+            cat_socket_internal_unrecoverable_io_error(socket_i);
         }
-        nread = context.nread;
-        error = context.error;
-        if (unlikely(error != 0)) {
-            goto _error;
+        if (unlikely(!ret)) {
+            cat_update_last_error_with_previous("Socket write wait failed");
+            goto _out;
         }
     }
-
-    return (ssize_t) nread;
-
-    _error:
-    if (error == CAT_ECANCELED) {
-        cat_update_last_error(CAT_ECANCELED, "Socket read has been canceled");
-    } else if (1) {
-        cat_update_last_error_with_reason((cat_errno_t) error, "Socket read %s", nread != 0 ? "uncompleted" : "failed");
-    } else {
-        _wait_error:
-        cat_update_last_error_with_previous("Socket read wait failed");
-    }
-    if (nread != 0) {
-        /* for possible data */
-        return (ssize_t) nread;
-    } else {
-        if (is_dgram && address_length != NULL) {
-            *address_length = 0;
+    ret = error == 0;
+    if (unlikely(!ret)) {
+        if (error == CAT_ECANCELED) {
+            cat_update_last_error(CAT_ECANCELED, "Socket write has been canceled");
+        } else {
+            cat_update_last_error_with_reason((cat_errno_t) error, "Socket write failed");
         }
-        return -1;
     }
+
+    _out:
+    return ret;
 }
 
-static ssize_t cat_socket_internal_try_recv_raw(
+#ifdef CAT_OS_UNIX_LIKE
+static cat_never_inline ssize_t cat_socket_internal_udg_try_write(
     cat_socket_internal_t *socket_i,
-    char *buffer, size_t size,
-    cat_sockaddr_t *address, cat_socklen_t *address_length
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    const cat_sockaddr_t *address, cat_socklen_t address_length
 )
 {
     cat_socket_fd_t fd;
-    ssize_t nread;
+    struct msghdr msg;
+    ssize_t nwrite;
 
-    if (unlikely(!cat_socket_internal_support_inline_read(socket_i))) {
-        return CAT_EMISUSE;
+    if (!!(socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE)) {
+        return CAT_EAGAIN;
     }
+
     fd = cat_socket_internal_get_fd_fast(socket_i);
-    if (unlikely(fd == CAT_SOCKET_INVALID_FD)) {
-        return CAT_EBADF;
+    msg.msg_name = (struct sockaddr *) address;
+    msg.msg_namelen = address_length;
+    msg.msg_iov = (struct iovec *) vector;
+    msg.msg_iovlen = vector_count;
+    msg.msg_control = NULL;
+    msg.msg_controllen = 0;
+    msg.msg_flags = 0;
+    do {
+        nwrite = sendmsg(fd, &msg, 0);
+    } while (nwrite < 0 && CAT_SOCKET_RETRY_ON_WRITE_ERROR(cat_sys_errno));
+
+    if (unlikely(nwrite < 0)) {
+        return cat_translate_sys_error(cat_sys_errno);
     }
+    return nwrite;
+}
+#endif
+
+static ssize_t cat_socket_internal_try_write_raw(
+    cat_socket_internal_t *socket_i,
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    const cat_sockaddr_t *address, cat_socklen_t address_length
+)
+{
+    CAT_SOCKET_CHECK_INPUT_ADDRESS_SILENT(address, address_length, return cat_false);
+    cat_bool_t is_dgram = (socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM);
 
-    while (1) {
-        nread = recvfrom(
-            fd, buffer, (cat_socket_recv_length_t) size, 0,
-            address, address_length
-        );
-        if (nread < 0) {
 #ifdef CAT_OS_UNIX_LIKE
-            if (unlikely(cat_sys_errno == EINTR)) {
-                continue;
-            }
+    cat_bool_t is_udp = ((socket_i->type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP);
+    /* libuv does not support dynamic address length */
+    CAT_ASSERT(
+        (!is_udp || address == NULL || address->sa_family != AF_UNIX || address_length >= sizeof(struct sockaddr_un)) &&
+        "Socket does not support variable size UNIX address on UDP"
+    );
+    if (is_dgram && !is_udp) {
+        return cat_socket_internal_udg_try_write(socket_i, vector, vector_count, address, address_length);
+    }
 #endif
-            return cat_translate_sys_error(cat_sys_errno);
-        }
-        break;
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    if (!is_dgram && socket_i->io_uring != NULL && cat_socket_io_uring_send_is_busy(socket_i->io_uring)) {
+        return CAT_EAGAIN;
+    }
+#endif
+    if (!is_dgram) {
+        return uv_try_write(
+            &socket_i->u.stream,
+            (const uv_buf_t *) vector, vector_count
+        );
+    } else {
+        return uv_udp_try_send(
+            &socket_i->u.udp,
+            (const uv_buf_t *) vector, vector_count,
+            address
+        );
     }
-
-    return nread;
 }
 
 #ifdef CAT_SSL
-static ssize_t cat_socket_internal_read_decrypted(
+static cat_bool_t cat_socket_internal_write_encrypted(
     cat_socket_internal_t *socket_i,
-    char *buffer, size_t size,
-    cat_sockaddr_t *address, cat_socklen_t *address_length,
-    cat_timeout_t timeout,
-    cat_bool_t once
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    const cat_sockaddr_t *address, cat_socklen_t address_length,
+    cat_timeout_t timeout
 )
 {
     cat_ssl_t *ssl = socket_i->ssl; CAT_ASSERT(ssl != NULL);
-    cat_buffer_t *read_buffer = &ssl->read_buffer;
-    size_t nread = 0;
-    cat_bool_t eof;
+    cat_io_vector_t ssl_vector[8];
+    unsigned int ssl_vector_count = CAT_ARRAY_SIZE(ssl_vector);
+    cat_bool_t ret;
 
-    while (1) {
-        size_t out_length = size - nread;
-        ssize_t n;
+    /* Notice: we must encrypt all buffers at once,
+     * otherwise we will not be able to support queued writes */
+    ret = cat_ssl_encrypt(
+        socket_i->ssl,
+        (const cat_io_vector_t *) vector, vector_count,
+        ssl_vector, &ssl_vector_count
+    );
 
-        if (!cat_ssl_decrypt(ssl, buffer + nread, &out_length, &eof)) {
-            cat_update_last_error_with_previous("Socket SSL decrypt failed");
-            goto _error;
-        }
+    if (unlikely(!ret)) {
+        cat_update_last_error_with_previous("Socket SSL write failed");
+        cat_socket_internal_ssl_recoverability_check(socket_i);
+        return cat_false;
+    }
 
-        if (out_length > 0) {
-            nread += out_length;
-            if (once) {
-                break;
-            }
-            if (nread == size) {
-                break;
-            }
-        }
-        if (eof) {
-            if (once) {
-                /* do not treat it as error */
-                break;
-            }
-            goto _error;
+    ret = cat_socket_internal_write_raw(
+        socket_i, (cat_socket_write_vector_t *) ssl_vector, ssl_vector_count,
+        address, address_length, NULL, timeout
+    );
+
+    cat_ssl_encrypted_vector_free(ssl, ssl_vector, ssl_vector_count);
+
+    return ret;
+}
+
+static void cat_socket_internal_try_write_encrypted_callback(uv_write_t *request, int status)
+{
+    cat_socket_internal_t *socket_i = (cat_socket_internal_t *) request->data;
+    if (status == 0) {
+        socket_i->ssl->write_buffer.length = 0;
+    }
+}
+
+static ssize_t cat_socket_internal_try_write_encrypted(
+    cat_socket_internal_t *socket_i,
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    const cat_sockaddr_t *address, cat_socklen_t address_length
+)
+{
+    cat_ssl_t *ssl = socket_i->ssl; CAT_ASSERT(ssl != NULL);
+    if (unlikely(ssl->write_buffer.length != 0)) {
+        return CAT_EAGAIN;
+    }
+    cat_io_vector_t ssl_vector[8];
+    unsigned int ssl_vector_count;
+    ssize_t nwrite, nwrite_encrypted;
+    cat_bool_t encrypted;
+    cat_errno_t error = 0;
+
+    /* Notice: we must encrypt all buffers at once,
+     * otherwise we will not be able to support queued writes. */
+    ssl_vector_count = CAT_ARRAY_SIZE(ssl_vector);
+    CAT_PROTECT_LAST_ERROR_START() {
+        encrypted = cat_ssl_encrypt(
+            socket_i->ssl,
+            (const cat_io_vector_t *) vector, vector_count,
+            ssl_vector, &ssl_vector_count
+        );
+        if (unlikely(!encrypted)) {
+            error = cat_get_last_error_code();
         }
+    } CAT_PROTECT_LAST_ERROR_END();
+    if (unlikely(!encrypted)) {
+        cat_socket_internal_ssl_recoverability_check(socket_i);
+        return error;
+    }
 
-        CAT_TIME_WAIT_START() {
-            n = cat_socket_internal_read_raw(
-                socket_i, read_buffer->value + read_buffer->length, read_buffer->size - read_buffer->length,
-                address, address_length, timeout, cat_true
-            );
-        } CAT_TIME_WAIT_END(timeout);
+    nwrite_encrypted = cat_socket_internal_try_write_raw(
+        socket_i,
+        (cat_socket_write_vector_t *) ssl_vector, ssl_vector_count,
+        address, address_length
+    );
 
-        if (unlikely(n <= 0)) {
-            if (once && n == 0) {
-                /* do not treat it as error */
+    if (nwrite_encrypted == CAT_EAGAIN) {
+        nwrite_encrypted = 0;
+    }
+    if (unlikely(nwrite_encrypted < 0)) {
+        nwrite = nwrite_encrypted;
+    } else {
+        cat_io_vector_t *ssl_vector_current = ssl_vector;
+        cat_io_vector_t *ssl_vector_eof = ssl_vector + ssl_vector_count;
+        size_t ssl_vector_base_offset = nwrite_encrypted;
+        nwrite = cat_io_vector_length((const cat_io_vector_t *) vector, vector_count);
+        while (ssl_vector_base_offset >= ssl_vector_current->length) {
+            ssl_vector_base_offset -= ssl_vector_current->length;
+            if (++ssl_vector_current == ssl_vector_eof) {
                 break;
             }
-            goto _error;
         }
-
-        read_buffer->length += n;
+        /* Well, this could be confusing. if we can not send all encrypted data at once,
+         * we really can not know how many bytes of raw data has been sent,
+         * so the only thing we can do is to store the remaining data to buffer and
+         * try again in the next call. */
+#ifdef CAT_DEBUG
+        size_t encrypted_bytes = cat_io_vector_length(ssl_vector, ssl_vector_count);
+        CAT_LOG_DEBUG(SSL, "SSL %p expect send %zu encrypted bytes, actually %zu bytes was sent (raw data is %zu bytes)",
+            ssl, encrypted_bytes, (size_t) nwrite_encrypted, (size_t) nwrite);
+        CAT_ASSERT(((size_t) nwrite_encrypted == encrypted_bytes) ==
+                    (ssl_vector_current == ssl_vector_eof));
+#endif
+        if (ssl_vector_current != ssl_vector_eof) {
+            if (ssl_vector_current->base == ssl->write_buffer.value) {
+                ssl->write_buffer.length = ssl_vector_current->length - ssl_vector_base_offset;
+                memmove(ssl->write_buffer.value,
+                        ssl_vector_current->base + ssl_vector_base_offset,
+                        ssl->write_buffer.length);
+            } else {
+                cat_buffer_append(&ssl->write_buffer,
+                    ssl_vector_current->base + ssl_vector_base_offset,
+                    ssl_vector_current->length - ssl_vector_base_offset);
+            }
+            while (++ssl_vector_current < ssl_vector_eof) {
+                cat_buffer_append(&ssl->write_buffer,
+                    ssl_vector_current->base,
+                    ssl_vector_current->length);
+            }
+            /* We tell caller all data has been sent, but actually they are in buffered,
+                * it's ok, just like syscall write() did. */
+            CAT_LOG_DEBUG(SSL, "SSL %p write buffer now has %zu bytes queued data", ssl, ssl->write_buffer.length);
+            uv_write_t *request = (uv_write_t *) cat_malloc(sizeof(*request));
+#if CAT_ALLOC_HANDLE_ERRORS
+            if (unlikely(request == NULL)) {
+                nwrite = cat_translate_sys_error(cat_sys_errno);
+            } else
+#endif
+            {
+                uv_buf_t buf;
+                request->data = socket_i;
+                buf.base = ssl->write_buffer.value;
+                buf.len = (cat_io_vector_length_t) ssl->write_buffer.length;
+                int error = uv_write(request, &socket_i->u.stream, &buf, 1, cat_socket_internal_try_write_encrypted_callback);
+                if (unlikely(error != 0)) {
+                    nwrite = error;
+                }
+            }
+        }
     }
 
-    return (ssize_t) nread;
+    cat_ssl_encrypted_vector_free(ssl, ssl_vector, ssl_vector_count);
 
-    _error:
-    cat_socket_internal_ssl_recoverability_check(socket_i);
-    if (nread == 0) {
-        return -1;
-    }
-    return (ssize_t) nread;
+    return nwrite;
 }
+#endif
 
-static ssize_t cat_socket_internal_try_recv_decrypted(
-    cat_socket_internal_t *socket_i,
-    char *buffer, size_t size,
-    cat_sockaddr_t *address, cat_socklen_t *address_length
-)
+#ifdef CAT_SSL
+/* records are encrypted by kernel if kTLS send is enabled */
+static cat_always_inline cat_bool_t cat_socket_internal_should_encrypt(const cat_socket_internal_t *socket_i)
 {
-    cat_ssl_t *ssl = socket_i->ssl; CAT_ASSERT(ssl != NULL);
-    cat_buffer_t *read_buffer = &ssl->read_buffer;
-
-    while (1) {
-        size_t out_length = size;
-        ssize_t nread;
-        cat_errno_t error = 0;
-        cat_bool_t decrypted, eof;
-
-        CAT_PROTECT_LAST_ERROR_START() {
-            decrypted = cat_ssl_decrypt(ssl, buffer, &out_length, &eof);
-            if (!decrypted) {
-                error = cat_get_last_error_code();
-            }
-        } CAT_PROTECT_LAST_ERROR_END();
-        if (!decrypted) {
-            cat_socket_internal_ssl_recoverability_check(socket_i);
-            return error;
-        }
-
-        if (out_length > 0) {
-            return out_length;
-        }
-        if (eof) {
-            return 0;
-        }
-
-        nread = cat_socket_internal_try_recv_raw(
-            socket_i,
-            read_buffer->value + read_buffer->length,
-            read_buffer->size - read_buffer->length,
-            address, address_length
-        );
-
-        if (unlikely(nread <= 0)) {
-            return nread;
-        }
-
-        read_buffer->length += nread;
-    }
+    return socket_i->ssl != NULL && !(socket_i->ssl->flags & CAT_SSL_FLAG_KTLS_SEND);
 }
 #endif
 
-static cat_always_inline ssize_t cat_socket_internal_read(
+static cat_always_inline cat_bool_t cat_socket_internal_write_uncorked(
     cat_socket_internal_t *socket_i,
-    char *buffer, size_t size,
-    cat_sockaddr_t *address, cat_socklen_t *address_length,
-    cat_timeout_t timeout,
-    cat_bool_t once
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    const cat_sockaddr_t *address, cat_socklen_t address_length,
+    cat_timeout_t timeout
 )
 {
 #ifdef CAT_SSL
-    if (socket_i->ssl != NULL) {
-        return cat_socket_internal_read_decrypted(socket_i, buffer, size, address, address_length, timeout, once);
+    /** @thinking: shall we check and wait for previous hanging write coroutines here?
+     * before previous write() are done (writable/POLLOUT), may SSL can not encrypt more data? */
+    if (cat_socket_internal_should_encrypt(socket_i)) {
+        return cat_socket_internal_write_encrypted(socket_i, vector, vector_count, address, address_length, timeout);
     }
 #endif
-    return cat_socket_internal_read_raw(socket_i, buffer, size, address, address_length, timeout, once);
+    return cat_socket_internal_write_raw(socket_i, vector, vector_count, address, address_length, NULL, timeout);
 }
 
-static cat_always_inline ssize_t cat_socket_internal_try_recv(
+/* send corked data and the extra vectors by one write */
+static cat_never_inline cat_bool_t cat_socket_internal_cork_flush(
     cat_socket_internal_t *socket_i,
-    char *buffer, size_t size,
-    cat_sockaddr_t *address, cat_socklen_t *address_length
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    cat_timeout_t timeout
 )
 {
-#ifdef CAT_SSL
-    if (socket_i->ssl != NULL) {
-        return cat_socket_internal_try_recv_decrypted(socket_i, buffer, size, address, address_length);
-    }
-#endif
-    return cat_socket_internal_try_recv_raw(socket_i, buffer, size, address, address_length);
-}
-
-CAT_STATIC_ASSERT(sizeof(cat_socket_write_vector_t) == sizeof(uv_buf_t));
-CAT_STATIC_ASSERT(offsetof(cat_socket_write_vector_t, base) == offsetof(uv_buf_t, base));
-CAT_STATIC_ASSERT(offsetof(cat_socket_write_vector_t, length) == offsetof(uv_buf_t, len));
-
-CAT_API size_t cat_socket_write_vector_length(const cat_socket_write_vector_t *vector, unsigned int vector_count)
-{
-    return cat_io_vector_length((const cat_io_vector_t *) vector, vector_count);
-}
-
-#ifdef CAT_ENABLE_DEBUG_LOG
-static CAT_BUFFER_STR_FREE char *cat_socket_write_vector_str(const cat_socket_write_vector_t *vector, unsigned int vector_count)
-{
+    cat_socket_write_context_t *context = &socket_i->context.io.write;
+    cat_socket_write_vector_t vectors[8];
     cat_buffer_t buffer;
-    unsigned int i;
-    cat_buffer_create(&buffer, 256);
-    cat_buffer_append_char(&buffer, '[');
-    for (i = 0; i < vector_count; i++) {
-        size_t show_length = CAT_MIN(vector[i].length, CAT_LOG_G(str_size));
-        size_t need_size = cat_str_quote_size(show_length, CAT_STR_QUOTE_STYLE_FLAG_NONE);
-        if (i > 0) {
-            cat_buffer_append_str(&buffer, ", ");
-        }
-        cat_buffer_append_char(&buffer, '{');
-        if (cat_buffer_prepare(&buffer, need_size)) {
-            size_t length = buffer.size - buffer.length;
-            cat_str_quote_ex2(vector[i].base, show_length, buffer.value + buffer.length, &length, CAT_STR_QUOTE_STYLE_FLAG_NONE, NULL);
-            buffer.length += length;
+    unsigned int n = 0, i;
+    cat_bool_t ret = cat_true;
+
+    if (unlikely(vector_count >= CAT_ARRAY_SIZE(vectors))) {
+        for (i = 0; i < vector_count; i++) {
+            if (unlikely(!cat_buffer_append(&context->cork_buffer, vector[i].base, vector[i].length))) {
+                cat_update_last_error_with_previous("Socket cork buffer append failed");
+                return cat_false;
+            }
         }
-        cat_buffer_append_str(&buffer, ", ");
-        cat_buffer_append_unsigned(&buffer, vector[i].length);
-        cat_buffer_append_char(&buffer, '}');
+        vector_count = 0;
     }
-    cat_buffer_append_char(&buffer, ']');
-    return cat_buffer_export_str(&buffer);
-}
-#endif
-
-/* IOCP/io_uring may not support wait writable */
-static cat_always_inline void cat_socket_internal_write_callback(cat_socket_internal_t *socket_i, cat_socket_write_request_t *request, int status)
-{
-    cat_coroutine_t *coroutine = request->u.coroutine;
-
-    if (coroutine != NULL) {
-        CAT_ASSERT(socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE);
-        request->error = status;
-        /* just resume and it will retry to send on while loop */
-        cat_coroutine_schedule(coroutine, SOCKET, "Write");
+    /* other coroutines may write to the cork buffer while we are waiting, so we take it over */
+    buffer = context->cork_buffer;
+    cat_buffer_init(&context->cork_buffer);
+    if (buffer.length > 0) {
+        vectors[n++] = cat_socket_write_vector_init(buffer.value, (cat_socket_vector_length_t) buffer.length);
     }
-
-    if (request != socket_i->cache.write_request) {
-        cat_free(request);
+    for (i = 0; i < vector_count; i++) {
+        vectors[n++] = vector[i];
+    }
+    if (n > 0) {
+        ret = cat_socket_internal_write_uncorked(socket_i, vectors, n, NULL, 0, timeout);
+    }
+    if (context->corked && context->cork_buffer.value == NULL) {
+        /* reuse it for the following writes */
+        buffer.length = 0;
+        context->cork_buffer = buffer;
+    } else {
+        cat_buffer_close(&buffer);
     }
-}
-
-static void cat_socket_write_callback(uv_write_t *request, int status)
-{
-    cat_socket_write_request_t *context = cat_container_of(request, cat_socket_write_request_t, u.stream);
-    cat_socket_internal_t *socket_i = cat_container_of(context->u.stream.handle, cat_socket_internal_t, u.stream);
-    cat_socket_internal_write_callback(socket_i, context, status);
-}
 
-static void cat_socket_udp_send_callback(uv_udp_send_t *request, int status)
-{
-    cat_socket_write_request_t *context = cat_container_of(request, cat_socket_write_request_t, u.udp);
-    cat_socket_internal_t *socket_i = cat_container_of(context->u.udp.handle, cat_socket_internal_t, u.udp);
-    cat_socket_internal_write_callback(socket_i, context, status);
+    return ret;
 }
 
-#ifdef CAT_OS_UNIX_LIKE
-static cat_never_inline cat_bool_t cat_socket_internal_udg_write(
+static cat_never_inline cat_bool_t cat_socket_internal_write_corked(
     cat_socket_internal_t *socket_i,
     const cat_socket_write_vector_t *vector, unsigned int vector_count,
-    const cat_sockaddr_t *address, cat_socklen_t address_length,
     cat_timeout_t timeout
 )
 {
-    cat_socket_fd_t fd = cat_socket_internal_get_fd_fast(socket_i);
-    cat_queue_t *queue = &socket_i->context.io.write.coroutines;
-    cat_bool_t ret = cat_false;
-    ssize_t error;
+    cat_buffer_t *buffer = &socket_i->context.io.write.cork_buffer;
+    size_t length = 0;
+    unsigned int n;
 
-    if (socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE) {
-        cat_bool_t wait_ret;
-        cat_queue_push_back(queue, &CAT_COROUTINE_G(current)->waiter.node);
-        CAT_TIME_WAIT_START() {
-            wait_ret = cat_time_wait(timeout);
-        } CAT_TIME_WAIT_END(timeout);
-        cat_queue_remove(&CAT_COROUTINE_G(current)->waiter.node);
-        if (unlikely(!wait_ret)) {
-            cat_update_last_error_with_previous("Socket write failed");
-            return cat_false;
-        }
-        if (cat_queue_front_data(queue, cat_coroutine_t, waiter.node) != CAT_COROUTINE_G(current)) {
-            cat_update_last_error(CAT_ECANCELED, "Socket write has been canceled");
-            return cat_false;
-        }
+    for (n = 0; n < vector_count; n++) {
+        length += vector[n].length;
     }
-    socket_i->io_flags |= CAT_SOCKET_IO_FLAG_WRITE;
-
-    while (1) {
-        struct msghdr msg;
-        msg.msg_name = (struct sockaddr *) address;
-        msg.msg_namelen = address_length;
-        msg.msg_iov = (struct iovec *) vector;
-        msg.msg_iovlen = vector_count;
-        msg.msg_control = NULL;
-        msg.msg_controllen = 0;
-        msg.msg_flags = 0;
-        do {
-            error = sendmsg(fd, &msg, 0);
-        } while (error < 0 && CAT_SOCKET_RETRY_ON_WRITE_ERROR(cat_sys_errno));
-        if (unlikely(error < 0)) {
-            if (CAT_SOCKET_IS_TRANSIENT_WRITE_ERROR(cat_sys_errno)) {
-                if (unlikely(socket_i->u.udg.writefd == CAT_OS_INVALID_FD)) {
-                    socket_i->u.udg.writefd = dup(fd);
-                    if (unlikely(socket_i->u.udg.writefd == CAT_OS_INVALID_FD)) {
-                        goto _syscall_error;
-                    }
-                }
-                cat_ret_t poll_ret = cat_poll_one(socket_i->u.udg.writefd, POLLOUT, NULL, timeout);
-                if (poll_ret == CAT_RET_OK) {
-                    continue;
-                } else if (poll_ret == CAT_RET_NONE) {
-                    cat_update_last_error(CAT_ETIMEDOUT, "Socket UDG poll writable timedout");
-                } else {
-                    cat_update_last_error_with_previous("Socket UDG poll writable failed");
-                }
-            } else {
-                _syscall_error:
-                cat_update_last_error_of_syscall("Socket write failed");
-            }
-        } else {
-            ret = cat_true;
-        }
-        break;
+    if (buffer->length + length >= CAT_SOCKET_CORK_BUFFER_MAX_SIZE) {
+        return cat_socket_internal_cork_flush(socket_i, vector, vector_count, timeout);
     }
-
-    socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_WRITE;
-    if (!cat_queue_empty(queue)) {
-        /* resume queued coroutines */
-        cat_coroutine_t *waiter = cat_queue_front_data(queue, cat_coroutine_t, waiter.node);
-        cat_coroutine_schedule(waiter, SOCKET, "UDG write");
+    if (unlikely(!cat_buffer_prepare(buffer, length))) {
+        cat_update_last_error_with_previous("Socket cork buffer prepare failed");
+        return cat_false;
+    }
+    for (n = 0; n < vector_count; n++) {
+        (void) cat_buffer_append(buffer, vector[n].base, vector[n].length);
     }
 
-    return ret;
+    return cat_true;
 }
-#endif
 
-static cat_bool_t cat_socket_internal_write_raw(
+static cat_always_inline cat_bool_t cat_socket_internal_write(
     cat_socket_internal_t *socket_i,
     const cat_socket_write_vector_t *vector, unsigned int vector_count,
     const cat_sockaddr_t *address, cat_socklen_t address_length,
-    cat_socket_t *send_handle,
     cat_timeout_t timeout
 )
 {
-    CAT_SOCKET_CHECK_INPUT_ADDRESS(address, address_length, return cat_false);
-    cat_bool_t is_udp = ((socket_i->type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP);
-    cat_bool_t is_dgram = (socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM);
-    cat_bool_t ret = cat_false;
-    cat_socket_write_request_t *request;
-    size_t context_size;
-    ssize_t error;
-
-#ifdef CAT_OS_UNIX_LIKE
-    /* libuv does not support dynamic address length */
-    CAT_ASSERT(
-        (!is_udp || address == NULL || address->sa_family != AF_UNIX || address_length >= sizeof(struct sockaddr_un)) &&
-        "Socket does not support variable size UNIX address on UDP"
-    );
-    if (is_dgram && !is_udp) {
-        ret = cat_socket_internal_udg_write(socket_i, vector, vector_count, address, address_length, timeout);
-        goto _out;
+    if (unlikely(socket_i->context.io.write.corked)) {
+        return cat_socket_internal_write_corked(socket_i, vector, vector_count, timeout);
     }
-#endif
+    return cat_socket_internal_write_uncorked(socket_i, vector, vector_count, address, address_length, timeout);
+}
 
-    if (!(socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE)) {
-        request = socket_i->cache.write_request;
-    } else {
-        request = NULL;
-    }
-    if (unlikely(request == NULL)) {
-        /* why we do not try write: on high-traffic scenarios, is_try_write will instead lead to performance */
-        if (!is_udp) {
-            context_size = cat_offsize_of(cat_socket_write_request_t, u.stream);
-        } else {
-            context_size = cat_offsize_of(cat_socket_write_request_t, u.udp);
-        }
-        request = (cat_socket_write_request_t *) cat_malloc(context_size);
-#if CAT_ALLOC_HANDLE_ERRORS
-        if (unlikely(request == NULL)) {
-            cat_update_last_error_of_syscall("Malloc for write request failed");
-            goto _out;
-        }
-#endif
-        if (!(socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE)) {
-            socket_i->cache.write_request = request;
-        }
-    }
-    if (!is_dgram) {
-        error = uv_write2(
-            &request->u.stream, &socket_i->u.stream,
-            (const uv_buf_t *) vector, vector_count,
-            send_handle == NULL ? NULL : &send_handle->internal->u.stream,
-            cat_socket_write_callback
-        );
-    } else {
-        error = uv_udp_send(
-            &request->u.udp, &socket_i->u.udp,
-            (const uv_buf_t *) vector, vector_count, address,
-            cat_socket_udp_send_callback
-        );
-    }
-    if (likely(error == 0)) {
-        request->error = CAT_ECANCELED;
-        request->u.coroutine = CAT_COROUTINE_G(current);
-        socket_i->io_flags |= CAT_SOCKET_IO_FLAG_WRITE;
-        cat_queue_push_back(&socket_i->context.io.write.coroutines, &CAT_COROUTINE_G(current)->waiter.node);
-        ret = cat_time_wait(timeout);
-        cat_queue_remove(&CAT_COROUTINE_G(current)->waiter.node);
-        request->u.coroutine = NULL;
-        error = request->error;
-        if (cat_queue_empty(&socket_i->context.io.write.coroutines)) {
-            socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_WRITE;
+static cat_always_inline ssize_t cat_socket_internal_try_write(
+    cat_socket_internal_t *socket_i,
+    const cat_socket_write_vector_t *vector, unsigned int vector_count,
+    const cat_sockaddr_t *address, cat_socklen_t address_length
+)
+{
+    if (unlikely(socket_i->context.io.write.corked)) {
+        cat_buffer_t *buffer = &socket_i->context.io.write.cork_buffer;
+        size_t length = 0;
+        unsigned int n;
+        /* it never blocks, data will be flushed by the next write() or uncork() */
+        for (n = 0; n < vector_count; n++) {
+            length += vector[n].length;
         }
-        /* handle error */
-        if (unlikely(!ret || request->error == CAT_ECANCELED)) {
-            /* write request is in progress, it can not be cancelled gracefully,
-             * so we must cancel it by socket_close(), it's unrecoverable.
-             * TODO: should we wait for close done here?
-             * Release buffers before write operation is totally over is dangerous on Windows */
-            cat_socket_internal_unrecoverable_io_error(socket_i);
+        if (unlikely(!cat_buffer_prepare(buffer, length))) {
+            return CAT_ENOMEM;
         }
-        if (unlikely(!ret)) {
-            cat_update_last_error_with_previous("Socket write wait failed");
-            goto _out;
+        for (n = 0; n < vector_count; n++) {
+            (void) cat_buffer_append(buffer, vector[n].base, vector[n].length);
         }
+        return length;
     }
-    ret = error == 0;
-    if (unlikely(!ret)) {
-        if (error == CAT_ECANCELED) {
-            cat_update_last_error(CAT_ECANCELED, "Socket write has been canceled");
-        } else {
-            cat_update_last_error_with_reason((cat_errno_t) error, "Socket write failed");
-        }
+#ifdef CAT_SSL
+    if (cat_socket_internal_should_encrypt(socket_i)) {
+        return cat_socket_internal_try_write_encrypted(socket_i, vector, vector_count, address, address_length);
     }
+#endif
+    return cat_socket_internal_try_write_raw(socket_i, vector, vector_count, address, address_length);
+}
+
+#define CAT_SOCKET_INTERNAL_IO_ESTABLISHED_CHECK_FOR_STREAM_SILENT(_socket_i, _failure) do { \
+    if (!(_socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM)) { \
+        CAT_SOCKET_INTERNAL_ESTABLISHED_ONLY_SILENT(_socket_i, _failure); \
+    } \
+} while (0)
+
+#define CAT_SOCKET_INTERNAL_IO_ESTABLISHED_CHECK_FOR_STREAM(_socket_i, _failure) do { \
+    if (!(_socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM)) { \
+        CAT_SOCKET_INTERNAL_ESTABLISHED_ONLY(_socket_i, _failure); \
+    } \
+} while (0)
+
+#define CAT_SOCKET_IO_CHECK_RAW(_socket, _socket_i, _io_flag, _failure) \
+    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(_socket, _socket_i, _io_flag, _failure); \
+    CAT_SOCKET_INTERNAL_IO_ESTABLISHED_CHECK_FOR_STREAM(_socket_i, _failure) \
+
+#define CAT_SOCKET_IO_CHECK(_socket, _socket_i, _io_flag, _failure) \
+        CAT_SOCKET_IO_CHECK_RAW(_socket, _socket_i, _io_flag, _failure); \
+        do { \
+            if (unlikely((_socket_i->type & CAT_SOCKET_TYPE_IPCC) == CAT_SOCKET_TYPE_IPCC)) { \
+                cat_update_last_error(CAT_EMISUSE, "Socket IPC channel can not transfer user data"); \
+                _failure; \
+            } \
+        } while (0)
+
+#define CAT_SOCKET_TRY_IO_CHECK(_socket, _socket_i, _io_flag, _failure) \
+        CAT_SOCKET_INTERNAL_GETTER_WITH_IO_SILENT(_socket, _socket_i, _io_flag, _failure); \
+        CAT_SOCKET_INTERNAL_IO_ESTABLISHED_CHECK_FOR_STREAM_SILENT(_socket_i, _failure) \
+
+static cat_always_inline ssize_t cat_socket_read_impl(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_timeout_t timeout, cat_bool_t once)
+{
+    CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return -1);
+    return cat_socket_internal_read(socket_i, buffer, size, address, address_length, timeout, once);
+}
+
+static cat_always_inline ssize_t cat_socket_try_recv_impl(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length)
+{
+    CAT_SOCKET_TRY_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return error);
+    return cat_socket_internal_try_recv(socket_i, buffer, size, address, address_length);
+}
+
+static cat_always_inline cat_bool_t cat_socket_write_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout)
+{
+    CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_NONE, return cat_false);
+    return cat_socket_internal_write(socket_i, vector, vector_count, address, address_length, timeout);
+}
+
+static cat_always_inline ssize_t cat_socket_try_write_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length)
+{
+    CAT_SOCKET_TRY_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_WRITE, return error == CAT_ELOCKED ? CAT_EAGAIN : error);
+    return cat_socket_internal_try_write(socket_i, vector, vector_count, address, address_length);
+}
+
+#define CAT_SOCKET_READ_ADDRESS_CONTEXT(_address, _name, _name_length, _port) \
+    cat_sockaddr_info_t _address##_info; \
+    cat_sockaddr_t *_address; \
+    cat_socklen_t *_address##_length; do { \
+    \
+    if (unlikely((_name == NULL || _name_length == NULL || *_name_length == 0) && _port == NULL)) { \
+        _address = NULL; \
+        _address##_length = NULL; \
+        _address##_info.length = 0; \
+    } else { \
+        _address = &_address##_info.address.common; \
+        _address##_length = &_address##_info.length; \
+        _address##_info.length = sizeof(_address##_info.address); \
+    } \
+} while (0)
+
+#define CAT_SOCKET_READ_ADDRESS_TO_NAME(_address, _name, _name_length, _port) do { \
+    if (unlikely(_address##_info.length > sizeof(_address##_info.address))) { \
+        _address##_info.length = 0; /* address is imcomplete, just discard it */ \
+    } \
+    /* always call this (it can handle empty case internally) */ \
+    (void) cat_sockaddr_to_name_silent(_address, _address##_info.length, _name, _name_length, _port); \
+} while (0)
+
+static ssize_t cat_socket_recv_from_impl(cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port, cat_timeout_t timeout)
+{
+    CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return -1);
+    CAT_SOCKET_READ_ADDRESS_CONTEXT(address, name, name_length, port);
+    ssize_t ret;
+
+    ret = cat_socket_internal_read(socket_i, buffer, size, address, address_length, timeout, cat_true);
+
+    CAT_SOCKET_READ_ADDRESS_TO_NAME(address, name, name_length, port);
 
-    _out:
     return ret;
 }
 
-#ifdef CAT_OS_UNIX_LIKE
-static cat_never_inline ssize_t cat_socket_internal_udg_try_write(
-    cat_socket_internal_t *socket_i,
-    const cat_socket_write_vector_t *vector, unsigned int vector_count,
-    const cat_sockaddr_t *address, cat_socklen_t address_length
-)
+static ssize_t cat_socket_try_recv_from_impl(cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port)
 {
-    cat_socket_fd_t fd;
-    struct msghdr msg;
-    ssize_t nwrite;
+    CAT_SOCKET_TRY_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return error);
+    CAT_SOCKET_READ_ADDRESS_CONTEXT(address, name, name_length, port);
+    ssize_t ret;
 
-    if (!!(socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE)) {
-        return CAT_EAGAIN;
-    }
+    ret = cat_socket_internal_try_recv(socket_i, buffer, size, address, address_length);
 
-    fd = cat_socket_internal_get_fd_fast(socket_i);
-    msg.msg_name = (struct sockaddr *) address;
-    msg.msg_namelen = address_length;
-    msg.msg_iov = (struct iovec *) vector;
-    msg.msg_iovlen = vector_count;
-    msg.msg_control = NULL;
-    msg.msg_controllen = 0;
-    msg.msg_flags = 0;
-    do {
-        nwrite = sendmsg(fd, &msg, 0);
-    } while (nwrite < 0 && CAT_SOCKET_RETRY_ON_WRITE_ERROR(cat_sys_errno));
+    CAT_SOCKET_READ_ADDRESS_TO_NAME(address, name, name_length, port);
 
-    if (unlikely(nwrite < 0)) {
-        return cat_translate_sys_error(cat_sys_errno);
+    return ret;
+}
+
+#define CAT_SOCKET_INTERNAL_SOLVE_WRITE_TO_ADDRESS(socket_i, name, name_length, port, address, address_length, _failure) \
+    cat_sockaddr_info_t address_info; \
+    cat_sockaddr_t *address; \
+    cat_socklen_t address_length; \
+    do { \
+        cat_ret_t ret = cat_socket_internal_solve_write_to_address(socket_i, name, name_length, port, &address_info); \
+        if (ret == CAT_RET_ERROR) { \
+            _failure; \
+        } else if (ret == CAT_RET_NONE) { \
+            address = NULL; \
+            address_length = 0; \
+        } else { \
+            address = &address_info.address.common; \
+            address_length = address_info.length; \
+        } \
+    } while (0)
+
+static cat_always_inline cat_ret_t cat_socket_internal_solve_write_to_address(
+    cat_socket_internal_t *socket_i,
+    const char *name, size_t name_length, int port,
+    cat_sockaddr_info_t *address_info
+) {
+    /* resolve address (DNS query may be triggered) */
+    if (name_length != 0) {
+        cat_bool_t ret;
+        socket_i->io_flags |= CAT_SOCKET_IO_FLAG_WRITE;
+        cat_queue_push_back(&socket_i->context.io.write.coroutines, &CAT_COROUTINE_G(current)->waiter.node);
+        ret  = cat_socket_internal_getaddrbyname(socket_i, address_info, name, name_length, port, NULL);
+        cat_queue_remove(&CAT_COROUTINE_G(current)->waiter.node);
+        if (cat_queue_empty(&socket_i->context.io.write.coroutines)) {
+            socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_WRITE;
+        }
+        if (unlikely(!ret)) {
+           cat_update_last_error_with_previous("Socket write failed");
+           return CAT_RET_ERROR;
+        }
+        return CAT_RET_OK;
+    } else {
+        return CAT_RET_NONE;
     }
-    return nwrite;
 }
-#endif
 
-static ssize_t cat_socket_internal_try_write_raw(
-    cat_socket_internal_t *socket_i,
-    const cat_socket_write_vector_t *vector, unsigned int vector_count,
-    const cat_sockaddr_t *address, cat_socklen_t address_length
-)
+static cat_bool_t cat_socket_write_to_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port, cat_timeout_t timeout)
 {
-    CAT_SOCKET_CHECK_INPUT_ADDRESS_SILENT(address, address_length, return cat_false);
-    cat_bool_t is_dgram = (socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM);
+    CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_NONE, return cat_false);
+    CAT_SOCKET_INTERNAL_SOLVE_WRITE_TO_ADDRESS(socket_i, name, name_length, port, address, address_length, return cat_false);
 
-#ifdef CAT_OS_UNIX_LIKE
-    cat_bool_t is_udp = ((socket_i->type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP);
-    /* libuv does not support dynamic address length */
-    CAT_ASSERT(
-        (!is_udp || address == NULL || address->sa_family != AF_UNIX || address_length >= sizeof(struct sockaddr_un)) &&
-        "Socket does not support variable size UNIX address on UDP"
-    );
-    if (is_dgram && !is_udp) {
-        return cat_socket_internal_udg_try_write(socket_i, vector, vector_count, address, address_length);
-    }
-#endif
-    if (!is_dgram) {
-        return uv_try_write(
-            &socket_i->u.stream,
-            (const uv_buf_t *) vector, vector_count
-        );
-    } else {
-        return uv_udp_try_send(
-            &socket_i->u.udp,
-            (const uv_buf_t *) vector, vector_count,
-            address
-        );
-    }
+    return cat_socket_internal_write(socket_i, vector, vector_count, address, address_length, timeout);
 }
 
-#ifdef CAT_SSL
-static cat_bool_t cat_socket_internal_write_encrypted(
-    cat_socket_internal_t *socket_i,
-    const cat_socket_write_vector_t *vector, unsigned int vector_count,
-    const cat_sockaddr_t *address, cat_socklen_t address_length,
-    cat_timeout_t timeout
-)
+static ssize_t cat_socket_try_write_to_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port)
 {
-    cat_ssl_t *ssl = socket_i->ssl; CAT_ASSERT(ssl != NULL);
-    cat_io_vector_t ssl_vector[8];
-    unsigned int ssl_vector_count = CAT_ARRAY_SIZE(ssl_vector);
-    cat_bool_t ret;
+    CAT_SOCKET_TRY_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_WRITE, return error == CAT_ELOCKED ? CAT_EAGAIN : error);
+    CAT_SOCKET_INTERNAL_SOLVE_WRITE_TO_ADDRESS(socket_i, name, name_length, port, address, address_length, return cat_false);
 
-    /* Notice: we must encrypt all buffers at once,
-     * otherwise we will not be able to support queued writes */
-    ret = cat_ssl_encrypt(
-        socket_i->ssl,
-        (const cat_io_vector_t *) vector, vector_count,
-        ssl_vector, &ssl_vector_count
-    );
+    return cat_socket_internal_try_write(socket_i, vector, vector_count, address, address_length);
+}
 
-    if (unlikely(!ret)) {
-        cat_update_last_error_with_previous("Socket SSL write failed");
-        cat_socket_internal_ssl_recoverability_check(socket_i);
-        return cat_false;
-    }
+CAT_API ssize_t cat_socket_read(cat_socket_t *socket, char *buffer, size_t length)
+{
+    return cat_socket_read_ex(socket, buffer, length, cat_socket_get_read_timeout_fast(socket));
+}
 
-    ret = cat_socket_internal_write_raw(
-        socket_i, (cat_socket_write_vector_t *) ssl_vector, ssl_vector_count,
-        address, address_length, NULL, timeout
-    );
+CAT_API ssize_t cat_socket_read_ex(cat_socket_t *socket, char *buffer, size_t length, cat_timeout_t timeout)
+{
+    CAT_LOG_DEBUG(SOCKET, "read(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+        socket->id, CAT_LOG_READ_BUFFER_C(buffer), length, timeout);
 
-    cat_ssl_encrypted_vector_free(ssl, ssl_vector, ssl_vector_count);
+    ssize_t n = cat_socket_read_impl(socket, buffer, length, 0, NULL, timeout, cat_false);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *s;
+        CAT_LOG_DEBUG_D(SOCKET, "read(" CAT_SOCKET_ID_FMT ", %s, %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), length, timeout, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
+    });
+
+    return n;
+}
+
+CAT_API cat_bool_t cat_socket_write(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count)
+{
+    return cat_socket_write_ex(socket, vector, vector_count, cat_socket_get_write_timeout_fast(socket));
+}
+
+CAT_API cat_bool_t cat_socket_write_ex(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, cat_timeout_t timeout)
+{
+#ifdef CAT_ENABLE_DEBUG_LOG
+    char *vector_quoted = NULL;
+#endif
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        vector_quoted = cat_socket_write_vector_str(vector, vector_count);
+        CAT_LOG_DEBUG_D(SOCKET, "write(" CAT_SOCKET_ID_FMT ", %s, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, vector_quoted, timeout);
+    });
+
+    cat_bool_t ret = cat_socket_write_impl(socket, vector, vector_count, NULL, 0, timeout);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        CAT_LOG_DEBUG_D(SOCKET, "write(" CAT_SOCKET_ID_FMT ", %s, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
+            socket->id, vector_quoted, timeout, CAT_LOG_BOOL_RET_C(ret));
+        cat_buffer_str_free(vector_quoted);
+    });
 
     return ret;
 }
 
-static void cat_socket_internal_try_write_encrypted_callback(uv_write_t *request, int status)
+CAT_API ssize_t cat_socket_try_write(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count)
 {
-    cat_socket_internal_t *socket_i = (cat_socket_internal_t *) request->data;
-    if (status == 0) {
-        socket_i->ssl->write_buffer.length = 0;
-    }
+    ssize_t n = cat_socket_try_write_impl(socket, vector, vector_count, NULL, 0);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *vector_quoted = cat_socket_write_vector_str(vector, vector_count);
+        CAT_LOG_DEBUG_D(SOCKET, "try_write(" CAT_SOCKET_ID_FMT ", %s) = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, vector_quoted, CAT_LOG_SSIZE_RET_C(n));
+        cat_buffer_str_free(vector_quoted);
+    });
+
+    return n;
 }
 
-static ssize_t cat_socket_internal_try_write_encrypted(
-    cat_socket_internal_t *socket_i,
-    const cat_socket_write_vector_t *vector, unsigned int vector_count,
-    const cat_sockaddr_t *address, cat_socklen_t address_length
-)
+CAT_API cat_bool_t cat_socket_writeto(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length)
 {
-    cat_ssl_t *ssl = socket_i->ssl; CAT_ASSERT(ssl != NULL);
-    if (unlikely(ssl->write_buffer.length != 0)) {
-        return CAT_EAGAIN;
-    }
-    cat_io_vector_t ssl_vector[8];
-    unsigned int ssl_vector_count;
-    ssize_t nwrite, nwrite_encrypted;
-    cat_bool_t encrypted;
-    cat_errno_t error = 0;
+    return cat_socket_writeto_ex(socket, vector, vector_count, address, address_length, cat_socket_get_write_timeout_fast(socket));
+}
 
-    /* Notice: we must encrypt all buffers at once,
-     * otherwise we will not be able to support queued writes. */
-    ssl_vector_count = CAT_ARRAY_SIZE(ssl_vector);
-    CAT_PROTECT_LAST_ERROR_START() {
-        encrypted = cat_ssl_encrypt(
-            socket_i->ssl,
-            (const cat_io_vector_t *) vector, vector_count,
-            ssl_vector, &ssl_vector_count
-        );
-        if (unlikely(!encrypted)) {
-            error = cat_get_last_error_code();
+CAT_API cat_bool_t cat_socket_writeto_ex(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout)
+{
+#ifdef CAT_ENABLE_DEBUG_LOG
+    char *vector_quoted = NULL;
+    char name[CAT_SOCKADDR_MAX_PATH];
+    size_t name_length = sizeof(name);
+    int port = 0;
+#endif
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
+            break;
         }
-    } CAT_PROTECT_LAST_ERROR_END();
-    if (unlikely(!encrypted)) {
-        cat_socket_internal_ssl_recoverability_check(socket_i);
-        return error;
-    }
+        vector_quoted = cat_socket_write_vector_str(vector, vector_count);
+        CAT_LOG_DEBUG_D(SOCKET, "writeto(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, vector_quoted, (int) name_length, name, port, timeout);
+    });
 
-    nwrite_encrypted = cat_socket_internal_try_write_raw(
-        socket_i,
-        (cat_socket_write_vector_t *) ssl_vector, ssl_vector_count,
-        address, address_length
-    );
+    cat_bool_t ret = cat_socket_write_impl(socket, vector, vector_count, address, address_length, timeout);
 
-    if (nwrite_encrypted == CAT_EAGAIN) {
-        nwrite_encrypted = 0;
-    }
-    if (unlikely(nwrite_encrypted < 0)) {
-        nwrite = nwrite_encrypted;
-    } else {
-        cat_io_vector_t *ssl_vector_current = ssl_vector;
-        cat_io_vector_t *ssl_vector_eof = ssl_vector + ssl_vector_count;
-        size_t ssl_vector_base_offset = nwrite_encrypted;
-        nwrite = cat_io_vector_length((const cat_io_vector_t *) vector, vector_count);
-        while (ssl_vector_base_offset >= ssl_vector_current->length) {
-            ssl_vector_base_offset -= ssl_vector_current->length;
-            if (++ssl_vector_current == ssl_vector_eof) {
-                break;
-            }
-        }
-        /* Well, this could be confusing. if we can not send all encrypted data at once,
-         * we really can not know how many bytes of raw data has been sent,
-         * so the only thing we can do is to store the remaining data to buffer and
-         * try again in the next call. */
-#ifdef CAT_DEBUG
-        size_t encrypted_bytes = cat_io_vector_length(ssl_vector, ssl_vector_count);
-        CAT_LOG_DEBUG(SSL, "SSL %p expect send %zu encrypted bytes, actually %zu bytes was sent (raw data is %zu bytes)",
-            ssl, encrypted_bytes, (size_t) nwrite_encrypted, (size_t) nwrite);
-        CAT_ASSERT(((size_t) nwrite_encrypted == encrypted_bytes) ==
-                    (ssl_vector_current == ssl_vector_eof));
-#endif
-        if (ssl_vector_current != ssl_vector_eof) {
-            if (ssl_vector_current->base == ssl->write_buffer.value) {
-                ssl->write_buffer.length = ssl_vector_current->length - ssl_vector_base_offset;
-                memmove(ssl->write_buffer.value,
-                        ssl_vector_current->base + ssl_vector_base_offset,
-                        ssl->write_buffer.length);
-            } else {
-                cat_buffer_append(&ssl->write_buffer,
-                    ssl_vector_current->base + ssl_vector_base_offset,
-                    ssl_vector_current->length - ssl_vector_base_offset);
-            }
-            while (++ssl_vector_current < ssl_vector_eof) {
-                cat_buffer_append(&ssl->write_buffer,
-                    ssl_vector_current->base,
-                    ssl_vector_current->length);
-            }
-            /* We tell caller all data has been sent, but actually they are in buffered,
-                * it's ok, just like syscall write() did. */
-            CAT_LOG_DEBUG(SSL, "SSL %p write buffer now has %zu bytes queued data", ssl, ssl->write_buffer.length);
-            uv_write_t *request = (uv_write_t *) cat_malloc(sizeof(*request));
-#if CAT_ALLOC_HANDLE_ERRORS
-            if (unlikely(request == NULL)) {
-                nwrite = cat_translate_sys_error(cat_sys_errno);
-            } else
-#endif
-            {
-                uv_buf_t buf;
-                request->data = socket_i;
-                buf.base = ssl->write_buffer.value;
-                buf.len = (cat_io_vector_length_t) ssl->write_buffer.length;
-                int error = uv_write(request, &socket_i->u.stream, &buf, 1, cat_socket_internal_try_write_encrypted_callback);
-                if (unlikely(error != 0)) {
-                    nwrite = error;
-                }
-            }
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        CAT_LOG_DEBUG_D(SOCKET, "writeto(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
+            socket->id, vector_quoted, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
+        cat_buffer_str_free(vector_quoted);
+    });
+
+    return ret;
+}
+
+CAT_API ssize_t cat_socket_try_writeto(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length)
+{
+    ssize_t n = cat_socket_try_write_impl(socket, vector, vector_count, address, address_length);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *vector_quoted;
+        char name[CAT_SOCKADDR_MAX_PATH];
+        size_t name_length = sizeof(name);
+        int port;
+        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
+            break;
         }
-    }
+        vector_quoted = cat_socket_write_vector_str(vector, vector_count);
+        CAT_LOG_DEBUG_D(SOCKET, "try_writeto(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, vector_quoted, (int) name_length, name, port, CAT_LOG_SSIZE_RET_C(n));
+        cat_buffer_str_free(vector_quoted);
+    });
 
-    cat_ssl_encrypted_vector_free(ssl, ssl_vector, ssl_vector_count);
+    return n;
+}
 
-    return nwrite;
+CAT_API cat_bool_t cat_socket_write_to(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port)
+{
+    return cat_socket_write_to_ex(socket, vector, vector_count, name, name_length, port, cat_socket_get_write_timeout_fast(socket));
 }
-#endif
 
-static cat_always_inline cat_bool_t cat_socket_internal_write(
-    cat_socket_internal_t *socket_i,
-    const cat_socket_write_vector_t *vector, unsigned int vector_count,
-    const cat_sockaddr_t *address, cat_socklen_t address_length,
-    cat_timeout_t timeout
-)
+CAT_API cat_bool_t cat_socket_write_to_ex(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port, cat_timeout_t timeout)
 {
-#ifdef CAT_SSL
-    /** @thinking: shall we check and wait for previous hanging write coroutines here?
-     * before previous write() are done (writable/POLLOUT), may SSL can not encrypt more data? */
-    if (socket_i->ssl != NULL) {
-        return cat_socket_internal_write_encrypted(socket_i, vector, vector_count, address, address_length, timeout);
-    }
+#ifdef CAT_ENABLE_DEBUG_LOG
+    char *vector_quoted = 0;
 #endif
-    return cat_socket_internal_write_raw(socket_i, vector, vector_count, address, address_length, NULL, timeout);
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        vector_quoted = cat_socket_write_vector_str(vector, vector_count);
+        CAT_LOG_DEBUG_D(SOCKET, "write_to(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, vector_quoted, (int) name_length, name, port, timeout);
+    });
+
+    cat_bool_t ret = cat_socket_write_to_impl(socket, vector, vector_count, name, name_length, port, timeout);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        CAT_LOG_DEBUG_D(SOCKET, "write_to(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
+            socket->id, vector_quoted, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
+        cat_buffer_str_free(vector_quoted);
+    });
+
+    return ret;
 }
 
-static cat_always_inline ssize_t cat_socket_internal_try_write(
-    cat_socket_internal_t *socket_i,
-    const cat_socket_write_vector_t *vector, unsigned int vector_count,
-    const cat_sockaddr_t *address, cat_socklen_t address_length
-)
+CAT_API ssize_t cat_socket_try_write_to(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port)
 {
-#ifdef CAT_SSL
-    if (socket_i->ssl != NULL) {
-        return cat_socket_internal_try_write_encrypted(socket_i, vector, vector_count, address, address_length);
-    }
-#endif
-    return cat_socket_internal_try_write_raw(socket_i, vector, vector_count, address, address_length);
+    ssize_t n = cat_socket_try_write_to_impl(socket, vector, vector_count, name, name_length, port);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *vector_quoted = cat_socket_write_vector_str(vector, vector_count);
+        CAT_LOG_DEBUG_D(SOCKET, "try_write_to(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, vector_quoted, (int) name_length, name, port, CAT_LOG_SSIZE_RET_C(n));
+        cat_buffer_str_free(vector_quoted);
+    });
+
+    return n;
 }
 
-#define CAT_SOCKET_INTERNAL_IO_ESTABLISHED_CHECK_FOR_STREAM_SILENT(_socket_i, _failure) do { \
-    if (!(_socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM)) { \
-        CAT_SOCKET_INTERNAL_ESTABLISHED_ONLY_SILENT(_socket_i, _failure); \
-    } \
-} while (0)
+CAT_API ssize_t cat_socket_recv(cat_socket_t *socket, char *buffer, size_t size)
+{
+    return cat_socket_recv_ex(socket, buffer, size, cat_socket_get_read_timeout_fast(socket));
+}
 
-#define CAT_SOCKET_INTERNAL_IO_ESTABLISHED_CHECK_FOR_STREAM(_socket_i, _failure) do { \
-    if (!(_socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM)) { \
-        CAT_SOCKET_INTERNAL_ESTABLISHED_ONLY(_socket_i, _failure); \
-    } \
-} while (0)
+CAT_API ssize_t cat_socket_recv_ex(cat_socket_t *socket, char *buffer, size_t size, cat_timeout_t timeout)
+{
+    CAT_LOG_DEBUG(SOCKET, "recv(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+        socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, timeout);
 
-#define CAT_SOCKET_IO_CHECK_RAW(_socket, _socket_i, _io_flag, _failure) \
-    CAT_SOCKET_INTERNAL_GETTER_WITH_IO(_socket, _socket_i, _io_flag, _failure); \
-    CAT_SOCKET_INTERNAL_IO_ESTABLISHED_CHECK_FOR_STREAM(_socket_i, _failure) \
+    ssize_t n = cat_socket_read_impl(socket, buffer, size, 0, NULL, timeout, cat_true);
 
-#define CAT_SOCKET_IO_CHECK(_socket, _socket_i, _io_flag, _failure) \
-        CAT_SOCKET_IO_CHECK_RAW(_socket, _socket_i, _io_flag, _failure); \
-        do { \
-            if (unlikely((_socket_i->type & CAT_SOCKET_TYPE_IPCC) == CAT_SOCKET_TYPE_IPCC)) { \
-                cat_update_last_error(CAT_EMISUSE, "Socket IPC channel can not transfer user data"); \
-                _failure; \
-            } \
-        } while (0)
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *s;
+        CAT_LOG_DEBUG_D(SOCKET, "recv(" CAT_SOCKET_ID_FMT ", %s, %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, timeout, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
+    });
 
-#define CAT_SOCKET_TRY_IO_CHECK(_socket, _socket_i, _io_flag, _failure) \
-        CAT_SOCKET_INTERNAL_GETTER_WITH_IO_SILENT(_socket, _socket_i, _io_flag, _failure); \
-        CAT_SOCKET_INTERNAL_IO_ESTABLISHED_CHECK_FOR_STREAM_SILENT(_socket_i, _failure) \
+    return n;
+}
 
-static cat_always_inline ssize_t cat_socket_read_impl(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_timeout_t timeout, cat_bool_t once)
+CAT_API ssize_t cat_socket_try_recv(cat_socket_t *socket, char *buffer, size_t size)
 {
-    CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return -1);
-    return cat_socket_internal_read(socket_i, buffer, size, address, address_length, timeout, once);
+    ssize_t n = cat_socket_try_recv_impl(socket, buffer, size, NULL, NULL);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *s;
+        CAT_LOG_DEBUG_D(SOCKET, "try_recv(" CAT_SOCKET_ID_FMT ", %s, %zu) = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
+    });
+
+    return n;
 }
 
-static cat_always_inline ssize_t cat_socket_try_recv_impl(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length)
+CAT_API ssize_t cat_socket_recvfrom(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length)
 {
-    CAT_SOCKET_TRY_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return error);
-    return cat_socket_internal_try_recv(socket_i, buffer, size, address, address_length);
+    return cat_socket_recvfrom_ex(socket, buffer, size, address, address_length, cat_socket_get_read_timeout_fast(socket));
 }
 
-static cat_always_inline cat_bool_t cat_socket_write_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout)
+CAT_API ssize_t cat_socket_recvfrom_ex(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_timeout_t timeout)
 {
-    CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_NONE, return cat_false);
-    return cat_socket_internal_write(socket_i, vector, vector_count, address, address_length, timeout);
+    CAT_LOG_DEBUG(SOCKET, "recvfrom(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_LOG_READ_BUFFER_FMT ", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+        socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, CAT_LOG_READ_BUFFER_C(address), address_length != NULL ? *address_length: 0, timeout);
+
+    ssize_t n = cat_socket_read_impl(socket, buffer, size, address, address_length, timeout, cat_true);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *s;
+        char name[CAT_SOCKADDR_MAX_PATH];
+        size_t name_length = sizeof(name);
+        int port;
+        if (cat_sockaddr_to_name_silent(address, address_length != NULL ? *address_length : 0, name, &name_length, &port) != 0) {
+            break;
+        }
+        CAT_LOG_DEBUG_D(SOCKET, "recvfrom(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) name_length, name, port, timeout, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
+    });
+
+    return n;
 }
 
-static cat_always_inline ssize_t cat_socket_try_write_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length)
+CAT_API ssize_t cat_socket_try_recvfrom(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length)
 {
-    CAT_SOCKET_TRY_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_WRITE, return error == CAT_ELOCKED ? CAT_EAGAIN : error);
-    return cat_socket_internal_try_write(socket_i, vector, vector_count, address, address_length);
+    ssize_t n = cat_socket_try_recv_impl(socket, buffer, size, address, address_length);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *s;
+        char name[CAT_SOCKADDR_MAX_PATH];
+        size_t name_length = sizeof(name);
+        int port;
+        if (cat_sockaddr_to_name_silent(address, address_length != NULL ? *address_length : 0, name, &name_length, &port) != 0) {
+            break;
+        }
+        CAT_LOG_DEBUG_D(SOCKET, "try_recvfrom(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) name_length, name, port, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
+    });
+
+    return n;
 }
 
-#define CAT_SOCKET_READ_ADDRESS_CONTEXT(_address, _name, _name_length, _port) \
-    cat_sockaddr_info_t _address##_info; \
-    cat_sockaddr_t *_address; \
-    cat_socklen_t *_address##_length; do { \
-    \
-    if (unlikely((_name == NULL || _name_length == NULL || *_name_length == 0) && _port == NULL)) { \
-        _address = NULL; \
-        _address##_length = NULL; \
-        _address##_info.length = 0; \
-    } else { \
-        _address = &_address##_info.address.common; \
-        _address##_length = &_address##_info.length; \
-        _address##_info.length = sizeof(_address##_info.address); \
-    } \
-} while (0)
+CAT_API ssize_t cat_socket_recv_from(cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port)
+{
+    return cat_socket_recv_from_ex(socket, buffer, size, name, name_length, port, cat_socket_get_read_timeout_fast(socket));
+}
 
-#define CAT_SOCKET_READ_ADDRESS_TO_NAME(_address, _name, _name_length, _port) do { \
-    if (unlikely(_address##_info.length > sizeof(_address##_info.address))) { \
-        _address##_info.length = 0; /* address is imcomplete, just discard it */ \
-    } \
-    /* always call this (it can handle empty case internally) */ \
-    (void) cat_sockaddr_to_name_silent(_address, _address##_info.length, _name, _name_length, _port); \
-} while (0)
+CAT_API ssize_t cat_socket_recv_from_ex(cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port, cat_timeout_t timeout)
+{
+    CAT_LOG_DEBUG(SOCKET, "recv_from(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+        socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, CAT_LOG_READ_BUFFER_C(name), name_length != NULL ? *name_length: 0, timeout);
 
-static ssize_t cat_socket_recv_from_impl(cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port, cat_timeout_t timeout)
+    ssize_t n = cat_socket_recv_from_impl(socket, buffer, size, name, name_length, port, timeout);
+
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *s;
+        CAT_LOG_DEBUG_D(SOCKET, "recv_from(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) (name_length != NULL ? *name_length : 0), name, port != NULL ? *port : 0, timeout, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
+    });
+
+    return n;
+}
+
+CAT_API ssize_t cat_socket_try_recv_from(cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port)
 {
-    CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return -1);
-    CAT_SOCKET_READ_ADDRESS_CONTEXT(address, name, name_length, port);
-    ssize_t ret;
+    ssize_t n = cat_socket_try_recv_from_impl(socket, buffer, size, name, name_length, port);
 
-    ret = cat_socket_internal_read(socket_i, buffer, size, address, address_length, timeout, cat_true);
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *s;
+        CAT_LOG_DEBUG_D(SOCKET, "try_recvfrom(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) (name_length != NULL ? *name_length : 0), name, port != NULL ? *port : 0, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
+    });
+
+    return n;
+}
+
+CAT_API cat_bool_t cat_socket_send(cat_socket_t *socket, const char *buffer, size_t length)
+{
+    return cat_socket_send_ex(socket, buffer, length, cat_socket_get_write_timeout_fast(socket));
+}
+
+CAT_API cat_bool_t cat_socket_send_ex(cat_socket_t *socket, const char *buffer, size_t length, cat_timeout_t timeout)
+{
+    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
+
+#ifdef CAT_ENABLE_DEBUG_LOG
+    char *buffer_quoted = NULL;
+#endif
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        CAT_LOG_DEBUG_D(SOCKET, "send(" CAT_SOCKET_ID_FMT ", %s, %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, cat_log_str_quote(buffer, length, &buffer_quoted), length, timeout);
+    });
+
+    cat_bool_t ret = cat_socket_write_impl(socket, &vector, 1, NULL, 0, timeout);
 
-    CAT_SOCKET_READ_ADDRESS_TO_NAME(address, name, name_length, port);
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        CAT_LOG_DEBUG_D(SOCKET, "send(" CAT_SOCKET_ID_FMT ", %s, %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
+            socket->id, buffer_quoted, length, timeout, CAT_LOG_BOOL_RET_C(ret));
+        cat_free(buffer_quoted);
+    });
 
     return ret;
 }
 
-static ssize_t cat_socket_try_recv_from_impl(cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port)
+CAT_API ssize_t cat_socket_try_send(cat_socket_t *socket, const char *buffer, size_t length)
 {
-    CAT_SOCKET_TRY_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return error);
-    CAT_SOCKET_READ_ADDRESS_CONTEXT(address, name, name_length, port);
-    ssize_t ret;
+    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
 
-    ret = cat_socket_internal_try_recv(socket_i, buffer, size, address, address_length);
+    ssize_t n = cat_socket_try_write_impl(socket, &vector, 1, NULL, 0);
 
-    CAT_SOCKET_READ_ADDRESS_TO_NAME(address, name, name_length, port);
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *s;
+        CAT_LOG_DEBUG_D(SOCKET, "try_send(" CAT_SOCKET_ID_FMT ", %s) = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, length, &s), CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
+    });
 
-    return ret;
+    return n;
 }
 
-#define CAT_SOCKET_INTERNAL_SOLVE_WRITE_TO_ADDRESS(socket_i, name, name_length, port, address, address_length, _failure) \
-    cat_sockaddr_info_t address_info; \
-    cat_sockaddr_t *address; \
-    cat_socklen_t address_length; \
-    do { \
-        cat_ret_t ret = cat_socket_internal_solve_write_to_address(socket_i, name, name_length, port, &address_info); \
-        if (ret == CAT_RET_ERROR) { \
-            _failure; \
-        } else if (ret == CAT_RET_NONE) { \
-            address = NULL; \
-            address_length = 0; \
-        } else { \
-            address = &address_info.address.common; \
-            address_length = address_info.length; \
-        } \
-    } while (0)
-
-static cat_always_inline cat_ret_t cat_socket_internal_solve_write_to_address(
-    cat_socket_internal_t *socket_i,
-    const char *name, size_t name_length, int port,
-    cat_sockaddr_info_t *address_info
-) {
-    /* resolve address (DNS query may be triggered) */
-    if (name_length != 0) {
-        cat_bool_t ret;
-        socket_i->io_flags |= CAT_SOCKET_IO_FLAG_WRITE;
-        cat_queue_push_back(&socket_i->context.io.write.coroutines, &CAT_COROUTINE_G(current)->waiter.node);
-        ret  = cat_socket_internal_getaddrbyname(socket_i, address_info, name, name_length, port, NULL);
-        cat_queue_remove(&CAT_COROUTINE_G(current)->waiter.node);
-        if (cat_queue_empty(&socket_i->context.io.write.coroutines)) {
-            socket_i->io_flags ^= CAT_SOCKET_IO_FLAG_WRITE;
-        }
-        if (unlikely(!ret)) {
-           cat_update_last_error_with_previous("Socket write failed");
-           return CAT_RET_ERROR;
-        }
-        return CAT_RET_OK;
-    } else {
-        return CAT_RET_NONE;
-    }
+CAT_API cat_bool_t cat_socket_sendto(cat_socket_t *socket, const char *buffer, size_t length, const cat_sockaddr_t *address, cat_socklen_t address_length)
+{
+    return cat_socket_sendto_ex(socket, buffer, length, address, address_length, cat_socket_get_write_timeout_fast(socket));
 }
 
-static cat_bool_t cat_socket_write_to_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port, cat_timeout_t timeout)
+CAT_API cat_bool_t cat_socket_sendto_ex(cat_socket_t *socket, const char *buffer, size_t length, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout)
 {
-    CAT_SOCKET_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_NONE, return cat_false);
-    CAT_SOCKET_INTERNAL_SOLVE_WRITE_TO_ADDRESS(socket_i, name, name_length, port, address, address_length, return cat_false);
+    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
 
-    return cat_socket_internal_write(socket_i, vector, vector_count, address, address_length, timeout);
-}
+#ifdef CAT_ENABLE_DEBUG_LOG
+    char *buffer_quoted = NULL;
+    char name[CAT_SOCKADDR_MAX_PATH];
+    size_t name_length = sizeof(name);
+    int port = 0;
+#endif
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
+            break;
+        }
+        CAT_LOG_DEBUG_D(SOCKET, "sendto(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, cat_log_str_quote(buffer, length, &buffer_quoted), length, (int) name_length, name, port, timeout);
+    });
 
-static ssize_t cat_socket_try_write_to_impl(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port)
-{
-    CAT_SOCKET_TRY_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_WRITE, return error == CAT_ELOCKED ? CAT_EAGAIN : error);
-    CAT_SOCKET_INTERNAL_SOLVE_WRITE_TO_ADDRESS(socket_i, name, name_length, port, address, address_length, return cat_false);
+    cat_bool_t ret = cat_socket_write_impl(socket, &vector, 1, address, address_length, timeout);
 
-    return cat_socket_internal_try_write(socket_i, vector, vector_count, address, address_length);
-}
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        CAT_LOG_DEBUG_D(SOCKET, "sendto(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
+            socket->id, buffer_quoted, length, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
+        cat_free(buffer_quoted);
+    });
 
-CAT_API ssize_t cat_socket_read(cat_socket_t *socket, char *buffer, size_t length)
-{
-    return cat_socket_read_ex(socket, buffer, length, cat_socket_get_read_timeout_fast(socket));
+    return ret;
 }
 
-CAT_API ssize_t cat_socket_read_ex(cat_socket_t *socket, char *buffer, size_t length, cat_timeout_t timeout)
+CAT_API ssize_t cat_socket_try_sendto(cat_socket_t *socket, const char *buffer, size_t length, const cat_sockaddr_t *address, cat_socklen_t address_length)
 {
-    CAT_LOG_DEBUG(SOCKET, "read(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-        socket->id, CAT_LOG_READ_BUFFER_C(buffer), length, timeout);
+    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
 
-    ssize_t n = cat_socket_read_impl(socket, buffer, length, 0, NULL, timeout, cat_false);
+    ssize_t n = cat_socket_try_write_impl(socket, &vector, 1, address, address_length);
 
     CAT_LOG_DEBUG_VA(SOCKET, {
-        char *s;
-        CAT_LOG_DEBUG_D(SOCKET, "read(" CAT_SOCKET_ID_FMT ", %s, %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), length, timeout, CAT_LOG_SSIZE_RET_C(n));
-        cat_free(s);
+        char *buffer_quoted;
+        char name[CAT_SOCKADDR_MAX_PATH];
+        size_t name_length = sizeof(name);
+        int port;
+        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
+            break;
+        }
+        CAT_LOG_DEBUG_D(SOCKET, "try_sendto(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, length, &buffer_quoted), length, (int) name_length, name, port, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(buffer_quoted);
     });
 
     return n;
 }
 
-CAT_API cat_bool_t cat_socket_write(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count)
+CAT_API cat_bool_t cat_socket_send_to(cat_socket_t *socket, const char *buffer, size_t length, const char *name, size_t name_length, int port)
 {
-    return cat_socket_write_ex(socket, vector, vector_count, cat_socket_get_write_timeout_fast(socket));
+    return cat_socket_send_to_ex(socket, buffer, length, name, name_length, port, cat_socket_get_write_timeout_fast(socket));
 }
 
-CAT_API cat_bool_t cat_socket_write_ex(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, cat_timeout_t timeout)
+CAT_API cat_bool_t cat_socket_send_to_ex(cat_socket_t *socket, const char *buffer, size_t length, const char *name, size_t name_length, int port, cat_timeout_t timeout)
 {
+    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
+
 #ifdef CAT_ENABLE_DEBUG_LOG
-    char *vector_quoted = NULL;
+    char *buffer_quoted = NULL;
 #endif
     CAT_LOG_DEBUG_VA(SOCKET, {
-        vector_quoted = cat_socket_write_vector_str(vector, vector_count);
-        CAT_LOG_DEBUG_D(SOCKET, "write(" CAT_SOCKET_ID_FMT ", %s, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, vector_quoted, timeout);
+        CAT_LOG_DEBUG_D(SOCKET, "send_to(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, cat_log_str_quote(buffer, length, &buffer_quoted), length, (int) name_length, name, port, timeout);
     });
 
-    cat_bool_t ret = cat_socket_write_impl(socket, vector, vector_count, NULL, 0, timeout);
+    cat_bool_t ret = cat_socket_write_to_impl(socket, &vector, 1, name, name_length, port, timeout);
 
     CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "write(" CAT_SOCKET_ID_FMT ", %s, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
-            socket->id, vector_quoted, timeout, CAT_LOG_BOOL_RET_C(ret));
-        cat_buffer_str_free(vector_quoted);
+        CAT_LOG_DEBUG_D(SOCKET, "send_to(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
+            socket->id, buffer_quoted, length, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
+        cat_free(buffer_quoted);
     });
 
     return ret;
 }
 
-CAT_API ssize_t cat_socket_try_write(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count)
+CAT_API ssize_t cat_socket_try_send_to(cat_socket_t *socket, const char *buffer, size_t length, const char *name, size_t name_length, int port)
 {
-    ssize_t n = cat_socket_try_write_impl(socket, vector, vector_count, NULL, 0);
+    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
+
+    ssize_t n = cat_socket_try_write_to_impl(socket, &vector, 1, name, name_length, port);
 
     CAT_LOG_DEBUG_VA(SOCKET, {
-        char *vector_quoted = cat_socket_write_vector_str(vector, vector_count);
-        CAT_LOG_DEBUG_D(SOCKET, "try_write(" CAT_SOCKET_ID_FMT ", %s) = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, vector_quoted, CAT_LOG_SSIZE_RET_C(n));
-        cat_buffer_str_free(vector_quoted);
+        char *buffer_quoted;
+        CAT_LOG_DEBUG_D(SOCKET, "try_send_to(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, length, &buffer_quoted), length, (int) name_length, name, port, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(buffer_quoted);
     });
 
     return n;
 }
 
-CAT_API cat_bool_t cat_socket_writeto(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length)
+#ifdef CAT_SSL
+/* plaintext may have been buffered by SSL (or encrypted data may be in our read buffer),
+ * while the raw socket has nothing to read, so we decrypt records into the reader buffer,
+ * then the following reads will consume them first */
+static ssize_t cat_socket_internal_ssl_peek(cat_socket_internal_t *socket_i, char *buffer, size_t size, cat_timeout_t timeout)
+{
+    cat_socket_reader_t *reader = &socket_i->reader;
+    ssize_t n;
+
+    CAT_ASSERT(cat_socket_internal_get_read_buffered_length(socket_i) == 0);
+    reader->offset = 0;
+    reader->buffer.length = 0;
+    if (reader->buffer.value == NULL) {
+        if (unlikely(!cat_buffer_create(&reader->buffer, CAT_SOCKET_READER_BUFFER_DEFAULT_SIZE))) {
+            cat_update_last_error_with_previous("Socket reader buffer create failed");
+            return -1;
+        }
+    }
+    n = cat_socket_internal_read_decrypted(socket_i, reader->buffer.value, reader->buffer.size, NULL, NULL, timeout, cat_true);
+    if (n <= 0) {
+        if (n < 0 && cat_get_last_error_code() == CAT_ETIMEDOUT) {
+            /* not real error, same as raw peek */
+            return 0;
+        }
+        return n;
+    }
+    reader->buffer.length = (size_t) n;
+
+    return (ssize_t) cat_socket_internal_reader_read(socket_i, buffer, size, cat_true);
+}
+#endif
+
+static ssize_t cat_socket_internal_peekfrom(
+    const cat_socket_internal_t *socket_i,
+    char *buffer, size_t size,
+    cat_sockaddr_t *address, cat_socklen_t *address_length,
+    cat_timeout_t timeout
+)
 {
-    return cat_socket_writeto_ex(socket, vector, vector_count, address, address_length, cat_socket_get_write_timeout_fast(socket));
+    CAT_SOCKET_INTERNAL_FD_GETTER(socket_i, fd, return cat_false);
+    ssize_t nread;
+
+    if (!(socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM)) {
+        if (address_length != NULL) {
+            *address_length = 0;
+        }
+        if (unlikely(cat_socket_internal_get_read_buffered_length(socket_i) != 0)) {
+            return (ssize_t) cat_socket_internal_reader_read((cat_socket_internal_t *) socket_i, buffer, size, cat_true);
+        }
+#ifdef CAT_SSL
+        /* raw data is encrypted, and it may not be all data we have (unless someone is reading now) */
+        if (socket_i->ssl != NULL && !(socket_i->io_flags & CAT_SOCKET_IO_FLAG_READ)) {
+            return cat_socket_internal_ssl_peek((cat_socket_internal_t *) socket_i, buffer, size, timeout);
+        }
+#endif
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+        /* data may have been read ahead by io_uring */
+        if (socket_i->io_uring != NULL && !(socket_i->io_flags & CAT_SOCKET_IO_FLAG_READ)) {
+            nread = cat_socket_internal_io_uring_peek((cat_socket_internal_t *) socket_i, socket_i->io_uring, buffer, size, timeout);
+            if (nread != CAT_ENOTSUP) {
+                return nread;
+            }
+        }
+#endif
+    }
+    while (1) {
+#ifdef CAT_OS_UNIX_LIKE
+        do {
+#endif
+            nread = recvfrom(
+                fd,
+                buffer, (cat_socket_recv_length_t) size,
+                MSG_PEEK,
+                address, address_length
+            );
+#ifdef CAT_OS_UNIX_LIKE
+        } while (unlikely(nread < 0 && errno == EINTR));
+#endif
+        if (nread < 0) {
+            cat_errno_t error = cat_translate_sys_error(cat_sys_errno);
+            if (unlikely(error != CAT_EAGAIN && error != CAT_EMSGSIZE)) {
+                /* there was an unrecoverable error */
+                cat_update_last_error_of_syscall("Socket peek failed");
+            } else {
+                /* not real error */
+                nread = 0;
+                if (timeout != 0) {
+                    /* wait for readable when timeout is not 0 */
+                    cat_ret_t ret = cat_poll_one(fd, POLLIN, NULL, timeout);
+                    if (ret == CAT_RET_OK) {
+                        continue;
+                    } else if (ret == CAT_RET_NONE) {
+                        cat_update_last_error(CAT_ETIMEDOUT, "Socket peek wait readable timedout");
+                    } else {
+                        cat_update_last_error_with_previous("Socket peek wait readable failed");
+                    }
+                }
+            }
+            if (address_length != NULL) {
+                *address_length = 0;
+            }
+        }
+        break;
+    }
+
+    return nread;
+}
+
+static ssize_t cat_socket_peekfrom_impl(const cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_timeout_t timeout)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+
+    return cat_socket_internal_peekfrom(socket_i, buffer, size, address, address_length, timeout);
+}
+
+static ssize_t cat_socket_peek_from_impl(const cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port, cat_timeout_t timeout)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    CAT_SOCKET_READ_ADDRESS_CONTEXT(address, name, name_length, port);
+    ssize_t nread;
+
+    nread = cat_socket_internal_peekfrom(socket_i, buffer, size, address, address_length, timeout);
+
+    CAT_SOCKET_READ_ADDRESS_TO_NAME(address, name, name_length, port);
+
+    return nread;
+}
+
+CAT_API ssize_t cat_socket_peek(const cat_socket_t *socket, char *buffer, size_t size)
+{
+    return cat_socket_peek_ex(socket, buffer, size, 0);
 }
 
-CAT_API cat_bool_t cat_socket_writeto_ex(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout)
+CAT_API ssize_t cat_socket_peek_ex(const cat_socket_t *socket, char *buffer, size_t size, cat_timeout_t timeout)
 {
-#ifdef CAT_ENABLE_DEBUG_LOG
-    char *vector_quoted = NULL;
-    char name[CAT_SOCKADDR_MAX_PATH];
-    size_t name_length = sizeof(name);
-    int port = 0;
-#endif
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
-            break;
-        }
-        vector_quoted = cat_socket_write_vector_str(vector, vector_count);
-        CAT_LOG_DEBUG_D(SOCKET, "writeto(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, vector_quoted, (int) name_length, name, port, timeout);
+    CAT_LOG_DEBUG_VA(SOCKET, if (timeout != 0) {
+        CAT_LOG_DEBUG_D(SOCKET, "peek(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, timeout);
     });
 
-    cat_bool_t ret = cat_socket_write_impl(socket, vector, vector_count, address, address_length, timeout);
+    ssize_t n = cat_socket_peekfrom_impl(socket, buffer, size, NULL, NULL, timeout);
 
     CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "writeto(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
-            socket->id, vector_quoted, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
-        cat_buffer_str_free(vector_quoted);
+        char *s;
+        CAT_LOG_DEBUG_D(SOCKET, "peek(" CAT_SOCKET_ID_FMT ", %s, %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, timeout, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
     });
 
-    return ret;
+    return n;
 }
 
-CAT_API ssize_t cat_socket_try_writeto(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const cat_sockaddr_t *address, cat_socklen_t address_length)
+CAT_API ssize_t cat_socket_peekfrom(const cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length)
 {
-    ssize_t n = cat_socket_try_write_impl(socket, vector, vector_count, address, address_length);
+    return cat_socket_peekfrom_ex(socket, buffer, size, address, address_length, 0);
+}
+
+CAT_API ssize_t cat_socket_peekfrom_ex(const cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_timeout_t timeout)
+{
+    CAT_LOG_DEBUG_VA(SOCKET, if (timeout != 0) {
+        CAT_LOG_DEBUG_D(SOCKET, "peekfrom(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_LOG_READ_BUFFER_FMT ", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, CAT_LOG_READ_BUFFER_C(address), address_length != NULL ? *address_length: 0, timeout);
+    });
+
+    ssize_t n = cat_socket_peekfrom_impl(socket, buffer, size, address, address_length, timeout);
 
     CAT_LOG_DEBUG_VA(SOCKET, {
-        char *vector_quoted;
+        char *s;
         char name[CAT_SOCKADDR_MAX_PATH];
         size_t name_length = sizeof(name);
         int port;
-        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
+        if (cat_sockaddr_to_name_silent(address, address_length != NULL ? *address_length : 0, name, &name_length, &port) != 0) {
             break;
         }
-        vector_quoted = cat_socket_write_vector_str(vector, vector_count);
-        CAT_LOG_DEBUG_D(SOCKET, "try_writeto(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, vector_quoted, (int) name_length, name, port, CAT_LOG_SSIZE_RET_C(n));
-        cat_buffer_str_free(vector_quoted);
+        CAT_LOG_DEBUG_D(SOCKET, "peekfrom(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) name_length, name, port, timeout, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
     });
 
     return n;
 }
 
-CAT_API cat_bool_t cat_socket_write_to(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port)
+CAT_API ssize_t cat_socket_peek_from(const cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port)
 {
-    return cat_socket_write_to_ex(socket, vector, vector_count, name, name_length, port, cat_socket_get_write_timeout_fast(socket));
+    return cat_socket_peek_from_ex(socket, buffer, size, name, name_length, port, 0);
 }
 
-CAT_API cat_bool_t cat_socket_write_to_ex(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port, cat_timeout_t timeout)
+CAT_API ssize_t cat_socket_peek_from_ex(const cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port, cat_timeout_t timeout)
 {
-#ifdef CAT_ENABLE_DEBUG_LOG
-    char *vector_quoted = 0;
-#endif
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        vector_quoted = cat_socket_write_vector_str(vector, vector_count);
-        CAT_LOG_DEBUG_D(SOCKET, "write_to(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, vector_quoted, (int) name_length, name, port, timeout);
-    });
-
-    cat_bool_t ret = cat_socket_write_to_impl(socket, vector, vector_count, name, name_length, port, timeout);
-
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "write_to(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
-            socket->id, vector_quoted, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
-        cat_buffer_str_free(vector_quoted);
+    CAT_LOG_DEBUG_VA(SOCKET, if (timeout != 0) {
+        CAT_LOG_DEBUG_D(SOCKET, "peek_from(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+            socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, CAT_LOG_READ_BUFFER_C(name), name_length != NULL ? *name_length: 0, timeout);
     });
 
-    return ret;
-}
-
-CAT_API ssize_t cat_socket_try_write_to(cat_socket_t *socket, const cat_socket_write_vector_t *vector, unsigned int vector_count, const char *name, size_t name_length, int port)
-{
-    ssize_t n = cat_socket_try_write_to_impl(socket, vector, vector_count, name, name_length, port);
+    ssize_t n = cat_socket_peek_from_impl(socket, buffer, size, name, name_length, port, timeout);
 
     CAT_LOG_DEBUG_VA(SOCKET, {
-        char *vector_quoted = cat_socket_write_vector_str(vector, vector_count);
-        CAT_LOG_DEBUG_D(SOCKET, "try_write_to(" CAT_SOCKET_ID_FMT ", %s, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, vector_quoted, (int) name_length, name, port, CAT_LOG_SSIZE_RET_C(n));
-        cat_buffer_str_free(vector_quoted);
+        char *s;
+        CAT_LOG_DEBUG_D(SOCKET, "peek_from(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) (name_length != NULL ? *name_length : 0), name, port != NULL ? *port : 0, timeout, CAT_LOG_SSIZE_RET_C(n));
+        cat_free(s);
     });
 
     return n;
 }
 
-CAT_API ssize_t cat_socket_recv(cat_socket_t *socket, char *buffer, size_t size)
-{
-    return cat_socket_recv_ex(socket, buffer, size, cat_socket_get_read_timeout_fast(socket));
-}
+/* datagram batch I/O */
 
-CAT_API ssize_t cat_socket_recv_ex(cat_socket_t *socket, char *buffer, size_t size, cat_timeout_t timeout)
+#ifdef CAT_SOCKET_HAVE_MMSG
+static ssize_t cat_socket_internal_try_recv_mmsg(cat_socket_fd_t fd, cat_socket_datagram_t *datagrams, size_t count)
 {
-    CAT_LOG_DEBUG(SOCKET, "recv(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-        socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, timeout);
-
-    ssize_t n = cat_socket_read_impl(socket, buffer, size, 0, NULL, timeout, cat_true);
+    struct mmsghdr msgs[CAT_SOCKET_DATAGRAM_BATCH_MAX_COUNT];
+    struct iovec iovs[CAT_SOCKET_DATAGRAM_BATCH_MAX_COUNT];
+    size_t i;
+    int n;
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        char *s;
-        CAT_LOG_DEBUG_D(SOCKET, "recv(" CAT_SOCKET_ID_FMT ", %s, %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, timeout, CAT_LOG_SSIZE_RET_C(n));
-        cat_free(s);
-    });
+    count = CAT_MIN(count, CAT_SOCKET_DATAGRAM_BATCH_MAX_COUNT);
+    for (i = 0; i < count; i++) {
+        cat_socket_datagram_t *datagram = &datagrams[i];
+        iovs[i].iov_base = datagram->buffer;
+        iovs[i].iov_len = datagram->size;
+        msgs[i].msg_hdr.msg_name = &datagram->address.address;
+        msgs[i].msg_hdr.msg_namelen = sizeof(datagram->address.address);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = NULL;
+        msgs[i].msg_hdr.msg_controllen = 0;
+        msgs[i].msg_hdr.msg_flags = 0;
+        msgs[i].msg_len = 0;
+    }
+    do {
+        n = recvmmsg(fd, msgs, (unsigned int) count, MSG_DONTWAIT, NULL);
+    } while (n < 0 && cat_sys_errno == EINTR);
+    if (unlikely(n < 0)) {
+        return cat_translate_sys_error(cat_sys_errno);
+    }
+    for (i = 0; i < (size_t) n; i++) {
+        datagrams[i].length = msgs[i].msg_len;
+        datagrams[i].address.length = msgs[i].msg_hdr.msg_namelen;
+    }
 
     return n;
 }
 
-CAT_API ssize_t cat_socket_try_recv(cat_socket_t *socket, char *buffer, size_t size)
+static ssize_t cat_socket_internal_try_send_mmsg(cat_socket_fd_t fd, const cat_socket_datagram_t *datagrams, size_t count)
 {
-    ssize_t n = cat_socket_try_recv_impl(socket, buffer, size, NULL, NULL);
+    struct mmsghdr msgs[CAT_SOCKET_DATAGRAM_BATCH_MAX_COUNT];
+    struct iovec iovs[CAT_SOCKET_DATAGRAM_BATCH_MAX_COUNT];
+    size_t i;
+    int n;
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        char *s;
-        CAT_LOG_DEBUG_D(SOCKET, "try_recv(" CAT_SOCKET_ID_FMT ", %s, %zu) = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, CAT_LOG_SSIZE_RET_C(n));
-        cat_free(s);
-    });
+    count = CAT_MIN(count, CAT_SOCKET_DATAGRAM_BATCH_MAX_COUNT);
+    for (i = 0; i < count; i++) {
+        const cat_socket_datagram_t *datagram = &datagrams[i];
+        iovs[i].iov_base = datagram->buffer;
+        iovs[i].iov_len = datagram->size;
+        msgs[i].msg_hdr.msg_name = datagram->address.length != 0 ? (void *) &datagram->address.address : NULL;
+        msgs[i].msg_hdr.msg_namelen = datagram->address.length;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = NULL;
+        msgs[i].msg_hdr.msg_controllen = 0;
+        msgs[i].msg_hdr.msg_flags = 0;
+        msgs[i].msg_len = 0;
+    }
+    do {
+        n = sendmmsg(fd, msgs, (unsigned int) count, MSG_DONTWAIT);
+    } while (n < 0 && CAT_SOCKET_RETRY_ON_WRITE_ERROR(cat_sys_errno));
+    if (unlikely(n < 0)) {
+        return cat_translate_sys_error(cat_sys_errno);
+    }
 
     return n;
 }
 
-CAT_API ssize_t cat_socket_recvfrom(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length)
+#ifdef UDP_SEGMENT
+#define CAT_SOCKET_UDP_GSO_MAX_SEGMENTS 64
+/* max UDP payload of IPv4 */
+#define CAT_SOCKET_UDP_GSO_MAX_SIZE     65507
+
+static cat_bool_t cat_socket_internal_udp_gso_available(cat_socket_internal_t *socket_i, cat_socket_fd_t fd)
 {
-    return cat_socket_recvfrom_ex(socket, buffer, size, address, address_length, cat_socket_get_read_timeout_fast(socket));
+    if (unlikely(!(socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_UDP_GSO_CHECKED))) {
+        int value;
+        socklen_t length = sizeof(value);
+        /* old kernels ignore unknown cmsg silently, so we must make sure UDP_SEGMENT is supported,
+         * otherwise all segments would be sent as one datagram */
+        if (getsockopt(fd, IPPROTO_UDP, UDP_SEGMENT, &value, &length) != 0) {
+            socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_UDP_GSO_UNAVAILABLE;
+        }
+        socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_UDP_GSO_CHECKED;
+    }
+    return !(socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_UDP_GSO_UNAVAILABLE);
 }
 
-CAT_API ssize_t cat_socket_recvfrom_ex(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_timeout_t timeout)
+/* leading datagrams with the same destination and the same size (except the last one) can be sent as one GSO packet,
+ * zero-length datagrams are never merged since they would become nothing instead of an empty segment */
+static size_t cat_socket_udp_gso_count(const cat_socket_datagram_t *datagrams, size_t count)
 {
-    CAT_LOG_DEBUG(SOCKET, "recvfrom(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_LOG_READ_BUFFER_FMT ", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-        socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, CAT_LOG_READ_BUFFER_C(address), address_length != NULL ? *address_length: 0, timeout);
-
-    ssize_t n = cat_socket_read_impl(socket, buffer, size, address, address_length, timeout, cat_true);
+    size_t segment_size = datagrams[0].size;
+    size_t total_size = 0;
+    size_t n;
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        char *s;
-        char name[CAT_SOCKADDR_MAX_PATH];
-        size_t name_length = sizeof(name);
-        int port;
-        if (cat_sockaddr_to_name_silent(address, address_length != NULL ? *address_length : 0, name, &name_length, &port) != 0) {
+    if (unlikely(segment_size == 0)) {
+        return 0;
+    }
+    count = CAT_MIN(count, CAT_SOCKET_UDP_GSO_MAX_SEGMENTS);
+    for (n = 0; n < count; n++) {
+        const cat_socket_datagram_t *datagram = &datagrams[n];
+        if (datagram->size == 0 || datagram->size > segment_size || total_size + datagram->size > CAT_SOCKET_UDP_GSO_MAX_SIZE) {
             break;
         }
-        CAT_LOG_DEBUG_D(SOCKET, "recvfrom(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) name_length, name, port, timeout, CAT_LOG_SSIZE_RET_C(n));
-        cat_free(s);
-    });
+        if (n > 0 && (
+            datagram->address.length != datagrams[0].address.length ||
+            memcmp(&datagram->address.address, &datagrams[0].address.address, datagram->address.length) != 0
+        )) {
+            break;
+        }
+        total_size += datagram->size;
+        if (datagram->size < segment_size) {
+            n++;
+            break;
+        }
+    }
 
     return n;
 }
 
-CAT_API ssize_t cat_socket_try_recvfrom(cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length)
+static ssize_t cat_socket_internal_try_send_gso(cat_socket_fd_t fd, const cat_socket_datagram_t *datagrams, size_t count)
 {
-    ssize_t n = cat_socket_try_recv_impl(socket, buffer, size, address, address_length);
+    struct iovec iovs[CAT_SOCKET_UDP_GSO_MAX_SEGMENTS];
+    union {
+        char buffer[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control;
+    struct cmsghdr *cmsg;
+    struct msghdr msg;
+    uint16_t segment_size = (uint16_t) datagrams[0].size;
+    ssize_t n;
+    size_t i;
+
+    CAT_ASSERT(count <= CAT_SOCKET_UDP_GSO_MAX_SEGMENTS);
+    for (i = 0; i < count; i++) {
+        iovs[i].iov_base = datagrams[i].buffer;
+        iovs[i].iov_len = datagrams[i].size;
+    }
+    memset(&control, 0, sizeof(control));
+    msg.msg_name = datagrams[0].address.length != 0 ? (void *) &datagrams[0].address.address : NULL;
+    msg.msg_namelen = datagrams[0].address.length;
+    msg.msg_iov = iovs;
+    msg.msg_iovlen = count;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+    msg.msg_flags = 0;
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = IPPROTO_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(segment_size));
+    memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+    do {
+        n = sendmsg(fd, &msg, MSG_DONTWAIT);
+    } while (n < 0 && CAT_SOCKET_RETRY_ON_WRITE_ERROR(cat_sys_errno));
+    if (unlikely(n < 0)) {
+        return cat_translate_sys_error(cat_sys_errno);
+    }
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        char *s;
-        char name[CAT_SOCKADDR_MAX_PATH];
-        size_t name_length = sizeof(name);
-        int port;
-        if (cat_sockaddr_to_name_silent(address, address_length != NULL ? *address_length : 0, name, &name_length, &port) != 0) {
+    return (ssize_t) count;
+}
+#endif /* UDP_SEGMENT */
+#endif /* CAT_SOCKET_HAVE_MMSG */
+
+static ssize_t cat_socket_internal_try_recv_multiple(cat_socket_internal_t *socket_i, cat_socket_datagram_t *datagrams, size_t count)
+{
+    size_t n = 0;
+    ssize_t ret = CAT_EAGAIN;
+
+#ifdef CAT_SOCKET_HAVE_MMSG
+    if ((socket_i->type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP) {
+        cat_socket_fd_t fd = cat_socket_internal_get_fd_fast(socket_i);
+        if (unlikely(fd == CAT_SOCKET_INVALID_FD)) {
+            return CAT_EBADF;
+        }
+        while (n < count) {
+            ret = cat_socket_internal_try_recv_mmsg(fd, datagrams + n, count - n);
+            if (ret <= 0) {
+                break;
+            }
+            n += ret;
+            if (ret < CAT_SOCKET_DATAGRAM_BATCH_MAX_COUNT) {
+                break; /* no more datagrams */
+            }
+        }
+        return n > 0 ? (ssize_t) n : ret;
+    }
+#endif
+    while (n < count) {
+        cat_socket_datagram_t *datagram = &datagrams[n];
+        datagram->address.length = sizeof(datagram->address.address);
+        ret = cat_socket_internal_try_recv_raw(
+            socket_i, datagram->buffer, datagram->size,
+            &datagram->address.address.common, &datagram->address.length
+        );
+        if (ret < 0) {
             break;
         }
-        CAT_LOG_DEBUG_D(SOCKET, "try_recvfrom(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) name_length, name, port, CAT_LOG_SSIZE_RET_C(n));
-        cat_free(s);
-    });
+        datagram->length = (size_t) ret;
+        n++;
+    }
 
-    return n;
+    return n > 0 ? (ssize_t) n : ret;
 }
 
-CAT_API ssize_t cat_socket_recv_from(cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port)
+static ssize_t cat_socket_internal_recv_multiple(cat_socket_internal_t *socket_i, cat_socket_datagram_t *datagrams, size_t count, cat_timeout_t timeout)
 {
-    return cat_socket_recv_from_ex(socket, buffer, size, name, name_length, port, cat_socket_get_read_timeout_fast(socket));
+    cat_socket_datagram_t *datagram;
+    ssize_t n;
+
+    if (unlikely(count == 0)) {
+        return 0;
+    }
+    n = cat_socket_internal_try_recv_multiple(socket_i, datagrams, count);
+    if (n > 0) {
+        return n;
+    }
+    if (unlikely(n != CAT_EAGAIN && n != CAT_EBADF)) {
+        cat_update_last_error_with_reason((cat_errno_t) n, "Socket recv multiple failed");
+        return -1;
+    }
+    /* wait for the first datagram (only one wakeup),
+     * then receive the rest of datagrams which have arrived without blocking */
+    datagram = &datagrams[0];
+    datagram->address.length = sizeof(datagram->address.address);
+    n = cat_socket_internal_read_raw(
+        socket_i, datagram->buffer, datagram->size,
+        &datagram->address.address.common, &datagram->address.length,
+        timeout, cat_true
+    );
+    if (unlikely(n < 0)) {
+        return -1;
+    }
+    datagram->length = (size_t) n;
+    if (count > 1) {
+        n = cat_socket_internal_try_recv_multiple(socket_i, datagrams + 1, count - 1);
+        if (n > 0) {
+            return n + 1;
+        }
+    }
+
+    return 1;
 }
 
-CAT_API ssize_t cat_socket_recv_from_ex(cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port, cat_timeout_t timeout)
+static ssize_t cat_socket_internal_try_send_multiple(cat_socket_internal_t *socket_i, const cat_socket_datagram_t *datagrams, size_t count)
 {
-    CAT_LOG_DEBUG(SOCKET, "recv_from(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-        socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, CAT_LOG_READ_BUFFER_C(name), name_length != NULL ? *name_length: 0, timeout);
-
-    ssize_t n = cat_socket_recv_from_impl(socket, buffer, size, name, name_length, port, timeout);
+    size_t n = 0;
+    ssize_t ret = CAT_EAGAIN;
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        char *s;
-        CAT_LOG_DEBUG_D(SOCKET, "recv_from(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) (name_length != NULL ? *name_length : 0), name, port != NULL ? *port : 0, timeout, CAT_LOG_SSIZE_RET_C(n));
-        cat_free(s);
-    });
+    if (socket_i->io_flags & CAT_SOCKET_IO_FLAG_WRITE) {
+        /* keep order with the queued writes */
+        return CAT_EAGAIN;
+    }
+#ifdef CAT_SOCKET_HAVE_MMSG
+    if ((socket_i->type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP) {
+        cat_socket_fd_t fd = cat_socket_internal_get_fd_fast(socket_i);
+        if (unlikely(fd == CAT_SOCKET_INVALID_FD)) {
+            return CAT_EBADF;
+        }
+        while (n < count) {
+#ifdef UDP_SEGMENT
+            if (cat_socket_internal_udp_gso_available(socket_i, fd)) {
+                size_t gso_count = cat_socket_udp_gso_count(datagrams + n, count - n);
+                if (gso_count > 1) {
+                    ret = cat_socket_internal_try_send_gso(fd, datagrams + n, gso_count);
+                    if (ret > 0) {
+                        n += ret;
+                        continue;
+                    }
+                    if (ret == CAT_EAGAIN) {
+                        break;
+                    }
+                    if (ret == CAT_EIO) {
+                        /* device does not support checksum offload */
+                        socket_i->flags |= CAT_SOCKET_INTERNAL_FLAG_UDP_GSO_UNAVAILABLE;
+                    }
+                    /* e.g. EINVAL if segment size is greater than MTU, fallback to sendmmsg() */
+                }
+            }
+#endif
+            ret = cat_socket_internal_try_send_mmsg(fd, datagrams + n, count - n);
+            if (ret <= 0) {
+                break;
+            }
+            n += ret;
+        }
+        return n > 0 ? (ssize_t) n : ret;
+    }
+#endif
+    while (n < count) {
+        const cat_socket_datagram_t *datagram = &datagrams[n];
+        cat_socket_write_vector_t vector = cat_socket_write_vector_init(datagram->buffer, (cat_socket_vector_length_t) datagram->size);
+        ret = cat_socket_internal_try_write_raw(
+            socket_i, &vector, 1,
+            datagram->address.length != 0 ? &datagram->address.address.common : NULL, datagram->address.length
+        );
+        if (ret < 0) {
+            break;
+        }
+        n++;
+    }
 
-    return n;
+    return n > 0 ? (ssize_t) n : ret;
 }
 
-CAT_API ssize_t cat_socket_try_recv_from(cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port)
+static ssize_t cat_socket_internal_send_multiple(cat_socket_internal_t *socket_i, const cat_socket_datagram_t *datagrams, size_t count, cat_timeout_t timeout)
 {
-    ssize_t n = cat_socket_try_recv_from_impl(socket, buffer, size, name, name_length, port);
+    size_t n = 0;
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        char *s;
-        CAT_LOG_DEBUG_D(SOCKET, "try_recvfrom(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) (name_length != NULL ? *name_length : 0), name, port != NULL ? *port : 0, CAT_LOG_SSIZE_RET_C(n));
-        cat_free(s);
-    });
+    while (n < count) {
+        const cat_socket_datagram_t *datagram = &datagrams[n];
+        cat_socket_write_vector_t vector;
+        ssize_t ret;
+        cat_bool_t sent;
+
+        ret = cat_socket_internal_try_send_multiple(socket_i, datagram, count - n);
+        if (ret > 0) {
+            n += ret;
+            continue;
+        }
+        if (unlikely(ret != CAT_EAGAIN && ret != CAT_EBADF)) {
+            cat_update_last_error_with_reason((cat_errno_t) ret, "Socket send multiple failed");
+            goto _error;
+        }
+        /* wait for writable by sending one datagram in the common way (lazy bind may also be triggered),
+         * then try to send the rest of datagrams in batch again */
+        vector = cat_socket_write_vector_init(datagram->buffer, (cat_socket_vector_length_t) datagram->size);
+        CAT_TIME_WAIT_START() {
+            sent = cat_socket_internal_write_raw(
+                socket_i, &vector, 1,
+                datagram->address.length != 0 ? &datagram->address.address.common : NULL, datagram->address.length,
+                NULL, timeout
+            );
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(!sent)) {
+            goto _error;
+        }
+        n++;
+    }
 
-    return n;
-}
+    return (ssize_t) n;
 
-CAT_API cat_bool_t cat_socket_send(cat_socket_t *socket, const char *buffer, size_t length)
-{
-    return cat_socket_send_ex(socket, buffer, length, cat_socket_get_write_timeout_fast(socket));
+    _error:
+    return n > 0 ? (ssize_t) n : -1;
 }
 
-CAT_API cat_bool_t cat_socket_send_ex(cat_socket_t *socket, const char *buffer, size_t length, cat_timeout_t timeout)
-{
-    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
-
-#ifdef CAT_ENABLE_DEBUG_LOG
-    char *buffer_quoted = NULL;
-#endif
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "send(" CAT_SOCKET_ID_FMT ", %s, %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, cat_log_str_quote(buffer, length, &buffer_quoted), length, timeout);
-    });
-
-    cat_bool_t ret = cat_socket_write_impl(socket, &vector, 1, NULL, 0, timeout);
+#define CAT_SOCKET_DATAGRAM_IO_CHECK(_socket, _socket_i, _io_flag, _failure) \
+        CAT_SOCKET_INTERNAL_GETTER_WITH_IO(_socket, _socket_i, _io_flag, _failure); \
+        CAT_SOCKET_INTERNAL_WHICH_ONLY(_socket_i, CAT_SOCKET_TYPE_FLAG_DGRAM, "Socket should be type of dgram", _failure)
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "send(" CAT_SOCKET_ID_FMT ", %s, %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
-            socket->id, buffer_quoted, length, timeout, CAT_LOG_BOOL_RET_C(ret));
-        cat_free(buffer_quoted);
-    });
+static ssize_t cat_socket_recv_multiple_impl(cat_socket_t *socket, cat_socket_datagram_t *datagrams, size_t count, cat_timeout_t timeout)
+{
+    CAT_SOCKET_DATAGRAM_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_READ, return -1);
 
-    return ret;
+    return cat_socket_internal_recv_multiple(socket_i, datagrams, count, timeout);
 }
 
-CAT_API ssize_t cat_socket_try_send(cat_socket_t *socket, const char *buffer, size_t length)
+static ssize_t cat_socket_send_multiple_impl(cat_socket_t *socket, const cat_socket_datagram_t *datagrams, size_t count, cat_timeout_t timeout)
 {
-    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
-
-    ssize_t n = cat_socket_try_write_impl(socket, &vector, 1, NULL, 0);
+    CAT_SOCKET_DATAGRAM_IO_CHECK(socket, socket_i, CAT_SOCKET_IO_FLAG_NONE, return -1);
+    size_t n;
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        char *s;
-        CAT_LOG_DEBUG_D(SOCKET, "try_send(" CAT_SOCKET_ID_FMT ", %s) = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, length, &s), CAT_LOG_SSIZE_RET_C(n));
-        cat_free(s);
-    });
+    for (n = 0; n < count; n++) {
+        CAT_SOCKET_CHECK_INPUT_ADDRESS(&datagrams[n].address.address.common, datagrams[n].address.length, return -1);
+    }
 
-    return n;
+    return cat_socket_internal_send_multiple(socket_i, datagrams, count, timeout);
 }
 
-CAT_API cat_bool_t cat_socket_sendto(cat_socket_t *socket, const char *buffer, size_t length, const cat_sockaddr_t *address, cat_socklen_t address_length)
+CAT_API ssize_t cat_socket_recv_multiple(cat_socket_t *socket, cat_socket_datagram_t *datagrams, size_t count)
 {
-    return cat_socket_sendto_ex(socket, buffer, length, address, address_length, cat_socket_get_write_timeout_fast(socket));
+    return cat_socket_recv_multiple_ex(socket, datagrams, count, cat_socket_get_read_timeout_fast(socket));
 }
 
-CAT_API cat_bool_t cat_socket_sendto_ex(cat_socket_t *socket, const char *buffer, size_t length, const cat_sockaddr_t *address, cat_socklen_t address_length, cat_timeout_t timeout)
+CAT_API ssize_t cat_socket_recv_multiple_ex(cat_socket_t *socket, cat_socket_datagram_t *datagrams, size_t count, cat_timeout_t timeout)
 {
-    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
+    CAT_LOG_DEBUG(SOCKET, "recv_multiple(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+        socket->id, count, timeout);
 
-#ifdef CAT_ENABLE_DEBUG_LOG
-    char *buffer_quoted = NULL;
-    char name[CAT_SOCKADDR_MAX_PATH];
-    size_t name_length = sizeof(name);
-    int port = 0;
-#endif
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
-            break;
-        }
-        CAT_LOG_DEBUG_D(SOCKET, "sendto(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, cat_log_str_quote(buffer, length, &buffer_quoted), length, (int) name_length, name, port, timeout);
-    });
+    ssize_t n = cat_socket_recv_multiple_impl(socket, datagrams, count, timeout);
 
-    cat_bool_t ret = cat_socket_write_impl(socket, &vector, 1, address, address_length, timeout);
+    CAT_LOG_DEBUG(SOCKET, "recv_multiple(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+        socket->id, count, timeout, CAT_LOG_SSIZE_RET_C(n));
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "sendto(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
-            socket->id, buffer_quoted, length, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
-        cat_free(buffer_quoted);
-    });
+    return n;
+}
 
-    return ret;
+CAT_API ssize_t cat_socket_send_multiple(cat_socket_t *socket, const cat_socket_datagram_t *datagrams, size_t count)
+{
+    return cat_socket_send_multiple_ex(socket, datagrams, count, cat_socket_get_write_timeout_fast(socket));
 }
 
-CAT_API ssize_t cat_socket_try_sendto(cat_socket_t *socket, const char *buffer, size_t length, const cat_sockaddr_t *address, cat_socklen_t address_length)
+CAT_API ssize_t cat_socket_send_multiple_ex(cat_socket_t *socket, const cat_socket_datagram_t *datagrams, size_t count, cat_timeout_t timeout)
 {
-    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
+    CAT_LOG_DEBUG(SOCKET, "send_multiple(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+        socket->id, count, timeout);
 
-    ssize_t n = cat_socket_try_write_impl(socket, &vector, 1, address, address_length);
+    ssize_t n = cat_socket_send_multiple_impl(socket, datagrams, count, timeout);
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        char *buffer_quoted;
-        char name[CAT_SOCKADDR_MAX_PATH];
-        size_t name_length = sizeof(name);
-        int port;
-        if (cat_sockaddr_to_name_silent(address, address_length, name, &name_length, &port) != 0) {
-            break;
-        }
-        CAT_LOG_DEBUG_D(SOCKET, "try_sendto(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, length, &buffer_quoted), length, (int) name_length, name, port, CAT_LOG_SSIZE_RET_C(n));
-        cat_free(buffer_quoted);
-    });
+    CAT_LOG_DEBUG(SOCKET, "send_multiple(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
+        socket->id, count, timeout, CAT_LOG_SSIZE_RET_C(n));
 
     return n;
 }
 
-CAT_API cat_bool_t cat_socket_send_to(cat_socket_t *socket, const char *buffer, size_t length, const char *name, size_t name_length, int port)
-{
-    return cat_socket_send_to_ex(socket, buffer, length, name, name_length, port, cat_socket_get_write_timeout_fast(socket));
-}
+/* buffered reader */
 
-CAT_API cat_bool_t cat_socket_send_to_ex(cat_socket_t *socket, const char *buffer, size_t length, const char *name, size_t name_length, int port, cat_timeout_t timeout)
-{
-    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
+#define CAT_SOCKET_READER_CHECK(_socket, _socket_i, _failure) \
+        CAT_SOCKET_IO_CHECK(_socket, _socket_i, CAT_SOCKET_IO_FLAG_READ, _failure); \
+        CAT_SOCKET_INTERNAL_WHICH_ONLY(_socket_i, CAT_SOCKET_TYPE_FLAG_STREAM, "Socket should be type of stream", _failure)
 
-#ifdef CAT_ENABLE_DEBUG_LOG
-    char *buffer_quoted = NULL;
-#endif
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "send_to(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, cat_log_str_quote(buffer, length, &buffer_quoted), length, (int) name_length, name, port, timeout);
-    });
+static const char *cat_socket_internal_read_until(
+    cat_socket_internal_t *socket_i,
+    const char *delimiter, size_t delimiter_length,
+    size_t max_length, size_t *length,
+    cat_timeout_t timeout
+)
+{
+    cat_socket_reader_t *reader = &socket_i->reader;
+    /* bytes which have been searched (relative to the reader offset) */
+    size_t searched = 0;
+    size_t limit;
 
-    cat_bool_t ret = cat_socket_write_to_impl(socket, &vector, 1, name, name_length, port, timeout);
+    if (unlikely(delimiter_length == 0)) {
+        cat_update_last_error(CAT_EINVAL, "Socket read delimiter can not be empty");
+        return NULL;
+    }
+    if (max_length == 0 || max_length > SIZE_MAX - delimiter_length) {
+        limit = SIZE_MAX;
+    } else {
+        limit = max_length + delimiter_length;
+    }
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        CAT_LOG_DEBUG_D(SOCKET, "send_to(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
-            socket->id, buffer_quoted, length, (int) name_length, name, port, timeout, CAT_LOG_BOOL_RET_C(ret));
-        cat_free(buffer_quoted);
-    });
+    while (1) {
+        const char *data = reader->buffer.value + reader->offset;
+        size_t buffered_length = cat_socket_internal_get_read_buffered_length(socket_i);
+        size_t search_length = CAT_MIN(buffered_length, limit);
+        cat_bool_t ret;
 
-    return ret;
+        if (search_length > searched && search_length >= delimiter_length) {
+            const char *p = cat_memmem(data + searched, search_length - searched, delimiter, delimiter_length);
+            if (p != NULL) {
+                *length = p - data;
+                reader->offset += *length + delimiter_length;
+                return data;
+            }
+            /* delimiter may be separated by the end of data */
+            searched = search_length - (delimiter_length - 1);
+        }
+        if (unlikely(buffered_length >= limit)) {
+            cat_update_last_error(CAT_EMSGSIZE, "Socket message is too large (max length is %zu)", max_length);
+            return NULL;
+        }
+        CAT_TIME_WAIT_START() {
+            ret = cat_socket_internal_reader_fill(socket_i, buffered_length + 1, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(!ret)) {
+            cat_update_last_error_with_previous("Socket read until delimiter failed");
+            return NULL;
+        }
+    }
 }
 
-CAT_API ssize_t cat_socket_try_send_to(cat_socket_t *socket, const char *buffer, size_t length, const char *name, size_t name_length, int port)
+static cat_always_inline uint64_t cat_socket_frame_length_field_decode(const unsigned char *p, uint8_t size, cat_bool_t little_endian)
 {
-    cat_socket_write_vector_t vector = cat_socket_write_vector_init(buffer, (cat_socket_vector_length_t) length);
-
-    ssize_t n = cat_socket_try_write_to_impl(socket, &vector, 1, name, name_length, port);
+    uint64_t value = 0;
+    uint8_t n;
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        char *buffer_quoted;
-        CAT_LOG_DEBUG_D(SOCKET, "try_send_to(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d) = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, length, &buffer_quoted), length, (int) name_length, name, port, CAT_LOG_SSIZE_RET_C(n));
-        cat_free(buffer_quoted);
-    });
+    if (little_endian) {
+        for (n = size; n > 0; n--) {
+            value = (value << 8) | p[n - 1];
+        }
+    } else {
+        for (n = 0; n < size; n++) {
+            value = (value << 8) | p[n];
+        }
+    }
 
-    return n;
+    return value;
 }
 
-static ssize_t cat_socket_internal_peekfrom(
-    const cat_socket_internal_t *socket_i,
-    char *buffer, size_t size,
-    cat_sockaddr_t *address, cat_socklen_t *address_length,
+static const char *cat_socket_internal_read_frame(
+    cat_socket_internal_t *socket_i,
+    const cat_socket_frame_spec_t *spec,
+    size_t max_length, size_t *length,
     cat_timeout_t timeout
 )
 {
-    CAT_SOCKET_INTERNAL_FD_GETTER(socket_i, fd, return cat_false);
-    ssize_t nread;
+    cat_socket_reader_t *reader = &socket_i->reader;
+    size_t header_length, frame_length, message_length;
+    uint64_t value;
+    int64_t rest_length;
+    cat_bool_t ret;
 
-    if (!(socket_i->type & CAT_SOCKET_TYPE_FLAG_DGRAM)) {
-        if (address_length != NULL) {
-            *address_length = 0;
+    if (unlikely(spec->length_field_size == 0 || spec->length_field_size > 8)) {
+        cat_update_last_error(CAT_EINVAL, "Socket frame length field size must be between 1 and 8");
+        return NULL;
+    }
+    if (unlikely(spec->length_field_offset > SIZE_MAX - spec->length_field_size)) {
+        cat_update_last_error(CAT_EINVAL, "Socket frame length field offset is too large");
+        return NULL;
+    }
+    header_length = spec->length_field_offset + spec->length_field_size;
+
+    while (cat_socket_internal_get_read_buffered_length(socket_i) < header_length) {
+        CAT_TIME_WAIT_START() {
+            ret = cat_socket_internal_reader_fill(socket_i, header_length, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(!ret)) {
+            goto _read_error;
         }
     }
-    while (1) {
-#ifdef CAT_OS_UNIX_LIKE
-        do {
-#endif
-            nread = recvfrom(
-                fd,
-                buffer, (cat_socket_recv_length_t) size,
-                MSG_PEEK,
-                address, address_length
-            );
-#ifdef CAT_OS_UNIX_LIKE
-        } while (unlikely(nread < 0 && errno == EINTR));
-#endif
-        if (nread < 0) {
-            cat_errno_t error = cat_translate_sys_error(cat_sys_errno);
-            if (unlikely(error != CAT_EAGAIN && error != CAT_EMSGSIZE)) {
-                /* there was an unrecoverable error */
-                cat_update_last_error_of_syscall("Socket peek failed");
-            } else {
-                /* not real error */
-                nread = 0;
-                if (timeout != 0) {
-                    /* wait for readable when timeout is not 0 */
-                    cat_ret_t ret = cat_poll_one(fd, POLLIN, NULL, timeout);
-                    if (ret == CAT_RET_OK) {
-                        continue;
-                    } else if (ret == CAT_RET_NONE) {
-                        cat_update_last_error(CAT_ETIMEDOUT, "Socket peek wait readable timedout");
-                    } else {
-                        cat_update_last_error_with_previous("Socket peek wait readable failed");
-                    }
-                }
-            }
-            if (address_length != NULL) {
-                *address_length = 0;
-            }
+
+    value = cat_socket_frame_length_field_decode(
+        (const unsigned char *) reader->buffer.value + reader->offset + spec->length_field_offset,
+        spec->length_field_size, spec->length_field_little_endian
+    );
+    if (unlikely(value > (uint64_t) INT64_MAX ||
+        (spec->length_adjustment > 0 && (int64_t) value > INT64_MAX - spec->length_adjustment))) {
+        goto _too_large;
+    }
+    rest_length = (int64_t) value + spec->length_adjustment;
+    if (unlikely(rest_length < 0)) {
+        cat_update_last_error(CAT_EPROTO, "Socket frame length %" PRIu64 " is invalid", value);
+        return NULL;
+    }
+    if (unlikely((uint64_t) rest_length > SIZE_MAX - header_length)) {
+        goto _too_large;
+    }
+    frame_length = header_length + (size_t) rest_length;
+    if (unlikely(frame_length < spec->initial_bytes_to_strip)) {
+        cat_update_last_error(CAT_EPROTO, "Socket frame length %zu is less than initial bytes to strip", frame_length);
+        return NULL;
+    }
+    message_length = frame_length - spec->initial_bytes_to_strip;
+    if (unlikely(max_length != 0 && message_length > max_length)) {
+        goto _too_large;
+    }
+
+    while (cat_socket_internal_get_read_buffered_length(socket_i) < frame_length) {
+        CAT_TIME_WAIT_START() {
+            ret = cat_socket_internal_reader_fill(socket_i, frame_length, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(!ret)) {
+            goto _read_error;
         }
-        break;
     }
 
-    return nread;
+    *length = message_length;
+    reader->offset += frame_length;
+    return reader->buffer.value + reader->offset - message_length;
+
+    _too_large:
+    cat_update_last_error(CAT_EMSGSIZE, "Socket frame is too large (max length is %zu)", max_length);
+    return NULL;
+    _read_error:
+    cat_update_last_error_with_previous("Socket read frame failed");
+    return NULL;
 }
 
-static ssize_t cat_socket_peekfrom_impl(const cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_timeout_t timeout)
+CAT_API const char *cat_socket_read_until(cat_socket_t *socket, const char *delimiter, size_t delimiter_length, size_t max_length, size_t *length)
 {
-    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
-
-    return cat_socket_internal_peekfrom(socket_i, buffer, size, address, address_length, timeout);
+    return cat_socket_read_until_ex(socket, delimiter, delimiter_length, max_length, length, cat_socket_get_read_timeout_fast(socket));
 }
 
-static ssize_t cat_socket_peek_from_impl(const cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port, cat_timeout_t timeout)
+CAT_API const char *cat_socket_read_until_ex(cat_socket_t *socket, const char *delimiter, size_t delimiter_length, size_t max_length, size_t *length, cat_timeout_t timeout)
 {
-    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
-    CAT_SOCKET_READ_ADDRESS_CONTEXT(address, name, name_length, port);
-    ssize_t nread;
+    CAT_SOCKET_READER_CHECK(socket, socket_i, return NULL);
+    const char *data;
 
-    nread = cat_socket_internal_peekfrom(socket_i, buffer, size, address, address_length, timeout);
+    data = cat_socket_internal_read_until(socket_i, delimiter, delimiter_length, max_length, length, timeout);
 
-    CAT_SOCKET_READ_ADDRESS_TO_NAME(address, name, name_length, port);
+    CAT_LOG_DEBUG_VA(SOCKET, {
+        char *s;
+        CAT_LOG_DEBUG_D(SOCKET, "read_until(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = %s" CAT_LOG_STRERRNO_FMT,
+            socket->id, max_length, timeout, cat_log_str_quote(data, data != NULL ? *length : 0, &s), CAT_LOG_STRERRNO_C(data != NULL, cat_get_last_error_code()));
+        cat_free(s);
+    });
 
-    return nread;
+    return data;
 }
 
-CAT_API ssize_t cat_socket_peek(const cat_socket_t *socket, char *buffer, size_t size)
+CAT_API const char *cat_socket_read_line(cat_socket_t *socket, size_t max_length, size_t *length)
 {
-    return cat_socket_peek_ex(socket, buffer, size, 0);
+    return cat_socket_read_line_ex(socket, max_length, length, cat_socket_get_read_timeout_fast(socket));
 }
 
-CAT_API ssize_t cat_socket_peek_ex(const cat_socket_t *socket, char *buffer, size_t size, cat_timeout_t timeout)
+CAT_API const char *cat_socket_read_line_ex(cat_socket_t *socket, size_t max_length, size_t *length, cat_timeout_t timeout)
 {
-    CAT_LOG_DEBUG_VA(SOCKET, if (timeout != 0) {
-        CAT_LOG_DEBUG_D(SOCKET, "peek(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, timeout);
-    });
+    CAT_SOCKET_READER_CHECK(socket, socket_i, return NULL);
+    const char *data;
 
-    ssize_t n = cat_socket_peekfrom_impl(socket, buffer, size, NULL, NULL, timeout);
+    /* "\r" is a part of message before it is stripped */
+    data = cat_socket_internal_read_until(socket_i, "\n", 1, max_length != 0 && max_length < SIZE_MAX ? max_length + 1 : max_length, length, timeout);
+    if (likely(data != NULL)) {
+        if (*length > 0 && data[*length - 1] == '\r') {
+            (*length)--;
+        }
+        if (unlikely(max_length != 0 && *length > max_length)) {
+            cat_update_last_error(CAT_EMSGSIZE, "Socket message is too large (max length is %zu)", max_length);
+            data = NULL;
+        }
+    }
 
     CAT_LOG_DEBUG_VA(SOCKET, {
         char *s;
-        CAT_LOG_DEBUG_D(SOCKET, "peek(" CAT_SOCKET_ID_FMT ", %s, %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, timeout, CAT_LOG_SSIZE_RET_C(n));
+        CAT_LOG_DEBUG_D(SOCKET, "read_line(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = %s" CAT_LOG_STRERRNO_FMT,
+            socket->id, max_length, timeout, cat_log_str_quote(data, data != NULL ? *length : 0, &s), CAT_LOG_STRERRNO_C(data != NULL, cat_get_last_error_code()));
         cat_free(s);
     });
 
-    return n;
+    return data;
 }
 
-CAT_API ssize_t cat_socket_peekfrom(const cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length)
+CAT_API const char *cat_socket_read_frame(cat_socket_t *socket, const cat_socket_frame_spec_t *spec, size_t max_length, size_t *length)
 {
-    return cat_socket_peekfrom_ex(socket, buffer, size, address, address_length, 0);
+    return cat_socket_read_frame_ex(socket, spec, max_length, length, cat_socket_get_read_timeout_fast(socket));
 }
 
-CAT_API ssize_t cat_socket_peekfrom_ex(const cat_socket_t *socket, char *buffer, size_t size, cat_sockaddr_t *address, cat_socklen_t *address_length, cat_timeout_t timeout)
+CAT_API const char *cat_socket_read_frame_ex(cat_socket_t *socket, const cat_socket_frame_spec_t *spec, size_t max_length, size_t *length, cat_timeout_t timeout)
 {
-    CAT_LOG_DEBUG_VA(SOCKET, if (timeout != 0) {
-        CAT_LOG_DEBUG_D(SOCKET, "peekfrom(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_LOG_READ_BUFFER_FMT ", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, CAT_LOG_READ_BUFFER_C(address), address_length != NULL ? *address_length: 0, timeout);
-    });
+    CAT_SOCKET_READER_CHECK(socket, socket_i, return NULL);
+    const char *data;
 
-    ssize_t n = cat_socket_peekfrom_impl(socket, buffer, size, address, address_length, timeout);
+    data = cat_socket_internal_read_frame(socket_i, spec, max_length, length, timeout);
 
     CAT_LOG_DEBUG_VA(SOCKET, {
         char *s;
-        char name[CAT_SOCKADDR_MAX_PATH];
-        size_t name_length = sizeof(name);
-        int port;
-        if (cat_sockaddr_to_name_silent(address, address_length != NULL ? *address_length : 0, name, &name_length, &port) != 0) {
-            break;
-        }
-        CAT_LOG_DEBUG_D(SOCKET, "peekfrom(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) name_length, name, port, timeout, CAT_LOG_SSIZE_RET_C(n));
+        CAT_LOG_DEBUG_D(SOCKET, "read_frame(" CAT_SOCKET_ID_FMT ", %zu, " CAT_TIMEOUT_FMT ") = %s" CAT_LOG_STRERRNO_FMT,
+            socket->id, max_length, timeout, cat_log_str_quote(data, data != NULL ? *length : 0, &s), CAT_LOG_STRERRNO_C(data != NULL, cat_get_last_error_code()));
         cat_free(s);
     });
 
-    return n;
+    return data;
+}
+
+CAT_API const char *cat_socket_read_ahead(cat_socket_t *socket, size_t length, size_t *buffered_length)
+{
+    return cat_socket_read_ahead_ex(socket, length, buffered_length, cat_socket_get_read_timeout_fast(socket));
 }
 
-CAT_API ssize_t cat_socket_peek_from(const cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port)
+CAT_API const char *cat_socket_read_ahead_ex(cat_socket_t *socket, size_t length, size_t *buffered_length, cat_timeout_t timeout)
 {
-    return cat_socket_peek_from_ex(socket, buffer, size, name, name_length, port, 0);
+    CAT_SOCKET_READER_CHECK(socket, socket_i, return NULL);
+    cat_socket_reader_t *reader = &socket_i->reader;
+    cat_bool_t ret;
+
+    if (unlikely(length == 0)) {
+        cat_update_last_error(CAT_EINVAL, "Socket read ahead length can not be 0");
+        return NULL;
+    }
+    while (cat_socket_internal_get_read_buffered_length(socket_i) < length) {
+        CAT_TIME_WAIT_START() {
+            ret = cat_socket_internal_reader_fill(socket_i, length, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(!ret)) {
+            cat_update_last_error_with_previous("Socket read ahead failed");
+            return NULL;
+        }
+    }
+    *buffered_length = cat_socket_internal_get_read_buffered_length(socket_i);
+
+    return reader->buffer.value + reader->offset;
 }
 
-CAT_API ssize_t cat_socket_peek_from_ex(const cat_socket_t *socket, char *buffer, size_t size, char *name, size_t *name_length, int *port, cat_timeout_t timeout)
+CAT_API size_t cat_socket_read_skip(cat_socket_t *socket, size_t length)
 {
-    CAT_LOG_DEBUG_VA(SOCKET, if (timeout != 0) {
-        CAT_LOG_DEBUG_D(SOCKET, "peek_from(" CAT_SOCKET_ID_FMT ", " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_LOG_READ_BUFFER_FMT ", %zu, " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
-            socket->id, CAT_LOG_READ_BUFFER_C(buffer), size, CAT_LOG_READ_BUFFER_C(name), name_length != NULL ? *name_length: 0, timeout);
-    });
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return 0);
 
-    ssize_t n = cat_socket_peek_from_impl(socket, buffer, size, name, name_length, port, timeout);
+    length = CAT_MIN(length, cat_socket_internal_get_read_buffered_length(socket_i));
+    socket_i->reader.offset += length;
 
-    CAT_LOG_DEBUG_VA(SOCKET, {
-        char *s;
-        CAT_LOG_DEBUG_D(SOCKET, "peek_from(" CAT_SOCKET_ID_FMT ", %s, %zu, \"%.*s\", %d, " CAT_TIMEOUT_FMT ") = " CAT_LOG_SSIZE_RET_FMT,
-            socket->id, cat_log_str_quote(buffer, n < 0 ? 0 : n, &s), size, (int) (name_length != NULL ? *name_length : 0), name, port != NULL ? *port : 0, timeout, CAT_LOG_SSIZE_RET_C(n));
-        cat_free(s);
-    });
+    return length;
+}
 
-    return n;
+CAT_API size_t cat_socket_get_read_buffered_length(const cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return 0);
+
+    return cat_socket_internal_get_read_buffered_length(socket_i);
 }
 
 #define CAT_SOCKET_IPCC_CHECK(_socket, _socket_i, _io_flags, _failure) \
@@ -4589,6 +7184,13 @@ static cat_always_inline ssize_t cat_socket_send_file_impl(cat_socket_t *socket,
     cat_file_t file;
     ssize_t written;
 
+    if (unlikely(socket_i->context.io.write.corked)) {
+        if (unlikely(!cat_socket_internal_cork_flush(socket_i, NULL, 0, timeout))) {
+            cat_update_last_error_with_previous("Socket sendfile failed when flush corked data");
+            return -1;
+        }
+    }
+
     file = cat_fs_open(filename, CAT_FS_OPEN_FLAG_RDONLY);
     if (unlikely(file < 0)) {
         cat_update_last_error_with_previous("Socket sendfile failed when open file");
@@ -4597,7 +7199,8 @@ static cat_always_inline ssize_t cat_socket_send_file_impl(cat_socket_t *socket,
 
 #ifdef CAT_SOCKET_NATIVE_SENDFILE
 # ifdef CAT_SSL
-    if (!socket_i->ssl)
+    /* it is real zero-copy if kTLS send is enabled */
+    if (!cat_socket_internal_should_encrypt(socket_i))
 # endif
     {
         written = cat_socket_internal_native_sendfile(socket_i, file, offset, length, timeout);
@@ -4634,6 +7237,61 @@ CAT_API ssize_t cat_socket_send_file_ex(cat_socket_t *socket, const char *filena
     return written;
 }
 
+CAT_API cat_bool_t cat_socket_cork(cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    CAT_SOCKET_INTERNAL_WHICH_ONLY(socket_i, CAT_SOCKET_TYPE_FLAG_STREAM, "Socket should be type of stream", return cat_false);
+
+    CAT_LOG_DEBUG(SOCKET, "cork(" CAT_SOCKET_ID_FMT ")", socket->id);
+
+    socket_i->context.io.write.corked = cat_true;
+
+    return cat_true;
+}
+
+static cat_always_inline cat_bool_t cat_socket_uncork_impl(cat_socket_t *socket, cat_timeout_t timeout)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    cat_socket_write_context_t *context = &socket_i->context.io.write;
+
+    if (!context->corked) {
+        return cat_true;
+    }
+    context->corked = cat_false;
+    if (context->cork_buffer.length == 0) {
+        cat_buffer_close(&context->cork_buffer);
+        return cat_true;
+    }
+    CAT_SOCKET_INTERNAL_ESTABLISHED_ONLY(socket_i, return cat_false);
+
+    return cat_socket_internal_cork_flush(socket_i, NULL, 0, timeout);
+}
+
+CAT_API cat_bool_t cat_socket_uncork(cat_socket_t *socket)
+{
+    return cat_socket_uncork_ex(socket, cat_socket_get_write_timeout_fast(socket));
+}
+
+CAT_API cat_bool_t cat_socket_uncork_ex(cat_socket_t *socket, cat_timeout_t timeout)
+{
+    CAT_LOG_DEBUG(SOCKET, "uncork(" CAT_SOCKET_ID_FMT ", " CAT_TIMEOUT_FMT ") = " CAT_LOG_UNFINISHED_STR,
+        socket->id, timeout);
+
+    cat_bool_t ret = cat_socket_uncork_impl(socket, timeout);
+
+    CAT_LOG_DEBUG(SOCKET, "uncork(" CAT_SOCKET_ID_FMT ", " CAT_TIMEOUT_FMT ") = " CAT_LOG_BOOL_RET_FMT,
+        socket->id, timeout, CAT_LOG_BOOL_RET_C(ret));
+
+    return ret;
+}
+
+CAT_API cat_bool_t cat_socket_is_corked(const cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return cat_false);
+
+    return socket_i->context.io.write.corked;
+}
+
 static cat_always_inline void cat_socket_io_cancel(cat_coroutine_t *coroutine, const char *type_name)
 {
     if (coroutine != NULL) {
@@ -4642,10 +7300,8 @@ static cat_always_inline void cat_socket_io_cancel(cat_coroutine_t *coroutine, c
     } /* else: under which case will coroutine be null except we are in try_connect()? */
 }
 
-static void cat_socket_close_callback(uv_handle_t *handle)
+static void cat_socket_internal_free(cat_socket_internal_t *socket_i)
 {
-    cat_socket_internal_t *socket_i = cat_container_of(handle, cat_socket_internal_t, u.handle);
-
 #ifdef CAT_SSL
     if (socket_i->ssl_peer_name != NULL) {
         cat_free(socket_i->ssl_peer_name);
@@ -4655,6 +7311,11 @@ static void cat_socket_close_callback(uv_handle_t *handle)
     }
 #endif
 
+    /* all write callbacks have been called before close callback */
+    CAT_ASSERT(socket_i->context.io.write.batch == NULL);
+    cat_buffer_close(&socket_i->context.io.write.cork_buffer);
+    cat_buffer_close(&socket_i->reader.buffer);
+
     if (socket_i->cache.write_request != NULL) {
         cat_free(socket_i->cache.write_request);
     }
@@ -4667,10 +7328,33 @@ static void cat_socket_close_callback(uv_handle_t *handle)
     if (socket_i->cache.peername != NULL) {
         cat_free(socket_i->cache.peername);
     }
+    if (socket_i->accept_stats != NULL) {
+        cat_free(socket_i->accept_stats);
+    }
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    if (socket_i->io_uring != NULL) {
+        cat_socket_io_uring_free(socket_i->io_uring);
+    }
+#endif
 
     cat_free(socket_i);
 }
 
+static void cat_socket_close_callback(uv_handle_t *handle)
+{
+    cat_socket_internal_t *socket_i = cat_container_of(handle, cat_socket_internal_t, u.handle);
+
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    if (socket_i->io_uring != NULL && socket_i->io_uring->send.request != NULL) {
+        /* kernel still references the data of zero-copy send, writer will free it after the notification */
+        socket_i->io_uring->send.close_pending = cat_true;
+        return;
+    }
+#endif
+
+    cat_socket_internal_free(socket_i);
+}
+
 static cat_always_inline void cat_socket_soft_close(cat_socket_t *socket, cat_bool_t unrecoverable_error)
 {
     socket->flags |= CAT_SOCKET_FLAG_CLOSED;
@@ -4714,9 +7398,10 @@ static void cat_socket_internal_close_impl(cat_socket_internal_t *socket_i, cat_
     } while (0);
 
     /* cleanup */
-    if (unlikely(socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_SERVER)) {
-        /* note: only server socket would be added to tree for now */
+    if (socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_IN_TREE) {
         RB_REMOVE(cat_socket_internal_tree_s, &CAT_SOCKET_G(internal_tree), socket_i);
+    }
+    if (unlikely(socket_i->flags & CAT_SOCKET_INTERNAL_FLAG_SERVER)) {
         /* unref in listen (references are idempotent) */
         uv_ref(&socket_i->u.handle);
     }
@@ -4725,6 +7410,10 @@ static void cat_socket_internal_close_impl(cat_socket_internal_t *socket_i, cat_
     if (socket_i->ssl != NULL &&
         cat_ssl_get_shutdown(socket_i->ssl) != (CAT_SSL_SENT_SHUTDOWN | CAT_SSL_RECEIVED_SHUTDOWN)) {
         cat_ssl_set_quiet_shutdown(socket_i->ssl, cat_true);
+        /* otherwise SSL_free() removes the session from cache as it was not closed properly */
+        if (!cat_ssl_is_down(socket_i->ssl)) {
+            cat_ssl_set_shutdown(socket_i->ssl, CAT_SSL_SENT_SHUTDOWN | CAT_SSL_RECEIVED_SHUTDOWN);
+        }
     }
 #endif
 
@@ -4750,6 +7439,10 @@ static void cat_socket_internal_close_impl(cat_socket_internal_t *socket_i, cat_
         }
     }
 
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    cat_socket_internal_io_uring_close(socket_i);
+#endif
+
 #ifdef CAT_OS_UNIX_LIKE
     if ((socket_i->type & CAT_SOCKET_TYPE_UDG) == CAT_SOCKET_TYPE_UDG) {
         if (socket_i->u.udg.readfd != CAT_OS_INVALID_FD) {
@@ -4796,6 +7489,40 @@ static cat_always_inline void cat_socket_internal_close(cat_socket_internal_t *s
     });
 }
 
+/* close() never blocks, so corked data is flushed by one try_write(),
+ * callers who care about it should uncork() before close() */
+static cat_never_inline void cat_socket_internal_cork_try_flush(cat_socket_internal_t *socket_i, cat_socket_t *socket)
+{
+    cat_socket_write_context_t *context = &socket_i->context.io.write;
+    cat_buffer_t *buffer = &context->cork_buffer;
+    cat_socket_write_vector_t vector;
+    size_t length = buffer->length;
+    ssize_t nwrite = 0;
+
+    context->corked = cat_false;
+    if (length == 0) {
+        return;
+    }
+    if (cat_socket_internal_is_established(socket_i)) {
+        vector = cat_socket_write_vector_init(buffer->value, (cat_socket_vector_length_t) length);
+        nwrite = cat_socket_internal_try_write(socket_i, &vector, 1, NULL, 0);
+        if (nwrite < 0) {
+            nwrite = 0;
+        }
+#ifdef CAT_SSL
+        /* encrypted data which is not written yet will be canceled by close */
+        if (socket_i->ssl != NULL && socket_i->ssl->write_buffer.length != 0) {
+            nwrite = 0;
+        }
+#endif
+    }
+    if ((size_t) nwrite < length) {
+        CAT_WARN(SOCKET, "Socket#" CAT_SOCKET_ID_FMT " closed while corked, %zu bytes of corked data were dropped",
+            socket->id, length - (size_t) nwrite);
+    }
+    buffer->length = 0;
+}
+
 static cat_always_inline cat_bool_t cat_socket_close_impl(cat_socket_t *socket)
 {
     cat_socket_internal_t *socket_i = socket->internal;
@@ -4814,6 +7541,10 @@ static cat_always_inline cat_bool_t cat_socket_close_impl(cat_socket_t *socket)
         }
     } else {
         socket->flags |= CAT_SOCKET_FLAG_USER_CLOSED;
+        /* if the socket is still referenced by others, they can flush corked data later */
+        if (unlikely(socket_i->context.io.write.corked) && CAT_REF_GET(socket_i) == 1) {
+            cat_socket_internal_cork_try_flush(socket_i, socket);
+        }
         cat_socket_internal_close(socket_i, socket, cat_false);
     }
 
@@ -4898,6 +7629,18 @@ CAT_API cat_bool_t cat_socket_is_encrypted(const cat_socket_t *socket)
     return socket_i != NULL && cat_socket_internal_is_established(socket_i) &&
            socket_i->ssl != NULL && cat_ssl_is_established(socket_i->ssl);
 }
+
+CAT_API cat_bool_t cat_socket_is_ktls_send_enabled(const cat_socket_t *socket)
+{
+    cat_socket_internal_t *socket_i = socket->internal;
+    return socket_i != NULL && socket_i->ssl != NULL && cat_ssl_is_ktls_send_enabled(socket_i->ssl);
+}
+
+CAT_API cat_bool_t cat_socket_is_ktls_recv_enabled(const cat_socket_t *socket)
+{
+    cat_socket_internal_t *socket_i = socket->internal;
+    return socket_i != NULL && socket_i->ssl != NULL && cat_ssl_is_ktls_recv_enabled(socket_i->ssl);
+}
 #endif
 
 // TODO: internal version APIs
@@ -4982,6 +7725,14 @@ CAT_API cat_errno_t cat_socket_get_connection_error(const cat_socket_t *socket)
     CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return CAT_EBADF);
     CAT_SOCKET_INTERNAL_FD_GETTER_SILENT(socket_i, fd, return CAT_EBADF);
     CAT_SOCKET_INTERNAL_SSL_LIVENESS_FAST_CHECK(socket_i, return 0);
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    do {
+        cat_errno_t error = cat_socket_internal_io_uring_get_connection_error(socket_i);
+        if (error != CAT_EAGAIN) {
+            return error;
+        }
+    } while (0);
+#endif
 
     return cat_socket_check_liveness_by_fd(fd);
 }
@@ -4993,7 +7744,14 @@ CAT_API cat_bool_t cat_socket_check_liveness(const cat_socket_t *socket)
     CAT_SOCKET_INTERNAL_SSL_LIVENESS_FAST_CHECK(socket_i, return cat_true);
     cat_errno_t error;
 
-    error = cat_socket_check_liveness_by_fd(fd);
+    error = socket_i->cache.read_error;
+    if (error == 0) {
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+        error = cat_socket_internal_io_uring_get_connection_error(socket_i);
+        if (error == CAT_EAGAIN)
+#endif
+        error = cat_socket_check_liveness_by_fd(fd);
+    }
 
     if (unlikely(error != 0)) {
         /* there was an unrecoverable error */
@@ -5304,6 +8062,281 @@ CAT_API cat_bool_t cat_socket_set_udp_broadcast(cat_socket_t *socket, cat_bool_t
     return cat_true;
 }
 
+CAT_API cat_bool_t cat_socket_get_write_coalescing(const cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER_SILENT(socket, socket_i, return cat_false);
+
+    return !!(socket_i->option_flags & CAT_SOCKET_OPTION_FLAG_WRITE_COALESCING);
+}
+
+CAT_API cat_bool_t cat_socket_set_write_coalescing(cat_socket_t *socket, cat_bool_t enable)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    CAT_SOCKET_INTERNAL_WHICH_ONLY(socket_i, CAT_SOCKET_TYPE_FLAG_STREAM, "Socket should be type of stream", return cat_false);
+
+    CAT_SOCKET_INTERNAL_SET_FLAG(socket_i, WRITE_COALESCING, enable);
+    if (!enable) {
+        /* do not let queued writes wait for the in-flight ones */
+        cat_socket_internal_write_batch_submit(socket_i);
+    }
+
+    return cat_true;
+}
+
+static cat_bool_t cat_socket_internal_set_reuseport_cpu_affinity(cat_socket_internal_t *socket_i, uint32_t group_size)
+{
+#ifdef CAT_SOCKET_HAVE_REUSEPORT_CBPF
+    CAT_SOCKET_INTERNAL_FD_GETTER(socket_i, fd, return cat_false);
+
+    if (group_size == 0) {
+        long n = sysconf(_SC_NPROCESSORS_CONF);
+        group_size = n > 0 ? (uint32_t) n : 1;
+    }
+    /* A = raw_smp_processor_id() % group_size; return A;
+     * kernel falls back to hash if A is out of range of the group */
+    struct sock_filter code[] = {
+        { BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t) (SKF_AD_OFF + SKF_AD_CPU) },
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, group_size },
+        { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    struct sock_fprog program;
+    program.len = sizeof(code) / sizeof(code[0]);
+    program.filter = code;
+    if (unlikely(setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) != 0)) {
+        cat_update_last_error_of_syscall("Socket attach reuseport CPU affinity program failed");
+        return cat_false;
+    }
+
+    return cat_true;
+#else
+    (void) socket_i;
+    (void) group_size;
+    cat_update_last_error(CAT_ENOTSUP, "Socket reuseport CPU affinity is not supported on this platform");
+    return cat_false;
+#endif
+}
+
+#ifdef CAT_SOCKET_HAVE_REUSEPORT_INCOMING_CPU
+/* since Linux 6.2, reuseport selection prefers the listener whose SO_INCOMING_CPU is the receiving CPU
+ * (if there is no reuseport program or the program returns an index out of range) */
+static cat_bool_t cat_socket_reuseport_incoming_cpu_is_supported(void)
+{
+    static int supported = -1;
+
+    if (unlikely(supported < 0)) {
+        struct utsname name;
+        unsigned int major = 0, minor = 0;
+        supported = uname(&name) == 0 &&
+            sscanf(name.release, "%u.%u", &major, &minor) == 2 &&
+            (major > 6 || (major == 6 && minor >= 2));
+    }
+
+    return supported;
+}
+
+/* returns the CPU if current thread is bound to exactly one CPU, otherwise -1 */
+static int cat_socket_get_bound_cpu(void)
+{
+    cpu_set_t set;
+    int cpu;
+
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0 || CPU_COUNT(&set) != 1) {
+        return -1;
+    }
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) {
+            return cpu;
+        }
+    }
+
+    return -1;
+}
+#endif
+
+/* index of listener in the reuseport group is not stable, kernel moves the last member
+ * into the slot of the removed one, so the index based program would dispatch connections
+ * of the CPU to the wrong listener after a member left the group,
+ * if we know which CPU the listener serves (thread is bound to one CPU) and kernel supports it,
+ * we let kernel match the receiving CPU with SO_INCOMING_CPU of listeners instead */
+static cat_bool_t cat_socket_internal_enable_reuseport_cpu_affinity(cat_socket_internal_t *socket_i)
+{
+#ifdef CAT_SOCKET_HAVE_REUSEPORT_INCOMING_CPU
+    int cpu;
+
+    if (cat_socket_reuseport_incoming_cpu_is_supported() && (cpu = cat_socket_get_bound_cpu()) >= 0) {
+        CAT_SOCKET_INTERNAL_FD_GETTER(socket_i, fd, return cat_false);
+        if (unlikely(setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) != 0)) {
+            cat_update_last_error_of_syscall("Socket set incoming CPU to %d failed", cpu);
+            return cat_false;
+        }
+        return cat_true;
+    }
+#endif
+
+    return cat_socket_internal_set_reuseport_cpu_affinity(socket_i, 0);
+}
+
+CAT_API cat_bool_t cat_socket_set_reuseport_cpu_affinity(cat_socket_t *socket, uint32_t group_size)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    CAT_SOCKET_INTERNAL_WHICH_ONLY(socket_i, CAT_SOCKET_TYPE_FLAG_INET, "Socket should be type of inet", return cat_false);
+
+    return cat_socket_internal_set_reuseport_cpu_affinity(socket_i, group_size);
+}
+
+CAT_API int cat_socket_get_incoming_cpu(const cat_socket_t *socket)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return -1);
+#ifdef SO_INCOMING_CPU
+    CAT_SOCKET_INTERNAL_FD_GETTER(socket_i, fd, return -1);
+    int cpu = -1;
+    socklen_t length = sizeof(cpu);
+
+    if (unlikely(getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &length) != 0)) {
+        cat_update_last_error_of_syscall("Socket get incoming CPU failed");
+        return -1;
+    }
+
+    return cpu;
+#else
+    cat_update_last_error(CAT_ENOTSUP, "Socket incoming CPU is not supported on this platform");
+    return -1;
+#endif
+}
+
+CAT_API cat_bool_t cat_socket_set_incoming_cpu(cat_socket_t *socket, int cpu)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+#ifdef SO_INCOMING_CPU
+    CAT_SOCKET_INTERNAL_FD_GETTER(socket_i, fd, return cat_false);
+
+    if (unlikely(setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) != 0)) {
+        cat_update_last_error_of_syscall("Socket set incoming CPU to %d failed", cpu);
+        return cat_false;
+    }
+
+    return cat_true;
+#else
+    cat_update_last_error(CAT_ENOTSUP, "Socket incoming CPU is not supported on this platform");
+    return cat_false;
+#endif
+}
+
+#ifdef __linux__
+/* read system-wide TcpExt ListenOverflows and ListenDrops counters from /proc/net/netstat */
+static void cat_socket_get_listen_drop_counters(uint64_t *overflows, uint64_t *drops)
+{
+    const size_t size = 16 * 1024;
+    char *buffer, *names, *values, *end;
+    size_t length = 0;
+    ssize_t n;
+    int fd;
+
+    fd = open("/proc/net/netstat", O_RDONLY | O_CLOEXEC);
+    if (unlikely(fd < 0)) {
+        return;
+    }
+    buffer = (char *) cat_malloc(size);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(buffer == NULL)) {
+        (void) close(fd);
+        return;
+    }
+#endif
+    while (length < size - 1) {
+        n = read(fd, buffer + length, size - 1 - length);
+        if (n <= 0) {
+            break;
+        }
+        length += n;
+    }
+    (void) close(fd);
+    buffer[length] = '\0';
+
+    /* the first TcpExt line contains names, the second one contains values */
+    names = strstr(buffer, "TcpExt:");
+    values = names != NULL ? strstr(names + CAT_STRLEN("TcpExt:"), "TcpExt:") : NULL;
+    if (values != NULL) {
+        names += CAT_STRLEN("TcpExt:");
+        values += CAT_STRLEN("TcpExt:");
+        while (1) {
+            uint64_t value;
+            while (*names == ' ') {
+                names++;
+            }
+            end = names + strcspn(names, " \n");
+            if (end == names) {
+                break;
+            }
+            value = strtoull(values, &values, 10);
+            if ((size_t) (end - names) == CAT_STRLEN("ListenOverflows") && memcmp(names, "ListenOverflows", end - names) == 0) {
+                *overflows = value;
+            } else if ((size_t) (end - names) == CAT_STRLEN("ListenDrops") && memcmp(names, "ListenDrops", end - names) == 0) {
+                *drops = value;
+            }
+            names = end;
+        }
+    }
+
+    cat_free(buffer);
+}
+#endif
+
+CAT_API cat_bool_t cat_socket_get_accept_stats(const cat_socket_t *socket, cat_socket_accept_stats_t *stats)
+{
+    CAT_SOCKET_INTERNAL_GETTER(socket, socket_i, return cat_false);
+    if (unlikely(socket_i->accept_stats == NULL)) {
+        cat_update_last_error(CAT_EMISUSE, "Socket is not listening for connections");
+        return cat_false;
+    }
+
+    *stats = *socket_i->accept_stats;
+#if defined(__linux__) && defined(TCP_INFO)
+    if ((socket_i->type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP) {
+        CAT_SOCKET_INTERNAL_FD_GETTER_SILENT(socket_i, fd, return cat_true);
+        struct tcp_info info;
+        socklen_t length = sizeof(info);
+        /* for listening sockets, tcpi_unacked is the current length of accept queue, tcpi_sacked is the backlog */
+        if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &length) == 0) {
+            stats->queue_length = info.tcpi_unacked;
+            stats->queue_capacity = info.tcpi_sacked;
+        }
+        /* libuv may have accepted one in advance */
+        if (socket_i->u.stream.accepted_fd != -1) {
+            stats->queue_length++;
+        }
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+        /* and io_uring may have accepted some */
+        if (socket_i->io_uring != NULL) {
+            stats->queue_length += socket_i->io_uring->accept.count;
+        }
+#endif
+        cat_socket_get_listen_drop_counters(&stats->listen_overflows, &stats->listen_drops);
+    }
+#endif
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_socket_set_io_uring_enabled(cat_bool_t enabled)
+{
+    cat_bool_t original_enabled = CAT_SOCKET_G(io_uring.enabled);
+
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+    CAT_SOCKET_G(io_uring.enabled) = enabled;
+#else
+    (void) enabled;
+#endif
+
+    return original_enabled;
+}
+
+CAT_API cat_bool_t cat_socket_is_io_uring_enabled(void)
+{
+    return CAT_SOCKET_G(io_uring.enabled);
+}
+
 /* helper */
 
 CAT_API int cat_socket_get_local_free_port(void)
@@ -5423,7 +8456,9 @@ CAT_API cat_bool_t cat_pipe(cat_os_fd_t fds[2], cat_pipe_flags read_flags, cat_p
 
 /* for poll emulation */
 
-static cat_bool_t cat_socket_fd_has_accepted_fd(cat_socket_fd_t fd)
+/* connections, data or errors which have been taken from fd by us but not been read by user yet,
+ * kernel does not know them, so fd should be reported as readable by us */
+static cat_bool_t cat_socket_fd_has_pending_input(cat_socket_fd_t fd)
 {
     cat_socket_internal_t lookup;
     cat_socket_internal_t *socket_i;
@@ -5432,8 +8467,21 @@ static cat_bool_t cat_socket_fd_has_accepted_fd(cat_socket_fd_t fd)
     if (socket_i == NULL) {
         return cat_false;
     }
+    if (unlikely(socket_i->cache.read_error != 0)) {
+        return cat_true;
+    }
 #ifndef CAT_OS_WIN
     if (socket_i->type & CAT_SOCKET_TYPE_FLAG_STREAM) {
+#ifdef CAT_HAVE_IO_URING_MULTISHOT
+        const cat_socket_io_uring_t *engine = socket_i->io_uring;
+        if (engine != NULL && (
+            engine->accept.count > 0 ||
+            cat_socket_io_uring_get_recv_buffered_length(engine) > 0 ||
+            engine->recv.error != 0
+        )) {
+            return cat_true;
+        }
+#endif
         return socket_i->u.stream.accepted_fd != -1;
     }
 #else
@@ -5460,7 +8508,7 @@ static cat_ret_t cat_socket_poll_one_emulate(cat_os_socket_t fd, cat_pollfd_even
             return ret;
         }
     }
-    if ((events & POLLIN) && cat_socket_fd_has_accepted_fd(fd)) {
+    if ((events & POLLIN) && cat_socket_fd_has_pending_input(fd)) {
         *revents = POLLIN;
         return CAT_RET_OK;
     }
@@ -5480,7 +8528,7 @@ static int cat_socket_poll_emulate(cat_pollfd_t *fds, cat_nfds_t nfds)
     for (i = 0; i < nfds; i++) {
         cat_pollfd_t *fd = &fds[i];
         if ((fd->events & POLLIN) &&
-            cat_socket_fd_has_accepted_fd(fd->fd)) {
+            cat_socket_fd_has_pending_input(fd->fd)) {
             fd->revents = POLLIN;
             n++;
         }
@@ -17,6 +17,13 @@
  */
 
 #include "cat_ssl.h"
+#include "cat_event.h"
+#include "cat_time.h"
+#include "cat_fs.h" /* for ticket keys file */
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#endif
 
 #ifdef CAT_SSL
 /*
@@ -50,6 +57,9 @@ static void cat_ssl_handshake_log(cat_ssl_t *ssl);
 
 static int cat_ssl_index;
 static int cat_ssl_context_index;
+static int cat_ssl_session_store_index;
+
+CAT_API CAT_GLOBALS_DECLARE(cat_ssl);
 
 static cat_always_inline cat_ssl_t *cat_ssl_get_from_connection(const cat_ssl_connection_t *connection)
 {
@@ -63,6 +73,26 @@ static cat_always_inline cat_ssl_context_t *cat_ssl_context_get_from_ctx(const c
 }
 #endif
 
+static void cat_ssl_session_store_release(cat_ssl_session_store_t *store);
+
+static cat_always_inline cat_ssl_session_store_t *cat_ssl_session_store_get_from_ctx(const cat_ssl_ctx_t *ctx)
+{
+    return (cat_ssl_session_store_t *) SSL_CTX_get_ex_data(ctx, cat_ssl_session_store_index);
+}
+
+static void cat_ssl_session_store_free_callback(void *parent, void *ptr, CRYPTO_EX_DATA *ad, int index, long argl, void *argp)
+{
+    (void) parent;
+    (void) ad;
+    (void) index;
+    (void) argl;
+    (void) argp;
+
+    if (ptr != NULL) {
+        cat_ssl_session_store_release((cat_ssl_session_store_t *) ptr);
+    }
+}
+
 CAT_API cat_bool_t cat_ssl_module_init(void)
 {
 #ifdef CAT_DEBUG
@@ -112,6 +142,58 @@ CAT_API cat_bool_t cat_ssl_module_init(void)
         ERR_print_errors_fp(CAT_LOG_G(error_output));
         CAT_MODULE_ERROR(SSL, "SSL_CTX_get_ex_new_index() failed");
     }
+    /* SSL_CTX holds a reference of session store, it is released after all connections were freed */
+    cat_ssl_session_store_index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, cat_ssl_session_store_free_callback);
+    if (cat_ssl_session_store_index == -1) {
+        ERR_print_errors_fp(CAT_LOG_G(error_output));
+        CAT_MODULE_ERROR(SSL, "SSL_CTX_get_ex_new_index() failed");
+    }
+
+    CAT_GLOBALS_REGISTER(cat_ssl);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_ssl_module_shutdown(void)
+{
+    CAT_GLOBALS_UNREGISTER(cat_ssl);
+
+    return cat_true;
+}
+
+static void cat_ssl_runtime_shutdown_callback(cat_data_t *data)
+{
+    (void) data;
+    (void) cat_ssl_runtime_shutdown();
+}
+
+CAT_API cat_bool_t cat_ssl_runtime_init(void)
+{
+    cat_queue_init(&CAT_SSL_G(session_stores));
+    CAT_SSL_G(handshakes) = 0;
+    CAT_SSL_G(resumed) = 0;
+
+    if (unlikely(cat_event_register_runtime_shutdown_task(cat_ssl_runtime_shutdown_callback, NULL) == NULL)) {
+        cat_update_last_error_with_previous("SSL register runtime shutdown task failed");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_ssl_runtime_shutdown(void)
+{
+    cat_queue_t *stores = &CAT_SSL_G(session_stores);
+
+    /* stores may still be referenced by the contexts of alive connections,
+     * but they are unusable since now */
+    while (!cat_queue_empty(stores)) {
+        cat_ssl_session_store_t *store = cat_queue_front_data(stores, cat_ssl_session_store_t, node);
+        cat_queue_remove(&store->node);
+        (void) cat_ssl_session_cache_set_size(store, 0);
+        (void) cat_ssl_ticket_keys_set_file(store, NULL);
+        cat_ssl_session_store_release(store);
+    }
 
     return cat_true;
 }
@@ -692,6 +774,112 @@ CAT_API void cat_ssl_context_set_no_compression(cat_ssl_context_t *context)
     SSL_CTX_set_options(context->ctx, SSL_OP_NO_COMPRESSION);
 }
 
+CAT_API cat_bool_t cat_ssl_context_set_session_id_context(cat_ssl_context_t *context, const char *data, size_t length)
+{
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int md_length;
+
+    if (unlikely(EVP_Digest(data, length, md, &md_length, EVP_sha256(), NULL) == 0)) {
+        cat_ssl_update_last_error(CAT_ESSL, "EVP_Digest() failed");
+        return cat_false;
+    }
+    if (md_length > SSL_MAX_SID_CTX_LENGTH) {
+        md_length = SSL_MAX_SID_CTX_LENGTH;
+    }
+    if (unlikely(SSL_CTX_set_session_id_context(context->ctx, md, md_length) == 0)) {
+        cat_ssl_update_last_error(CAT_ESSL, "SSL_CTX_set_session_id_context() failed");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+CAT_API void cat_ssl_context_set_session_timeout(cat_ssl_context_t *context, long timeout)
+{
+    CAT_LOG_DEBUG(SSL, "SSL_CTX_set_timeout(%p, %ld)", context, timeout);
+    SSL_CTX_set_timeout(context->ctx, timeout);
+}
+
+static int cat_ssl_session_cache_new_callback(cat_ssl_connection_t *connection, SSL_SESSION *session);
+static SSL_SESSION *cat_ssl_session_cache_get_callback(
+    cat_ssl_connection_t *connection,
+#if OPENSSL_VERSION_NUMBER >= 0x10100003L
+    const
+#endif
+    unsigned char *id, int id_length, int *copy
+);
+static void cat_ssl_session_cache_remove_callback(cat_ssl_ctx_t *ctx, SSL_SESSION *session);
+
+static cat_bool_t cat_ssl_context_set_session_store(cat_ssl_context_t *context, cat_ssl_session_store_t *store)
+{
+    cat_ssl_session_store_t *original_store = cat_ssl_session_store_get_from_ctx(context->ctx);
+
+    if (original_store == store) {
+        return cat_true;
+    }
+    if (unlikely(SSL_CTX_set_ex_data(context->ctx, cat_ssl_session_store_index, store) == 0)) {
+        cat_ssl_update_last_error(CAT_ESSL, "SSL_CTX_set_ex_data() failed");
+        return cat_false;
+    }
+    CAT_REF_ADD(store);
+    if (original_store != NULL) {
+        cat_ssl_session_store_release(original_store);
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_ssl_context_enable_session_cache(cat_ssl_context_t *context, cat_ssl_session_store_t *store)
+{
+    cat_ssl_ctx_t *ctx = context->ctx;
+
+    if (unlikely(!cat_ssl_context_set_session_store(context, store))) {
+        return cat_false;
+    }
+    CAT_LOG_DEBUG(SSL, "SSL_CTX_set_session_cache_mode(%p, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL)", context);
+    /* contexts are usually temporary, so the internal cache of them is useless */
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(ctx, cat_ssl_session_cache_new_callback);
+    SSL_CTX_sess_set_get_cb(ctx, cat_ssl_session_cache_get_callback);
+    SSL_CTX_sess_set_remove_cb(ctx, cat_ssl_session_cache_remove_callback);
+
+    return cat_true;
+}
+
+static cat_bool_t cat_ssl_ticket_keys_check(cat_ssl_ticket_keys_t *keys);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+static int cat_ssl_ticket_key_callback(cat_ssl_connection_t *connection, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *ectx, EVP_MAC_CTX *hctx, int enc);
+#else
+static int cat_ssl_ticket_key_callback(cat_ssl_connection_t *connection, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *ectx, HMAC_CTX *hctx, int enc);
+#endif
+
+CAT_API cat_bool_t cat_ssl_context_enable_session_tickets(cat_ssl_context_t *context, cat_ssl_session_store_t *store)
+{
+    cat_ssl_ticket_keys_t *keys = &store->ticket_keys;
+
+    if (unlikely(!cat_ssl_context_set_session_store(context, store))) {
+        return cat_false;
+    }
+    if (keys->file != NULL) {
+        /* keep using the old keys if file is being rewritten */
+        (void) cat_ssl_ticket_keys_check(keys);
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (unlikely(SSL_CTX_set_tlsext_ticket_key_evp_cb(context->ctx, cat_ssl_ticket_key_callback) == 0)) {
+        cat_ssl_update_last_error(CAT_ESSL, "SSL_CTX_set_tlsext_ticket_key_evp_cb() failed");
+        return cat_false;
+    }
+#else
+    if (unlikely(SSL_CTX_set_tlsext_ticket_key_cb(context->ctx, cat_ssl_ticket_key_callback) == 0)) {
+        cat_ssl_update_last_error(CAT_ESSL, "SSL_CTX_set_tlsext_ticket_key_cb() failed");
+        return cat_false;
+    }
+#endif
+
+    return cat_true;
+}
+
 CAT_API cat_ssl_t *cat_ssl_create(cat_ssl_t *ssl, cat_ssl_context_t *context)
 {
     cat_ssl_connection_t *connection;
@@ -850,6 +1038,74 @@ CAT_API cat_bool_t cat_ssl_is_established(const cat_ssl_t *ssl)
     return ssl->flags & CAT_SSL_FLAG_HANDSHAKE_OK;
 }
 
+#ifdef CAT_SSL_HAVE_KTLS
+/* The kTLS BIO is only used for writing, reading still goes through the BIO pair,
+ * because records other than application data (e.g. TLSv1.3 NewSessionTicket, alerts)
+ * are delivered by kernel as control messages which can not be handled by libuv. */
+static void cat_ssl_ktls_complete(cat_ssl_t *ssl)
+{
+    cat_ssl_connection_t *connection = ssl->connection;
+    cat_ssl_bio_t *rbio = SSL_get_rbio(connection);
+
+    ssl->flags ^= CAT_SSL_FLAG_KTLS;
+    if (BIO_get_ktls_send(SSL_get_wbio(connection))) {
+        CAT_LOG_DEBUG(SSL, "SSL#(%p) kTLS send enabled", ssl);
+        ssl->flags |= CAT_SSL_FLAG_KTLS_SEND;
+        return;
+    }
+    /* kernel or cipher does not support it, fallback to BIO pair */
+    CAT_LOG_DEBUG(SSL, "SSL#(%p) kTLS send is unavailable", ssl);
+    BIO_up_ref(rbio);
+    SSL_set0_wbio(connection, rbio);
+}
+#endif
+
+CAT_API cat_bool_t cat_ssl_enable_ktls(cat_ssl_t *ssl, cat_os_socket_t fd)
+{
+#ifdef CAT_SSL_HAVE_KTLS
+    cat_ssl_connection_t *connection = ssl->connection;
+    cat_ssl_bio_t *bio;
+
+    if (unlikely(ssl->flags & (CAT_SSL_FLAG_HANDSHAKE_OK | CAT_SSL_FLAG_KTLS))) {
+        cat_update_last_error(CAT_EMISUSE, "SSL kTLS must be enabled before handshake");
+        return cat_false;
+    }
+    bio = BIO_new_socket(fd, BIO_NOCLOSE);
+    if (unlikely(bio == NULL)) {
+        cat_ssl_update_last_error(CAT_ESSL, "BIO_new_socket() failed");
+        return cat_false;
+    }
+    CAT_LOG_DEBUG(SSL, "SSL_set_options(%p, SSL_OP_ENABLE_KTLS)", ssl);
+    SSL_set_options(connection, SSL_OP_ENABLE_KTLS);
+    /* drops the wbio reference of the BIO pair, it is still held as rbio */
+    SSL_set0_wbio(connection, bio);
+    ssl->flags |= CAT_SSL_FLAG_KTLS;
+
+    return cat_true;
+#else
+    (void) ssl;
+    (void) fd;
+    cat_update_last_error(CAT_ENOTSUP, "SSL kTLS is not supported");
+    return cat_false;
+#endif
+}
+
+CAT_API cat_bool_t cat_ssl_is_ktls_send_enabled(const cat_ssl_t *ssl)
+{
+    return !!(ssl->flags & CAT_SSL_FLAG_KTLS_SEND);
+}
+
+CAT_API cat_bool_t cat_ssl_is_ktls_recv_enabled(const cat_ssl_t *ssl)
+{
+#ifdef CAT_SSL_HAVE_KTLS
+    /* records are always read through the BIO pair for now, but ask the BIO to report the truth */
+    return !!BIO_get_ktls_recv(SSL_get_rbio(ssl->connection));
+#else
+    (void) ssl;
+    return cat_false;
+#endif
+}
+
 CAT_API cat_ssl_ret_t cat_ssl_handshake(cat_ssl_t *ssl)
 {
     cat_ssl_connection_t *connection = ssl->connection;
@@ -878,12 +1134,29 @@ CAT_API cat_ssl_ret_t cat_ssl_handshake(cat_ssl_t *ssl)
 #endif
 #endif
 #endif
+#ifdef CAT_SSL_HAVE_KTLS
+        if (ssl->flags & CAT_SSL_FLAG_KTLS) {
+            cat_ssl_ktls_complete(ssl);
+        }
+#endif
+        if (SSL_is_server(connection)) {
+            CAT_SSL_G(handshakes)++;
+            if (SSL_session_reused(connection)) {
+                CAT_SSL_G(resumed)++;
+            }
+        }
         CAT_LOG_DEBUG(SSL, "SSL handshake succeeded");
         return CAT_SSL_RET_OK;
     }
 
     int error = cat_ssl_get_error(ssl, n);
 
+#ifdef CAT_SSL_HAVE_KTLS
+    if (error == SSL_ERROR_WANT_WRITE && (ssl->flags & CAT_SSL_FLAG_KTLS)) {
+        CAT_LOG_DEBUG(SSL, "SSL_ERROR_WANT_WRITE");
+        return CAT_SSL_RET_WANT_WRITE;
+    }
+#endif
     if (error == SSL_ERROR_WANT_WRITE) {
         fprintf(stderr, "SSL handshake should never return SSL_ERROR_WANT_WRITE with BIO mode.");
         abort();
@@ -1161,11 +1434,19 @@ static cat_bool_t cat_ssl_encrypt_buffered(cat_ssl_t *ssl, const char *in, size_
         if (unlikely(n <= 0)) {
             int error = cat_ssl_get_error(ssl, n);
 
+#ifdef CAT_SSL_HAVE_KTLS
+            if (unlikely(error == SSL_ERROR_WANT_WRITE && (ssl->flags & CAT_SSL_FLAG_KTLS_SEND))) {
+                /* plain data is written to the socket directly in kTLS mode, SSL_write() is not expected here */
+                cat_update_last_error(CAT_EINVAL, "SSL_write() want write on kTLS connection");
+                break;
+            }
+#endif
             if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
                 CAT_LOG_DEBUG(SSL, "SSL_write(%p) want %s", ssl, error == SSL_ERROR_WANT_READ ? "read" : "write");
                 // continue to  SSL_read_encrypted_bytes()
             } else if (error == SSL_ERROR_SYSCALL) {
                 cat_update_last_error_of_syscall("SSL_write() error");
+                cat_ssl_unrecoverable_error(ssl);
                 break;
             } else {
                 if (error != SSL_ERROR_ZERO_RETURN) {
@@ -1290,6 +1571,9 @@ CAT_API cat_bool_t cat_ssl_decrypt(cat_ssl_t *ssl, char *out, size_t *out_length
 
     *out_length = 0;
     *eof = cat_false;
+#ifdef CAT_SSL_HAVE_KTLS
+    ssl->flags &= ~CAT_SSL_FLAG_KTLS_WANT_WRITE;
+#endif
 
     while (1) {
         int n;
@@ -1323,6 +1607,16 @@ CAT_API cat_bool_t cat_ssl_decrypt(cat_ssl_t *ssl, char *out, size_t *out_length
         if (unlikely(n <= 0)) {
             int error = cat_ssl_get_error(ssl, n);
 
+#ifdef CAT_SSL_HAVE_KTLS
+            if (error == SSL_ERROR_WANT_WRITE && (ssl->flags & CAT_SSL_FLAG_KTLS_SEND)) {
+                /* SSL_read() wrote records (alert, KeyUpdate) to the socket directly and it is not writable,
+                 * caller should wait for socket writable then call us again to flush them */
+                CAT_LOG_DEBUG(SSL, "SSL_read(%p) want write to socket", ssl);
+                ssl->flags |= CAT_SSL_FLAG_KTLS_WANT_WRITE;
+                ret = cat_true;
+                break;
+            }
+#endif
             if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
                 CAT_LOG_DEBUG(SSL, "SSL_read(%p) want %s", ssl, error == SSL_ERROR_WANT_READ ? "read" : "write");
                 // continue to SSL_write_encrypted_bytes()
@@ -1334,6 +1628,7 @@ CAT_API cat_bool_t cat_ssl_decrypt(cat_ssl_t *ssl, char *out, size_t *out_length
                 break;
             } else if (error == SSL_ERROR_SYSCALL) {
                 cat_update_last_error_of_syscall("SSL_read() error");
+                cat_ssl_unrecoverable_error(ssl);
                 break;
             } else {
                 cat_ssl_update_last_error(CAT_ESSL, "SSL_read() error");
@@ -1413,6 +1708,589 @@ CAT_API cat_ssl_ret_t cat_ssl_shutdown(cat_ssl_t *ssl)
 }
 #endif
 
+/* session resumption */
+
+struct cat_ssl_session_cache_entry_s {
+    /* hash chain */
+    cat_ssl_session_cache_entry_t *next;
+    /* lru node */
+    cat_queue_node_t node;
+    uint32_t hash;
+    unsigned int id_length;
+    unsigned char id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+    cat_msec_t expire;
+    /* DER encoded session */
+    size_t length;
+    unsigned char data[1];
+};
+
+static uint32_t cat_ssl_session_cache_hash(const unsigned char *id, unsigned int id_length)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    unsigned int n;
+
+    for (n = 0; n < id_length; n++) {
+        hash ^= id[n];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static cat_ssl_session_cache_entry_t **cat_ssl_session_cache_bucket(cat_ssl_session_cache_t *cache, uint32_t hash)
+{
+    return &cache->buckets[hash & (cache->bucket_count - 1)];
+}
+
+static cat_bool_t cat_ssl_session_cache_resize(cat_ssl_session_cache_t *cache, size_t max_size)
+{
+    cat_ssl_session_cache_entry_t **buckets, *entry, *next;
+    size_t bucket_count = 16, n;
+
+    while (bucket_count < max_size) {
+        bucket_count <<= 1;
+    }
+    if (bucket_count == cache->bucket_count) {
+        return cat_true;
+    }
+    buckets = (cat_ssl_session_cache_entry_t **) cat_malloc(sizeof(*buckets) * bucket_count);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(buckets == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for SSL session cache buckets failed");
+        return cat_false;
+    }
+#endif
+    memset(buckets, 0, sizeof(*buckets) * bucket_count);
+    for (n = 0; n < cache->bucket_count; n++) {
+        for (entry = cache->buckets[n]; entry != NULL; entry = next) {
+            next = entry->next;
+            entry->next = buckets[entry->hash & (bucket_count - 1)];
+            buckets[entry->hash & (bucket_count - 1)] = entry;
+        }
+    }
+    if (cache->buckets != NULL) {
+        cat_free(cache->buckets);
+    }
+    cache->buckets = buckets;
+    cache->bucket_count = bucket_count;
+
+    return cat_true;
+}
+
+static void cat_ssl_session_cache_unlink(cat_ssl_session_cache_t *cache, cat_ssl_session_cache_entry_t *entry)
+{
+    cat_ssl_session_cache_entry_t **p = cat_ssl_session_cache_bucket(cache, entry->hash);
+
+    while (*p != entry) {
+        p = &(*p)->next;
+    }
+    *p = entry->next;
+    cat_queue_remove(&entry->node);
+    cache->size--;
+    OPENSSL_cleanse(entry->data, entry->length);
+    cat_free(entry);
+}
+
+static void cat_ssl_session_cache_evict(cat_ssl_session_cache_t *cache)
+{
+    while (cache->size > cache->max_size) {
+        cat_ssl_session_cache_entry_t *entry = cat_queue_back_data(&cache->lru, cat_ssl_session_cache_entry_t, node);
+        cat_ssl_session_cache_unlink(cache, entry);
+        cache->evictions++;
+    }
+}
+
+static cat_ssl_session_cache_entry_t *cat_ssl_session_cache_find(cat_ssl_session_cache_t *cache, const unsigned char *id, unsigned int id_length, uint32_t hash)
+{
+    cat_ssl_session_cache_entry_t *entry;
+
+    if (cache->buckets == NULL) {
+        return NULL;
+    }
+    for (entry = *cat_ssl_session_cache_bucket(cache, hash); entry != NULL; entry = entry->next) {
+        if (entry->hash == hash &&
+            entry->id_length == id_length &&
+            memcmp(entry->id, id, id_length) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static int cat_ssl_session_cache_new_callback(cat_ssl_connection_t *connection, SSL_SESSION *session)
+{
+    cat_ssl_session_cache_t *cache = &cat_ssl_session_store_get_from_ctx(SSL_get_SSL_CTX(connection))->cache;
+    cat_ssl_session_cache_entry_t *entry;
+    const unsigned char *id;
+    unsigned int id_length;
+    unsigned char *p;
+    uint32_t hash;
+    int length;
+
+    if (cache->max_size == 0) {
+        return 0;
+    }
+    length = i2d_SSL_SESSION(session, NULL);
+    if (unlikely(length <= 0)) {
+        return 0;
+    }
+    id = SSL_SESSION_get_id(session, &id_length);
+    if (unlikely(id_length == 0 || id_length > SSL_MAX_SSL_SESSION_ID_LENGTH)) {
+        return 0;
+    }
+    hash = cat_ssl_session_cache_hash(id, id_length);
+    entry = cat_ssl_session_cache_find(cache, id, id_length, hash);
+    if (entry != NULL) {
+        cat_ssl_session_cache_unlink(cache, entry);
+    }
+    if (cache->buckets == NULL && unlikely(!cat_ssl_session_cache_resize(cache, cache->max_size))) {
+        return 0;
+    }
+    entry = (cat_ssl_session_cache_entry_t *) cat_malloc(offsetof(cat_ssl_session_cache_entry_t, data) + length);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(entry == NULL)) {
+        return 0;
+    }
+#endif
+    p = entry->data;
+    entry->length = (size_t) i2d_SSL_SESSION(session, &p);
+    entry->hash = hash;
+    entry->id_length = id_length;
+    memcpy(entry->id, id, id_length);
+    entry->expire = cat_time_msec_cached() + (cat_msec_t) SSL_SESSION_get_timeout(session) * 1000;
+    entry->next = *cat_ssl_session_cache_bucket(cache, hash);
+    *cat_ssl_session_cache_bucket(cache, hash) = entry;
+    cat_queue_push_front(&cache->lru, &entry->node);
+    cache->size++;
+    cat_ssl_session_cache_evict(cache);
+    CAT_LOG_DEBUG(SSL, "SSL session cache added (size: %zu)", cache->size);
+
+    /* we do not hold the reference of session */
+    return 0;
+}
+
+static SSL_SESSION *cat_ssl_session_cache_get_callback(
+    cat_ssl_connection_t *connection,
+#if OPENSSL_VERSION_NUMBER >= 0x10100003L
+    const
+#endif
+    unsigned char *id, int id_length, int *copy
+)
+{
+    cat_ssl_session_cache_t *cache = &cat_ssl_session_store_get_from_ctx(SSL_get_SSL_CTX(connection))->cache;
+    cat_ssl_session_cache_entry_t *entry;
+    const unsigned char *p;
+    SSL_SESSION *session;
+
+    *copy = 0;
+
+    entry = cat_ssl_session_cache_find(cache, id, (unsigned int) id_length, cat_ssl_session_cache_hash(id, (unsigned int) id_length));
+    if (entry == NULL) {
+        cache->misses++;
+        return NULL;
+    }
+    if (entry->expire <= cat_time_msec_cached()) {
+        cat_ssl_session_cache_unlink(cache, entry);
+        cache->timeouts++;
+        cache->misses++;
+        return NULL;
+    }
+    p = entry->data;
+    session = d2i_SSL_SESSION(NULL, &p, (long) entry->length);
+    if (unlikely(session == NULL)) {
+        cat_ssl_session_cache_unlink(cache, entry);
+        cache->misses++;
+        return NULL;
+    }
+    cat_queue_remove(&entry->node);
+    cat_queue_push_front(&cache->lru, &entry->node);
+    cache->hits++;
+
+    return session;
+}
+
+static void cat_ssl_session_cache_remove_callback(cat_ssl_ctx_t *ctx, SSL_SESSION *session)
+{
+    cat_ssl_session_cache_t *cache = &cat_ssl_session_store_get_from_ctx(ctx)->cache;
+    cat_ssl_session_cache_entry_t *entry;
+    const unsigned char *id;
+    unsigned int id_length;
+
+    id = SSL_SESSION_get_id(session, &id_length);
+    entry = cat_ssl_session_cache_find(cache, id, id_length, cat_ssl_session_cache_hash(id, id_length));
+    if (entry != NULL) {
+        cat_ssl_session_cache_unlink(cache, entry);
+    }
+}
+
+CAT_API cat_ssl_session_store_t *cat_ssl_session_store_get(const char *data, size_t length)
+{
+    cat_ssl_session_store_t *store;
+    cat_ssl_session_cache_t *cache;
+    cat_ssl_ticket_keys_t *keys;
+    int max_size;
+    unsigned char id[sizeof(store->id)];
+    unsigned int id_length;
+
+    if (unlikely(EVP_Digest(data, length, id, &id_length, EVP_sha256(), NULL) == 0)) {
+        cat_ssl_update_last_error(CAT_ESSL, "EVP_Digest() failed");
+        return NULL;
+    }
+    CAT_ASSERT(id_length == sizeof(id));
+    CAT_QUEUE_FOREACH_DATA_START(&CAT_SSL_G(session_stores), cat_ssl_session_store_t, node, store) {
+        if (memcmp(store->id, id, sizeof(id)) == 0) {
+            return store;
+        }
+    } CAT_QUEUE_FOREACH_DATA_END();
+
+    store = (cat_ssl_session_store_t *) cat_malloc(sizeof(*store));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(store == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for SSL session store failed");
+        return NULL;
+    }
+#endif
+    CAT_REF_INIT(store);
+    memcpy(store->id, id, sizeof(id));
+    cache = &store->cache;
+    cache->buckets = NULL;
+    cache->bucket_count = 0;
+    cat_queue_init(&cache->lru);
+    cache->size = 0;
+    max_size = cat_env_get_i("CAT_SSL_SESSION_CACHE_SIZE", CAT_SSL_SESSION_CACHE_DEFAULT_SIZE);
+    if (max_size < 0) {
+        /* 0 means disabled */
+        max_size = 0;
+    }
+    cache->max_size = (size_t) max_size;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->timeouts = 0;
+    cache->evictions = 0;
+    keys = &store->ticket_keys;
+    keys->count = 0;
+    keys->file = NULL;
+    keys->file_checked = 0;
+    keys->file_mtime = 0;
+    keys->file_size = 0;
+    keys->rotation = (cat_msec_t) cat_env_get_i("CAT_SSL_TICKET_KEY_ROTATION", CAT_SSL_TICKET_KEY_DEFAULT_ROTATION) * 1000;
+    keys->rotated = 0;
+    keys->issued = 0;
+    keys->decrypted = 0;
+    keys->renewed = 0;
+    keys->unknown = 0;
+    cat_queue_push_back(&CAT_SSL_G(session_stores), &store->node);
+
+    return store;
+}
+
+static void cat_ssl_session_store_release(cat_ssl_session_store_t *store)
+{
+    if (CAT_REF_DEL(store) != 0) {
+        return;
+    }
+    (void) cat_ssl_session_cache_set_size(store, 0);
+    (void) cat_ssl_ticket_keys_set_file(store, NULL);
+    cat_free(store);
+}
+
+CAT_API size_t cat_ssl_session_cache_set_size(cat_ssl_session_store_t *store, size_t max_size)
+{
+    cat_ssl_session_cache_t *cache = &store->cache;
+    size_t original_max_size = cache->max_size;
+
+    if (max_size == original_max_size) {
+        return original_max_size;
+    }
+    cache->max_size = max_size;
+    if (max_size == 0) {
+        (void) cat_ssl_session_cache_flush(store);
+        if (cache->buckets != NULL) {
+            cat_free(cache->buckets);
+            cache->buckets = NULL;
+            cache->bucket_count = 0;
+        }
+    } else {
+        cat_ssl_session_cache_evict(cache);
+        if (cache->buckets != NULL) {
+            (void) cat_ssl_session_cache_resize(cache, max_size);
+        }
+    }
+
+    return original_max_size;
+}
+
+CAT_API size_t cat_ssl_session_cache_flush(cat_ssl_session_store_t *store)
+{
+    cat_ssl_session_cache_t *cache = &store->cache;
+    size_t count = cache->size;
+
+    while (!cat_queue_empty(&cache->lru)) {
+        cat_ssl_session_cache_unlink(cache, cat_queue_front_data(&cache->lru, cat_ssl_session_cache_entry_t, node));
+    }
+
+    return count;
+}
+
+static cat_bool_t cat_ssl_ticket_keys_generate(cat_ssl_ticket_keys_t *keys)
+{
+    cat_ssl_ticket_key_t key;
+
+    key.size = sizeof(key.aes_key);
+    if (unlikely(RAND_bytes(key.name, sizeof(key.name)) != 1 ||
+                 RAND_bytes(key.hmac_key, sizeof(key.hmac_key)) != 1 ||
+                 RAND_bytes(key.aes_key, sizeof(key.aes_key)) != 1)) {
+        cat_ssl_update_last_error(CAT_ESSL, "RAND_bytes() failed");
+        OPENSSL_cleanse(&key, sizeof(key));
+        return cat_false;
+    }
+    /* the previous one is kept to decrypt tickets which were issued before rotation */
+    keys->keys[1] = keys->keys[0];
+    keys->keys[0] = key;
+    keys->count = keys->count == 0 ? 1 : 2;
+    OPENSSL_cleanse(&key, sizeof(key));
+    CAT_LOG_DEBUG(SSL, "SSL ticket keys rotated");
+
+    return cat_true;
+}
+
+static cat_bool_t cat_ssl_ticket_keys_load(cat_ssl_ticket_keys_t *keys, const char *file)
+{
+    unsigned char buffer[CAT_SSL_TICKET_KEY_FILE_ENTRY_SIZE * CAT_SSL_TICKET_KEY_MAX_COUNT + 1];
+    cat_ssl_ticket_key_t *key;
+    size_t entry_size, count, n;
+    cat_file_t fd;
+    ssize_t nread;
+
+    fd = cat_fs_open(file, CAT_FS_OPEN_FLAG_RDONLY);
+    if (unlikely(fd < 0)) {
+        cat_update_last_error_with_previous("SSL open ticket keys file \"%s\" failed", file);
+        return cat_false;
+    }
+    nread = cat_fs_read(fd, buffer, sizeof(buffer));
+    (void) cat_fs_close(fd);
+    if (unlikely(nread < 0)) {
+        cat_update_last_error_with_previous("SSL read ticket keys file \"%s\" failed", file);
+        return cat_false;
+    }
+    if (nread != 0 && nread % CAT_SSL_TICKET_KEY_FILE_ENTRY_SIZE == 0) {
+        entry_size = CAT_SSL_TICKET_KEY_FILE_ENTRY_SIZE;
+    } else if (nread != 0 && nread % CAT_SSL_TICKET_KEY_FILE_ENTRY_SIZE_AES128 == 0) {
+        entry_size = CAT_SSL_TICKET_KEY_FILE_ENTRY_SIZE_AES128;
+    } else {
+        cat_update_last_error(CAT_EINVAL, "SSL ticket keys file \"%s\" size must be a multiple of %u or %u bytes",
+            file, CAT_SSL_TICKET_KEY_FILE_ENTRY_SIZE, CAT_SSL_TICKET_KEY_FILE_ENTRY_SIZE_AES128);
+        goto _error;
+    }
+    count = (size_t) nread / entry_size;
+    if (unlikely(count > CAT_SSL_TICKET_KEY_MAX_COUNT)) {
+        cat_update_last_error(CAT_EINVAL, "SSL ticket keys file \"%s\" contains too many keys (max %u)",
+            file, CAT_SSL_TICKET_KEY_MAX_COUNT);
+        goto _error;
+    }
+    /* name (16 bytes), HMAC key (32 or 16 bytes), AES key (32 or 16 bytes) */
+    for (n = 0; n < count; n++) {
+        const unsigned char *entry = buffer + n * entry_size;
+        size_t size = (entry_size - CAT_SSL_TICKET_KEY_NAME_SIZE) / 2;
+        key = &keys->keys[n];
+        key->size = size;
+        memcpy(key->name, entry, CAT_SSL_TICKET_KEY_NAME_SIZE);
+        memcpy(key->hmac_key, entry + CAT_SSL_TICKET_KEY_NAME_SIZE, size);
+        memcpy(key->aes_key, entry + CAT_SSL_TICKET_KEY_NAME_SIZE + size, size);
+    }
+    OPENSSL_cleanse(keys->keys + count, sizeof(keys->keys[0]) * (keys->count > count ? keys->count - count : 0));
+    keys->count = count;
+    OPENSSL_cleanse(buffer, sizeof(buffer));
+    CAT_LOG_DEBUG(SSL, "SSL ticket keys loaded from \"%s\" (count: %zu)", file, count);
+
+    return cat_true;
+
+    _error:
+    OPENSSL_cleanse(buffer, sizeof(buffer));
+    return cat_false;
+}
+
+static cat_bool_t cat_ssl_ticket_keys_check(cat_ssl_ticket_keys_t *keys)
+{
+    cat_msec_t now = cat_time_msec_cached();
+    cat_stat_t statbuf;
+    int64_t mtime;
+
+    if (keys->count != 0 && now - keys->file_checked < 1000) {
+        return cat_true;
+    }
+    keys->file_checked = now;
+    if (unlikely(cat_fs_stat(keys->file, &statbuf) != 0)) {
+        cat_update_last_error_with_previous("SSL stat ticket keys file \"%s\" failed", keys->file);
+        return cat_false;
+    }
+    mtime = (int64_t) statbuf.st_mtim.tv_sec * 1000000000 + statbuf.st_mtim.tv_nsec;
+    if (keys->count != 0 && mtime == keys->file_mtime && statbuf.st_size == keys->file_size) {
+        return cat_true;
+    }
+    if (unlikely(!cat_ssl_ticket_keys_load(keys, keys->file))) {
+        return cat_false;
+    }
+    keys->file_mtime = mtime;
+    keys->file_size = statbuf.st_size;
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_ssl_ticket_keys_set_file(cat_ssl_session_store_t *store, const char *file)
+{
+    cat_ssl_ticket_keys_t *keys = &store->ticket_keys;
+    char *original_file = keys->file;
+
+    if (file != NULL && original_file != NULL && strcmp(file, original_file) == 0) {
+        (void) cat_ssl_ticket_keys_check(keys);
+        return keys->count != 0;
+    }
+    if (file != NULL) {
+        keys->file = cat_strdup(file);
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(keys->file == NULL)) {
+            keys->file = original_file;
+            cat_update_last_error_of_syscall("Malloc for SSL ticket keys file failed");
+            return cat_false;
+        }
+#endif
+        keys->count = 0;
+        if (unlikely(!cat_ssl_ticket_keys_check(keys))) {
+            cat_free(keys->file);
+            keys->file = original_file;
+            keys->file_checked = 0;
+            return cat_false;
+        }
+    } else {
+        keys->file = NULL;
+        OPENSSL_cleanse(keys->keys, sizeof(keys->keys));
+        keys->count = 0;
+    }
+    if (original_file != NULL) {
+        cat_free(original_file);
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_msec_t cat_ssl_ticket_keys_set_rotation(cat_ssl_session_store_t *store, cat_msec_t rotation)
+{
+    cat_msec_t original_rotation = store->ticket_keys.rotation;
+    store->ticket_keys.rotation = rotation;
+    return original_rotation;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+static int cat_ssl_ticket_key_callback(cat_ssl_connection_t *connection, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *ectx, EVP_MAC_CTX *hctx, int enc)
+#else
+static int cat_ssl_ticket_key_callback(cat_ssl_connection_t *connection, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *ectx, HMAC_CTX *hctx, int enc)
+#endif
+{
+    cat_ssl_ticket_keys_t *keys = &cat_ssl_session_store_get_from_ctx(SSL_get_SSL_CTX(connection))->ticket_keys;
+    const cat_ssl_ticket_key_t *key;
+    const EVP_CIPHER *cipher;
+    size_t n;
+
+    if (enc == 1) {
+        /* encrypt session ticket */
+        if (keys->file == NULL &&
+            (keys->count == 0 || cat_time_msec_cached() - keys->rotated >= keys->rotation)) {
+            if (unlikely(!cat_ssl_ticket_keys_generate(keys))) {
+                if (keys->count == 0) {
+                    return -1;
+                }
+            } else {
+                keys->rotated = cat_time_msec_cached();
+            }
+        }
+        if (unlikely(keys->count == 0)) {
+            /* do not issue ticket */
+            return 0;
+        }
+        n = 0;
+        key = &keys->keys[0];
+        cipher = key->size == 32 ? EVP_aes_256_cbc() : EVP_aes_128_cbc();
+        if (unlikely(RAND_bytes(iv, EVP_CIPHER_iv_length(cipher)) != 1)) {
+            return -1;
+        }
+        if (unlikely(EVP_EncryptInit_ex(ectx, cipher, NULL, key->aes_key, iv) != 1)) {
+            return -1;
+        }
+        memcpy(name, key->name, CAT_SSL_TICKET_KEY_NAME_SIZE);
+        keys->issued++;
+    } else {
+        /* decrypt session ticket */
+        for (n = 0; n < keys->count; n++) {
+            if (memcmp(name, keys->keys[n].name, CAT_SSL_TICKET_KEY_NAME_SIZE) == 0) {
+                break;
+            }
+        }
+        if (n == keys->count) {
+            CAT_LOG_DEBUG(SSL, "SSL ticket key was not found");
+            keys->unknown++;
+            return 0;
+        }
+        key = &keys->keys[n];
+        cipher = key->size == 32 ? EVP_aes_256_cbc() : EVP_aes_128_cbc();
+        if (unlikely(EVP_DecryptInit_ex(ectx, cipher, NULL, key->aes_key, iv) != 1)) {
+            return -1;
+        }
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    do {
+        OSSL_PARAM params[3];
+        params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, (void *) key->hmac_key, key->size);
+        params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char *) "SHA256", 0);
+        params[2] = OSSL_PARAM_construct_end();
+        if (unlikely(EVP_MAC_CTX_set_params(hctx, params) != 1)) {
+            return -1;
+        }
+    } while (0);
+#else
+    if (unlikely(HMAC_Init_ex(hctx, key->hmac_key, (int) key->size, EVP_sha256(), NULL) != 1)) {
+        return -1;
+    }
+#endif
+
+    if (enc == 1) {
+        return 1;
+    }
+    keys->decrypted++;
+    if (n != 0) {
+        /* ask for a new ticket which is encrypted by the current key */
+        keys->renewed++;
+        return 2;
+    }
+
+    return 1;
+}
+
+CAT_API void cat_ssl_get_session_stats(cat_ssl_session_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->handshakes = CAT_SSL_G(handshakes);
+    stats->resumed = CAT_SSL_G(resumed);
+    CAT_QUEUE_FOREACH_DATA_START(&CAT_SSL_G(session_stores), cat_ssl_session_store_t, node, store) {
+        cat_ssl_session_cache_t *cache = &store->cache;
+        cat_ssl_ticket_keys_t *keys = &store->ticket_keys;
+        stats->cache_size += cache->size;
+        stats->cache_max_size += cache->max_size;
+        stats->cache_hits += cache->hits;
+        stats->cache_misses += cache->misses;
+        stats->cache_timeouts += cache->timeouts;
+        stats->cache_evictions += cache->evictions;
+        stats->ticket_key_count += keys->count;
+        stats->ticket_issued += keys->issued;
+        stats->ticket_decrypted += keys->decrypted;
+        stats->ticket_renewed += keys->renewed;
+        stats->ticket_unknown += keys->unknown;
+    } CAT_QUEUE_FOREACH_DATA_END();
+}
+
 #ifdef CAT_ENABLE_DEBUG_LOG
 static const char *cat_ssl_error_to_str(int error)
 {
@@ -1556,7 +2434,8 @@ CAT_API CAT_COLD cat_bool_t cat_ssl_is_down(const cat_ssl_t *ssl)
 
 CAT_API CAT_COLD void cat_ssl_unrecoverable_error(cat_ssl_t *ssl)
 {
-    cat_ssl_set_shutdown(ssl, CAT_SSL_SENT_SHUTDOWN | CAT_SSL_RECEIVED_SHUTDOWN);
+    /* shutdown state is not set here, so that SSL_free() removes the session from cache */
+    ssl->flags |= CAT_SSL_FLAG_UNRECOVERABLE_ERROR;
 }
 
 static void cat_ssl_info_callback(const cat_ssl_connection_t *connection, int where, int ret)
@@ -1591,7 +2470,12 @@ static void cat_ssl_info_callback(const cat_ssl_connection_t *connection, int wh
             rbio = SSL_get_rbio(connection);
             wbio = SSL_get_wbio(connection);
 
-            if (rbio != wbio) {
+            if (rbio != wbio
+#ifdef CAT_SSL_HAVE_KTLS
+                /* socket BIO of kTLS is not a buffering BIO */
+                && BIO_method_type(wbio) != BIO_TYPE_SOCKET
+#endif
+            ) {
                 (void) BIO_set_write_buffer_size(wbio, CAT_SSL_BUFFER_SIZE);
                 ssl->flags |= CAT_SSL_FLAG_HANDSHAKE_BUFFER_SET;
             }
@@ -42,6 +42,40 @@ CAT_API const char *cat_strlchr(const char *s, const char *last, char c)
     return NULL;
 }
 
+/* Finds the first occurrence of the needle in the haystack,
+ * libc memmem() and memchr() are usually vectorized, so we prefer them. */
+CAT_API const char *cat_memmem(const char *haystack, size_t haystack_length, const char *needle, size_t needle_length)
+{
+    if (unlikely(needle_length == 0)) {
+        return haystack;
+    }
+    if (needle_length == 1) {
+        return (const char *) memchr(haystack, needle[0], haystack_length);
+    }
+#ifndef CAT_OS_WIN
+    return (const char *) memmem(haystack, haystack_length, needle, needle_length);
+#else
+    {
+        const char *p = haystack, *last = haystack + haystack_length - needle_length;
+
+        if (unlikely(haystack_length < needle_length)) {
+            return NULL;
+        }
+        while (p <= last) {
+            p = (const char *) memchr(p, needle[0], last - p + 1);
+            if (p == NULL) {
+                break;
+            }
+            if (memcmp(p + 1, needle + 1, needle_length - 1) == 0) {
+                return p;
+            }
+            p++;
+        }
+        return NULL;
+    }
+#endif
+}
+
 /* Copy a string returning a pointer to its end */
 CAT_API char *cat_stpcpy(char *dest, const char *src)
 {
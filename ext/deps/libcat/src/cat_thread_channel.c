@@ -0,0 +1,384 @@
+/*
+  +--------------------------------------------------------------------------+
+  | libcat                                                                   |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "cat_thread_channel.h"
+#include "cat_coroutine.h"
+#include "cat_event.h"
+#include "cat_time.h"
+
+#ifndef CAT_THREAD_CHANNEL_CACHE_LINE_SIZE
+#define CAT_THREAD_CHANNEL_CACHE_LINE_SIZE 64
+#endif
+
+/* cells of the bounded MPMC queue (Dmitry Vyukov's algorithm),
+ * sequence tells whether the cell is ready for the producer (== position)
+ * or the consumer (== position + 1) of the given position */
+typedef struct cat_thread_channel_cell_s {
+    cat_atomic_uint64_t sequence;
+    char data[1];
+} cat_thread_channel_cell_t;
+
+typedef struct cat_thread_channel_waiter_s {
+    cat_queue_node_t node;
+    cat_coroutine_t *coroutine;
+    cat_bool_t notified;
+} cat_thread_channel_waiter_t;
+
+struct cat_thread_channel_s {
+    /* producers and consumers work on different cache lines */
+    cat_atomic_uint64_t enqueue_position;
+    char padding1[CAT_THREAD_CHANNEL_CACHE_LINE_SIZE - sizeof(cat_atomic_uint64_t)];
+    cat_atomic_uint64_t dequeue_position;
+    char padding2[CAT_THREAD_CHANNEL_CACHE_LINE_SIZE - sizeof(cat_atomic_uint64_t)];
+    /* there are coroutines sleeping on it, the next producer should notify the owner */
+    cat_atomic_bool_t waiting;
+    cat_atomic_bool_t closed;
+    /* read-only after creation */
+    uint64_t mask;
+    size_t cell_size;
+    cat_channel_data_size_t data_size;
+    cat_channel_data_dtor_t dtor;
+    char *cells;
+    /* owner thread only */
+    cat_queue_t consumers;
+    union {
+        uv_handle_t handle;
+        uv_async_t async;
+    } u;
+};
+
+static cat_always_inline cat_thread_channel_cell_t *cat_thread_channel_get_cell(const cat_thread_channel_t *channel, uint64_t position)
+{
+    return (cat_thread_channel_cell_t *) (channel->cells + ((size_t) (position & channel->mask)) * channel->cell_size);
+}
+
+static cat_always_inline cat_bool_t cat_thread_channel__is_available(const cat_thread_channel_t *channel)
+{
+    return !cat_atomic_bool_load(&channel->closed);
+}
+
+static cat_always_inline cat_bool_t cat_thread_channel__is_empty(const cat_thread_channel_t *channel)
+{
+    uint64_t position = cat_atomic_uint64_load(&channel->dequeue_position);
+    cat_thread_channel_cell_t *cell = cat_thread_channel_get_cell(channel, position);
+
+    return (int64_t) (cat_atomic_uint64_load(&cell->sequence) - (position + 1)) < 0;
+}
+
+static cat_always_inline cat_bool_t cat_thread_channel_enqueue(cat_thread_channel_t *channel, const cat_data_t *data)
+{
+    uint64_t position = cat_atomic_uint64_load(&channel->enqueue_position);
+    cat_thread_channel_cell_t *cell;
+
+    while (1) {
+        int64_t diff;
+        cell = cat_thread_channel_get_cell(channel, position);
+        diff = (int64_t) (cat_atomic_uint64_load(&cell->sequence) - position);
+        if (diff == 0) {
+            /* cell is free, try to take it (position will be updated on failure) */
+            if (cat_atomic_uint64_compare_exchange_weak(&channel->enqueue_position, &position, position + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* full */
+            return cat_false;
+        } else {
+            /* another producer took it */
+            position = cat_atomic_uint64_load(&channel->enqueue_position);
+        }
+    }
+    memcpy(cell->data, data, channel->data_size);
+    cat_atomic_uint64_store(&cell->sequence, position + 1);
+
+    return cat_true;
+}
+
+static cat_always_inline cat_bool_t cat_thread_channel_dequeue(cat_thread_channel_t *channel, cat_data_t *data)
+{
+    uint64_t position = cat_atomic_uint64_load(&channel->dequeue_position);
+    cat_thread_channel_cell_t *cell;
+
+    while (1) {
+        int64_t diff;
+        cell = cat_thread_channel_get_cell(channel, position);
+        diff = (int64_t) (cat_atomic_uint64_load(&cell->sequence) - (position + 1));
+        if (diff == 0) {
+            /* cell is ready, try to take it (position will be updated on failure) */
+            if (cat_atomic_uint64_compare_exchange_weak(&channel->dequeue_position, &position, position + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* empty */
+            return cat_false;
+        } else {
+            /* another consumer took it */
+            position = cat_atomic_uint64_load(&channel->dequeue_position);
+        }
+    }
+    if (data != NULL) {
+        memcpy(data, cell->data, channel->data_size);
+        /* release the cell for the producer of the next round */
+        cat_atomic_uint64_store(&cell->sequence, position + channel->mask + 1);
+    } else {
+        /* the cell may be reused by others after released, so make a copy first */
+        char buffer[CAT_CHANNEL_DATA_SIZE_MAX];
+        memcpy(buffer, cell->data, channel->data_size);
+        cat_atomic_uint64_store(&cell->sequence, position + channel->mask + 1);
+        if (channel->dtor != NULL) {
+            channel->dtor(buffer);
+        }
+    }
+
+    return cat_true;
+}
+
+static cat_always_inline void cat_thread_channel_notify(cat_thread_channel_t *channel)
+{
+    /* only the first producer after consumers fell asleep sends the notification,
+     * uv_async_send() itself is also coalesced, but it always costs an atomic operation */
+    if (cat_atomic_bool_load(&channel->waiting) &&
+        cat_atomic_bool_exchange(&channel->waiting, cat_false)) {
+        (void) uv_async_send(&channel->u.async);
+    }
+}
+
+static void cat_thread_channel_wake_consumers(cat_thread_channel_t *channel, cat_bool_t all)
+{
+    cat_thread_channel_waiter_t *waiter;
+
+    while (1) {
+        /* consumers pop items immediately after resumed, so one item, one consumer */
+        while ((waiter = cat_queue_front_data(&channel->consumers, cat_thread_channel_waiter_t, node)) != NULL &&
+               (all || !cat_thread_channel__is_empty(channel))) {
+            cat_queue_remove(&waiter->node);
+            waiter->notified = cat_true;
+            cat_coroutine_schedule(waiter->coroutine, CHANNEL, "Thread channel consumer");
+        }
+        if (waiter == NULL) {
+            break;
+        }
+        /* still have waiters, ask producers to notify us again,
+         * and check it again in case of producers pushed before they saw the flag */
+        cat_atomic_bool_store(&channel->waiting, cat_true);
+        if (cat_thread_channel__is_empty(channel)) {
+            break;
+        }
+    }
+}
+
+static void cat_thread_channel_async_callback(uv_async_t *handle)
+{
+    cat_thread_channel_t *channel = cat_container_of(handle, cat_thread_channel_t, u.async);
+
+    cat_thread_channel_wake_consumers(channel, cat_false);
+}
+
+static void cat_thread_channel_close_callback(uv_handle_t *handle)
+{
+    cat_thread_channel_t *channel = cat_container_of(handle, cat_thread_channel_t, u.handle);
+
+    cat_free(channel);
+}
+
+CAT_API cat_thread_channel_t *cat_thread_channel_create(cat_channel_size_t capacity, cat_channel_data_size_t data_size, cat_channel_data_dtor_t dtor)
+{
+    cat_thread_channel_t *channel;
+    uint64_t size = 1, position;
+    size_t cell_size;
+    int error;
+
+    if (unlikely(capacity == 0 || capacity > (CAT_CHANNEL_SIZE_MAX >> 1) + 1)) {
+        cat_update_last_error(CAT_EINVAL, "Thread channel capacity should be in range [1, " CAT_CHANNEL_SIZE_FMT "]", (CAT_CHANNEL_SIZE_MAX >> 1) + 1);
+        return NULL;
+    }
+    while (size < capacity) {
+        size <<= 1;
+    }
+    cell_size = CAT_MEMORY_ALIGNED_SIZE_EX(offsetof(cat_thread_channel_cell_t, data) + data_size, sizeof(uint64_t));
+    if (unlikely(size > (SIZE_MAX - sizeof(*channel)) / cell_size)) {
+        cat_update_last_error(CAT_ENOMEM, "Thread channel size overflow");
+        return NULL;
+    }
+
+    channel = (cat_thread_channel_t *) cat_malloc(sizeof(*channel) + (size_t) size * cell_size);
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(channel == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for thread channel failed");
+        return NULL;
+    }
+#endif
+
+    error = uv_async_init(&CAT_EVENT_G(loop), &channel->u.async, cat_thread_channel_async_callback);
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "Thread channel async init failed");
+        cat_free(channel);
+        return NULL;
+    }
+    /* it only keeps loop alive when there are waiters */
+    uv_unref(&channel->u.handle);
+
+    cat_atomic_uint64_init(&channel->enqueue_position, 0);
+    cat_atomic_uint64_init(&channel->dequeue_position, 0);
+    cat_atomic_bool_init(&channel->waiting, cat_false);
+    cat_atomic_bool_init(&channel->closed, cat_false);
+    channel->mask = size - 1;
+    channel->cell_size = cell_size;
+    channel->data_size = data_size;
+    channel->dtor = dtor;
+    channel->cells = (char *) (channel + 1);
+    for (position = 0; position < size; position++) {
+        cat_atomic_uint64_init(&cat_thread_channel_get_cell(channel, position)->sequence, position);
+    }
+    cat_queue_init(&channel->consumers);
+
+    return channel;
+}
+
+CAT_API cat_bool_t cat_thread_channel_pop(cat_thread_channel_t *channel, cat_data_t *data, cat_timeout_t timeout)
+{
+    cat_thread_channel_waiter_t waiter;
+    cat_bool_t ret;
+
+    while (!cat_thread_channel_dequeue(channel, data)) {
+        if (unlikely(!cat_thread_channel__is_available(channel))) {
+            cat_update_last_error(CAT_ECLOSED, "Thread channel has been closed");
+            return cat_false;
+        }
+        /* tell producers that we are going to sleep, then check it again */
+        cat_atomic_bool_store(&channel->waiting, cat_true);
+        if (!cat_thread_channel__is_empty(channel)) {
+            continue;
+        }
+        if (cat_queue_empty(&channel->consumers)) {
+            uv_ref(&channel->u.handle);
+        }
+        waiter.coroutine = CAT_COROUTINE_G(current);
+        waiter.notified = cat_false;
+        cat_queue_push_back(&channel->consumers, &waiter.node);
+        CAT_TIME_WAIT_START() {
+            ret = cat_time_wait(timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (!waiter.notified) {
+            cat_queue_remove(&waiter.node);
+        }
+        if (cat_queue_empty(&channel->consumers)) {
+            uv_unref(&channel->u.handle);
+        }
+        if (unlikely(!ret)) {
+            cat_update_last_error_with_previous("Thread channel wait producer failed");
+            return cat_false;
+        }
+        if (unlikely(!waiter.notified)) {
+            cat_update_last_error(CAT_ECANCELED, "Thread channel pop has been canceled");
+            return cat_false;
+        }
+        /* the item may be taken by others, try again */
+    }
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_thread_channel_close(cat_thread_channel_t *channel)
+{
+    if (unlikely(!cat_thread_channel__is_available(channel))) {
+        cat_update_last_error(CAT_ECLOSED, "Thread channel has been closed");
+        return cat_false;
+    }
+
+    cat_atomic_bool_store(&channel->closed, cat_true);
+    /* notify all waiters */
+    cat_thread_channel_wake_consumers(channel, cat_true);
+    CAT_ASSERT(cat_queue_empty(&channel->consumers));
+
+    return cat_true;
+}
+
+CAT_API void cat_thread_channel_free(cat_thread_channel_t *channel)
+{
+    if (cat_thread_channel__is_available(channel)) {
+        (void) cat_thread_channel_close(channel);
+    }
+    /* clean up the remaining items (no more consumers) */
+    while (cat_thread_channel_dequeue(channel, NULL));
+    uv_close(&channel->u.handle, cat_thread_channel_close_callback);
+}
+
+CAT_API cat_bool_t cat_thread_channel_push(cat_thread_channel_t *channel, const cat_data_t *data)
+{
+    if (unlikely(!cat_thread_channel__is_available(channel))) {
+        return cat_false;
+    }
+    if (unlikely(!cat_thread_channel_enqueue(channel, data))) {
+        return cat_false;
+    }
+    cat_thread_channel_notify(channel);
+
+    return cat_true;
+}
+
+CAT_API cat_channel_size_t cat_thread_channel_push_many(cat_thread_channel_t *channel, const cat_data_t *data, cat_channel_size_t count)
+{
+    const char *p = (const char *) data;
+    cat_channel_size_t n;
+
+    if (unlikely(!cat_thread_channel__is_available(channel))) {
+        return 0;
+    }
+    for (n = 0; n < count; n++, p += channel->data_size) {
+        if (unlikely(!cat_thread_channel_enqueue(channel, p))) {
+            break;
+        }
+    }
+    if (n > 0) {
+        cat_thread_channel_notify(channel);
+    }
+
+    return n;
+}
+
+CAT_API cat_bool_t cat_thread_channel_try_pop(cat_thread_channel_t *channel, cat_data_t *data)
+{
+    return cat_thread_channel_dequeue(channel, data);
+}
+
+/* status */
+
+CAT_API cat_channel_size_t cat_thread_channel_get_capacity(const cat_thread_channel_t *channel)
+{
+    return (cat_channel_size_t) (channel->mask + 1);
+}
+
+CAT_API cat_channel_size_t cat_thread_channel_get_length(const cat_thread_channel_t *channel)
+{
+    uint64_t dequeue_position = cat_atomic_uint64_load(&channel->dequeue_position);
+    uint64_t enqueue_position = cat_atomic_uint64_load(&channel->enqueue_position);
+
+    /* positions are loaded separately, it may be out of range */
+    if ((int64_t) (enqueue_position - dequeue_position) <= 0) {
+        return 0;
+    }
+    if (enqueue_position - dequeue_position > channel->mask + 1) {
+        return (cat_channel_size_t) (channel->mask + 1);
+    }
+    return (cat_channel_size_t) (enqueue_position - dequeue_position);
+}
+
+CAT_API cat_bool_t cat_thread_channel_is_available(const cat_thread_channel_t *channel)
+{
+    return cat_thread_channel__is_available(channel);
+}
@@ -104,76 +104,72 @@ CAT_API char *cat_time_format_msec(cat_msec_t msec)
 #undef SECOND
 }
 
-typedef union {
+typedef struct cat_timer_s {
+    cat_event_timer_t timer;
     cat_coroutine_t *coroutine;
-    uv_handle_t handle;
-    uv_timer_t timer;
 } cat_timer_t;
 
-static void cat_timer_callback(uv_timer_t* handle)
+static void cat_timer_callback(cat_event_timer_t *event_timer)
 {
-    cat_timer_t *timer = (cat_timer_t *) handle;
+    cat_timer_t *timer = cat_container_of(event_timer, cat_timer_t, timer);
     cat_coroutine_t *coroutine = timer->coroutine;
 
+    if (unlikely(coroutine->flags & CAT_COROUTINE_FLAG_READY)) {
+        /* it was woken up by others in ready queue before timed out */
+        return;
+    }
     timer->coroutine = NULL;
-    cat_coroutine_schedule(coroutine, TIME, "Timer");
+    cat_coroutine_schedule_deferrable(coroutine, TIME, "Timer");
 }
 
-static void cat_timer_close_callback(uv_handle_t *handle)
+/* timer lives on the C stack of the waiter, nothing to allocate */
+static cat_bool_t cat_timer_wait(cat_timer_t *timer, cat_msec_t msec)
 {
-    cat_timer_t *timer = cat_container_of(handle, cat_timer_t, handle);
-    cat_free(timer);
-}
-
-static cat_timer_t *cat_timer_wait(cat_msec_t msec)
-{
-    cat_timer_t *timer;
     cat_bool_t ret;
 
-    timer = (cat_timer_t *) cat_malloc(sizeof(*timer));;
-#if CAT_ALLOC_HANDLE_ERRORS
-    if (unlikely(timer == NULL)) {
-        cat_update_last_error_of_syscall("Malloc for timer failed");
-        return NULL;
-    }
-#endif
-
-    (void) uv_timer_init(&CAT_EVENT_G(loop), &timer->timer);
-    (void) uv_timer_start(&timer->timer, cat_timer_callback, msec, 0);
+    cat_event_timer_init(&timer->timer, cat_timer_callback);
+    cat_event_timer_start(&timer->timer, msec);
 
     timer->coroutine = CAT_COROUTINE_G(current);
 
     ret = cat_coroutine_yield(NULL, NULL);
 
-    uv_close(&timer->handle, cat_timer_close_callback);
+    cat_event_timer_stop(&timer->timer);
 
     if (unlikely(!ret)) {
         cat_update_last_error_with_previous("Time sleep failed");
-        return NULL;
+        return cat_false;
     }
 
-    return timer;
+    return cat_true;
 }
 
 static void cat_time_wait_0_callback(cat_event_loop_defer_task_t *task, cat_data_t *data)
 {
-    cat_coroutine_t *coroutine = (cat_coroutine_t *) data;
+    cat_coroutine_t **waiter = (cat_coroutine_t **) data;
+    cat_coroutine_t *coroutine = *waiter;
     (void) task;
-    cat_coroutine_schedule(coroutine, TIME, "Time wait 0");
+    if (unlikely(coroutine->flags & CAT_COROUTINE_FLAG_READY)) {
+        /* it was woken up by others in ready queue before timed out */
+        return;
+    }
+    *waiter = NULL;
+    cat_coroutine_schedule_deferrable(coroutine, TIME, "Time wait 0");
 }
 
 static cat_ret_t cat_time_delay_0(void)
 {
+    cat_coroutine_t *waiter = CAT_COROUTINE_G(current);
     cat_event_loop_defer_task_t *task = cat_event_loop_defer_task_create(
         cat_time_wait_0_callback,
-        CAT_COROUTINE_G(current)
+        &waiter
     );
     cat_bool_t ret = cat_coroutine_yield(NULL, NULL);
+    (void) cat_event_loop_defer_task_close(task);
     if (unlikely(!ret)) {
-        cat_event_loop_defer_task_close(task);
         return CAT_RET_ERROR;
     }
-    return cat_event_loop_defer_task_close(task) ? CAT_RET_OK : CAT_RET_NONE;
+    return waiter == NULL ? CAT_RET_OK : CAT_RET_NONE;
 }
 
 static cat_always_inline cat_bool_t cat_time_wait_impl(cat_timeout_t timeout)
@@ -191,11 +187,11 @@ static cat_always_inline cat_bool_t cat_time_wait_impl(cat_timeout_t timeout)
         }
         return cat_true;
     } else {
-        cat_timer_t *timer = cat_timer_wait(timeout);
-        if (unlikely(timer == NULL)) {
+        cat_timer_t timer;
+        if (unlikely(!cat_timer_wait(&timer, timeout))) {
             return cat_false;
         }
-        if (unlikely(timer->coroutine == NULL)) {
+        if (unlikely(timer.coroutine == NULL)) {
             cat_update_last_error(CAT_ETIMEDOUT, "Timed out for " CAT_TIMEOUT_FMT " ms", timeout);
             return cat_false;
         }
@@ -222,11 +218,11 @@ static cat_always_inline cat_ret_t cat_time_delay_impl(cat_timeout_t timeout)
     } else if (timeout == 0) {
         return cat_time_delay_0();
     } else {
-        cat_timer_t *timer = cat_timer_wait(timeout);
-        if (unlikely(timer == NULL)) {
+        cat_timer_t timer;
+        if (unlikely(!cat_timer_wait(&timer, timeout))) {
             return CAT_RET_ERROR;
         }
-        if (timer->coroutine == NULL) {
+        if (timer.coroutine == NULL) {
             return CAT_RET_OK;
         }
     }
@@ -251,22 +247,20 @@ static cat_always_inline cat_msec_t cat_time_msleep_impl(cat_msec_t msec)
         (void) cat_time_delay_0();
         // even if error, the number of seconds left to sleep is always 0...
     } else {
-        cat_timer_t *timer;
-
-        timer = cat_timer_wait(msec);
+        cat_timer_t timer;
 
-        if (unlikely(timer == NULL)) {
+        if (unlikely(!cat_timer_wait(&timer, msec))) {
             return msec;
         }
 
-        if (unlikely(timer->coroutine != NULL)) {
+        if (unlikely(timer.coroutine != NULL)) {
             cat_update_last_error(CAT_ECANCELED, "Time waiter has been canceled");
-            if (unlikely(timer->timer.timeout <= CAT_EVENT_G(loop).time)) {
+            if (unlikely(timer.timer.expire <= CAT_EVENT_G(loop).time)) {
                 /* blocking IO lead it to be negative or 0
                 * we can not know the real reserve time */
                 return msec;
             }
-            return timer->timer.timeout - CAT_EVENT_G(loop).time;
+            return timer.timer.expire - CAT_EVENT_G(loop).time;
         }
     }
 
@@ -24,6 +24,8 @@ static cat_timeout_t cat_watchdog_align_quantum(cat_timeout_t quantum)
 {
     if (quantum <= 0) {
         quantum = CAT_WATCH_DOG_DEFAULT_QUANTUM;
+    } else if (quantum < CAT_WATCH_DOG_MIN_QUANTUM) {
+        quantum = CAT_WATCH_DOG_MIN_QUANTUM;
     }
 
     return quantum;
@@ -40,6 +42,28 @@ static cat_timeout_t cat_watchdog_align_threshold(cat_timeout_t threshold)
     return threshold;
 }
 
+static cat_always_inline cat_timeout_t cat_watchdog_get_effective_quantum(cat_watchdog_t *watchdog)
+{
+    cat_timeout_t quantum = cat_atomic_int64_load(&watchdog->globals->watchdog_quantum);
+
+    if (quantum == 0) {
+        return watchdog->quantum;
+    }
+
+    return quantum > 0 ? quantum : CAT_WATCH_DOG_QUANTUM_DISABLED;
+}
+
+static cat_always_inline cat_timeout_t cat_watchdog_get_effective_threshold(cat_watchdog_t *watchdog)
+{
+    cat_timeout_t threshold = cat_atomic_int64_load(&watchdog->globals->watchdog_threshold);
+
+    if (threshold == 0) {
+        return watchdog->threshold;
+    }
+
+    return threshold > 0 ? threshold : CAT_WATCH_DOG_THRESHOLD_DISABLED;
+}
+
 #ifdef CAT_OS_WIN
 // in default, Windows timer slice is about 15.6ms
 // this function will try reduce it
@@ -80,14 +104,24 @@ static void cat_watchdog_loop(void* arg)
 
     uv_sem_post(watchdog->sem);
 
+    watchdog->last_check_time = uv_hrtime();
+
     while (1) {
-        watchdog->last_switches = watchdog->globals->switches;
+        cat_timeout_t interval = cat_atomic_int64_load(&watchdog->globals->watchdog_finest_quantum);
+        cat_nsec_t now;
+        /* some coroutine may have a shorter quantum, and it may be switched in while we are sleeping,
+         * so we check at the granularity of the finest one (it costs more wake-ups, but only
+         * for programs which really set a shorter coroutine quantum) */
+        if (interval <= 0 || interval > watchdog->quantum) {
+            interval = watchdog->quantum;
+        }
         uv_mutex_lock(&watchdog->mutex);
-        uv_cond_timedwait(&watchdog->cond, &watchdog->mutex, watchdog->quantum);
+        uv_cond_timedwait(&watchdog->cond, &watchdog->mutex, interval);
         uv_mutex_unlock(&watchdog->mutex);
         if (cat_atomic_bool_load(&watchdog->stop)) {
             return;
         }
+        now = uv_hrtime();
         /* Notice: globals info maybe changed during check,
          * but it is usually acceptable to us.
          * In other words, there is a certain probability of false alert. */
@@ -95,11 +129,24 @@ static void cat_watchdog_loop(void* arg)
             watchdog->globals->current != watchdog->globals->scheduler &&
             watchdog->globals->count > 1
         ) {
-            watchdog->alert_count++;
-            watchdog->alerter(watchdog);
+            watchdog->blocking_time += (cat_timeout_t) (now - watchdog->last_check_time);
+            watchdog->effective_quantum = cat_watchdog_get_effective_quantum(watchdog);
+            watchdog->effective_threshold = cat_watchdog_get_effective_threshold(watchdog);
+            /* options may be published by the next coroutine during check,
+             * so we re-check switches to avoid alerting on the wrong one */
+            if (watchdog->effective_quantum > 0 &&
+                watchdog->blocking_time >= watchdog->effective_quantum &&
+                watchdog->globals->switches == watchdog->last_switches
+            ) {
+                watchdog->alert_count++;
+                watchdog->alerter(watchdog);
+            }
         } else {
+            watchdog->last_switches = watchdog->globals->switches;
+            watchdog->blocking_time = 0;
             watchdog->alert_count = 0;
         }
+        watchdog->last_check_time = now;
     }
 }
 
@@ -153,7 +200,7 @@ CAT_API void cat_watchdog_alert_standard(cat_watchdog_t *watchdog)
 {
     fprintf(stderr, "Warning: <Watchdog> Syscall blocking or CPU starvation may occur in " CAT_WATCH_DOG_ROLE_NAME " %d, "
                     "it has been blocked for more than " CAT_TIMEOUT_FMT  " ns\n",
-                    watchdog->pid, watchdog->quantum * watchdog->alert_count);
+                    watchdog->pid, watchdog->blocking_time);
 }
 
 CAT_API cat_bool_t cat_watchdog_run(cat_watchdog_t *watchdog, cat_timeout_t quantum, cat_timeout_t threshold, cat_watchdog_alerter_t alerter)
@@ -188,6 +235,10 @@ CAT_API cat_bool_t cat_watchdog_run(cat_watchdog_t *watchdog, cat_timeout_t quan
     watchdog->pid = uv_os_getpid();
     watchdog->globals = CAT_GLOBALS_BULK(cat_coroutine);
     watchdog->last_switches = 0;
+    watchdog->blocking_time = 0;
+    watchdog->effective_quantum = watchdog->quantum;
+    watchdog->effective_threshold = watchdog->threshold;
+    watchdog->last_check_time = 0;
 
     error = uv_sem_init(&sem, 0);
     if (error != 0) {
@@ -294,3 +345,48 @@ CAT_API cat_timeout_t cat_watchdog_get_threshold(void)
             watchdog->threshold :
             -1;
 }
+
+CAT_API cat_timeout_t cat_watchdog_get_coroutine_quantum(const cat_coroutine_t *coroutine)
+{
+    return coroutine->watchdog_quantum;
+}
+
+CAT_API cat_timeout_t cat_watchdog_set_coroutine_quantum(cat_coroutine_t *coroutine, cat_timeout_t quantum)
+{
+    cat_timeout_t original_quantum = coroutine->watchdog_quantum;
+
+    if (quantum < 0) {
+        quantum = CAT_WATCH_DOG_QUANTUM_DISABLED;
+    } else if (quantum > 0 && quantum < CAT_WATCH_DOG_MIN_QUANTUM) {
+        quantum = CAT_WATCH_DOG_MIN_QUANTUM;
+    }
+    coroutine->watchdog_quantum = quantum;
+    if (quantum > 0) {
+        cat_timeout_t finest_quantum = cat_atomic_int64_load(&CAT_COROUTINE_G(watchdog_finest_quantum));
+        if (finest_quantum == 0 || quantum < finest_quantum) {
+            cat_atomic_int64_store(&CAT_COROUTINE_G(watchdog_finest_quantum), quantum);
+        }
+    }
+    if (coroutine == CAT_COROUTINE_G(current)) {
+        cat_atomic_int64_store(&CAT_COROUTINE_G(watchdog_quantum), coroutine->watchdog_quantum);
+    }
+
+    return original_quantum;
+}
+
+CAT_API cat_timeout_t cat_watchdog_get_coroutine_threshold(const cat_coroutine_t *coroutine)
+{
+    return coroutine->watchdog_threshold;
+}
+
+CAT_API cat_timeout_t cat_watchdog_set_coroutine_threshold(cat_coroutine_t *coroutine, cat_timeout_t threshold)
+{
+    cat_timeout_t original_threshold = coroutine->watchdog_threshold;
+
+    coroutine->watchdog_threshold = threshold < 0 ? CAT_WATCH_DOG_THRESHOLD_DISABLED : threshold;
+    if (coroutine == CAT_COROUTINE_G(current)) {
+        cat_atomic_int64_store(&CAT_COROUTINE_G(watchdog_threshold), coroutine->watchdog_threshold);
+    }
+
+    return original_threshold;
+}
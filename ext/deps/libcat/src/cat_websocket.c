@@ -17,6 +17,27 @@
  */
 
 #include "cat_websocket.h"
+#include "cat_time.h"
+
+#ifdef CAT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+/* SSE2 is always available on x86_64,
+ * AVX2 and AVX-512 are selected at runtime */
+#define CAT_WEBSOCKET_MASK_HAVE_SSE2 1
+#include <emmintrin.h>
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+#define CAT_WEBSOCKET_MASK_HAVE_AVX2 1
+#define CAT_WEBSOCKET_MASK_HAVE_AVX512 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+/* NEON is always available on aarch64 */
+#define CAT_WEBSOCKET_MASK_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
 
 CAT_API const char* cat_websocket_opcode_get_name(cat_websocket_opcode_t opcode)
 {
@@ -213,6 +234,233 @@ static void cat_websocket_mask2(const char *from, char *to, uint64_t length, con
     }
 }
 
+static void cat_websocket_mask_scalar(const char *from, char *to, uint64_t length, const char *masking_key, uint64_t index)
+{
+    if (from == to) {
+        cat_websocket_mask1(to, length, masking_key, index);
+    } else {
+        cat_websocket_mask2(from, to, length, masking_key, index);
+    }
+}
+
+/* SIMD kernels XOR the whole vector with the masking key rotated to the index,
+ * so that they do not need to align the index first, and the rest of data
+ * which is shorter than the vector width is passed to the narrower kernel.
+ * Data is always loaded before it is stored, so from and to can be the same. */
+
+#if defined(CAT_WEBSOCKET_MASK_HAVE_SSE2) || defined(CAT_WEBSOCKET_MASK_HAVE_NEON)
+static cat_always_inline uint32_t cat_websocket_masking_key_rotate(const char *masking_key, uint64_t index)
+{
+    char rotated_masking_key[CAT_WEBSOCKET_MASKING_KEY_LENGTH];
+    uint32_t masking_key_u32;
+    size_t n;
+
+    for (n = 0; n < CAT_WEBSOCKET_MASKING_KEY_LENGTH; n++) {
+        rotated_masking_key[n] = masking_key[(index + n) & (CAT_WEBSOCKET_MASKING_KEY_LENGTH - 1)];
+    }
+    memcpy(&masking_key_u32, rotated_masking_key, sizeof(masking_key_u32));
+
+    return masking_key_u32;
+}
+#endif
+
+#ifdef CAT_WEBSOCKET_MASK_HAVE_SSE2
+static void cat_websocket_mask_sse2(const char *from, char *to, uint64_t length, const char *masking_key, uint64_t index)
+{
+    uint64_t offset = 0;
+
+    if (length >= sizeof(__m128i)) {
+        const __m128i key = _mm_set1_epi32((int) cat_websocket_masking_key_rotate(masking_key, index));
+        for (; offset + sizeof(__m128i) * 4 <= length; offset += sizeof(__m128i) * 4) {
+            __m128i v0 = _mm_loadu_si128((const __m128i *) (from + offset));
+            __m128i v1 = _mm_loadu_si128((const __m128i *) (from + offset + sizeof(__m128i)));
+            __m128i v2 = _mm_loadu_si128((const __m128i *) (from + offset + sizeof(__m128i) * 2));
+            __m128i v3 = _mm_loadu_si128((const __m128i *) (from + offset + sizeof(__m128i) * 3));
+            _mm_storeu_si128((__m128i *) (to + offset), _mm_xor_si128(v0, key));
+            _mm_storeu_si128((__m128i *) (to + offset + sizeof(__m128i)), _mm_xor_si128(v1, key));
+            _mm_storeu_si128((__m128i *) (to + offset + sizeof(__m128i) * 2), _mm_xor_si128(v2, key));
+            _mm_storeu_si128((__m128i *) (to + offset + sizeof(__m128i) * 3), _mm_xor_si128(v3, key));
+        }
+        for (; offset + sizeof(__m128i) <= length; offset += sizeof(__m128i)) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (from + offset));
+            _mm_storeu_si128((__m128i *) (to + offset), _mm_xor_si128(v, key));
+        }
+    }
+    for (; offset < length; offset++) {
+        to[offset] = from[offset] ^ masking_key[(index + offset) & (CAT_WEBSOCKET_MASKING_KEY_LENGTH - 1)];
+    }
+}
+#endif
+
+#ifdef CAT_WEBSOCKET_MASK_HAVE_AVX2
+__attribute__((target("avx2")))
+static void cat_websocket_mask_avx2(const char *from, char *to, uint64_t length, const char *masking_key, uint64_t index)
+{
+    uint64_t offset = 0;
+
+    if (length >= sizeof(__m256i)) {
+        const __m256i key = _mm256_set1_epi32((int) cat_websocket_masking_key_rotate(masking_key, index));
+        for (; offset + sizeof(__m256i) * 4 <= length; offset += sizeof(__m256i) * 4) {
+            __m256i v0 = _mm256_loadu_si256((const __m256i *) (from + offset));
+            __m256i v1 = _mm256_loadu_si256((const __m256i *) (from + offset + sizeof(__m256i)));
+            __m256i v2 = _mm256_loadu_si256((const __m256i *) (from + offset + sizeof(__m256i) * 2));
+            __m256i v3 = _mm256_loadu_si256((const __m256i *) (from + offset + sizeof(__m256i) * 3));
+            _mm256_storeu_si256((__m256i *) (to + offset), _mm256_xor_si256(v0, key));
+            _mm256_storeu_si256((__m256i *) (to + offset + sizeof(__m256i)), _mm256_xor_si256(v1, key));
+            _mm256_storeu_si256((__m256i *) (to + offset + sizeof(__m256i) * 2), _mm256_xor_si256(v2, key));
+            _mm256_storeu_si256((__m256i *) (to + offset + sizeof(__m256i) * 3), _mm256_xor_si256(v3, key));
+        }
+        for (; offset + sizeof(__m256i) <= length; offset += sizeof(__m256i)) {
+            __m256i v = _mm256_loadu_si256((const __m256i *) (from + offset));
+            _mm256_storeu_si256((__m256i *) (to + offset), _mm256_xor_si256(v, key));
+        }
+    }
+    cat_websocket_mask_sse2(from + offset, to + offset, length - offset, masking_key, index + offset);
+}
+#endif
+
+#ifdef CAT_WEBSOCKET_MASK_HAVE_AVX512
+__attribute__((target("avx512f")))
+static void cat_websocket_mask_avx512(const char *from, char *to, uint64_t length, const char *masking_key, uint64_t index)
+{
+    uint64_t offset = 0;
+
+    if (length >= sizeof(__m512i)) {
+        const __m512i key = _mm512_set1_epi32((int) cat_websocket_masking_key_rotate(masking_key, index));
+        for (; offset + sizeof(__m512i) * 2 <= length; offset += sizeof(__m512i) * 2) {
+            __m512i v0 = _mm512_loadu_si512((const void *) (from + offset));
+            __m512i v1 = _mm512_loadu_si512((const void *) (from + offset + sizeof(__m512i)));
+            _mm512_storeu_si512((void *) (to + offset), _mm512_xor_si512(v0, key));
+            _mm512_storeu_si512((void *) (to + offset + sizeof(__m512i)), _mm512_xor_si512(v1, key));
+        }
+        for (; offset + sizeof(__m512i) <= length; offset += sizeof(__m512i)) {
+            __m512i v = _mm512_loadu_si512((const void *) (from + offset));
+            _mm512_storeu_si512((void *) (to + offset), _mm512_xor_si512(v, key));
+        }
+    }
+    cat_websocket_mask_avx2(from + offset, to + offset, length - offset, masking_key, index + offset);
+}
+#endif
+
+#ifdef CAT_WEBSOCKET_MASK_HAVE_NEON
+static void cat_websocket_mask_neon(const char *from, char *to, uint64_t length, const char *masking_key, uint64_t index)
+{
+    uint64_t offset = 0;
+
+    if (length >= sizeof(uint8x16_t)) {
+        const uint8x16_t key = vreinterpretq_u8_u32(vdupq_n_u32(cat_websocket_masking_key_rotate(masking_key, index)));
+        for (; offset + sizeof(uint8x16_t) * 4 <= length; offset += sizeof(uint8x16_t) * 4) {
+            uint8x16_t v0 = vld1q_u8((const uint8_t *) (from + offset));
+            uint8x16_t v1 = vld1q_u8((const uint8_t *) (from + offset + sizeof(uint8x16_t)));
+            uint8x16_t v2 = vld1q_u8((const uint8_t *) (from + offset + sizeof(uint8x16_t) * 2));
+            uint8x16_t v3 = vld1q_u8((const uint8_t *) (from + offset + sizeof(uint8x16_t) * 3));
+            vst1q_u8((uint8_t *) (to + offset), veorq_u8(v0, key));
+            vst1q_u8((uint8_t *) (to + offset + sizeof(uint8x16_t)), veorq_u8(v1, key));
+            vst1q_u8((uint8_t *) (to + offset + sizeof(uint8x16_t) * 2), veorq_u8(v2, key));
+            vst1q_u8((uint8_t *) (to + offset + sizeof(uint8x16_t) * 3), veorq_u8(v3, key));
+        }
+        for (; offset + sizeof(uint8x16_t) <= length; offset += sizeof(uint8x16_t)) {
+            uint8x16_t v = vld1q_u8((const uint8_t *) (from + offset));
+            vst1q_u8((uint8_t *) (to + offset), veorq_u8(v, key));
+        }
+    }
+    for (; offset < length; offset++) {
+        to[offset] = from[offset] ^ masking_key[(index + offset) & (CAT_WEBSOCKET_MASKING_KEY_LENGTH - 1)];
+    }
+}
+#endif
+
+typedef void (*cat_websocket_mask_function_t)(const char *from, char *to, uint64_t length, const char *masking_key, uint64_t index);
+
+typedef struct cat_websocket_mask_implementation_s {
+    const char *name;
+    cat_websocket_mask_function_t function;
+} cat_websocket_mask_implementation_t;
+
+/* ordered from the widest to the narrowest */
+static const cat_websocket_mask_implementation_t cat_websocket_mask_implementations[] = {
+#ifdef CAT_WEBSOCKET_MASK_HAVE_AVX512
+    { "avx512", cat_websocket_mask_avx512 },
+#endif
+#ifdef CAT_WEBSOCKET_MASK_HAVE_AVX2
+    { "avx2", cat_websocket_mask_avx2 },
+#endif
+#ifdef CAT_WEBSOCKET_MASK_HAVE_SSE2
+    { "sse2", cat_websocket_mask_sse2 },
+#endif
+#ifdef CAT_WEBSOCKET_MASK_HAVE_NEON
+    { "neon", cat_websocket_mask_neon },
+#endif
+    { "scalar", cat_websocket_mask_scalar },
+};
+
+/* resolved on the first use, it is fine if threads race on it since they get the same one */
+static const cat_websocket_mask_implementation_t *cat_websocket_mask_implementation;
+
+static cat_bool_t cat_websocket_mask_implementation_is_supported(const cat_websocket_mask_implementation_t *implementation)
+{
+#if defined(CAT_WEBSOCKET_MASK_HAVE_AVX2) || defined(CAT_WEBSOCKET_MASK_HAVE_AVX512)
+    __builtin_cpu_init();
+#endif
+#ifdef CAT_WEBSOCKET_MASK_HAVE_AVX512
+    if (implementation->function == cat_websocket_mask_avx512) {
+        /* it also checks whether OS saves the ZMM registers */
+        return __builtin_cpu_supports("avx512f") != 0;
+    }
+#endif
+#ifdef CAT_WEBSOCKET_MASK_HAVE_AVX2
+    if (implementation->function == cat_websocket_mask_avx2) {
+        return __builtin_cpu_supports("avx2") != 0;
+    }
+#endif
+    (void) implementation;
+    return cat_true;
+}
+
+static const cat_websocket_mask_implementation_t *cat_websocket_mask_get_implementation_internal(void)
+{
+    const cat_websocket_mask_implementation_t *implementation = cat_websocket_mask_implementation;
+
+    if (unlikely(implementation == NULL)) {
+        size_t n;
+        for (n = 0; n < CAT_ARRAY_SIZE(cat_websocket_mask_implementations); n++) {
+            implementation = &cat_websocket_mask_implementations[n];
+            if (cat_websocket_mask_implementation_is_supported(implementation)) {
+                break;
+            }
+        }
+        cat_websocket_mask_implementation = implementation;
+    }
+
+    return implementation;
+}
+
+CAT_API const char *cat_websocket_mask_get_implementation(void)
+{
+    return cat_websocket_mask_get_implementation_internal()->name;
+}
+
+CAT_API cat_bool_t cat_websocket_mask_set_implementation(const char *name)
+{
+    size_t n;
+
+    for (n = 0; n < CAT_ARRAY_SIZE(cat_websocket_mask_implementations); n++) {
+        const cat_websocket_mask_implementation_t *implementation = &cat_websocket_mask_implementations[n];
+        if (strcmp(implementation->name, name) != 0) {
+            continue;
+        }
+        if (!cat_websocket_mask_implementation_is_supported(implementation)) {
+            cat_update_last_error(CAT_ENOTSUP, "WebSocket mask implementation \"%s\" is not supported by CPU", name);
+            return cat_false;
+        }
+        cat_websocket_mask_implementation = implementation;
+        return cat_true;
+    }
+    cat_update_last_error(CAT_EINVAL, "Unknown WebSocket mask implementation \"%s\"", name);
+
+    return cat_false;
+}
+
 CAT_API void cat_websocket_mask(const char *from, char *to, uint64_t length, const char *masking_key)
 {
     cat_websocket_mask_ex(from, to, length, masking_key, 0);
@@ -225,18 +473,17 @@ CAT_API void cat_websocket_unmask(char *data, uint64_t length, const char *maski
 
 CAT_API void cat_websocket_mask_ex(const char *from, char *to, uint64_t length, const char *masking_key, uint64_t index)
 {
-    cat_bool_t masking_key_is_empty = masking_key == NULL || memcmp(masking_key, CAT_STRS(CAT_WEBSOCKET_EMPTY_MASKING_KEY)) == 0;
+    cat_bool_t masking_key_is_empty = masking_key == NULL || memcmp(masking_key, CAT_STRL(CAT_WEBSOCKET_EMPTY_MASKING_KEY)) == 0;
 
-    if (from == to) {
-        if (!masking_key_is_empty) {
-            cat_websocket_mask1(to, length, masking_key, index);
-        }
-    } else {
-        if (masking_key_is_empty) {
+    if (masking_key_is_empty) {
+        if (from != to) {
             memmove(to, from, length);
-        } else {
-            cat_websocket_mask2(from, to, length, masking_key, index);
         }
+    } else if (length < sizeof(uint64_t) * 2) {
+        /* not worth an indirect call */
+        cat_websocket_mask_scalar(from, to, length, masking_key, index);
+    } else {
+        cat_websocket_mask_get_implementation_internal()->function(from, to, length, masking_key, index);
     }
 }
 
@@ -244,3 +491,1038 @@ CAT_API void cat_websocket_unmask_ex(char *data, uint64_t length, const char *ma
 {
     cat_websocket_mask_ex(data, data, length, masking_key, index);
 }
+
+/* UTF-8 DFA decoder by Bjoern Hoehrmann, see http://bjoern.hoehrmann.de/utf-8/decoder/dfa/
+ * the first part maps bytes to character classes,
+ * the second part maps a state and a character class to the next state */
+static const uint8_t cat_websocket_utf8_dfa[] = {
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+    7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7, 7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+    8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2, 2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+    10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3, 11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
+    0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
+    12,0,12,12,12,12,12,0,12,0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
+    12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
+    12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
+    12,36,12,12,12,12,12,12,12,12,12,12,
+};
+
+CAT_STATIC_ASSERT(CAT_WEBSOCKET_UTF8_REJECT == 12);
+CAT_STATIC_ASSERT(sizeof(cat_websocket_utf8_dfa) == 256 + CAT_WEBSOCKET_UTF8_STATE_MAX + 12);
+
+static cat_websocket_utf8_state_t cat_websocket_utf8_validate_internal(const char *data, uint64_t length, cat_websocket_utf8_state_t state)
+{
+    const uint8_t *p = (const uint8_t *) data, *pe = p + length;
+
+    while (p < pe) {
+        if (state == CAT_WEBSOCKET_UTF8_ACCEPT) {
+            /* skip ASCII fast */
+            while (p + sizeof(uint64_t) * 2 <= pe) {
+                uint64_t v0, v1;
+                memcpy(&v0, p, sizeof(v0));
+                memcpy(&v1, p + sizeof(v0), sizeof(v1));
+                if (((v0 | v1) & UINT64_C(0x8080808080808080)) != 0) {
+                    break;
+                }
+                p += sizeof(uint64_t) * 2;
+            }
+            if (p == pe) {
+                break;
+            }
+        }
+        state = cat_websocket_utf8_dfa[256 + state + cat_websocket_utf8_dfa[*p++]];
+        if (unlikely(state == CAT_WEBSOCKET_UTF8_REJECT)) {
+            break;
+        }
+    }
+
+    return state;
+}
+
+CAT_API cat_bool_t cat_websocket_utf8_validate(const char *data, uint64_t length, cat_websocket_utf8_state_t *state)
+{
+    CAT_ASSERT(CAT_WEBSOCKET_UTF8_STATE_IS_VALID(*state));
+    *state = cat_websocket_utf8_validate_internal(data, length, *state);
+
+    if (unlikely(*state == CAT_WEBSOCKET_UTF8_REJECT)) {
+        cat_update_last_error(CAT_EILSEQ, "WebSocket payload data is not valid UTF-8");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+/* unmask and validate chunk by chunk, so that the unmasked data is still in L1 cache when it is validated */
+#define CAT_WEBSOCKET_UNMASK_CHUNK_SIZE (8 * 1024)
+
+CAT_API cat_bool_t cat_websocket_unmask_to(const char *from, char *to, uint64_t length, const char *masking_key, uint64_t index, cat_websocket_utf8_state_t *utf8_state)
+{
+    cat_websocket_utf8_state_t state;
+    uint64_t offset;
+
+    if (utf8_state == NULL) {
+        cat_websocket_mask_ex(from, to, length, masking_key, index);
+        return cat_true;
+    }
+    state = *utf8_state;
+    CAT_ASSERT(CAT_WEBSOCKET_UTF8_STATE_IS_VALID(state));
+    for (offset = 0; offset < length; offset += CAT_WEBSOCKET_UNMASK_CHUNK_SIZE) {
+        uint64_t chunk_length = CAT_MIN(length - offset, CAT_WEBSOCKET_UNMASK_CHUNK_SIZE);
+        cat_websocket_mask_ex(from + offset, to + offset, chunk_length, masking_key, index + offset);
+        if (state != CAT_WEBSOCKET_UTF8_REJECT) {
+            state = cat_websocket_utf8_validate_internal(to + offset, chunk_length, state);
+        }
+    }
+    *utf8_state = state;
+
+    if (unlikely(state == CAT_WEBSOCKET_UTF8_REJECT)) {
+        cat_update_last_error(CAT_EILSEQ, "WebSocket payload data is not valid UTF-8");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+/* permessage-deflate */
+
+CAT_API void cat_websocket_deflate_options_init(cat_websocket_deflate_options_t *options)
+{
+    options->server_no_context_takeover = cat_false;
+    options->client_no_context_takeover = cat_false;
+    options->server_max_window_bits = CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS;
+    options->client_max_window_bits = CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS;
+}
+
+enum cat_websocket_deflate_param_e {
+    CAT_WEBSOCKET_DEFLATE_PARAM_SERVER_NO_CONTEXT_TAKEOVER = 1 << 0,
+    CAT_WEBSOCKET_DEFLATE_PARAM_CLIENT_NO_CONTEXT_TAKEOVER = 1 << 1,
+    CAT_WEBSOCKET_DEFLATE_PARAM_SERVER_MAX_WINDOW_BITS     = 1 << 2,
+    CAT_WEBSOCKET_DEFLATE_PARAM_CLIENT_MAX_WINDOW_BITS     = 1 << 3,
+};
+
+static cat_always_inline cat_bool_t cat_websocket_extension_is_token_char(char c)
+{
+    return c != ',' && c != ';' && c != '=' && c != '"' && c != ' ' && c != '\t';
+}
+
+static const char *cat_websocket_extension_skip_spaces(const char *p, const char *pe)
+{
+    while (p < pe && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+static const char *cat_websocket_extension_read_token(const char *p, const char *pe, size_t *length)
+{
+    const char *s = p;
+
+    while (p < pe && cat_websocket_extension_is_token_char(*p)) {
+        p++;
+    }
+    *length = p - s;
+
+    return p;
+}
+
+/* skip to the next extension (quoted value may contain comma) */
+static const char *cat_websocket_extension_skip(const char *p, const char *pe)
+{
+    cat_bool_t quoted = cat_false;
+
+    for (; p < pe; p++) {
+        if (*p == '"') {
+            quoted = !quoted;
+        } else if (*p == ',' && !quoted) {
+            break;
+        }
+    }
+
+    return p;
+}
+
+static cat_bool_t cat_websocket_deflate_parse_window_bits(const char *value, size_t value_length, uint8_t *window_bits)
+{
+    unsigned int bits = 0;
+    size_t n;
+
+    if (value_length == 0 || value_length > 2) {
+        return cat_false;
+    }
+    for (n = 0; n < value_length; n++) {
+        if (value[n] < '0' || value[n] > '9') {
+            return cat_false;
+        }
+        bits = bits * 10 + (value[n] - '0');
+    }
+    /* 8 is valid in RFC, but zlib can not deflate with it */
+    if (bits < CAT_WEBSOCKET_DEFLATE_MIN_WINDOW_BITS || bits > CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS) {
+        return cat_false;
+    }
+    *window_bits = (uint8_t) bits;
+
+    return cat_true;
+}
+
+/* parse one extension and move p to the end of it, return true if it is an acceptable permessage-deflate */
+static cat_bool_t cat_websocket_deflate_options_parse_one(cat_websocket_deflate_options_t *options, const char **pp, const char *pe)
+{
+    const char *p = *pp, *name, *value;
+    size_t name_length, value_length;
+    unsigned int params = 0;
+    cat_bool_t ret = cat_false;
+
+    cat_websocket_deflate_options_init(options);
+    p = cat_websocket_extension_skip_spaces(p, pe);
+    name = p;
+    p = cat_websocket_extension_read_token(p, pe, &name_length);
+    if (!(name_length == CAT_STRLEN(CAT_WEBSOCKET_DEFLATE_EXTENSION_NAME) &&
+          cat_strncasecmp(name, CAT_STRL(CAT_WEBSOCKET_DEFLATE_EXTENSION_NAME)) == 0)) {
+        goto _out;
+    }
+    while (1) {
+        unsigned int param;
+        p = cat_websocket_extension_skip_spaces(p, pe);
+        if (p == pe || *p == ',') {
+            break;
+        }
+        if (*p != ';') {
+            goto _out;
+        }
+        p = cat_websocket_extension_skip_spaces(p + 1, pe);
+        name = p;
+        p = cat_websocket_extension_read_token(p, pe, &name_length);
+        p = cat_websocket_extension_skip_spaces(p, pe);
+        value = NULL;
+        value_length = 0;
+        if (p < pe && *p == '=') {
+            p = cat_websocket_extension_skip_spaces(p + 1, pe);
+            if (p < pe && *p == '"') {
+                value = ++p;
+                while (p < pe && *p != '"') {
+                    p++;
+                }
+                if (p == pe) {
+                    goto _out;
+                }
+                value_length = p++ - value;
+            } else {
+                value = p;
+                p = cat_websocket_extension_read_token(p, pe, &value_length);
+            }
+        }
+#define CAT_WEBSOCKET_DEFLATE_PARAM_IS(_name) \
+        (name_length == CAT_STRLEN(_name) && cat_strncasecmp(name, CAT_STRL(_name)) == 0)
+        if (CAT_WEBSOCKET_DEFLATE_PARAM_IS("server_no_context_takeover")) {
+            param = CAT_WEBSOCKET_DEFLATE_PARAM_SERVER_NO_CONTEXT_TAKEOVER;
+            options->server_no_context_takeover = cat_true;
+        } else if (CAT_WEBSOCKET_DEFLATE_PARAM_IS("client_no_context_takeover")) {
+            param = CAT_WEBSOCKET_DEFLATE_PARAM_CLIENT_NO_CONTEXT_TAKEOVER;
+            options->client_no_context_takeover = cat_true;
+        } else if (CAT_WEBSOCKET_DEFLATE_PARAM_IS("server_max_window_bits")) {
+            param = CAT_WEBSOCKET_DEFLATE_PARAM_SERVER_MAX_WINDOW_BITS;
+            if (value == NULL || !cat_websocket_deflate_parse_window_bits(value, value_length, &options->server_max_window_bits)) {
+                goto _out;
+            }
+        } else if (CAT_WEBSOCKET_DEFLATE_PARAM_IS("client_max_window_bits")) {
+            param = CAT_WEBSOCKET_DEFLATE_PARAM_CLIENT_MAX_WINDOW_BITS;
+            /* client may offer it without value, it means that client supports it */
+            if (value != NULL && !cat_websocket_deflate_parse_window_bits(value, value_length, &options->client_max_window_bits)) {
+                goto _out;
+            }
+        } else {
+            goto _out;
+        }
+#undef CAT_WEBSOCKET_DEFLATE_PARAM_IS
+        if ((param & (CAT_WEBSOCKET_DEFLATE_PARAM_SERVER_NO_CONTEXT_TAKEOVER | CAT_WEBSOCKET_DEFLATE_PARAM_CLIENT_NO_CONTEXT_TAKEOVER)) && value != NULL) {
+            goto _out;
+        }
+        if (params & param) {
+            goto _out;
+        }
+        params |= param;
+    }
+    ret = cat_true;
+
+    _out:
+    *pp = cat_websocket_extension_skip(p, pe);
+    return ret;
+}
+
+CAT_API cat_bool_t cat_websocket_deflate_options_parse(cat_websocket_deflate_options_t *options, const char *extensions, size_t length)
+{
+    const char *p = extensions, *pe = extensions + length;
+
+    while (p < pe) {
+        if (cat_websocket_deflate_options_parse_one(options, &p, pe)) {
+            return cat_true;
+        }
+        p++; /* skip ',' */
+    }
+    cat_websocket_deflate_options_init(options);
+    cat_update_last_error(CAT_EINVAL, "WebSocket has no acceptable permessage-deflate extension");
+
+    return cat_false;
+}
+
+CAT_API cat_bool_t cat_websocket_deflate_options_negotiate(cat_websocket_deflate_options_t *options, const char *offer, size_t length, cat_buffer_t *response)
+{
+#ifndef CAT_HAVE_ZLIB
+    cat_websocket_deflate_options_init(options);
+    cat_update_last_error(CAT_ENOTSUP, "WebSocket permessage-deflate is not supported (zlib is not available)");
+    return cat_false;
+#endif
+    if (!cat_websocket_deflate_options_parse(options, offer, length)) {
+        return cat_false;
+    }
+    /* we accept whatever client offered,
+     * client_max_window_bits without value is just a hint, we do not limit it */
+    return cat_websocket_deflate_options_format(options, response);
+}
+
+CAT_API cat_bool_t cat_websocket_deflate_options_format(const cat_websocket_deflate_options_t *options, cat_buffer_t *buffer)
+{
+    cat_bool_t ret;
+
+    ret = cat_buffer_append(buffer, CAT_STRL(CAT_WEBSOCKET_DEFLATE_EXTENSION_NAME));
+    if (ret && options->server_no_context_takeover) {
+        ret = cat_buffer_append(buffer, CAT_STRL("; server_no_context_takeover"));
+    }
+    if (ret && options->client_no_context_takeover) {
+        ret = cat_buffer_append(buffer, CAT_STRL("; client_no_context_takeover"));
+    }
+    if (ret && options->server_max_window_bits < CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS) {
+        ret = cat_buffer_append_printf(buffer, "; server_max_window_bits=%u", (unsigned int) options->server_max_window_bits);
+    }
+    if (ret && options->client_max_window_bits < CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS) {
+        ret = cat_buffer_append_printf(buffer, "; client_max_window_bits=%u", (unsigned int) options->client_max_window_bits);
+    }
+    if (unlikely(!ret)) {
+        cat_update_last_error_with_previous("WebSocket format permessage-deflate options failed");
+    }
+
+    return ret;
+}
+
+/* frame codec */
+
+#define CAT_WEBSOCKET_CODEC_IS_CLIENT(codec) (((codec)->flags & CAT_WEBSOCKET_CODEC_FLAG_CLIENT) != 0)
+
+#define CAT_WEBSOCKET_OPCODE_IS_CONTROL(opcode) (((opcode) & 0x8) != 0)
+
+#define CAT_WEBSOCKET_INFLATE_CHUNK_SIZE (16 * 1024)
+
+#define CAT_WEBSOCKET_RECV_CHUNK_SIZE (64 * 1024)
+
+#define CAT_WEBSOCKET_DEFLATE_TRAILER "\x00\x00\xff\xff"
+
+CAT_API void cat_websocket_codec_init(cat_websocket_codec_t *codec, cat_websocket_codec_flags_t flags)
+{
+    codec->flags = flags;
+    codec->max_message_length = CAT_WEBSOCKET_DEFAULT_MAX_MESSAGE_LENGTH;
+    codec->message_opcode = CAT_WEBSOCKET_OPCODE_CONTINUATION;
+    codec->message_compressed = cat_false;
+    codec->message_offset = 0;
+    codec->utf8_state = CAT_WEBSOCKET_UTF8_ACCEPT;
+    codec->control_payload_length = 0;
+    codec->close_sent = cat_false;
+    codec->close_received = cat_false;
+    codec->broken = cat_false;
+    /* filled on the first masking key request */
+    codec->masking_key_pool_offset = CAT_WEBSOCKET_MASKING_KEY_POOL_SIZE;
+    cat_buffer_init(&codec->recv_buffer);
+    cat_buffer_init(&codec->send_buffer);
+    codec->sending = cat_false;
+    codec->deflate_enabled = cat_false;
+    codec->deflate_level = -1;
+    codec->deflate_threshold = CAT_WEBSOCKET_DEFLATE_DEFAULT_THRESHOLD;
+    codec->deflate_no_context_takeover = cat_false;
+    codec->inflate_no_context_takeover = cat_false;
+    codec->deflate_stream = NULL;
+    codec->inflate_stream = NULL;
+}
+
+CAT_API cat_bool_t cat_websocket_codec_enable_deflate(cat_websocket_codec_t *codec, const cat_websocket_deflate_options_t *options, int level)
+{
+#ifndef CAT_HAVE_ZLIB
+    (void) codec;
+    (void) options;
+    (void) level;
+    cat_update_last_error(CAT_ENOTSUP, "WebSocket permessage-deflate is not supported (zlib is not available)");
+    return cat_false;
+#else
+    cat_bool_t is_client = CAT_WEBSOCKET_CODEC_IS_CLIENT(codec);
+    z_stream *deflate_stream, *inflate_stream;
+    int window_bits;
+
+    if (unlikely(codec->deflate_enabled)) {
+        cat_update_last_error(CAT_EALREADY, "WebSocket permessage-deflate has been enabled");
+        return cat_false;
+    }
+    if (unlikely(level < Z_DEFAULT_COMPRESSION || level > Z_BEST_COMPRESSION)) {
+        cat_update_last_error(CAT_EINVAL, "WebSocket compression level should be in range [-1, 9]");
+        return cat_false;
+    }
+    window_bits = is_client ? options->client_max_window_bits : options->server_max_window_bits;
+    deflate_stream = (z_stream *) cat_malloc(sizeof(*deflate_stream));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(deflate_stream == NULL)) {
+        cat_update_last_error_of_syscall("Malloc for deflate stream failed");
+        return cat_false;
+    }
+#endif
+    inflate_stream = (z_stream *) cat_malloc(sizeof(*inflate_stream));
+#if CAT_ALLOC_HANDLE_ERRORS
+    if (unlikely(inflate_stream == NULL)) {
+        cat_free(deflate_stream);
+        cat_update_last_error_of_syscall("Malloc for inflate stream failed");
+        return cat_false;
+    }
+#endif
+    memset(deflate_stream, 0, sizeof(*deflate_stream));
+    memset(inflate_stream, 0, sizeof(*inflate_stream));
+    /* negative window bits means raw deflate data without zlib header */
+    if (unlikely(deflateInit2(deflate_stream, level, Z_DEFLATED, -window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)) {
+        cat_update_last_error(CAT_ENOMEM, "WebSocket deflate init failed");
+        goto _deflate_init_error;
+    }
+    /* peer may use any window size which is not greater than it */
+    if (unlikely(inflateInit2(inflate_stream, -CAT_WEBSOCKET_DEFLATE_MAX_WINDOW_BITS) != Z_OK)) {
+        cat_update_last_error(CAT_ENOMEM, "WebSocket inflate init failed");
+        goto _inflate_init_error;
+    }
+    codec->deflate_enabled = cat_true;
+    codec->deflate_level = level;
+    codec->deflate_no_context_takeover = is_client ? options->client_no_context_takeover : options->server_no_context_takeover;
+    codec->inflate_no_context_takeover = is_client ? options->server_no_context_takeover : options->client_no_context_takeover;
+    codec->deflate_stream = deflate_stream;
+    codec->inflate_stream = inflate_stream;
+
+    return cat_true;
+
+    _inflate_init_error:
+    deflateEnd(deflate_stream);
+    _deflate_init_error:
+    cat_free(inflate_stream);
+    cat_free(deflate_stream);
+    return cat_false;
+#endif
+}
+
+CAT_API void cat_websocket_codec_close(cat_websocket_codec_t *codec)
+{
+#ifdef CAT_HAVE_ZLIB
+    if (codec->deflate_stream != NULL) {
+        deflateEnd((z_stream *) codec->deflate_stream);
+        cat_free(codec->deflate_stream);
+        codec->deflate_stream = NULL;
+    }
+    if (codec->inflate_stream != NULL) {
+        inflateEnd((z_stream *) codec->inflate_stream);
+        cat_free(codec->inflate_stream);
+        codec->inflate_stream = NULL;
+    }
+#endif
+    codec->deflate_enabled = cat_false;
+    cat_buffer_close(&codec->recv_buffer);
+    cat_buffer_close(&codec->send_buffer);
+}
+
+/* masking key must be unpredictable (RFC 6455 10.3), so keys are drawn from CSPRNG,
+ * a batch of them is fetched at once to amortize the cost of syscall */
+static cat_bool_t cat_websocket_codec_generate_masking_key(cat_websocket_codec_t *codec, char *masking_key)
+{
+    char *pool = codec->masking_key_pool;
+
+    if (codec->masking_key_pool_offset == CAT_WEBSOCKET_MASKING_KEY_POOL_SIZE) {
+#ifdef CAT_SSL
+        if (unlikely(RAND_bytes((unsigned char *) pool, CAT_WEBSOCKET_MASKING_KEY_POOL_SIZE) != 1)) {
+            cat_update_last_error(CAT_ESSL, "RAND_bytes() failed");
+            return cat_false;
+        }
+#else
+        int error = uv_random(NULL, NULL, pool, CAT_WEBSOCKET_MASKING_KEY_POOL_SIZE, 0, NULL);
+        if (unlikely(error != 0)) {
+            cat_update_last_error(error, "Random bytes generation failed");
+            return cat_false;
+        }
+#endif
+        codec->masking_key_pool_offset = 0;
+    }
+    memcpy(masking_key, pool + codec->masking_key_pool_offset, CAT_WEBSOCKET_MASKING_KEY_LENGTH);
+    codec->masking_key_pool_offset += CAT_WEBSOCKET_MASKING_KEY_LENGTH;
+
+    return cat_true;
+}
+
+static cat_bool_t cat_websocket_status_code_is_valid(cat_websocket_status_code_t code)
+{
+    if (code >= 3000 && code <= 4999) {
+        return cat_true;
+    }
+    switch (code) {
+        case CAT_WEBSOCKET_STATUS_NORMAL_CLOSURE:
+        case CAT_WEBSOCKET_STATUS_GOING_AWAY:
+        case CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR:
+        case CAT_WEBSOCKET_STATUS_UNSUPPORTED_DATA:
+        case CAT_WEBSOCKET_STATUS_INVALID_FRAME_PAYLOAD_DATA:
+        case CAT_WEBSOCKET_STATUS_POLICY_VIOLATION:
+        case CAT_WEBSOCKET_STATUS_MESSAGE_TOO_BIG:
+        case CAT_WEBSOCKET_STATUS_MISSING_EXTENSION:
+        case CAT_WEBSOCKET_STATUS_INTERNAL_ERROR:
+        case CAT_WEBSOCKET_STATUS_SERVICE_RESTART:
+        case CAT_WEBSOCKET_STATUS_TRY_AGAIN_LATER:
+        case CAT_WEBSOCKET_STATUS_BAD_GATEWAY:
+            return cat_true;
+        default:
+            return cat_false;
+    }
+}
+
+/* the connection can not be used anymore, tell peer why if necessary, and then report the error */
+static void cat_websocket_codec_fail(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_websocket_status_code_t status_code, cat_errno_t error, const char *format, ...) CAT_ATTRIBUTE_FORMAT(printf, 5, 6);
+
+static void cat_websocket_codec_fail(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_websocket_status_code_t status_code, cat_errno_t error, const char *format, ...)
+{
+    va_list args;
+
+    codec->broken = cat_true;
+    if ((codec->flags & CAT_WEBSOCKET_CODEC_FLAG_AUTO_CLOSE) && !codec->close_sent) {
+        (void) cat_websocket_send_close_ex(socket, codec, status_code, NULL, 0, cat_socket_get_write_timeout(socket));
+    }
+    va_start(args, format);
+    cat_update_last_error_va_list(error, format, args);
+    va_end(args);
+}
+
+/* read payload of the current frame into the place, unmask it and update UTF-8 state if it is not NULL */
+static cat_bool_t cat_websocket_codec_read_payload(cat_socket_t *socket, char *to, size_t length, const char *masking_key, cat_websocket_utf8_state_t *utf8_state, cat_timeout_t timeout)
+{
+    const char *data;
+    size_t offset = 0, buffered_length, n;
+    ssize_t nread;
+
+    while (offset < length) {
+        size_t left = length - offset;
+        if (left > CAT_SOCKET_READER_BUFFER_DEFAULT_SIZE && cat_socket_get_read_buffered_length(socket) == 0) {
+            /* large payload is read into the place directly to avoid copying */
+            CAT_TIME_WAIT_START() {
+                nread = cat_socket_read_ex(socket, to + offset, left, timeout);
+            } CAT_TIME_WAIT_END(timeout);
+            if (unlikely(nread != (ssize_t) left)) {
+                return cat_false;
+            }
+            (void) cat_websocket_unmask_to(to + offset, to + offset, left, masking_key, offset, utf8_state);
+            return cat_true;
+        }
+        CAT_TIME_WAIT_START() {
+            data = cat_socket_read_ahead_ex(socket, 1, &buffered_length, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(data == NULL)) {
+            return cat_false;
+        }
+        n = CAT_MIN(buffered_length, left);
+        /* unmask from the reader buffer to the place, copying is fused */
+        (void) cat_websocket_unmask_to(data, to + offset, n, masking_key, offset, utf8_state);
+        (void) cat_socket_read_skip(socket, n);
+        offset += n;
+    }
+
+    return cat_true;
+}
+
+/* append payload of the current frame to the buffer, the buffer grows as bytes arrive
+ * instead of being prepared for the announced length up front */
+static cat_bool_t cat_websocket_codec_read_payload_to_buffer(cat_socket_t *socket, cat_buffer_t *buffer, size_t length, const char *masking_key, cat_websocket_utf8_state_t *utf8_state, cat_timeout_t timeout)
+{
+    char rotated_masking_key[CAT_WEBSOCKET_MASKING_KEY_LENGTH];
+    size_t offset = 0;
+
+    while (offset < length) {
+        const char *chunk_masking_key = masking_key;
+        size_t n = CAT_MAX(CAT_MAX(buffer->size - buffer->length, offset), CAT_WEBSOCKET_RECV_CHUNK_SIZE);
+        cat_bool_t ret;
+        n = CAT_MIN(n, length - offset);
+        if (unlikely(!cat_buffer_prepare(buffer, n))) {
+            return cat_false;
+        }
+        if (masking_key != NULL && (offset & 3) != 0) {
+            size_t i;
+            for (i = 0; i < CAT_WEBSOCKET_MASKING_KEY_LENGTH; i++) {
+                rotated_masking_key[i] = masking_key[(offset + i) & 3];
+            }
+            chunk_masking_key = rotated_masking_key;
+        }
+        CAT_TIME_WAIT_START() {
+            ret = cat_websocket_codec_read_payload(socket, buffer->value + buffer->length, n, chunk_masking_key, utf8_state, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(!ret)) {
+            return cat_false;
+        }
+        buffer->length += n;
+        offset += n;
+    }
+
+    return cat_true;
+}
+
+#ifdef CAT_HAVE_ZLIB
+static cat_bool_t cat_websocket_codec_inflate(cat_socket_t *socket, cat_websocket_codec_t *codec, const char *data, size_t length, cat_bool_t fin, cat_buffer_t *buffer)
+{
+    z_stream *stream = (z_stream *) codec->inflate_stream;
+    cat_bool_t validate_utf8 = codec->message_opcode == CAT_WEBSOCKET_OPCODE_TEXT &&
+        (codec->flags & CAT_WEBSOCKET_CODEC_FLAG_VALIDATE_UTF8);
+    int round;
+
+    /* peer removed the tail of sync flush at the end of message, we append it back */
+    for (round = 0; round < 2; round++) {
+        if (round == 0) {
+            stream->next_in = (Bytef *) data;
+            stream->avail_in = (uInt) length;
+        } else if (fin) {
+            stream->next_in = (Bytef *) CAT_WEBSOCKET_DEFLATE_TRAILER;
+            stream->avail_in = CAT_STRLEN(CAT_WEBSOCKET_DEFLATE_TRAILER);
+        } else {
+            break;
+        }
+        do {
+            size_t available, produced;
+            int error;
+            if (unlikely(!cat_buffer_prepare(buffer, CAT_WEBSOCKET_INFLATE_CHUNK_SIZE))) {
+                codec->broken = cat_true;
+                cat_update_last_error_with_previous("WebSocket inflate buffer prepare failed");
+                return cat_false;
+            }
+            available = CAT_MIN(buffer->size - buffer->length, UINT_MAX);
+            if (codec->max_message_length != 0) {
+                /* one more byte is enough to know it exceeds the limit */
+                available = CAT_MIN(available, codec->max_message_length - (buffer->length - codec->message_offset) + 1);
+            }
+            stream->next_out = (Bytef *) (buffer->value + buffer->length);
+            stream->avail_out = (uInt) available;
+            error = inflate(stream, Z_SYNC_FLUSH);
+            produced = available - stream->avail_out;
+            if (produced > 0 && validate_utf8 && codec->utf8_state != CAT_WEBSOCKET_UTF8_REJECT) {
+                codec->utf8_state = cat_websocket_utf8_validate_internal(buffer->value + buffer->length, produced, codec->utf8_state);
+            }
+            buffer->length += produced;
+            if (unlikely(codec->utf8_state == CAT_WEBSOCKET_UTF8_REJECT)) {
+                cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_INVALID_FRAME_PAYLOAD_DATA, CAT_EILSEQ, "WebSocket text message is not valid UTF-8");
+                return cat_false;
+            }
+            if (unlikely(codec->max_message_length != 0 && buffer->length - codec->message_offset > codec->max_message_length)) {
+                cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_MESSAGE_TOO_BIG, CAT_EMSGSIZE,
+                    "WebSocket message length exceeds the limit %" PRIu64, codec->max_message_length);
+                return cat_false;
+            }
+            if (error == Z_STREAM_END) {
+                /* peer finished the deflate stream with a final block, start a new one */
+                (void) inflateReset(stream);
+            } else if (error == Z_BUF_ERROR) {
+                /* no progress was possible, all input has been consumed */
+                break;
+            } else if (unlikely(error != Z_OK)) {
+                cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_INVALID_FRAME_PAYLOAD_DATA, CAT_EPROTO,
+                    "WebSocket inflate failed: %s", stream->msg != NULL ? stream->msg : "unknown error");
+                return cat_false;
+            }
+        } while (stream->avail_in > 0 || stream->avail_out == 0);
+    }
+    if (fin && codec->inflate_no_context_takeover) {
+        (void) inflateReset(stream);
+    }
+
+    return cat_true;
+}
+
+static cat_bool_t cat_websocket_codec_deflate(cat_websocket_codec_t *codec, const char *data, size_t length, cat_buffer_t *output)
+{
+    z_stream *stream = (z_stream *) codec->deflate_stream;
+
+    output->length = 0;
+    /* sync flush may output a few bytes more than deflateBound() */
+    if (unlikely(!cat_buffer_prepare(output, deflateBound(stream, (uLong) length) + 16))) {
+        cat_update_last_error_with_previous("WebSocket deflate buffer prepare failed");
+        return cat_false;
+    }
+    stream->next_in = (Bytef *) data;
+    stream->avail_in = (uInt) length;
+    while (1) {
+        size_t available = CAT_MIN(output->size - output->length, UINT_MAX);
+        int error;
+        stream->next_out = (Bytef *) (output->value + output->length);
+        stream->avail_out = (uInt) available;
+        error = deflate(stream, Z_SYNC_FLUSH);
+        output->length += available - stream->avail_out;
+        if (unlikely(error != Z_OK && error != Z_BUF_ERROR)) {
+            cat_update_last_error(CAT_EPROTO, "WebSocket deflate failed: %s", stream->msg != NULL ? stream->msg : "unknown error");
+            return cat_false;
+        }
+        if (stream->avail_in == 0 && stream->avail_out != 0) {
+            break;
+        }
+        if (unlikely(!cat_buffer_extend(output, output->size + 1))) {
+            cat_update_last_error_with_previous("WebSocket deflate buffer extend failed");
+            return cat_false;
+        }
+    }
+    /* remove the tail of sync flush (RFC 7692 7.2.1) */
+    CAT_ASSERT(output->length >= CAT_STRLEN(CAT_WEBSOCKET_DEFLATE_TRAILER));
+    CAT_ASSERT(memcmp(output->value + output->length - CAT_STRLEN(CAT_WEBSOCKET_DEFLATE_TRAILER), CAT_STRL(CAT_WEBSOCKET_DEFLATE_TRAILER)) == 0);
+    output->length -= CAT_STRLEN(CAT_WEBSOCKET_DEFLATE_TRAILER);
+    if (codec->deflate_no_context_takeover) {
+        (void) deflateReset(stream);
+    }
+
+    return cat_true;
+}
+#endif
+
+static cat_bool_t cat_websocket_codec_handle_close(cat_socket_t *socket, cat_websocket_codec_t *codec)
+{
+    const char *payload = codec->control_payload;
+    size_t length = codec->control_payload_length;
+    cat_websocket_status_code_t code = 0;
+
+    codec->close_received = cat_true;
+    if (length != 0) {
+        if (unlikely(length < CAT_WEBSOCKET_STATUS_CODE_LENGTH)) {
+            cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, CAT_EPROTO, "WebSocket close frame payload is too short");
+            return cat_false;
+        }
+        code = ntohs(*((uint16_t *) payload));
+        if (unlikely(!cat_websocket_status_code_is_valid(code))) {
+            cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, CAT_EPROTO, "WebSocket close status code %u is invalid", (unsigned int) code);
+            return cat_false;
+        }
+        if (codec->flags & CAT_WEBSOCKET_CODEC_FLAG_VALIDATE_UTF8) {
+            cat_websocket_utf8_state_t state = CAT_WEBSOCKET_UTF8_ACCEPT;
+            state = cat_websocket_utf8_validate_internal(payload + CAT_WEBSOCKET_STATUS_CODE_LENGTH, length - CAT_WEBSOCKET_STATUS_CODE_LENGTH, state);
+            if (unlikely(state != CAT_WEBSOCKET_UTF8_ACCEPT)) {
+                cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_INVALID_FRAME_PAYLOAD_DATA, CAT_EILSEQ, "WebSocket close reason is not valid UTF-8");
+                return cat_false;
+            }
+        }
+    }
+    if ((codec->flags & CAT_WEBSOCKET_CODEC_FLAG_AUTO_CLOSE) && !codec->close_sent) {
+        /* echo the status code, failure is ignored because peer may have closed the connection */
+        (void) cat_websocket_send_close_ex(socket, codec, code, NULL, 0, cat_socket_get_write_timeout(socket));
+    }
+
+    return cat_true;
+}
+
+CAT_API int cat_websocket_recv_message(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_buffer_t *buffer)
+{
+    return cat_websocket_recv_message_ex(socket, codec, buffer, cat_socket_get_read_timeout(socket));
+}
+
+CAT_API int cat_websocket_recv_message_ex(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_buffer_t *buffer, cat_timeout_t timeout)
+{
+    cat_bool_t is_client = CAT_WEBSOCKET_CODEC_IS_CLIENT(codec);
+
+    if (unlikely(codec->broken)) {
+        cat_update_last_error(CAT_EPROTO, "WebSocket connection is broken");
+        return -1;
+    }
+    if (unlikely(codec->close_received)) {
+        cat_update_last_error(CAT_ECONNRESET, "WebSocket close frame has been received");
+        return -1;
+    }
+    if (codec->message_opcode == CAT_WEBSOCKET_OPCODE_CONTINUATION) {
+        codec->message_offset = buffer->length;
+    }
+
+    while (1) {
+        cat_websocket_header_t header;
+        const char *data, *masking_key;
+        size_t buffered_length, header_size;
+        uint64_t payload_length;
+        cat_websocket_opcode_t opcode;
+        cat_bool_t ret;
+
+        /* header may be incomplete in the reader buffer */
+        CAT_TIME_WAIT_START() {
+            data = cat_socket_read_ahead_ex(socket, CAT_WEBSOCKET_HEADER_MIN_SIZE, &buffered_length, timeout);
+        } CAT_TIME_WAIT_END(timeout);
+        if (unlikely(data == NULL)) {
+            cat_update_last_error_with_previous("WebSocket read frame header failed");
+            return -1;
+        }
+        memcpy(&header, data, CAT_WEBSOCKET_HEADER_MIN_SIZE);
+        header_size = (size_t) cat_websocket_header_get_size(&header);
+        if (buffered_length < header_size) {
+            CAT_TIME_WAIT_START() {
+                data = cat_socket_read_ahead_ex(socket, header_size, &buffered_length, timeout);
+            } CAT_TIME_WAIT_END(timeout);
+            if (unlikely(data == NULL)) {
+                codec->broken = cat_true;
+                cat_update_last_error_with_previous("WebSocket read frame header failed");
+                return -1;
+            }
+        }
+        memcpy(&header, data, header_size);
+        (void) cat_socket_read_skip(socket, header_size);
+        opcode = header.opcode;
+        payload_length = cat_websocket_header_get_payload_length(&header);
+        masking_key = header.mask ? cat_websocket_header_get_masking_key(&header) : NULL;
+
+        /* validate frame */
+        if (unlikely(header.rsv2 || header.rsv3 ||
+            (header.rsv1 && (!codec->deflate_enabled || CAT_WEBSOCKET_OPCODE_IS_CONTROL(opcode) || opcode == CAT_WEBSOCKET_OPCODE_CONTINUATION)))) {
+            cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, CAT_EPROTO, "WebSocket frame has unexpected reserved bits");
+            return -1;
+        }
+        if (unlikely((!!header.mask) == is_client)) {
+            cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, CAT_EPROTO,
+                "WebSocket frame from %s must %sbe masked", is_client ? "server" : "client", is_client ? "not " : "");
+            return -1;
+        }
+        switch (opcode) {
+            case CAT_WEBSOCKET_OPCODE_CONTINUATION:
+                if (unlikely(codec->message_opcode == CAT_WEBSOCKET_OPCODE_CONTINUATION)) {
+                    cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, CAT_EPROTO, "WebSocket continuation frame is unexpected");
+                    return -1;
+                }
+                break;
+            case CAT_WEBSOCKET_OPCODE_TEXT:
+            case CAT_WEBSOCKET_OPCODE_BINARY:
+                if (unlikely(codec->message_opcode != CAT_WEBSOCKET_OPCODE_CONTINUATION)) {
+                    cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, CAT_EPROTO, "WebSocket message is interleaved before the previous one was finished");
+                    return -1;
+                }
+                break;
+            case CAT_WEBSOCKET_OPCODE_CLOSE:
+            case CAT_WEBSOCKET_OPCODE_PING:
+            case CAT_WEBSOCKET_OPCODE_PONG:
+                if (unlikely(!header.fin || payload_length > CAT_WEBSOCKET_CONTROL_FRAME_MAX_PAYLOAD_LENGTH)) {
+                    cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, CAT_EPROTO, "WebSocket control frame can not be fragmented or longer than 125");
+                    return -1;
+                }
+                break;
+            default:
+                cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_PROTOCOL_ERROR, CAT_EPROTO, "WebSocket opcode %u is unknown", (unsigned int) opcode);
+                return -1;
+        }
+
+        /* control frame may be injected in the middle of a fragmented message */
+        if (CAT_WEBSOCKET_OPCODE_IS_CONTROL(opcode)) {
+            ret = cat_websocket_codec_read_payload(socket, codec->control_payload, (size_t) payload_length, masking_key, NULL, timeout);
+            if (unlikely(!ret)) {
+                codec->broken = cat_true;
+                cat_update_last_error_with_previous("WebSocket read control frame payload failed");
+                return -1;
+            }
+            codec->control_payload_length = (uint8_t) payload_length;
+            if (opcode == CAT_WEBSOCKET_OPCODE_CLOSE) {
+                if (unlikely(!cat_websocket_codec_handle_close(socket, codec))) {
+                    return -1;
+                }
+                return opcode;
+            }
+            if (!(codec->flags & CAT_WEBSOCKET_CODEC_FLAG_AUTO_PONG)) {
+                return opcode;
+            }
+            if (opcode == CAT_WEBSOCKET_OPCODE_PING && !codec->close_sent) {
+                ret = cat_websocket_send_message_ex(socket, codec, CAT_WEBSOCKET_OPCODE_PONG, codec->control_payload, codec->control_payload_length, cat_socket_get_write_timeout(socket));
+                if (unlikely(!ret)) {
+                    codec->broken = cat_true;
+                    cat_update_last_error_with_previous("WebSocket reply pong failed");
+                    return -1;
+                }
+            }
+            continue;
+        }
+
+        /* data frame */
+        if (opcode != CAT_WEBSOCKET_OPCODE_CONTINUATION) {
+            codec->message_opcode = opcode;
+            codec->message_compressed = header.rsv1;
+            codec->utf8_state = CAT_WEBSOCKET_UTF8_ACCEPT;
+        }
+        if (unlikely(payload_length > SIZE_MAX - buffer->length ||
+            (codec->max_message_length != 0 && payload_length > codec->max_message_length - (buffer->length - codec->message_offset)))) {
+            cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_MESSAGE_TOO_BIG, CAT_EMSGSIZE,
+                "WebSocket message length exceeds the limit %" PRIu64, codec->max_message_length);
+            return -1;
+        }
+#ifdef CAT_HAVE_ZLIB
+        if (codec->message_compressed) {
+            cat_buffer_t *recv_buffer = &codec->recv_buffer;
+            recv_buffer->length = 0;
+            ret = cat_websocket_codec_read_payload_to_buffer(socket, recv_buffer, (size_t) payload_length, masking_key, NULL, timeout);
+            if (unlikely(!ret)) {
+                codec->broken = cat_true;
+                cat_update_last_error_with_previous("WebSocket read frame payload failed");
+                return -1;
+            }
+            if (unlikely(!cat_websocket_codec_inflate(socket, codec, recv_buffer->value, recv_buffer->length, header.fin, buffer))) {
+                return -1;
+            }
+        } else
+#endif
+        {
+            cat_websocket_utf8_state_t *utf8_state = NULL;
+            if (codec->message_opcode == CAT_WEBSOCKET_OPCODE_TEXT && (codec->flags & CAT_WEBSOCKET_CODEC_FLAG_VALIDATE_UTF8)) {
+                utf8_state = &codec->utf8_state;
+            }
+            ret = cat_websocket_codec_read_payload_to_buffer(socket, buffer, (size_t) payload_length, masking_key, utf8_state, timeout);
+            if (unlikely(!ret)) {
+                codec->broken = cat_true;
+                cat_update_last_error_with_previous("WebSocket read frame payload failed");
+                return -1;
+            }
+            if (unlikely(codec->utf8_state == CAT_WEBSOCKET_UTF8_REJECT)) {
+                cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_INVALID_FRAME_PAYLOAD_DATA, CAT_EILSEQ, "WebSocket text message is not valid UTF-8");
+                return -1;
+            }
+        }
+        if (!header.fin) {
+            continue;
+        }
+        /* message is complete */
+        if (unlikely(codec->utf8_state != CAT_WEBSOCKET_UTF8_ACCEPT)) {
+            cat_websocket_codec_fail(socket, codec, CAT_WEBSOCKET_STATUS_INVALID_FRAME_PAYLOAD_DATA, CAT_EILSEQ, "WebSocket text message ends with an incomplete UTF-8 sequence");
+            return -1;
+        }
+        opcode = codec->message_opcode;
+        codec->message_opcode = CAT_WEBSOCKET_OPCODE_CONTINUATION;
+        codec->message_compressed = cat_false;
+        return opcode;
+    }
+}
+
+CAT_API const char *cat_websocket_codec_get_control_payload(const cat_websocket_codec_t *codec, size_t *length)
+{
+    *length = codec->control_payload_length;
+    return codec->control_payload;
+}
+
+CAT_API cat_bool_t cat_websocket_send_message(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_websocket_opcode_t opcode, const char *data, size_t length)
+{
+    return cat_websocket_send_message_ex(socket, codec, opcode, data, length, cat_socket_get_write_timeout(socket));
+}
+
+CAT_API cat_bool_t cat_websocket_send_message_ex(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_websocket_opcode_t opcode, const char *data, size_t length, cat_timeout_t timeout)
+{
+    cat_bool_t is_client = CAT_WEBSOCKET_CODEC_IS_CLIENT(codec);
+    cat_bool_t compress = cat_false;
+    cat_websocket_header_t header;
+    char masking_key[CAT_WEBSOCKET_MASKING_KEY_LENGTH];
+    cat_socket_write_vector_t vector[2];
+    cat_buffer_t *send_buffer = NULL, temp_buffer;
+    cat_bool_t ret = cat_false;
+
+    switch (opcode) {
+        case CAT_WEBSOCKET_OPCODE_TEXT:
+        case CAT_WEBSOCKET_OPCODE_BINARY:
+            compress = codec->deflate_enabled && length >= codec->deflate_threshold;
+            break;
+        case CAT_WEBSOCKET_OPCODE_CLOSE:
+        case CAT_WEBSOCKET_OPCODE_PING:
+        case CAT_WEBSOCKET_OPCODE_PONG:
+            if (unlikely(length > CAT_WEBSOCKET_CONTROL_FRAME_MAX_PAYLOAD_LENGTH)) {
+                cat_update_last_error(CAT_EINVAL, "WebSocket control frame payload length can not be greater than 125");
+                return cat_false;
+            }
+            break;
+        default:
+            cat_update_last_error(CAT_EINVAL, "WebSocket opcode %u can not be sent as a message", (unsigned int) opcode);
+            return cat_false;
+    }
+    if (unlikely(codec->close_sent)) {
+        cat_update_last_error(CAT_EPIPE, "WebSocket close frame has been sent");
+        return cat_false;
+    }
+    if (opcode == CAT_WEBSOCKET_OPCODE_CLOSE) {
+        codec->close_sent = cat_true;
+    }
+
+    if (compress || is_client) {
+        /* send buffer is in use if another coroutine is waiting for writing */
+        if (!codec->sending) {
+            send_buffer = &codec->send_buffer;
+            codec->sending = cat_true;
+        } else {
+            send_buffer = &temp_buffer;
+            cat_buffer_init(send_buffer);
+        }
+        send_buffer->length = 0;
+    }
+#ifdef CAT_HAVE_ZLIB
+    if (compress) {
+        if (unlikely(!cat_websocket_codec_deflate(codec, data, length, send_buffer))) {
+            goto _out;
+        }
+        data = send_buffer->value;
+        length = send_buffer->length;
+    }
+#endif
+    cat_websocket_header_init(&header);
+    header.fin = 1;
+    header.rsv1 = compress;
+    header.opcode = opcode;
+    if (is_client) {
+        if (unlikely(!cat_websocket_codec_generate_masking_key(codec, masking_key))) {
+            cat_update_last_error_with_previous("WebSocket generate masking key failed");
+            goto _out;
+        }
+        if (!compress) {
+            if (unlikely(!cat_buffer_prepare(send_buffer, length))) {
+                cat_update_last_error_with_previous("WebSocket send buffer prepare failed");
+                goto _out;
+            }
+        }
+        /* it is in place if data has been compressed into the send buffer */
+        cat_websocket_mask(data, send_buffer->value, length, masking_key);
+        data = send_buffer->value;
+        cat_websocket_header_set_payload_info(&header, length, masking_key);
+    } else {
+        cat_websocket_header_set_payload_info(&header, length, NULL);
+    }
+    vector[0] = cat_socket_write_vector_init((const char *) &header, (cat_socket_vector_length_t) cat_websocket_header_get_size(&header));
+    vector[1] = cat_socket_write_vector_init(data, (cat_socket_vector_length_t) length);
+    ret = cat_socket_write_ex(socket, vector, length != 0 ? 2 : 1, timeout);
+    if (unlikely(!ret)) {
+        cat_update_last_error_with_previous("WebSocket send message failed");
+    }
+
+    _out:
+    if (send_buffer == &temp_buffer) {
+        cat_buffer_close(send_buffer);
+    } else if (send_buffer != NULL) {
+        codec->sending = cat_false;
+    }
+    return ret;
+}
+
+CAT_API cat_bool_t cat_websocket_send_close(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_websocket_status_code_t code, const char *reason, size_t reason_length)
+{
+    return cat_websocket_send_close_ex(socket, codec, code, reason, reason_length, cat_socket_get_write_timeout(socket));
+}
+
+CAT_API cat_bool_t cat_websocket_send_close_ex(cat_socket_t *socket, cat_websocket_codec_t *codec, cat_websocket_status_code_t code, const char *reason, size_t reason_length, cat_timeout_t timeout)
+{
+    char payload[CAT_WEBSOCKET_CONTROL_FRAME_MAX_PAYLOAD_LENGTH];
+    size_t length = 0;
+
+    /* 0 means close without status code */
+    if (code != 0) {
+        uint16_t network_code = htons(code);
+        if (unlikely(reason_length > sizeof(payload) - CAT_WEBSOCKET_STATUS_CODE_LENGTH)) {
+            cat_update_last_error(CAT_EINVAL, "WebSocket close reason length can not be greater than 123");
+            return cat_false;
+        }
+        memcpy(payload, &network_code, sizeof(network_code));
+        if (reason_length != 0) {
+            memcpy(payload + CAT_WEBSOCKET_STATUS_CODE_LENGTH, reason, reason_length);
+        }
+        length = CAT_WEBSOCKET_STATUS_CODE_LENGTH + reason_length;
+    }
+
+    return cat_websocket_send_message_ex(socket, codec, CAT_WEBSOCKET_OPCODE_CLOSE, payload, length, timeout);
+}
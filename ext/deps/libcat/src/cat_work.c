@@ -21,70 +21,675 @@
 #include "cat_event.h"
 #include "cat_time.h"
 
-typedef struct cat_work_context_s {
-    union {
-        cat_coroutine_t *coroutine;
-        uv_req_t req;
-        uv_work_t work;
-    } request;
+#ifdef CAT_IDE_HELPER
+#include "uv-common.h"
+#else
+#include "../deps/libuv/src/uv-common.h"
+#endif
+
+#ifndef CAT_OS_WIN
+#include <pthread.h>
+#endif
+
+#define CAT_WORK_SLAB_SIZE 64
+
+#define CAT_WORK_CHECK_KIND(kind, failure) do { \
+    if (unlikely((unsigned int) (kind) >= CAT_WORK_KIND_COUNT)) { \
+        cat_update_last_error(CAT_EINVAL, "Unknown work kind %d", (int) (kind)); \
+        failure; \
+    } \
+} while (0)
+
+typedef enum cat_work_state_e {
+    CAT_WORK_STATE_QUEUED,
+    CAT_WORK_STATE_RUNNING,
+    CAT_WORK_STATE_DONE,
+} cat_work_state_t;
+
+typedef struct cat_work_waiter_s {
+    cat_coroutine_t *coroutine;
+    /* all contexts submitted by this waiter */
+    cat_queue_t contexts;
+    size_t pending;
+} cat_work_waiter_t;
+
+struct cat_work_context_s {
+    /* in pool queue / done queue / free list */
+    cat_queue_node_t node;
+    cat_queue_node_t waiter_node;
+    /* runtime which submitted it, finished work will be posted back to it */
+    cat_work_globals_t *runtime;
+    /* NULL if waiter has gone */
+    cat_work_waiter_t *waiter;
+    cat_work_job_t *job;
     cat_work_function_t function;
     cat_work_cleanup_callback_t cleanup;
     cat_data_t *data;
+    cat_work_kind_t kind;
+    /* protected by pool mutex */
+    cat_work_state_t state;
     int status;
-} cat_work_context_t;
+    /* loop side has seen its result */
+    cat_bool_t completed;
+    uint64_t queued_time;
+};
+
+typedef struct cat_work_slab_s {
+    cat_queue_node_t node;
+    cat_work_context_t contexts[CAT_WORK_SLAB_SIZE];
+} cat_work_slab_t;
+
+typedef struct cat_work_pool_s {
+    uv_mutex_t mutex;
+    uv_cond_t cond;
+    cat_queue_t queue;
+    uv_thread_t *threads;
+    unsigned int threads_size;
+    unsigned int idle;
+    cat_bool_t stop;
+    cat_work_pool_stats_t stats;
+} cat_work_pool_t;
+
+/* pools are shared by all threads (runtimes) */
+static cat_work_pool_t cat_work_pools[CAT_WORK_KIND_COUNT];
+
+static const char *cat_work_kind_names[CAT_WORK_KIND_COUNT] = { "CPU", "FAST_IO", "SLOW_IO" };
+
+/* pool (any thread) */
 
-void cat_work_callback(uv_work_t *request)
+static void cat_work_post(cat_work_context_t *context)
 {
-    cat_work_context_t *context = (cat_work_context_t *) request;
-    context->function(context->data);
+    cat_work_globals_t *runtime = context->runtime;
+    cat_bool_t notify;
+
+    uv_mutex_lock(&runtime->mutex);
+    /* only the first one of a burst needs to wake up the loop */
+    notify = cat_queue_empty(&runtime->done);
+    cat_queue_push_back(&runtime->done, &context->node);
+    /* loop may close the runtime as soon as it sees the context,
+     * so async must be sent before the mutex is released */
+    if (notify) {
+        (void) uv_async_send(&runtime->async);
+    }
+    uv_mutex_unlock(&runtime->mutex);
 }
 
-static void cat_work_after_done(uv_work_t *request, int status)
+static void cat_work_pool_thread(void *arg)
 {
-    cat_work_context_t *context = (cat_work_context_t *) request;
+    cat_work_pool_t *pool = (cat_work_pool_t *) arg;
+    cat_work_context_t *context;
+    uint64_t start_time, end_time, time;
+
+    uv_mutex_lock(&pool->mutex);
+    while (1) {
+        if (pool->stop) {
+            break;
+        }
+        if (cat_queue_empty(&pool->queue) || pool->stats.running >= pool->stats.size) {
+            pool->idle++;
+            uv_cond_wait(&pool->cond, &pool->mutex);
+            pool->idle--;
+            continue;
+        }
+        context = cat_queue_front_data(&pool->queue, cat_work_context_t, node);
+        cat_queue_remove(&context->node);
+        context->state = CAT_WORK_STATE_RUNNING;
+        pool->stats.queued--;
+        pool->stats.running++;
+        start_time = uv_hrtime();
+        time = start_time - context->queued_time;
+        pool->stats.wait_time += time;
+        if (time > pool->stats.max_wait_time) {
+            pool->stats.max_wait_time = time;
+        }
+        uv_mutex_unlock(&pool->mutex);
+
+        context->function(context->data);
+        end_time = uv_hrtime();
 
-    if (likely(context->request.coroutine != NULL)) {
-        context->status = status;
-        cat_coroutine_schedule(context->request.coroutine, WORK, "Work");
+        uv_mutex_lock(&pool->mutex);
+        context->state = CAT_WORK_STATE_DONE;
+        pool->stats.running--;
+        pool->stats.completed++;
+        time = end_time - start_time;
+        pool->stats.run_time += time;
+        if (time > pool->stats.max_run_time) {
+            pool->stats.max_run_time = time;
+        }
+        uv_mutex_unlock(&pool->mutex);
+
+        /* context may be recycled after posted */
+        context->status = 0;
+        cat_work_post(context);
+
+        uv_mutex_lock(&pool->mutex);
     }
+    uv_mutex_unlock(&pool->mutex);
+}
 
-    if (context->cleanup != NULL) {
-        context->cleanup(context->data);
+/* called with pool mutex locked */
+static cat_bool_t cat_work_pool_spawn(cat_work_pool_t *pool)
+{
+    int error;
+
+    if (pool->stats.threads == pool->threads_size) {
+        unsigned int threads_size = pool->threads_size == 0 ? 4 : pool->threads_size * 2;
+        uv_thread_t *threads = (uv_thread_t *) cat_sys_realloc_recoverable(pool->threads, sizeof(*threads) * threads_size);
+        if (unlikely(threads == NULL)) {
+            cat_update_last_error_of_syscall("Realloc for work pool threads failed");
+            return cat_false;
+        }
+        pool->threads = threads;
+        pool->threads_size = threads_size;
     }
-    cat_free(context);
+    error = uv_thread_create(&pool->threads[pool->stats.threads], cat_work_pool_thread, pool);
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "Work pool thread create failed");
+        return cat_false;
+    }
+    pool->stats.threads++;
+
+    return cat_true;
 }
 
-CAT_API cat_bool_t cat_work(cat_work_kind_t kind, cat_work_function_t function, cat_work_cleanup_callback_t cleanup, cat_data_t *data, cat_timeout_t timeout)
+static cat_bool_t cat_work_pool_submit(cat_work_pool_t *pool, cat_work_context_t *context)
+{
+    uv_mutex_lock(&pool->mutex);
+    if (pool->idle == 0 && pool->stats.threads < pool->stats.size) {
+        /* start threads on demand */
+        if (unlikely(!cat_work_pool_spawn(pool) && pool->stats.threads == 0)) {
+            uv_mutex_unlock(&pool->mutex);
+            return cat_false;
+        }
+    }
+    context->state = CAT_WORK_STATE_QUEUED;
+    context->queued_time = uv_hrtime();
+    cat_queue_push_back(&pool->queue, &context->node);
+    pool->stats.submitted++;
+    pool->stats.queued++;
+    if (pool->stats.queued > pool->stats.max_queued) {
+        pool->stats.max_queued = pool->stats.queued;
+    }
+    if (pool->idle > 0) {
+        uv_cond_signal(&pool->cond);
+    }
+    uv_mutex_unlock(&pool->mutex);
+
+    return cat_true;
+}
+
+static cat_bool_t cat_work_pool_cancel(cat_work_pool_t *pool, cat_work_context_t *context)
 {
-    cat_work_context_t *context = (cat_work_context_t *) cat_malloc(sizeof(*context));
     cat_bool_t ret;
 
-#if CAT_ALLOC_HANDLE_ERRORS
+    uv_mutex_lock(&pool->mutex);
+    ret = context->state == CAT_WORK_STATE_QUEUED;
+    if (ret) {
+        cat_queue_remove(&context->node);
+        context->state = CAT_WORK_STATE_DONE;
+        context->status = CAT_ECANCELED;
+        pool->stats.queued--;
+        pool->stats.canceled++;
+    }
+    uv_mutex_unlock(&pool->mutex);
+
+    return ret;
+}
+
+static void cat_work_pool_init(cat_work_pool_t *pool, unsigned int size)
+{
+    (void) uv_mutex_init(&pool->mutex);
+    (void) uv_cond_init(&pool->cond);
+    cat_queue_init(&pool->queue);
+    pool->threads = NULL;
+    pool->threads_size = 0;
+    pool->idle = 0;
+    pool->stop = cat_false;
+    memset(&pool->stats, 0, sizeof(pool->stats));
+    pool->stats.size = size;
+}
+
+static void cat_work_pool_close(cat_work_pool_t *pool)
+{
+    unsigned int n;
+
+    uv_mutex_lock(&pool->mutex);
+    pool->stop = cat_true;
+    uv_cond_broadcast(&pool->cond);
+    uv_mutex_unlock(&pool->mutex);
+    for (n = 0; n < pool->stats.threads; n++) {
+        (void) uv_thread_join(&pool->threads[n]);
+    }
+    if (pool->threads != NULL) {
+        cat_sys_free(pool->threads);
+    }
+    uv_cond_destroy(&pool->cond);
+    uv_mutex_destroy(&pool->mutex);
+}
+
+#ifndef CAT_OS_WIN
+/* threads are gone in the child process */
+static void cat_work_atfork_child(void)
+{
+    size_t n;
+
+    for (n = 0; n < CAT_ARRAY_SIZE(cat_work_pools); n++) {
+        cat_work_pool_t *pool = &cat_work_pools[n];
+        cat_work_pool_stats_t stats = pool->stats;
+        cat_work_pool_init(pool, stats.size);
+    }
+}
+#endif
+
+/* runtime (loop thread) */
+
+static cat_work_context_t *cat_work_context_alloc(void)
+{
+    cat_work_context_t *context;
+
+    context = cat_queue_front_data(&CAT_WORK_G(free_contexts), cat_work_context_t, node);
     if (unlikely(context == NULL)) {
-        cat_update_last_error_of_syscall("Malloc for work context failed");
-        if (cleanup != NULL) {
-            cleanup(data);
+        cat_work_slab_t *slab = (cat_work_slab_t *) cat_malloc(sizeof(*slab));
+        size_t n;
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(slab == NULL)) {
+            cat_update_last_error_of_syscall("Malloc for work slab failed");
+            return NULL;
+        }
+#endif
+        cat_queue_push_back(&CAT_WORK_G(slabs), &slab->node);
+        for (n = 0; n < CAT_WORK_SLAB_SIZE; n++) {
+            cat_queue_push_back(&CAT_WORK_G(free_contexts), &slab->contexts[n].node);
+        }
+        context = &slab->contexts[0];
+    }
+    cat_queue_remove(&context->node);
+
+    return context;
+}
+
+static void cat_work_context_release(cat_work_context_t *context)
+{
+    /* hot one first */
+    cat_queue_push_front(&CAT_WORK_G(free_contexts), &context->node);
+}
+
+static void cat_work_context_cleanup(cat_work_context_t *context)
+{
+    if (context->cleanup != NULL) {
+        context->cleanup(context->data);
+    }
+    cat_work_context_release(context);
+}
+
+static void cat_work_inflight_decrease(void)
+{
+    CAT_ASSERT(CAT_WORK_G(inflight) > 0);
+    if (--CAT_WORK_G(inflight) == 0) {
+        uv_unref((uv_handle_t *) &CAT_WORK_G(async));
+    }
+}
+
+static void cat_work_complete(cat_work_context_t *context)
+{
+    cat_work_waiter_t *waiter = context->waiter;
+
+    cat_work_inflight_decrease();
+    context->completed = cat_true;
+    if (waiter == NULL) {
+        /* waiter has gone */
+        cat_work_context_cleanup(context);
+        return;
+    }
+    context->job->status = context->status;
+    if (--waiter->pending == 0) {
+        /* waiter stack may be gone after resumed */
+        cat_queue_t contexts;
+        cat_queue_init(&contexts);
+        while ((context = cat_queue_front_data(&waiter->contexts, cat_work_context_t, waiter_node))) {
+            cat_queue_remove(&context->waiter_node);
+            cat_queue_push_back(&contexts, &context->waiter_node);
+        }
+        if (waiter->coroutine != NULL) {
+            cat_coroutine_schedule(waiter->coroutine, WORK, "Work");
+        }
+        /* clean up after waiter consumed the results */
+        while ((context = cat_queue_front_data(&contexts, cat_work_context_t, waiter_node))) {
+            cat_queue_remove(&context->waiter_node);
+            cat_work_context_cleanup(context);
+        }
+    } /* else cleanup will be delayed until all works of the waiter are done */
+}
+
+static void cat_work_runtime_close(cat_work_globals_t *runtime);
+
+static void cat_work_async_callback(uv_async_t *handle)
+{
+    cat_work_globals_t *runtime = cat_container_of(handle, cat_work_globals_t, async);
+    cat_work_context_t *context;
+    cat_queue_t done;
+
+    cat_queue_init(&done);
+    uv_mutex_lock(&runtime->mutex);
+    while ((context = cat_queue_front_data(&runtime->done, cat_work_context_t, node))) {
+        cat_queue_remove(&context->node);
+        cat_queue_push_back(&done, &context->node);
+    }
+    uv_mutex_unlock(&runtime->mutex);
+
+    while ((context = cat_queue_front_data(&done, cat_work_context_t, node))) {
+        cat_queue_remove(&context->node);
+        cat_work_complete(context);
+    }
+
+    if (unlikely(runtime->closing) && runtime->inflight == 0) {
+        cat_work_runtime_close(runtime);
+    }
+}
+
+static void cat_work_waiter_abandon(cat_work_waiter_t *waiter)
+{
+    cat_work_context_t *context;
+
+    while ((context = cat_queue_front_data(&waiter->contexts, cat_work_context_t, waiter_node))) {
+        cat_queue_remove(&context->waiter_node);
+        context->job->status = CAT_ECANCELED;
+        if (context->completed) {
+            /* done and completed, but waiting for others */
+            cat_work_context_cleanup(context);
+        } else if (cat_work_pool_cancel(&cat_work_pools[context->kind], context)) {
+            cat_work_inflight_decrease();
+            cat_work_context_cleanup(context);
+        } else {
+            /* it is running or will be posted back, clean up it later */
+            context->waiter = NULL;
+            context->job = NULL;
+        }
+    }
+    waiter->pending = 0;
+}
+
+CAT_API CAT_GLOBALS_DECLARE(cat_work);
+
+CAT_API cat_bool_t cat_work_module_init(void)
+{
+    static const int default_sizes[CAT_WORK_KIND_COUNT] = { 0 /* parallelism */, 4, 2 };
+    size_t n;
+
+    CAT_GLOBALS_REGISTER(cat_work);
+
+    for (n = 0; n < CAT_ARRAY_SIZE(cat_work_pools); n++) {
+        char name[64];
+        int size;
+        (void) snprintf(name, sizeof(name), "CAT_WORK_%s_POOL_SIZE", cat_work_kind_names[n]);
+        size = default_sizes[n] != 0 ? default_sizes[n] : (int) uv_available_parallelism();
+        size = cat_env_get_i(name, size);
+        if (size < 1) {
+            size = 1;
+        } else if (size > CAT_WORK_POOL_MAX_SIZE) {
+            size = CAT_WORK_POOL_MAX_SIZE;
         }
+        cat_work_pool_init(&cat_work_pools[n], (unsigned int) size);
+    }
+#ifndef CAT_OS_WIN
+    (void) pthread_atfork(NULL, NULL, cat_work_atfork_child);
+#endif
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_work_module_shutdown(void)
+{
+    size_t n;
+
+    for (n = 0; n < CAT_ARRAY_SIZE(cat_work_pools); n++) {
+        cat_work_pool_close(&cat_work_pools[n]);
+    }
+
+    CAT_GLOBALS_UNREGISTER(cat_work);
+
+    return cat_true;
+}
+
+static void cat_work_runtime_shutdown_callback(cat_data_t *data)
+{
+    (void) data;
+    (void) cat_work_runtime_shutdown();
+}
+
+CAT_API cat_bool_t cat_work_runtime_init(void)
+{
+    int error;
+
+    error = uv_async_init(&CAT_EVENT_G(loop), &CAT_WORK_G(async), cat_work_async_callback);
+    if (unlikely(error != 0)) {
+        cat_update_last_error_with_reason(error, "Work async init failed");
         return cat_false;
     }
+    /* it only keeps loop alive when there are works in flight */
+    uv_unref((uv_handle_t *) &CAT_WORK_G(async));
+    CAT_WORK_G(async).flags |= UV_HANDLE_INTERNAL;
+    (void) uv_mutex_init(&CAT_WORK_G(mutex));
+    cat_queue_init(&CAT_WORK_G(done));
+    CAT_WORK_G(inflight) = 0;
+    CAT_WORK_G(closing) = cat_false;
+    cat_queue_init(&CAT_WORK_G(free_contexts));
+    cat_queue_init(&CAT_WORK_G(slabs));
+
+    if (unlikely(cat_event_register_runtime_shutdown_task(cat_work_runtime_shutdown_callback, NULL) == NULL)) {
+        cat_update_last_error_with_previous("Work register runtime shutdown task failed");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+static void cat_work_runtime_close(cat_work_globals_t *runtime)
+{
+    cat_work_slab_t *slab;
+
+    runtime->closing = cat_false;
+    /* wait for the last poster to leave the critical section */
+    uv_mutex_lock(&runtime->mutex);
+    uv_close((uv_handle_t *) &runtime->async, NULL);
+    uv_mutex_unlock(&runtime->mutex);
+    uv_mutex_destroy(&runtime->mutex);
+    while ((slab = cat_queue_front_data(&runtime->slabs, cat_work_slab_t, node))) {
+        cat_queue_remove(&slab->node);
+        cat_free(slab);
+    }
+    cat_queue_init(&runtime->free_contexts);
+}
+
+CAT_API cat_bool_t cat_work_runtime_shutdown(void)
+{
+    cat_work_globals_t *runtime = CAT_GLOBALS_BULK(cat_work);
+    size_t n;
+
+    /* cancel works which have not been started */
+    for (n = 0; n < CAT_ARRAY_SIZE(cat_work_pools); n++) {
+        cat_work_pool_t *pool = &cat_work_pools[n];
+        cat_queue_t canceled;
+        cat_work_context_t *context;
+        cat_queue_init(&canceled);
+        uv_mutex_lock(&pool->mutex);
+        cat_queue_node_t *node = cat_queue_next(&pool->queue);
+        while (node != &pool->queue) {
+            context = cat_queue_data(node, cat_work_context_t, node);
+            node = cat_queue_next(node);
+            if (context->runtime != runtime) {
+                continue;
+            }
+            cat_queue_remove(&context->node);
+            context->state = CAT_WORK_STATE_DONE;
+            context->status = CAT_ECANCELED;
+            pool->stats.queued--;
+            pool->stats.canceled++;
+            cat_queue_push_back(&canceled, &context->node);
+        }
+        uv_mutex_unlock(&pool->mutex);
+        while ((context = cat_queue_front_data(&canceled, cat_work_context_t, node))) {
+            cat_queue_remove(&context->node);
+            cat_work_complete(context);
+        }
+    }
+    /* running works can not be canceled, and pool threads still refer to the runtime,
+     * async keeps the loop alive until they are posted back (without blocking the loop),
+     * then the runtime is closed by the async callback */
+    if (runtime->inflight > 0) {
+        runtime->closing = cat_true;
+        return cat_true;
+    }
+    cat_work_runtime_close(runtime);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_work_many(cat_work_kind_t kind, cat_work_job_t *jobs, size_t count, cat_timeout_t timeout)
+{
+    cat_work_pool_t *pool;
+    cat_work_waiter_t waiter;
+    cat_work_job_t *job;
+    size_t n;
+    cat_bool_t ret;
+
+    CAT_WORK_CHECK_KIND(kind, goto _error);
+    pool = &cat_work_pools[kind];
+
+    waiter.coroutine = NULL;
+    waiter.pending = 0;
+    cat_queue_init(&waiter.contexts);
+    for (n = 0, job = jobs; n < count; n++, job++) {
+        cat_work_context_t *context = cat_work_context_alloc();
+#if CAT_ALLOC_HANDLE_ERRORS
+        if (unlikely(context == NULL)) {
+            goto _submit_error;
+        }
 #endif
-    context->function = function;
-    context->cleanup = cleanup;
-    context->data = data;
-    (void) uv_queue_work_ex(&CAT_EVENT_G(loop), &context->request.work, (uv_work_kind) kind, cat_work_callback, cat_work_after_done);
-    context->status = CAT_ECANCELED;
-    context->request.coroutine = CAT_COROUTINE_G(current);
+        context->runtime = CAT_GLOBALS_BULK(cat_work);
+        context->waiter = &waiter;
+        context->job = job;
+        context->function = job->function;
+        context->cleanup = job->cleanup;
+        context->data = job->data;
+        context->kind = kind;
+        context->status = CAT_ECANCELED;
+        context->completed = cat_false;
+        job->status = CAT_ECANCELED;
+        if (unlikely(!cat_work_pool_submit(pool, context))) {
+            cat_work_context_release(context);
+            goto _submit_error;
+        }
+        cat_queue_push_back(&waiter.contexts, &context->waiter_node);
+        waiter.pending++;
+        if (CAT_WORK_G(inflight)++ == 0) {
+            uv_ref((uv_handle_t *) &CAT_WORK_G(async));
+        }
+    }
+    if (count == 0) {
+        return cat_true;
+    }
+
+    waiter.coroutine = CAT_COROUTINE_G(current);
     ret = cat_time_wait(timeout);
-    context->request.coroutine = NULL;
+    waiter.coroutine = NULL;
     if (unlikely(!ret)) {
         cat_update_last_error_with_previous("Work wait failed");
-        (void) uv_cancel(&context->request.req);
+        cat_work_waiter_abandon(&waiter);
         return cat_false;
     }
-    if (unlikely(context->status != 0)) {
-        cat_update_last_error_with_reason(context->status, "Work failed");
+    if (unlikely(waiter.pending != 0)) {
+        cat_update_last_error(CAT_ECANCELED, "Work has been canceled");
+        cat_work_waiter_abandon(&waiter);
         return cat_false;
     }
 
     return cat_true;
+
+    _submit_error:
+    cat_update_last_error_with_previous("Work submit failed");
+    cat_work_waiter_abandon(&waiter);
+    /* clean up the rest jobs */
+    for (; n < count; n++, job++) {
+        job->status = CAT_ECANCELED;
+        if (job->cleanup != NULL) {
+            job->cleanup(job->data);
+        }
+    }
+    return cat_false;
+    _error:
+    for (n = 0, job = jobs; n < count; n++, job++) {
+        job->status = CAT_EINVAL;
+        if (job->cleanup != NULL) {
+            job->cleanup(job->data);
+        }
+    }
+    return cat_false;
+}
+
+CAT_API cat_bool_t cat_work(cat_work_kind_t kind, cat_work_function_t function, cat_work_cleanup_callback_t cleanup, cat_data_t *data, cat_timeout_t timeout)
+{
+    cat_work_job_t job;
+
+    job.function = function;
+    job.cleanup = cleanup;
+    job.data = data;
+
+    if (unlikely(!cat_work_many(kind, &job, 1, timeout))) {
+        return cat_false;
+    }
+    if (unlikely(job.status != 0)) {
+        cat_update_last_error_with_reason(job.status, "Work failed");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+/* pool */
+
+CAT_API unsigned int cat_work_pool_get_size(cat_work_kind_t kind)
+{
+    cat_work_pool_t *pool;
+    unsigned int size;
+
+    CAT_WORK_CHECK_KIND(kind, return 0);
+    pool = &cat_work_pools[kind];
+    uv_mutex_lock(&pool->mutex);
+    size = pool->stats.size;
+    uv_mutex_unlock(&pool->mutex);
+
+    return size;
+}
+
+CAT_API cat_bool_t cat_work_pool_set_size(cat_work_kind_t kind, unsigned int size)
+{
+    cat_work_pool_t *pool;
+
+    CAT_WORK_CHECK_KIND(kind, return cat_false);
+    if (unlikely(size < 1 || size > CAT_WORK_POOL_MAX_SIZE)) {
+        cat_update_last_error(CAT_EINVAL, "Work pool size should be in range [1, %u]", CAT_WORK_POOL_MAX_SIZE);
+        return cat_false;
+    }
+    pool = &cat_work_pools[kind];
+    uv_mutex_lock(&pool->mutex);
+    /* threads are never stopped, extra threads just keep idle if size was reduced */
+    pool->stats.size = size;
+    uv_cond_broadcast(&pool->cond);
+    uv_mutex_unlock(&pool->mutex);
+
+    return cat_true;
+}
+
+CAT_API cat_bool_t cat_work_pool_get_stats(cat_work_kind_t kind, cat_work_pool_stats_t *stats)
+{
+    cat_work_pool_t *pool;
+
+    CAT_WORK_CHECK_KIND(kind, return cat_false);
+    pool = &cat_work_pools[kind];
+    uv_mutex_lock(&pool->mutex);
+    *stats = pool->stats;
+    uv_mutex_unlock(&pool->mutex);
+
+    return cat_true;
 }
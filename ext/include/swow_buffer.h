@@ -50,6 +50,9 @@ typedef struct swow_buffer_s {
 /* loader */
 
 zend_result swow_buffer_module_init(INIT_FUNC_ARGS);
+zend_result swow_buffer_module_shutdown(INIT_FUNC_ARGS);
+zend_result swow_buffer_runtime_init(INIT_FUNC_ARGS);
+zend_result swow_buffer_runtime_shutdown(SHUTDOWN_FUNC_ARGS);
 
 /* helper */
 
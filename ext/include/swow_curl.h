@@ -25,6 +25,8 @@ extern "C" {
 #include "swow.h"
 
 #ifdef CAT_HAVE_CURL
+extern SWOW_API zend_class_entry *swow_curl_ce;
+
 zend_result swow_curl_module_init(INIT_FUNC_ARGS);
 zend_result swow_curl_module_shutdown(INIT_FUNC_ARGS);
 zend_result swow_curl_runtime_init(INIT_FUNC_ARGS);
@@ -26,6 +26,9 @@ extern "C" {
 
 #include "cat_dns.h"
 
+extern SWOW_API zend_class_entry *swow_dns_ce;
+extern SWOW_API zend_class_entry *swow_dns_exception_ce;
+
 /* loader */
 
 zend_result swow_dns_module_init(INIT_FUNC_ARGS);
@@ -43,6 +43,7 @@ typedef struct swow_http_parser_s {
 /* loader */
 
 zend_result swow_http_module_init(INIT_FUNC_ARGS);
+zend_result swow_http_module_shutdown(INIT_FUNC_ARGS);
 
 /* helper*/
 
@@ -32,5 +32,7 @@ extern cat_bool_t swow_pgsql_hooked;
 
 zend_result swow_pgsql_module_init(INIT_FUNC_ARGS);
 zend_result swow_pgsql_module_shutdown(INIT_FUNC_ARGS);
+zend_result swow_pgsql_runtime_init(INIT_FUNC_ARGS);
+zend_result swow_pgsql_runtime_close(void);
 
 #endif // SWOW_PGSQL_H
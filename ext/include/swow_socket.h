@@ -25,6 +25,7 @@ extern "C" {
 #include "swow.h"
 
 #include "cat_socket.h"
+#include "cat_websocket.h"
 
 extern SWOW_API zend_class_entry *swow_socket_ce;
 extern SWOW_API zend_object_handlers swow_socket_handlers;
@@ -33,6 +34,8 @@ extern SWOW_API zend_class_entry *swow_socket_exception_ce;
 
 typedef struct swow_socket_s {
     cat_socket_t socket;
+    /* native WebSocket frame codec, it is created by enableWebSocket() */
+    cat_websocket_codec_t *websocket_codec;
     zend_object std;
 } swow_socket_t;
 
@@ -24,6 +24,7 @@ extern "C" {
 
 #include "swow.h"
 #include "cat_socket.h"
+#include "cat_poll.h"
 #include "cat_ssl.h"
 
 #include "php_network.h" /* for php_netstream_data_t */
@@ -75,6 +76,8 @@ typedef struct swow_netstream_ssl_s {
 typedef struct swow_netstream_data_s {
     php_netstream_data_t sock;
     cat_socket_t socket;
+    /* created on demand for stream_select() */
+    cat_poll_watcher_t *poll_watcher;
 #ifdef CAT_SSL
     swow_netstream_ssl_t ssl;
 #endif
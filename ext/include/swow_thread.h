@@ -0,0 +1,86 @@
+/*
+  +--------------------------------------------------------------------------+
+  | Swow                                                                     |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#ifndef SWOW_THREAD_H
+#define SWOW_THREAD_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "swow.h"
+
+#include "cat_thread_channel.h"
+
+/* Swow\Thread runs a PHP script in an isolated interpreter (with its own event loop and scheduler) on a new OS thread,
+ * it is only available on ZTS builds */
+
+#ifdef ZTS
+#define SWOW_THREAD 1
+#endif
+
+extern SWOW_API zend_class_entry *swow_thread_ce;
+extern SWOW_API zend_object_handlers swow_thread_handlers;
+
+extern SWOW_API zend_class_entry *swow_thread_exception_ce;
+
+typedef struct swow_thread_context_s swow_thread_context_t;
+
+typedef struct swow_thread_s {
+    swow_thread_context_t *context;
+    zend_object std;
+} swow_thread_t;
+
+CAT_GLOBALS_STRUCT_BEGIN(swow_thread) {
+    /* context of current thread (created on demand) */
+    swow_thread_context_t *current;
+    /* arguments from parent thread */
+    zval arguments;
+    /* children which have not been joined yet */
+    cat_queue_t children;
+    /* coroutines which are waiting for space in mailboxes of other threads */
+    cat_queue_t senders;
+    /* wake up parent when state of children changed,
+     * and wake up senders when receivers popped messages */
+    uv_async_t notifier;
+    cat_bool_t notifier_initialized;
+    size_t waiters;
+    /* runtime is shutting down, close it once all children exited */
+    cat_bool_t closing;
+} CAT_GLOBALS_STRUCT_END(swow_thread);
+
+extern SWOW_API CAT_GLOBALS_DECLARE(swow_thread);
+
+#define SWOW_THREAD_G(x) CAT_GLOBALS_GET(swow_thread, x)
+
+/* loader */
+
+zend_result swow_thread_module_init(INIT_FUNC_ARGS);
+zend_result swow_thread_module_shutdown(INIT_FUNC_ARGS);
+zend_result swow_thread_runtime_init(INIT_FUNC_ARGS);
+
+/* helper*/
+
+static zend_always_inline swow_thread_t *swow_thread_get_from_object(zend_object *object)
+{
+    return cat_container_of(object, swow_thread_t, std);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SWOW_THREAD_H */
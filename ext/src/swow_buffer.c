@@ -832,6 +832,97 @@ static PHP_METHOD(Swow_Buffer, close)
     swow_buffer_close(s_buffer);
 }
 
+#define arginfo_class_Swow_Buffer_recycle arginfo_class_Swow_Buffer_isAvailable
+
+static PHP_METHOD(Swow_Buffer, recycle)
+{
+    swow_buffer_t *s_buffer = getThisBuffer();
+    SWOW_BUFFER_CHECK_LOCK(s_buffer);
+    zend_string *string;
+    bool ret;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    string = swow_buffer_get_string(s_buffer);
+    /* only the value which is not shared can be reused by others */
+    if (string == NULL || GC_REFCOUNT(string) != 1 || ZSTR_IS_INTERNED(string) || (GC_FLAGS(string) & IS_STR_PERSISTENT)) {
+        swow_buffer_close(s_buffer);
+        RETURN_FALSE;
+    }
+    zend_string_forget_hash_val(string);
+    ret = cat_buffer_pool_recycle(&s_buffer->buffer);
+    swow_buffer_reset(s_buffer);
+
+    RETURN_BOOL(ret);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Buffer_enablePool, 0, 0, IS_VOID, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, blockSize, IS_LONG, 0, "Swow\\Buffer::COMMON_SIZE")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxSize, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Buffer, enablePool)
+{
+    zend_long block_size = CAT_BUFFER_COMMON_SIZE;
+    zend_long max_size = 0;
+
+    ZEND_PARSE_PARAMETERS_START(0, 2)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(block_size)
+        Z_PARAM_LONG(max_size)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(block_size <= 0)) {
+        zend_argument_value_error(1, "must be greater than 0");
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(max_size < 0)) {
+        zend_argument_value_error(2, "can not be negative");
+        RETURN_THROWS();
+    }
+
+    if (UNEXPECTED(!cat_buffer_pool_register(block_size, max_size))) {
+        swow_throw_exception_with_last(swow_buffer_exception_ce);
+        RETURN_THROWS();
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Buffer_disablePool, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Buffer, disablePool)
+{
+    cat_buffer_pool_stats_t stats;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    cat_buffer_pool_get_stats(&stats);
+    if (stats.registered) {
+        (void) cat_buffer_pool_unregister();
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Buffer_getPoolStats, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Buffer, getPoolStats)
+{
+    cat_buffer_pool_stats_t stats;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    cat_buffer_pool_get_stats(&stats);
+
+    array_init(return_value);
+    add_assoc_bool(return_value, "enabled", stats.registered);
+    add_assoc_long(return_value, "block_size", (zend_long) stats.block_size);
+    add_assoc_long(return_value, "max_size", (zend_long) stats.max_size);
+    add_assoc_long(return_value, "count", (zend_long) stats.count);
+    add_assoc_long(return_value, "hits", (zend_long) stats.hits);
+    add_assoc_long(return_value, "misses", (zend_long) stats.misses);
+    add_assoc_long(return_value, "recycles", (zend_long) stats.recycles);
+}
+
 #define arginfo_class_Swow_Buffer___toString arginfo_class_Swow_Buffer_fetchString
 
 #define zim_Swow_Buffer___toString zim_Swow_Buffer_toString
@@ -950,6 +1041,10 @@ static const zend_function_entry swow_buffer_methods[] = {
     PHP_ME(Swow_Buffer, lock,              arginfo_class_Swow_Buffer_lock,              ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Buffer, unlock,            arginfo_class_Swow_Buffer_unlock,            ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Buffer, close,             arginfo_class_Swow_Buffer_close,             ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Buffer, recycle,           arginfo_class_Swow_Buffer_recycle,           ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Buffer, enablePool,        arginfo_class_Swow_Buffer_enablePool,        ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Buffer, disablePool,       arginfo_class_Swow_Buffer_disablePool,       ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Buffer, getPoolStats,      arginfo_class_Swow_Buffer_getPoolStats,      ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     /* magic */
     PHP_ME(Swow_Buffer, __toString,        arginfo_class_Swow_Buffer___toString,        ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Buffer, __debugInfo,       arginfo_class_Swow_Buffer___debugInfo,       ZEND_ACC_PUBLIC)
@@ -1086,3 +1181,31 @@ zend_result swow_buffer_module_init(INIT_FUNC_ARGS)
 
     return SUCCESS;
 }
+
+zend_result swow_buffer_module_shutdown(INIT_FUNC_ARGS)
+{
+    if (!cat_buffer_module_shutdown()) {
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+zend_result swow_buffer_runtime_init(INIT_FUNC_ARGS)
+{
+    if (!cat_buffer_runtime_init()) {
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+zend_result swow_buffer_runtime_shutdown(SHUTDOWN_FUNC_ARGS)
+{
+    /* idle values were allocated from the request memory */
+    if (!cat_buffer_runtime_shutdown()) {
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
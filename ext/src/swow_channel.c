@@ -169,6 +169,120 @@ static PHP_METHOD(Swow_Channel, pop)
     }
 }
 
+#define SWOW_CHANNEL_MANY_STACK_SIZE 16
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Channel_pushMany, 0, 1, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO(0, data, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 0, "-1")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Channel, pushMany)
+{
+    SWOW_CHANNEL_GETTER_CONSTRUCTED(s_channel, channel);
+    zval zs_data_stacked[SWOW_CHANNEL_MANY_STACK_SIZE], *zs_data, *z_data;
+    HashTable *data;
+    zend_long timeout = -1;
+    cat_channel_size_t count, n, i;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ARRAY_HT(data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(timeout)
+    ZEND_PARSE_PARAMETERS_END();
+
+    count = zend_hash_num_elements(data);
+    if (count == 0) {
+        RETURN_LONG(0);
+    }
+    /* no more than capacity items can be pushed at once */
+    if (channel->capacity == 0) {
+        count = 1;
+    } else if (count > channel->capacity) {
+        count = channel->capacity;
+    }
+    if (count <= SWOW_CHANNEL_MANY_STACK_SIZE) {
+        zs_data = zs_data_stacked;
+    } else {
+        zs_data = safe_emalloc(count, sizeof(*zs_data), 0);
+    }
+    i = 0;
+    ZEND_HASH_FOREACH_VAL(data, z_data) {
+        ZVAL_COPY(&zs_data[i], z_data);
+        if (++i == count) {
+            break;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    n = cat_channel_push_many(channel, zs_data, count, timeout);
+
+    /* release what has not been pushed */
+    for (i = n; i < count; i++) {
+        zval_ptr_dtor(&zs_data[i]);
+    }
+    if (zs_data != zs_data_stacked) {
+        efree(zs_data);
+    }
+    if (UNEXPECTED(n == 0)) {
+        swow_throw_exception_with_last(swow_channel_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_LONG(n);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Channel_popMany, 0, 1, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO(0, count, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 0, "-1")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Channel, popMany)
+{
+    SWOW_CHANNEL_GETTER_CONSTRUCTED(s_channel, channel);
+    zval zs_data[SWOW_CHANNEL_MANY_STACK_SIZE];
+    zend_long count;
+    zend_long timeout = -1;
+    cat_channel_size_t n, i;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_LONG(count)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(timeout)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(count <= 0)) {
+        zend_argument_value_error(1, "must be greater than 0");
+        RETURN_THROWS();
+    }
+    /* no more than capacity items can be popped at once */
+    if (channel->capacity == 0) {
+        count = 1;
+    } else if ((zend_ulong) count > channel->capacity) {
+        count = channel->capacity;
+    }
+
+    n = cat_channel_pop_many(channel, zs_data, (cat_channel_size_t) MIN(count, SWOW_CHANNEL_MANY_STACK_SIZE), timeout);
+
+    if (UNEXPECTED(n == 0)) {
+        swow_throw_exception_with_last(swow_channel_exception_ce);
+        RETURN_THROWS();
+    }
+    array_init_size(return_value, MIN((zend_ulong) count, n + channel->length));
+    while (1) {
+        for (i = 0; i < n; i++) {
+            add_next_index_zval(return_value, &zs_data[i]);
+        }
+        count -= n;
+        /* pop the rest in batches without waiting, so memory is never allocated more than the popped items */
+        if (count == 0 || channel->length == 0) {
+            break;
+        }
+        n = cat_channel_pop_many(channel, zs_data, (cat_channel_size_t) MIN(count, SWOW_CHANNEL_MANY_STACK_SIZE), 0);
+        if (n == 0) {
+            break;
+        }
+    }
+}
+
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Channel_close, 0, 0, IS_VOID, 0)
 ZEND_END_ARG_INFO()
 
@@ -317,6 +431,8 @@ static const zend_function_entry swow_channel_methods[] = {
     PHP_ME(Swow_Channel, __construct,  arginfo_class_Swow_Channel___construct,  ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Channel, push,         arginfo_class_Swow_Channel_push,         ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Channel, pop,          arginfo_class_Swow_Channel_pop,          ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Channel, pushMany,     arginfo_class_Swow_Channel_pushMany,     ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Channel, popMany,      arginfo_class_Swow_Channel_popMany,      ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Channel, close,        arginfo_class_Swow_Channel_close,        ZEND_ACC_PUBLIC)
     /* status */
     PHP_ME(Swow_Channel, getCapacity,  arginfo_class_Swow_Channel_getCapacity,  ZEND_ACC_PUBLIC)
@@ -345,9 +461,9 @@ static HashTable *swow_channel_get_gc(zend_object *object, zval **gc_data, int *
 
     zend_get_gc_buffer *zgc_buffer = zend_get_gc_buffer_create();
 
-    CAT_QUEUE_FOREACH_DATA_START(&channel->u.buffered.storage, cat_channel_bucket_t, node, bucket) {
-        zend_get_gc_buffer_add_zval(zgc_buffer, (zval *) bucket->data);
-    } CAT_QUEUE_FOREACH_DATA_END();
+    for (cat_channel_size_t index = 0; index < channel->length; index++) {
+        zend_get_gc_buffer_add_zval(zgc_buffer, (zval *) cat_channel_get_storage_item(channel, index));
+    }
 
     zend_get_gc_buffer_use(zgc_buffer, gc_data, gc_count);
 
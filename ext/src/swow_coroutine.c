@@ -20,6 +20,8 @@
 
 #include "swow_debug.h"
 
+#include "cat_watchdog.h"
+
 #ifdef SWOW_COROUTINE_MOCK_FIBER_CONTEXT
 # include "zend_observer.h"
 #endif
@@ -1704,6 +1706,170 @@ static PHP_METHOD(Swow_Coroutine, getGlobalSwitches)
     RETURN_LONG(CAT_COROUTINE_G(switches));
 }
 
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Coroutine_getStackPoolStats, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Coroutine, getStackPoolStats)
+{
+    cat_coroutine_stack_pool_stats_t stats;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    cat_coroutine_get_stack_pool_stats(&stats);
+
+    array_init(return_value);
+    add_assoc_long(return_value, "max_size", (zend_long) stats.max_size);
+    add_assoc_long(return_value, "hot_size", (zend_long) stats.hot_size);
+    add_assoc_long(return_value, "count", (zend_long) stats.count);
+    add_assoc_long(return_value, "hot_count", (zend_long) stats.hot_count);
+    add_assoc_long(return_value, "hits", (zend_long) stats.hits);
+    add_assoc_long(return_value, "misses", (zend_long) stats.misses);
+}
+
+#define arginfo_class_Swow_Coroutine_getPriority arginfo_class_Swow_Coroutine_getId
+
+static PHP_METHOD(Swow_Coroutine, getPriority)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_LONG(cat_coroutine_get_priority(&getThisCoroutine()->coroutine));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Coroutine_setPriority, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO(0, priority, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Coroutine, setPriority)
+{
+    zend_long priority;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(priority)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(priority < 0 || priority >= CAT_COROUTINE_PRIORITY_COUNT)) {
+        zend_argument_value_error(1, "must be one of Coroutine::PRIORITY_LOW, Coroutine::PRIORITY_NORMAL or Coroutine::PRIORITY_HIGH");
+        RETURN_THROWS();
+    }
+
+    (void) cat_coroutine_set_priority(&getThisCoroutine()->coroutine, (cat_coroutine_priority_t) priority);
+
+    RETURN_THIS();
+}
+
+#define arginfo_class_Swow_Coroutine_getWatchdogQuantum arginfo_class_Swow_Coroutine_getId
+
+static PHP_METHOD(Swow_Coroutine, getWatchdogQuantum)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_LONG(cat_watchdog_get_coroutine_quantum(&getThisCoroutine()->coroutine));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Coroutine_setWatchdogQuantum, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO(0, quantum, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Coroutine, setWatchdogQuantum)
+{
+    zend_long quantum;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(quantum)
+    ZEND_PARSE_PARAMETERS_END();
+
+    (void) cat_watchdog_set_coroutine_quantum(&getThisCoroutine()->coroutine, quantum);
+
+    RETURN_THIS();
+}
+
+#define arginfo_class_Swow_Coroutine_getWatchdogThreshold arginfo_class_Swow_Coroutine_getId
+
+static PHP_METHOD(Swow_Coroutine, getWatchdogThreshold)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_LONG(cat_watchdog_get_coroutine_threshold(&getThisCoroutine()->coroutine));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Coroutine_setWatchdogThreshold, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO(0, threshold, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Coroutine, setWatchdogThreshold)
+{
+    zend_long threshold;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(threshold)
+    ZEND_PARSE_PARAMETERS_END();
+
+    (void) cat_watchdog_set_coroutine_threshold(&getThisCoroutine()->coroutine, threshold);
+
+    RETURN_THIS();
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Coroutine_enableReadyQueue, 0, 0, IS_VOID, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, budgetCount, IS_LONG, 0, "0")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, budgetTime, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Coroutine, enableReadyQueue)
+{
+    zend_long budget_count = 0;
+    zend_long budget_time = 0;
+
+    ZEND_PARSE_PARAMETERS_START(0, 2)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(budget_count)
+        Z_PARAM_LONG(budget_time)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(budget_count < 0)) {
+        zend_argument_value_error(1, "must be greater than or equal to 0");
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(budget_time < 0)) {
+        zend_argument_value_error(2, "must be greater than or equal to 0");
+        RETURN_THROWS();
+    }
+
+    (void) cat_coroutine_set_ready_queue_budget_count((size_t) budget_count);
+    (void) cat_coroutine_set_ready_queue_budget_time((cat_usec_t) budget_time);
+    (void) cat_coroutine_set_ready_queue_enabled(cat_true);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Coroutine_disableReadyQueue, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Coroutine, disableReadyQueue)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    (void) cat_coroutine_set_ready_queue_enabled(cat_false);
+}
+
+#define arginfo_class_Swow_Coroutine_getReadyQueueStats arginfo_class_Swow_Coroutine_getStackPoolStats
+
+static PHP_METHOD(Swow_Coroutine, getReadyQueueStats)
+{
+    cat_coroutine_ready_queue_stats_t stats;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    cat_coroutine_get_ready_queue_stats(&stats);
+
+    array_init(return_value);
+    add_assoc_bool(return_value, "enabled", stats.enabled);
+    add_assoc_long(return_value, "budget_count", (zend_long) stats.budget_count);
+    add_assoc_long(return_value, "budget_time", (zend_long) stats.budget_time);
+    add_assoc_long(return_value, "count", (zend_long) stats.count);
+    add_assoc_long(return_value, "peak_count", (zend_long) stats.peak_count);
+    add_assoc_long(return_value, "rounds", (zend_long) stats.rounds);
+    add_assoc_long(return_value, "exhausted_rounds", (zend_long) stats.exhausted_rounds);
+    add_assoc_long(return_value, "resumes", (zend_long) stats.resumes);
+}
+
 #define arginfo_class_Swow_Coroutine_getStartTime arginfo_class_Swow_Coroutine_getId
 
 static PHP_METHOD(Swow_Coroutine, getStartTime)
@@ -2234,6 +2400,16 @@ static const zend_function_entry swow_coroutine_methods[] = {
     PHP_ME(Swow_Coroutine, getStateName,            arginfo_class_Swow_Coroutine_getStateName,            ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Coroutine, getSwitches,             arginfo_class_Swow_Coroutine_getSwitches,             ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Coroutine, getGlobalSwitches,       arginfo_class_Swow_Coroutine_getGlobalSwitches,       ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Coroutine, getStackPoolStats,       arginfo_class_Swow_Coroutine_getStackPoolStats,       ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Coroutine, getPriority,             arginfo_class_Swow_Coroutine_getPriority,             ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Coroutine, setPriority,             arginfo_class_Swow_Coroutine_setPriority,             ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Coroutine, getWatchdogQuantum,      arginfo_class_Swow_Coroutine_getWatchdogQuantum,      ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Coroutine, setWatchdogQuantum,      arginfo_class_Swow_Coroutine_setWatchdogQuantum,      ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Coroutine, getWatchdogThreshold,    arginfo_class_Swow_Coroutine_getWatchdogThreshold,    ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Coroutine, setWatchdogThreshold,    arginfo_class_Swow_Coroutine_setWatchdogThreshold,    ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Coroutine, enableReadyQueue,        arginfo_class_Swow_Coroutine_enableReadyQueue,        ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Coroutine, disableReadyQueue,       arginfo_class_Swow_Coroutine_disableReadyQueue,       ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Coroutine, getReadyQueueStats,      arginfo_class_Swow_Coroutine_getReadyQueueStats,      ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(Swow_Coroutine, getStartTime,            arginfo_class_Swow_Coroutine_getStartTime,            ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Coroutine, getEndTime,              arginfo_class_Swow_Coroutine_getEndTime,              ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Coroutine, getElapsed,              arginfo_class_Swow_Coroutine_getElapsed,              ZEND_ACC_PUBLIC)
@@ -2654,6 +2830,10 @@ zend_result swow_coroutine_module_init(INIT_FUNC_ARGS)
     zend_declare_class_constant_long(swow_coroutine_ce, ZEND_STRL("STATE_" #name), (value));
     CAT_COROUTINE_STATE_MAP(SWOW_COROUTINE_STATE_GEN)
 #undef SWOW_COROUTINE_STATE_GEN
+#define SWOW_COROUTINE_PRIORITY_GEN(name, value, unused) \
+    zend_declare_class_constant_long(swow_coroutine_ce, ZEND_STRL("PRIORITY_" #name), (value));
+    CAT_COROUTINE_PRIORITY_MAP(SWOW_COROUTINE_PRIORITY_GEN)
+#undef SWOW_COROUTINE_PRIORITY_GEN
 
     /* Exception for common errors */
     swow_coroutine_exception_ce = swow_register_internal_class(
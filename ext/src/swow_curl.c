@@ -25,6 +25,8 @@
 #include <curl/curl.h>
 #include <curl/multi.h>
 
+SWOW_API zend_class_entry *swow_curl_ce;
+
 #define CURLOPT_RETURNTRANSFER 19913
 #define CURLOPT_BINARYTRANSFER 19914 /* For Backward compatibility */
 #define PHP_CURL_STDOUT 0
@@ -299,7 +301,348 @@ static void swow_curl_multi_free_obj(zend_object *object)
     zend_object_std_dtor(&mh->std);
 }
 
-// TODO: hook curl_read()/curl_write()
+/* PHP callbacks may switch coroutines or rely on the calling one (and so do PHP streams),
+ * they must be called in the coroutine which called curl_exec() rather than the one
+ * which is driving the runtime multi handle, so we take over the callbacks of ext/curl */
+
+typedef struct swow_curl_call_context_s {
+    php_curl *ch;
+    zval *func_name;
+    zend_fcall_info_cache *fci_cache;
+    uint32_t argc;
+    zval *argv;
+    zval *retval;
+    zend_result error;
+} swow_curl_call_context_t;
+
+static void swow_curl_call_function(cat_data_t *data)
+{
+    swow_curl_call_context_t *context = (swow_curl_call_context_t *) data;
+    php_curl *ch = context->ch;
+    zend_fcall_info fci;
+
+    fci.size = sizeof(fci);
+    fci.object = NULL;
+    ZVAL_COPY_VALUE(&fci.function_name, context->func_name);
+    fci.retval = context->retval;
+    fci.param_count = context->argc;
+    fci.params = context->argv;
+    fci.named_params = NULL;
+
+    ch->in_callback = 1;
+    context->error = zend_call_function(&fci, context->fci_cache);
+    ch->in_callback = 0;
+    if (context->error == SUCCESS && !Z_ISUNDEF_P(context->retval)) {
+        _swow_php_curl_verify_handlers(ch, 1);
+    }
+}
+
+/* returns CAT_RET_NONE if transfer has been canceled and function was not called */
+static cat_ret_t swow_curl_call(php_curl *ch, zval *func_name, zend_fcall_info_cache *fci_cache, zval *retval, uint32_t argc, zval *argv)
+{
+    swow_curl_call_context_t context;
+
+    context.ch = ch;
+    context.func_name = func_name;
+    context.fci_cache = fci_cache;
+    context.argc = argc;
+    context.argv = argv;
+    context.retval = retval;
+    context.error = FAILURE;
+    ZVAL_UNDEF(retval);
+
+    if (UNEXPECTED(!cat_curl_easy_call(ch->cp, swow_curl_call_function, &context))) {
+        return CAT_RET_NONE;
+    }
+
+    return context.error == SUCCESS ? CAT_RET_OK : CAT_RET_ERROR;
+}
+
+static size_t swow_curl_write_user(php_curl *ch, php_curl_write *t, const char *name, char *data, size_t length)
+{
+    zval argv[2];
+    zval retval;
+    cat_ret_t ret;
+
+    GC_ADDREF(&ch->std);
+    ZVAL_OBJ(&argv[0], &ch->std);
+    ZVAL_STRINGL(&argv[1], data, length);
+
+    ret = swow_curl_call(ch, &t->func_name, &t->fci_cache, &retval, 2, argv);
+    if (ret != CAT_RET_OK) {
+        if (ret == CAT_RET_ERROR) {
+            php_error_docref(NULL, E_WARNING, "Could not call the %s", name);
+        }
+        length = -1;
+    } else if (!Z_ISUNDEF(retval)) {
+        length = zval_get_long(&retval);
+        zval_ptr_dtor(&retval);
+    }
+
+    zval_ptr_dtor(&argv[0]);
+    zval_ptr_dtor(&argv[1]);
+
+    return length;
+}
+
+static size_t swow_curl_write(char *data, size_t size, size_t nmemb, void *ctx)
+{
+    php_curl *ch = (php_curl *) ctx;
+    php_curl_write *t = CURL_HANDLERS_GET(ch, write);
+    size_t length = size * nmemb;
+
+    switch (t->method) {
+        case PHP_CURL_STDOUT:
+            PHPWRITE(data, length);
+            break;
+        case PHP_CURL_FILE:
+            return fwrite(data, size, nmemb, t->fp);
+        case PHP_CURL_RETURN:
+            if (length > 0) {
+                smart_str_appendl(&t->buf, data, (int) length);
+            }
+            break;
+        case PHP_CURL_USER:
+            return swow_curl_write_user(ch, t, "CURLOPT_WRITEFUNCTION", data, length);
+    }
+
+    return length;
+}
+
+static size_t swow_curl_write_header(char *data, size_t size, size_t nmemb, void *ctx)
+{
+    php_curl *ch = (php_curl *) ctx;
+    php_curl_write *t = CURL_HANDLERS_GET(ch, write_header);
+    size_t length = size * nmemb;
+
+    switch (t->method) {
+        case PHP_CURL_STDOUT:
+            /* Handle special case write when we're returning the entire transfer */
+            if (CURL_HANDLERS_GET(ch, write)->method == PHP_CURL_RETURN && length > 0) {
+                smart_str_appendl(&CURL_HANDLERS_GET(ch, write)->buf, data, (int) length);
+            } else {
+                PHPWRITE(data, length);
+            }
+            break;
+        case PHP_CURL_FILE:
+            return fwrite(data, size, nmemb, t->fp);
+        case PHP_CURL_USER:
+            return swow_curl_write_user(ch, t, "CURLOPT_HEADERFUNCTION", data, length);
+        case PHP_CURL_IGNORE:
+            return length;
+        default:
+            return -1;
+    }
+
+    return length;
+}
+
+static size_t swow_curl_read(char *data, size_t size, size_t nmemb, void *ctx)
+{
+    php_curl *ch = (php_curl *) ctx;
+    php_curl_read *t = CURL_HANDLERS_GET(ch, read);
+    int length = 0;
+
+    switch (t->method) {
+        case PHP_CURL_DIRECT:
+            if (t->fp) {
+                length = fread(data, size, nmemb, t->fp);
+            }
+            break;
+        case PHP_CURL_USER: {
+            zval argv[3];
+            zval retval;
+            cat_ret_t ret;
+
+            GC_ADDREF(&ch->std);
+            ZVAL_OBJ(&argv[0], &ch->std);
+            if (t->res) {
+                GC_ADDREF(t->res);
+                ZVAL_RES(&argv[1], t->res);
+            } else {
+                ZVAL_NULL(&argv[1]);
+            }
+            ZVAL_LONG(&argv[2], (int) size * nmemb);
+
+            ret = swow_curl_call(ch, &t->func_name, &t->fci_cache, &retval, 3, argv);
+            if (ret != CAT_RET_OK) {
+                if (ret == CAT_RET_ERROR) {
+                    php_error_docref(NULL, E_WARNING, "Cannot call the CURLOPT_READFUNCTION");
+                }
+                length = CURL_READFUNC_ABORT;
+            } else if (!Z_ISUNDEF(retval)) {
+                if (Z_TYPE(retval) == IS_STRING) {
+                    length = MIN((int) (size * nmemb), Z_STRLEN(retval));
+                    memcpy(data, Z_STRVAL(retval), length);
+                } else if (Z_TYPE(retval) == IS_LONG) {
+                    length = Z_LVAL_P(&retval);
+                }
+                zval_ptr_dtor(&retval);
+            }
+
+            zval_ptr_dtor(&argv[0]);
+            zval_ptr_dtor(&argv[1]);
+            break;
+        }
+    }
+
+    return length;
+}
+
+static size_t swow_curl_progress_user(php_curl *ch, php_curl_callback *t, const char *name, zend_long dltotal, zend_long dlnow, zend_long ultotal, zend_long ulnow)
+{
+    zval argv[5];
+    zval retval;
+    cat_ret_t ret;
+    size_t rval = 0;
+
+    GC_ADDREF(&ch->std);
+    ZVAL_OBJ(&argv[0], &ch->std);
+    ZVAL_LONG(&argv[1], dltotal);
+    ZVAL_LONG(&argv[2], dlnow);
+    ZVAL_LONG(&argv[3], ultotal);
+    ZVAL_LONG(&argv[4], ulnow);
+
+    ret = swow_curl_call(ch, &t->func_name, &t->fci_cache, &retval, 5, argv);
+    if (ret != CAT_RET_OK) {
+        if (ret == CAT_RET_ERROR) {
+            php_error_docref(NULL, E_WARNING, "Cannot call the %s", name);
+        } else {
+            rval = 1;
+        }
+    } else if (!Z_ISUNDEF(retval)) {
+        if (0 != zval_get_long(&retval)) {
+            rval = 1;
+        }
+        zval_ptr_dtor(&retval);
+    }
+
+    zval_ptr_dtor(&argv[0]);
+
+    return rval;
+}
+
+static size_t swow_curl_progress(void *clientp, double dltotal, double dlnow, double ultotal, double ulnow)
+{
+    php_curl *ch = (php_curl *) clientp;
+
+    return swow_curl_progress_user(
+        ch, CURL_HANDLERS_GET(ch, progress), "CURLOPT_PROGRESSFUNCTION",
+        (zend_long) dltotal, (zend_long) dlnow, (zend_long) ultotal, (zend_long) ulnow
+    );
+}
+
+#if PHP_VERSION_ID >= 80200
+# if LIBCURL_VERSION_NUM >= 0x072000
+static size_t swow_curl_xferinfo(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+{
+    php_curl *ch = (php_curl *) clientp;
+
+    return swow_curl_progress_user(
+        ch, CURL_HANDLERS_GET(ch, xferinfo), "CURLOPT_XFERINFOFUNCTION",
+        (zend_long) dltotal, (zend_long) dlnow, (zend_long) ultotal, (zend_long) ulnow
+    );
+}
+# endif
+#endif
+
+#if LIBCURL_VERSION_NUM >= 0x071500 /* Available since 7.21.0 */
+static int swow_curl_fnmatch(void *ctx, const char *pattern, const char *string)
+{
+    php_curl *ch = (php_curl *) ctx;
+    php_curl_callback *t = CURL_HANDLERS_GET(ch, fnmatch);
+    int rval = CURL_FNMATCHFUNC_FAIL;
+    zval argv[3];
+    zval retval;
+    cat_ret_t ret;
+
+    GC_ADDREF(&ch->std);
+    ZVAL_OBJ(&argv[0], &ch->std);
+    ZVAL_STRING(&argv[1], pattern);
+    ZVAL_STRING(&argv[2], string);
+
+    ret = swow_curl_call(ch, &t->func_name, &t->fci_cache, &retval, 3, argv);
+    if (ret == CAT_RET_ERROR) {
+        php_error_docref(NULL, E_WARNING, "Cannot call the CURLOPT_FNMATCH_FUNCTION");
+    } else if (ret == CAT_RET_OK && !Z_ISUNDEF(retval)) {
+        rval = zval_get_long(&retval);
+        zval_ptr_dtor(&retval);
+    }
+
+    zval_ptr_dtor(&argv[0]);
+    zval_ptr_dtor(&argv[1]);
+    zval_ptr_dtor(&argv[2]);
+
+    return rval;
+}
+#endif
+
+#if PHP_VERSION_ID >= 80300
+# if LIBCURL_VERSION_NUM >= 0x075400
+static int swow_curl_ssh_hostkeyfunction(void *clientp, int keytype, const char *key, size_t keylen)
+{
+    php_curl *ch = (php_curl *) clientp;
+    php_curl_callback *t = CURL_HANDLERS_GET(ch, sshhostkey);
+    int rval = CURLKHMATCH_MISMATCH; /* cancel connection in case of an exception */
+    zval argv[4];
+    zval retval;
+    cat_ret_t ret;
+
+    GC_ADDREF(&ch->std);
+    ZVAL_OBJ(&argv[0], &ch->std);
+    ZVAL_LONG(&argv[1], keytype);
+    ZVAL_STRINGL(&argv[2], key, keylen);
+    ZVAL_LONG(&argv[3], keylen);
+
+    ret = swow_curl_call(ch, &t->func_name, &t->fci_cache, &retval, 4, argv);
+    if (ret == CAT_RET_ERROR) {
+        php_error_docref(NULL, E_WARNING, "Cannot call the CURLOPT_SSH_HOSTKEYFUNCTION");
+    } else if (ret == CAT_RET_OK && !Z_ISUNDEF(retval)) {
+        if (Z_TYPE(retval) == IS_LONG && (Z_LVAL(retval) == CURLKHMATCH_OK || Z_LVAL(retval) == CURLKHMATCH_MISMATCH)) {
+            rval = (int) Z_LVAL(retval);
+        } else {
+            zend_throw_error(NULL, "The CURLOPT_SSH_HOSTKEYFUNCTION callback must return either CURLKHMATCH_OK or CURLKHMATCH_MISMATCH");
+        }
+        zval_ptr_dtor(&retval);
+    }
+
+    zval_ptr_dtor(&argv[0]);
+    zval_ptr_dtor(&argv[2]);
+
+    return rval;
+}
+# endif
+#endif
+
+/* data of callbacks is always the php_curl itself, only functions need to be replaced */
+static void _swow_php_curl_setup_callbacks(php_curl *ch)
+{
+    curl_easy_setopt(ch->cp, CURLOPT_WRITEFUNCTION, swow_curl_write);
+    curl_easy_setopt(ch->cp, CURLOPT_HEADERFUNCTION, swow_curl_write_header);
+    curl_easy_setopt(ch->cp, CURLOPT_READFUNCTION, swow_curl_read);
+    if (CURL_HANDLERS_GET(ch, progress)) {
+        curl_easy_setopt(ch->cp, CURLOPT_PROGRESSFUNCTION, swow_curl_progress);
+    }
+#if PHP_VERSION_ID >= 80200
+# if LIBCURL_VERSION_NUM >= 0x072000
+    if (CURL_HANDLERS_GET(ch, xferinfo)) {
+        curl_easy_setopt(ch->cp, CURLOPT_XFERINFOFUNCTION, swow_curl_xferinfo);
+    }
+# endif
+#endif
+#if LIBCURL_VERSION_NUM >= 0x071500 /* Available since 7.21.0 */
+    if (CURL_HANDLERS_GET(ch, fnmatch)) {
+        curl_easy_setopt(ch->cp, CURLOPT_FNMATCH_FUNCTION, swow_curl_fnmatch);
+    }
+#endif
+#if PHP_VERSION_ID >= 80300
+# if LIBCURL_VERSION_NUM >= 0x075400
+    if (CURL_HANDLERS_GET(ch, sshhostkey)) {
+        curl_easy_setopt(ch->cp, CURLOPT_SSH_HOSTKEYFUNCTION, swow_curl_ssh_hostkeyfunction);
+    }
+# endif
+#endif
+}
 
 /* {{{ Perform a cURL session */
 static PHP_FUNCTION(swow_curl_exec)
@@ -307,6 +650,7 @@ static PHP_FUNCTION(swow_curl_exec)
     CURLcode    error;
     zval        *zid;
     php_curl    *ch;
+    cat_curl_easy_perform_flags_t flags = CAT_CURL_EASY_PERFORM_FLAG_NONE;
 
     ZEND_PARSE_PARAMETERS_START(1, 1)
         Z_PARAM_OBJECT_OF_CLASS(zid, curl_ce)
@@ -318,8 +662,17 @@ static PHP_FUNCTION(swow_curl_exec)
 
     _swow_php_curl_cleanup_handle(ch);
 
-    error = cat_curl_easy_perform(ch->cp);
+    /* do not override the share handle set by user */
+    if (ch->share != NULL) {
+        flags |= CAT_CURL_EASY_PERFORM_FLAG_NO_SHARE;
+    }
+    _swow_php_curl_setup_callbacks(ch);
+    error = cat_curl_easy_perform_ex(ch->cp, flags);
     SAVE_CURL_ERROR(ch, error);
+    if (error == CURLE_ABORTED_BY_CALLBACK && cat_get_last_error_code() == CAT_ECANCELED) {
+        /* make curl_error() tell that it was canceled rather than aborted by a callback */
+        strlcpy(ch->err.str, cat_get_last_error_message(), sizeof(ch->err.str));
+    }
 
     if (error != CURLE_OK) {
         smart_str_free(&CURL_HANDLERS_GET(ch, write)->buf);
@@ -444,6 +797,41 @@ static PHP_FUNCTION(swow_curl_multi_select)
 }
 /* }}} */
 
+#define SWOW_CURL_SET_CONNECTIONS_METHOD(Name, name) \
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Curl_set##Name, 0, 1, IS_LONG, 0) \
+    ZEND_ARG_TYPE_INFO(0, name, IS_LONG, 0) \
+ZEND_END_ARG_INFO() \
+\
+static PHP_METHOD(Swow_Curl, set##Name) \
+{ \
+    zend_long name; \
+    \
+    ZEND_PARSE_PARAMETERS_START(1, 1) \
+        Z_PARAM_LONG(name) \
+    ZEND_PARSE_PARAMETERS_END(); \
+    \
+    if (UNEXPECTED(name < 0)) { \
+        zend_argument_value_error(1, "must be greater than or equal to 0"); \
+        RETURN_THROWS(); \
+    } \
+    \
+    RETURN_LONG(cat_curl_set_##name((long) name)); \
+}
+
+/* Set the per-host connection cap of the runtime shared multi handle, returns the original one */
+SWOW_CURL_SET_CONNECTIONS_METHOD(MaxHostConnections, max_host_connections)
+
+/* Set the total connection cap of the runtime shared multi handle, returns the original one */
+SWOW_CURL_SET_CONNECTIONS_METHOD(MaxTotalConnections, max_total_connections)
+
+#undef SWOW_CURL_SET_CONNECTIONS_METHOD
+
+static const zend_function_entry swow_curl_methods[] = {
+    PHP_ME(Swow_Curl, setMaxHostConnections,  arginfo_class_Swow_Curl_setMaxHostConnections,  ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Curl, setMaxTotalConnections, arginfo_class_Swow_Curl_setMaxTotalConnections, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_FE_END
+};
+
 zend_result swow_curl_module_init(INIT_FUNC_ARGS)
 {
     SWOW_MODULES_CHECK_PRE_START() {
@@ -474,6 +862,12 @@ zend_result swow_curl_module_init(INIT_FUNC_ARGS)
         return FAILURE;
     }
 
+    swow_curl_ce = swow_register_internal_class(
+        "Swow\\Curl", NULL, swow_curl_methods,
+        NULL, NULL, cat_false, cat_false,
+        swow_create_object_deny, NULL, 0
+    );
+
     return SUCCESS;
 }
 
@@ -19,6 +19,13 @@
 #include "swow_debug.h"
 
 #include "swow_coroutine.h"
+#include "swow_channel.h"
+
+#include "cat_io_uring.h"
+#include "cat_socket.h"
+#ifdef CAT_DEBUG
+#include "cat_thread_channel.h"
+#endif
 
 #include "zend_generators.h"
 
@@ -486,12 +493,341 @@ static PHP_FUNCTION(Swow_Debug_registerExtendedStatementHandler)
     RETURN_OBJ_COPY(&handler->std);
 }
 
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Swow_Debug_getIoUringStats, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_FUNCTION(Swow_Debug_getIoUringStats)
+{
+    cat_io_uring_stats_t stats;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    (void) cat_io_uring_get_stats(&stats);
+
+    array_init(return_value);
+    add_assoc_bool(return_value, "available", stats.available);
+    add_assoc_bool(return_value, "running", stats.running);
+    add_assoc_long(return_value, "entries", stats.entries);
+    add_assoc_long(return_value, "pending", stats.pending);
+    add_assoc_long(return_value, "inflight", stats.inflight);
+    add_assoc_long(return_value, "enters", stats.enters);
+    add_assoc_long(return_value, "submissions", stats.submissions);
+    add_assoc_long(return_value, "completions", stats.completions);
+    add_assoc_long(return_value, "max_batch", stats.max_batch);
+    add_assoc_long(return_value, "recv_multishot", stats.recv_multishot);
+    add_assoc_long(return_value, "accept_multishot", stats.accept_multishot);
+    add_assoc_long(return_value, "send_zc", stats.send_zc);
+    add_assoc_bool(return_value, "socket_engine", cat_socket_is_io_uring_enabled());
+}
+
 static const zend_function_entry swow_debug_functions[] = {
     PHP_FENTRY(Swow\\Debug\\buildTraceAsString, PHP_FN(Swow_Debug_buildTraceAsString), arginfo_Swow_Debug_buildTraceAsString, 0)
     /* for breakpoint debugging  */
     PHP_FENTRY(Swow\\Debug\\registerExtendedStatementHandler, PHP_FN(Swow_Debug_registerExtendedStatementHandler), arginfo_Swow_Debug_registerExtendedStatementHandler, 0)
+    /* io_uring is created on demand, so "running" is false until it is used for the first time */
+    PHP_FENTRY(Swow\\Debug\\getIoUringStats, PHP_FN(Swow_Debug_getIoUringStats), arginfo_Swow_Debug_getIoUringStats, 0)
+    PHP_FE_END
+};
+
+#ifdef CAT_DEBUG
+/* thread channel (debug build only, we only use it to test cat_thread_channel directly) */
+
+SWOW_API zend_class_entry *swow_debug_thread_channel_ce;
+SWOW_API zend_object_handlers swow_debug_thread_channel_handlers;
+
+typedef struct swow_debug_thread_channel_s {
+    cat_thread_channel_t *channel;
+    /* native producer thread, it pushes [0, count) and retries while channel is full */
+    uv_thread_t producer;
+    cat_bool_t producing;
+    zend_long count;
+    /* written by producer thread */
+    cat_atomic_int64_t pushed;
+    zend_object std;
+} swow_debug_thread_channel_t;
+
+static zend_always_inline swow_debug_thread_channel_t *swow_debug_thread_channel_get_from_object(zend_object *object)
+{
+    return cat_container_of(object, swow_debug_thread_channel_t, std);
+}
+
+static zend_object *swow_debug_thread_channel_create_object(zend_class_entry *ce)
+{
+    swow_debug_thread_channel_t *s_channel = swow_object_alloc(swow_debug_thread_channel_t, ce, swow_debug_thread_channel_handlers);
+
+    s_channel->channel = NULL;
+    s_channel->producing = cat_false;
+    s_channel->count = 0;
+    cat_atomic_int64_init(&s_channel->pushed, 0);
+
+    return &s_channel->std;
+}
+
+static void swow_debug_thread_channel_producer_routine(void *arg)
+{
+    swow_debug_thread_channel_t *s_channel = (swow_debug_thread_channel_t *) arg;
+    zend_long value;
+
+    for (value = 0; value < s_channel->count; value++) {
+        while (!cat_thread_channel_push(s_channel->channel, &value)) {
+            if (!cat_thread_channel_is_available(s_channel->channel)) {
+                return;
+            }
+            /* full, wait for consumers */
+            cat_sys_usleep(1000);
+        }
+        (void) cat_atomic_int64_fetch_add(&s_channel->pushed, 1);
+    }
+}
+
+static void swow_debug_thread_channel_join_producer(swow_debug_thread_channel_t *s_channel)
+{
+    if (s_channel->producing) {
+        (void) uv_thread_join(&s_channel->producer);
+        s_channel->producing = cat_false;
+    }
+}
+
+static void swow_debug_thread_channel_dtor_object(zend_object *object)
+{
+    swow_debug_thread_channel_t *s_channel = swow_debug_thread_channel_get_from_object(object);
+
+    zend_objects_destroy_object(object);
+
+    /* producer may be blocked on a full channel, close it to stop the producer */
+    if (s_channel->channel != NULL && s_channel->producing) {
+        if (cat_thread_channel_is_available(s_channel->channel)) {
+            (void) cat_thread_channel_close(s_channel->channel);
+        }
+        swow_debug_thread_channel_join_producer(s_channel);
+    }
+}
+
+static void swow_debug_thread_channel_free_object(zend_object *object)
+{
+    swow_debug_thread_channel_t *s_channel = swow_debug_thread_channel_get_from_object(object);
+
+    if (s_channel->channel != NULL) {
+        CAT_ASSERT(!s_channel->producing);
+        cat_thread_channel_free(s_channel->channel);
+    }
+
+    zend_object_std_dtor(&s_channel->std);
+}
+
+#define SWOW_DEBUG_THREAD_CHANNEL_GETTER(s_channel, channel) \
+    swow_debug_thread_channel_t *s_channel = swow_debug_thread_channel_get_from_object(Z_OBJ_P(ZEND_THIS)); \
+    cat_thread_channel_t *channel = s_channel->channel; \
+    if (UNEXPECTED(channel == NULL)) { \
+        zend_throw_error(NULL, "%s must construct first", ZEND_THIS_NAME); \
+        RETURN_THROWS(); \
+    }
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Swow_Debug_ThreadChannel___construct, 0, 0, 1)
+    ZEND_ARG_TYPE_INFO(0, capacity, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Debug_ThreadChannel, __construct)
+{
+    swow_debug_thread_channel_t *s_channel = swow_debug_thread_channel_get_from_object(Z_OBJ_P(ZEND_THIS));
+    zend_long capacity;
+
+    if (UNEXPECTED(s_channel->channel != NULL)) {
+        zend_throw_error(NULL, "%s can only construct once", ZEND_THIS_NAME);
+        RETURN_THROWS();
+    }
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(capacity)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(capacity <= 0 || capacity > (CAT_CHANNEL_SIZE_MAX >> 1) + 1)) {
+        zend_argument_value_error(1, "must be in range [1, " CAT_CHANNEL_SIZE_FMT "]", (CAT_CHANNEL_SIZE_MAX >> 1) + 1);
+        RETURN_THROWS();
+    }
+
+    s_channel->channel = cat_thread_channel_create((cat_channel_size_t) capacity, sizeof(zend_long), NULL);
+
+    if (UNEXPECTED(s_channel->channel == NULL)) {
+        swow_throw_exception_with_last(swow_channel_exception_ce);
+        RETURN_THROWS();
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Debug_ThreadChannel_push, 0, 1, _IS_BOOL, 0)
+    ZEND_ARG_TYPE_INFO(0, value, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Debug_ThreadChannel, push)
+{
+    SWOW_DEBUG_THREAD_CHANNEL_GETTER(s_channel, channel);
+    zend_long value;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(value)
+    ZEND_PARSE_PARAMETERS_END();
+
+    RETURN_BOOL(cat_thread_channel_push(channel, &value));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Debug_ThreadChannel_pop, 0, 0, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 0, "-1")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Debug_ThreadChannel, pop)
+{
+    SWOW_DEBUG_THREAD_CHANNEL_GETTER(s_channel, channel);
+    zend_long timeout = -1;
+    zend_long value;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(timeout)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(!cat_thread_channel_pop(channel, &value, timeout))) {
+        swow_throw_exception_with_last(swow_channel_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_LONG(value);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Debug_ThreadChannel_tryPop, 0, 0, IS_LONG, 1)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Debug_ThreadChannel, tryPop)
+{
+    SWOW_DEBUG_THREAD_CHANNEL_GETTER(s_channel, channel);
+    zend_long value;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    if (!cat_thread_channel_try_pop(channel, &value)) {
+        RETURN_NULL();
+    }
+
+    RETURN_LONG(value);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Debug_ThreadChannel_close, 0, 0, IS_STATIC, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Debug_ThreadChannel, close)
+{
+    SWOW_DEBUG_THREAD_CHANNEL_GETTER(s_channel, channel);
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    if (UNEXPECTED(!cat_thread_channel_close(channel))) {
+        swow_throw_exception_with_last(swow_channel_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_THIS();
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Debug_ThreadChannel_startProducer, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO(0, count, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Debug_ThreadChannel, startProducer)
+{
+    SWOW_DEBUG_THREAD_CHANNEL_GETTER(s_channel, channel);
+    zend_long count;
+    int error;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(count)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(count < 0)) {
+        zend_argument_value_error(1, "can not be negative");
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(s_channel->producing)) {
+        zend_throw_error(NULL, "Producer is running");
+        RETURN_THROWS();
+    }
+
+    (void) channel;
+    s_channel->count = count;
+    cat_atomic_int64_store(&s_channel->pushed, 0);
+    error = uv_thread_create(&s_channel->producer, swow_debug_thread_channel_producer_routine, s_channel);
+    if (UNEXPECTED(error != 0)) {
+        swow_throw_exception(swow_channel_exception_ce, error, "Thread create failed, reason: %s", cat_strerror(error));
+        RETURN_THROWS();
+    }
+    s_channel->producing = cat_true;
+
+    RETURN_THIS();
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Debug_ThreadChannel_joinProducer, 0, 0, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+/* return the number of pushed items */
+static PHP_METHOD(Swow_Debug_ThreadChannel, joinProducer)
+{
+    SWOW_DEBUG_THREAD_CHANNEL_GETTER(s_channel, channel);
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    (void) channel;
+    swow_debug_thread_channel_join_producer(s_channel);
+
+    RETURN_LONG((zend_long) cat_atomic_int64_load(&s_channel->pushed));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Debug_ThreadChannel_getCapacity, 0, 0, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Debug_ThreadChannel, getCapacity)
+{
+    SWOW_DEBUG_THREAD_CHANNEL_GETTER(s_channel, channel);
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_LONG(cat_thread_channel_get_capacity(channel));
+}
+
+#define arginfo_class_Swow_Debug_ThreadChannel_getLength arginfo_class_Swow_Debug_ThreadChannel_getCapacity
+
+static PHP_METHOD(Swow_Debug_ThreadChannel, getLength)
+{
+    SWOW_DEBUG_THREAD_CHANNEL_GETTER(s_channel, channel);
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_LONG(cat_thread_channel_get_length(channel));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Debug_ThreadChannel_isAvailable, 0, 0, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Debug_ThreadChannel, isAvailable)
+{
+    SWOW_DEBUG_THREAD_CHANNEL_GETTER(s_channel, channel);
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_BOOL(cat_thread_channel_is_available(channel));
+}
+
+static const zend_function_entry swow_debug_thread_channel_methods[] = {
+    PHP_ME(Swow_Debug_ThreadChannel, __construct,   arginfo_class_Swow_Debug_ThreadChannel___construct,   ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Debug_ThreadChannel, push,          arginfo_class_Swow_Debug_ThreadChannel_push,          ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Debug_ThreadChannel, pop,           arginfo_class_Swow_Debug_ThreadChannel_pop,           ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Debug_ThreadChannel, tryPop,        arginfo_class_Swow_Debug_ThreadChannel_tryPop,        ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Debug_ThreadChannel, close,         arginfo_class_Swow_Debug_ThreadChannel_close,         ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Debug_ThreadChannel, startProducer, arginfo_class_Swow_Debug_ThreadChannel_startProducer, ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Debug_ThreadChannel, joinProducer,  arginfo_class_Swow_Debug_ThreadChannel_joinProducer,  ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Debug_ThreadChannel, getCapacity,   arginfo_class_Swow_Debug_ThreadChannel_getCapacity,   ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Debug_ThreadChannel, getLength,     arginfo_class_Swow_Debug_ThreadChannel_getLength,     ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Debug_ThreadChannel, isAvailable,   arginfo_class_Swow_Debug_ThreadChannel_isAvailable,   ZEND_ACC_PUBLIC)
     PHP_FE_END
 };
+#endif /* CAT_DEBUG */
 
 SWOW_API CAT_GLOBALS_DECLARE(swow_debug);
 
@@ -563,6 +899,18 @@ zend_result swow_debug_module_init(INIT_FUNC_ARGS)
         return FAILURE;
     }
 
+#ifdef CAT_DEBUG
+    swow_debug_thread_channel_ce = swow_register_internal_class(
+        "Swow\\Debug\\ThreadChannel", NULL, swow_debug_thread_channel_methods,
+        &swow_debug_thread_channel_handlers, NULL,
+        cat_false, cat_false,
+        swow_debug_thread_channel_create_object,
+        swow_debug_thread_channel_free_object,
+        XtOffsetOf(swow_debug_thread_channel_t, std)
+    );
+    swow_debug_thread_channel_handlers.dtor_obj = swow_debug_thread_channel_dtor_object;
+#endif
+
     return SUCCESS;
 }
 
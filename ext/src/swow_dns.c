@@ -24,6 +24,9 @@
 # define MAXFQDNLEN 255
 #endif
 
+SWOW_API zend_class_entry *swow_dns_ce;
+SWOW_API zend_class_entry *swow_dns_exception_ce;
+
 static PHP_FUNCTION_EX(_swow_gethostbyname, bool is_v2)
 {
     char *hostname;
@@ -90,6 +93,320 @@ static const zend_function_entry swow_dns_functions[] = {
     PHP_FE_END
 };
 
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Dns_getCacheStats, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Dns, getCacheStats)
+{
+    cat_dns_cache_stats_t stats;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    cat_dns_cache_get_stats(&stats);
+
+    array_init(return_value);
+    add_assoc_long(return_value, "size", (zend_long) stats.size);
+    add_assoc_long(return_value, "max_size", (zend_long) stats.max_size);
+    add_assoc_long(return_value, "pending_count", (zend_long) stats.pending_count);
+    add_assoc_long(return_value, "ttl", (zend_long) stats.ttl);
+    add_assoc_long(return_value, "negative_ttl", (zend_long) stats.negative_ttl);
+    add_assoc_long(return_value, "hits", (zend_long) stats.hits);
+    add_assoc_long(return_value, "misses", (zend_long) stats.misses);
+    add_assoc_long(return_value, "coalesced", (zend_long) stats.coalesced);
+    add_assoc_long(return_value, "evictions", (zend_long) stats.evictions);
+}
+
+static void swow_dns_cache_entry_walker(const cat_dns_cache_entry_info_t *info, cat_data_t *data)
+{
+    zval *zentries = (zval *) data;
+    zval zentry, zaddresses;
+    const struct addrinfo *response;
+
+    array_init(&zaddresses);
+    for (response = info->response; response != NULL; response = response->ai_next) {
+        char ip[CAT_SOCKET_IPV6_BUFFER_SIZE];
+        int error;
+        switch (response->ai_family) {
+            case AF_INET:
+                error = uv_ip4_name((const struct sockaddr_in *) response->ai_addr, ip, sizeof(ip));
+                break;
+            case AF_INET6:
+                error = uv_ip6_name((const struct sockaddr_in6 *) response->ai_addr, ip, sizeof(ip));
+                break;
+            default:
+                continue;
+        }
+        if (error == 0) {
+            add_next_index_string(&zaddresses, ip);
+        }
+    }
+
+    array_init(&zentry);
+    add_assoc_string(&zentry, "hostname", (char *) info->hostname);
+    add_assoc_string(&zentry, "service", (char *) info->service);
+    add_assoc_long(&zentry, "family", info->family);
+    add_assoc_long(&zentry, "socktype", info->socktype);
+    add_assoc_long(&zentry, "ttl", (zend_long) info->ttl);
+    add_assoc_long(&zentry, "error", info->status);
+    add_assoc_zval(&zentry, "addresses", &zaddresses);
+    add_next_index_zval(zentries, &zentry);
+}
+
+#define arginfo_class_Swow_Dns_getCacheEntries arginfo_class_Swow_Dns_getCacheStats
+
+static PHP_METHOD(Swow_Dns, getCacheEntries)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    array_init(return_value);
+    cat_dns_cache_walk(swow_dns_cache_entry_walker, return_value);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Dns_flushCache, 0, 0, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, hostname, IS_STRING, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Dns, flushCache)
+{
+    zend_string *hostname = NULL;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR_OR_NULL(hostname)
+    ZEND_PARSE_PARAMETERS_END();
+
+    RETURN_LONG((zend_long) cat_dns_cache_flush(hostname != NULL ? ZSTR_VAL(hostname) : NULL));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Dns_setCacheSize, 0, 1, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO(0, size, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Dns, setCacheSize)
+{
+    zend_long size;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(size)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(size < 0)) {
+        zend_argument_value_error(1, "must be greater than or equal to 0");
+        RETURN_THROWS();
+    }
+
+    RETURN_LONG((zend_long) cat_dns_cache_set_size((size_t) size));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Dns_setCacheTtl, 0, 1, IS_VOID, 0)
+    ZEND_ARG_TYPE_INFO(0, ttl, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, negativeTtl, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Dns, setCacheTtl)
+{
+    zend_long ttl;
+    zend_long negative_ttl = 0;
+    bool negative_ttl_is_null = true;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_LONG(ttl)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(negative_ttl, negative_ttl_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(ttl < 0)) {
+        zend_argument_value_error(1, "must be greater than or equal to 0");
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(!negative_ttl_is_null && negative_ttl < 0)) {
+        zend_argument_value_error(2, "must be greater than or equal to 0 or null");
+        RETURN_THROWS();
+    }
+
+    (void) cat_dns_cache_set_ttl((cat_msec_t) ttl);
+    if (!negative_ttl_is_null) {
+        (void) cat_dns_cache_set_negative_ttl((cat_msec_t) negative_ttl);
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Dns_setResolver, 0, 1, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO(0, resolver, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Dns, setResolver)
+{
+    zend_long resolver;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(resolver)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(resolver != CAT_DNS_RESOLVER_SYSTEM && resolver != CAT_DNS_RESOLVER_NATIVE)) {
+        zend_argument_value_error(1, "must be one of Dns::RESOLVER_SYSTEM or Dns::RESOLVER_NATIVE");
+        RETURN_THROWS();
+    }
+
+    RETURN_LONG(cat_dns_set_resolver((cat_dns_resolver_type_t) resolver));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Dns_getResolver, 0, 0, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Dns, getResolver)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_LONG(cat_dns_get_resolver());
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Dns_loadConfig, 0, 0, IS_VOID, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, resolvConf, IS_STRING, 1, "null")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, hosts, IS_STRING, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Dns, loadConfig)
+{
+    zend_string *resolv_conf = NULL;
+    zend_string *hosts = NULL;
+
+    ZEND_PARSE_PARAMETERS_START(0, 2)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_PATH_STR_OR_NULL(resolv_conf)
+        Z_PARAM_PATH_STR_OR_NULL(hosts)
+    ZEND_PARSE_PARAMETERS_END();
+
+    (void) cat_dns_resolver_load_config(
+        resolv_conf != NULL ? ZSTR_VAL(resolv_conf) : NULL,
+        hosts != NULL ? ZSTR_VAL(hosts) : NULL
+    );
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Dns_setNameservers, 0, 1, IS_VOID, 0)
+    ZEND_ARG_TYPE_MASK(0, nameservers, MAY_BE_STRING | MAY_BE_ARRAY, NULL)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Dns, setNameservers)
+{
+    HashTable *nameservers_array = NULL;
+    zend_string *nameservers_string = NULL;
+    smart_str buffer = {0};
+    cat_bool_t ret;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_ARRAY_HT_OR_STR(nameservers_array, nameservers_string)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (nameservers_array != NULL) {
+        zval *znameserver;
+        ZEND_HASH_FOREACH_VAL(nameservers_array, znameserver) {
+            if (UNEXPECTED(Z_TYPE_P(znameserver) != IS_STRING)) {
+                smart_str_free(&buffer);
+                zend_argument_type_error(1, "must be an array of strings");
+                RETURN_THROWS();
+            }
+            if (buffer.s != NULL) {
+                smart_str_appendc(&buffer, ',');
+            }
+            smart_str_append(&buffer, Z_STR_P(znameserver));
+        } ZEND_HASH_FOREACH_END();
+        smart_str_0(&buffer);
+        ret = cat_dns_resolver_set_nameservers(buffer.s != NULL ? ZSTR_VAL(buffer.s) : "");
+        smart_str_free(&buffer);
+    } else {
+        ret = cat_dns_resolver_set_nameservers(ZSTR_VAL(nameservers_string));
+    }
+
+    if (UNEXPECTED(!ret)) {
+        swow_throw_exception_with_last(swow_dns_exception_ce);
+        RETURN_THROWS();
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Dns_query, 0, 1, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, type, IS_LONG, 0, "Swow\\Dns::TYPE_A")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Dns, query)
+{
+    zend_string *name;
+    zend_long type = CAT_DNS_TYPE_A;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    cat_dns_response_t *response;
+    size_t n;
+
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_STR(name)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(type)
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(type != CAT_DNS_TYPE_A && type != CAT_DNS_TYPE_AAAA &&
+                   type != CAT_DNS_TYPE_CNAME && type != CAT_DNS_TYPE_SRV)) {
+        zend_argument_value_error(2, "must be one of Dns::TYPE_A, Dns::TYPE_AAAA, Dns::TYPE_CNAME or Dns::TYPE_SRV");
+        RETURN_THROWS();
+    }
+    if (timeout_is_null) {
+        timeout = cat_socket_get_global_dns_timeout();
+    }
+
+    response = cat_dns_query_ex(ZSTR_VAL(name), (cat_dns_type_t) type, timeout);
+    if (UNEXPECTED(response == NULL)) {
+        swow_throw_exception_with_last(swow_dns_exception_ce);
+        RETURN_THROWS();
+    }
+
+    array_init_size(return_value, (uint32_t) response->count);
+    for (n = 0; n < response->count; n++) {
+        const cat_dns_record_t *record = &response->records[n];
+        char ip[CAT_SOCKET_IPV6_BUFFER_SIZE];
+        zval zrecord;
+        array_init(&zrecord);
+        add_assoc_string(&zrecord, "name", (char *) record->name);
+        add_assoc_long(&zrecord, "type", record->type);
+        add_assoc_long(&zrecord, "ttl", (zend_long) record->ttl);
+        switch (record->type) {
+            case CAT_DNS_TYPE_A:
+                (void) uv_inet_ntop(AF_INET, &record->data.a, ip, sizeof(ip));
+                add_assoc_string(&zrecord, "address", ip);
+                break;
+            case CAT_DNS_TYPE_AAAA:
+                (void) uv_inet_ntop(AF_INET6, &record->data.aaaa, ip, sizeof(ip));
+                add_assoc_string(&zrecord, "address", ip);
+                break;
+            case CAT_DNS_TYPE_CNAME:
+                add_assoc_string(&zrecord, "target", (char *) record->data.cname);
+                break;
+            case CAT_DNS_TYPE_SRV:
+                add_assoc_long(&zrecord, "priority", record->data.srv.priority);
+                add_assoc_long(&zrecord, "weight", record->data.srv.weight);
+                add_assoc_long(&zrecord, "port", record->data.srv.port);
+                add_assoc_string(&zrecord, "target", (char *) record->data.srv.target);
+                break;
+        }
+        add_next_index_zval(return_value, &zrecord);
+    }
+    cat_dns_response_free(response);
+}
+
+static const zend_function_entry swow_dns_methods[] = {
+    PHP_ME(Swow_Dns, getCacheStats,   arginfo_class_Swow_Dns_getCacheStats,   ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Dns, getCacheEntries, arginfo_class_Swow_Dns_getCacheEntries, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Dns, flushCache,      arginfo_class_Swow_Dns_flushCache,      ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Dns, setCacheSize,    arginfo_class_Swow_Dns_setCacheSize,    ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Dns, setCacheTtl,     arginfo_class_Swow_Dns_setCacheTtl,     ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Dns, setResolver,     arginfo_class_Swow_Dns_setResolver,     ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Dns, getResolver,     arginfo_class_Swow_Dns_getResolver,     ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Dns, loadConfig,      arginfo_class_Swow_Dns_loadConfig,      ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Dns, setNameservers,  arginfo_class_Swow_Dns_setNameservers,  ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Dns, query,           arginfo_class_Swow_Dns_query,           ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_FE_END
+};
+
 static bool has_sockets_extension = false;
 static bool af_constants_checked = false;
 
@@ -108,6 +425,22 @@ zend_result swow_dns_module_init(INIT_FUNC_ARGS)
         return FAILURE;
     }
 
+    swow_dns_ce = swow_register_internal_class(
+        "Swow\\Dns", NULL, swow_dns_methods,
+        NULL, NULL, cat_false, cat_false,
+        swow_create_object_deny, NULL, 0
+    );
+    zend_declare_class_constant_long(swow_dns_ce, ZEND_STRL("RESOLVER_SYSTEM"), CAT_DNS_RESOLVER_SYSTEM);
+    zend_declare_class_constant_long(swow_dns_ce, ZEND_STRL("RESOLVER_NATIVE"), CAT_DNS_RESOLVER_NATIVE);
+    zend_declare_class_constant_long(swow_dns_ce, ZEND_STRL("TYPE_A"), CAT_DNS_TYPE_A);
+    zend_declare_class_constant_long(swow_dns_ce, ZEND_STRL("TYPE_CNAME"), CAT_DNS_TYPE_CNAME);
+    zend_declare_class_constant_long(swow_dns_ce, ZEND_STRL("TYPE_AAAA"), CAT_DNS_TYPE_AAAA);
+    zend_declare_class_constant_long(swow_dns_ce, ZEND_STRL("TYPE_SRV"), CAT_DNS_TYPE_SRV);
+
+    swow_dns_exception_ce = swow_register_internal_class(
+        "Swow\\DnsException", swow_exception_ce, NULL, NULL, NULL, cat_true, cat_true, NULL, NULL, 0
+    );
+
     REGISTER_LONG_CONSTANT("AF_UNSPEC", AF_UNSPEC, CONST_PERSISTENT);
     if (!zend_hash_str_find_ptr(&module_registry, ZEND_STRL("sockets"))) {
         REGISTER_LONG_CONSTANT("AF_INET", AF_INET, CONST_PERSISTENT);
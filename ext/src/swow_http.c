@@ -19,6 +19,7 @@
 #include "swow_http.h"
 
 #include "swow_buffer.h"
+#include "swow_known_strings.h"
 
 #include "swow_errno.h" /* for errno register */
 
@@ -457,6 +458,348 @@ static PHP_METHOD(Swow_Http_Parser, getEventNameFor)
     RETURN_STRING(cat_http_parser_event_get_name(event));
 }
 
+/* one-shot head parser */
+
+#define SWOW_HTTP_KNOWN_STRING_MAP(XX) \
+    XX(method) \
+    XX(uri) \
+    XX(statusCode) \
+    XX(reasonPhrase) \
+    XX(protocolVersion) \
+    XX(headers) \
+    XX(headerNames) \
+    XX(contentLength) \
+    XX(isChunked) \
+    XX(isUpgrade) \
+    XX(isMultipart) \
+    XX(shouldKeepAlive) \
+    XX(headLength) \
+
+SWOW_HTTP_KNOWN_STRING_MAP(SWOW_KNOWN_STRING_STORAGE_GEN)
+
+#define SWOW_HTTP_KNOWN_HEADER_MAP(XX) \
+    XX("Accept") \
+    XX("Accept-Charset") \
+    XX("Accept-Encoding") \
+    XX("Accept-Language") \
+    XX("Accept-Ranges") \
+    XX("Access-Control-Request-Headers") \
+    XX("Access-Control-Request-Method") \
+    XX("Age") \
+    XX("Authorization") \
+    XX("Cache-Control") \
+    XX("Connection") \
+    XX("Content-Disposition") \
+    XX("Content-Encoding") \
+    XX("Content-Language") \
+    XX("Content-Length") \
+    XX("Content-Type") \
+    XX("Cookie") \
+    XX("Date") \
+    XX("DNT") \
+    XX("ETag") \
+    XX("Expect") \
+    XX("Expires") \
+    XX("Forwarded") \
+    XX("From") \
+    XX("Host") \
+    XX("If-Match") \
+    XX("If-Modified-Since") \
+    XX("If-None-Match") \
+    XX("If-Range") \
+    XX("If-Unmodified-Since") \
+    XX("Keep-Alive") \
+    XX("Last-Modified") \
+    XX("Location") \
+    XX("Origin") \
+    XX("Pragma") \
+    XX("Range") \
+    XX("Referer") \
+    XX("Sec-Fetch-Dest") \
+    XX("Sec-Fetch-Mode") \
+    XX("Sec-Fetch-Site") \
+    XX("Sec-WebSocket-Accept") \
+    XX("Sec-WebSocket-Extensions") \
+    XX("Sec-WebSocket-Key") \
+    XX("Sec-WebSocket-Protocol") \
+    XX("Sec-WebSocket-Version") \
+    XX("Server") \
+    XX("Set-Cookie") \
+    XX("TE") \
+    XX("Transfer-Encoding") \
+    XX("Upgrade") \
+    XX("Upgrade-Insecure-Requests") \
+    XX("User-Agent") \
+    XX("Vary") \
+    XX("Via") \
+    XX("X-Forwarded-For") \
+    XX("X-Forwarded-Host") \
+    XX("X-Forwarded-Proto") \
+    XX("X-Real-IP") \
+    XX("X-Requested-With") \
+
+/* longer names are never known ones */
+#define SWOW_HTTP_KNOWN_HEADER_NAME_MAX_LENGTH 64
+
+typedef struct swow_http_known_header_s {
+    zend_string *name;
+    zend_string *lower_name;
+} swow_http_known_header_t;
+
+static swow_http_known_header_t swow_http_known_headers[] = {
+#define SWOW_HTTP_KNOWN_HEADER_GEN(name) { NULL, NULL },
+    SWOW_HTTP_KNOWN_HEADER_MAP(SWOW_HTTP_KNOWN_HEADER_GEN)
+#undef SWOW_HTTP_KNOWN_HEADER_GEN
+};
+
+/* lower name => swow_http_known_header_t */
+static HashTable swow_http_known_header_map;
+
+static zend_string *swow_http_method_names[CAT_HTTP_METHOD_UNKNOWN];
+
+static void swow_http_known_headers_init(void)
+{
+    static const char *names[] = {
+#define SWOW_HTTP_KNOWN_HEADER_GEN(name) name,
+        SWOW_HTTP_KNOWN_HEADER_MAP(SWOW_HTTP_KNOWN_HEADER_GEN)
+#undef SWOW_HTTP_KNOWN_HEADER_GEN
+    };
+    size_t i;
+
+    zend_hash_init(&swow_http_known_header_map, CAT_ARRAY_SIZE(names), NULL, NULL, 1);
+    for (i = 0; i < CAT_ARRAY_SIZE(names); i++) {
+        swow_http_known_header_t *header = &swow_http_known_headers[i];
+        header->name = zend_string_init_interned(names[i], strlen(names[i]), 1);
+        header->lower_name = zend_string_tolower_ex(header->name, 1);
+        header->lower_name = zend_new_interned_string(header->lower_name);
+        zend_hash_add_new_ptr(&swow_http_known_header_map, header->lower_name, header);
+    }
+
+#define SWOW_HTTP_METHOD_NAME_GEN(id, name, string) \
+    swow_http_method_names[id] = zend_string_init_interned(ZEND_STRL(#string), 1);
+    CAT_HTTP_METHOD_MAP(SWOW_HTTP_METHOD_NAME_GEN)
+#undef SWOW_HTTP_METHOD_NAME_GEN
+}
+
+static void swow_http_known_headers_shutdown(void)
+{
+    zend_hash_destroy(&swow_http_known_header_map);
+}
+
+/* returns the length of request/status line and headers (including the empty line), 0 if incomplete */
+static size_t swow_http_get_head_length(const char *data, size_t length)
+{
+    const char *p = data, *end = data + length;
+
+    while ((p = (const char *) memchr(p, '\n', end - p)) != NULL) {
+        if (p + 1 < end && p[1] == '\n') {
+            return p + 2 - data;
+        }
+        if (p + 2 < end && p[1] == '\r' && p[2] == '\n') {
+            return p + 3 - data;
+        }
+        p++;
+    }
+
+    return 0;
+}
+
+static zend_always_inline zend_string *swow_http_string_init(const char *string, size_t length)
+{
+    if (length == 0) {
+        return ZSTR_EMPTY_ALLOC();
+    }
+    if (length == 1) {
+        return ZSTR_CHAR((zend_uchar) *string);
+    }
+    return zend_string_init(string, length, 0);
+}
+
+static void swow_http_add_header(HashTable *headers, HashTable *header_names, const char *name, size_t name_length, const char *value, size_t value_length)
+{
+    swow_http_known_header_t *known_header = NULL;
+    zend_string *header_name, *lower_header_name;
+    zval *z_values, z_value;
+
+    if (name_length <= SWOW_HTTP_KNOWN_HEADER_NAME_MAX_LENGTH) {
+        char lower_name[SWOW_HTTP_KNOWN_HEADER_NAME_MAX_LENGTH + 1];
+        zend_str_tolower_copy(lower_name, name, name_length);
+        known_header = (swow_http_known_header_t *) zend_hash_str_find_ptr(&swow_http_known_header_map, lower_name, name_length);
+    }
+    if (known_header != NULL) {
+        /* most of clients send canonical or lowercase names */
+        if (memcmp(name, ZSTR_VAL(known_header->name), name_length) == 0) {
+            header_name = known_header->name;
+        } else if (memcmp(name, ZSTR_VAL(known_header->lower_name), name_length) == 0) {
+            header_name = known_header->lower_name;
+        } else {
+            header_name = zend_string_init(name, name_length, 0);
+        }
+        lower_header_name = known_header->lower_name;
+    } else {
+        header_name = zend_string_init(name, name_length, 0);
+        lower_header_name = zend_string_tolower(header_name);
+    }
+
+    z_values = zend_hash_find(headers, header_name);
+    if (z_values == NULL) {
+        zval z_tmp;
+        array_init_size(&z_tmp, 1);
+        z_values = zend_hash_add_new(headers, header_name, &z_tmp);
+    }
+    ZVAL_STR(&z_value, swow_http_string_init(value, value_length));
+    zend_hash_next_index_insert_new(Z_ARRVAL_P(z_values), &z_value);
+
+    ZVAL_STR_COPY(&z_value, header_name);
+    zend_hash_update(header_names, lower_header_name, &z_value);
+
+    zend_string_release(header_name);
+    zend_string_release(lower_header_name);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Http_Parser_parseHead, 0, 1, IS_ARRAY, 1)
+    ZEND_ARG_OBJ_TYPE_MASK(0, data, Stringable, MAY_BE_STRING, NULL)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, start, IS_LONG, 0, "0")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 0, "-1")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Http_Parser, parseHead)
+{
+    SWOW_HTTP_PARSER_GETTER(s_parser, parser);
+    zend_string *string;
+    zend_long start = 0;
+    zend_long length = -1;
+    cat_http_parser_events_t events;
+    cat_http_parser_event_t event, previous_event = CAT_HTTP_PARSER_EVENT_NONE;
+    const char *ptr, *line = NULL, *field = NULL, *value = NULL;
+    size_t head_length, parsed_length = 0, line_length = 0, field_length = 0, value_length = 0;
+    HashTable *headers, *header_names;
+    zval z_headers, z_header_names, z_tmp;
+    cat_bool_t ret;
+
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        SWOW_PARAM_STRINGABLE_EXPECT_BUFFER_FOR_READING(string)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(start)
+        Z_PARAM_LONG(length)
+    ZEND_PARSE_PARAMETERS_END();
+
+    ptr = swow_string_get_readable_space(string, start, &length, 1);
+    if (UNEXPECTED(ptr == NULL)) {
+        RETURN_THROWS();
+    }
+
+    /* parser state is untouched until the whole head arrived */
+    head_length = swow_http_get_head_length(ptr, length);
+    if (head_length == 0) {
+        RETURN_NULL();
+    }
+
+    array_init_size(&z_headers, 8);
+    headers = Z_ARRVAL(z_headers);
+    array_init_size(&z_header_names, 8);
+    header_names = Z_ARRVAL(z_header_names);
+
+    events = parser->events;
+    parser->events |= CAT_HTTP_PARSER_EVENT_URL | CAT_HTTP_PARSER_EVENT_STATUS |
+                      CAT_HTTP_PARSER_EVENT_HEADER_FIELD | CAT_HTTP_PARSER_EVENT_HEADER_VALUE |
+                      CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE;
+    while (1) {
+        ret = cat_http_parser_execute(parser, ptr + parsed_length, head_length - parsed_length);
+        if (UNEXPECTED(!ret)) {
+            break;
+        }
+        parsed_length += parser->parsed_length;
+        event = parser->event;
+        /* all data of the head are in the same buffer,
+         * so the continued data are always adjacent */
+        switch (event) {
+            case CAT_HTTP_PARSER_EVENT_URL:
+            case CAT_HTTP_PARSER_EVENT_STATUS:
+                if (event != previous_event) {
+                    line = parser->data;
+                }
+                line_length = parser->data + parser->data_length - line;
+                break;
+            case CAT_HTTP_PARSER_EVENT_HEADER_FIELD:
+                if (event != previous_event) {
+                    if (field != NULL) {
+                        swow_http_add_header(headers, header_names, field, field_length, value, value_length);
+                    }
+                    field = parser->data;
+                    value = NULL;
+                    value_length = 0;
+                }
+                field_length = parser->data + parser->data_length - field;
+                break;
+            case CAT_HTTP_PARSER_EVENT_HEADER_VALUE:
+                if (event != previous_event) {
+                    value = parser->data;
+                }
+                value_length = parser->data + parser->data_length - value;
+                break;
+            case CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE:
+                if (field != NULL) {
+                    swow_http_add_header(headers, header_names, field, field_length, value, value_length);
+                }
+                break;
+            default:
+                break;
+        }
+        if (event == CAT_HTTP_PARSER_EVENT_HEADERS_COMPLETE) {
+            break;
+        }
+        if (UNEXPECTED(event == CAT_HTTP_PARSER_EVENT_NONE || event == CAT_HTTP_PARSER_EVENT_MESSAGE_COMPLETE)) {
+            cat_update_last_error(CAT_EHP_INVALID_EOF_STATE, "HTTP-Parser execute failed: unexpected end of head");
+            ret = cat_false;
+            break;
+        }
+        previous_event = event;
+    }
+    parser->events = events;
+    if (UNEXPECTED(!ret)) {
+        zval_ptr_dtor(&z_headers);
+        zval_ptr_dtor(&z_header_names);
+        swow_throw_exception_with_last(swow_http_parser_exception_ce);
+        RETURN_THROWS();
+    }
+    s_parser->data_offset = ptr + parsed_length - ZSTR_VAL(string);
+
+    array_init_size(return_value, 12);
+    if (cat_http_parser_get_type(parser) == CAT_HTTP_PARSER_TYPE_REQUEST) {
+        cat_http_method_t method = cat_http_parser_get_method(parser);
+        if (EXPECTED(method < CAT_HTTP_METHOD_UNKNOWN && swow_http_method_names[method] != NULL)) {
+            ZVAL_INTERNED_STR(&z_tmp, swow_http_method_names[method]);
+        } else {
+            ZVAL_STRING(&z_tmp, cat_http_parser_get_method_name(parser));
+        }
+        zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(method), &z_tmp);
+        ZVAL_STR(&z_tmp, swow_http_string_init(line, line_length));
+        zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(uri), &z_tmp);
+    } else {
+        ZVAL_LONG(&z_tmp, cat_http_parser_get_status_code(parser));
+        zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(statusCode), &z_tmp);
+        ZVAL_STR(&z_tmp, swow_http_string_init(line, line_length));
+        zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(reasonPhrase), &z_tmp);
+    }
+    ZVAL_STRING(&z_tmp, cat_http_parser_get_protocol_version(parser));
+    zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(protocolVersion), &z_tmp);
+    zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(headers), &z_headers);
+    zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(headerNames), &z_header_names);
+    ZVAL_LONG(&z_tmp, cat_http_parser_get_content_length(parser));
+    zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(contentLength), &z_tmp);
+    ZVAL_BOOL(&z_tmp, cat_http_parser_is_chunked(parser));
+    zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(isChunked), &z_tmp);
+    ZVAL_BOOL(&z_tmp, cat_http_parser_is_upgrade(parser));
+    zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(isUpgrade), &z_tmp);
+    ZVAL_BOOL(&z_tmp, cat_http_parser_is_multipart(parser));
+    zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(isMultipart), &z_tmp);
+    ZVAL_BOOL(&z_tmp, parser->keep_alive);
+    zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(shouldKeepAlive), &z_tmp);
+    ZVAL_LONG(&z_tmp, parsed_length);
+    zend_hash_add_new(Z_ARRVAL_P(return_value), SWOW_KNOWN_STRING(headLength), &z_tmp);
+}
+
 static const zend_function_entry swow_http_parser_methods[] = {
     PHP_ME(Swow_Http_Parser, getType,               arginfo_class_Swow_Http_Parser_getType,               ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Http_Parser, setType,               arginfo_class_Swow_Http_Parser_setType,               ZEND_ACC_PUBLIC)
@@ -485,6 +828,7 @@ static const zend_function_entry swow_http_parser_methods[] = {
     PHP_ME(Swow_Http_Parser, isUpgrade,             arginfo_class_Swow_Http_Parser_isUpgrade,             ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Http_Parser, finish,                arginfo_class_Swow_Http_Parser_finish,                ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Http_Parser, reset,                 arginfo_class_Swow_Http_Parser_reset,                 ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Http_Parser, parseHead,             arginfo_class_Swow_Http_Parser_parseHead,             ZEND_ACC_PUBLIC)
     /* static */
     PHP_ME(Swow_Http_Parser, getEventNameFor,       arginfo_class_Swow_Http_Parser_getEventNameFor,       ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_FE_END
@@ -717,6 +1061,9 @@ zend_result swow_http_module_init(INIT_FUNC_ARGS)
         return FAILURE;
     }
 
+    SWOW_HTTP_KNOWN_STRING_MAP(SWOW_KNOWN_STRING_INIT_GEN);
+    swow_http_known_headers_init();
+
     /* Http */
     swow_http_http_ce = swow_register_internal_class(
         "Swow\\Http\\Http", NULL, swow_http_http_methods,
@@ -767,3 +1114,10 @@ zend_result swow_http_module_init(INIT_FUNC_ARGS)
 
     return SUCCESS;
 }
+
+zend_result swow_http_module_shutdown(INIT_FUNC_ARGS)
+{
+    swow_http_known_headers_shutdown();
+
+    return SUCCESS;
+}
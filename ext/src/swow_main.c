@@ -32,6 +32,8 @@
 #include "swow_dns.h"
 #include "swow_stream.h"
 #include "swow_signal.h"
+#include "swow_work.h"
+#include "swow_thread.h"
 #include "swow_watchdog.h"
 #include "swow_closure.h"
 #include "swow_ipaddress.h"
@@ -211,6 +213,8 @@ PHP_MINIT_FUNCTION(swow)
         swow_dns_module_init,
         swow_stream_module_init,
         swow_signal_module_init,
+        swow_work_module_init,
+        swow_thread_module_init,
         swow_watchdog_module_init,
         swow_closure_module_init,
         swow_ipaddress_init,
@@ -278,10 +282,13 @@ PHP_MSHUTDOWN_FUNCTION(swow)
 #ifdef CAT_OS_WAIT
         swow_proc_open_module_shutdown,
 #endif
+        swow_http_module_shutdown,
         swow_closure_module_shutdown,
         swow_watchdog_module_shutdown,
+        swow_thread_module_shutdown,
         swow_stream_module_shutdown,
         swow_socket_module_shutdown,
+        swow_buffer_module_shutdown,
         swow_event_module_shutdown,
         swow_coroutine_module_shutdown,
         swow_debug_module_shutdown,
@@ -321,15 +328,20 @@ PHP_RINIT_FUNCTION(swow)
         swow_debug_runtime_init,
         swow_coroutine_runtime_init,
         swow_event_runtime_init,
+        swow_buffer_runtime_init,
         swow_socket_runtime_init,
         swow_dns_runtime_init,
         swow_stream_runtime_init,
         swow_watchdog_runtime_init,
+        swow_thread_runtime_init,
 #ifdef CAT_OS_WAIT
         swow_proc_open_runtime_init,
 #endif
 #ifdef CAT_HAVE_CURL
         swow_curl_runtime_init,
+#endif
+#ifdef CAT_HAVE_PQ
+        swow_pgsql_runtime_init,
 #endif
     };
 
@@ -371,6 +383,7 @@ PHP_RSHUTDOWN_FUNCTION(swow)
         swow_event_runtime_shutdown,
         swow_coroutine_runtime_shutdown,
         swow_debug_runtime_shutdown,
+        swow_buffer_runtime_shutdown,
         swow_runtime_shutdown,
     };
 
@@ -412,6 +425,9 @@ static zend_result swow_post_deactivate(void)
         /* Some cURL object may freed after rshutdown due to global/static ref,
          * so we need to run checks in post_deactivate here. */
         swow_curl_runtime_close,
+#endif
+#ifdef CAT_HAVE_PQ
+        swow_pgsql_runtime_close,
 #endif
         swow_event_runtime_close,
     };
@@ -630,6 +646,11 @@ static PHP_METHOD(Swow_Extension, isBuiltWith)
         ret = true;
     }
 #endif
+#ifdef CAT_SSL_HAVE_KTLS
+    else if (zend_string_equals_literal_ci(lib, "ktls")) {
+        ret = true;
+    }
+#endif
 #ifdef CAT_HAVE_CURL
     else if (zend_string_equals_literal_ci(lib, "curl")) {
         ret = true;
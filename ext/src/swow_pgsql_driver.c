@@ -2693,6 +2693,9 @@ zend_result swow_pgsql_module_init(INIT_FUNC_ARGS)
 	if (php_pdo_register_driver(&swow_pdo_pgsql_driver) == SUCCESS) {
 		swow_pgsql_hooked = cat_true;
 	}
+	if (swow_pgsql_hooked && !cat_pq_module_init()) {
+		return FAILURE;
+	}
 	return SUCCESS;
 }
 
@@ -2707,6 +2710,28 @@ zend_result swow_pgsql_module_shutdown(INIT_FUNC_ARGS)
 		// }
 
 		swow_pgsql_hooked = cat_false;
+
+		if (!cat_pq_module_shutdown()) {
+			return FAILURE;
+		}
+	}
+
+	return SUCCESS;
+}
+
+zend_result swow_pgsql_runtime_init(INIT_FUNC_ARGS)
+{
+	if (swow_pgsql_hooked && !cat_pq_runtime_init()) {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+zend_result swow_pgsql_runtime_close(void)
+{
+	if (swow_pgsql_hooked && !cat_pq_runtime_close()) {
+		return FAILURE;
 	}
 
 	return SUCCESS;
@@ -21,6 +21,8 @@
 
 #include "swow_stream.h" /* for Socket->open(stream) */
 
+#include "cat_time.h" /* for accept stats */
+
 SWOW_API zend_class_entry *swow_socket_ce;
 SWOW_API zend_object_handlers swow_socket_handlers;
 
@@ -37,6 +39,7 @@ static zend_object *swow_socket_create_object(zend_class_entry *ce)
     swow_socket_t *s_socket = swow_object_alloc(swow_socket_t, ce, swow_socket_handlers);
 
     cat_socket_init(&s_socket->socket);
+    s_socket->websocket_codec = NULL;
 
     return &s_socket->std;
 }
@@ -65,6 +68,11 @@ static void swow_socket_free_object(zend_object *object)
         cat_socket_close(socket);
     }
 
+    if (s_socket->websocket_codec != NULL) {
+        cat_websocket_codec_close(s_socket->websocket_codec);
+        efree(s_socket->websocket_codec);
+    }
+
     zend_object_std_dtor(&s_socket->std);
 }
 
@@ -536,6 +544,135 @@ static PHP_METHOD(Swow_Socket, acceptTo)
     RETURN_THIS();
 }
 
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_acceptMany, 0, 0, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxCount, IS_LONG, 0, "64")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, acceptMany)
+{
+    SWOW_SOCKET_GETTER(s_server, server);
+    cat_socket_type_t server_type = cat_socket_get_simple_type(server);
+    zend_long max_count = 64;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    swow_socket_t *s_connection;
+    cat_socket_t *connection;
+    zend_long n;
+    cat_bool_t ret;
+
+    ZEND_PARSE_PARAMETERS_START(0, 2)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_count)
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(max_count <= 0)) {
+        zend_argument_value_error(1, "must be greater than 0");
+        RETURN_THROWS();
+    }
+    if (timeout_is_null) {
+        timeout = cat_socket_get_accept_timeout(server);
+    }
+
+    /* wait for the first one */
+    s_connection = swow_socket_get_from_object(
+        swow_socket_create_object(Z_OBJCE_P(ZEND_THIS))
+    );
+    connection = &s_connection->socket;
+    if (likely(server_type != CAT_SOCKET_TYPE_ANY)) {
+        ret = cat_socket_create(connection, server_type) != NULL;
+        if (UNEXPECTED(!ret)) {
+            goto _creation_error;
+        }
+    } /* else server has not been constructed, but error will be triggered later in socket_accept() */
+
+    ret = cat_socket_accept_ex(server, connection, timeout);
+
+    if (UNEXPECTED(!ret)) {
+        if (server_type != CAT_SOCKET_TYPE_ANY) {
+            cat_socket_close(connection);
+        }
+        _creation_error:
+        zend_object_release(&s_connection->std);
+        swow_throw_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+
+    array_init(return_value);
+    add_next_index_object(return_value, &s_connection->std);
+
+    /* then drain the accept queue without waiting */
+    for (n = 1; n < max_count; n++) {
+        s_connection = swow_socket_get_from_object(
+            swow_socket_create_object(Z_OBJCE_P(ZEND_THIS))
+        );
+        connection = &s_connection->socket;
+        if (UNEXPECTED(cat_socket_create(connection, server_type) == NULL)) {
+            zend_object_release(&s_connection->std);
+            break;
+        }
+        if (!cat_socket_try_accept(server, connection)) {
+            cat_socket_close(connection);
+            zend_object_release(&s_connection->std);
+            break;
+        }
+        add_next_index_object(return_value, &s_connection->std);
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_acceptManyTo, 0, 1, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO(0, connections, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, acceptManyTo)
+{
+    SWOW_SOCKET_GETTER(s_server, server);
+    HashTable *connections_array;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    cat_socket_t **connections;
+    uint32_t count = 0;
+    zval *z_connection;
+    ssize_t n;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ARRAY_HT(connections_array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(zend_hash_num_elements(connections_array) == 0)) {
+        zend_argument_value_error(1, "can not be empty");
+        RETURN_THROWS();
+    }
+    if (timeout_is_null) {
+        timeout = cat_socket_get_accept_timeout(server);
+    }
+    connections = safe_emalloc(zend_hash_num_elements(connections_array), sizeof(*connections), 0);
+    ZEND_HASH_FOREACH_VAL(connections_array, z_connection) {
+        ZVAL_DEREF(z_connection);
+        if (UNEXPECTED(Z_TYPE_P(z_connection) != IS_OBJECT || !instanceof_function(Z_OBJCE_P(z_connection), swow_socket_ce))) {
+            zend_argument_type_error(1, "[%u] must be of type %s, %s given", count, ZSTR_VAL(swow_socket_ce->name), zend_zval_type_name(z_connection));
+            efree(connections);
+            RETURN_THROWS();
+        }
+        connections[count++] = &swow_socket_get_from_object(Z_OBJ_P(z_connection))->socket;
+    } ZEND_HASH_FOREACH_END();
+
+    /* connections are filled in order */
+    n = cat_socket_accept_multiple_ex(server, connections, count, timeout);
+    efree(connections);
+
+    if (UNEXPECTED(n < 0)) {
+        swow_throw_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_LONG(n);
+}
+
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_connect, 0, 1, IS_STATIC, 0)
     ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
     ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, port, IS_LONG, 0, "0")
@@ -583,6 +720,7 @@ static PHP_METHOD(Swow_Socket, enableCrypto)
     HashTable *options_array = NULL;
     cat_socket_crypto_options_t options;
     cat_bool_t is_client = !cat_socket_is_server_connection(socket);
+    zend_long session_cache_size = 0;
     cat_bool_t ret;
 
     ZEND_PARSE_PARAMETERS_START(0, 1)
@@ -610,6 +748,17 @@ static PHP_METHOD(Swow_Socket, enableCrypto)
         swow_hash_str_fetch_str(options_array, "certificate_key", &options.certificate_key);
         swow_hash_str_fetch_bool(options_array, "no_ticket", &options.no_ticket);
         swow_hash_str_fetch_bool(options_array, "no_compression", &options.no_compression);
+        swow_hash_str_fetch_bool(options_array, "ktls", &options.ktls);
+        swow_hash_str_fetch_bool(options_array, "session_cache", &options.session_cache);
+        swow_hash_str_fetch_long(options_array, "session_cache_size", &session_cache_size);
+        if (UNEXPECTED(session_cache_size < 0)) {
+            zend_argument_value_error(1, "[\"session_cache_size\"] can not be negative");
+            RETURN_THROWS();
+        }
+        options.session_cache_size = (size_t) session_cache_size;
+        swow_hash_str_fetch_long(options_array, "session_timeout", &options.session_timeout);
+        swow_hash_str_fetch_str(options_array, "session_ticket_key_file", &options.session_ticket_key_file);
+        swow_hash_str_fetch_long(options_array, "session_ticket_key_rotation", &options.session_ticket_key_rotation);
         swow_hash_str_fetch_str(options_array, "passphrase", &options.passphrase);
         // TODO: SNI related things
         if (is_client) {
@@ -632,6 +781,59 @@ static PHP_METHOD(Swow_Socket, enableCrypto)
 #endif
 }
 
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_getCryptoSessionStats, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, getCryptoSessionStats)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+#ifdef CAT_SSL
+    cat_ssl_session_stats_t stats;
+
+    cat_ssl_get_session_stats(&stats);
+
+    array_init(return_value);
+    add_assoc_long(return_value, "handshakes", (zend_long) stats.handshakes);
+    add_assoc_long(return_value, "resumed", (zend_long) stats.resumed);
+    add_assoc_long(return_value, "cache_size", (zend_long) stats.cache_size);
+    add_assoc_long(return_value, "cache_max_size", (zend_long) stats.cache_max_size);
+    add_assoc_long(return_value, "cache_hits", (zend_long) stats.cache_hits);
+    add_assoc_long(return_value, "cache_misses", (zend_long) stats.cache_misses);
+    add_assoc_long(return_value, "cache_timeouts", (zend_long) stats.cache_timeouts);
+    add_assoc_long(return_value, "cache_evictions", (zend_long) stats.cache_evictions);
+    add_assoc_long(return_value, "ticket_key_count", (zend_long) stats.ticket_key_count);
+    add_assoc_long(return_value, "ticket_issued", (zend_long) stats.ticket_issued);
+    add_assoc_long(return_value, "ticket_decrypted", (zend_long) stats.ticket_decrypted);
+    add_assoc_long(return_value, "ticket_renewed", (zend_long) stats.ticket_renewed);
+    add_assoc_long(return_value, "ticket_unknown", (zend_long) stats.ticket_unknown);
+#else
+    zend_throw_error(NULL, "SSL support is not enabled, "
+        "`--enable-" SWOW_MODULE_NAME_LC "-ssl` must be configured while compiling %s extension", SWOW_MODULE_NAME);
+    RETURN_THROWS();
+#endif
+}
+
+#define arginfo_class_Swow_Socket_getCryptoKtlsStatus arginfo_class_Swow_Socket_getCryptoSessionStats
+
+static PHP_METHOD(Swow_Socket, getCryptoKtlsStatus)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+#ifdef CAT_SSL
+    array_init(return_value);
+    add_assoc_bool(return_value, "send", cat_socket_is_ktls_send_enabled(socket));
+    add_assoc_bool(return_value, "recv", cat_socket_is_ktls_recv_enabled(socket));
+#else
+    (void) socket;
+    zend_throw_error(NULL, "SSL support is not enabled, "
+        "`--enable-" SWOW_MODULE_NAME_LC "-ssl` must be configured while compiling %s extension", SWOW_MODULE_NAME);
+    RETURN_THROWS();
+#endif
+}
+
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_getAddress, ZEND_RETURN_VALUE, 0, IS_STRING, 0)
 ZEND_END_ARG_INFO()
 
@@ -1061,114 +1263,479 @@ static PHP_METHOD(Swow_Socket, peekStringFrom)
     PHP_METHOD_CALL(Swow_Socket, _readString, 1, 1, 1);
 }
 
-static PHP_METHOD_EX(Swow_Socket, _write, bool single, bool may_address)
+#define SWOW_SOCKET_PARSE_MAX_LENGTH(arg_num) do { \
+    if (UNEXPECTED(max_length < -1 || max_length == 0)) { \
+        zend_argument_value_error(arg_num, "must be greater than 0 or -1 to refer to unlimited"); \
+        RETURN_THROWS(); \
+    } \
+    if (max_length == -1) { \
+        max_length = 0; \
+    } \
+} while (0)
+
+#define SWOW_SOCKET_RETURN_READ_MESSAGE(data, length) do { \
+    if (UNEXPECTED(data == NULL)) { \
+        swow_throw_call_exception_with_last(swow_socket_exception_ce); \
+        RETURN_THROWS(); \
+    } \
+    RETURN_STRINGL(data, length); \
+} while (0)
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_readLine, 0, 0, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxLength, IS_LONG, 0, "-1")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, readLine)
 {
     SWOW_SOCKET_GETTER(s_socket, socket);
-    uint32_t max_num_args;
-    swow_buffer_t *s_buffer = NULL;
-    zend_string *string = NULL;
-    zend_long start = 0;
-    zend_long length = -1;
-    zend_string *address = NULL;
-    zend_long port = 0;
+    zend_long max_length = -1;
     zend_long timeout;
     bool timeout_is_null = 1;
-    const char *ptr;
-    cat_socket_write_vector_t *vector, *vector_list_on_heap = NULL, vector_list_on_stack[8];
-    /* real non-empty vector count */
-    uint32_t vector_count = 0;
-    /* Use addref/release for buffer strings to make sure data is immutable (COW),
-     * save strings in a C array and release them before return. */
-    zend_string **strings, **strings_on_heap = NULL, *strings_on_stack[8];
-    uint32_t buffer_count = 0;
-    cat_bool_t ret;
+    const char *data;
+    size_t length;
 
-    // vector, timeout / buffer or string, timeout
-    max_num_args = 2;
-    if (single) {
-        // start, length
-        max_num_args += 2;
+    ZEND_PARSE_PARAMETERS_START(0, 2)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_length)
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    SWOW_SOCKET_PARSE_MAX_LENGTH(1);
+    if (timeout_is_null) {
+        timeout = cat_socket_get_read_timeout(socket);
     }
-    if (may_address) {
-        // address, port
-        max_num_args += 2;
+
+    data = cat_socket_read_line_ex(socket, max_length, &length, timeout);
+
+    SWOW_SOCKET_RETURN_READ_MESSAGE(data, length);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_readUntil, 0, 1, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, delimiter, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxLength, IS_LONG, 0, "-1")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, readUntil)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    zend_string *delimiter;
+    zend_long max_length = -1;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    const char *data;
+    size_t length;
+
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_STR(delimiter)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_length)
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(ZSTR_LEN(delimiter) == 0)) {
+        zend_argument_value_error(1, "can not be empty");
+        RETURN_THROWS();
+    }
+    SWOW_SOCKET_PARSE_MAX_LENGTH(2);
+    if (timeout_is_null) {
+        timeout = cat_socket_get_read_timeout(socket);
     }
 
-    vector = vector_list_on_stack;
-    strings = strings_on_stack;
-    ZEND_PARSE_PARAMETERS_START(1, max_num_args)
-        if (!single) {
-            HashTable *vector_list_array;
-            uint32_t vector_list_array_count;
-            Z_PARAM_ARRAY_HT(vector_list_array)
-            vector_list_array_count = zend_hash_num_elements(vector_list_array);
-            if (UNEXPECTED(vector_list_array_count == 0)) {
-                zend_argument_value_error(1, "can not be empty");
-                goto _error;
-            }
-            if (UNEXPECTED(vector_list_array_count > CAT_ARRAY_SIZE(vector_list_on_stack))) {
-                vector = vector_list_on_heap = emalloc(vector_list_array_count * sizeof(*vector));
-            }
-            if (UNEXPECTED(vector_list_array_count > CAT_ARRAY_SIZE(strings_on_stack))) {
-                strings = strings_on_heap = emalloc(vector_list_array_count * sizeof(*strings));
-            }
-            do {
-                zval *z_tmp;
-                uint32_t vector_list_array_index = 0;
-                ZEND_HASH_FOREACH_VAL(vector_list_array, z_tmp) {
-                    /* the last one can be null */
-                    if (ZVAL_IS_NULL(z_tmp)) {
-                        break;
-                    }
-                    /* [array|string|Stringable|Buffer] */
-                    if (Z_TYPE_P(z_tmp) == IS_ARRAY) {
-                        /* array include parameters */
-                        HashTable *vector_elements_array = Z_ARR_P(z_tmp);
-                        uint32_t vector_elements_array_count = zend_hash_num_elements(vector_elements_array);
-                        if (UNEXPECTED(vector_elements_array_count < 1 || vector_elements_array_count > 3)) {
-                            zend_argument_value_error(1, "[%u] must have 1 to 3 elements, %u given", vector_list_array_index, vector_elements_array_count);
-                            goto _error;
-                        }
-                        uint32_t index = 0;
-                        /* [string|Stringable|Buffer, start, length] */
-                        ZEND_HASH_FOREACH_VAL(vector_elements_array, z_tmp) {
-                            ZEND_ASSERT(index == 0 || index == 1 || index == 2);
-                            if (index == 0) {
-                                if (UNEXPECTED(!swow_parse_arg_buffer_or_stringable_for_reading(z_tmp, &s_buffer, &string, 1))) {
-                                    zend_argument_type_error(1, "[%u][0] ($data) must be of type string or %s, %s given", vector_list_array_index, ZSTR_VAL(swow_buffer_ce->name), zend_zval_type_name(z_tmp));
-                                    goto _error;
-                                }
-                            } else if (index == 1) {
-                                if (UNEXPECTED(z_tmp != NULL && !swow_parse_arg_long(z_tmp, &start, NULL, false, 1))) {
-                                    zend_argument_type_error(1, "[%u][1] ($start) must be of type int, %s given", vector_list_array_index, zend_zval_type_name(z_tmp));
-                                    goto _error;
-                                }
-                            } else if (index == 2) {
-                                if (UNEXPECTED(z_tmp != NULL && !swow_parse_arg_long(z_tmp, &length, NULL, false, 1))) {
-                                    zend_argument_type_error(1, "[%u][2] ($length) must be of type int, %s given", vector_list_array_index, zend_zval_type_name(z_tmp));
-                                    goto _error;
-                                }
-                            }
-                            index++;
-                        } ZEND_HASH_FOREACH_END();
-                    } else if (!swow_parse_arg_buffer_or_stringable_for_reading(z_tmp, &s_buffer, &string, 1)) {
-                        zend_argument_type_error(1, "[%u] ($stringable) must be of type string, array or %s, %s given", vector_list_array_index, ZSTR_VAL(swow_buffer_ce->name), zend_zval_type_name(z_tmp));
-                        goto _error;
-                    }
-                    ptr = swow_buffer_or_string_get_readable_space_v(s_buffer, string, start, &length, 1, vector_list_array_index, 1);
-                    if (UNEXPECTED(ptr == NULL)) {
-                        goto _error;
-                    }
-                    if (length == 0) {
-                        goto _next;
-                    }
-                    if (s_buffer != NULL) {
-                        zend_string *buffer_string = swow_buffer_get_string(s_buffer);
-                        if (buffer_string != NULL) {
-                            strings[buffer_count++] = zend_string_copy(buffer_string);
-                        }
-                    }
-                    vector[vector_count].base = ptr;
+    data = cat_socket_read_until_ex(socket, ZSTR_VAL(delimiter), ZSTR_LEN(delimiter), max_length, &length, timeout);
+
+    SWOW_SOCKET_RETURN_READ_MESSAGE(data, length);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_readFrame, 0, 0, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, lengthFieldSize, IS_LONG, 0, "4")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, lengthFieldOffset, IS_LONG, 0, "0")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, lengthAdjustment, IS_LONG, 0, "0")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, initialBytesToStrip, IS_LONG, 1, "null")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, littleEndian, _IS_BOOL, 0, "false")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxLength, IS_LONG, 0, "Swow\\Socket::DEFAULT_MAX_FRAME_LENGTH")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, readFrame)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    cat_socket_frame_spec_t spec;
+    zend_long length_field_size = 4;
+    zend_long length_field_offset = 0;
+    zend_long length_adjustment = 0;
+    zend_long initial_bytes_to_strip;
+    bool initial_bytes_to_strip_is_null = 1;
+    bool little_endian = 0;
+    zend_long max_length = CAT_SOCKET_DEFAULT_MAX_FRAME_LENGTH;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    const char *data;
+    size_t length;
+
+    ZEND_PARSE_PARAMETERS_START(0, 7)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(length_field_size)
+        Z_PARAM_LONG(length_field_offset)
+        Z_PARAM_LONG(length_adjustment)
+        Z_PARAM_LONG_OR_NULL(initial_bytes_to_strip, initial_bytes_to_strip_is_null)
+        Z_PARAM_BOOL(little_endian)
+        Z_PARAM_LONG(max_length)
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(length_field_size < 1 || length_field_size > 8)) {
+        zend_argument_value_error(1, "must be between 1 and 8");
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(length_field_offset < 0)) {
+        zend_argument_value_error(2, "must be greater than or equal to 0");
+        RETURN_THROWS();
+    }
+    if (initial_bytes_to_strip_is_null) {
+        /* strip the header by default */
+        initial_bytes_to_strip = length_field_offset + length_field_size;
+    } else if (UNEXPECTED(initial_bytes_to_strip < 0)) {
+        zend_argument_value_error(4, "must be greater than or equal to 0");
+        RETURN_THROWS();
+    }
+    SWOW_SOCKET_PARSE_MAX_LENGTH(6);
+    if (timeout_is_null) {
+        timeout = cat_socket_get_read_timeout(socket);
+    }
+
+    spec.length_field_offset = (size_t) length_field_offset;
+    spec.length_field_size = (uint8_t) length_field_size;
+    spec.length_field_little_endian = little_endian;
+    spec.length_adjustment = (int64_t) length_adjustment;
+    spec.initial_bytes_to_strip = (size_t) initial_bytes_to_strip;
+    data = cat_socket_read_frame_ex(socket, &spec, max_length, &length, timeout);
+
+    SWOW_SOCKET_RETURN_READ_MESSAGE(data, length);
+}
+
+#undef SWOW_SOCKET_PARSE_MAX_LENGTH
+#undef SWOW_SOCKET_RETURN_READ_MESSAGE
+
+#define arginfo_class_Swow_Socket_getReadBufferedLength arginfo_class_Swow_Socket_getId
+
+static PHP_METHOD(Swow_Socket, getReadBufferedLength)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_LONG(cat_socket_get_read_buffered_length(socket));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_recvMultipleFrom, 0, 0, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxCount, IS_LONG, 0, "64")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, size, IS_LONG, 0, "Swow\\Buffer::COMMON_SIZE")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, recvMultipleFrom)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    zend_long max_count = CAT_SOCKET_DATAGRAM_BATCH_MAX_COUNT;
+    zend_long size = CAT_BUFFER_COMMON_SIZE;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    cat_socket_datagram_t *datagrams;
+    char *buffer;
+    ssize_t n, i;
+
+    ZEND_PARSE_PARAMETERS_START(0, 3)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_count)
+        Z_PARAM_LONG(size)
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    /* check args and initialize */
+    if (UNEXPECTED(max_count <= 0)) {
+        zend_argument_value_error(1, "must be greater than 0");
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(size <= 0)) {
+        zend_argument_value_error(2, "must be greater than 0");
+        RETURN_THROWS();
+    }
+    if (timeout_is_null) {
+        timeout = cat_socket_get_read_timeout(socket);
+    }
+    /* datagrams are received into one scratch buffer and copied out by their real length */
+    buffer = safe_emalloc(max_count, size, 0);
+    datagrams = safe_emalloc(max_count, sizeof(*datagrams), 0);
+    for (i = 0; i < max_count; i++) {
+        datagrams[i].buffer = buffer + i * size;
+        datagrams[i].size = size;
+    }
+
+    n = cat_socket_recv_multiple_ex(socket, datagrams, max_count, timeout);
+
+    /* [[data, address, port], ...] */
+    array_init_size(return_value, n > 0 ? (uint32_t) n : 0);
+    for (i = 0; i < n; i++) {
+        cat_socket_datagram_t *datagram = &datagrams[i];
+        char address[CAT_SOCKADDR_MAX_PATH];
+        size_t address_length = sizeof(address);
+        int port = 0;
+        zval z_datagram;
+        if (datagram->address.length > sizeof(datagram->address.address) ||
+            cat_sockaddr_to_name_silent(&datagram->address.address.common, datagram->address.length, address, &address_length, &port) != 0) {
+            address_length = 0;
+        }
+        array_init_size(&z_datagram, 3);
+        add_next_index_stringl(&z_datagram, datagram->buffer, datagram->length);
+        add_next_index_stringl(&z_datagram, address, address_length);
+        add_next_index_long(&z_datagram, port);
+        add_next_index_zval(return_value, &z_datagram);
+    }
+    efree(datagrams);
+    efree(buffer);
+
+    /* handle error */
+    if (UNEXPECTED(n < 0)) {
+        swow_throw_call_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_sendMultipleTo, 0, 1, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO(0, datagrams, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, sendMultipleTo)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    HashTable *datagrams_array;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    cat_socket_datagram_t *datagrams;
+    /* addresses are usually the same, so we cache the last resolved one */
+    zend_string *last_address = NULL;
+    zend_long last_port = 0;
+    cat_sockaddr_info_t last_address_info;
+    uint32_t count = 0, index = 0;
+    zval *z_datagram;
+    ssize_t n;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ARRAY_HT(datagrams_array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    /* check args and initialize */
+    if (UNEXPECTED(zend_hash_num_elements(datagrams_array) == 0)) {
+        zend_argument_value_error(1, "can not be empty");
+        RETURN_THROWS();
+    }
+    if (timeout_is_null) {
+        timeout = cat_socket_get_write_timeout(socket);
+    }
+    last_address_info.length = 0;
+    datagrams = safe_emalloc(zend_hash_num_elements(datagrams_array), sizeof(*datagrams), 0);
+    /* string (to the connected peer) or [data, address, port] */
+    ZEND_HASH_FOREACH_VAL(datagrams_array, z_datagram) {
+        cat_socket_datagram_t *datagram = &datagrams[count];
+        zval *z_data = z_datagram, *z_address = NULL, *z_port = NULL;
+        zend_string *address = NULL;
+        zend_long port = 0;
+        ZVAL_DEREF(z_datagram);
+        if (Z_TYPE_P(z_datagram) == IS_ARRAY) {
+            HashTable *datagram_array = Z_ARR_P(z_datagram);
+            uint32_t datagram_array_count = zend_hash_num_elements(datagram_array);
+            if (UNEXPECTED(datagram_array_count < 1 || datagram_array_count > 3)) {
+                zend_argument_value_error(1, "[%u] must have 1 to 3 elements, %u given", index, datagram_array_count);
+                goto _error;
+            }
+            z_data = zend_hash_index_find(datagram_array, 0);
+            z_address = zend_hash_index_find(datagram_array, 1);
+            z_port = zend_hash_index_find(datagram_array, 2);
+            if (UNEXPECTED(z_data == NULL)) {
+                zend_argument_value_error(1, "[%u][0] ($data) is required", index);
+                goto _error;
+            }
+            ZVAL_DEREF(z_data);
+        }
+        if (UNEXPECTED(Z_TYPE_P(z_data) != IS_STRING)) {
+            zend_argument_type_error(1, "[%u] ($data) must be of type string, %s given", index, zend_zval_type_name(z_data));
+            goto _error;
+        }
+        if (z_address != NULL) {
+            ZVAL_DEREF(z_address);
+            if (UNEXPECTED(Z_TYPE_P(z_address) != IS_STRING && Z_TYPE_P(z_address) != IS_NULL)) {
+                zend_argument_type_error(1, "[%u][1] ($address) must be of type ?string, %s given", index, zend_zval_type_name(z_address));
+                goto _error;
+            }
+            if (Z_TYPE_P(z_address) == IS_STRING) {
+                address = Z_STR_P(z_address);
+            }
+        }
+        if (z_port != NULL) {
+            ZVAL_DEREF(z_port);
+            if (UNEXPECTED(Z_TYPE_P(z_port) != IS_LONG && Z_TYPE_P(z_port) != IS_NULL)) {
+                zend_argument_type_error(1, "[%u][2] ($port) must be of type ?int, %s given", index, zend_zval_type_name(z_port));
+                goto _error;
+            }
+            if (Z_TYPE_P(z_port) == IS_LONG) {
+                port = Z_LVAL_P(z_port);
+            }
+        }
+        datagram->buffer = Z_STRVAL_P(z_data);
+        datagram->size = Z_STRLEN_P(z_data);
+        if (address == NULL || ZSTR_LEN(address) == 0) {
+            datagram->address.length = 0;
+        } else {
+            if (last_address == NULL || port != last_port || !zend_string_equals(address, last_address)) {
+                last_address_info.length = sizeof(last_address_info.address);
+                if (UNEXPECTED(!cat_sockaddr_getbyname(
+                    &last_address_info.address.common, &last_address_info.length,
+                    ZSTR_VAL(address), ZSTR_LEN(address), (int) port
+                ))) {
+                    swow_throw_exception_with_last(swow_socket_exception_ce);
+                    goto _error;
+                }
+                last_address = address;
+                last_port = port;
+            }
+            datagram->address = last_address_info;
+        }
+        count++;
+        index++;
+    } ZEND_HASH_FOREACH_END();
+
+    n = cat_socket_send_multiple_ex(socket, datagrams, count, timeout);
+
+    efree(datagrams);
+
+    /* also for socket exception getReturnValue */
+    RETVAL_LONG(n > 0 ? n : 0);
+
+    /* handle error */
+    if (UNEXPECTED(n != (ssize_t) count)) {
+        swow_throw_call_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+    return;
+
+    _error:
+    efree(datagrams);
+    RETURN_THROWS();
+}
+
+static PHP_METHOD_EX(Swow_Socket, _write, bool single, bool may_address)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    uint32_t max_num_args;
+    swow_buffer_t *s_buffer = NULL;
+    zend_string *string = NULL;
+    zend_long start = 0;
+    zend_long length = -1;
+    zend_string *address = NULL;
+    zend_long port = 0;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    const char *ptr;
+    cat_socket_write_vector_t *vector, *vector_list_on_heap = NULL, vector_list_on_stack[8];
+    /* real non-empty vector count */
+    uint32_t vector_count = 0;
+    /* Use addref/release for buffer strings to make sure data is immutable (COW),
+     * save strings in a C array and release them before return. */
+    zend_string **strings, **strings_on_heap = NULL, *strings_on_stack[8];
+    uint32_t buffer_count = 0;
+    cat_bool_t ret;
+
+    // vector, timeout / buffer or string, timeout
+    max_num_args = 2;
+    if (single) {
+        // start, length
+        max_num_args += 2;
+    }
+    if (may_address) {
+        // address, port
+        max_num_args += 2;
+    }
+
+    vector = vector_list_on_stack;
+    strings = strings_on_stack;
+    ZEND_PARSE_PARAMETERS_START(1, max_num_args)
+        if (!single) {
+            HashTable *vector_list_array;
+            uint32_t vector_list_array_count;
+            Z_PARAM_ARRAY_HT(vector_list_array)
+            vector_list_array_count = zend_hash_num_elements(vector_list_array);
+            if (UNEXPECTED(vector_list_array_count == 0)) {
+                zend_argument_value_error(1, "can not be empty");
+                goto _error;
+            }
+            if (UNEXPECTED(vector_list_array_count > CAT_ARRAY_SIZE(vector_list_on_stack))) {
+                vector = vector_list_on_heap = emalloc(vector_list_array_count * sizeof(*vector));
+            }
+            if (UNEXPECTED(vector_list_array_count > CAT_ARRAY_SIZE(strings_on_stack))) {
+                strings = strings_on_heap = emalloc(vector_list_array_count * sizeof(*strings));
+            }
+            do {
+                zval *z_tmp;
+                uint32_t vector_list_array_index = 0;
+                ZEND_HASH_FOREACH_VAL(vector_list_array, z_tmp) {
+                    /* the last one can be null */
+                    if (ZVAL_IS_NULL(z_tmp)) {
+                        break;
+                    }
+                    /* [array|string|Stringable|Buffer] */
+                    if (Z_TYPE_P(z_tmp) == IS_ARRAY) {
+                        /* array include parameters */
+                        HashTable *vector_elements_array = Z_ARR_P(z_tmp);
+                        uint32_t vector_elements_array_count = zend_hash_num_elements(vector_elements_array);
+                        if (UNEXPECTED(vector_elements_array_count < 1 || vector_elements_array_count > 3)) {
+                            zend_argument_value_error(1, "[%u] must have 1 to 3 elements, %u given", vector_list_array_index, vector_elements_array_count);
+                            goto _error;
+                        }
+                        uint32_t index = 0;
+                        /* [string|Stringable|Buffer, start, length] */
+                        ZEND_HASH_FOREACH_VAL(vector_elements_array, z_tmp) {
+                            ZEND_ASSERT(index == 0 || index == 1 || index == 2);
+                            if (index == 0) {
+                                if (UNEXPECTED(!swow_parse_arg_buffer_or_stringable_for_reading(z_tmp, &s_buffer, &string, 1))) {
+                                    zend_argument_type_error(1, "[%u][0] ($data) must be of type string or %s, %s given", vector_list_array_index, ZSTR_VAL(swow_buffer_ce->name), zend_zval_type_name(z_tmp));
+                                    goto _error;
+                                }
+                            } else if (index == 1) {
+                                if (UNEXPECTED(z_tmp != NULL && !swow_parse_arg_long(z_tmp, &start, NULL, false, 1))) {
+                                    zend_argument_type_error(1, "[%u][1] ($start) must be of type int, %s given", vector_list_array_index, zend_zval_type_name(z_tmp));
+                                    goto _error;
+                                }
+                            } else if (index == 2) {
+                                if (UNEXPECTED(z_tmp != NULL && !swow_parse_arg_long(z_tmp, &length, NULL, false, 1))) {
+                                    zend_argument_type_error(1, "[%u][2] ($length) must be of type int, %s given", vector_list_array_index, zend_zval_type_name(z_tmp));
+                                    goto _error;
+                                }
+                            }
+                            index++;
+                        } ZEND_HASH_FOREACH_END();
+                    } else if (!swow_parse_arg_buffer_or_stringable_for_reading(z_tmp, &s_buffer, &string, 1)) {
+                        zend_argument_type_error(1, "[%u] ($stringable) must be of type string, array or %s, %s given", vector_list_array_index, ZSTR_VAL(swow_buffer_ce->name), zend_zval_type_name(z_tmp));
+                        goto _error;
+                    }
+                    ptr = swow_buffer_or_string_get_readable_space_v(s_buffer, string, start, &length, 1, vector_list_array_index, 1);
+                    if (UNEXPECTED(ptr == NULL)) {
+                        goto _error;
+                    }
+                    if (length == 0) {
+                        goto _next;
+                    }
+                    if (s_buffer != NULL) {
+                        zend_string *buffer_string = swow_buffer_get_string(s_buffer);
+                        if (buffer_string != NULL) {
+                            strings[buffer_count++] = zend_string_copy(buffer_string);
+                        }
+                    }
+                    vector[vector_count].base = ptr;
                     vector[vector_count].length = length;
                     vector_count++;
                     _next:
@@ -1214,115 +1781,388 @@ static PHP_METHOD_EX(Swow_Socket, _write, bool single, bool may_address)
         vector[0].length = length;
     }
     if (timeout_is_null) {
-        timeout = cat_socket_get_read_timeout(socket);
+        timeout = cat_socket_get_read_timeout(socket);
+    }
+
+    /* write */
+    if (!may_address || address == NULL || ZSTR_LEN(address) == 0) {
+        ret = cat_socket_write_ex(socket, vector, vector_count, timeout);
+    } else {
+        ret = cat_socket_write_to_ex(socket, vector, vector_count, ZSTR_VAL(address), ZSTR_LEN(address), port, timeout);
+    }
+
+    if (UNEXPECTED(!ret)) {
+        swow_throw_call_exception_with_last(swow_socket_exception_ce);
+        goto _error;
+    }
+
+    _return:
+    RETVAL_THIS();
+
+    if (0) {
+        _error:
+        ZEND_ASSERT_HAS_EXCEPTION();
+    }
+    while (buffer_count--) {
+        zend_string_release(strings[buffer_count]);
+    }
+    if (UNEXPECTED(strings_on_heap != NULL)) {
+        efree(strings_on_heap);
+    }
+    if (UNEXPECTED(vector_list_on_heap != NULL)) {
+        efree(vector_list_on_heap);
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_write, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO(0, vector, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, write)
+{
+    PHP_METHOD_CALL(Swow_Socket, _write, 0, 0);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_writeTo, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO(0, vector, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, address, IS_STRING, 1, "null")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, port, IS_LONG, 1, "null")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, writeTo)
+{
+    PHP_METHOD_CALL(Swow_Socket, _write, 0, 1);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_send, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_OBJ_TYPE_MASK(0, data, Stringable, MAY_BE_STRING, NULL)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, start, IS_LONG, 0, "0")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 0, "-1")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, send)
+{
+    PHP_METHOD_CALL(Swow_Socket, _write, 1, 0);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_sendTo, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_OBJ_TYPE_MASK(0, data, Stringable, MAY_BE_STRING, NULL)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, start, IS_LONG, 0, "0")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 0, "-1")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, address, IS_STRING, 1, "null")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, port, IS_LONG, 1, "null")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, sendTo)
+{
+    PHP_METHOD_CALL(Swow_Socket, _write, 1, 1);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_sendHandle, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_OBJ_INFO(0, handle, Swow\\Socket, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, sendHandle)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    zend_object *handle_object;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    swow_socket_t *s_handle;
+    cat_socket_t *handle;
+    cat_bool_t ret;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_OBJ_OF_CLASS(handle_object, swow_socket_ce)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    s_handle = swow_socket_get_from_object(handle_object);
+    handle = &s_handle->socket;
+    if (timeout_is_null) {
+        timeout = cat_socket_get_write_timeout(socket);
+    }
+
+    ret = cat_socket_send_handle_ex(socket, handle, timeout);
+
+    if (UNEXPECTED(!ret)) {
+        swow_throw_call_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_THIS();
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_sendFile, 0, 1, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO(0, filename, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, offset, IS_LONG, 0, "0")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 0, "0")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, sendFile)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    zend_string *filename;
+    zend_long offset = 0;
+    zend_long length = 0;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    ssize_t written;
+
+    ZEND_PARSE_PARAMETERS_START(1, 4)
+        Z_PARAM_STR(filename)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(offset)
+        Z_PARAM_LONG(length)
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (length == -1) {
+        // 0 means unlimited for sendfile()
+        length = 0;
+    } else if (UNEXPECTED(length < 0)) {
+        zend_argument_error(swow_socket_exception_ce, 3, "can only be -1 to refer to unlimited when it is negative");
+        RETURN_THROWS();
+    }
+    if (timeout_is_null) {
+        timeout = cat_socket_get_write_timeout(socket);
+    }
+
+    written = cat_socket_send_file_ex(socket, ZSTR_VAL(filename), offset, length, timeout);
+
+    if (UNEXPECTED(written < 0)) {
+        swow_throw_call_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+
+    // TODO: RETURN_LONG_SAFE() ? may SIZE_MAX be bigger than ZEND_LONG_MAX?
+    RETURN_LONG(written);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_cork, 0, 0, IS_STATIC, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, cork)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    cat_bool_t ret;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    ret = cat_socket_cork(socket);
+
+    if (UNEXPECTED(!ret)) {
+        swow_throw_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_THIS();
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_uncork, 0, 0, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, uncork)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    cat_bool_t ret;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (timeout_is_null) {
+        timeout = cat_socket_get_write_timeout(socket);
     }
 
-    /* write */
-    if (!may_address || address == NULL || ZSTR_LEN(address) == 0) {
-        ret = cat_socket_write_ex(socket, vector, vector_count, timeout);
-    } else {
-        ret = cat_socket_write_to_ex(socket, vector, vector_count, ZSTR_VAL(address), ZSTR_LEN(address), port, timeout);
-    }
+    ret = cat_socket_uncork_ex(socket, timeout);
 
     if (UNEXPECTED(!ret)) {
         swow_throw_call_exception_with_last(swow_socket_exception_ce);
-        goto _error;
+        RETURN_THROWS();
     }
 
-    _return:
-    RETVAL_THIS();
+    RETURN_THIS();
+}
 
-    if (0) {
-        _error:
-        ZEND_ASSERT_HAS_EXCEPTION();
+#define SWOW_SOCKET_WEBSOCKET_CODEC_CHECK(s_socket, codec) do { \
+    codec = (s_socket)->websocket_codec; \
+    if (UNEXPECTED(codec == NULL)) { \
+        swow_throw_exception(swow_socket_exception_ce, CAT_EMISUSE, "WebSocket codec is not enabled"); \
+        RETURN_THROWS(); \
+    } \
+} while (0)
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_enableWebSocket, 0, 0, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, flags, IS_LONG, 0, "Swow\\WebSocket\\WebSocket::CODEC_FLAG_DEFAULT")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, extensions, IS_STRING, 0, "\'\'")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxMessageLength, IS_LONG, 0, "Swow\\WebSocket\\WebSocket::DEFAULT_MAX_MESSAGE_LENGTH")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, compressionLevel, IS_LONG, 0, "-1")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, enableWebSocket)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    zend_long flags = CAT_WEBSOCKET_CODEC_FLAG_DEFAULT;
+    zend_string *extensions = NULL;
+    zend_long max_message_length = CAT_WEBSOCKET_DEFAULT_MAX_MESSAGE_LENGTH;
+    zend_long compression_level = -1;
+    cat_websocket_codec_t *codec;
+
+    ZEND_PARSE_PARAMETERS_START(0, 4)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(flags)
+        Z_PARAM_STR(extensions)
+        Z_PARAM_LONG(max_message_length)
+        Z_PARAM_LONG(compression_level)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(s_socket->websocket_codec != NULL)) {
+        swow_throw_exception(swow_socket_exception_ce, CAT_EMISUSE, "WebSocket codec has been enabled");
+        RETURN_THROWS();
     }
-    while (buffer_count--) {
-        zend_string_release(strings[buffer_count]);
+    if (UNEXPECTED(max_message_length < 0)) {
+        zend_argument_value_error(3, "must be greater than or equal to 0");
+        RETURN_THROWS();
     }
-    if (UNEXPECTED(strings_on_heap != NULL)) {
-        efree(strings_on_heap);
+    if (UNEXPECTED(compression_level < -1 || compression_level > 9)) {
+        zend_argument_value_error(4, "must be between -1 and 9");
+        RETURN_THROWS();
     }
-    if (UNEXPECTED(vector_list_on_heap != NULL)) {
-        efree(vector_list_on_heap);
+
+    codec = (cat_websocket_codec_t *) emalloc(sizeof(*codec));
+    cat_websocket_codec_init(codec, (cat_websocket_codec_flags_t) flags);
+    codec->max_message_length = (uint64_t) max_message_length;
+    /* extensions is the Sec-WebSocket-Extensions value of the handshake response */
+    if (extensions != NULL && ZSTR_LEN(extensions) != 0) {
+        cat_websocket_deflate_options_t options;
+        if (UNEXPECTED(!cat_websocket_deflate_options_parse(&options, ZSTR_VAL(extensions), ZSTR_LEN(extensions)) ||
+                       !cat_websocket_codec_enable_deflate(codec, &options, (int) compression_level))) {
+            cat_websocket_codec_close(codec);
+            efree(codec);
+            swow_throw_exception_with_last(swow_socket_exception_ce);
+            RETURN_THROWS();
+        }
     }
+    s_socket->websocket_codec = codec;
+
+    RETURN_THIS();
 }
 
-ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_write, 0, 1, IS_STATIC, 0)
-    ZEND_ARG_TYPE_INFO(0, vector, IS_ARRAY, 0)
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_recvWebSocketMessage, 0, 1, IS_LONG, 0)
+    ZEND_ARG_OBJ_INFO(0, buffer, Swow\\Buffer, 0)
     ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
 ZEND_END_ARG_INFO()
 
-static PHP_METHOD(Swow_Socket, write)
+static PHP_METHOD(Swow_Socket, recvWebSocketMessage)
 {
-    PHP_METHOD_CALL(Swow_Socket, _write, 0, 0);
-}
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    zend_object *buffer_object;
+    zend_long timeout;
+    bool timeout_is_null = 1;
+    cat_websocket_codec_t *codec;
+    swow_buffer_t *s_buffer;
+    cat_buffer_t *buffer;
+    int opcode;
 
-ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_writeTo, 0, 1, IS_STATIC, 0)
-    ZEND_ARG_TYPE_INFO(0, vector, IS_ARRAY, 0)
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, address, IS_STRING, 1, "null")
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, port, IS_LONG, 1, "null")
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
-ZEND_END_ARG_INFO()
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_OBJ_OF_CLASS(buffer_object, swow_buffer_ce)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
+    ZEND_PARSE_PARAMETERS_END();
 
-static PHP_METHOD(Swow_Socket, writeTo)
-{
-    PHP_METHOD_CALL(Swow_Socket, _write, 0, 1);
-}
+    SWOW_SOCKET_WEBSOCKET_CODEC_CHECK(s_socket, codec);
+    if (timeout_is_null) {
+        timeout = cat_socket_get_read_timeout(socket);
+    }
 
-ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_send, 0, 1, IS_STATIC, 0)
-    ZEND_ARG_OBJ_TYPE_MASK(0, data, Stringable, MAY_BE_STRING, NULL)
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, start, IS_LONG, 0, "0")
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 0, "-1")
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
-ZEND_END_ARG_INFO()
+    s_buffer = swow_buffer_get_from_object(buffer_object);
+    buffer = &s_buffer->buffer;
 
-static PHP_METHOD(Swow_Socket, send)
-{
-    PHP_METHOD_CALL(Swow_Socket, _write, 1, 0);
+    SWOW_BUFFER_LOCK(s_buffer);
+
+    swow_buffer_cow(s_buffer);
+
+    /* payload is appended to the buffer directly (it may be extended) */
+    opcode = cat_websocket_recv_message_ex(socket, codec, buffer, timeout);
+
+    SWOW_BUFFER_UNLOCK(s_buffer);
+
+    if (buffer->value != NULL) {
+        swow_buffer_update(s_buffer, buffer->length);
+    }
+
+    if (UNEXPECTED(opcode < 0)) {
+        swow_throw_call_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_LONG(opcode);
 }
 
-ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_sendTo, 0, 1, IS_STATIC, 0)
-    ZEND_ARG_OBJ_TYPE_MASK(0, data, Stringable, MAY_BE_STRING, NULL)
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, start, IS_LONG, 0, "0")
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 0, "-1")
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, address, IS_STRING, 1, "null")
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, port, IS_LONG, 1, "null")
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_getWebSocketControlPayload, 0, 0, IS_STRING, 0)
 ZEND_END_ARG_INFO()
 
-static PHP_METHOD(Swow_Socket, sendTo)
+static PHP_METHOD(Swow_Socket, getWebSocketControlPayload)
 {
-    PHP_METHOD_CALL(Swow_Socket, _write, 1, 1);
+    swow_socket_t *s_socket = swow_socket_get_from_object(Z_OBJ_P(ZEND_THIS));
+    cat_websocket_codec_t *codec;
+    const char *payload;
+    size_t length;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    SWOW_SOCKET_WEBSOCKET_CODEC_CHECK(s_socket, codec);
+
+    payload = cat_websocket_codec_get_control_payload(codec, &length);
+
+    RETURN_STRINGL(payload, length);
 }
 
-ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_sendHandle, 0, 1, IS_STATIC, 0)
-    ZEND_ARG_OBJ_INFO(0, handle, Swow\\Socket, 0)
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_sendWebSocketMessage, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_OBJ_TYPE_MASK(0, data, Stringable, MAY_BE_STRING, NULL)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, opcode, IS_LONG, 0, "Swow\\WebSocket\\Opcode::TEXT")
     ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
 ZEND_END_ARG_INFO()
 
-static PHP_METHOD(Swow_Socket, sendHandle)
+static PHP_METHOD(Swow_Socket, sendWebSocketMessage)
 {
     SWOW_SOCKET_GETTER(s_socket, socket);
-    zend_object *handle_object;
+    zend_string *data;
+    zend_long opcode = CAT_WEBSOCKET_OPCODE_TEXT;
     zend_long timeout;
     bool timeout_is_null = 1;
-    swow_socket_t *s_handle;
-    cat_socket_t *handle;
+    cat_websocket_codec_t *codec;
     cat_bool_t ret;
 
-    ZEND_PARSE_PARAMETERS_START(1, 2)
-        Z_PARAM_OBJ_OF_CLASS(handle_object, swow_socket_ce)
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        SWOW_PARAM_STRINGABLE_EXPECT_BUFFER_FOR_READING(data)
         Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(opcode)
         Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
     ZEND_PARSE_PARAMETERS_END();
 
-    s_handle = swow_socket_get_from_object(handle_object);
-    handle = &s_handle->socket;
+    SWOW_SOCKET_WEBSOCKET_CODEC_CHECK(s_socket, codec);
+    if (UNEXPECTED(opcode < 0 || opcode > 0xf)) {
+        zend_argument_value_error(2, "is unknown");
+        RETURN_THROWS();
+    }
     if (timeout_is_null) {
         timeout = cat_socket_get_write_timeout(socket);
     }
 
-    ret = cat_socket_send_handle_ex(socket, handle, timeout);
+    ret = cat_websocket_send_message_ex(socket, codec, (cat_websocket_opcode_t) opcode, ZSTR_VAL(data), ZSTR_LEN(data), timeout);
 
     if (UNEXPECTED(!ret)) {
         swow_throw_call_exception_with_last(swow_socket_exception_ce);
@@ -1332,64 +2172,71 @@ static PHP_METHOD(Swow_Socket, sendHandle)
     RETURN_THIS();
 }
 
-ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_sendFile, 0, 1, IS_LONG, 0)
-    ZEND_ARG_TYPE_INFO(0, filename, IS_STRING, 0)
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, offset, IS_LONG, 0, "0")
-    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 0, "0")
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_sendWebSocketClose, 0, 0, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, code, IS_LONG, 0, "Swow\\WebSocket\\Status::NORMAL_CLOSURE")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, reason, IS_STRING, 0, "\'\'")
     ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 1, "null")
 ZEND_END_ARG_INFO()
 
-static PHP_METHOD(Swow_Socket, sendFile)
+static PHP_METHOD(Swow_Socket, sendWebSocketClose)
 {
     SWOW_SOCKET_GETTER(s_socket, socket);
-    zend_string *filename;
-    zend_long offset = 0;
-    zend_long length = 0;
+    zend_long code = CAT_WEBSOCKET_STATUS_NORMAL_CLOSURE;
+    zend_string *reason = NULL;
     zend_long timeout;
     bool timeout_is_null = 1;
-    ssize_t written;
+    cat_websocket_codec_t *codec;
+    cat_bool_t ret;
 
-    ZEND_PARSE_PARAMETERS_START(1, 4)
-        Z_PARAM_STR(filename)
+    ZEND_PARSE_PARAMETERS_START(0, 3)
         Z_PARAM_OPTIONAL
-        Z_PARAM_LONG(offset)
-        Z_PARAM_LONG(length)
+        Z_PARAM_LONG(code)
+        Z_PARAM_STR(reason)
         Z_PARAM_LONG_OR_NULL(timeout, timeout_is_null)
     ZEND_PARSE_PARAMETERS_END();
 
-    if (length == -1) {
-        // 0 means unlimited for sendfile()
-        length = 0;
-    } else if (UNEXPECTED(length < 0)) {
-        zend_argument_error(swow_socket_exception_ce, 3, "can only be -1 to refer to unlimited when it is negative");
+    SWOW_SOCKET_WEBSOCKET_CODEC_CHECK(s_socket, codec);
+    /* 0 means that close frame has no status code */
+    if (UNEXPECTED(code < 0 || code > UINT16_MAX)) {
+        zend_argument_value_error(1, "must be between 0 and %u", UINT16_MAX);
         RETURN_THROWS();
     }
     if (timeout_is_null) {
         timeout = cat_socket_get_write_timeout(socket);
     }
 
-    written = cat_socket_send_file_ex(socket, ZSTR_VAL(filename), offset, length, timeout);
+    ret = cat_websocket_send_close_ex(
+        socket, codec, (cat_websocket_status_code_t) code,
+        reason != NULL ? ZSTR_VAL(reason) : NULL, reason != NULL ? ZSTR_LEN(reason) : 0,
+        timeout
+    );
 
-    if (UNEXPECTED(written < 0)) {
+    if (UNEXPECTED(!ret)) {
         swow_throw_call_exception_with_last(swow_socket_exception_ce);
         RETURN_THROWS();
     }
 
-    // TODO: RETURN_LONG_SAFE() ? may SIZE_MAX be bigger than ZEND_LONG_MAX?
-    RETURN_LONG(written);
+    RETURN_THIS();
 }
 
+#undef SWOW_SOCKET_WEBSOCKET_CODEC_CHECK
+
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_close, 0, 0, _IS_BOOL, 0)
 ZEND_END_ARG_INFO()
 
 static PHP_METHOD(Swow_Socket, close)
 {
     SWOW_SOCKET_GETTER(s_socket, socket);
-    cat_bool_t ret;
+    cat_bool_t ret = cat_true;
 
     ZEND_PARSE_PARAMETERS_NONE();
 
-    ret = cat_socket_close(socket);
+    /* user close() is graceful, corked data is flushed first (it may block),
+     * while close() from destructor only tries to flush it once */
+    if (cat_socket_is_corked(socket) && UNEXPECTED(!cat_socket_uncork(socket))) {
+        ret = cat_false;
+    }
+    ret = cat_socket_close(socket) && ret;
 
     RETURN_BOOL(ret);
 }
@@ -1430,6 +2277,10 @@ SWOW_SOCKET_IS_XXX_API_GEN(ServerConnection, server_connection)
 
 SWOW_SOCKET_IS_XXX_API_GEN(Client, client)
 
+#define arginfo_class_Swow_Socket_isCorked arginfo_class_Swow_Socket_close
+
+SWOW_SOCKET_IS_XXX_API_GEN(Corked, corked)
+
 #define arginfo_class_Swow_Socket_getConnectionError arginfo_class_Swow_Socket_getId
 
 static PHP_METHOD(Swow_Socket, getConnectionError)
@@ -1516,6 +2367,58 @@ static PHP_METHOD(Swow_Socket, getSendBufferSize)
     RETURN_LONG(cat_socket_get_send_buffer_size(socket));
 }
 
+#define arginfo_class_Swow_Socket_getIncomingCpu arginfo_class_Swow_Socket_getId
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket___debugInfo, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, getIncomingCpu)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    int cpu;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    cpu = cat_socket_get_incoming_cpu(socket);
+
+    if (UNEXPECTED(cpu < 0)) {
+        swow_throw_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_LONG(cpu);
+}
+
+#define arginfo_class_Swow_Socket_getAcceptStats arginfo_class_Swow_Socket___debugInfo
+
+static PHP_METHOD(Swow_Socket, getAcceptStats)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    cat_socket_accept_stats_t stats;
+    cat_msec_t uptime;
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    if (UNEXPECTED(!cat_socket_get_accept_stats(socket, &stats))) {
+        swow_throw_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+    uptime = cat_time_msec_cached() - stats.listen_time;
+
+    array_init(return_value);
+    add_assoc_long(return_value, "count", (zend_long) stats.count);
+    add_assoc_long(return_value, "rounds", (zend_long) stats.rounds);
+    add_assoc_long(return_value, "last_batch_size", (zend_long) stats.last_batch_size);
+    add_assoc_long(return_value, "max_batch_size", (zend_long) stats.max_batch_size);
+    add_assoc_double(return_value, "rate", uptime > 0 ? (double) stats.count * 1000 / uptime : 0.0);
+    add_assoc_long(return_value, "uptime", (zend_long) uptime);
+    add_assoc_long(return_value, "idle", stats.count > 0 ? (zend_long) (cat_time_msec_cached() - stats.last_accept_time) : (zend_long) uptime);
+    add_assoc_long(return_value, "queue_length", (zend_long) stats.queue_length);
+    add_assoc_long(return_value, "queue_capacity", (zend_long) stats.queue_capacity);
+    add_assoc_long(return_value, "listen_overflows", (zend_long) stats.listen_overflows);
+    add_assoc_long(return_value, "listen_drops", (zend_long) stats.listen_drops);
+}
+
 /* setter */
 
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_setRecvBufferSize, 0, 1, IS_STATIC, 0)
@@ -1622,9 +2525,89 @@ static PHP_METHOD(Swow_Socket, setTcpKeepAlive)
     RETURN_THIS();
 }
 
-ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket___debugInfo, 0, 0, IS_ARRAY, 0)
+#define arginfo_class_Swow_Socket_setWriteCoalescing arginfo_class_Swow_Socket_setTcpNodelay
+
+static PHP_METHOD(Swow_Socket, setWriteCoalescing)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    bool enable = cat_true;
+    cat_bool_t ret;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_BOOL(enable)
+    ZEND_PARSE_PARAMETERS_END();
+
+    ret = cat_socket_set_write_coalescing(socket, enable);
+
+    if (UNEXPECTED(!ret)) {
+        swow_throw_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_THIS();
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_setIncomingCpu, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO(0, cpu, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Socket, setIncomingCpu)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    zend_long cpu;
+    cat_bool_t ret;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(cpu)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(cpu < 0 || cpu > INT_MAX)) {
+        zend_argument_value_error(1, "must be greater than or equal to 0 and less than or equal to %d", INT_MAX);
+        RETURN_THROWS();
+    }
+
+    ret = cat_socket_set_incoming_cpu(socket, (int) cpu);
+
+    if (UNEXPECTED(!ret)) {
+        swow_throw_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_THIS();
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Socket_setReusePortCpuAffinity, 0, 0, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, groupSize, IS_LONG, 0, "0")
 ZEND_END_ARG_INFO()
 
+static PHP_METHOD(Swow_Socket, setReusePortCpuAffinity)
+{
+    SWOW_SOCKET_GETTER(s_socket, socket);
+    zend_long group_size = 0;
+    cat_bool_t ret;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(group_size)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(group_size < 0 || group_size > UINT32_MAX)) {
+        zend_argument_value_error(1, "must be greater than or equal to 0 and less than or equal to %u", (unsigned int) UINT32_MAX);
+        RETURN_THROWS();
+    }
+
+    ret = cat_socket_set_reuseport_cpu_affinity(socket, (uint32_t) group_size);
+
+    if (UNEXPECTED(!ret)) {
+        swow_throw_exception_with_last(swow_socket_exception_ce);
+        RETURN_THROWS();
+    }
+
+    RETURN_THIS();
+}
+
+
 static PHP_METHOD(Swow_Socket, __debugInfo)
 {
     SWOW_SOCKET_GETTER(s_socket, socket);
@@ -1704,8 +2687,12 @@ static const zend_function_entry swow_socket_methods[] = {
     PHP_ME(Swow_Socket, listen,                    arginfo_class_Swow_Socket_listen,              ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, accept,                    arginfo_class_Swow_Socket_accept,              ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, acceptTo,                  arginfo_class_Swow_Socket_acceptTo,            ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, acceptMany,                arginfo_class_Swow_Socket_acceptMany,          ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, acceptManyTo,              arginfo_class_Swow_Socket_acceptManyTo,        ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, connect,                   arginfo_class_Swow_Socket_connect,             ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, enableCrypto,              arginfo_class_Swow_Socket_enableCrypto,        ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, getCryptoSessionStats,     arginfo_class_Swow_Socket_getCryptoSessionStats, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Socket, getCryptoKtlsStatus,       arginfo_class_Swow_Socket_getCryptoKtlsStatus, ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, getSockAddress,            arginfo_class_Swow_Socket_getAddress,          ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, getSockPort,               arginfo_class_Swow_Socket_getPort,             ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, getPeerAddress,            arginfo_class_Swow_Socket_getAddress,          ZEND_ACC_PUBLIC)
@@ -1724,12 +2711,25 @@ static const zend_function_entry swow_socket_methods[] = {
     PHP_ME(Swow_Socket, recvStringDataFrom,        arginfo_class_Swow_Socket_recvStringDataFrom,  ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, peekString,                arginfo_class_Swow_Socket_peekString,          ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, peekStringFrom,            arginfo_class_Swow_Socket_peekStringFrom,      ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, readLine,                  arginfo_class_Swow_Socket_readLine,            ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, readUntil,                 arginfo_class_Swow_Socket_readUntil,           ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, readFrame,                 arginfo_class_Swow_Socket_readFrame,           ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, getReadBufferedLength,     arginfo_class_Swow_Socket_getReadBufferedLength, ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, recvMultipleFrom,          arginfo_class_Swow_Socket_recvMultipleFrom,    ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, sendMultipleTo,            arginfo_class_Swow_Socket_sendMultipleTo,      ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, write,                     arginfo_class_Swow_Socket_write,               ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, writeTo,                   arginfo_class_Swow_Socket_writeTo,             ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, send,                      arginfo_class_Swow_Socket_send,                ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, sendTo,                    arginfo_class_Swow_Socket_sendTo,              ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, sendHandle,                arginfo_class_Swow_Socket_sendHandle,          ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, sendFile,                  arginfo_class_Swow_Socket_sendFile,            ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, cork,                      arginfo_class_Swow_Socket_cork,                ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, uncork,                    arginfo_class_Swow_Socket_uncork,              ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, enableWebSocket,           arginfo_class_Swow_Socket_enableWebSocket,     ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, recvWebSocketMessage,      arginfo_class_Swow_Socket_recvWebSocketMessage, ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, getWebSocketControlPayload, arginfo_class_Swow_Socket_getWebSocketControlPayload, ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, sendWebSocketMessage,      arginfo_class_Swow_Socket_sendWebSocketMessage, ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, sendWebSocketClose,        arginfo_class_Swow_Socket_sendWebSocketClose,  ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, close,                     arginfo_class_Swow_Socket_close,               ZEND_ACC_PUBLIC)
     /* status */
     PHP_ME(Swow_Socket, isAvailable,               arginfo_class_Swow_Socket_isAvailable,         ZEND_ACC_PUBLIC)
@@ -1738,6 +2738,7 @@ static const zend_function_entry swow_socket_methods[] = {
     PHP_ME(Swow_Socket, isServer,                  arginfo_class_Swow_Socket_isServer,            ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, isServerConnection,        arginfo_class_Swow_Socket_isServerConnection,  ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, isClient,                  arginfo_class_Swow_Socket_isClient,            ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, isCorked,                  arginfo_class_Swow_Socket_isCorked,            ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, getConnectionError,        arginfo_class_Swow_Socket_getConnectionError,  ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, checkLiveness,             arginfo_class_Swow_Socket_checkLiveness,       ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, getIoState,                arginfo_class_Swow_Socket_getIoState,          ZEND_ACC_PUBLIC)
@@ -1745,11 +2746,16 @@ static const zend_function_entry swow_socket_methods[] = {
     PHP_ME(Swow_Socket, getIoStateNaming,          arginfo_class_Swow_Socket_getIoStateNaming,    ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, getRecvBufferSize,         arginfo_class_Swow_Socket_getRecvBufferSize,   ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, getSendBufferSize,         arginfo_class_Swow_Socket_getSendBufferSize,   ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, getIncomingCpu,            arginfo_class_Swow_Socket_getIncomingCpu,      ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, getAcceptStats,            arginfo_class_Swow_Socket_getAcceptStats,      ZEND_ACC_PUBLIC)
     /* setter */
     PHP_ME(Swow_Socket, setRecvBufferSize,         arginfo_class_Swow_Socket_setRecvBufferSize,   ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, setSendBufferSize,         arginfo_class_Swow_Socket_setSendBufferSize,   ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, setTcpNodelay,             arginfo_class_Swow_Socket_setTcpNodelay,       ZEND_ACC_PUBLIC)
     PHP_ME(Swow_Socket, setTcpKeepAlive,           arginfo_class_Swow_Socket_setTcpKeepAlive,     ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, setWriteCoalescing,        arginfo_class_Swow_Socket_setWriteCoalescing,  ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, setIncomingCpu,            arginfo_class_Swow_Socket_setIncomingCpu,      ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Socket, setReusePortCpuAffinity,   arginfo_class_Swow_Socket_setReusePortCpuAffinity, ZEND_ACC_PUBLIC)
     /* magic */
     PHP_ME(Swow_Socket, __debugInfo,               arginfo_class_Swow_Socket___debugInfo,         ZEND_ACC_PUBLIC)
     /* globals */
@@ -1793,6 +2799,7 @@ zend_result swow_socket_module_init(INIT_FUNC_ARGS)
     /* constants */
     zend_declare_class_constant_long(swow_socket_ce, ZEND_STRL("INVALID_FD"), CAT_SOCKET_INVALID_FD);
     zend_declare_class_constant_long(swow_socket_ce, ZEND_STRL("DEFAULT_BACKLOG"), CAT_SOCKET_DEFAULT_BACKLOG);
+    zend_declare_class_constant_long(swow_socket_ce, ZEND_STRL("DEFAULT_MAX_FRAME_LENGTH"), CAT_SOCKET_DEFAULT_MAX_FRAME_LENGTH);
 #define SWOW_SOCKET_TYPE_FLAG_GEN(name, value) \
     zend_declare_class_constant_long(swow_socket_ce, ZEND_STRL("TYPE_FLAG_" #name), (value));
     CAT_SOCKET_TYPE_FLAG_MAP(SWOW_SOCKET_TYPE_FLAG_GEN)
@@ -1819,6 +2826,11 @@ zend_result swow_socket_module_init(INIT_FUNC_ARGS)
 
 zend_result swow_socket_module_shutdown(INIT_FUNC_ARGS)
 {
+#ifdef CAT_SSL
+    if (!cat_ssl_module_shutdown()) {
+        return FAILURE;
+    }
+#endif
     if (!cat_socket_module_shutdown()) {
         return FAILURE;
     }
@@ -1831,6 +2843,11 @@ zend_result swow_socket_runtime_init(INIT_FUNC_ARGS)
     if (!cat_socket_runtime_init()) {
         return FAILURE;
     }
+#ifdef CAT_SSL
+    if (!cat_ssl_runtime_init()) {
+        return FAILURE;
+    }
+#endif
 
     return SUCCESS;
 }
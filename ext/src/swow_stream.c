@@ -789,6 +789,9 @@ static int swow_stream_enable_crypto(php_stream *stream,
         if (GET_VER_OPT("no_ticket") && zend_is_true(val)) {
             options.no_ticket = cat_true;
         }
+        if (GET_VER_OPT("ktls") && zend_is_true(val)) {
+            options.ktls = cat_true;
+        }
         if (!GET_VER_OPT("disable_compression") || zend_is_true(val)) {
             options.no_compression = cat_true;
         }
@@ -1141,6 +1144,11 @@ static int swow_stream_close(php_stream *stream, int close_handle)
         return 0;
     }
 
+    if (swow_sock->poll_watcher != NULL) {
+        cat_poll_watcher_close(swow_sock->poll_watcher);
+        swow_sock->poll_watcher = NULL;
+    }
+
     if (close_handle) {
 #ifdef PHP_WIN32
         if (sock->socket < 0) {
@@ -1639,7 +1647,61 @@ static PHP_FUNCTION(swow_stream_socket_sendto)
 /* }}} */
 
 /* {{{ stream_select related functions */
-static int swow_stream_array_to_fd_set(zval *stream_array, fd_set *fds, php_socket_t *max_fd)
+typedef struct swow_stream_poll_watchers_s {
+    cat_poll_watcher_t *watchers_stacked[8];
+    cat_poll_watcher_t **watchers;
+    size_t count;
+    size_t size;
+} swow_stream_poll_watchers_t;
+
+/* watcher keeps fd being watched across stream_select() calls,
+ * it only works for our non-persistent socket streams */
+static cat_poll_watcher_t *swow_stream_get_poll_watcher(php_stream *stream, php_socket_t fd)
+{
+    swow_netstream_data_t *swow_sock;
+
+    if (stream->ops->close != swow_stream_close || php_stream_is_persistent(stream)) {
+        return NULL;
+    }
+    swow_sock = (swow_netstream_data_t *) stream->abstract;
+    if (swow_sock == NULL) {
+        return NULL;
+    }
+    if (swow_sock->poll_watcher != NULL) {
+        if (EXPECTED(cat_poll_watcher_get_fd(swow_sock->poll_watcher) == (cat_os_socket_t) fd)) {
+            return swow_sock->poll_watcher;
+        }
+        cat_poll_watcher_close(swow_sock->poll_watcher);
+    }
+    /* fallback to one-shot poll if it failed */
+    swow_sock->poll_watcher = cat_poll_watcher_create((cat_os_socket_t) fd);
+
+    return swow_sock->poll_watcher;
+}
+
+static void swow_stream_poll_watchers_add(swow_stream_poll_watchers_t *watchers, cat_poll_watcher_t *watcher)
+{
+    if (watchers->count == watchers->size) {
+        watchers->size *= 2;
+        if (watchers->watchers == watchers->watchers_stacked) {
+            watchers->watchers = (cat_poll_watcher_t **) emalloc(watchers->size * sizeof(*watchers->watchers));
+            memcpy(watchers->watchers, watchers->watchers_stacked, sizeof(watchers->watchers_stacked));
+        } else {
+            watchers->watchers = (cat_poll_watcher_t **) erealloc(watchers->watchers, watchers->size * sizeof(*watchers->watchers));
+        }
+    }
+    watchers->watchers[watchers->count++] = watcher;
+}
+
+static int swow_stream_poll_watcher_compare(const void *a, const void *b)
+{
+    cat_os_socket_t fd_a = cat_poll_watcher_get_fd(*(cat_poll_watcher_t *const *) a);
+    cat_os_socket_t fd_b = cat_poll_watcher_get_fd(*(cat_poll_watcher_t *const *) b);
+
+    return fd_a < fd_b ? -1 : (fd_a > fd_b ? 1 : 0);
+}
+
+static int swow_stream_array_to_fd_set(zval *stream_array, fd_set *fds, php_socket_t *max_fd, swow_stream_poll_watchers_t *watchers)
 {
     zval *elem;
     php_stream *stream;
@@ -1671,11 +1733,17 @@ static int swow_stream_array_to_fd_set(zval *stream_array, fd_set *fds, php_sock
             this_fd != -1
         ) {
 
+            cat_poll_watcher_t *watcher;
+
             PHP_SAFE_FD_SET(this_fd, fds);
 
             if (this_fd > *max_fd) {
                 *max_fd = this_fd;
             }
+            watcher = swow_stream_get_poll_watcher(stream, this_fd);
+            if (watcher != NULL) {
+                swow_stream_poll_watchers_add(watchers, watcher);
+            }
             cnt++;
         }
     } ZEND_HASH_FOREACH_END();
@@ -1798,6 +1866,7 @@ PHP_FUNCTION(swow_stream_select)
     zval *r_array, *w_array, *e_array;
     struct timeval tv, *tv_p = NULL;
     fd_set rfds, wfds, efds;
+    swow_stream_poll_watchers_t watchers;
     php_socket_t max_fd = 0;
     int retval, sets = 0;
     zend_long sec, usec = 0;
@@ -1824,22 +1893,26 @@ PHP_FUNCTION(swow_stream_select)
     FD_ZERO(&wfds);
     FD_ZERO(&efds);
 
+    watchers.watchers = watchers.watchers_stacked;
+    watchers.count = 0;
+    watchers.size = CAT_ARRAY_SIZE(watchers.watchers_stacked);
+
     if (r_array != NULL) {
-        set_count = swow_stream_array_to_fd_set(r_array, &rfds, &max_fd);
+        set_count = swow_stream_array_to_fd_set(r_array, &rfds, &max_fd, &watchers);
         if (set_count > max_set_count)
             max_set_count = set_count;
         sets += set_count;
     }
 
     if (w_array != NULL) {
-        set_count = swow_stream_array_to_fd_set(w_array, &wfds, &max_fd);
+        set_count = swow_stream_array_to_fd_set(w_array, &wfds, &max_fd, &watchers);
         if (set_count > max_set_count)
             max_set_count = set_count;
         sets += set_count;
     }
 
     if (e_array != NULL) {
-        set_count = swow_stream_array_to_fd_set(e_array, &efds, &max_fd);
+        set_count = swow_stream_array_to_fd_set(e_array, &efds, &max_fd, &watchers);
         if (set_count > max_set_count)
             max_set_count = set_count;
         sets += set_count;
@@ -1847,7 +1920,8 @@ PHP_FUNCTION(swow_stream_select)
 
     if (!sets) {
         zend_value_error("No stream arrays were passed");
-        RETURN_THROWS();
+        retval = -1;
+        goto _out;
     }
 
     PHP_SAFE_MAX_FD(max_fd, max_set_count);
@@ -1858,7 +1932,8 @@ PHP_FUNCTION(swow_stream_select)
             php_error_docref(NULL, E_DEPRECATED, "Argument #5 ($microseconds) should be null instead of 0 when argument #4 ($seconds) is null");
         } else {
             zend_argument_value_error(5, "must be null when argument #4 ($seconds) is null");
-            RETURN_THROWS();
+            retval = -1;
+            goto _out;
         }
     }
 #endif // PHP_VERSION_ID >= 80100
@@ -1868,12 +1943,14 @@ PHP_FUNCTION(swow_stream_select)
 
         if (sec < 0) {
             zend_argument_value_error(4, "must be greater than or equal to 0");
-            RETURN_THROWS();
+            retval = -1;
+            goto _out;
         } else if (usec < 0) {
             // there's a bug before b751c24e233945281b08ef15b569a63feb6e0c48
             // here we fixed it
             zend_argument_value_error(5, "must be greater than or equal to 0");
-            RETURN_THROWS();
+            retval = -1;
+            goto _out;
         }
 
         /* Windows, Solaris and BSD do not like microsecond values which are >= 1 sec */
@@ -1896,16 +1973,19 @@ PHP_FUNCTION(swow_stream_select)
                 zval_ptr_dtor(e_array);
                 ZVAL_EMPTY_ARRAY(e_array);
             }
-            RETURN_LONG(retval);
+            goto _out;
         }
     }
 
-    retval = cat_select(max_fd + 1, &rfds, &wfds, &efds, tv_p);
+    if (watchers.count > 1) {
+        qsort(watchers.watchers, watchers.count, sizeof(*watchers.watchers), swow_stream_poll_watcher_compare);
+    }
+    retval = cat_select_ex(max_fd + 1, &rfds, &wfds, &efds, tv_p, watchers.watchers, watchers.count);
 
     if (retval == -1) {
         php_error_docref(NULL, E_WARNING, "Unable to select [%d]: %s (max_fd=%d)",
             errno, strerror(errno), max_fd);
-        RETURN_FALSE;
+        goto _out;
     }
 
     if (r_array != NULL) {
@@ -1918,6 +1998,16 @@ PHP_FUNCTION(swow_stream_select)
         swow_stream_array_from_fd_set(e_array, &efds);
     }
 
+    _out:
+    if (watchers.watchers != watchers.watchers_stacked) {
+        efree(watchers.watchers);
+    }
+    if (UNEXPECTED(EG(exception) != NULL)) {
+        RETURN_THROWS();
+    }
+    if (retval == -1) {
+        RETURN_FALSE;
+    }
     RETURN_LONG(retval);
 }
 /* }}} */
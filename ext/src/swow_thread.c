@@ -17,18 +17,988 @@
  */
 
 #include "swow_thread.h"
+#include "swow_socket.h"
 
-SWOW_API zend_class_entry *swow_thread_wait_reference_ce;
-SWOW_API zend_object_handlers swow_thread_wait_reference_handlers;
+#include "cat_time.h"
+
+#include "ext/standard/php_var.h"
+#include "zend_smart_str.h"
+
+SWOW_API zend_class_entry *swow_thread_ce;
+SWOW_API zend_object_handlers swow_thread_handlers;
 
 SWOW_API zend_class_entry *swow_thread_exception_ce;
 
-SWOW_API CAT_GLOBALS_DECLARE(swow_thread)
+SWOW_API CAT_GLOBALS_DECLARE(swow_thread);
+
+#ifdef SWOW_THREAD
+
+#define SWOW_THREAD_MAILBOX_CAPACITY 1024
+
+typedef enum swow_thread_state_e {
+    SWOW_THREAD_STATE_STARTING,
+    SWOW_THREAD_STATE_RUNNING,
+    SWOW_THREAD_STATE_EXITED,
+} swow_thread_state_t;
+
+struct swow_thread_context_s {
+    cat_atomic_uint32_t refcount;
+    uint32_t id;
+    uv_mutex_t mutex;
+    uv_cond_t cond;
+    /* owned by the thread itself, and they are NULL if it is not running,
+     * other threads must access them with mutex locked */
+    cat_thread_channel_t *mailbox;
+    uv_async_t *notifier;
+    /* senders which are waiting for space in mailbox, guarded by mutex */
+    cat_queue_t senders;
+    /* following fields are only for child threads */
+    swow_thread_context_t *parent;
+    uv_thread_t tid;
+    swow_thread_state_t state;
+    int exit_status;
+    char *file;
+    char *arguments;
+    size_t arguments_length;
+    /* parent thread only */
+    cat_queue_node_t node;
+    cat_coroutine_t *waiter;
+    swow_thread_state_t wait_state;
+    cat_bool_t joined;
+};
+
+/* it lives on the stack of the sender coroutine */
+typedef struct swow_thread_sender_s {
+    /* in senders of receiver, guarded by mutex of receiver */
+    cat_queue_node_t node;
+    /* in senders of the sender thread */
+    cat_queue_node_t local_node;
+    swow_thread_context_t *receiver;
+    uv_async_t *notifier;
+    cat_coroutine_t *coroutine;
+    cat_bool_t notified;
+} swow_thread_sender_t;
+
+typedef enum swow_thread_message_type_e {
+    SWOW_THREAD_MESSAGE_TYPE_VALUE,
+    SWOW_THREAD_MESSAGE_TYPE_SOCKET,
+} swow_thread_message_type_t;
+
+typedef struct swow_thread_message_s {
+    swow_thread_message_type_t type;
+    union {
+        size_t length;
+        struct {
+            cat_socket_type_t type;
+            cat_os_socket_t os_socket;
+        } socket;
+    } u;
+    char data[1];
+} swow_thread_message_t;
+
+static cat_atomic_uint32_t swow_thread_last_id;
+
+/* context */
+
+static swow_thread_context_t *swow_thread_context_create(swow_thread_context_t *parent)
+{
+    swow_thread_context_t *context = (swow_thread_context_t *) pecalloc(1, sizeof(*context), 1);
+
+    cat_atomic_uint32_init(&context->refcount, 1);
+    context->id = cat_atomic_uint32_fetch_add(&swow_thread_last_id, 1) + 1;
+    (void) uv_mutex_init(&context->mutex);
+    (void) uv_cond_init(&context->cond);
+    cat_queue_init(&context->senders);
+    context->parent = parent;
+    context->state = parent == NULL ? SWOW_THREAD_STATE_RUNNING : SWOW_THREAD_STATE_STARTING;
+
+    return context;
+}
+
+static swow_thread_context_t *swow_thread_context_addref(swow_thread_context_t *context)
+{
+    (void) cat_atomic_uint32_fetch_add(&context->refcount, 1);
+    return context;
+}
+
+static void swow_thread_context_release(swow_thread_context_t *context)
+{
+    if (cat_atomic_uint32_fetch_sub(&context->refcount, 1) != 1) {
+        return;
+    }
+    if (context->parent != NULL) {
+        swow_thread_context_release(context->parent);
+    }
+    if (context->file != NULL) {
+        pefree(context->file, 1);
+    }
+    if (context->arguments != NULL) {
+        pefree(context->arguments, 1);
+    }
+    uv_cond_destroy(&context->cond);
+    uv_mutex_destroy(&context->mutex);
+    pefree(context, 1);
+}
+
+static swow_thread_state_t swow_thread_context_get_state(swow_thread_context_t *context)
+{
+    swow_thread_state_t state;
+
+    uv_mutex_lock(&context->mutex);
+    state = context->state;
+    uv_mutex_unlock(&context->mutex);
+
+    return state;
+}
+
+/* called by the child thread itself */
+static void swow_thread_context_set_state(swow_thread_context_t *context, swow_thread_state_t state, int exit_status)
+{
+    swow_thread_context_t *parent = context->parent;
+
+    uv_mutex_lock(&context->mutex);
+    context->state = state;
+    context->exit_status = exit_status;
+    uv_cond_broadcast(&context->cond);
+    uv_mutex_unlock(&context->mutex);
+
+    uv_mutex_lock(&parent->mutex);
+    if (parent->notifier != NULL) {
+        (void) uv_async_send(parent->notifier);
+    }
+    uv_mutex_unlock(&parent->mutex);
+}
+
+/* wake up all senders waiting for mailbox of context (mutex must be locked),
+ * they will retry or see that mailbox has gone */
+static void swow_thread_context_notify_senders(swow_thread_context_t *context)
+{
+    swow_thread_sender_t *sender;
+
+    while ((sender = cat_queue_front_data(&context->senders, swow_thread_sender_t, node)) != NULL) {
+        cat_queue_remove(&sender->node);
+        sender->notified = cat_true;
+        (void) uv_async_send(sender->notifier);
+    }
+}
+
+/* message */
+
+static void swow_thread_message_free(swow_thread_message_t *message)
+{
+    if (message->type == SWOW_THREAD_MESSAGE_TYPE_SOCKET) {
+#ifndef CAT_OS_WIN
+        (void) close(message->u.socket.os_socket);
+#else
+        (void) closesocket(message->u.socket.os_socket);
+#endif
+    }
+    pefree(message, 1);
+}
+
+static void swow_thread_message_dtor(const cat_data_t *data)
+{
+    swow_thread_message_free(*(swow_thread_message_t **) data);
+}
+
+static swow_thread_message_t *swow_thread_message_create_from_socket(cat_socket_t *socket)
+{
+    swow_thread_message_t *message;
+    cat_socket_type_t type = cat_socket_get_simple_type(socket);
+    cat_socket_fd_t fd;
+    cat_os_socket_t os_socket;
+
+    if (!(((type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP) ||
+          ((type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP)
+#ifndef CAT_OS_WIN
+       || ((type & CAT_SOCKET_TYPE_PIPE) == CAT_SOCKET_TYPE_PIPE)
+       || ((type & CAT_SOCKET_TYPE_UDG) == CAT_SOCKET_TYPE_UDG)
+#endif
+    )) {
+        swow_throw_exception(swow_thread_exception_ce, CAT_EINVAL, "Socket of type %s can not be sent to other threads", cat_socket_get_type_name(socket));
+        return NULL;
+    }
+    fd = cat_socket_get_fd(socket);
+    if (UNEXPECTED(fd == CAT_SOCKET_INVALID_FD)) {
+        swow_throw_exception_with_last(swow_thread_exception_ce);
+        return NULL;
+    }
+    /* the socket is still owned by the sender, receiver gets a duplicated one */
+#ifndef CAT_OS_WIN
+    os_socket = dup(fd);
+#else
+    do {
+        WSAPROTOCOL_INFOW info;
+        if (WSADuplicateSocketW(fd, GetCurrentProcessId(), &info) != 0) {
+            os_socket = CAT_OS_INVALID_SOCKET;
+            break;
+        }
+        os_socket = WSASocketW(FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO, &info, 0, WSA_FLAG_OVERLAPPED);
+    } while (0);
+#endif
+    if (UNEXPECTED(os_socket == CAT_OS_INVALID_SOCKET)) {
+        swow_throw_exception(swow_thread_exception_ce,
+            cat_translate_sys_error(cat_sys_errno),
+            "Failed to dup socket: %s", cat_strerror(cat_sys_errno));
+        return NULL;
+    }
+
+    message = (swow_thread_message_t *) pemalloc(sizeof(*message), 1);
+    message->type = SWOW_THREAD_MESSAGE_TYPE_SOCKET;
+    message->u.socket.type = type;
+    message->u.socket.os_socket = os_socket;
+
+    return message;
+}
+
+static char *swow_thread_serialize(zval *zvalue, size_t *length)
+{
+    php_serialize_data_t var_hash;
+    smart_str buffer = { 0 };
+    char *data;
+
+    PHP_VAR_SERIALIZE_INIT(var_hash);
+    php_var_serialize(&buffer, zvalue, &var_hash);
+    PHP_VAR_SERIALIZE_DESTROY(var_hash);
+    if (UNEXPECTED(EG(exception) != NULL)) {
+        smart_str_free(&buffer);
+        return NULL;
+    }
+    smart_str_0(&buffer);
+    *length = ZSTR_LEN(buffer.s);
+    data = pemalloc(*length + 1, 1);
+    memcpy(data, ZSTR_VAL(buffer.s), *length + 1);
+    smart_str_free(&buffer);
+
+    return data;
+}
+
+static cat_bool_t swow_thread_unserialize(zval *zvalue, const char *data, size_t length)
+{
+    php_unserialize_data_t var_hash;
+    const unsigned char *p = (const unsigned char *) data;
+    cat_bool_t ret;
+
+    PHP_VAR_UNSERIALIZE_INIT(var_hash);
+    ret = php_var_unserialize(zvalue, &p, p + length, &var_hash);
+    PHP_VAR_UNSERIALIZE_DESTROY(var_hash);
+    if (UNEXPECTED(!ret)) {
+        if (!EG(exception)) {
+            swow_throw_exception(swow_thread_exception_ce, CAT_EINVAL, "Unserialize message failed");
+        }
+        zval_ptr_dtor(zvalue);
+        ZVAL_UNDEF(zvalue);
+    }
+
+    return ret;
+}
+
+static swow_thread_message_t *swow_thread_message_create(zval *zvalue)
+{
+    swow_thread_message_t *message;
+    char *data;
+    size_t length;
+
+    if (Z_TYPE_P(zvalue) == IS_OBJECT && instanceof_function(Z_OBJCE_P(zvalue), swow_socket_ce)) {
+        return swow_thread_message_create_from_socket(&swow_socket_get_from_object(Z_OBJ_P(zvalue))->socket);
+    }
+
+    data = swow_thread_serialize(zvalue, &length);
+    if (UNEXPECTED(data == NULL)) {
+        return NULL;
+    }
+    message = (swow_thread_message_t *) pemalloc(offsetof(swow_thread_message_t, data) + length, 1);
+    message->type = SWOW_THREAD_MESSAGE_TYPE_VALUE;
+    message->u.length = length;
+    memcpy(message->data, data, length);
+    pefree(data, 1);
+
+    return message;
+}
+
+/* consume the message and free it */
+static cat_bool_t swow_thread_message_get_value(swow_thread_message_t *message, zval *zvalue)
+{
+    cat_bool_t ret = cat_false;
+
+    if (message->type == SWOW_THREAD_MESSAGE_TYPE_SOCKET) {
+        swow_socket_t *s_socket;
+        cat_socket_type_t type = message->u.socket.type;
+        cat_bool_t opened;
+        object_init_ex(zvalue, swow_socket_ce);
+        s_socket = swow_socket_get_from_object(Z_OBJ_P(zvalue));
+        if (UNEXPECTED(cat_socket_create(&s_socket->socket, type) == NULL)) {
+            goto _socket_error;
+        }
+        if (((type & CAT_SOCKET_TYPE_TCP) == CAT_SOCKET_TYPE_TCP) ||
+            ((type & CAT_SOCKET_TYPE_UDP) == CAT_SOCKET_TYPE_UDP)) {
+            opened = cat_socket_open_os_socket(&s_socket->socket, message->u.socket.os_socket);
+        } else {
+            opened = cat_socket_open_os_fd(&s_socket->socket, (cat_os_fd_t) message->u.socket.os_socket);
+        }
+        if (UNEXPECTED(!opened)) {
+            goto _socket_error;
+        }
+        /* owned by socket now */
+        pefree(message, 1);
+        return cat_true;
+        _socket_error:
+        swow_throw_exception_with_last(swow_thread_exception_ce);
+        zval_ptr_dtor(zvalue);
+        ZVAL_UNDEF(zvalue);
+    } else {
+        ret = swow_thread_unserialize(zvalue, message->data, message->u.length);
+    }
+    swow_thread_message_free(message);
+
+    return ret;
+}
+
+/* runtime */
+
+static void swow_thread_context_join(swow_thread_context_t *context)
+{
+    /* the thread must have exited or be exiting */
+    (void) uv_thread_join(&context->tid);
+    context->joined = cat_true;
+    cat_queue_remove(&context->node);
+    swow_thread_context_release(context);
+}
+
+/* join children which have exited, return true if there is no child anymore */
+static cat_bool_t swow_thread_join_exited_children(void)
+{
+    _again:
+    CAT_QUEUE_FOREACH_DATA_START(&SWOW_THREAD_G(children), swow_thread_context_t, node, context) {
+        if (swow_thread_context_get_state(context) == SWOW_THREAD_STATE_EXITED) {
+            swow_thread_context_join(context);
+            /* children have been changed */
+            goto _again;
+        }
+    } CAT_QUEUE_FOREACH_DATA_END();
+
+    return cat_queue_empty(&SWOW_THREAD_G(children));
+}
+
+static void swow_thread_runtime_close(void);
+
+static void swow_thread_notifier_callback(uv_async_t *handle)
+{
+    swow_thread_context_t *context;
+    (void) handle;
+
+    _again_senders:
+    CAT_QUEUE_FOREACH_DATA_START(&SWOW_THREAD_G(senders), swow_thread_sender_t, local_node, sender) {
+        cat_bool_t notified;
+        if (sender->coroutine == NULL) {
+            continue;
+        }
+        uv_mutex_lock(&sender->receiver->mutex);
+        notified = sender->notified;
+        uv_mutex_unlock(&sender->receiver->mutex);
+        if (notified) {
+            cat_coroutine_t *coroutine = sender->coroutine;
+            sender->coroutine = NULL;
+            cat_coroutine_schedule(coroutine, THREAD, "Thread send");
+            /* senders may be changed */
+            goto _again_senders;
+        }
+    } CAT_QUEUE_FOREACH_DATA_END();
+
+    _again:
+    CAT_QUEUE_FOREACH_DATA_START(&SWOW_THREAD_G(children), swow_thread_context_t, node, context) {
+        if (context->waiter != NULL && swow_thread_context_get_state(context) >= context->wait_state) {
+            cat_coroutine_t *waiter = context->waiter;
+            context->waiter = NULL;
+            cat_coroutine_schedule(waiter, THREAD, "Thread");
+            /* children may be changed */
+            goto _again;
+        }
+    } CAT_QUEUE_FOREACH_DATA_END();
+
+    if (UNEXPECTED(SWOW_THREAD_G(closing)) && swow_thread_join_exited_children()) {
+        swow_thread_runtime_close();
+    }
+}
+
+
+static void swow_thread_runtime_close(void)
+{
+    swow_thread_context_t *current = SWOW_THREAD_G(current);
+
+    uv_mutex_lock(&current->mutex);
+    current->notifier = NULL;
+    uv_mutex_unlock(&current->mutex);
+    if (SWOW_THREAD_G(notifier_initialized)) {
+        uv_close((uv_handle_t *) &SWOW_THREAD_G(notifier), NULL);
+        SWOW_THREAD_G(notifier_initialized) = cat_false;
+    }
+    SWOW_THREAD_G(closing) = cat_false;
+
+    zval_ptr_dtor(&SWOW_THREAD_G(arguments));
+    ZVAL_UNDEF(&SWOW_THREAD_G(arguments));
+    SWOW_THREAD_G(current) = NULL;
+    swow_thread_context_release(current);
+}
+
+static void swow_thread_runtime_shutdown_callback(cat_data_t *data)
+{
+    swow_thread_context_t *current = SWOW_THREAD_G(current);
+    cat_thread_channel_t *mailbox;
+    (void) data;
+
+    /* close mailbox first, children which are waiting to send to us must see it */
+    uv_mutex_lock(&current->mutex);
+    mailbox = current->mailbox;
+    current->mailbox = NULL;
+    swow_thread_context_notify_senders(current);
+    uv_mutex_unlock(&current->mutex);
+    if (mailbox != NULL) {
+        cat_thread_channel_free(mailbox);
+    }
+
+    /* children must not outlive their parent runtime, but they may still be running,
+     * notifier keeps the last loop run alive until all of them exited (without blocking the loop),
+     * then the runtime is closed by the notifier callback */
+    if (!swow_thread_join_exited_children()) {
+        SWOW_THREAD_G(closing) = cat_true;
+        uv_ref((uv_handle_t *) &SWOW_THREAD_G(notifier));
+        return;
+    }
+    swow_thread_runtime_close();
+}
+
+/* get context of current thread, create mailbox for it if necessary */
+static swow_thread_context_t *swow_thread_get_current(void)
+{
+    swow_thread_context_t *current = SWOW_THREAD_G(current);
+    cat_thread_channel_t *mailbox;
+    int error;
+
+    if (EXPECTED(current != NULL && current->mailbox != NULL)) {
+        return current;
+    }
+    if (current == NULL) {
+        current = swow_thread_context_create(NULL);
+        SWOW_THREAD_G(current) = current;
+        if (UNEXPECTED(cat_event_register_runtime_shutdown_task(swow_thread_runtime_shutdown_callback, NULL) == NULL)) {
+            SWOW_THREAD_G(current) = NULL;
+            swow_thread_context_release(current);
+            swow_throw_exception_with_last(swow_thread_exception_ce);
+            return NULL;
+        }
+    }
+    if (!SWOW_THREAD_G(notifier_initialized)) {
+        error = uv_async_init(&CAT_EVENT_G(loop), &SWOW_THREAD_G(notifier), swow_thread_notifier_callback);
+        if (UNEXPECTED(error != 0)) {
+            swow_throw_exception(swow_thread_exception_ce, error, "Thread notifier init failed, reason: %s", cat_strerror(error));
+            return NULL;
+        }
+        uv_unref((uv_handle_t *) &SWOW_THREAD_G(notifier));
+        SWOW_THREAD_G(notifier_initialized) = cat_true;
+    }
+    mailbox = cat_thread_channel_create(SWOW_THREAD_MAILBOX_CAPACITY, sizeof(swow_thread_message_t *), swow_thread_message_dtor);
+    if (UNEXPECTED(mailbox == NULL)) {
+        swow_throw_exception_with_last(swow_thread_exception_ce);
+        return NULL;
+    }
+    uv_mutex_lock(&current->mutex);
+    current->mailbox = mailbox;
+    current->notifier = &SWOW_THREAD_G(notifier);
+    uv_mutex_unlock(&current->mutex);
+
+    return current;
+}
+
+/* wait for state changes of child thread, return false on timeout or cancel */
+static cat_bool_t swow_thread_context_wait(swow_thread_context_t *context, swow_thread_state_t state, cat_timeout_t timeout)
+{
+    cat_bool_t ret;
+
+    if (swow_thread_context_get_state(context) >= state) {
+        return cat_true;
+    }
+    if (UNEXPECTED(context->waiter != NULL)) {
+        cat_update_last_error(CAT_EBUSY, "Thread is being waited by coroutine#" CAT_COROUTINE_ID_FMT, context->waiter->id);
+        return cat_false;
+    }
+    context->wait_state = state;
+    context->waiter = CAT_COROUTINE_G(current);
+    if (SWOW_THREAD_G(waiters)++ == 0) {
+        uv_ref((uv_handle_t *) &SWOW_THREAD_G(notifier));
+    }
+    /* the state may be changed before we start to wait */
+    if (swow_thread_context_get_state(context) >= state) {
+        (void) uv_async_send(&SWOW_THREAD_G(notifier));
+    }
+    ret = cat_time_wait(timeout);
+    if (--SWOW_THREAD_G(waiters) == 0) {
+        uv_unref((uv_handle_t *) &SWOW_THREAD_G(notifier));
+    }
+    context->waiter = NULL;
+    if (UNEXPECTED(!ret)) {
+        cat_update_last_error_with_previous("Thread wait failed");
+        return cat_false;
+    }
+    if (UNEXPECTED(swow_thread_context_get_state(context) < state)) {
+        cat_update_last_error(CAT_ECANCELED, "Thread wait has been canceled");
+        return cat_false;
+    }
+
+    return cat_true;
+}
+
+/* thread routine */
+
+static cat_bool_t swow_thread_bootstrap(swow_thread_context_t *context)
+{
+    SWOW_THREAD_G(current) = swow_thread_context_addref(context);
+    if (UNEXPECTED(cat_event_register_runtime_shutdown_task(swow_thread_runtime_shutdown_callback, NULL) == NULL)) {
+        SWOW_THREAD_G(current) = NULL;
+        swow_thread_context_release(context);
+        return cat_false;
+    }
+    if (UNEXPECTED(swow_thread_get_current() == NULL)) {
+        return cat_false;
+    }
+    if (UNEXPECTED(!swow_thread_unserialize(&SWOW_THREAD_G(arguments), context->arguments, context->arguments_length))) {
+        return cat_false;
+    }
+    pefree(context->arguments, 1);
+    context->arguments = NULL;
+
+    return cat_true;
+}
+
+static void swow_thread_routine(void *arg)
+{
+    swow_thread_context_t *context = (swow_thread_context_t *) arg;
+    int exit_status = 255;
+
+    (void) ts_resource(0);
+#if defined(COMPILE_DL_SWOW)
+    ZEND_TSRMLS_CACHE_UPDATE();
+#endif
+
+    PG(expose_php) = 0;
+    PG(auto_globals_jit) = 1;
+    if (php_request_startup() == SUCCESS) {
+        PG(during_request_startup) = 0;
+        SG(sapi_started) = 0;
+        SG(headers_sent) = 1;
+        SG(request_info).no_headers = 1;
+        zend_first_try {
+            if (!SWOW_G(ini.enable) || !swow_thread_bootstrap(context)) {
+                if (EG(exception) != NULL) {
+                    zend_exception_error(EG(exception), E_ERROR);
+                } else {
+                    zend_error(E_WARNING, "Thread bootstrap failed");
+                }
+            } else {
+                zend_file_handle file_handle;
+                swow_thread_context_set_state(context, SWOW_THREAD_STATE_RUNNING, 0);
+                zend_stream_init_filename(&file_handle, context->file);
+                php_execute_script(&file_handle);
+#if PHP_VERSION_ID >= 80100
+                zend_destroy_file_handle(&file_handle);
+#endif
+                exit_status = EG(exit_status);
+            }
+        } zend_end_try();
+        php_request_shutdown(NULL);
+    }
+    ts_free_thread();
+
+    /* parent may join us after that */
+    swow_thread_context_set_state(context, SWOW_THREAD_STATE_EXITED, exit_status);
+    swow_thread_context_release(context);
+}
+
+/* object */
+
+static zend_object *swow_thread_create_object(zend_class_entry *ce)
+{
+    swow_thread_t *s_thread = swow_object_alloc(swow_thread_t, ce, swow_thread_handlers);
+
+    s_thread->context = NULL;
+
+    return &s_thread->std;
+}
+
+static void swow_thread_free_object(zend_object *object)
+{
+    swow_thread_t *s_thread = swow_thread_get_from_object(object);
+
+    /* child which is not joined will be joined on runtime shutdown */
+    if (s_thread->context != NULL) {
+        swow_thread_context_release(s_thread->context);
+    }
+
+    zend_object_std_dtor(&s_thread->std);
+}
+
+#define SWOW_THREAD_GETTER(s_thread, context) \
+    swow_thread_t *s_thread = swow_thread_get_from_object(Z_OBJ_P(ZEND_THIS)); \
+    swow_thread_context_t *context = s_thread->context; \
+    if (UNEXPECTED(context == NULL)) { \
+        zend_throw_error(NULL, "%s must construct first", ZEND_THIS_NAME); \
+        RETURN_THROWS(); \
+    }
+
+static void swow_thread_create_object_from_context(zval *zthread, swow_thread_context_t *context)
+{
+    swow_thread_t *s_thread;
+
+    object_init_ex(zthread, swow_thread_ce);
+    s_thread = swow_thread_get_from_object(Z_OBJ_P(zthread));
+    s_thread->context = swow_thread_context_addref(context);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Swow_Thread___construct, 0, 0, 1)
+    ZEND_ARG_TYPE_INFO(0, file, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, arguments, IS_ARRAY, 0, "[]")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Thread, __construct)
+{
+    swow_thread_t *s_thread = swow_thread_get_from_object(Z_OBJ_P(ZEND_THIS));
+    swow_thread_context_t *current, *context;
+    zend_string *file;
+    zval *zarguments = NULL;
+    zval zempty_arguments;
+    char *path;
+    int error;
+
+    if (UNEXPECTED(s_thread->context != NULL)) {
+        zend_throw_error(NULL, "%s can be constructed only once", ZEND_THIS_NAME);
+        RETURN_THROWS();
+    }
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_PATH_STR(file)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ARRAY(zarguments)
+    ZEND_PARSE_PARAMETERS_END();
+
+    current = swow_thread_get_current();
+    if (UNEXPECTED(current == NULL)) {
+        RETURN_THROWS();
+    }
+    /* working directory of the new interpreter may be different */
+    path = expand_filepath(ZSTR_VAL(file), NULL);
+    if (UNEXPECTED(path == NULL)) {
+        zend_argument_value_error(1, "must be a valid path");
+        RETURN_THROWS();
+    }
+    if (zarguments == NULL) {
+        ZVAL_EMPTY_ARRAY(&zempty_arguments);
+        zarguments = &zempty_arguments;
+    }
+
+    context = swow_thread_context_create(swow_thread_context_addref(current));
+    context->file = pestrdup(path, 1);
+    efree(path);
+    context->arguments = swow_thread_serialize(zarguments, &context->arguments_length);
+    if (UNEXPECTED(context->arguments == NULL)) {
+        swow_thread_context_release(context);
+        RETURN_THROWS();
+    }
+    /* refs: object, routine and children list */
+    s_thread->context = context;
+    (void) swow_thread_context_addref(context);
+    error = uv_thread_create(&context->tid, swow_thread_routine, context);
+    if (UNEXPECTED(error != 0)) {
+        swow_thread_context_release(context);
+        s_thread->context = NULL;
+        swow_thread_context_release(context);
+        swow_throw_exception(swow_thread_exception_ce, error, "Thread create failed, reason: %s", cat_strerror(error));
+        RETURN_THROWS();
+    }
+    cat_queue_push_back(&SWOW_THREAD_G(children), &swow_thread_context_addref(context)->node);
+
+    /* wait until it is ready to receive messages (or exited) */
+    if (UNEXPECTED(!swow_thread_context_wait(context, SWOW_THREAD_STATE_RUNNING, CAT_TIMEOUT_FOREVER))) {
+        swow_throw_exception_with_last(swow_thread_exception_ce);
+        RETURN_THROWS();
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Thread_getId, 0, 0, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Thread, getId)
+{
+    SWOW_THREAD_GETTER(s_thread, context);
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_LONG(context->id);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Thread_isRunning, 0, 0, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Thread, isRunning)
+{
+    SWOW_THREAD_GETTER(s_thread, context);
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_BOOL(swow_thread_context_get_state(context) == SWOW_THREAD_STATE_RUNNING);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Thread_join, 0, 0, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 0, "-1")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Thread, join)
+{
+    SWOW_THREAD_GETTER(s_thread, context);
+    zend_long timeout = -1;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(timeout)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(context->parent == NULL || context->parent != SWOW_THREAD_G(current))) {
+        swow_throw_exception(swow_thread_exception_ce, CAT_EMISUSE, "Thread can only be joined by its parent");
+        RETURN_THROWS();
+    }
+    if (!context->joined) {
+        if (UNEXPECTED(!swow_thread_context_wait(context, SWOW_THREAD_STATE_EXITED, timeout))) {
+            swow_throw_exception_with_last(swow_thread_exception_ce);
+            RETURN_THROWS();
+        }
+        swow_thread_context_join(context);
+    }
+
+    RETURN_LONG(context->exit_status);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Thread_send, 0, 1, IS_STATIC, 0)
+    ZEND_ARG_TYPE_INFO(0, value, IS_MIXED, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 0, "-1")
+ZEND_END_ARG_INFO()
+
+/* wait until receiver pops messages from its mailbox (or exits), return false on timeout or cancel */
+static cat_bool_t swow_thread_wait_for_receiver(swow_thread_sender_t *sender, cat_timeout_t timeout)
+{
+    cat_bool_t ret;
+
+    sender->coroutine = CAT_COROUTINE_G(current);
+    cat_queue_push_back(&SWOW_THREAD_G(senders), &sender->local_node);
+    if (SWOW_THREAD_G(waiters)++ == 0) {
+        uv_ref((uv_handle_t *) &SWOW_THREAD_G(notifier));
+    }
+    ret = cat_time_wait(timeout);
+    if (--SWOW_THREAD_G(waiters) == 0) {
+        uv_unref((uv_handle_t *) &SWOW_THREAD_G(notifier));
+    }
+    cat_queue_remove(&sender->local_node);
+    sender->coroutine = NULL;
+    uv_mutex_lock(&sender->receiver->mutex);
+    if (!sender->notified) {
+        cat_queue_remove(&sender->node);
+    }
+    uv_mutex_unlock(&sender->receiver->mutex);
+    if (UNEXPECTED(!ret)) {
+        cat_update_last_error_with_previous("Thread send wait failed");
+    }
+
+    return ret;
+}
+
+static PHP_METHOD(Swow_Thread, send)
+{
+    SWOW_THREAD_GETTER(s_thread, context);
+    swow_thread_sender_t sender;
+    swow_thread_message_t *message;
+    zval *zvalue;
+    zend_long timeout = -1;
+    cat_msec_t deadline;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ZVAL(zvalue)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(timeout)
+    ZEND_PARSE_PARAMETERS_END();
+
+    message = swow_thread_message_create(zvalue);
+    if (UNEXPECTED(message == NULL)) {
+        RETURN_THROWS();
+    }
+    sender.receiver = context;
+    sender.notifier = NULL;
+    deadline = timeout < 0 ? 0 : cat_time_msec() + timeout;
+    while (1) {
+        cat_bool_t pushed = cat_false, available = cat_false;
+        cat_timeout_t wait_timeout = -1;
+        uv_mutex_lock(&context->mutex);
+        if (context->mailbox != NULL) {
+            pushed = cat_thread_channel_push(context->mailbox, &message);
+            available = pushed || cat_thread_channel_is_available(context->mailbox);
+            /* mailbox is full, receiver will wake us up after it pops messages,
+             * we are registered in the same critical section, so that no wake-up would be missed */
+            if (!pushed && available && sender.notifier != NULL) {
+                sender.notified = cat_false;
+                cat_queue_push_back(&context->senders, &sender.node);
+            }
+        }
+        uv_mutex_unlock(&context->mutex);
+        if (EXPECTED(pushed)) {
+            break;
+        }
+        if (UNEXPECTED(!available)) {
+            swow_thread_message_free(message);
+            swow_throw_exception(swow_thread_exception_ce, CAT_ECLOSED, "Thread is not running");
+            RETURN_THROWS();
+        }
+        if (sender.notifier == NULL) {
+            /* we need a notifier of current thread to be woken up, then retry immediately */
+            if (UNEXPECTED(swow_thread_get_current() == NULL)) {
+                swow_thread_message_free(message);
+                RETURN_THROWS();
+            }
+            sender.notifier = &SWOW_THREAD_G(notifier);
+            continue;
+        }
+        if (timeout >= 0) {
+            cat_msec_t now = cat_time_msec();
+            wait_timeout = now < deadline ? (cat_timeout_t) (deadline - now) : 0;
+        }
+        if (UNEXPECTED(!swow_thread_wait_for_receiver(&sender, wait_timeout))) {
+            swow_thread_message_free(message);
+            if (cat_get_last_error_code() == CAT_ETIMEDOUT) {
+                swow_throw_exception(swow_thread_exception_ce, CAT_ETIMEDOUT, "Thread mailbox is full");
+            } else {
+                swow_throw_exception_with_last(swow_thread_exception_ce);
+            }
+            RETURN_THROWS();
+        }
+    }
+
+    RETURN_THIS();
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Thread_receive, 0, 0, IS_MIXED, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 0, "-1")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Thread, receive)
+{
+    swow_thread_context_t *current;
+    swow_thread_message_t *message;
+    zend_long timeout = -1;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(timeout)
+    ZEND_PARSE_PARAMETERS_END();
+
+    current = swow_thread_get_current();
+    if (UNEXPECTED(current == NULL)) {
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(!cat_thread_channel_pop(current->mailbox, &message, timeout))) {
+        swow_throw_exception_with_last(swow_thread_exception_ce);
+        RETURN_THROWS();
+    }
+    /* there is space in mailbox now */
+    uv_mutex_lock(&current->mutex);
+    swow_thread_context_notify_senders(current);
+    uv_mutex_unlock(&current->mutex);
+    if (UNEXPECTED(!swow_thread_message_get_value(message, return_value))) {
+        RETURN_THROWS();
+    }
+}
 
-CAT_GLOBALS_CTOR_DECLARE_SZ(swow_thread)
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Thread_getParent, 0, 0, Swow\\Thread, 1)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Thread, getParent)
+{
+    swow_thread_context_t *current = SWOW_THREAD_G(current);
+
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    if (current == NULL || current->parent == NULL) {
+        RETURN_NULL();
+    }
+    swow_thread_create_object_from_context(return_value, current->parent);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Thread_getArguments, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Thread, getArguments)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    if (Z_TYPE(SWOW_THREAD_G(arguments)) != IS_ARRAY) {
+        RETURN_EMPTY_ARRAY();
+    }
+    RETURN_COPY(&SWOW_THREAD_G(arguments));
+}
+
+static const zend_function_entry swow_thread_methods[] = {
+    PHP_ME(Swow_Thread, __construct,  arginfo_class_Swow_Thread___construct,  ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Thread, getId,        arginfo_class_Swow_Thread_getId,        ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Thread, isRunning,    arginfo_class_Swow_Thread_isRunning,    ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Thread, join,         arginfo_class_Swow_Thread_join,         ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Thread, send,         arginfo_class_Swow_Thread_send,         ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Thread, receive,      arginfo_class_Swow_Thread_receive,      ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Thread, getParent,    arginfo_class_Swow_Thread_getParent,    ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_Thread, getArguments, arginfo_class_Swow_Thread_getArguments, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_FE_END
+};
+#endif /* SWOW_THREAD */
 
 zend_result swow_thread_module_init(INIT_FUNC_ARGS)
 {
-    
+#ifdef SWOW_THREAD
+    CAT_GLOBALS_REGISTER(swow_thread);
+
+    cat_atomic_uint32_init(&swow_thread_last_id, 0);
+
+    swow_thread_ce = swow_register_internal_class(
+        "Swow\\Thread", NULL, swow_thread_methods,
+        &swow_thread_handlers, NULL,
+        cat_false, cat_false,
+        swow_thread_create_object,
+        swow_thread_free_object,
+        XtOffsetOf(swow_thread_t, std)
+    );
+
+    swow_thread_exception_ce = swow_register_internal_class(
+        "Swow\\ThreadException", swow_exception_ce, NULL, NULL, NULL, cat_true, cat_true, NULL, NULL, 0
+    );
+#endif
+
+    return SUCCESS;
+}
+
+zend_result swow_thread_module_shutdown(INIT_FUNC_ARGS)
+{
+#ifdef SWOW_THREAD
+    CAT_GLOBALS_UNREGISTER(swow_thread);
+#endif
+
+    return SUCCESS;
+}
+
+zend_result swow_thread_runtime_init(INIT_FUNC_ARGS)
+{
+#ifdef SWOW_THREAD
+    /* TSRM does not zero globals for new threads */
+    SWOW_THREAD_G(current) = NULL;
+    ZVAL_UNDEF(&SWOW_THREAD_G(arguments));
+    cat_queue_init(&SWOW_THREAD_G(children));
+    cat_queue_init(&SWOW_THREAD_G(senders));
+    SWOW_THREAD_G(notifier_initialized) = cat_false;
+    SWOW_THREAD_G(waiters) = 0;
+    SWOW_THREAD_G(closing) = cat_false;
+#endif
+
     return SUCCESS;
 }
@@ -41,8 +41,8 @@ SWOW_API void swow_watchdog_alert_standard(cat_watchdog_t *watchdog)
         vm_interrupted == 0 /* interrupt maybe failed */
     ) {
         if (
-            watchdog->threshold > 0 && /* blocking time is greater than syscall threshold */
-            ((cat_timeout_t) (watchdog->quantum * watchdog->alert_count)) > watchdog->threshold
+            watchdog->effective_threshold > 0 && /* blocking time is greater than syscall threshold */
+            watchdog->blocking_time > watchdog->effective_threshold
         ) {
             /* Syscall blocking
              * CPU starvation is also possible,
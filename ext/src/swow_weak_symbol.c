@@ -721,6 +721,68 @@ char * swow_PQgetvalue_redirect(const void *res, int tup_num, int field_num) {
     return swow_PQgetvalue_resolved(res, tup_num, field_num);
 }
 
+// weak function pointer for PQinstanceData
+#ifdef CAT_OS_WIN
+// extern void * PQinstanceData(const void *conn, void *proc);
+# pragma comment(linker, "/alternatename:PQinstanceData=swow_PQinstanceData_redirect")
+#else
+__attribute__((weak, alias("swow_PQinstanceData_redirect"))) extern void * PQinstanceData(const void *conn, void *proc);
+#endif
+// resolved function holder
+void * (*swow_PQinstanceData_resolved)(const void *conn, void *proc);
+// resolver for PQinstanceData
+void * swow_PQinstanceData_resolver(const void *conn, void *proc) {
+    swow_PQinstanceData_resolved = (void * (*)(const void *conn, void *proc))DL_FETCH_SYMBOL(DL_FROM_HANDLE, "PQinstanceData");
+
+    if (swow_PQinstanceData_resolved == NULL) {
+#if defined(DL_ERROR)
+        fprintf(stderr, "failed resolve PQinstanceData: %s\n", DL_ERROR());
+#elif defined(CAT_OS_WIN)
+        fprintf(stderr, "failed resolve PQinstanceData: %08x\n", (unsigned int)GetLastError());
+#else
+        fprintf(stderr, "failed resolve PQinstanceData\n",());
+#endif
+        abort();
+    }
+
+    return swow_PQinstanceData_resolved(conn, proc);
+}
+void * (*swow_PQinstanceData_resolved)(const void *conn, void *proc) = swow_PQinstanceData_resolver;
+void * swow_PQinstanceData_redirect(const void *conn, void *proc) {
+    return swow_PQinstanceData_resolved(conn, proc);
+}
+
+// weak function pointer for PQisBusy
+#ifdef CAT_OS_WIN
+// extern int PQisBusy(void *conn);
+# pragma comment(linker, "/alternatename:PQisBusy=swow_PQisBusy_redirect")
+#else
+__attribute__((weak, alias("swow_PQisBusy_redirect"))) extern int PQisBusy(void *conn);
+#endif
+// resolved function holder
+int (*swow_PQisBusy_resolved)(void *conn);
+// resolver for PQisBusy
+int swow_PQisBusy_resolver(void *conn) {
+    swow_PQisBusy_resolved = (int (*)(void *conn))DL_FETCH_SYMBOL(DL_FROM_HANDLE, "PQisBusy");
+
+    if (swow_PQisBusy_resolved == NULL) {
+#if defined(DL_ERROR)
+        fprintf(stderr, "failed resolve PQisBusy: %s\n", DL_ERROR());
+#elif defined(CAT_OS_WIN)
+        fprintf(stderr, "failed resolve PQisBusy: %08x\n", (unsigned int)GetLastError());
+#else
+        fprintf(stderr, "failed resolve PQisBusy\n",());
+#endif
+        abort();
+    }
+
+    return swow_PQisBusy_resolved(conn);
+}
+int (*swow_PQisBusy_resolved)(void *conn) = swow_PQisBusy_resolver;
+int swow_PQisBusy_redirect(void *conn) {
+    return swow_PQisBusy_resolved(conn);
+}
+
 // weak function pointer for PQlibVersion
 #ifdef CAT_OS_WIN
 // extern int PQlibVersion(void);
@@ -1000,6 +1062,37 @@ int swow_PQputCopyEnd_redirect(void *conn, const char *errormsg) {
     return swow_PQputCopyEnd_resolved(conn, errormsg);
 }
 
+// weak function pointer for PQregisterEventProc
+#ifdef CAT_OS_WIN
+// extern int PQregisterEventProc(void *conn, void *proc, const char *name, void *passThrough);
+# pragma comment(linker, "/alternatename:PQregisterEventProc=swow_PQregisterEventProc_redirect")
+#else
+__attribute__((weak, alias("swow_PQregisterEventProc_redirect"))) extern int PQregisterEventProc(void *conn, void *proc, const char *name, void *passThrough);
+#endif
+// resolved function holder
+int (*swow_PQregisterEventProc_resolved)(void *conn, void *proc, const char *name, void *passThrough);
+// resolver for PQregisterEventProc
+int swow_PQregisterEventProc_resolver(void *conn, void *proc, const char *name, void *passThrough) {
+    swow_PQregisterEventProc_resolved = (int (*)(void *conn, void *proc, const char *name, void *passThrough))DL_FETCH_SYMBOL(DL_FROM_HANDLE, "PQregisterEventProc");
+
+    if (swow_PQregisterEventProc_resolved == NULL) {
+#if defined(DL_ERROR)
+        fprintf(stderr, "failed resolve PQregisterEventProc: %s\n", DL_ERROR());
+#elif defined(CAT_OS_WIN)
+        fprintf(stderr, "failed resolve PQregisterEventProc: %08x\n", (unsigned int)GetLastError());
+#else
+        fprintf(stderr, "failed resolve PQregisterEventProc\n",());
+#endif
+        abort();
+    }
+
+    return swow_PQregisterEventProc_resolved(conn, proc, name, passThrough);
+}
+int (*swow_PQregisterEventProc_resolved)(void *conn, void *proc, const char *name, void *passThrough) = swow_PQregisterEventProc_resolver;
+int swow_PQregisterEventProc_redirect(void *conn, void *proc, const char *name, void *passThrough) {
+    return swow_PQregisterEventProc_resolved(conn, proc, name, passThrough);
+}
+
 // weak function pointer for PQreset
 #ifdef CAT_OS_WIN
 // extern void PQreset(void *conn);
@@ -1248,6 +1341,37 @@ int swow_PQsendQueryPrepared_redirect(void *conn, const char *stmtName, int nPar
     return swow_PQsendQueryPrepared_resolved(conn, stmtName, nParams, paramValues, paramLengths, paramFormats, resultFormat);
 }
 
+// weak function pointer for PQsetInstanceData
+#ifdef CAT_OS_WIN
+// extern int PQsetInstanceData(void *conn, void *proc, void *data);
+# pragma comment(linker, "/alternatename:PQsetInstanceData=swow_PQsetInstanceData_redirect")
+#else
+__attribute__((weak, alias("swow_PQsetInstanceData_redirect"))) extern int PQsetInstanceData(void *conn, void *proc, void *data);
+#endif
+// resolved function holder
+int (*swow_PQsetInstanceData_resolved)(void *conn, void *proc, void *data);
+// resolver for PQsetInstanceData
+int swow_PQsetInstanceData_resolver(void *conn, void *proc, void *data) {
+    swow_PQsetInstanceData_resolved = (int (*)(void *conn, void *proc, void *data))DL_FETCH_SYMBOL(DL_FROM_HANDLE, "PQsetInstanceData");
+
+    if (swow_PQsetInstanceData_resolved == NULL) {
+#if defined(DL_ERROR)
+        fprintf(stderr, "failed resolve PQsetInstanceData: %s\n", DL_ERROR());
+#elif defined(CAT_OS_WIN)
+        fprintf(stderr, "failed resolve PQsetInstanceData: %08x\n", (unsigned int)GetLastError());
+#else
+        fprintf(stderr, "failed resolve PQsetInstanceData\n",());
+#endif
+        abort();
+    }
+
+    return swow_PQsetInstanceData_resolved(conn, proc, data);
+}
+int (*swow_PQsetInstanceData_resolved)(void *conn, void *proc, void *data) = swow_PQsetInstanceData_resolver;
+int swow_PQsetInstanceData_redirect(void *conn, void *proc, void *data) {
+    return swow_PQsetInstanceData_resolved(conn, proc, data);
+}
+
 // weak function pointer for PQsetnonblocking
 #ifdef CAT_OS_WIN
 // extern int PQsetnonblocking(void *conn, int arg);
@@ -142,6 +142,8 @@ int  PQgetisnull(const void *res, int tup_num, int field_num);
 int  PQgetlength(const void *res, int tup_num, int field_num);
 void *PQgetResult(void *conn);
 char *PQgetvalue(const void *res, int tup_num, int field_num);
+void *PQinstanceData(const void *conn, void *proc);
+int  PQisBusy(void *conn);
 int  PQlibVersion(void);
 int  PQnfields(const void *res);
 int  PQntuples(const void *res);
@@ -151,6 +153,7 @@ const char *PQparameterStatus(const void *conn, const char *paramName);
 int  PQprotocolVersion(const void *conn);
 int  PQputCopyData(void *conn, const char *buffer, int nbytes);
 int  PQputCopyEnd(void *conn, const char *errormsg);
+int  PQregisterEventProc(void *conn, void *proc, const char *name, void *passThrough);
 void PQreset(void *conn);
 int  PQresetStart(void *conn);
 char *PQresultErrorField(const void *res, int fieldcode);
@@ -159,6 +162,7 @@ int  PQsendPrepare(void *conn, const char *stmtName, const char *query, int nPar
 int  PQsendQuery(void *conn, const char *query);
 int  PQsendQueryParams(void *conn, const char *command, int nParams,  const unsigned int *paramTypes, const char *const *paramValues, const int *paramLengths, const int *paramFormats, int resultFormat);
 int  PQsendQueryPrepared(void *conn, const char *stmtName, int nParams, const char *const *paramValues, const int *paramLengths, const int *paramFormats, int resultFormat);
+int  PQsetInstanceData(void *conn, void *proc, void *data);
 int  PQsetnonblocking(void *conn, int arg);
 void *PQsetNoticeProcessor(void *conn, void *proc, void *arg);
 int  PQsocket(const void *conn);
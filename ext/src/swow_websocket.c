@@ -509,7 +509,7 @@ static PHP_METHOD(Swow_WebSocket_WebSocket, mask)
     SWOW_WEBSOCKET_HEADER_MASKING_KEY_CHECK(masking_key, 4);
 
     if (UNEXPECTED(masking_key == NULL ||
-        memcmp(masking_key, CAT_STRS(CAT_WEBSOCKET_EMPTY_MASKING_KEY)) == 0)) {
+        memcmp(ZSTR_VAL(masking_key), CAT_STRL(CAT_WEBSOCKET_EMPTY_MASKING_KEY)) == 0)) {
         RETURN_STR_COPY(data);
     }
     ptr = swow_string_get_readable_space(data, start, &length, 1);
@@ -523,12 +523,30 @@ static PHP_METHOD(Swow_WebSocket_WebSocket, mask)
     RETURN_STR(masked_data);
 }
 
+/* validate UTF-8 while unmasking if utf8State is passed, it can be carried across fragments */
+#define SWOW_WEBSOCKET_UTF8_STATE_INIT(z_utf8_state, utf8_state, arg_num) do { \
+    if (z_utf8_state != NULL) { \
+        zval *z_tmp = z_utf8_state; \
+        ZVAL_DEREF(z_tmp); \
+        if (Z_TYPE_P(z_tmp) == IS_LONG) { \
+            zend_long _utf8_state = Z_LVAL_P(z_tmp); \
+            /* it is used as the index of DFA table */ \
+            if (UNEXPECTED(_utf8_state < 0 || !CAT_WEBSOCKET_UTF8_STATE_IS_VALID((cat_websocket_utf8_state_t) _utf8_state))) { \
+                zend_argument_value_error(arg_num, "is not a valid UTF-8 state"); \
+                RETURN_THROWS(); \
+            } \
+            utf8_state = (cat_websocket_utf8_state_t) _utf8_state; \
+        } \
+    } \
+} while (0)
+
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_WebSocket_WebSocket_unmask, 0, 1, IS_VOID, 0)
     ZEND_ARG_OBJ_INFO(0, data, Swow\\Buffer, 0)
     ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, start, IS_LONG, 0, "0")
     ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 0, "-1")
     ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maskingKey, IS_STRING, 0, "\'\'")
     ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, index, IS_LONG, 0, "0")
+    ZEND_ARG_INFO_WITH_DEFAULT_VALUE(1, utf8State, "null")
 ZEND_END_ARG_INFO()
 
 static PHP_METHOD(Swow_WebSocket_WebSocket, unmask)
@@ -539,28 +557,162 @@ static PHP_METHOD(Swow_WebSocket_WebSocket, unmask)
     zend_long start = 0;
     zend_long length = -1;
     zend_long index = 0;
+    zval *z_utf8_state = NULL;
+    cat_websocket_utf8_state_t utf8_state = CAT_WEBSOCKET_UTF8_ACCEPT;
     char *ptr;
 
-    ZEND_PARSE_PARAMETERS_START(1, 5)
+    ZEND_PARSE_PARAMETERS_START(1, 6)
         Z_PARAM_OBJ_OF_CLASS(buffer_object, swow_buffer_ce)
         Z_PARAM_OPTIONAL
         Z_PARAM_LONG(start)
         Z_PARAM_LONG(length)
         Z_PARAM_STR(masking_key)
         Z_PARAM_LONG(index)
+        Z_PARAM_ZVAL(z_utf8_state)
     ZEND_PARSE_PARAMETERS_END();
 
     SWOW_WEBSOCKET_HEADER_MASKING_KEY_CHECK(masking_key, 4);
+    SWOW_WEBSOCKET_UTF8_STATE_INIT(z_utf8_state, utf8_state, 6);
 
     data = swow_buffer_get_from_object(buffer_object);
+    SWOW_BUFFER_CHECK_LOCK(data);
+    swow_buffer_cow(data);
     ptr = (char *) swow_buffer_get_readable_space(data, start, &length, 1);
+    if (UNEXPECTED(ptr == NULL)) {
+        RETURN_THROWS();
+    }
+
+    (void) cat_websocket_unmask_to(ptr, ptr, length, masking_key != NULL ? ZSTR_VAL(masking_key) : NULL, index, z_utf8_state != NULL ? &utf8_state : NULL);
+
+    if (z_utf8_state != NULL) {
+        ZEND_TRY_ASSIGN_REF_LONG(z_utf8_state, utf8_state);
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_WebSocket_WebSocket_unmaskTo, 0, 2, IS_LONG, 0)
+    ZEND_ARG_OBJ_INFO(0, buffer, Swow\\Buffer, 0)
+    ZEND_ARG_OBJ_TYPE_MASK(0, data, Stringable, MAY_BE_STRING, NULL)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, start, IS_LONG, 0, "0")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 0, "-1")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maskingKey, IS_STRING, 0, "\'\'")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, index, IS_LONG, 0, "0")
+    ZEND_ARG_INFO_WITH_DEFAULT_VALUE(1, utf8State, "null")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_WebSocket_WebSocket, unmaskTo)
+{
+    zend_object *buffer_object;
+    zend_string *masking_key = NULL, *data;
+    swow_buffer_t *s_buffer;
+    cat_buffer_t *buffer;
+    zend_long start = 0;
+    zend_long length = -1;
+    zend_long index = 0;
+    zval *z_utf8_state = NULL;
+    cat_websocket_utf8_state_t utf8_state = CAT_WEBSOCKET_UTF8_ACCEPT;
+    size_t offset;
+    const char *ptr;
+
+    ZEND_PARSE_PARAMETERS_START(2, 7)
+        Z_PARAM_OBJ_OF_CLASS(buffer_object, swow_buffer_ce)
+        SWOW_PARAM_STRINGABLE_EXPECT_BUFFER_FOR_READING(data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(start)
+        Z_PARAM_LONG(length)
+        Z_PARAM_STR(masking_key)
+        Z_PARAM_LONG(index)
+        Z_PARAM_ZVAL(z_utf8_state)
+    ZEND_PARSE_PARAMETERS_END();
+
+    SWOW_WEBSOCKET_HEADER_MASKING_KEY_CHECK(masking_key, 5);
+    SWOW_WEBSOCKET_UTF8_STATE_INIT(z_utf8_state, utf8_state, 7);
+
+    ptr = swow_string_get_readable_space(data, start, &length, 2);
+    if (UNEXPECTED(ptr == NULL)) {
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(length == 0)) {
+        RETURN_LONG(0);
+    }
+
+    s_buffer = swow_buffer_get_from_object(buffer_object);
+    buffer = &s_buffer->buffer;
+    SWOW_BUFFER_CHECK_LOCK(s_buffer);
+    /* data string is held by args, so it is still readable even if buffer is separated or extended */
+    swow_buffer_cow(s_buffer);
+    if (UNEXPECTED(!cat_buffer_prepare(buffer, length))) {
+        swow_throw_exception_with_last(swow_buffer_exception_ce);
+        RETURN_THROWS();
+    }
+    offset = buffer->length;
+
+    /* unmask while copying, so that data is only traversed once */
+    (void) cat_websocket_unmask_to(ptr, buffer->value + offset, length, masking_key != NULL ? ZSTR_VAL(masking_key) : NULL, index, z_utf8_state != NULL ? &utf8_state : NULL);
+    swow_buffer_virtual_write(s_buffer, offset, length);
+
+    if (z_utf8_state != NULL) {
+        ZEND_TRY_ASSIGN_REF_LONG(z_utf8_state, utf8_state);
+    }
+
+    RETURN_LONG(length);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_WebSocket_WebSocket_getMaskImplementation, 0, 0, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_WebSocket_WebSocket, getMaskImplementation)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    RETURN_STRING(cat_websocket_mask_get_implementation());
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_WebSocket_WebSocket_setMaskImplementation, 0, 1, _IS_BOOL, 0)
+    ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_WebSocket_WebSocket, setMaskImplementation)
+{
+    zend_string *name;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_STR(name)
+    ZEND_PARSE_PARAMETERS_END();
+
+    RETURN_BOOL(cat_websocket_mask_set_implementation(ZSTR_VAL(name)));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_WebSocket_WebSocket_negotiateDeflate, 0, 1, IS_STRING, 1)
+    ZEND_ARG_TYPE_INFO(0, offer, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_WebSocket_WebSocket, negotiateDeflate)
+{
+    zend_string *offer;
+    cat_websocket_deflate_options_t options;
+    cat_buffer_t response;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_STR(offer)
+    ZEND_PARSE_PARAMETERS_END();
+
+    cat_buffer_init(&response);
+    if (!cat_websocket_deflate_options_negotiate(&options, ZSTR_VAL(offer), ZSTR_LEN(offer), &response)) {
+        cat_buffer_close(&response);
+        RETURN_NULL();
+    }
 
-    cat_websocket_unmask_ex(ptr, length, masking_key != NULL ? ZSTR_VAL(masking_key) : NULL, index);
+    RETVAL_STRINGL(response.value, response.length);
+    cat_buffer_close(&response);
 }
 
 static const zend_function_entry swow_websocket_websocket_methods[] = {
-    PHP_ME(Swow_WebSocket_WebSocket, mask,   arginfo_class_Swow_WebSocket_WebSocket_mask,   ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
-    PHP_ME(Swow_WebSocket_WebSocket, unmask, arginfo_class_Swow_WebSocket_WebSocket_unmask, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_WebSocket_WebSocket, mask,                  arginfo_class_Swow_WebSocket_WebSocket_mask,                  ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_WebSocket_WebSocket, unmask,                arginfo_class_Swow_WebSocket_WebSocket_unmask,                ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_WebSocket_WebSocket, unmaskTo,              arginfo_class_Swow_WebSocket_WebSocket_unmaskTo,              ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_WebSocket_WebSocket, getMaskImplementation, arginfo_class_Swow_WebSocket_WebSocket_getMaskImplementation, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_WebSocket_WebSocket, setMaskImplementation, arginfo_class_Swow_WebSocket_WebSocket_setMaskImplementation, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Swow_WebSocket_WebSocket, negotiateDeflate,      arginfo_class_Swow_WebSocket_WebSocket_negotiateDeflate,      ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_FE_END
 };
 
@@ -593,6 +745,14 @@ zend_result swow_websocket_module_init(INIT_FUNC_ARGS)
     SWOW_WEBSOCKET_REGISTER_LONG_CONSTANT(MASKING_KEY_LENGTH);
     SWOW_WEBSOCKET_REGISTER_STRING_CONSTANT(EMPTY_MASKING_KEY);
     SWOW_WEBSOCKET_REGISTER_STRING_CONSTANT(DEFAULT_MASKING_KEY);
+    SWOW_WEBSOCKET_REGISTER_LONG_CONSTANT(UTF8_ACCEPT);
+    SWOW_WEBSOCKET_REGISTER_LONG_CONSTANT(UTF8_REJECT);
+    SWOW_WEBSOCKET_REGISTER_STRING_CONSTANT(DEFLATE_EXTENSION_NAME);
+    SWOW_WEBSOCKET_REGISTER_STRING_CONSTANT(DEFLATE_DEFAULT_OFFER);
+    SWOW_WEBSOCKET_REGISTER_LONG_CONSTANT(DEFAULT_MAX_MESSAGE_LENGTH);
+#define SWOW_WEBSOCKET_CODEC_FLAG_GEN(name, value) SWOW_WEBSOCKET_REGISTER_LONG_CONSTANT(CODEC_FLAG_##name);
+    CAT_WEBSOCKET_CODEC_FLAG_MAP(SWOW_WEBSOCKET_CODEC_FLAG_GEN)
+#undef SWOW_WEBSOCKET_CODEC_FLAG_GEN
 
     do {
         cat_websocket_header_t header;
@@ -0,0 +1,507 @@
+/*
+  +--------------------------------------------------------------------------+
+  | Swow                                                                     |
+  +--------------------------------------------------------------------------+
+  | Licensed under the Apache License, Version 2.0 (the "License");          |
+  | you may not use this file except in compliance with the License.         |
+  | You may obtain a copy of the License at                                  |
+  | http://www.apache.org/licenses/LICENSE-2.0                               |
+  | Unless required by applicable law or agreed to in writing, software      |
+  | distributed under the License is distributed on an "AS IS" BASIS,        |
+  | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+  | See the License for the specific language governing permissions and      |
+  | limitations under the License. See accompanying LICENSE file.            |
+  +--------------------------------------------------------------------------+
+  | Author: Twosee <twosee@php.net>                                          |
+  +--------------------------------------------------------------------------+
+ */
+
+#include "swow_work.h"
+
+#ifdef CAT_HAVE_OPENSSL
+#include "cat_ssl.h"
+#endif
+
+SWOW_API zend_class_entry *swow_work_ce;
+
+SWOW_API zend_class_entry *swow_work_exception_ce;
+
+static zend_always_inline cat_bool_t swow_work_check_kind(zend_long kind, uint32_t arg_num)
+{
+    if (UNEXPECTED(kind < 0 || kind >= CAT_WORK_KIND_COUNT)) {
+        zend_argument_value_error(arg_num, "must be one of Swow\\Work::KIND_*");
+        return cat_false;
+    }
+    return cat_true;
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Work_getPoolSize, 0, 1, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO(0, kind, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Work, getPoolSize)
+{
+    zend_long kind;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(kind)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(!swow_work_check_kind(kind, 1))) {
+        RETURN_THROWS();
+    }
+
+    RETURN_LONG(cat_work_pool_get_size((cat_work_kind_t) kind));
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Work_setPoolSize, 0, 2, IS_VOID, 0)
+    ZEND_ARG_TYPE_INFO(0, kind, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO(0, size, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Work, setPoolSize)
+{
+    zend_long kind;
+    zend_long size;
+
+    ZEND_PARSE_PARAMETERS_START(2, 2)
+        Z_PARAM_LONG(kind)
+        Z_PARAM_LONG(size)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(!swow_work_check_kind(kind, 1))) {
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(size < 1 || size > CAT_WORK_POOL_MAX_SIZE)) {
+        zend_argument_value_error(2, "must be between 1 and %u", CAT_WORK_POOL_MAX_SIZE);
+        RETURN_THROWS();
+    }
+
+    if (UNEXPECTED(!cat_work_pool_set_size((cat_work_kind_t) kind, (unsigned int) size))) {
+        swow_throw_exception_with_last(swow_work_exception_ce);
+        RETURN_THROWS();
+    }
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Work_getPoolStats, 0, 1, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO(0, kind, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Work, getPoolStats)
+{
+    zend_long kind;
+    cat_work_pool_stats_t stats;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(kind)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (UNEXPECTED(!swow_work_check_kind(kind, 1))) {
+        RETURN_THROWS();
+    }
+
+    if (UNEXPECTED(!cat_work_pool_get_stats((cat_work_kind_t) kind, &stats))) {
+        swow_throw_exception_with_last(swow_work_exception_ce);
+        RETURN_THROWS();
+    }
+
+    array_init(return_value);
+    add_assoc_long(return_value, "size", stats.size);
+    add_assoc_long(return_value, "threads", stats.threads);
+    add_assoc_long(return_value, "running", stats.running);
+    add_assoc_long(return_value, "queued", stats.queued);
+    add_assoc_long(return_value, "max_queued", stats.max_queued);
+    add_assoc_long(return_value, "submitted", stats.submitted);
+    add_assoc_long(return_value, "completed", stats.completed);
+    add_assoc_long(return_value, "canceled", stats.canceled);
+    /* in nanoseconds */
+    add_assoc_long(return_value, "wait_time", stats.wait_time);
+    add_assoc_long(return_value, "max_wait_time", stats.max_wait_time);
+    add_assoc_long(return_value, "run_time", stats.run_time);
+    add_assoc_long(return_value, "max_run_time", stats.max_run_time);
+}
+
+#ifdef CAT_HAVE_OPENSSL
+/* OpenSSL digests are thread-safe and do not touch the Zend allocator,
+ * so strings are prepared on the loop thread and only filled by workers */
+
+#define SWOW_WORK_DIGEST_STACK_SIZE 16
+
+typedef struct swow_work_digest_batch_s swow_work_digest_batch_t;
+
+typedef struct swow_work_digest_item_s {
+    swow_work_digest_batch_t *batch;
+    zend_string *input;
+    /* binary result is written to the tail of it, then converted to hex in-place */
+    zend_string *output;
+    size_t raw_length;
+    cat_bool_t failed;
+} swow_work_digest_item_t;
+
+struct swow_work_digest_batch_s {
+    /* items in flight + the caller */
+    uint32_t refcount;
+    const EVP_MD *md;
+    cat_bool_t binary;
+    /* for pbkdf2 */
+    zend_string *salt;
+    int iterations;
+    swow_work_digest_item_t items[1];
+};
+
+static swow_work_digest_batch_t *swow_work_digest_batch_create(const EVP_MD *md, cat_bool_t binary, uint32_t count)
+{
+    swow_work_digest_batch_t *batch;
+
+    batch = (swow_work_digest_batch_t *) emalloc(offsetof(swow_work_digest_batch_t, items) + sizeof(batch->items[0]) * count);
+    batch->refcount = count + 1;
+    batch->md = md;
+    batch->binary = binary;
+    batch->salt = NULL;
+    batch->iterations = 0;
+
+    return batch;
+}
+
+static void swow_work_digest_batch_release(swow_work_digest_batch_t *batch)
+{
+    if (--batch->refcount == 0) {
+        if (batch->salt != NULL) {
+            zend_string_release(batch->salt);
+        }
+        efree(batch);
+    }
+}
+
+static void swow_work_digest_item_init(swow_work_digest_item_t *item, swow_work_digest_batch_t *batch, zend_string *input, size_t raw_length)
+{
+    item->batch = batch;
+    item->input = zend_string_copy(input);
+    item->output = zend_string_alloc(batch->binary ? raw_length : raw_length * 2, 0);
+    item->raw_length = raw_length;
+    item->failed = cat_false;
+}
+
+static void swow_work_digest_item_to_hex(swow_work_digest_item_t *item)
+{
+    static const char hexits[] = "0123456789abcdef";
+    unsigned char *raw;
+    char *hex;
+    size_t n;
+
+    if (item->batch->binary) {
+        return;
+    }
+    hex = ZSTR_VAL(item->output);
+    raw = (unsigned char *) hex + item->raw_length;
+    /* the raw byte is always read before it is overwritten */
+    for (n = 0; n < item->raw_length; n++) {
+        unsigned char c = raw[n];
+        hex[n * 2] = hexits[c >> 4];
+        hex[n * 2 + 1] = hexits[c & 15];
+    }
+}
+
+static unsigned char *swow_work_digest_item_get_raw(swow_work_digest_item_t *item)
+{
+    unsigned char *raw = (unsigned char *) ZSTR_VAL(item->output);
+
+    if (!item->batch->binary) {
+        raw += item->raw_length;
+    }
+    return raw;
+}
+
+static void swow_work_hash_function(cat_data_t *data)
+{
+    swow_work_digest_item_t *item = (swow_work_digest_item_t *) data;
+
+    if (UNEXPECTED(!EVP_Digest(
+        ZSTR_VAL(item->input), ZSTR_LEN(item->input),
+        swow_work_digest_item_get_raw(item), NULL,
+        item->batch->md, NULL
+    ))) {
+        item->failed = cat_true;
+        return;
+    }
+    swow_work_digest_item_to_hex(item);
+}
+
+static void swow_work_pbkdf2_function(cat_data_t *data)
+{
+    swow_work_digest_item_t *item = (swow_work_digest_item_t *) data;
+    swow_work_digest_batch_t *batch = item->batch;
+
+    if (UNEXPECTED(!PKCS5_PBKDF2_HMAC(
+        ZSTR_VAL(item->input), (int) ZSTR_LEN(item->input),
+        (const unsigned char *) ZSTR_VAL(batch->salt), (int) ZSTR_LEN(batch->salt),
+        batch->iterations, batch->md,
+        (int) item->raw_length, swow_work_digest_item_get_raw(item)
+    ))) {
+        item->failed = cat_true;
+        return;
+    }
+    swow_work_digest_item_to_hex(item);
+}
+
+static void swow_work_digest_cleanup(cat_data_t *data)
+{
+    swow_work_digest_item_t *item = (swow_work_digest_item_t *) data;
+
+    zend_string_release(item->input);
+    zend_string_release(item->output);
+    swow_work_digest_batch_release(item->batch);
+}
+
+/* submit all items with one yield, return false and throw if any of them failed */
+static cat_bool_t swow_work_digest_run(swow_work_digest_batch_t *batch, uint32_t count, cat_work_function_t function)
+{
+    cat_work_job_t jobs_stack[SWOW_WORK_DIGEST_STACK_SIZE];
+    cat_work_job_t *jobs = count <= SWOW_WORK_DIGEST_STACK_SIZE ? jobs_stack : (cat_work_job_t *) emalloc(sizeof(*jobs) * count);
+    cat_bool_t ret;
+    uint32_t n;
+
+    for (n = 0; n < count; n++) {
+        jobs[n].function = function;
+        jobs[n].cleanup = swow_work_digest_cleanup;
+        jobs[n].data = &batch->items[n];
+    }
+    ret = cat_work_many(CAT_WORK_KIND_CPU, jobs, count, CAT_TIMEOUT_FOREVER);
+    if (UNEXPECTED(!ret)) {
+        swow_throw_exception_with_last(swow_work_exception_ce);
+    } else {
+        for (n = 0; n < count; n++) {
+            if (UNEXPECTED(jobs[n].status != 0 || batch->items[n].failed)) {
+                swow_throw_exception(swow_work_exception_ce, CAT_EINVAL, "Digest failed");
+                ret = cat_false;
+                break;
+            }
+        }
+    }
+    if (jobs != jobs_stack) {
+        efree(jobs);
+    }
+
+    return ret;
+}
+
+static zend_string *swow_work_digest_item_get_result(swow_work_digest_item_t *item, size_t length)
+{
+    zend_string *output = item->output;
+
+    /* cleanup has not been called yet, items are still alive */
+    ZSTR_LEN(output) = length;
+    ZSTR_VAL(output)[length] = '\0';
+
+    return zend_string_copy(output);
+}
+
+static const EVP_MD *swow_work_get_md(zend_string *algo, uint32_t arg_num)
+{
+    const EVP_MD *md = EVP_get_digestbyname(ZSTR_VAL(algo));
+
+    if (UNEXPECTED(md == NULL)) {
+        zend_argument_value_error(arg_num, "must be a valid hashing algorithm");
+    }
+    return md;
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Work_hash, 0, 2, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, algo, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, binary, _IS_BOOL, 0, "false")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Work, hash)
+{
+    zend_string *algo;
+    zend_string *data;
+    zend_bool binary = 0;
+    swow_work_digest_batch_t *batch;
+    const EVP_MD *md;
+    size_t raw_length;
+
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_STR(algo)
+        Z_PARAM_STR(data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_BOOL(binary)
+    ZEND_PARSE_PARAMETERS_END();
+
+    md = swow_work_get_md(algo, 1);
+    if (UNEXPECTED(md == NULL)) {
+        RETURN_THROWS();
+    }
+    raw_length = EVP_MD_size(md);
+
+    batch = swow_work_digest_batch_create(md, binary, 1);
+    swow_work_digest_item_init(&batch->items[0], batch, data, raw_length);
+    if (EXPECTED(swow_work_digest_run(batch, 1, swow_work_hash_function))) {
+        RETVAL_STR(swow_work_digest_item_get_result(&batch->items[0], binary ? raw_length : raw_length * 2));
+    }
+    swow_work_digest_batch_release(batch);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Work_hashMany, 0, 2, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO(0, algo, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, data, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, binary, _IS_BOOL, 0, "false")
+ZEND_END_ARG_INFO()
+
+static PHP_METHOD(Swow_Work, hashMany)
+{
+    zend_string *algo;
+    HashTable *data;
+    zend_bool binary = 0;
+    swow_work_digest_batch_t *batch;
+    const EVP_MD *md;
+    size_t raw_length;
+    zend_string *key;
+    zend_ulong index;
+    zval *ztmp;
+    uint32_t count, n;
+
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_STR(algo)
+        Z_PARAM_ARRAY_HT(data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_BOOL(binary)
+    ZEND_PARSE_PARAMETERS_END();
+
+    md = swow_work_get_md(algo, 1);
+    if (UNEXPECTED(md == NULL)) {
+        RETURN_THROWS();
+    }
+    ZEND_HASH_FOREACH_VAL(data, ztmp) {
+        ZVAL_DEREF(ztmp);
+        if (UNEXPECTED(Z_TYPE_P(ztmp) != IS_STRING)) {
+            zend_argument_type_error(2, "must be an array of strings, %s given", zend_zval_type_name(ztmp));
+            RETURN_THROWS();
+        }
+    } ZEND_HASH_FOREACH_END();
+    count = zend_hash_num_elements(data);
+    if (count == 0) {
+        RETURN_EMPTY_ARRAY();
+    }
+    raw_length = EVP_MD_size(md);
+
+    batch = swow_work_digest_batch_create(md, binary, count);
+    n = 0;
+    ZEND_HASH_FOREACH_VAL(data, ztmp) {
+        ZVAL_DEREF(ztmp);
+        swow_work_digest_item_init(&batch->items[n++], batch, Z_STR_P(ztmp), raw_length);
+    } ZEND_HASH_FOREACH_END();
+    if (EXPECTED(swow_work_digest_run(batch, count, swow_work_hash_function))) {
+        array_init_size(return_value, count);
+        n = 0;
+        ZEND_HASH_FOREACH_KEY(data, index, key) {
+            zval zresult;
+            ZVAL_STR(&zresult, swow_work_digest_item_get_result(&batch->items[n++], binary ? raw_length : raw_length * 2));
+            if (key != NULL) {
+                zend_hash_add_new(Z_ARRVAL_P(return_value), key, &zresult);
+            } else {
+                zend_hash_index_add_new(Z_ARRVAL_P(return_value), index, &zresult);
+            }
+        } ZEND_HASH_FOREACH_END();
+    }
+    swow_work_digest_batch_release(batch);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Swow_Work_pbkdf2, 0, 4, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, algo, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, password, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, salt, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, iterations, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 0, "0")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, binary, _IS_BOOL, 0, "false")
+ZEND_END_ARG_INFO()
+
+/* same semantics as hash_pbkdf2() */
+static PHP_METHOD(Swow_Work, pbkdf2)
+{
+    zend_string *algo;
+    zend_string *password;
+    zend_string *salt;
+    zend_long iterations;
+    zend_long length = 0;
+    zend_bool binary = 0;
+    swow_work_digest_batch_t *batch;
+    const EVP_MD *md;
+    size_t raw_length;
+
+    ZEND_PARSE_PARAMETERS_START(4, 6)
+        Z_PARAM_STR(algo)
+        Z_PARAM_STR(password)
+        Z_PARAM_STR(salt)
+        Z_PARAM_LONG(iterations)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(length)
+        Z_PARAM_BOOL(binary)
+    ZEND_PARSE_PARAMETERS_END();
+
+    md = swow_work_get_md(algo, 1);
+    if (UNEXPECTED(md == NULL)) {
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(ZSTR_LEN(password) > INT_MAX)) {
+        zend_argument_value_error(2, "must be less than or equal to INT_MAX");
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(ZSTR_LEN(salt) > INT_MAX - 4)) {
+        zend_argument_value_error(3, "must be less than or equal to INT_MAX - 4 bytes");
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(iterations <= 0 || iterations > INT_MAX)) {
+        zend_argument_value_error(4, "must be greater than 0");
+        RETURN_THROWS();
+    }
+    if (UNEXPECTED(length < 0 || length > INT_MAX)) {
+        zend_argument_value_error(5, "must be greater than or equal to 0");
+        RETURN_THROWS();
+    }
+    if (length == 0) {
+        length = binary ? EVP_MD_size(md) : EVP_MD_size(md) * 2;
+    }
+    /* length is in hex digits if not binary */
+    raw_length = binary ? (size_t) length : ((size_t) length + 1) / 2;
+
+    batch = swow_work_digest_batch_create(md, binary, 1);
+    batch->salt = zend_string_copy(salt);
+    batch->iterations = (int) iterations;
+    swow_work_digest_item_init(&batch->items[0], batch, password, raw_length);
+    if (EXPECTED(swow_work_digest_run(batch, 1, swow_work_pbkdf2_function))) {
+        RETVAL_STR(swow_work_digest_item_get_result(&batch->items[0], (size_t) length));
+    }
+    swow_work_digest_batch_release(batch);
+}
+#endif /* CAT_HAVE_OPENSSL */
+
+static const zend_function_entry swow_work_methods[] = {
+    PHP_ME(Swow_Work, getPoolSize, arginfo_class_Swow_Work_getPoolSize, ZEND_ACC_STATIC | ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Work, setPoolSize, arginfo_class_Swow_Work_setPoolSize, ZEND_ACC_STATIC | ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Work, getPoolStats, arginfo_class_Swow_Work_getPoolStats, ZEND_ACC_STATIC | ZEND_ACC_PUBLIC)
+#ifdef CAT_HAVE_OPENSSL
+    PHP_ME(Swow_Work, hash, arginfo_class_Swow_Work_hash, ZEND_ACC_STATIC | ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Work, hashMany, arginfo_class_Swow_Work_hashMany, ZEND_ACC_STATIC | ZEND_ACC_PUBLIC)
+    PHP_ME(Swow_Work, pbkdf2, arginfo_class_Swow_Work_pbkdf2, ZEND_ACC_STATIC | ZEND_ACC_PUBLIC)
+#endif
+    PHP_FE_END
+};
+
+zend_result swow_work_module_init(INIT_FUNC_ARGS)
+{
+    swow_work_ce = swow_register_internal_class(
+        "Swow\\Work", NULL, swow_work_methods,
+        NULL, NULL, cat_false, cat_false,
+        swow_create_object_deny, NULL, 0
+    );
+    zend_declare_class_constant_long(swow_work_ce, ZEND_STRL("KIND_CPU"), CAT_WORK_KIND_CPU);
+    zend_declare_class_constant_long(swow_work_ce, ZEND_STRL("KIND_FAST_IO"), CAT_WORK_KIND_FAST_IO);
+    zend_declare_class_constant_long(swow_work_ce, ZEND_STRL("KIND_SLOW_IO"), CAT_WORK_KIND_SLOW_IO);
+
+    swow_work_exception_ce = swow_register_internal_class(
+        "Swow\\WorkException", swow_exception_ce, NULL, NULL, NULL, cat_true, cat_true, NULL, NULL, 0
+    );
+
+    return SUCCESS;
+}
@@ -0,0 +1,98 @@
+--TEST--
+swow_buffer: pool
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Buffer;
+use Swow\BufferException;
+use Swow\Coroutine;
+use Swow\Errno;
+
+// pool is disabled
+Assert::false(Buffer::getPoolStats()['enabled']);
+$buffer = new Buffer(Buffer::COMMON_SIZE);
+Assert::false($buffer->recycle());
+Assert::false($buffer->isAvailable());
+
+Buffer::enablePool(Buffer::COMMON_SIZE, 2);
+try {
+    Buffer::enablePool();
+    echo "Never here\n";
+} catch (BufferException $exception) {
+    Assert::same($exception->getCode(), Errno::EMISUSE);
+}
+$stats = Buffer::getPoolStats();
+Assert::true($stats['enabled']);
+Assert::same($stats['block_size'], Buffer::COMMON_SIZE);
+Assert::same($stats['max_size'], 2);
+
+// recycled memory is reused and it is empty
+$buffer->alloc(Buffer::COMMON_SIZE);
+$buffer->append('foo');
+Assert::true($buffer->recycle());
+Assert::false($buffer->isAvailable());
+$buffer->alloc(Buffer::COMMON_SIZE);
+Assert::same($buffer->getLength(), 0);
+Assert::same($buffer->toString(), '');
+$buffer->append('bar');
+Assert::same($buffer->toString(), 'bar');
+$stats = Buffer::getPoolStats();
+Assert::same($stats['hits'], 1);
+Assert::same($stats['recycles'], 1);
+Assert::same($stats['count'], 0);
+
+// shared memory can not be recycled
+$string = $buffer->toString();
+Assert::false($buffer->recycle());
+Assert::false($buffer->isAvailable());
+Assert::same($string, 'bar');
+
+// size is not the block size
+$buffer->alloc(Buffer::COMMON_SIZE * 2);
+Assert::false($buffer->recycle());
+
+// pool is full
+$buffers = [];
+for ($n = 0; $n < 3; $n++) {
+    $buffers[] = new Buffer(Buffer::COMMON_SIZE);
+}
+Assert::true($buffers[0]->recycle());
+Assert::true($buffers[1]->recycle());
+Assert::false($buffers[2]->recycle());
+Assert::same(Buffer::getPoolStats()['count'], 2);
+
+// locked buffer
+$buffer->alloc(Buffer::COMMON_SIZE);
+$buffer->lock();
+Coroutine::run(static function () use ($buffer): void {
+    try {
+        $buffer->recycle();
+        echo "Never here\n";
+    } catch (Error $error) {
+        Assert::contains($error->getMessage(), 'locked');
+    }
+});
+$buffer->unlock();
+
+Buffer::disablePool();
+$stats = Buffer::getPoolStats();
+Assert::false($stats['enabled']);
+Assert::same($stats['count'], 0);
+Assert::false($buffer->recycle());
+Buffer::disablePool();
+
+// pool will be disabled on shutdown
+Buffer::enablePool();
+$buffer->alloc(Buffer::COMMON_SIZE);
+Assert::true($buffer->recycle());
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
@@ -0,0 +1,78 @@
+--TEST--
+swow_channel: pushMany and popMany
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Channel;
+use Swow\ChannelException;
+use Swow\Coroutine;
+use Swow\Errno;
+
+// limited by capacity, order is kept across the ring boundary
+$channel = new Channel(5);
+Assert::same($channel->pushMany([]), 0);
+Assert::same($channel->pushMany([1, 2, 3]), 3);
+Assert::same($channel->popMany(2), [1, 2]);
+Assert::same($channel->pushMany(['a' => 4, 'b' => 5, 'c' => 6, 'd' => 7, 'e' => 8]), 4);
+Assert::true($channel->isFull());
+Assert::same($channel->popMany(100), [3, 4, 5, 6, 7]);
+try {
+    $channel->popMany(1, 0);
+    echo "Never here\n";
+} catch (ChannelException $exception) {
+    Assert::same($exception->getCode(), Errno::ETIMEDOUT);
+}
+try {
+    $channel->popMany(0);
+    echo "Never here\n";
+} catch (ValueError $error) {
+    echo $error->getMessage(), "\n";
+}
+
+// memory is allocated for the popped items instead of count or capacity
+$channel = new Channel(1 << 30);
+Assert::same($channel->pushMany(range(1, 40)), 40);
+Assert::same($channel->popMany(PHP_INT_MAX), range(1, 40));
+Assert::true($channel->isEmpty());
+
+// batches between coroutines
+$total = 1000;
+foreach ([0, 1, 7, 100] as $capacity) {
+    $channel = new Channel($capacity);
+    Coroutine::run(static function () use ($channel, $total): void {
+        $data = range(1, $total);
+        while ($data) {
+            $data = array_slice($data, $channel->pushMany($data));
+        }
+        $channel->close();
+    });
+    $sum = $count = 0;
+    try {
+        while (true) {
+            foreach ($channel->popMany(16) as $item) {
+                $sum += $item;
+                $count++;
+            }
+        }
+    } catch (ChannelException) {
+        /* closed */
+    }
+    Assert::same($count, $total);
+    Assert::same($sum, $total * ($total + 1) / 2);
+}
+
+// refcounted items are released with the channel
+$channel = new Channel(10);
+$channel->pushMany([new stdClass(), [1, 2, 3], str_repeat('x', 100)]);
+unset($channel);
+
+echo "Done\n";
+?>
+--EXPECT--
+Swow\Channel::popMany(): Argument #1 ($count) must be greater than 0
+Done
@@ -0,0 +1,32 @@
+--TEST--
+swow_coroutine: getStackPoolStats()
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+
+$stats = Coroutine::getStackPoolStats();
+foreach (['max_size', 'hot_size', 'count', 'hot_count', 'hits', 'misses'] as $key) {
+    Assert::keyExists($stats, $key);
+    Assert::integer($stats[$key]);
+}
+
+if ($stats['max_size'] > 0) {
+    for ($n = 0; $n < TEST_MAX_REQUESTS; $n++) {
+        Coroutine::run(static function (): void { });
+    }
+    $newStats = Coroutine::getStackPoolStats();
+    Assert::greaterThanEq($newStats['hits'] - $stats['hits'], TEST_MAX_REQUESTS - 1);
+    Assert::lessThanEq($newStats['count'], $newStats['max_size']);
+    Assert::lessThanEq($newStats['hot_count'], $newStats['count']);
+}
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
@@ -0,0 +1,88 @@
+--TEST--
+swow_coroutine: ready queue and priority
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+
+$stats = Coroutine::getReadyQueueStats();
+Assert::false($stats['enabled']);
+Assert::same(Coroutine::getCurrent()->getPriority(), Coroutine::PRIORITY_NORMAL);
+
+$coroutine = new Coroutine(static function (): void { });
+Assert::same($coroutine->setPriority(Coroutine::PRIORITY_HIGH), $coroutine);
+Assert::same($coroutine->getPriority(), Coroutine::PRIORITY_HIGH);
+$coroutine->resume();
+
+function runSleepers(): string
+{
+    $order = '';
+    $priorities = [
+        'a' => Coroutine::PRIORITY_LOW,
+        'b' => Coroutine::PRIORITY_NORMAL,
+        'c' => Coroutine::PRIORITY_HIGH,
+        'd' => Coroutine::PRIORITY_NORMAL,
+        'e' => Coroutine::PRIORITY_HIGH,
+        'f' => Coroutine::PRIORITY_LOW,
+    ];
+    foreach ($priorities as $tag => $priority) {
+        $coroutine = new Coroutine(static function () use ($tag, &$order): void {
+            msleep(10);
+            $order .= $tag;
+        });
+        $coroutine->setPriority($priority)->resume();
+    }
+    msleep(50);
+
+    return $order;
+}
+
+// coroutines are resumed in callback order by default
+Assert::same(runSleepers(), 'abcdef');
+
+// higher priority first, FIFO in the same priority class
+Coroutine::enableReadyQueue();
+Assert::same(runSleepers(), 'cebdaf');
+$stats = Coroutine::getReadyQueueStats();
+Assert::true($stats['enabled']);
+Assert::same($stats['count'], 0);
+Assert::greaterThanEq($stats['peak_count'], 6);
+Assert::greaterThanEq($stats['resumes'], 6);
+
+// the rest of coroutines wait for the next round if budget is exhausted
+Coroutine::enableReadyQueue(2);
+Assert::same(runSleepers(), 'cebdaf');
+$exhaustedRounds = Coroutine::getReadyQueueStats()['exhausted_rounds'];
+Assert::greaterThanEq($exhaustedRounds, 2);
+Assert::same(Coroutine::getReadyQueueStats()['budget_count'], 2);
+
+Coroutine::disableReadyQueue();
+Assert::same(runSleepers(), 'abcdef');
+Assert::same(Coroutine::getReadyQueueStats()['exhausted_rounds'], $exhaustedRounds);
+
+// bad args
+try {
+    Coroutine::getCurrent()->setPriority(3);
+    echo "Never here\n";
+} catch (ValueError $error) {
+    echo $error->getMessage(), "\n";
+}
+try {
+    Coroutine::enableReadyQueue(-1);
+    echo "Never here\n";
+} catch (ValueError $error) {
+    echo $error->getMessage(), "\n";
+}
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Swow\Coroutine::setPriority(): Argument #1 ($priority) must be one of Coroutine::PRIORITY_LOW, Coroutine::PRIORITY_NORMAL or Coroutine::PRIORITY_HIGH
+Swow\Coroutine::enableReadyQueue(): Argument #1 ($budgetCount) must be greater than or equal to 0
+Done
@@ -0,0 +1,102 @@
+--TEST--
+swow_curl: PHP callbacks are called in the coroutine of curl_exec() on the runtime multi handle
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if_extension_not_exist('curl');
+skip_if(PHP_SAPI !== 'cli', 'only for cli');
+skip_if(!getenv('SWOW_HAVE_CURL') && !Swow\Extension::isBuiltWith('curl'), 'extension must be built with libcurl');
+skip_if(getenv('CAT_CURL_SHARED_MULTI') === '0', 'shared multi handle is disabled');
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Socket;
+use Swow\SocketException;
+use Swow\Sync\WaitReference;
+
+// keep-alive http server which sends body in pieces
+$connections = 0;
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1', 0)->listen();
+Coroutine::run(static function () use ($server, &$connections): void {
+    while (true) {
+        try {
+            $connection = $server->accept();
+        } catch (SocketException) {
+            break;
+        }
+        $connections++;
+        Coroutine::run(static function () use ($connection): void {
+            $buffer = '';
+            try {
+                while (true) {
+                    while (($end = strpos($buffer, "\r\n\r\n")) === false) {
+                        $data = $connection->recvString();
+                        if ($data === '') {
+                            return;
+                        }
+                        $buffer .= $data;
+                    }
+                    $buffer = substr($buffer, $end + 4);
+                    $connection->send("HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\nOK");
+                    msleep(1);
+                    $connection->send('OK');
+                }
+            } catch (SocketException) {
+                /* closed */
+            }
+        });
+    }
+});
+
+$url = "http://{$server->getSockAddress()}:{$server->getSockPort()}/";
+$request = static function () use ($url): void {
+    $coroutine = Coroutine::getCurrent();
+    $headers = [];
+    $body = '';
+    $ch = curl_init($url);
+    curl_setopt($ch, CURLOPT_HEADERFUNCTION, static function ($ch, string $header) use ($coroutine, &$headers): int {
+        Assert::same(Coroutine::getCurrent(), $coroutine);
+        $headers[] = $header;
+        return strlen($header);
+    });
+    curl_setopt($ch, CURLOPT_WRITEFUNCTION, static function ($ch, string $data) use ($coroutine, &$body): int {
+        Assert::same(Coroutine::getCurrent(), $coroutine);
+        // callbacks can switch coroutines
+        msleep(1);
+        Assert::same(Coroutine::getCurrent(), $coroutine);
+        $body .= $data;
+        return strlen($data);
+    });
+    Assert::true(curl_exec($ch));
+    Assert::same($headers[0], "HTTP/1.1 200 OK\r\n");
+    Assert::same($body, 'OKOK');
+    curl_close($ch);
+};
+
+// a new easy handle every time, connection can only be reused through the runtime multi handle
+for ($n = 0; $n < 3; $n++) {
+    $request();
+}
+Assert::same($connections, 1);
+
+for ($round = 0; $round < 2; $round++) {
+    $wr = new WaitReference();
+    for ($n = 0; $n < TEST_MAX_CONCURRENCY; $n++) {
+        Coroutine::run(static function () use ($request, $wr): void {
+            $request();
+        });
+    }
+    WaitReference::wait($wr);
+}
+Assert::lessThanEq($connections, TEST_MAX_CONCURRENCY);
+
+$server->close();
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
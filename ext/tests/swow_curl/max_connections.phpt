@@ -0,0 +1,107 @@
+--TEST--
+swow_curl: connection caps of the runtime multi handle
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if_extension_not_exist('curl');
+skip_if(PHP_SAPI !== 'cli', 'only for cli');
+skip_if(!getenv('SWOW_HAVE_CURL') && !Swow\Extension::isBuiltWith('curl'), 'extension must be built with libcurl');
+skip_if(getenv('CAT_CURL_SHARED_MULTI') === '0', 'shared multi handle is disabled');
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Curl;
+use Swow\Socket;
+use Swow\SocketException;
+use Swow\Sync\WaitReference;
+
+const CONCURRENCY = 8;
+const MAX_HOST_CONNECTIONS = 2;
+
+$originalMaxHostConnections = Curl::setMaxHostConnections(4);
+Assert::same(Curl::setMaxHostConnections(2), 4);
+Assert::same(Curl::setMaxHostConnections($originalMaxHostConnections), 2);
+
+$originalMaxTotalConnections = Curl::setMaxTotalConnections(64);
+Assert::same(Curl::setMaxTotalConnections(0), 64);
+Assert::same(Curl::setMaxTotalConnections($originalMaxTotalConnections), 0);
+
+try {
+    Curl::setMaxHostConnections(-1);
+    echo "Never here\n";
+} catch (ValueError $error) {
+    Assert::contains($error->getMessage(), 'must be greater than or equal to 0');
+}
+
+// slow keep-alive http server which counts connections which are open at the same time
+$openConnections = 0;
+$maxOpenConnections = 0;
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1', 0)->listen();
+Coroutine::run(static function () use ($server, &$openConnections, &$maxOpenConnections): void {
+    while (true) {
+        try {
+            $connection = $server->accept();
+        } catch (SocketException) {
+            break;
+        }
+        $maxOpenConnections = max($maxOpenConnections, ++$openConnections);
+        Coroutine::run(static function () use ($connection, &$openConnections): void {
+            $buffer = '';
+            try {
+                while (true) {
+                    while (($end = strpos($buffer, "\r\n\r\n")) === false) {
+                        $data = $connection->recvString();
+                        if ($data === '') {
+                            return;
+                        }
+                        $buffer .= $data;
+                    }
+                    $buffer = substr($buffer, $end + 4);
+                    msleep(50);
+                    $connection->send("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK");
+                }
+            } catch (SocketException) {
+                /* closed */
+            } finally {
+                $openConnections--;
+            }
+        });
+    }
+});
+
+$url = "http://{$server->getSockAddress()}:{$server->getSockPort()}/";
+$requestConcurrently = static function () use ($url): void {
+    $wr = new WaitReference();
+    for ($n = 0; $n < CONCURRENCY; $n++) {
+        Coroutine::run(static function () use ($url, $wr): void {
+            $ch = curl_init($url);
+            curl_setopt($ch, CURLOPT_RETURNTRANSFER, 1);
+            Assert::same(curl_exec($ch), 'OK');
+            curl_close($ch);
+        });
+    }
+    WaitReference::wait($wr);
+};
+
+// transfers are queued until one of the capped connections is free
+$originalMaxHostConnections = Curl::setMaxHostConnections(MAX_HOST_CONNECTIONS);
+$requestConcurrently();
+Assert::greaterThan($maxOpenConnections, 0);
+Assert::lessThanEq($maxOpenConnections, MAX_HOST_CONNECTIONS);
+
+// without the cap, more connections are opened for the same load
+Curl::setMaxHostConnections(0);
+$requestConcurrently();
+Assert::greaterThan($maxOpenConnections, MAX_HOST_CONNECTIONS);
+
+Curl::setMaxHostConnections($originalMaxHostConnections);
+$server->close();
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
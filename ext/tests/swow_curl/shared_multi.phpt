@@ -0,0 +1,78 @@
+--TEST--
+swow_curl: connections are reused across coroutines
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if_extension_not_exist('curl');
+skip_if(PHP_SAPI !== 'cli', 'only for cli');
+skip_if(!getenv('SWOW_HAVE_CURL') && !Swow\Extension::isBuiltWith('curl'), 'extension must be built with libcurl');
+skip_if(getenv('CAT_CURL_SHARED_MULTI') === '0', 'shared multi handle is disabled');
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Socket;
+use Swow\SocketException;
+use Swow\Sync\WaitReference;
+
+// keep-alive http server
+$connections = 0;
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1', 0)->listen();
+Coroutine::run(static function () use ($server, &$connections): void {
+    while (true) {
+        try {
+            $connection = $server->accept();
+        } catch (SocketException) {
+            break;
+        }
+        $connections++;
+        Coroutine::run(static function () use ($connection): void {
+            $buffer = '';
+            try {
+                while (true) {
+                    while (($end = strpos($buffer, "\r\n\r\n")) === false) {
+                        $data = $connection->recvString();
+                        if ($data === '') {
+                            return;
+                        }
+                        $buffer .= $data;
+                    }
+                    $buffer = substr($buffer, $end + 4);
+                    $connection->send("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK");
+                }
+            } catch (SocketException) {
+                /* closed */
+            }
+        });
+    }
+});
+
+$url = "http://{$server->getSockAddress()}:{$server->getSockPort()}/";
+$request = static function () use ($url): void {
+    // a new easy handle every time, connection can only be reused through the runtime multi handle
+    $ch = curl_init($url);
+    curl_setopt($ch, CURLOPT_RETURNTRANSFER, 1);
+    Assert::same(curl_exec($ch), 'OK');
+    curl_close($ch);
+};
+
+for ($round = 0; $round < 2; $round++) {
+    $wr = new WaitReference();
+    for ($n = 0; $n < TEST_MAX_CONCURRENCY; $n++) {
+        Coroutine::run(static function () use ($request, $wr): void {
+            $request();
+        });
+    }
+    WaitReference::wait($wr);
+}
+Assert::lessThanEq($connections, TEST_MAX_CONCURRENCY);
+
+$server->close();
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
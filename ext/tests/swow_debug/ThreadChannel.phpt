@@ -0,0 +1,102 @@
+--TEST--
+swow_debug: thread channel
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if(!Swow\Extension::isBuiltWith('debug'), 'extension must be built with debug');
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\ChannelException;
+use Swow\Coroutine;
+use Swow\Debug\ThreadChannel;
+use Swow\Errno;
+use Swow\Sync\WaitReference;
+
+// capacity is rounded up to the power of two
+$channel = new ThreadChannel(3);
+Assert::same($channel->getCapacity(), 4);
+
+// push never blocks
+for ($n = 0; $n < 4; $n++) {
+    Assert::true($channel->push($n));
+}
+Assert::false($channel->push(4));
+Assert::same($channel->getLength(), 4);
+for ($n = 0; $n < 4; $n++) {
+    Assert::same($channel->tryPop(), $n);
+}
+Assert::null($channel->tryPop());
+
+// pop timed out on the empty channel
+try {
+    $channel->pop(10);
+    echo "Never here\n";
+} catch (ChannelException $exception) {
+    Assert::same($exception->getCode(), Errno::ETIMEDOUT);
+}
+
+// the producer thread is blocked while the channel is full,
+// and coroutines are blocked while it is empty
+const C = 4;
+const N = 1024;
+$received = [];
+$wr = new WaitReference();
+for ($c = 0; $c < C; $c++) {
+    Coroutine::run(static function () use ($channel, &$received, $wr): void {
+        for ($n = 0; $n < N / C; $n++) {
+            $received[] = $channel->pop();
+        }
+    });
+}
+$channel->startProducer(N);
+WaitReference::wait($wr);
+Assert::same($channel->joinProducer(), N);
+sort($received);
+Assert::same($received, range(0, N - 1));
+Assert::same($channel->getLength(), 0);
+
+// close wakes up the waiting consumer
+$wr = new WaitReference();
+Coroutine::run(static function () use ($channel, $wr): void {
+    try {
+        $channel->pop();
+        echo "Never here\n";
+    } catch (ChannelException $exception) {
+        Assert::same($exception->getCode(), Errno::ECLOSED);
+    }
+});
+$channel->close();
+WaitReference::wait($wr);
+Assert::false($channel->isAvailable());
+Assert::false($channel->push(0));
+
+// items pushed before close can still be popped
+$channel = new ThreadChannel(4);
+Assert::true($channel->push(1));
+$channel->close();
+Assert::same($channel->pop(), 1);
+try {
+    $channel->pop();
+    echo "Never here\n";
+} catch (ChannelException $exception) {
+    Assert::same($exception->getCode(), Errno::ECLOSED);
+}
+
+// close stops the producer thread which is blocked on the full channel
+$channel = new ThreadChannel(2);
+$channel->startProducer(N);
+while ($channel->getLength() < 2) {
+    msleep(1);
+}
+$channel->close();
+Assert::same($channel->joinProducer(), 2);
+Assert::same($channel->tryPop(), 0);
+Assert::same($channel->tryPop(), 1);
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
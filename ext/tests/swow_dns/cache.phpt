@@ -0,0 +1,65 @@
+--TEST--
+swow_dns: cache
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Dns;
+use Swow\Sync\WaitReference;
+
+Dns::flushCache();
+$stats = Dns::getCacheStats();
+Assert::same($stats['size'], 0);
+Assert::greaterThan($stats['max_size'], 0);
+
+// concurrent lookups of the same name are coalesced
+$wr = new WaitReference();
+for ($n = 0; $n < TEST_MAX_CONCURRENCY; $n++) {
+    Coroutine::run(static function () use ($wr): void {
+        Assert::same(gethostbyname('localhost'), '127.0.0.1');
+    });
+}
+WaitReference::wait($wr);
+$newStats = Dns::getCacheStats();
+Assert::same($newStats['size'], 1);
+Assert::same($newStats['misses'] - $stats['misses'], 1);
+Assert::same($newStats['coalesced'] - $stats['coalesced'], TEST_MAX_CONCURRENCY - 1);
+
+// then it is served from cache
+$stats = $newStats;
+Assert::same(gethostbyname('LocalHost'), '127.0.0.1');
+$newStats = Dns::getCacheStats();
+Assert::same($newStats['hits'] - $stats['hits'], 1);
+
+$entries = Dns::getCacheEntries();
+Assert::count($entries, 1);
+Assert::same($entries[0]['hostname'], 'localhost');
+Assert::same($entries[0]['family'], AF_INET);
+Assert::same($entries[0]['addresses'], ['127.0.0.1']);
+Assert::greaterThan($entries[0]['ttl'], 0);
+
+Assert::same(Dns::flushCache('unknown'), 0);
+Assert::same(Dns::flushCache('LOCALHOST'), 1);
+Assert::same(Dns::getCacheEntries(), []);
+
+// disabled
+$originalSize = Dns::setCacheSize(0);
+Assert::same(gethostbyname('localhost'), '127.0.0.1');
+Assert::same(Dns::getCacheStats()['size'], 0);
+Assert::same(Dns::setCacheSize($originalSize), 0);
+
+// expired
+Dns::setCacheTtl(1);
+Assert::same(gethostbyname('localhost'), '127.0.0.1');
+msleep(10);
+Assert::same(Dns::getCacheEntries(), []);
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
@@ -0,0 +1,150 @@
+--TEST--
+swow_dns: native resolver
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Dns;
+use Swow\DnsException;
+use Swow\Errno;
+use Swow\Socket;
+use Swow\SocketException;
+use Swow\Sync\WaitReference;
+
+function dnsName(string $name): string
+{
+    $data = '';
+    foreach (explode('.', rtrim($name, '.')) as $label) {
+        $data .= chr(strlen($label)) . $label;
+    }
+    return $data . "\0";
+}
+
+function dnsRecord(string $name, int $type, int $ttl, string $data): string
+{
+    return dnsName($name) . pack('nnNn', $type, 1, $ttl, strlen($data)) . $data;
+}
+
+/* a tiny stub DNS server which knows a few names */
+function dnsAnswer(string $query): string
+{
+    $offset = 12;
+    $labels = [];
+    while (($length = ord($query[$offset])) !== 0) {
+        $labels[] = substr($query, $offset + 1, $length);
+        $offset += $length + 1;
+    }
+    $name = implode('.', $labels);
+    $type = unpack('n', $query, $offset + 1)[1];
+    $question = substr($query, 12, $offset + 5 - 12);
+    $rcode = 0;
+    $records = [];
+    switch ($name) {
+        case 'a.swow.test':
+            if ($type === Dns::TYPE_A) {
+                $records[] = dnsRecord($name, Dns::TYPE_A, 60, inet_pton('10.0.0.1'));
+                $records[] = dnsRecord($name, Dns::TYPE_A, 30, inet_pton('10.0.0.2'));
+            } elseif ($type === Dns::TYPE_AAAA) {
+                $records[] = dnsRecord($name, Dns::TYPE_AAAA, 60, inet_pton('fd00::1'));
+            }
+            break;
+        case 'alias.swow.test':
+            $records[] = dnsRecord($name, Dns::TYPE_CNAME, 60, dnsName('a.swow.test'));
+            if ($type === Dns::TYPE_A) {
+                $records[] = dnsRecord('a.swow.test', Dns::TYPE_A, 60, inet_pton('10.0.0.1'));
+            }
+            break;
+        case '_sip._tcp.swow.test':
+            if ($type === Dns::TYPE_SRV) {
+                $records[] = dnsRecord($name, Dns::TYPE_SRV, 60, pack('nnn', 10, 20, 5060) . dnsName('sip.swow.test'));
+            }
+            break;
+        default:
+            $rcode = 3; /* NXDOMAIN */
+    }
+    $header = substr($query, 0, 2) . pack('nnnnn', 0x8180 | $rcode, 1, count($records), 0, 0);
+    return $header . $question . implode('', $records);
+}
+
+$server = new Socket(Socket::TYPE_UDP);
+$server->bind('127.0.0.1');
+Coroutine::run(static function () use ($server): void {
+    try {
+        while (true) {
+            $query = $server->recvStringFrom(512, $ip, $port);
+            $server->sendTo(dnsAnswer($query), address: $ip, port: $port);
+        }
+    } catch (SocketException) {
+        /* closed */
+    }
+});
+
+Dns::loadConfig('', '');
+Dns::setNameservers([$server->getSockAddress() . ':' . $server->getSockPort()]);
+
+$records = Dns::query('a.swow.test');
+Assert::count($records, 2);
+Assert::same($records[0]['name'], 'a.swow.test');
+Assert::same($records[0]['type'], Dns::TYPE_A);
+Assert::same($records[0]['ttl'], 60);
+Assert::same($records[0]['address'], '10.0.0.1');
+Assert::same($records[1]['address'], '10.0.0.2');
+
+$records = Dns::query('a.swow.test', Dns::TYPE_AAAA);
+Assert::same($records[0]['address'], 'fd00::1');
+
+$records = Dns::query('alias.swow.test');
+Assert::same($records[0]['type'], Dns::TYPE_CNAME);
+Assert::same($records[0]['target'], 'a.swow.test');
+Assert::same($records[1]['address'], '10.0.0.1');
+
+$records = Dns::query('_sip._tcp.swow.test', Dns::TYPE_SRV);
+Assert::same($records[0]['priority'], 10);
+Assert::same($records[0]['weight'], 20);
+Assert::same($records[0]['port'], 5060);
+Assert::same($records[0]['target'], 'sip.swow.test');
+
+try {
+    Dns::query('unknown.swow.test');
+    echo "Never here\n";
+} catch (DnsException $exception) {
+    Assert::same($exception->getCode(), Errno::EAI_NONAME);
+}
+
+// many queries in flight at the same time
+$wr = new WaitReference();
+for ($n = 0; $n < TEST_MAX_CONCURRENCY; $n++) {
+    Coroutine::run(static function () use ($wr): void {
+        Assert::same(Dns::query('a.swow.test')[0]['address'], '10.0.0.1');
+    });
+}
+WaitReference::wait($wr);
+
+// getaddrinfo goes through the native resolver
+Dns::flushCache();
+$originalResolver = Dns::setResolver(Dns::RESOLVER_NATIVE);
+Assert::same(Dns::getResolver(), Dns::RESOLVER_NATIVE);
+Assert::same(gethostbyname('alias.swow.test'), '10.0.0.1');
+Assert::same(gethostbyname2('a.swow.test', AF_INET6), 'fd00::1');
+Dns::setResolver($originalResolver);
+Dns::flushCache();
+
+try {
+    Dns::setNameservers('not-an-ip');
+    echo "Never here\n";
+} catch (DnsException $exception) {
+    Assert::same($exception->getCode(), Errno::EINVAL);
+}
+
+$server->close();
+Dns::loadConfig();
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
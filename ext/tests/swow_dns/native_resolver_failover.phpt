@@ -0,0 +1,182 @@
+--TEST--
+swow_dns: native resolver falls back to TCP and fails over to the next nameserver
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Dns;
+use Swow\Socket;
+use Swow\SocketException;
+use Swow\Sync\WaitReference;
+
+const BIG_RECORD_COUNT = 64;
+const HOSTS_ADDRESS_COUNT = 10;
+
+function dnsName(string $name): string
+{
+    $data = '';
+    foreach (explode('.', rtrim($name, '.')) as $label) {
+        $data .= chr(strlen($label)) . $label;
+    }
+    return $data . "\0";
+}
+
+function dnsRecord(string $name, int $type, int $ttl, string $data): string
+{
+    return dnsName($name) . pack('nnNn', $type, 1, $ttl, strlen($data)) . $data;
+}
+
+/** @return array{0: string, 1: string} name and question section */
+function dnsQuestion(string $query): array
+{
+    $offset = 12;
+    $labels = [];
+    while (($length = ord($query[$offset])) !== 0) {
+        $labels[] = substr($query, $offset + 1, $length);
+        $offset += $length + 1;
+    }
+    return [implode('.', $labels), substr($query, 12, $offset + 5 - 12)];
+}
+
+/** @param string[] $records */
+function dnsAnswer(string $query, int $flags, array $records = []): string
+{
+    [, $question] = dnsQuestion($query);
+    return substr($query, 0, 2) . pack('nnnnn', 0x8180 | $flags, 1, count($records), 0, 0) . $question . implode('', $records);
+}
+
+function bigRecords(string $name): array
+{
+    $records = [];
+    for ($n = 1; $n <= BIG_RECORD_COUNT; $n++) {
+        $records[] = dnsRecord($name, Dns::TYPE_A, 60, inet_pton("10.0.1.{$n}"));
+    }
+    return $records;
+}
+
+/** @param callable(string, int): ?string $handler returns null to drop the query */
+function runUdpServer(Socket $server, callable $handler): void
+{
+    Coroutine::run(static function () use ($server, $handler): void {
+        try {
+            while (true) {
+                $query = $server->recvStringFrom(512, $ip, $port);
+                $answer = $handler($query, $port);
+                if ($answer !== null) {
+                    $server->sendTo($answer, address: $ip, port: $port);
+                }
+            }
+        } catch (SocketException) {
+            /* closed */
+        }
+    });
+}
+
+// it answers over UDP, but big answers are truncated (TC=1) and must be queried over TCP
+$sourcePorts = [];
+$good = new Socket(Socket::TYPE_UDP);
+$good->bind('127.0.0.1');
+runUdpServer($good, static function (string $query, int $port) use (&$sourcePorts): string {
+    $sourcePorts[] = $port;
+    [$name] = dnsQuestion($query);
+    if ($name === 'big.swow.test') {
+        return dnsAnswer($query, 0x0200 /* TC */);
+    }
+    return dnsAnswer($query, 0, [dnsRecord($name, Dns::TYPE_A, 60, inet_pton('10.0.0.1'))]);
+});
+$goodTcp = new Socket(Socket::TYPE_TCP);
+$goodTcp->bind($good->getSockAddress(), $good->getSockPort())->listen();
+Coroutine::run(static function () use ($goodTcp): void {
+    try {
+        while (true) {
+            $connection = $goodTcp->accept();
+            $length = unpack('n', $connection->readString(2))[1];
+            $query = $connection->readString($length);
+            [$name] = dnsQuestion($query);
+            $answer = dnsAnswer($query, 0, bigRecords($name));
+            $connection->send(pack('n', strlen($answer)) . $answer);
+            $connection->close();
+        }
+    } catch (SocketException) {
+        /* closed */
+    }
+});
+$goodAddress = $good->getSockAddress() . ':' . $good->getSockPort();
+
+// it always fails
+$servfail = new Socket(Socket::TYPE_UDP);
+$servfail->bind('127.0.0.1');
+runUdpServer($servfail, static fn (string $query): string => dnsAnswer($query, 2 /* SERVFAIL */));
+$servfailAddress = $servfail->getSockAddress() . ':' . $servfail->getSockPort();
+
+// it never answers
+$silent = new Socket(Socket::TYPE_UDP);
+$silent->bind('127.0.0.1');
+runUdpServer($silent, static fn (): ?string => null);
+$silentAddress = $silent->getSockAddress() . ':' . $silent->getSockPort();
+
+Dns::loadConfig('', '');
+
+// TCP fallback
+Dns::setNameservers([$goodAddress]);
+$records = Dns::query('big.swow.test');
+Assert::count($records, BIG_RECORD_COUNT);
+Assert::same($records[BIG_RECORD_COUNT - 1]['address'], '10.0.1.' . BIG_RECORD_COUNT);
+
+// each query is sent from its own socket (random source port)
+$sourcePorts = [];
+$wr = new WaitReference();
+for ($n = 0; $n < TEST_MAX_CONCURRENCY; $n++) {
+    Coroutine::run(static function () use ($wr): void {
+        Assert::same(Dns::query('a.swow.test')[0]['address'], '10.0.0.1');
+    });
+}
+WaitReference::wait($wr);
+Assert::count($sourcePorts, TEST_MAX_CONCURRENCY);
+Assert::count(array_unique($sourcePorts), TEST_MAX_CONCURRENCY);
+
+// fail over to the next nameserver on SERVFAIL
+Dns::setNameservers([$servfailAddress, $goodAddress]);
+Assert::same(Dns::query('a.swow.test')[0]['address'], '10.0.0.1');
+
+// fail over to the next nameserver on timeout
+$resolvConf = tempnam(sys_get_temp_dir(), 'swow_resolv_');
+file_put_contents($resolvConf, "options timeout:1 attempts:1\nnameserver {$silentAddress}\nnameserver {$goodAddress}\n");
+Dns::loadConfig($resolvConf, '');
+$startTime = microtime(true);
+Assert::same(Dns::query('a.swow.test')[0]['address'], '10.0.0.1');
+Assert::greaterThanEq(microtime(true) - $startTime, 0.9);
+
+// addresses of a name in hosts file are not limited by the number of nameservers
+$hosts = tempnam(sys_get_temp_dir(), 'swow_hosts_');
+$hostsContent = '';
+for ($n = 1; $n <= HOSTS_ADDRESS_COUNT; $n++) {
+    $hostsContent .= "10.0.2.{$n} many.swow.test\n";
+}
+file_put_contents($hosts, $hostsContent);
+Dns::loadConfig($resolvConf, $hosts);
+Dns::flushCache();
+$originalResolver = Dns::setResolver(Dns::RESOLVER_NATIVE);
+Assert::same(gethostbyname('many.swow.test'), '10.0.2.1');
+$entries = Dns::getCacheEntries();
+Assert::count(array_unique($entries[0]['addresses']), HOSTS_ADDRESS_COUNT);
+Dns::setResolver($originalResolver);
+Dns::flushCache();
+
+unlink($resolvConf);
+unlink($hosts);
+$good->close();
+$goodTcp->close();
+$servfail->close();
+$silent->close();
+Dns::loadConfig();
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
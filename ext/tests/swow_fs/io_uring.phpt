@@ -0,0 +1,74 @@
+--TEST--
+swow_fs: concurrent file operations (io_uring or thread pool)
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if(!is_writable(sys_get_temp_dir()), 'temp dir is not writable');
+?>
+--ENV--
+CAT_FS_IO_URING=1
+CAT_IO_URING_ENTRIES=4
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Sync\WaitReference;
+
+use function Swow\Debug\getIoUringStats;
+
+const C = 16;
+
+// more requests than SQ entries are issued in the same round
+$wr = new WaitReference();
+for ($c = 0; $c < C; $c++) {
+    Coroutine::run(static function () use ($c, $wr): void {
+        $path = sys_get_temp_dir() . "/swow-test-io-uring-{$c}";
+        $data = getRandomBytes(8192 + $c);
+        $file = fopen($path, 'w+');
+        Assert::same(fwrite($file, $data), strlen($data));
+        if (function_exists('fsync')) {
+            Assert::true(fsync($file));
+            Assert::true(fdatasync($file));
+        } else {
+            Assert::true(fflush($file));
+        }
+        Assert::same(fstat($file)['size'], strlen($data));
+        Assert::same(fseek($file, 1), 0);
+        Assert::same(fread($file, 4), substr($data, 1, 4));
+        Assert::true(fclose($file));
+        clearstatcache();
+        Assert::same(filesize($path), strlen($data));
+        Assert::same(lstat($path)['size'], strlen($data));
+        Assert::same(file_get_contents($path), $data);
+        Assert::same(file_put_contents($path, 'foo', FILE_APPEND), 3);
+        Assert::same(file_get_contents($path), $data . 'foo');
+        Assert::true(unlink($path));
+        Assert::false(@file_get_contents($path));
+    });
+}
+WaitReference::wait($wr);
+
+// requests really went through io_uring if it is available (otherwise they fell back to the thread pool)
+$stats = getIoUringStats();
+if ($stats['available']) {
+    Assert::true($stats['running']);
+    Assert::greaterThan($stats['submissions'], 0);
+    Assert::greaterThanEq($stats['completions'], $stats['submissions']);
+    Assert::greaterThan($stats['enters'], 0);
+    Assert::lessThanEq($stats['max_batch'], $stats['entries']);
+    Assert::same($stats['inflight'], 0);
+    Assert::same($stats['pending'], 0);
+}
+
+echo "Done\n";
+
+?>
+--CLEAN--
+<?php
+for ($c = 0; $c < 16; $c++) {
+    @unlink(sys_get_temp_dir() . "/swow-test-io-uring-{$c}");
+}
+?>
+--EXPECT--
+Done
@@ -0,0 +1,86 @@
+--TEST--
+swow_http: parse request/status line and headers at once
+--SKIPIF--
+<?php
+
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Buffer;
+use Swow\Http\Parser;
+use Swow\Http\ParserException;
+
+$body = 'Hello Swow';
+$request = "POST /echo?foo=bar HTTP/1.1\r\n" .
+    "Host: localhost\r\n" .
+    "content-type: text/plain\r\n" .
+    "X-Test-Header: value1\r\n" .
+    "x-test-header: value2\r\n" .
+    "X-Test-Header: \r\n" .
+    'Content-Length: ' . strlen($body) . "\r\n" .
+    "\r\n" .
+    $body;
+
+$parser = (new Parser())->setType(Parser::TYPE_REQUEST)->setEvents(Parser::EVENT_BODY | Parser::EVENT_MESSAGE_COMPLETE);
+
+// incomplete head does not change the parser
+$buffer = new Buffer(Buffer::COMMON_SIZE);
+$buffer->append(substr($request, 0, 40));
+Assert::null($parser->parseHead($buffer));
+
+$buffer->append(substr($request, 40));
+$head = $parser->parseHead($buffer);
+Assert::same($head['method'], 'POST');
+Assert::same($head['uri'], '/echo?foo=bar');
+Assert::same($head['protocolVersion'], '1.1');
+Assert::same($head['headers'], [
+    'Host' => ['localhost'],
+    'content-type' => ['text/plain'],
+    'X-Test-Header' => ['value1', ''],
+    'x-test-header' => ['value2'],
+    'Content-Length' => [(string) strlen($body)],
+]);
+Assert::same($head['headerNames'], [
+    'host' => 'Host',
+    'content-type' => 'content-type',
+    'x-test-header' => 'X-Test-Header',
+    'content-length' => 'Content-Length',
+]);
+Assert::same($head['contentLength'], strlen($body));
+Assert::false($head['isChunked']);
+Assert::false($head['isUpgrade']);
+Assert::false($head['isMultipart']);
+Assert::true($head['shouldKeepAlive']);
+Assert::same($head['headLength'], strlen($request) - strlen($body));
+
+// parser continues with body
+$offset = $head['headLength'];
+$offset += $parser->execute($buffer, $offset);
+Assert::same($parser->getEvent(), Parser::EVENT_BODY);
+Assert::same($buffer->read($parser->getDataOffset(), $parser->getDataLength()), $body);
+$parser->execute($buffer, $offset);
+Assert::same($parser->getEvent(), Parser::EVENT_MESSAGE_COMPLETE);
+
+// response
+$parser = (new Parser())->setType(Parser::TYPE_RESPONSE);
+$head = $parser->parseHead("HTTP/1.1 404 Not Found\r\nConnection: close\r\nTransfer-Encoding: chunked\r\n\r\n");
+Assert::same($head['statusCode'], 404);
+Assert::same($head['reasonPhrase'], 'Not Found');
+Assert::same($head['protocolVersion'], '1.1');
+Assert::true($head['isChunked']);
+Assert::false($head['shouldKeepAlive']);
+
+// bad head
+$parser = (new Parser())->setType(Parser::TYPE_REQUEST);
+try {
+    $parser->parseHead("GET / HTTP/1.1\r\nBad Header\r\n\r\n");
+    echo "Never here\n";
+} catch (ParserException $exception) {
+    echo "Done\n";
+}
+?>
+--EXPECT--
+Done
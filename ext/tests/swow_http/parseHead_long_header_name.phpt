@@ -0,0 +1,25 @@
+--TEST--
+swow_http: parseHead() with header names around the known header name length limit
+--SKIPIF--
+<?php
+
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Http\Parser;
+
+foreach ([63, 64, 65] as $nameLength) {
+    $name = 'X-' . str_repeat('A', $nameLength - 2);
+    $parser = (new Parser())->setType(Parser::TYPE_REQUEST);
+    $head = $parser->parseHead("GET / HTTP/1.1\r\n{$name}: value\r\n\r\n");
+    Assert::same($head['headers'], [$name => ['value']]);
+    Assert::same($head['headerNames'], [strtolower($name) => $name]);
+}
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
@@ -0,0 +1,108 @@
+--TEST--
+swow_socket: acceptMany and acceptManyTo
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Errno;
+use Swow\Socket;
+use Swow\SocketException;
+
+const CONNECTIONS = 32;
+const BATCH_SIZE = 16;
+
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1')->listen(CONNECTIONS * 2);
+
+$clients = [];
+for ($n = 0; $n < CONNECTIONS; $n++) {
+    $client = new Socket(Socket::TYPE_TCP);
+    $client->connect($server->getSockAddress(), $server->getSockPort());
+    $clients[$client->getSockPort()] = $client;
+}
+
+// all pending connections are accepted in rounds
+$connections = [];
+while (count($connections) < CONNECTIONS) {
+    $batch = $server->acceptMany(BATCH_SIZE);
+    Assert::greaterThanEq(count($batch), 1);
+    Assert::lessThanEq(count($batch), BATCH_SIZE);
+    foreach ($batch as $connection) {
+        Assert::isInstanceOf($connection, Socket::class);
+        Assert::true($connection->isServerConnection());
+        $connections[] = $connection;
+    }
+}
+Assert::same(count($connections), CONNECTIONS);
+foreach ($connections as $connection) {
+    $connection->send('ping');
+    Assert::same($clients[$connection->getPeerPort()]->readString(4), 'ping');
+    $connection->close();
+}
+
+$stats = $server->getAcceptStats();
+Assert::same($stats['count'], CONNECTIONS);
+Assert::greaterThanEq($stats['rounds'], intdiv(CONNECTIONS, BATCH_SIZE));
+Assert::lessThanEq($stats['max_batch_size'], BATCH_SIZE);
+Assert::greaterThanEq($stats['listen_overflows'], 0);
+Assert::greaterThanEq($stats['listen_drops'], 0);
+
+// accept into the given connections
+for ($n = 0; $n < 2; $n++) {
+    $client = new Socket(Socket::TYPE_TCP);
+    $client->connect($server->getSockAddress(), $server->getSockPort());
+    $clients[] = $client;
+}
+msleep(10);
+$connections = [new Socket(Socket::TYPE_TCP), new Socket(Socket::TYPE_TCP), new Socket(Socket::TYPE_TCP)];
+Assert::same($server->acceptManyTo($connections), 2);
+Assert::true($connections[0]->isEstablished());
+Assert::true($connections[1]->isEstablished());
+Assert::false($connections[2]->isOpen());
+
+// wait until timed out
+try {
+    $server->acceptMany(BATCH_SIZE, 10);
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::ETIMEDOUT);
+}
+try {
+    $server->acceptManyTo([$connections[2]], 10);
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::ETIMEDOUT);
+}
+
+// bad args
+try {
+    $server->acceptMany(0);
+    echo "Never here\n";
+} catch (ValueError $error) {
+    echo $error->getMessage(), "\n";
+}
+try {
+    $server->acceptManyTo([]);
+    echo "Never here\n";
+} catch (ValueError $error) {
+    echo $error->getMessage(), "\n";
+}
+try {
+    $server->acceptManyTo(['foo']);
+    echo "Never here\n";
+} catch (TypeError $error) {
+    echo $error->getMessage(), "\n";
+}
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Swow\Socket::acceptMany(): Argument #1 ($maxCount) must be greater than 0
+Swow\Socket::acceptManyTo(): Argument #1 ($connections) can not be empty
+Swow\Socket::acceptManyTo(): Argument #1 ($connections) [0] must be of type Swow\Socket, string given
+Done
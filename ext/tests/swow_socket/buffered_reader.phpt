@@ -0,0 +1,100 @@
+--TEST--
+swow_socket: buffered reader (readLine, readUntil and readFrame)
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Errno;
+use Swow\Socket;
+use Swow\SocketException;
+use Swow\Sync\WaitReference;
+
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1')->listen();
+$wr = new WaitReference();
+Coroutine::run(static function () use ($server, $wr): void {
+    $connection = $server->accept();
+    // many messages in one packet
+    $lines = '';
+    for ($n = 0; $n < TEST_MAX_REQUESTS; $n++) {
+        $lines .= "line {$n}" . ($n % 2 ? "\r\n" : "\n");
+    }
+    $connection->send($lines);
+    // one message in many packets
+    foreach (str_split('foo|bar||baz||', 1) as $char) {
+        $connection->send($char);
+        Coroutine::yield();
+    }
+    // uint32 BE, uint16 LE and 3 bytes LE length with sequence id (MySQL packet)
+    $connection->send(pack('N', 5) . 'hello' . pack('v', 5) . 'world' . "\x03\x00\x00\x07" . 'foo');
+    // length field counts the whole frame
+    $connection->send(pack('N', 4 + 6) . 'swow!!');
+    // frame is limited by default
+    $connection->send(pack('J', Socket::DEFAULT_MAX_FRAME_LENGTH + 1) . str_repeat('x', Socket::DEFAULT_MAX_FRAME_LENGTH + 1));
+    // raw data after messages
+    $connection->send("too long line\nraw");
+    $connection->close();
+});
+
+$client = new Socket(Socket::TYPE_TCP);
+$client->connect($server->getSockAddress(), $server->getSockPort());
+for ($n = 0; $n < TEST_MAX_REQUESTS; $n++) {
+    Assert::same($client->readLine(), "line {$n}");
+}
+Assert::same($client->readUntil('||'), 'foo|bar');
+Assert::same($client->readUntil('||'), 'baz');
+Assert::same($client->readFrame(), 'hello');
+Assert::same($client->readFrame(2, littleEndian: true), 'world');
+Assert::same($client->readFrame(3, littleEndian: true, lengthAdjustment: 1, initialBytesToStrip: 3), "\x07foo");
+Assert::same($client->readFrame(lengthAdjustment: -4), 'swow!!');
+try {
+    $client->readFrame(8);
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::EMSGSIZE);
+}
+Assert::same(strlen($client->readFrame(8, maxLength: -1)), Socket::DEFAULT_MAX_FRAME_LENGTH + 1);
+try {
+    $client->readLine(4);
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::EMSGSIZE);
+}
+// data is still available after failure
+Assert::same($client->readLine(), 'too long line');
+Assert::lessThanEq($client->getReadBufferedLength(), strlen('raw'));
+Assert::same($client->readString(strlen('raw')), 'raw');
+Assert::same($client->getReadBufferedLength(), 0);
+try {
+    $client->readLine();
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::ECONNRESET);
+}
+$wr::wait($wr);
+
+try {
+    $client->readFrame(9);
+    echo "Never here\n";
+} catch (ValueError $exception) {
+    echo $exception->getMessage(), "\n";
+}
+try {
+    $client->readUntil('');
+    echo "Never here\n";
+} catch (ValueError $exception) {
+    echo $exception->getMessage(), "\n";
+}
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Swow\Socket::readFrame(): Argument #1 ($lengthFieldSize) must be between 1 and 8
+Swow\Socket::readUntil(): Argument #1 ($delimiter) can not be empty
+Done
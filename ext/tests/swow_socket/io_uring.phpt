@@ -0,0 +1,129 @@
+--TEST--
+swow_socket: stream socket IO through io_uring engine (or libuv fallback)
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--ENV--
+CAT_SOCKET_IO_URING=1
+CAT_SOCKET_IO_URING_BUFFER_COUNT=4
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Errno;
+use Swow\Socket;
+use Swow\SocketException;
+use Swow\Sync\WaitReference;
+
+use function Swow\Debug\getIoUringStats;
+
+const CONNECTIONS = 16;
+const LARGE_LENGTH = 1024 * 1024 + 1;
+
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1')->listen(CONNECTIONS * 2);
+$large = getRandomBytes(LARGE_LENGTH);
+
+Coroutine::run(static function () use ($server, $large): void {
+    while (true) {
+        try {
+            $connection = $server->accept();
+        } catch (SocketException) {
+            break;
+        }
+        Coroutine::run(static function () use ($connection, $large): void {
+            while (true) {
+                $request = $connection->recvString();
+                if ($request === '') {
+                    break;
+                }
+                if ($request === 'large') {
+                    // large data is sent by zero-copy send, the small one must follow it
+                    Coroutine::run(static function () use ($connection, $large): void {
+                        $connection->send($large);
+                    });
+                    $connection->send('end');
+                    continue;
+                }
+                if ($request === 'vector') {
+                    $connection->write([$large, ['end']]);
+                    continue;
+                }
+                $connection->send($request);
+            }
+            $connection->close();
+        });
+    }
+});
+
+// echo on many connections
+$wr = new WaitReference();
+for ($c = 0; $c < CONNECTIONS; $c++) {
+    Coroutine::run(static function () use ($server, $c, $wr): void {
+        $client = new Socket(Socket::TYPE_TCP);
+        $client->connect($server->getSockAddress(), $server->getSockPort());
+        for ($n = 0; $n < TEST_MAX_REQUESTS; $n++) {
+            $message = "hello {$c}-{$n}";
+            $client->send($message);
+            Assert::same($client->readString(strlen($message)), $message);
+        }
+        $client->close();
+    });
+}
+WaitReference::wait($wr);
+
+$client = new Socket(Socket::TYPE_TCP);
+$client->connect($server->getSockAddress(), $server->getSockPort());
+
+// read timeout does not lose data
+try {
+    $client->recvString(8192, 10);
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::ETIMEDOUT);
+}
+$client->send('ping');
+Assert::same($client->peekString(4, -1), 'ping');
+Assert::same($client->readString(4), 'ping');
+
+// large data
+$client->send('large');
+Assert::same($client->readString(LARGE_LENGTH), $large);
+Assert::same($client->readString(3), 'end');
+$client->send('vector');
+Assert::same($client->readString(LARGE_LENGTH), $large);
+Assert::same($client->readString(3), 'end');
+$client->close();
+
+// read is canceled by close
+$client = new Socket(Socket::TYPE_TCP);
+$client->connect($server->getSockAddress(), $server->getSockPort());
+Coroutine::run(static function () use ($client): void {
+    msleep(1);
+    $client->close();
+});
+try {
+    $client->recvString();
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::ECANCELED);
+}
+
+$server->close();
+
+// IO really went through io_uring if the engine is available (otherwise it fell back to libuv)
+$stats = getIoUringStats();
+if ($stats['socket_engine']) {
+    Assert::true($stats['available']);
+    Assert::greaterThan($stats['accept_multishot'], 0);
+    Assert::greaterThan($stats['recv_multishot'], 0);
+    Assert::greaterThan($stats['send_zc'], 0);
+}
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
@@ -0,0 +1,104 @@
+--TEST--
+swow_socket: reuseport CPU affinity and accept stats
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_linux_only();
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Errno;
+use Swow\Socket;
+use Swow\SocketException;
+use Swow\Sync\WaitGroup;
+
+const LISTENERS = 2;
+
+$servers = [];
+$port = 0;
+for ($n = 0; $n < LISTENERS; $n++) {
+    $server = new Socket(Socket::TYPE_TCP);
+    $server->bind('127.0.0.1', $port, Socket::BIND_FLAG_REUSEPORT_CPU_AFFINITY)->listen();
+    $port = $server->getSockPort();
+    $servers[] = $server;
+}
+
+$wg = new WaitGroup();
+$wg->add(TEST_MAX_REQUESTS);
+foreach ($servers as $index => $server) {
+    Coroutine::run(static function () use ($server, $index, $wg): void {
+        try {
+            while (true) {
+                $connection = $server->accept();
+                $cpu = $connection->getIncomingCpu();
+                Assert::greaterThanEq($cpu, 0);
+                $listenerCpu = $server->getIncomingCpu();
+                if ($listenerCpu >= 0) {
+                    // listener is bound to the CPU which the process is bound to
+                    Assert::same($cpu, $listenerCpu);
+                } elseif ($cpu < LISTENERS) {
+                    // connections processed on CPU N are dispatched to the N-th listener,
+                    // the others fall back to hash if there are less listeners than CPUs
+                    Assert::same($index, $cpu);
+                }
+                $connection->close();
+                $wg->done();
+            }
+        } catch (SocketException $exception) {
+            Assert::same($exception->getCode(), Errno::ECANCELED);
+        }
+    });
+}
+for ($n = 0; $n < TEST_MAX_REQUESTS; $n++) {
+    $client = new Socket(Socket::TYPE_TCP);
+    $client->connect('127.0.0.1', $port);
+    $client->close();
+}
+$wg->wait();
+
+$count = 0;
+foreach ($servers as $server) {
+    $stats = $server->getAcceptStats();
+    Assert::greaterThanEq($stats['uptime'], 0);
+    Assert::greaterThanEq($stats['idle'], 0);
+    Assert::float($stats['rate']);
+    Assert::same($stats['queue_length'], 0);
+    Assert::greaterThan($stats['queue_capacity'], 0);
+    $count += $stats['count'];
+    $server->close();
+}
+Assert::same($count, TEST_MAX_REQUESTS);
+
+// connections waiting to be accepted
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1', 0, Socket::BIND_FLAG_REUSEPORT)->listen(16);
+Assert::same($server->setReusePortCpuAffinity(), $server);
+Assert::same($server->setIncomingCpu(0), $server);
+$client = new Socket(Socket::TYPE_TCP);
+$client->connect($server->getSockAddress(), $server->getSockPort());
+msleep(10);
+$stats = $server->getAcceptStats();
+Assert::same($stats['count'], 0);
+Assert::same($stats['queue_length'], 1);
+Assert::same($stats['queue_capacity'], 16);
+$server->accept()->close();
+Assert::same($server->getAcceptStats()['count'], 1);
+
+// only listening sockets have accept stats
+try {
+    $client->getAcceptStats();
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::EMISUSE);
+}
+$client->close();
+$server->close();
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
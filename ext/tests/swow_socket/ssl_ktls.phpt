@@ -0,0 +1,84 @@
+--TEST--
+swow_socket: SSL with kTLS option
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if(!getenv('SWOW_HAVE_SSL') && !Swow\Extension::isBuiltWith('ssl'), 'extension must be built with libcurl');
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Extension;
+use Swow\Socket;
+use Swow\Sync\WaitReference;
+
+const FILE_SIZE = 1024 * 1024;
+
+function assertKtlsStatus(Socket $socket): void
+{
+    $status = $socket->getCryptoKtlsStatus();
+    // records are always read through the BIO pair
+    Assert::false($status['recv']);
+    if (!Extension::isBuiltWith('ktls')) {
+        Assert::false($status['send']);
+        return;
+    }
+    // kernel may not support the negotiated cipher even if the TLS module is loaded,
+    // then it falls back to userland encryption and there is nothing to check
+    if (!$status['send']) {
+        return;
+    }
+    // otherwise the kernel must have taken over the encryption (by software or by NIC offload)
+    $tlsStat = file_get_contents('/proc/net/tls_stat');
+    Assert::notSame($tlsStat, false);
+    $currentTx = 0;
+    foreach (['TlsCurrTxSw', 'TlsCurrTxDevice'] as $name) {
+        if (preg_match("/^{$name}\\s+(\\d+)$/m", $tlsStat, $matches) === 1) {
+            $currentTx += (int) $matches[1];
+        }
+    }
+    Assert::greaterThan($currentTx, 0);
+}
+
+$random = getRandomBytes(FILE_SIZE);
+$tmpFile = tmpfile();
+fwrite($tmpFile, $random);
+$filename = stream_get_meta_data($tmpFile)['uri'];
+
+// it works whether kernel supports kTLS or not (fallback to userland encryption)
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1')->listen();
+$wr = new WaitReference();
+Coroutine::run(static function () use ($server, $filename, $wr): void {
+    $connection = $server->accept();
+    $connection->enableCrypto([
+        'certificate' => __DIR__ . '/../include/ssl/server.crt',
+        'certificate_key' => __DIR__ . '/../include/ssl/server.key',
+        'ktls' => true,
+    ]);
+    assertKtlsStatus($connection);
+    Assert::same($connection->readString(5), 'hello');
+    $connection->send('world');
+    Assert::same($connection->sendFile($filename), FILE_SIZE);
+    $connection->close();
+});
+$client = new Socket(Socket::TYPE_TCP);
+$client->connect($server->getSockAddress(), $server->getSockPort());
+$client->enableCrypto([
+    'verify_peer' => false,
+    'verify_peer_name' => false,
+    'ktls' => true,
+]);
+assertKtlsStatus($client);
+$client->send('hello');
+Assert::same($client->readString(5), 'world');
+Assert::same($client->readString(FILE_SIZE), $random);
+$wr::wait($wr);
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
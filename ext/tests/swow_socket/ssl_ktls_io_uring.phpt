@@ -0,0 +1,63 @@
+--TEST--
+swow_socket: STARTTLS with kTLS after data was read ahead by io_uring engine
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if(!getenv('SWOW_HAVE_SSL') && !Swow\Extension::isBuiltWith('ssl'), 'extension must be built with libcurl');
+?>
+--ENV--
+CAT_SOCKET_IO_URING=1
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Socket;
+use Swow\Sync\WaitReference;
+
+use function Swow\Debug\getIoUringStats;
+
+const LARGE_LENGTH = 1024 * 1024;
+
+$large = getRandomBytes(LARGE_LENGTH);
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1')->listen();
+$wr = new WaitReference();
+Coroutine::run(static function () use ($server, $large, $wr): void {
+    $connection = $server->accept();
+    // plaintext is read through io_uring engine, and ClientHello may have been read ahead with it
+    Assert::same($connection->readString(strlen("STARTTLS\n")), "STARTTLS\n");
+    $connection->enableCrypto([
+        'certificate' => __DIR__ . '/../include/ssl/server.crt',
+        'certificate_key' => __DIR__ . '/../include/ssl/server.key',
+        'ktls' => true,
+    ]);
+    Assert::same($connection->readString(5), 'hello');
+    $connection->send('world');
+    $connection->send($large);
+    $connection->close();
+});
+
+$client = new Socket(Socket::TYPE_TCP);
+$client->connect($server->getSockAddress(), $server->getSockPort());
+// start handshake without waiting for server, so that its records follow the plaintext closely
+$client->send("STARTTLS\n");
+$client->enableCrypto([
+    'verify_peer' => false,
+    'verify_peer_name' => false,
+]);
+$client->send('hello');
+Assert::same($client->readString(5), 'world');
+Assert::same($client->readString(LARGE_LENGTH), $large);
+$wr::wait($wr);
+
+$stats = getIoUringStats();
+if ($stats['socket_engine']) {
+    Assert::greaterThan($stats['recv_multishot'], 0);
+}
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
@@ -0,0 +1,65 @@
+--TEST--
+swow_socket: SSL session resumption
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if(!getenv('SWOW_HAVE_SSL') && !Swow\Extension::isBuiltWith('ssl'), 'extension must be built with openssl');
+skip_if(!extension_loaded('curl'), 'curl extension is required');
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Socket;
+use Swow\SocketException;
+
+const REQUESTS = 3;
+
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1')->listen();
+Coroutine::run(static function () use ($server): void {
+    try {
+        while (true) {
+            $connection = $server->accept();
+            Coroutine::run(static function () use ($connection): void {
+                $connection->enableCrypto([
+                    'certificate' => __DIR__ . '/../include/ssl/server.crt',
+                    'certificate_key' => __DIR__ . '/../include/ssl/server.key',
+                    'session_cache' => true,
+                    'session_timeout' => 60,
+                ]);
+                $connection->recvString();
+                $connection->send("HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nOK");
+                $connection->close();
+            });
+        }
+    } catch (SocketException) {
+    }
+});
+
+$statsBefore = Socket::getCryptoSessionStats();
+$ch = curl_init("https://{$server->getSockAddress()}:{$server->getSockPort()}");
+curl_setopt($ch, CURLOPT_SSL_VERIFYPEER, false);
+curl_setopt($ch, CURLOPT_SSL_VERIFYHOST, false);
+curl_setopt($ch, CURLOPT_FORBID_REUSE, true);
+curl_setopt($ch, CURLOPT_RETURNTRANSFER, true);
+for ($i = 0; $i < REQUESTS; $i++) {
+    Assert::same(curl_exec($ch), 'OK');
+}
+curl_close($ch);
+$stats = Socket::getCryptoSessionStats();
+Assert::same($stats['handshakes'] - $statsBefore['handshakes'], REQUESTS);
+Assert::greaterThanEq($stats['resumed'] - $statsBefore['resumed'], 1);
+$server->close();
+
+// it would be a huge size if it was casted to size_t
+Assert::throws(static function (): void {
+    (new Socket(Socket::TYPE_TCP))->enableCrypto(['session_cache' => true, 'session_cache_size' => -1]);
+}, ValueError::class);
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
@@ -0,0 +1,105 @@
+--TEST--
+swow_socket: udp recvMultipleFrom and sendMultipleTo
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Errno;
+use Swow\Socket;
+use Swow\SocketException;
+
+const BATCH_SIZE = 16;
+
+Socket::setGlobalTimeout(1000);
+
+$randoms = getRandomBytesArray(TEST_MAX_REQUESTS, TEST_MAX_LENGTH_LOW);
+
+$server = new Socket(Socket::TYPE_UDP);
+$server->bind('127.0.0.1');
+
+// a batch udp echo server
+Coroutine::run(static function () use ($server): void {
+    try {
+        while (true) {
+            $datagrams = $server->recvMultipleFrom(BATCH_SIZE, TEST_MAX_LENGTH_LOW + 4);
+            Assert::greaterThanEq(count($datagrams), 1);
+            Assert::lessThanEq(count($datagrams), BATCH_SIZE);
+            Assert::same($server->sendMultipleTo($datagrams), count($datagrams));
+        }
+    } catch (SocketException $exception) {
+        Assert::same($exception->getCode(), Errno::ECANCELED);
+    }
+});
+
+$client = new Socket(Socket::TYPE_UDP);
+$received = 0;
+foreach (array_chunk($randoms, BATCH_SIZE, true) as $chunk) {
+    $datagrams = [];
+    foreach ($chunk as $n => $random) {
+        $datagrams[] = [pack('N', $n) . $random, $server->getSockAddress(), $server->getSockPort()];
+    }
+    Assert::same($client->sendMultipleTo($datagrams), count($datagrams));
+    $expected = count($datagrams);
+    while ($expected > 0) {
+        foreach ($client->recvMultipleFrom(BATCH_SIZE, TEST_MAX_LENGTH_LOW + 4) as [$packet, $address, $port]) {
+            Assert::same($address, $server->getSockAddress());
+            Assert::same($port, $server->getSockPort());
+            $index = unpack('Nindex', substr($packet, 0, 4))['index'];
+            Assert::keyExists($chunk, $index);
+            Assert::same(substr($packet, 4), $chunk[$index]);
+            $expected--;
+            $received++;
+        }
+    }
+}
+Assert::same($received, count($randoms));
+
+// connected socket
+$connected = new Socket(Socket::TYPE_UDP);
+$connected->connect($server->getSockAddress(), $server->getSockPort());
+Assert::same($connected->sendMultipleTo(['foo', ['bar'], ['baz', null, null]]), 3);
+$messages = [];
+while (count($messages) < 3) {
+    foreach ($connected->recvMultipleFrom() as [$packet]) {
+        $messages[] = $packet;
+    }
+}
+sort($messages);
+Assert::same($messages, ['bar', 'baz', 'foo']);
+
+// timeout
+try {
+    $connected->recvMultipleFrom(timeout: 10);
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::ETIMEDOUT);
+}
+
+// dgram only
+$tcp = new Socket(Socket::TYPE_TCP);
+try {
+    $tcp->recvMultipleFrom();
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::EMISUSE);
+}
+
+try {
+    $client->sendMultipleTo([1]);
+    echo "Never here\n";
+} catch (TypeError $exception) {
+    echo $exception->getMessage(), "\n";
+}
+
+$server->close();
+echo "Done\n";
+
+?>
+--EXPECT--
+Swow\Socket::sendMultipleTo(): Argument #1 ($datagrams) [0] ($data) must be of type string, int given
+Done
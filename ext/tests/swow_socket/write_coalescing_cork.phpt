@@ -0,0 +1,114 @@
+--TEST--
+swow_socket: write coalescing and cork
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Errno;
+use Swow\Socket;
+use Swow\SocketException;
+use Swow\Sync\WaitGroup;
+use Swow\Sync\WaitReference;
+
+const WRITERS = 16;
+const RECORD_SIZE = 128;
+const LARGE_LENGTH = 128 * 1024;
+
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1')->listen();
+$wr = new WaitReference();
+Coroutine::run(static function () use ($server, $wr): void {
+    $connection = $server->accept();
+    Assert::same($connection->setWriteCoalescing(true), $connection);
+
+    // records written by different coroutines must not be interleaved
+    $wg = new WaitGroup();
+    $wg->add(WRITERS);
+    for ($n = 0; $n < WRITERS; $n++) {
+        Coroutine::run(static function () use ($connection, $n, $wg): void {
+            for ($i = 0; $i < TEST_MAX_REQUESTS; $i++) {
+                $connection->send(str_pad("{$n}:{$i}:", RECORD_SIZE, chr(ord('a') + $n)));
+            }
+            $wg->done();
+        });
+    }
+    $wg->wait();
+    // wait for the peer to drain them, so that the following data is the only one in flight
+    Assert::same($connection->readString(strlen('ready')), 'ready');
+
+    // header and body are sent by one write
+    Assert::same($connection->cork(), $connection);
+    Assert::true($connection->isCorked());
+    $connection->send("HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\n");
+    // header would arrive alone if it was not corked
+    msleep(10);
+    Assert::true($connection->isCorked());
+    $connection->send('hello');
+    Assert::same($connection->uncork(), $connection);
+    Assert::false($connection->isCorked());
+    // uncork without cork is a no-op
+    $connection->uncork();
+
+    // large data will be flushed automatically
+    $connection->cork();
+    $connection->send('[');
+    $connection->send(str_repeat('x', LARGE_LENGTH));
+    $connection->send(']');
+    $connection->uncork();
+
+    // corked data is flushed on close
+    $connection->cork();
+    $connection->send('bye');
+    Assert::true($connection->close());
+});
+
+$client = new Socket(Socket::TYPE_TCP);
+$client->connect($server->getSockAddress(), $server->getSockPort());
+$sequences = array_fill(0, WRITERS, 0);
+for ($n = 0; $n < WRITERS * TEST_MAX_REQUESTS; $n++) {
+    $record = $client->readString(RECORD_SIZE);
+    [$writer, $sequence] = explode(':', $record);
+    Assert::same((int) $sequence, $sequences[$writer]++);
+    Assert::same($record, str_pad("{$writer}:{$sequence}:", RECORD_SIZE, chr(ord('a') + $writer)));
+}
+$client->send('ready');
+// it arrives as a single segment
+$response = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello";
+Assert::same($client->recvString(strlen($response) * 2), $response);
+Assert::same($client->readString(LARGE_LENGTH + 2), '[' . str_repeat('x', LARGE_LENGTH) . ']');
+Assert::same($client->readString(strlen('bye')), 'bye');
+Assert::same($client->recvString(), '');
+$wr::wait($wr);
+
+// destructor never blocks, corked data is flushed by one try-write
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1')->listen();
+$client = new Socket(Socket::TYPE_TCP);
+$client->connect($server->getSockAddress(), $server->getSockPort());
+$connection = $server->accept();
+$connection->cork();
+$connection->send('destructed');
+$connection = null;
+Assert::same($client->readString(strlen('destructed')), 'destructed');
+Assert::same($client->recvString(), '');
+$server->close();
+
+// only stream sockets can be corked
+$udp = new Socket(Socket::TYPE_UDP);
+try {
+    $udp->cork();
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::EMISUSE);
+}
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
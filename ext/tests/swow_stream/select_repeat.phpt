@@ -0,0 +1,57 @@
+--TEST--
+swow_stream: select on the same stream repeatedly
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require_once __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+
+$server = stream_socket_server('tcp://127.0.0.1:0');
+$serverName = stream_socket_get_name($server, false);
+
+Coroutine::run(static function () use ($server): void {
+    $connection = stream_socket_accept($server);
+    while (($data = fread($connection, 8192)) !== '' && $data !== false) {
+        fwrite($connection, $data);
+    }
+    fclose($connection);
+});
+
+$client = stream_socket_client("tcp://{$serverName}");
+
+for ($n = 0; $n < TEST_MAX_REQUESTS; $n++) {
+    $write = [$client];
+    $read = $except = null;
+    Assert::same(stream_select($read, $write, $except, 1), 1);
+    fwrite($client, "ping {$n}");
+
+    $read = [$client];
+    $write = $except = null;
+    Assert::same(stream_select($read, $write, $except, 1), 1);
+    Assert::same(fread($client, 8192), "ping {$n}");
+
+    // nothing to read
+    $read = [$client];
+    Assert::same(stream_select($read, $write, $except, 0, 1000), 0);
+    Assert::isEmpty($read);
+}
+
+// both read and write on the same stream
+fwrite($client, 'pong');
+usleep(10 * 1000);
+$read = [$client];
+$write = [$client];
+$except = null;
+Assert::same(stream_select($read, $write, $except, 1), 2);
+Assert::same(fread($client, 8192), 'pong');
+
+fclose($client);
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
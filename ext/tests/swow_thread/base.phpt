@@ -0,0 +1,64 @@
+--TEST--
+swow_thread: base
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if(!PHP_ZTS, 'ZTS is required');
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Socket;
+use Swow\Thread;
+use Swow\ThreadException;
+
+Assert::null(Thread::getParent());
+Assert::same(Thread::getArguments(), []);
+
+$thread = new Thread(__DIR__ . '/child.inc', ['name' => 'child', 'status' => 42]);
+Assert::greaterThan($thread->getId(), 0);
+Assert::true($thread->isRunning());
+
+// values
+$thread->send('hello')->send(['foo' => 1.5]);
+Assert::same(Thread::receive(), ['child', 'hello']);
+Assert::same(Thread::receive(), ['child', ['foo' => 1.5]]);
+
+// more messages than mailbox capacity, senders on both sides wait for receivers
+$count = 4096;
+Coroutine::run(static function () use ($thread, $count): void {
+    for ($n = 0; $n < $count; $n++) {
+        $thread->send($n);
+    }
+});
+for ($n = 0; $n < $count; $n++) {
+    Assert::same(Thread::receive(), ['child', $n]);
+}
+
+// sockets
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1')->listen();
+$client = new Socket(Socket::TYPE_TCP);
+$client->connect($server->getSockAddress(), $server->getSockPort());
+$connection = $server->accept();
+$thread->send($connection);
+$connection->close();
+Assert::same($client->recvString(), 'pong');
+
+$thread->send('bye');
+Assert::same($thread->join(), 42);
+Assert::false($thread->isRunning());
+
+try {
+    $thread->send('dead');
+    echo "Never here\n";
+} catch (ThreadException $exception) {
+    Assert::same($exception->getCode(), Swow\Errno::ECLOSED);
+}
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
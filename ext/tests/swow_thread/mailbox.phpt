@@ -0,0 +1,63 @@
+--TEST--
+swow_thread: mailbox
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if(!PHP_ZTS, 'ZTS is required');
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Errno;
+use Swow\Sync\WaitReference;
+use Swow\Thread;
+use Swow\ThreadException;
+
+// nothing in mailbox
+try {
+    Thread::receive(10);
+    echo "Never here\n";
+} catch (ThreadException $exception) {
+    Assert::same($exception->getCode(), Errno::ETIMEDOUT);
+}
+
+$thread = new Thread(__DIR__ . '/child.inc', ['name' => 'child', 'status' => 0]);
+
+// a burst of messages is consumed by multiple coroutines waiting on the same mailbox
+const C = 4;
+const N = 256;
+$received = [];
+$wr = new WaitReference();
+for ($c = 0; $c < C; $c++) {
+    Coroutine::run(static function () use (&$received, $wr): void {
+        for ($n = 0; $n < N / C; $n++) {
+            [$name, $message] = Thread::receive();
+            Assert::same($name, 'child');
+            $received[] = $message;
+        }
+    });
+}
+for ($n = 0; $n < N; $n++) {
+    $thread->send($n);
+}
+WaitReference::wait($wr);
+sort($received);
+Assert::same($received, range(0, N - 1));
+
+// mailbox is empty again
+try {
+    Thread::receive(0);
+    echo "Never here\n";
+} catch (ThreadException $exception) {
+    Assert::same($exception->getCode(), Errno::ETIMEDOUT);
+}
+
+$thread->send('bye');
+Assert::same($thread->join(), 0);
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
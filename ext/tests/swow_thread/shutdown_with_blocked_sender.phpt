@@ -0,0 +1,24 @@
+--TEST--
+swow_thread: parent shuts down while child is blocked on its full mailbox
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if(!PHP_ZTS, 'ZTS is required');
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Thread;
+
+$thread = new Thread(__DIR__ . '/flood.inc');
+Assert::same(Thread::receive(), 0);
+// let the child fill up the mailbox and block in send()
+msleep(100);
+
+// child is not joined, runtime shutdown must close mailbox and wait for it without deadlock
+echo "Done\n";
+?>
+--EXPECT--
+Done
+Child: mailbox closed
@@ -0,0 +1,40 @@
+--TEST--
+swow_time: concurrent sleeps wake up in order
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Sync\WaitReference;
+
+$wr = new WaitReference();
+$durations = range(1, TEST_MAX_REQUESTS);
+shuffle($durations);
+$wakeups = [];
+foreach ($durations as $duration) {
+    Coroutine::run(static function () use ($duration, &$wakeups, $wr): void {
+        Assert::same(msleep($duration * 5), 0);
+        $wakeups[] = $duration;
+    });
+}
+/* long sleep which is broken in the middle */
+$coroutine = Coroutine::run(static function (): void {
+    $remaining = msleep(60 * 1000);
+    Assert::greaterThan($remaining, 0);
+    Assert::lessThanEq($remaining, 60 * 1000);
+});
+WaitReference::wait($wr);
+$coroutine->resume();
+
+$sorted = $wakeups;
+sort($sorted);
+Assert::same($wakeups, $sorted);
+
+echo "Done\n";
+?>
+--EXPECT--
+Done
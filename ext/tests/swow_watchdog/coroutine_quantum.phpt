@@ -0,0 +1,89 @@
+--TEST--
+swow_watchdog: per-coroutine quantum and threshold
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if_in_valgrind();
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Watchdog;
+
+function busy(int $milliseconds): void
+{
+    $end = hrtime(true) + $milliseconds * 1000 * 1000;
+    while (hrtime(true) < $end);
+}
+
+$coroutine = new Coroutine(static function (): void { });
+Assert::same($coroutine->getWatchdogQuantum(), 0);
+Assert::same($coroutine->getWatchdogThreshold(), 0);
+Assert::same($coroutine->setWatchdogQuantum(-100), $coroutine);
+Assert::same($coroutine->getWatchdogQuantum(), -1);
+// it is less than the timer resolution
+Assert::same($coroutine->setWatchdogQuantum(1), $coroutine);
+Assert::same($coroutine->getWatchdogQuantum(), 1 * 1000 * 1000);
+Assert::same($coroutine->setWatchdogThreshold(100 * 1000 * 1000), $coroutine);
+Assert::same($coroutine->getWatchdogThreshold(), 100 * 1000 * 1000);
+$coroutine->resume();
+
+$alerts = [];
+Watchdog::run(1 * 1000 * 1000, 0, static function () use (&$alerts): void {
+    $id = Coroutine::getCurrent()->getId();
+    $alerts[$id] = ($alerts[$id] ?? 0) + 1;
+    sleep(0);
+});
+
+// it is preempted and resume() returns before it is done
+$preempted = new Coroutine(static fn() => busy(50));
+$preempted->resume();
+Assert::true($preempted->isAlive());
+Assert::greaterThan($alerts[$preempted->getId()], 0);
+while ($preempted->isAlive()) {
+    sleep(0);
+}
+
+// it is exempted from watchdog and runs until it is done
+$exempted = new Coroutine(static fn() => busy(50));
+$exempted->setWatchdogQuantum(-1);
+$exempted->resume();
+Assert::false($exempted->isAlive());
+Assert::keyNotExists($alerts, $exempted->getId());
+
+// it is allowed to run longer than the watchdog quantum
+$tolerated = new Coroutine(static fn() => busy(50));
+$tolerated->setWatchdogQuantum(20 * 1000 * 1000);
+$tolerated->resume();
+Assert::true($tolerated->isAlive());
+Assert::lessThan($alerts[$tolerated->getId()], $alerts[$preempted->getId()]);
+while ($tolerated->isAlive()) {
+    sleep(0);
+}
+
+Watchdog::stop();
+
+// it is checked at the granularity of its own quantum which is shorter than the watchdog one
+Watchdog::run(1000 * 1000 * 1000, 0, static function () use (&$alerts): void {
+    $id = Coroutine::getCurrent()->getId();
+    $alerts[$id] = ($alerts[$id] ?? 0) + 1;
+    sleep(0);
+});
+$strict = new Coroutine(static fn() => busy(200));
+$strict->setWatchdogQuantum(5 * 1000 * 1000);
+$strict->resume();
+Assert::true($strict->isAlive());
+Assert::greaterThan($alerts[$strict->getId()], 0);
+while ($strict->isAlive()) {
+    sleep(0);
+}
+
+Watchdog::stop();
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
@@ -0,0 +1,185 @@
+--TEST--
+swow_websocket: native frame codec
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Buffer;
+use Swow\Coroutine;
+use Swow\Errno;
+use Swow\Socket;
+use Swow\SocketException;
+use Swow\WebSocket\Opcode;
+use Swow\WebSocket\Status;
+use Swow\WebSocket\WebSocket;
+
+/** @return Socket[] */
+function createPair(string $extensions = '', int $clientFlags = WebSocket::CODEC_FLAG_DEFAULT): array
+{
+    $server = new Socket(Socket::TYPE_TCP);
+    $server->bind('127.0.0.1')->listen();
+    $client = new Socket(Socket::TYPE_TCP);
+    $client->connect($server->getSockAddress(), $server->getSockPort());
+    $connection = $server->accept();
+    $server->close();
+    $connection->enableWebSocket(extensions: $extensions);
+    $client->enableWebSocket($clientFlags | WebSocket::CODEC_FLAG_CLIENT, $extensions);
+
+    return [$connection, $client];
+}
+
+/* build a masked frame as what client sends */
+function buildFrame(int $opcode, string $payload, bool $fin = true): string
+{
+    $maskingKey = "\x12\x9a\x5c\xf0";
+    return chr(($fin ? 0x80 : 0) | $opcode) . chr(0x80 | strlen($payload)) . $maskingKey . WebSocket::mask($payload, maskingKey: $maskingKey);
+}
+
+$extensionsList = [''];
+$response = WebSocket::negotiateDeflate('x-unknown, ' . WebSocket::DEFLATE_DEFAULT_OFFER);
+if ($response !== null) {
+    Assert::same($response, WebSocket::DEFLATE_EXTENSION_NAME);
+    $extensionsList[] = $response;
+    $response = WebSocket::negotiateDeflate('permessage-deflate; client_no_context_takeover; server_no_context_takeover; server_max_window_bits=10');
+    Assert::same($response, 'permessage-deflate; server_no_context_takeover; client_no_context_takeover; server_max_window_bits=10');
+    $extensionsList[] = $response;
+}
+Assert::null(WebSocket::negotiateDeflate('permessage-deflate; unknown_param'));
+
+// messages are reassembled and inflated as they were
+$random = getRandomBytes(256);
+foreach ($extensionsList as $extensions) {
+    [$connection, $client] = createPair($extensions);
+    foreach ([0, 1, 125, 126, 65535, 65536, 1024 * 1024] as $length) {
+        $data = substr(str_repeat($random, intdiv($length, strlen($random)) + 1), 0, $length);
+        foreach ([[$client, $connection], [$connection, $client]] as [$sender, $receiver]) {
+            Coroutine::run(static function () use ($sender, $data): void {
+                $sender->sendWebSocketMessage($data, Opcode::BINARY);
+            });
+            $buffer = new Buffer(0);
+            Assert::same($receiver->recvWebSocketMessage($buffer), Opcode::BINARY);
+            Assert::same($buffer->toString(), $data);
+        }
+    }
+    // the same message is sent twice to check context takeover
+    $text = str_repeat("h\u{e9}llo \u{4e16}\u{754c} ", 16);
+    $buffer = new Buffer(0);
+    for ($n = 0; $n < 2; $n++) {
+        $client->sendWebSocketMessage($text);
+        Assert::same($connection->recvWebSocketMessage($buffer), Opcode::TEXT);
+        $connection->sendWebSocketMessage($text);
+        Assert::same($client->recvWebSocketMessage($buffer), Opcode::TEXT);
+    }
+    Assert::same($buffer->toString(), str_repeat($text, 4));
+    $client->close();
+    $connection->close();
+}
+
+// fragmented message, ping in the middle of it is answered automatically
+[$connection, $client] = createPair(clientFlags: WebSocket::CODEC_FLAG_NONE);
+$client->send(buildFrame(Opcode::TEXT, "h\xc3", false));
+$client->send(buildFrame(Opcode::PING, 'ping'));
+$client->send(buildFrame(Opcode::CONTINUATION, "\xa9l", false));
+$client->send(buildFrame(Opcode::CONTINUATION, 'lo'));
+$buffer = new Buffer(0);
+Assert::same($connection->recvWebSocketMessage($buffer), Opcode::TEXT);
+Assert::same($buffer->toString(), "h\u{e9}llo");
+// client does not drop pong without CODEC_FLAG_AUTO_PONG
+Assert::same($client->recvWebSocketMessage($buffer), Opcode::PONG);
+Assert::same($client->getWebSocketControlPayload(), 'ping');
+
+// close is answered automatically
+$client->sendWebSocketClose(Status::NORMAL_CLOSURE, 'bye');
+Assert::same($connection->recvWebSocketMessage($buffer), Opcode::CLOSE);
+Assert::same($connection->getWebSocketControlPayload(), pack('n', Status::NORMAL_CLOSURE) . 'bye');
+Assert::same($client->recvWebSocketMessage($buffer), Opcode::CLOSE);
+Assert::same($client->getWebSocketControlPayload(), pack('n', Status::NORMAL_CLOSURE));
+try {
+    $client->sendWebSocketMessage('foo');
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::EPIPE);
+}
+$client->close();
+$connection->close();
+
+// protocol errors are reported to peer by close frame
+$cases = [
+    [buildFrame(Opcode::TEXT, "\xc0\xaf"), Status::INVALID_FRAME_PAYLOAD_DATA, Errno::EILSEQ],
+    [buildFrame(Opcode::CONTINUATION, 'foo'), Status::PROTOCOL_ERROR, Errno::EPROTO],
+    [buildFrame(Opcode::PING, 'foo', false), Status::PROTOCOL_ERROR, Errno::EPROTO],
+    [buildFrame(Opcode::BINARY, str_repeat('x', 100)), Status::MESSAGE_TOO_BIG, Errno::EMSGSIZE],
+    ["\x81\x03foo" /* not masked */, Status::PROTOCOL_ERROR, Errno::EPROTO],
+];
+foreach ($cases as [$frame, $status, $errno]) {
+    $server = new Socket(Socket::TYPE_TCP);
+    $server->bind('127.0.0.1')->listen();
+    $client = new Socket(Socket::TYPE_TCP);
+    $client->connect($server->getSockAddress(), $server->getSockPort());
+    $connection = $server->accept()->enableWebSocket(maxMessageLength: 64);
+    $client->enableWebSocket(WebSocket::CODEC_FLAG_CLIENT);
+    $client->send($frame);
+    try {
+        $connection->recvWebSocketMessage(new Buffer(0));
+        echo "Never here\n";
+    } catch (SocketException $exception) {
+        Assert::same($exception->getCode(), $errno);
+    }
+    Assert::same($client->recvWebSocketMessage(new Buffer(0)), Opcode::CLOSE);
+    Assert::same($client->getWebSocketControlPayload(), pack('n', $status));
+    $client->close();
+    $connection->close();
+    $server->close();
+}
+
+// message length is limited by default, neither announced length nor inflated data can exceed it
+$frames = ["\x82\xff" . pack('J', WebSocket::DEFAULT_MAX_MESSAGE_LENGTH + 1) . "\x12\x9a\x5c\xf0"];
+foreach (array_slice($extensionsList, 1, 1) as $extensions) {
+    $frames[$extensions] = str_repeat("\0", WebSocket::DEFAULT_MAX_MESSAGE_LENGTH + 1);
+}
+foreach ($frames as $extensions => $frame) {
+    [$connection, $client] = createPair(is_string($extensions) ? $extensions : '');
+    if (is_string($extensions)) {
+        Coroutine::run(static function () use ($client, $frame): void {
+            $client->sendWebSocketMessage($frame, Opcode::BINARY);
+        });
+    } else {
+        $client->send($frame);
+    }
+    try {
+        $connection->recvWebSocketMessage(new Buffer(0));
+        echo "Never here\n";
+    } catch (SocketException $exception) {
+        Assert::same($exception->getCode(), Errno::EMSGSIZE);
+    }
+    Assert::same($client->recvWebSocketMessage(new Buffer(0)), Opcode::CLOSE);
+    Assert::same($client->getWebSocketControlPayload(), pack('n', Status::MESSAGE_TOO_BIG));
+    $client->close();
+    $connection->close();
+}
+
+// misuse
+$socket = new Socket(Socket::TYPE_TCP);
+try {
+    $socket->recvWebSocketMessage(new Buffer(0));
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::EMISUSE);
+}
+$socket->enableWebSocket();
+try {
+    $socket->enableWebSocket();
+    echo "Never here\n";
+} catch (SocketException $exception) {
+    Assert::same($exception->getCode(), Errno::EMISUSE);
+}
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
@@ -0,0 +1,125 @@
+--TEST--
+swow_websocket: mask implementations, unmaskTo and UTF-8 validation
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Buffer;
+use Swow\WebSocket\WebSocket;
+
+function maskByBytes(string $data, string $maskingKey, int $index = 0): string
+{
+    $masked = '';
+    for ($n = 0; $n < strlen($data); $n++) {
+        $masked .= $data[$n] ^ $maskingKey[($index + $n) % WebSocket::MASKING_KEY_LENGTH];
+    }
+    return $masked;
+}
+
+$maskingKey = "\x12\x9a\x5c\xf0";
+$data = getRandomBytes(304);
+$default = WebSocket::getMaskImplementation();
+
+$implementations = [];
+foreach (['avx512', 'avx2', 'sse2', 'neon', 'scalar'] as $implementation) {
+    if (WebSocket::setMaskImplementation($implementation)) {
+        Assert::same(WebSocket::getMaskImplementation(), $implementation);
+        $implementations[] = $implementation;
+    }
+}
+Assert::oneOf('scalar', $implementations);
+Assert::oneOf($default, $implementations);
+Assert::false(WebSocket::setMaskImplementation('unknown'));
+
+foreach ($implementations as $implementation) {
+    WebSocket::setMaskImplementation($implementation);
+    foreach ([0, 1, 7, 15, 16, 17, 31, 32, 63, 64, 65, 129, 255, 299] as $length) {
+        foreach ([0, 1, 3] as $start) {
+            foreach ([0, 1, 2, 5] as $index) {
+                $expected = maskByBytes(substr($data, $start, $length), $maskingKey, $index);
+                $masked = WebSocket::mask($data, $start, $length, $maskingKey, $index);
+                Assert::same($masked, $expected);
+                $buffer = new Buffer(0);
+                $buffer->append($expected);
+                WebSocket::unmask($buffer, 0, -1, $maskingKey, $index);
+                Assert::same($buffer->toString(), substr($data, $start, $length));
+                $buffer = new Buffer(0);
+                $buffer->append('head');
+                Assert::same(WebSocket::unmaskTo($buffer, $masked, 0, -1, $maskingKey, $index), $length);
+                Assert::same($buffer->toString(), 'head' . substr($data, $start, $length));
+            }
+        }
+    }
+}
+WebSocket::setMaskImplementation($default);
+
+// copy without masking key
+$buffer = new Buffer(0);
+Assert::same(WebSocket::unmaskTo($buffer, 'foobar', 3), 3);
+Assert::same($buffer->toString(), 'bar');
+
+// unmask and validate UTF-8 at the same time
+$text = str_repeat("h\u{e9}llo \u{4e16}\u{754c} \u{1f600}!", 1000);
+$masked = WebSocket::mask($text, maskingKey: $maskingKey);
+$buffer = new Buffer(0);
+$utf8State = WebSocket::UTF8_ACCEPT;
+WebSocket::unmaskTo($buffer, $masked, maskingKey: $maskingKey, utf8State: $utf8State);
+Assert::same($utf8State, WebSocket::UTF8_ACCEPT);
+Assert::same($buffer->toString(), $text);
+
+// fragments split in the middle of a character
+$utf8State = null;
+$buffer = new Buffer(0);
+$split = strpos($text, "\u{1f600}") + 2;
+WebSocket::unmaskTo($buffer, $masked, 0, $split, $maskingKey, 0, $utf8State);
+Assert::notSame($utf8State, WebSocket::UTF8_ACCEPT);
+Assert::notSame($utf8State, WebSocket::UTF8_REJECT);
+WebSocket::unmaskTo($buffer, $masked, $split, -1, $maskingKey, $split, $utf8State);
+Assert::same($utf8State, WebSocket::UTF8_ACCEPT);
+Assert::same($buffer->toString(), $text);
+
+// invalid state is rejected (it is used as the index of DFA table)
+foreach ([-12, 1, 11, 108, PHP_INT_MAX] as $invalidState) {
+    foreach ([true, false] as $inPlace) {
+        $utf8State = $invalidState;
+        try {
+            if ($inPlace) {
+                WebSocket::unmask(new Buffer(0), maskingKey: $maskingKey, utf8State: $utf8State);
+            } else {
+                WebSocket::unmaskTo(new Buffer(0), $masked, maskingKey: $maskingKey, utf8State: $utf8State);
+            }
+            echo "Never here\n";
+        } catch (ValueError $error) {
+            Assert::contains($error->getMessage(), 'UTF-8 state');
+        }
+        Assert::same($utf8State, $invalidState);
+    }
+}
+
+// in place
+$buffer = new Buffer(0);
+$buffer->append($masked);
+$utf8State = WebSocket::UTF8_ACCEPT;
+WebSocket::unmask($buffer, maskingKey: $maskingKey, utf8State: $utf8State);
+Assert::same($utf8State, WebSocket::UTF8_ACCEPT);
+Assert::same($buffer->toString(), $text);
+
+// invalid UTF-8 is still unmasked completely
+foreach (["\xff", "\xc0\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80"] as $invalid) {
+    $invalidText = substr($text, 0, 5000) . $invalid . substr($text, 0, 5000);
+    $buffer = new Buffer(0);
+    $utf8State = WebSocket::UTF8_ACCEPT;
+    WebSocket::unmaskTo($buffer, WebSocket::mask($invalidText, maskingKey: $maskingKey), maskingKey: $maskingKey, utf8State: $utf8State);
+    Assert::same($utf8State, WebSocket::UTF8_REJECT);
+    Assert::same($buffer->toString(), $invalidText);
+}
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
@@ -0,0 +1,52 @@
+--TEST--
+swow_websocket: client masking keys are not repeated
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Socket;
+use Swow\WebSocket\Opcode;
+use Swow\WebSocket\WebSocket;
+
+// more than one batch of keys are fetched from CSPRNG
+const N = 100;
+
+$server = new Socket(Socket::TYPE_TCP);
+$server->bind('127.0.0.1')->listen();
+$client = new Socket(Socket::TYPE_TCP);
+$client->connect($server->getSockAddress(), $server->getSockPort());
+$connection = $server->accept();
+$server->close();
+$client->enableWebSocket(WebSocket::CODEC_FLAG_DEFAULT | WebSocket::CODEC_FLAG_CLIENT);
+
+Coroutine::run(static function () use ($client): void {
+    for ($n = 0; $n < N; $n++) {
+        $client->sendWebSocketMessage('x', Opcode::BINARY);
+    }
+});
+
+$maskingKeys = [];
+for ($n = 0; $n < N; $n++) {
+    // FIN|BINARY, MASK|1, masking key, masked payload
+    $frame = $connection->readString(2 + 4 + 1);
+    Assert::same($frame[0], "\x82");
+    Assert::same($frame[1], "\x81");
+    $maskingKey = substr($frame, 2, 4);
+    Assert::same(WebSocket::mask(substr($frame, 6), maskingKey: $maskingKey), 'x');
+    $maskingKeys[] = $maskingKey;
+}
+// a collision of 100 random 32-bit keys is about 1e-6
+Assert::same(count(array_unique($maskingKeys)), N);
+$client->close();
+$connection->close();
+
+echo "Done\n";
+
+?>
+--EXPECT--
+Done
@@ -0,0 +1,83 @@
+--TEST--
+swow_work: pool stats and digest offload
+--SKIPIF--
+<?php
+require __DIR__ . '/../include/skipif.php';
+skip_if(!Swow\Extension::isBuiltWith('openssl'), 'extension must be built with OpenSSL');
+?>
+--FILE--
+<?php
+require __DIR__ . '/../include/bootstrap.php';
+
+use Swow\Coroutine;
+use Swow\Sync\WaitReference;
+use Swow\Work;
+
+// pools
+foreach ([Work::KIND_CPU, Work::KIND_FAST_IO, Work::KIND_SLOW_IO] as $kind) {
+    Assert::greaterThanEq(Work::getPoolSize($kind), 1);
+}
+$size = Work::getPoolSize(Work::KIND_CPU);
+Work::setPoolSize(Work::KIND_CPU, 2);
+Assert::same(Work::getPoolSize(Work::KIND_CPU), 2);
+try {
+    Work::setPoolSize(Work::KIND_CPU, 0);
+    echo "Never here\n";
+} catch (ValueError $error) {
+    echo $error->getMessage(), "\n";
+}
+try {
+    Work::getPoolSize(100);
+    echo "Never here\n";
+} catch (ValueError $error) {
+    echo $error->getMessage(), "\n";
+}
+
+// digests are the same as the ones computed in place
+Assert::same(Work::hash('sha256', 'foo'), hash('sha256', 'foo'));
+Assert::same(Work::hash('md5', 'foo', true), md5('foo', true));
+$data = ['a' => 'foo', 'b' => 'bar', 3 => '', 4 => str_repeat('x', 1024 * 1024)];
+Assert::same(Work::hashMany('sha1', $data), array_map('sha1', $data));
+Assert::same(Work::hashMany('sha1', []), []);
+try {
+    Work::hash('unknown', 'foo');
+    echo "Never here\n";
+} catch (ValueError $error) {
+    echo $error->getMessage(), "\n";
+}
+foreach ([[0, false], [0, true], [7, false], [20, true]] as [$length, $binary]) {
+    Assert::same(
+        Work::pbkdf2('sha256', 'password', 'salt', 1000, $length, $binary),
+        hash_pbkdf2('sha256', 'password', 'salt', 1000, $length, $binary)
+    );
+}
+
+// concurrent batches
+$wr = new WaitReference();
+for ($c = 0; $c < TEST_MAX_CONCURRENCY_LOW; $c++) {
+    Coroutine::run(static function () use ($c, $wr): void {
+        $data = [];
+        for ($n = 0; $n < 32; $n++) {
+            $data[] = "{$c}-{$n}";
+        }
+        Assert::same(Work::hashMany('sha256', $data), array_map(static fn (string $s): string => hash('sha256', $s), $data));
+    });
+}
+WaitReference::wait($wr);
+
+$stats = Work::getPoolStats(Work::KIND_CPU);
+Assert::lessThanEq($stats['threads'], 2);
+Assert::same($stats['queued'], 0);
+Assert::same($stats['running'], 0);
+Assert::greaterThanEq($stats['completed'], TEST_MAX_CONCURRENCY_LOW * 32);
+Assert::greaterThanEq($stats['max_run_time'], 0);
+
+Work::setPoolSize(Work::KIND_CPU, $size);
+
+echo "Done\n";
+?>
+--EXPECT--
+Swow\Work::setPoolSize(): Argument #2 ($size) must be between 1 and 1024
+Swow\Work::getPoolSize(): Argument #1 ($kind) must be one of Swow\Work::KIND_*
+Swow\Work::hash(): Argument #1 ($algo) must be a valid hashing algorithm
+Done
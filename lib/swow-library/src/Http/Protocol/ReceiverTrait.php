@@ -26,19 +26,21 @@ use Swow\Http\Parser as HttpParser;
 use Swow\Http\ParserException;
 use Swow\Http\Status as HttpStatus;
 use Swow\SocketException;
+use Swow\WebSocket\Opcode as WebSocketOpcode;
 use Swow\WebSocket\WebSocket;
 use ValueError;
 
 use function array_filter;
 use function array_map;
-use function count;
 use function explode;
 use function fopen;
 use function fwrite;
 use function implode;
 use function in_array;
+use function min;
 use function parse_str;
 use function sprintf;
+use function str_contains;
 use function strcasecmp;
 use function strtolower;
 use function sys_get_temp_dir;
@@ -73,19 +75,22 @@ trait ReceiverTrait
 
     protected bool $autoUnmask = true;
 
+    protected bool $utf8Validation = false;
+
+    /** UTF-8 validation state of the current text message, it is null if it is not a text message */
+    protected ?int $utf8State = null;
+
     protected int $recvMessageTimeout = -1;
 
     protected bool $shouldKeepAlive = false;
 
+    protected bool $releaseIdleBuffer = false;
+
     protected function __constructReceiver(int $type, int $events): void
     {
         $this->buffer = new Buffer(Buffer::COMMON_SIZE);
+        /* request/status line and headers are parsed by HttpParser::parseHead() */
         $requiredEvents =
-            HttpParser::EVENT_URL |
-            HttpParser::EVENT_STATUS |
-            HttpParser::EVENT_HEADER_FIELD |
-            HttpParser::EVENT_HEADER_VALUE |
-            HttpParser::EVENT_HEADERS_COMPLETE |
             HttpParser::EVENT_CHUNK_HEADER |
             HttpParser::EVENT_CHUNK_COMPLETE |
             HttpParser::EVENT_BODY |
@@ -161,6 +166,25 @@ trait ReceiverTrait
         return $this;
     }
 
+    /**
+     * @return bool Whether validate payload data of WebSocket text messages as UTF-8
+     */
+    public function isUtf8Validation(): bool
+    {
+        return $this->utf8Validation;
+    }
+
+    /**
+     * @param bool $enable If true, payload data of WebSocket text messages will be validated as UTF-8
+     * while it is being unmasked, ProtocolException will be thrown if it is invalid
+     */
+    public function setUtf8Validation(bool $enable): static
+    {
+        $this->utf8Validation = $enable;
+
+        return $this;
+    }
+
     public function getRecvMessageTimeout(): int
     {
         return $this->recvMessageTimeout;
@@ -176,6 +200,29 @@ trait ReceiverTrait
         return $this;
     }
 
+    /**
+     * @return bool Whether release the buffer while connection is idle
+     */
+    public function isReleaseIdleBuffer(): bool
+    {
+        return $this->releaseIdleBuffer;
+    }
+
+    /**
+     * @param bool $enable If true, the buffer will be recycled once all received data has been parsed,
+     * and it will be re-acquired after connection becomes readable, so idle keep-alive (or WebSocket)
+     * connections do not hold it, use it with Buffer::enablePool() to reuse the memory of buffers
+     */
+    public function setReleaseIdleBuffer(bool $enable): static
+    {
+        $this->releaseIdleBuffer = $enable;
+        if ($enable && $this->buffer->isEmpty()) {
+            $this->buffer->recycle();
+        }
+
+        return $this;
+    }
+
     public function shouldKeepAlive(): bool
     {
         return $this->shouldKeepAlive;
@@ -211,7 +258,6 @@ trait ReceiverTrait
         /* }}} */
         /* HTTP related values {{{ */
         $uriOrReasonPhrase = '';
-        $headerName = '';
         $formDataName = '';
         $fileName = '';
         /** @var array<string, array<string>> $headers */
@@ -220,7 +266,6 @@ trait ReceiverTrait
         $headerNames = [];
         $shouldKeepAlive = false;
         $contentLength = 0;
-        $headerLength = 0;
         $headersCompleted = false;
         $isChunked = false;
         $currentChunkLength = 0;
@@ -259,12 +304,83 @@ trait ReceiverTrait
                             $readTimeout = $timeout - $timePassed;
                         }
                     }
-                    $this->recvData($buffer, $buffer->getLength(), timeout: $readTimeout);
+                    if ($buffer->isAvailable()) {
+                        $this->recvData($buffer, $buffer->getLength(), timeout: $readTimeout);
+                    } else {
+                        $this->recvDataToIdleBuffer($readTimeout);
+                    }
                     /** @noinspection PhpUnusedLocalVariableInspection (on the safe-side) */
                     $expectMoreData = false;
                 }
                 // TODO: call $parser->finished() if connection error?
                 while (true) {
+                    if (!$headersCompleted) {
+                        /* parse request/status line and all headers at once */
+                        $head = $parser->parseHead($buffer, $parsedOffset);
+                        if ($head === null) {
+                            $unparsedLength = $buffer->getLength() - $parsedOffset;
+                            if ($unparsedLength > $maxHeaderLength) {
+                                $requestLineCompleted = str_contains($buffer->read($parsedOffset, $unparsedLength), "\n");
+                                throw new ProtocolException($requestLineCompleted ? HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE : HttpStatus::REQUEST_URI_TOO_LARGE);
+                            }
+                            $buffer->truncateFrom($parsedOffset);
+                            if ($buffer->isFull()) {
+                                /* the whole head must be in buffer, grow it up to max buffer size */
+                                $bufferSize = $buffer->getSize();
+                                $maxBufferSize = $this->getMaxBufferSize();
+                                if ($bufferSize >= $maxBufferSize) {
+                                    throw new ParserException('Buffer is full and unable to continue parsing');
+                                }
+                                $buffer->realloc(min($bufferSize * 2, $maxBufferSize));
+                            }
+                            $parsedOffset = 0;
+                            $expectMoreData = true;
+                            break; /* goto recv more data */
+                        }
+                        $parsedLength = $head['headLength'];
+                        if ($parsedLength > $maxHeaderLength) {
+                            throw new ProtocolException(HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE);
+                        }
+                        $parsedOffset += $parsedLength;
+                        $event = HttpParser::EVENT_HEADERS_COMPLETE;
+                        $uriOrReasonPhrase = $isServerRequest ? $head['uri'] : $head['reasonPhrase'];
+                        $headers = $head['headers'];
+                        $headerNames = $head['headerNames'];
+                        $headersCompleted = true;
+                        $shouldKeepAlive = $head['shouldKeepAlive'];
+                        if ($head['isChunked']) {
+                            $isChunked = true;
+                        } else {
+                            $contentLength = $head['contentLength'];
+                            if ($contentLength > $maxContentLength) {
+                                throw new ProtocolException(HttpStatus::REQUEST_ENTITY_TOO_LARGE);
+                            }
+                        }
+                        if ($head['isMultipart']) {
+                            $isMultipart = true;
+                            if ($this->preserveBodyData) {
+                                $body = new Buffer($contentLength);
+                                $unparsedLength = $buffer->getLength() - $parsedOffset;
+                                if ($contentLength < $parsedLength) {
+                                    $body->append($buffer, $parsedOffset, $contentLength);
+                                    $parsedOffset += $contentLength;
+                                } else {
+                                    $body->append($buffer, $parsedOffset, $unparsedLength);
+                                    $parsedOffset += $unparsedLength;
+                                    $neededLength = $contentLength - $unparsedLength;
+                                    if ($neededLength > 0) {
+                                        $this->read($body, $unparsedLength, $neededLength);
+                                    }
+                                }
+                                /* Notice: There may be some risks associated with doing so,
+                                 * but it's the easiest way...
+                                 * $parsedOffset is for $body instead of $thisBuffer from now. */
+                                $thisBufferParsedOffset = $parsedOffset;
+                                $buffer = $body;
+                                $parsedOffset = 0;
+                            }
+                        }
+                    }
                     $previousEvent = $event;
                     $parsedLength = $parser->execute($buffer, $parsedOffset);
                     $parsedOffset += $parsedLength;
@@ -272,16 +388,10 @@ trait ReceiverTrait
                     if ($event & HttpParser::EVENT_FLAG_DATA) {
                         $dataOffset = $parser->getDataOffset();
                         $dataLength = $parser->getDataLength();
-                        if (!$headersCompleted || ($isMultipart && !$multiPartHeadersCompleted)) {
+                        if ($isMultipart && !$multiPartHeadersCompleted) {
                             $data = $buffer->read($dataOffset, $dataLength);
                         }
                     }
-                    if (!$headersCompleted) {
-                        $headerLength += $parsedLength;
-                        if ($headerLength > $maxHeaderLength) {
-                            throw new ProtocolException(empty($headerName) ? HttpStatus::REQUEST_URI_TOO_LARGE : HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE);
-                        }
-                    }
                     if ($event === HttpParser::EVENT_NONE) {
                         if ($buffer !== $thisBuffer) {
                             throw new ParserException('Unexpected EVENT_NONE, buffer is dummy one');
@@ -316,69 +426,7 @@ trait ReceiverTrait
                         }
                         break 2;
                     }
-                    if (!$headersCompleted) {
-                        switch ($event) {
-                            case HttpParser::EVENT_HEADER_FIELD:
-                                if ($event !== $previousEvent) {
-                                    $headerName = $data;
-                                } else {
-                                    $headerName .= $data;
-                                }
-                                break;
-                            case HttpParser::EVENT_HEADER_VALUE:
-                                if ($event !== $previousEvent) {
-                                    $headers[$headerName][] = $data;
-                                    $headerNames[strtolower($headerName)] = $headerName;
-                                } else {
-                                    $headers[$headerName][count($headers[$headerName]) - 1] .= $data;
-                                }
-                                break;
-                            case HttpParser::EVENT_URL:
-                            case HttpParser::EVENT_STATUS:
-                                if ($event !== $previousEvent) {
-                                    $uriOrReasonPhrase = $data;
-                                } else {
-                                    $uriOrReasonPhrase .= $data;
-                                }
-                                break;
-                            case HttpParser::EVENT_HEADERS_COMPLETE:
-                                $headersCompleted = true;
-                                $shouldKeepAlive = $parser->shouldKeepAlive();
-                                if ($parser->isChunked()) {
-                                    $isChunked = true;
-                                } else {
-                                    $contentLength = $parser->getContentLength();
-                                    if ($contentLength > $maxContentLength) {
-                                        throw new ProtocolException(HttpStatus::REQUEST_ENTITY_TOO_LARGE);
-                                    }
-                                }
-                                if ($parser->isMultipart()) {
-                                    $isMultipart = true;
-                                    if ($this->preserveBodyData) {
-                                        $body = new Buffer($contentLength);
-                                        $unparsedLength = $buffer->getLength() - $parsedOffset;
-                                        if ($contentLength < $parsedLength) {
-                                            $body->append($buffer, $parsedOffset, $contentLength);
-                                            $parsedOffset += $contentLength;
-                                        } else {
-                                            $body->append($buffer, $parsedOffset, $unparsedLength);
-                                            $parsedOffset += $unparsedLength;
-                                            $neededLength = $contentLength - $unparsedLength;
-                                            if ($neededLength > 0) {
-                                                $this->read($body, $unparsedLength, $neededLength);
-                                            }
-                                        }
-                                        /* Notice: There may be some risks associated with doing so,
-                                         * but it's the easiest way...
-                                         * $parsedOffset is for $body instead of $thisBuffer from now. */
-                                        $thisBufferParsedOffset = $parsedOffset;
-                                        $buffer = $body;
-                                        $parsedOffset = 0;
-                                    }
-                                }
-                                break;
-                        }
-                    } elseif ($isMultipart) {
+                    if ($isMultipart) {
                         switch ($event) {
                             case HttpParser::EVENT_MULTIPART_HEADER_FIELD:
                                 if ($event !== $previousEvent) {
@@ -640,7 +688,9 @@ trait ReceiverTrait
         try {
             /* recv header */
             while ($unparsedLength < WebSocket::HEADER_MIN_SIZE) {
-                $unparsedLength += $this->recvData($buffer, $buffer->getLength());
+                $unparsedLength += $buffer->isAvailable() ?
+                    $this->recvData($buffer, $buffer->getLength()) :
+                    $this->recvDataToIdleBuffer();
             }
             $header->write(
                 offset: 0,
@@ -665,10 +715,26 @@ trait ReceiverTrait
             if ($payloadLength > $maxContentLength) {
                 throw new ProtocolException(HttpStatus::REQUEST_ENTITY_TOO_LARGE);
             }
+            $opcode = $header->getOpcode();
+            if ($opcode === WebSocketOpcode::TEXT || $opcode === WebSocketOpcode::BINARY) {
+                $this->utf8State = $opcode === WebSocketOpcode::TEXT && $this->utf8Validation ? WebSocket::UTF8_ACCEPT : null;
+            }
+            $unmask = $header->getMask() && $this->autoUnmask;
+            /* control frames may be injected in the middle of a fragmented message,
+             * and masked data can not be validated if it will not be unmasked */
+            $validateUtf8 = $this->utf8State !== null &&
+                ($opcode === WebSocketOpcode::TEXT || $opcode === WebSocketOpcode::CONTINUATION) &&
+                ($unmask || !$header->getMask());
             if ($payloadLength > 0) {
                 $payloadData = new Buffer($payloadLength);
                 if ($unparsedLength >= $payloadLength) {
-                    $payloadData->append($buffer, $parsedOffset, $payloadLength);
+                    /* unmask (and validate) while copying, data is only traversed once */
+                    $maskingKey = $unmask ? $header->getMaskingKey() : '';
+                    if ($validateUtf8) {
+                        WebSocket::unmaskTo($payloadData, $buffer, $parsedOffset, $payloadLength, $maskingKey, utf8State: $this->utf8State);
+                    } else {
+                        WebSocket::unmaskTo($payloadData, $buffer, $parsedOffset, $payloadLength, $maskingKey);
+                    }
                 } else {
                     $payloadData->append($buffer, $parsedOffset, $unparsedLength);
                     $this->read(
@@ -676,13 +742,27 @@ trait ReceiverTrait
                         offset: $unparsedLength,
                         length: $payloadLength - $unparsedLength
                     );
+                    if ($validateUtf8) {
+                        WebSocket::unmask($payloadData, maskingKey: $unmask ? $header->getMaskingKey() : '', utf8State: $this->utf8State);
+                    } elseif ($unmask) {
+                        WebSocket::unmask($payloadData, maskingKey: $header->getMaskingKey());
+                    }
                 }
                 $parsedOffset += $payloadLength;
-                if ($header->getMask() && $this->autoUnmask) {
-                    WebSocket::unmask($payloadData, maskingKey: $header->getMaskingKey());
+                if ($unmask) {
                     $header->setMaskingKey(''); // drop mask and masking key
                 }
             }
+            if ($validateUtf8) {
+                if ($this->utf8State === WebSocket::UTF8_REJECT ||
+                    ($header->getFin() && $this->utf8State !== WebSocket::UTF8_ACCEPT)) {
+                    $this->utf8State = null;
+                    throw new ProtocolException(HttpStatus::BAD_REQUEST, 'Invalid UTF-8 payload data');
+                }
+                if ($header->getFin()) {
+                    $this->utf8State = null;
+                }
+            }
         } finally {
             $frame->payloadData = $payloadData;
         } /* TODO: with bad message */
@@ -692,8 +772,31 @@ trait ReceiverTrait
         return $frame;
     }
 
+    /**
+     * Wait for connection to become readable without holding the buffer (poll-then-read),
+     * then re-acquire the buffer (from buffer pool if it is enabled) and read data into it.
+     * Notice: peek also reports data which has been buffered by SSL on crypto connections
+     */
+    protected function recvDataToIdleBuffer(?int $timeout = null): int
+    {
+        $buffer = $this->buffer;
+        if ($this->peekString(1, $timeout) === '') {
+            /* timed out or closed by peer, recvData() will report it without waiting again */
+            $timeout = 0;
+        }
+        $buffer->alloc(Buffer::COMMON_SIZE);
+
+        return $this->recvData($buffer, 0, timeout: $timeout);
+    }
+
     protected function updateParsedOffsetAndRecycleBufferSpace(Buffer $buffer, int $parsedOffset): void
     {
+        if ($this->releaseIdleBuffer && $buffer->getLength() === $parsedOffset) {
+            /* All data has been parsed and connection is idle now */
+            $buffer->recycle();
+            $this->parsedOffset = 0;
+            return;
+        }
         if (
             /* All data has been parsed, clear them */
             $buffer->getLength() === $parsedOffset ||
@@ -131,102 +131,116 @@ class EventDriver
             ($this->startHandler)($server);
         }
 
-        while (true) {
-            try {
-                $connection = null;
-                $connection = $server->acceptConnection();
-                if ($connectionHandler !== null) {
-                    $connectionHandler($connection);
-                }
-                Coroutine::run(static function () use ($connection, $requestHandler, $upgradeHandler, $messageHandler, $closeHandler, $exceptionHandler): void {
-                    try {
-                        while (true) {
-                            $request = null;
-                            try {
-                                /** @var ServerRequestPlusInterface $request */
-                                $request = $connection->recvHttpRequest();
-                                if ($requestHandler) {
-                                    $upgradeType = UpgradeType::UPGRADE_TYPE_NONE;
-                                    if ($upgradeHandler !== null || $messageHandler !== null) {
-                                        $upgradeType = Psr7::detectUpgradeType($request);
-                                        if ($upgradeType !== UpgradeType::UPGRADE_TYPE_NONE) {
-                                            if (($upgradeType & UpgradeType::UPGRADE_TYPE_WEBSOCKET) === 0) {
-                                                throw new HttpProtocolException(HttpStatus::BAD_REQUEST, 'Unsupported Upgrade Type');
-                                            }
-                                            if ($upgradeHandler !== null) {
-                                                $upgradeResponse = $upgradeHandler($connection, $request, $upgradeType);
-                                                if ($upgradeResponse !== null && !($upgradeResponse instanceof ResponseInterface)) {
-                                                    $upgradeResponse = static::solveUpgradeResponse($upgradeResponse);
+        /* connections accepted in one round are handled one by one */
+        $connections = [];
+        $connection = null;
+        try {
+            while (true) {
+                try {
+                    $connection = null;
+                    $connections = $connections ?: $server->acceptConnections();
+                    $connection = array_shift($connections);
+                    if ($connectionHandler !== null) {
+                        $connectionHandler($connection);
+                    }
+                    Coroutine::run(static function () use ($connection, $requestHandler, $upgradeHandler, $messageHandler, $closeHandler, $exceptionHandler): void {
+                        try {
+                            while (true) {
+                                $request = null;
+                                try {
+                                    /** @var ServerRequestPlusInterface $request */
+                                    $request = $connection->recvHttpRequest();
+                                    if ($requestHandler) {
+                                        $upgradeType = UpgradeType::UPGRADE_TYPE_NONE;
+                                        if ($upgradeHandler !== null || $messageHandler !== null) {
+                                            $upgradeType = Psr7::detectUpgradeType($request);
+                                            if ($upgradeType !== UpgradeType::UPGRADE_TYPE_NONE) {
+                                                if (($upgradeType & UpgradeType::UPGRADE_TYPE_WEBSOCKET) === 0) {
+                                                    throw new HttpProtocolException(HttpStatus::BAD_REQUEST, 'Unsupported Upgrade Type');
+                                                }
+                                                if ($upgradeHandler !== null) {
+                                                    $upgradeResponse = $upgradeHandler($connection, $request, $upgradeType);
+                                                    if ($upgradeResponse !== null && !($upgradeResponse instanceof ResponseInterface)) {
+                                                        $upgradeResponse = static::solveUpgradeResponse($upgradeResponse);
+                                                    }
                                                 }
                                             }
                                         }
-                                    }
-                                    if ($upgradeType === UpgradeType::UPGRADE_TYPE_NONE) {
-                                        $response = $requestHandler($connection, $request);
-                                        if ($response !== null) {
-                                            if ($response instanceof ResponseInterface) {
-                                                $connection->sendHttpResponse($response);
-                                            } elseif (is_array($response)) {
-                                                $connection->respond(...$response);
-                                            } else {
-                                                $connection->respond($response);
+                                        if ($upgradeType === UpgradeType::UPGRADE_TYPE_NONE) {
+                                            $response = $requestHandler($connection, $request);
+                                            if ($response !== null) {
+                                                if ($response instanceof ResponseInterface) {
+                                                    $connection->sendHttpResponse($response);
+                                                } elseif (is_array($response)) {
+                                                    $connection->respond(...$response);
+                                                } else {
+                                                    $connection->respond($response);
+                                                }
                                             }
-                                        }
-                                    } elseif ($upgradeType & UpgradeType::UPGRADE_TYPE_WEBSOCKET) {
-                                        $connection->upgradeToWebSocket($request, $upgradeResponse ?? null);
-                                        $request = null;
-                                        while (true) {
-                                            $frame = $connection->recvWebSocketFrame();
-                                            $opcode = $frame->getOpcode();
-                                            switch ($opcode) {
-                                                case WebSocketOpcode::PING:
-                                                    $connection->send(WebSocket::PONG_FRAME);
-                                                    break;
-                                                case WebSocketOpcode::PONG:
-                                                    break;
-                                                case WebSocketOpcode::CLOSE:
-                                                    break 3;
-                                                default:
-                                                    $reply = $messageHandler($connection, $frame);
-                                                    if ($reply instanceof WebSocketFrameInterface) {
-                                                        $connection->sendWebSocketFrame($reply);
-                                                    } elseif (Swow\Debug\isStrictStringable($reply)) {
-                                                        $connection->sendWebSocketFrame(
-                                                            Psr7::createWebSocketTextFrame(
-                                                                payloadData: $reply
-                                                            )
-                                                        );
-                                                    }
+                                        } elseif ($upgradeType & UpgradeType::UPGRADE_TYPE_WEBSOCKET) {
+                                            $connection->upgradeToWebSocket($request, $upgradeResponse ?? null);
+                                            $request = null;
+                                            while (true) {
+                                                $frame = $connection->recvWebSocketFrame();
+                                                $opcode = $frame->getOpcode();
+                                                switch ($opcode) {
+                                                    case WebSocketOpcode::PING:
+                                                        $connection->send(WebSocket::PONG_FRAME);
+                                                        break;
+                                                    case WebSocketOpcode::PONG:
+                                                        break;
+                                                    case WebSocketOpcode::CLOSE:
+                                                        break 3;
+                                                    default:
+                                                        $reply = $messageHandler($connection, $frame);
+                                                        if ($reply instanceof WebSocketFrameInterface) {
+                                                            $connection->sendWebSocketFrame($reply);
+                                                        } elseif (Swow\Debug\isStrictStringable($reply)) {
+                                                            $connection->sendWebSocketFrame(
+                                                                Psr7::createWebSocketTextFrame(
+                                                                    payloadData: $reply
+                                                                )
+                                                            );
+                                                        }
+                                                }
                                             }
                                         }
                                     }
+                                } catch (HttpProtocolException $exception) {
+                                    $connection->error($exception->getCode(), $exception->getMessage(), close: true);
+                                    break;
+                                }
+                                if (!$connection->shouldKeepAlive()) {
+                                    break;
                                 }
-                            } catch (HttpProtocolException $exception) {
-                                $connection->error($exception->getCode(), $exception->getMessage(), close: true);
-                                break;
                             }
-                            if (!$connection->shouldKeepAlive()) {
-                                break;
+                        } catch (Exception $exception) {
+                            if ($exceptionHandler !== null) {
+                                $exceptionHandler($connection, $exception);
                             }
+                        } finally {
+                            if ($closeHandler !== null) {
+                                $closeHandler($connection);
+                            }
+                            $connection->close();
                         }
-                    } catch (Exception $exception) {
-                        if ($exceptionHandler !== null) {
-                            $exceptionHandler($connection, $exception);
-                        }
-                    } finally {
-                        if ($closeHandler !== null) {
-                            $closeHandler($connection);
-                        }
-                        $connection->close();
+                    });
+                } catch (CoroutineException|SocketException $exception) {
+                    $connection?->close();
+                    $connection = null;
+                    if (in_array($exception->getCode(), [Errno::EMFILE, Errno::ENFILE, Errno::ENOMEM], true)) {
+                        sleep(1);
+                    } else {
+                        break;
                     }
-                });
-            } catch (CoroutineException|SocketException $exception) {
-                if (in_array($exception->getCode(), [Errno::EMFILE, Errno::ENFILE, Errno::ENOMEM], true)) {
-                    sleep(1);
-                } else {
-                    break;
                 }
             }
+        } finally {
+            /* the handler threw or the server was closed, connections accepted in this round have not been handled yet */
+            $connection?->close();
+            foreach ($connections as $connection) {
+                $connection->close();
+            }
         }
     }
 
@@ -22,6 +22,11 @@ use Swow\Socket;
 use Swow\SocketException;
 use WeakMap;
 
+use function array_push;
+use function array_slice;
+use function count;
+use function min;
+
 class Server extends Socket
 {
     use LimitationTrait;
@@ -34,6 +39,8 @@ class Server extends Socket
 
     protected int $recvMessageTimeout = -1;
 
+    protected bool $releaseIdleBuffer = false;
+
     public function __construct(int $type = self::TYPE_TCP)
     {
         parent::__construct($type);
@@ -57,6 +64,23 @@ class Server extends Socket
         return $this;
     }
 
+    public function isReleaseIdleBuffer(): bool
+    {
+        return $this->releaseIdleBuffer;
+    }
+
+    /**
+     * @param bool $enable If true, connections release their buffers while they are idle,
+     * it is recommended for the server with lots of idle keep-alive (or WebSocket) connections,
+     * see ServerConnection::setReleaseIdleBuffer()
+     */
+    public function setReleaseIdleBuffer(bool $enable): static
+    {
+        $this->releaseIdleBuffer = $enable;
+
+        return $this;
+    }
+
     public function acceptConnection(?int $timeout = null): ServerConnection
     {
         while (true) {
@@ -82,6 +106,56 @@ class Server extends Socket
         return $connection;
     }
 
+    /**
+     * Accept all pending connections (at most $maxCount) in one round
+     *
+     * @return ServerConnection[]
+     */
+    public function acceptConnections(int $maxCount = 64, ?int $timeout = null): array
+    {
+        while (true) {
+            /* connections are created on demand (rather than reserved) so that they always inherit the current configuration,
+             * the batch size is doubled while the previous batch is filled up, so only a few of them would be wasted */
+            $batch = [$this->serverConnectionFactory->createServerConnection($this)];
+            $count = $this->acceptManyTo($batch, $timeout);
+            $connections = [];
+            while (true) {
+                array_push($connections, ...array_slice($batch, 0, $count));
+                $restCount = $maxCount - count($connections);
+                if ($count < count($batch) || $restCount <= 0) {
+                    break;
+                }
+                $batch = [];
+                for ($n = min(count($connections), $restCount); $n > 0; $n--) {
+                    $batch[] = $this->serverConnectionFactory->createServerConnection($this);
+                }
+                try {
+                    $count = $this->acceptManyTo($batch, 0);
+                } catch (SocketException) {
+                    /* no more pending connections, or error which will be reported by the next round */
+                    break;
+                }
+            }
+            $accepted = [];
+            foreach ($connections as $connection) {
+                try {
+                    $connection->addServerParams([
+                        'remote_addr' => $connection->getPeerAddress(),
+                        'remote_port' => $connection->getPeerPort(),
+                    ]);
+                } catch (SocketException) {
+                    /* FIXME: workaround for ENOTCONN error, see acceptConnection() */
+                    continue;
+                }
+                $this->online($connection);
+                $accepted[] = $connection;
+            }
+            if ($accepted) {
+                return $accepted;
+            }
+        }
+    }
+
     protected const BROADCAST_FLAG_NONE = 0;
     protected const BROADCAST_FLAG_RECORD_EXCEPTIONS = 1 << 0;
 
@@ -90,6 +90,7 @@ class ServerConnection extends Socket implements ProtocolTypeInterface
 
         // Inherited server configuration.
         $this->setRecvMessageTimeout($server->getRecvMessageTimeout());
+        $this->setReleaseIdleBuffer($server->isReleaseIdleBuffer());
     }
 
     /**
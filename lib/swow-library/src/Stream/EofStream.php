@@ -16,12 +16,16 @@ namespace Swow\Stream;
 use InvalidArgumentException;
 use Stringable;
 use Swow\Buffer;
+use Swow\Errno;
 use Swow\Socket;
+use Swow\SocketException;
 
 use function is_array;
 use function strlen;
 use function strpos;
 
+use const PHP_INT_MAX;
+
 class EofStream extends Socket
 {
     protected string $eof = "\r\n";
@@ -118,10 +122,22 @@ class EofStream extends Socket
 
     public function recvMessageString(?int $timeout = null): string
     {
-        $buffer = new Buffer(0);
-        $this->recvMessage($buffer, $timeout);
+        $maxMessageLength = $this->maxMessageLength;
+        if (!$this->internalBuffer->isEmpty() || $maxMessageLength === 0) {
+            $buffer = new Buffer(0);
+            $this->recvMessage($buffer, timeout: $timeout);
 
-        return $buffer->toString();
+            return $buffer->toString();
+        }
+        /* scan for eof in the read buffer of socket without copying data to the internal buffer */
+        try {
+            return $this->readUntil($this->eof, $maxMessageLength === PHP_INT_MAX ? -1 : $maxMessageLength, $timeout);
+        } catch (SocketException $exception) {
+            if ($exception->getCode() === Errno::EMSGSIZE) {
+                throw new MessageTooLargeException($this->getReadBufferedLength(), $maxMessageLength);
+            }
+            throw $exception;
+        }
     }
 
     /**
@@ -16,8 +16,10 @@ namespace Swow\Stream;
 use InvalidArgumentException;
 use Stringable;
 use Swow\Buffer;
+use Swow\Errno;
 use Swow\Pack\Format;
 use Swow\Socket;
+use Swow\SocketException;
 
 use function assert;
 use function is_array;
@@ -25,6 +27,8 @@ use function pack;
 use function strlen;
 use function unpack;
 
+use const PHP_INT_MAX;
+
 class LengthStream extends Socket
 {
     protected string $format = Format::UINT32_BE;
@@ -123,10 +127,34 @@ class LengthStream extends Socket
 
     public function recvMessageString(?int $timeout = null): string
     {
-        $buffer = new Buffer(0);
-        $this->recvMessage($buffer, $timeout);
-
-        return $buffer->toString();
+        $maxMessageLength = $this->maxMessageLength;
+        $littleEndian = match ($this->format) {
+            Format::UINT8, Format::UINT16_BE, Format::UINT32_BE, Format::UINT64_BE => false,
+            Format::UINT16_LE, Format::UINT32_LE, Format::UINT64_LE => true,
+            default => null,
+        };
+        if ($littleEndian === null || !$this->internalBuffer->isEmpty() || $maxMessageLength === 0) {
+            $buffer = new Buffer(0);
+            $this->recvMessage($buffer, timeout: $timeout);
+
+            return $buffer->toString();
+        }
+        /* decode the frame in the read buffer of socket without copying data to the internal buffer */
+        try {
+            return $this->readFrame(
+                lengthFieldSize: $this->formatSize,
+                littleEndian: $littleEndian,
+                maxLength: $maxMessageLength === PHP_INT_MAX ? -1 : $maxMessageLength,
+                timeout: $timeout
+            );
+        } catch (SocketException $exception) {
+            if ($exception->getCode() === Errno::EMSGSIZE) {
+                /* the frame is kept in the read buffer, so we can peek the length field */
+                $length = unpack($this->format, $this->peekString($this->formatSize))[1];
+                throw new MessageTooLargeException($length, $maxMessageLength);
+            }
+            throw $exception;
+        }
     }
 
     public function sendMessage(string|Stringable $string, int $start = 0, int $length = -1, ?int $timeout = null): static
@@ -17,9 +17,11 @@ use PHPUnit\Framework\TestCase;
 use Psr\Http\Message\UploadedFileInterface;
 use ReflectionProperty;
 use RuntimeException;
+use Swow\Buffer;
 use Swow\Channel;
 use Swow\Coroutine;
 use Swow\Errno;
+use Swow\Extension;
 use Swow\Http\Http;
 use Swow\Http\Mime\MimeType;
 use Swow\Http\Protocol\ProtocolException as HttpProtocolException;
@@ -31,6 +33,7 @@ use Swow\Psr7\Message\UpgradeType;
 use Swow\Psr7\Message\WebSocketFrame;
 use Swow\Psr7\Psr7;
 use Swow\Psr7\Server\Server;
+use Swow\Psr7\Server\ServerConnection;
 use Swow\Socket;
 use Swow\SocketException;
 use Swow\Sync\WaitReference;
@@ -46,6 +49,7 @@ use function msleep;
 use function putenv;
 use function serialize;
 use function sprintf;
+use function str_contains;
 use function str_repeat;
 use function strlen;
 use function substr;
@@ -319,6 +323,34 @@ final class ServerTest extends TestCase
         $wr::wait($wr);
     }
 
+    public function testHeadLargerThanCommonBufferSize(): void
+    {
+        $maxBufferSize = Buffer::COMMON_SIZE * 4;
+        $headerValue = str_repeat('x', Buffer::COMMON_SIZE * 2);
+
+        $server = new Server();
+        $server->setMaxHeaderLength($maxBufferSize);
+        $server->bind('127.0.0.1')->listen();
+
+        $wr = new WaitReference();
+        Coroutine::run(function () use ($server, $maxBufferSize, $headerValue, $wr): void {
+            $connection = $server->acceptConnection();
+            $connection->setMaxBufferSize($maxBufferSize);
+            $request = $connection->recvHttpRequest();
+            $this->assertSame($headerValue, $request->getHeaderLine('x-large'));
+            $connection->respond((string) $request->getBody());
+        });
+
+        $client = new Client();
+        $client->connect($server->getSockAddress(), $server->getSockPort());
+        $request = Psr7::createRequest(method: 'POST', uri: '/', headers: ['X-Large' => $headerValue], body: Psr7::createStream('Hello Swow'));
+        $response = $client->sendRequest($request);
+        $this->assertSame('Hello Swow', (string) $response->getBody());
+        $client->close();
+
+        $wr::wait($wr);
+    }
+
     public function testBroadcastWebSocketFrame(): void
     {
         $server = new Server();
@@ -475,4 +507,108 @@ final class ServerTest extends TestCase
         $this->assertTrue($requestDup->hasHeader('Content-Type'));
         $this->assertSame('', $requestDup->getHeaderLine('Content-Type'));
     }
-}
+
+    public function testReleaseIdleBuffer(): void
+    {
+        Buffer::enablePool();
+        defer(static function (): void {
+            Buffer::disablePool();
+        });
+        $server = new Server();
+        $server->setReleaseIdleBuffer(true);
+        $server->bind('127.0.0.1')->listen();
+        $wr = new WaitReference();
+        Coroutine::run(function () use ($server, $wr): void {
+            $connection = $server->acceptConnection();
+            $this->assertTrue($connection->isReleaseIdleBuffer());
+            /** @var Buffer $buffer */
+            $buffer = (new ReflectionProperty(ServerConnection::class, 'buffer'))->getValue($connection);
+            for ($n = 0; $n < Testing::$maxRequests; $n++) {
+                $this->assertFalse($buffer->isAvailable());
+                $request = $connection->recvHttpRequest();
+                $this->assertFalse($buffer->isAvailable());
+                $connection->respond($request->getBody());
+            }
+            $connection->upgradeToWebSocket($connection->recvHttpRequest());
+            $this->assertFalse($buffer->isAvailable());
+            $frame = $connection->recvWebSocketFrame();
+            $this->assertFalse($buffer->isAvailable());
+            $connection->sendWebSocketFrame($frame);
+            $exception = null;
+            try {
+                $connection->recvWebSocketFrame();
+            } catch (SocketException $exception) {
+            }
+            $this->assertInstanceOf(SocketException::class, $exception);
+        });
+        $client = new Client();
+        $client->connect($server->getSockAddress(), $server->getSockPort());
+        for ($n = 0; $n < Testing::$maxRequests; $n++) {
+            $random = getRandomBytes();
+            $request = Psr7::createRequest(method: 'POST', uri: '/', body: Psr7::createStream($random));
+            $response = $client->sendRequest($request);
+            $this->assertSame($random, (string) $response->getBody());
+        }
+        $client->upgradeToWebSocket(Psr7::createRequest(method: 'GET', uri: '/chat'));
+        $random = getRandomBytes();
+        $client->sendWebSocketFrame(Psr7::createWebSocketTextFrame($random));
+        $this->assertSame($random, (string) $client->recvWebSocketFrame()->getPayloadData());
+        $client->close();
+        $wr::wait($wr);
+        $this->assertGreaterThan(0, Buffer::getPoolStats()['hits']);
+    }
+
+    /**
+     * Decrypted data which does not fit the buffer is held by SSL,
+     * the raw socket is not readable, but connection must not wait for more data
+     */
+    public function testReleaseIdleBufferWithCrypto(): void
+    {
+        if (!Extension::isBuiltWith('ssl')) {
+            $this->markTestSkipped('extension must be built with openssl');
+        }
+        Buffer::enablePool();
+        defer(static function (): void {
+            Buffer::disablePool();
+        });
+        $server = new Server();
+        $server->setReleaseIdleBuffer(true);
+        $server->bind('127.0.0.1')->listen();
+        $wr = new WaitReference();
+        Coroutine::run(static function () use ($server, $wr): void {
+            $connection = $server->acceptConnection();
+            $connection->enableCrypto([
+                'certificate' => __DIR__ . '/../../../../../ext/tests/include/ssl/server.crt',
+                'certificate_key' => __DIR__ . '/../../../../../ext/tests/include/ssl/server.key',
+            ]);
+            try {
+                while (true) {
+                    $request = $connection->recvHttpRequest();
+                    $connection->respond($request->getHeaderLine('X-Tag'));
+                }
+            } catch (SocketException) {
+                /* closed by client */
+            }
+        });
+        $client = new Socket(Socket::TYPE_TCP);
+        $client->connect($server->getSockAddress(), $server->getSockPort());
+        $client->enableCrypto(['verify_peer' => false, 'verify_peer_name' => false]);
+        $client->setReadTimeout(3000);
+        // two pipelined requests are sent by one write (one TLS record), and it is larger than the buffer
+        for ($size = Buffer::COMMON_SIZE - 1024; $size <= Buffer::COMMON_SIZE + 1024; $size += 128) {
+            $requests = '';
+            foreach (['A', 'B'] as $tag) {
+                $body = str_repeat('x', $tag === 'A' ? $size : 1);
+                $requests .= "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nX-Tag: {$tag}{$size}\r\nContent-Length: " . strlen($body) . "\r\n\r\n{$body}";
+            }
+            $client->send($requests);
+            $responses = '';
+            while (!str_contains($responses, "B{$size}")) {
+                $responses .= $client->recvStringData();
+            }
+            $this->assertStringContainsString("A{$size}", $responses);
+        }
+        $client->close();
+        $wr::wait($wr);
+    }
+}
\ No newline at end of file
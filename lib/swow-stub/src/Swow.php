@@ -720,6 +720,9 @@ namespace Swow
         public const STATE_WAITING = 1;
         public const STATE_RUNNING = 2;
         public const STATE_DEAD = 3;
+        public const PRIORITY_LOW = 0;
+        public const PRIORITY_NORMAL = 1;
+        public const PRIORITY_HIGH = 2;
 
         public function __construct(callable $callable) { }
 
@@ -773,6 +776,66 @@ namespace Swow
 
         public static function getGlobalSwitches(): int { }
 
+        /**
+         * Get statistics of the coroutine C stack pool
+         *
+         * @return array<string, int>
+         * @note the pool can be configured by env CAT_COROUTINE_STACK_POOL_SIZE and CAT_COROUTINE_STACK_POOL_HOT_SIZE
+         */
+        public static function getStackPoolStats(): array { }
+
+        public function getPriority(): int { }
+
+        /**
+         * Set the priority class which is used when the coroutine is in ready queue,
+         * coroutines of higher priority class are always resumed first, and the same class is FIFO
+         */
+        public function setPriority(int $priority): static { }
+
+        /**
+         * Get the watchdog quantum of the coroutine in nanoseconds, 0 means using the one of Watchdog::run()
+         */
+        public function getWatchdogQuantum(): int { }
+
+        /**
+         * Set how long the coroutine can run without switching before the watchdog alerts (and preempts) it,
+         * 0 means using the one of Watchdog::run(), a negative value exempts the coroutine from it.
+         * Notice: watchdog checks at the granularity of the lesser of its own quantum and this one,
+         * a positive value less than 1ms will be rounded up to 1ms
+         * @param int $quantum Nanoseconds
+         */
+        public function setWatchdogQuantum(int $quantum): static { }
+
+        public function getWatchdogThreshold(): int { }
+
+        /**
+         * Set the syscall blocking threshold of the coroutine,
+         * 0 means using the one of Watchdog::run(), a negative value disables it for the coroutine
+         * @param int $threshold Nanoseconds
+         */
+        public function setWatchdogThreshold(int $threshold): static { }
+
+        /**
+         * Defer coroutines woken up by timers and socket IO to the ready queue,
+         * then they will be resumed in priority order once per event loop round
+         *
+         * @param int $budgetCount max number of coroutines resumed in one round (0 means unlimited)
+         * @param int $budgetTime max time (in microseconds) spent on ready queue in one round (0 means unlimited)
+         * @note the rest of coroutines will wait for the next round if budget is exhausted
+         * @note it can also be enabled by env CAT_COROUTINE_READY_QUEUE, CAT_COROUTINE_READY_QUEUE_BUDGET_COUNT and CAT_COROUTINE_READY_QUEUE_BUDGET_TIME
+         */
+        public static function enableReadyQueue(int $budgetCount = 0, int $budgetTime = 0): void { }
+
+        /**
+         * Coroutines in ready queue will still be resumed by scheduler
+         */
+        public static function disableReadyQueue(): void { }
+
+        /**
+         * @return array{'enabled': bool, 'budget_count': int, 'budget_time': int, 'count': int, 'peak_count': int, 'rounds': int, 'exhausted_rounds': int, 'resumes': int}
+         */
+        public static function getReadyQueueStats(): array { }
+
         public function getStartTime(): int { }
 
         public function getEndTime(): int { }
@@ -999,6 +1062,35 @@ namespace Swow
          */
         public function pop(int $timeout = -1): mixed { }
 
+        /**
+         * push data from array into channel in batch
+         *
+         * @note it waits until at least one item can be pushed, then pushes as many as possible without waiting again,
+         * unbuffered channel always pushes one item at a time.
+         *
+         * @phan-param array<T> $data
+         * @phpstan-param array<T> $data
+         * @psalm-param array<T> $data
+         * @param array<mixed> $data
+         * @param int $timeout in microseconds
+         * @return int the number of items pushed (from the head of $data)
+         */
+        public function pushMany(array $data, int $timeout = -1): int { }
+
+        /**
+         * pop data from channel in batch
+         *
+         * @note it waits until at least one item can be popped, then pops as many as possible (up to $count) without waiting again,
+         * unbuffered channel always pops one item at a time.
+         *
+         * @param int $timeout in microseconds
+         * @phan-return list<T>
+         * @phpstan-return list<T>
+         * @psalm-return list<T>
+         * @return array<mixed>
+         */
+        public function popMany(int $count, int $timeout = -1): array { }
+
         public function close(): void { }
 
         public function getCapacity(): int { }
@@ -1215,6 +1307,28 @@ namespace Swow
 
         public function close(): void { }
 
+        /**
+         * Close the buffer and give its memory back to the buffer pool for reusing,
+         * it is the same as close() if pool is disabled, or the size of buffer is not the block size of pool,
+         * or the buffer is shared with others (e.g. a string returned by toString() is still alive)
+         * @return bool whether the memory was taken by pool
+         */
+        public function recycle(): bool { }
+
+        /**
+         * Buffers of $blockSize will be allocated from memory recycled by recycle() first,
+         * at most $maxSize blocks are kept in pool (0 means default), pool is disabled on request shutdown
+         */
+        public static function enablePool(int $blockSize = \Swow\Buffer::COMMON_SIZE, int $maxSize = 0): void { }
+
+        /**
+         * Release all memory kept in pool and disable it
+         */
+        public static function disablePool(): void { }
+
+        /** @return array<string, bool|int> */
+        public static function getPoolStats(): array { }
+
         public function __toString(): string { }
 
         /** @return array<string, mixed> debug information for var_dump */
@@ -1237,6 +1351,7 @@ namespace Swow
     {
         public const INVALID_FD = -1;
         public const DEFAULT_BACKLOG = 511;
+        public const DEFAULT_MAX_FRAME_LENGTH = 16777216;
         public const TYPE_FLAG_STREAM = 1;
         public const TYPE_FLAG_DGRAM = 2;
         public const TYPE_FLAG_INET = 16;
@@ -1275,6 +1390,7 @@ namespace Swow
         public const BIND_FLAG_IPV6ONLY = 1;
         public const BIND_FLAG_REUSEADDR = 2;
         public const BIND_FLAG_REUSEPORT = 4;
+        public const BIND_FLAG_REUSEPORT_CPU_AFFINITY = 8;
 
         public function __construct(int $type) { }
 
@@ -1342,11 +1458,51 @@ namespace Swow
          */
         public function acceptTo(self $connection, ?int $timeout = null): static { }
 
+        /**
+         * Wait for the first connection, then drain the accept queue without waiting
+         * @param int $timeout [optional] = $this->getAcceptTimeout()
+         * @return static[] at least one connection, at most $maxCount connections
+         */
+        public function acceptMany(int $maxCount = 64, ?int $timeout = null): array { }
+
+        /**
+         * Same as acceptMany() but accepts into the given lazy connections in order
+         * @param self[] $connections
+         * @param int $timeout [optional] = $this->getAcceptTimeout()
+         * @return int the number of accepted connections, the rest ones are untouched
+         */
+        public function acceptManyTo(array $connections, ?int $timeout = null): int { }
+
         /** @param int $timeout [optional] = $this->getConnectTimeout() */
         public function connect(string $name, int $port = 0, ?int $timeout = null): static { }
 
+        /**
+         * Server side session resumption options:
+         * - session_cache: use the in-process session cache, it is shared by the servers with the same options in one thread
+         * - session_cache_size: max size of session cache (0 means the default size)
+         * - session_timeout: session lifetime in seconds
+         * - session_ticket_key_file: session ticket keys file which can be shared by multi processes,
+         *   it consists of 80 bytes (or 48 bytes for AES128) keys, the first one is used to encrypt tickets,
+         *   it will be reloaded after it was changed, e.g. `openssl rand 80 > new.key && cat new.key current.key > ticket.key`
+         * - session_ticket_key_rotation: rotation interval (seconds) of generated ticket keys if key file is not used
+         * @param array<string, mixed>|null $options
+         */
         public function enableCrypto(?array $options = null): static { }
 
+        /**
+         * Get statistics of server side session resumption (sum of all session caches in the current thread)
+         *
+         * @return array<string, int>
+         */
+        public static function getCryptoSessionStats(): array { }
+
+        /**
+         * Get whether the kernel (kTLS) has taken over the record layer of the connection
+         *
+         * @return array{'send': bool, 'recv': bool}
+         */
+        public function getCryptoKtlsStatus(): array { }
+
         public function getSockAddress(): string { }
 
         public function getSockPort(): int { }
@@ -1630,6 +1786,94 @@ namespace Swow
          */
         public function peekStringFrom(int $size = \Swow\Buffer::COMMON_SIZE, &$address = null, &$port = null, ?int $timeout = 0): string { }
 
+        /**
+         * read a line from socket, the line ending ("\n" or "\r\n") is not included in the returned string,
+         * data after the line is kept in the read buffer of socket for further reading
+         *
+         * @note context switching may happen here
+         *
+         * @throws SocketException when line is longer than `$maxLength` (code is {@see Errno::EMSGSIZE})
+         * @throws SocketException when connection was closed before a line was received
+         * @throws SocketException when timed out
+         * @throws SocketException when socket read failed
+         * @param int $maxLength -1 meaning not limited, otherwise max length of line in bytes
+         * @param int|null $timeout timeout in microseconds or null for using {@see Socket::getReadTimeout()} value
+         */
+        public function readLine(int $maxLength = -1, ?int $timeout = null): string { }
+
+        /**
+         * read data from socket until `$delimiter` is received, the delimiter is consumed but not included in the returned string
+         *
+         * @note context switching may happen here
+         *
+         * @throws SocketException when message is longer than `$maxLength` (code is {@see Errno::EMSGSIZE})
+         * @throws SocketException when connection was closed before the delimiter was received
+         * @throws SocketException when timed out
+         * @throws SocketException when socket read failed
+         * @param non-empty-string $delimiter
+         * @param int $maxLength -1 meaning not limited, otherwise max length of message in bytes
+         * @param int|null $timeout timeout in microseconds or null for using {@see Socket::getReadTimeout()} value
+         */
+        public function readUntil(string $delimiter, int $maxLength = -1, ?int $timeout = null): string { }
+
+        /**
+         * read a length-prefixed frame from socket,
+         * frame length is `$lengthFieldOffset + $lengthFieldSize + <value of length field> + $lengthAdjustment`,
+         * and the first `$initialBytesToStrip` bytes of frame are not included in the returned string
+         *
+         * @note context switching may happen here
+         *
+         * @throws SocketException when frame is longer than `$maxLength` (code is {@see Errno::EMSGSIZE})
+         * @throws SocketException when length field is invalid (code is {@see Errno::EPROTO})
+         * @throws SocketException when connection was closed before the whole frame was received
+         * @throws SocketException when timed out
+         * @throws SocketException when socket read failed
+         * @param int<1, 8> $lengthFieldSize size of length field in bytes
+         * @param int $lengthFieldOffset bytes before length field
+         * @param int $lengthAdjustment e.g. `-($lengthFieldOffset + $lengthFieldSize)` if the length field counts the whole frame
+         * @param int|null $initialBytesToStrip null meaning strip the header (all bytes before the end of length field)
+         * @param int $maxLength max length of returned message in bytes, -1 meaning not limited (only for trusted peers)
+         * @param int|null $timeout timeout in microseconds or null for using {@see Socket::getReadTimeout()} value
+         */
+        public function readFrame(int $lengthFieldSize = 4, int $lengthFieldOffset = 0, int $lengthAdjustment = 0, ?int $initialBytesToStrip = null, bool $littleEndian = false, int $maxLength = self::DEFAULT_MAX_FRAME_LENGTH, ?int $timeout = null): string { }
+
+        /**
+         * get length of data which was read ahead by {@see Socket::readLine()}, {@see Socket::readUntil()}
+         * or {@see Socket::readFrame()} and has not been consumed yet
+         */
+        public function getReadBufferedLength(): int { }
+
+        /**
+         * receive a batch of datagrams from socket by one wakeup (and as few syscalls as possible),
+         * it waits until at least one datagram arrives, then receives the rest of arrived datagrams without blocking
+         *
+         * @note context switching may happen here
+         *
+         * @throws SocketException when timed out
+         * @throws SocketException when socket read failed
+         * @param int $maxCount max number of datagrams to receive
+         * @param int $size max size of each datagram in bytes, the excess part of datagram will be discarded
+         * @param int|null $timeout timeout in microseconds or null for using {@see Socket::getReadTimeout()} value
+         * @return list<array{0: string, 1: string, 2: int}> list of [data, address, port]
+         */
+        public function recvMultipleFrom(int $maxCount = 64, int $size = \Swow\Buffer::COMMON_SIZE, ?int $timeout = null): array { }
+
+        /**
+         * send a batch of datagrams by as few syscalls as possible
+         *
+         * @note context switching may happen here
+         *
+         * @throws SocketException when address is not a valid IP address
+         * @throws SocketException when timed out
+         * @throws SocketException when socket write failed (the number of sent datagrams is the return value of exception)
+         * @param non-empty-array<string|array{0: string, 1?: string|null, 2?: int|null}> $datagrams
+         *        list of data (to the connected peer) or [data, address, port], the result of {@see Socket::recvMultipleFrom()} is acceptable,
+         *        address must be an IP address, domain name resolution is not supported here
+         * @param int|null $timeout timeout in microseconds or null for using {@see Socket::getWriteTimeout()} value
+         * @return int the number of sent datagrams
+         */
+        public function sendMultipleTo(array $datagrams, ?int $timeout = null): int { }
+
         /**
          * write io vector to socket
          *
@@ -1732,6 +1976,56 @@ namespace Swow
          */
         public function sendFile(string $filename, int $offset = 0, int $length = 0, ?int $timeout = null): int { }
 
+        /**
+         * Buffer the following writes until {@see Socket::uncork()} is called,
+         * so that e.g. response header and body can be sent by one syscall (and one SSL record)
+         * @note buffered data will be flushed automatically if it grows too large or close() is called,
+         * and close() returns false if it can not be sent,
+         * but if the socket is closed by destructor, data which can not be sent at once will be dropped with a warning
+         */
+        public function cork(): static { }
+
+        /**
+         * Flush the buffered data and stop buffering
+         * @param int $timeout [optional] = $this->getWriteTimeout()
+         */
+        public function uncork(?int $timeout = null): static { }
+
+        /**
+         * Enable the native WebSocket frame codec on this stream socket (after the handshake was done)
+         * @param int $flags [optional] = \Swow\WebSocket\WebSocket::CODEC_FLAG_DEFAULT, CODEC_FLAG_CLIENT should be set on client side
+         * @param string $extensions [optional] the Sec-WebSocket-Extensions value of the handshake response,
+         * permessage-deflate is enabled if it is accepted, see {@see \Swow\WebSocket\WebSocket::negotiateDeflate()}
+         * @param int $maxMessageLength [optional] = \Swow\WebSocket\WebSocket::DEFAULT_MAX_MESSAGE_LENGTH, 0 means unlimited
+         * @param int $compressionLevel [optional] zlib compression level, -1 means default
+         */
+        public function enableWebSocket(int $flags = \Swow\WebSocket\WebSocket::CODEC_FLAG_DEFAULT, string $extensions = '', int $maxMessageLength = \Swow\WebSocket\WebSocket::DEFAULT_MAX_MESSAGE_LENGTH, int $compressionLevel = -1): static { }
+
+        /**
+         * Receive a whole WebSocket message (fragments are reassembled and compressed one is inflated),
+         * and append its payload to the buffer
+         * @param int $timeout [optional] = $this->getReadTimeout()
+         * @return int opcode of message, or opcode of control frame which is not answered automatically,
+         * the payload of control frame can be got by {@see Socket::getWebSocketControlPayload()}
+         */
+        public function recvWebSocketMessage(\Swow\Buffer $buffer, ?int $timeout = null): int { }
+
+        /** @return string the payload of the last received control frame */
+        public function getWebSocketControlPayload(): string { }
+
+        /**
+         * Send a message in a single WebSocket frame (it is masked on client side and may be compressed)
+         * @param int $opcode [optional] = \Swow\WebSocket\Opcode::TEXT
+         * @param int $timeout [optional] = $this->getWriteTimeout()
+         */
+        public function sendWebSocketMessage(\Stringable|string $data, int $opcode = \Swow\WebSocket\Opcode::TEXT, ?int $timeout = null): static { }
+
+        /**
+         * @param int $code [optional] = \Swow\WebSocket\Status::NORMAL_CLOSURE, 0 means no status code
+         * @param int $timeout [optional] = $this->getWriteTimeout()
+         */
+        public function sendWebSocketClose(int $code = \Swow\WebSocket\Status::NORMAL_CLOSURE, string $reason = '', ?int $timeout = null): static { }
+
         public function close(): bool { }
 
         /** @return bool Whether the socket has been constructed and has not been closed */
@@ -1752,6 +2046,8 @@ namespace Swow
 
         public function isClient(): bool { }
 
+        public function isCorked(): bool { }
+
         /**
          * @return int return Errno constants if the socket is broken, zero otherwise,
          * it's a silent version of {@see Socket::checkLiveness()}
@@ -1772,6 +2068,29 @@ namespace Swow
 
         public function getSendBufferSize(): int { }
 
+        /**
+         * Get the CPU which processes the incoming packets of the socket (Linux only)
+         */
+        public function getIncomingCpu(): int { }
+
+        /**
+         * Get accept statistics of the listening socket
+         * - count: number of accepted connections
+         * - rounds: number of accept wakeups, count / rounds is connections accepted per round
+         * - last_batch_size: connections accepted in the last round
+         * - max_batch_size: max connections accepted in one round
+         * - rate: average accepted connections per second since listen
+         * - uptime: milliseconds since listen
+         * - idle: milliseconds since the last accept
+         * - queue_length: connections waiting to be accepted (TCP on Linux only)
+         * - queue_capacity: max length of the accept queue (TCP on Linux only)
+         * - listen_overflows: system-wide accept queue overflows (TcpExt ListenOverflows, TCP on Linux only)
+         * - listen_drops: system-wide dropped SYNs of listeners (TcpExt ListenDrops, TCP on Linux only)
+         *
+         * @return array<string, int|float>
+         */
+        public function getAcceptStats(): array { }
+
         public function setRecvBufferSize(int $size): static { }
 
         public function setSendBufferSize(int $size): static { }
@@ -1780,6 +2099,26 @@ namespace Swow
 
         public function setTcpKeepAlive(bool $enable, int $delay): static { }
 
+        /**
+         * Gather writes from different coroutines into one writev() while the previous write is still in progress
+         */
+        public function setWriteCoalescing(bool $enable): static { }
+
+        /**
+         * Prefer this listener for connections processed on the given CPU (Linux only)
+         */
+        public function setIncomingCpu(int $cpu): static { }
+
+        /**
+         * Dispatch connections of the reuseport group to the listener whose index
+         * (bind order for UDP, listen order for TCP) is `receiving CPU % $groupSize` (Linux only),
+         * $groupSize = 0 means the number of CPUs.
+         * Notice: kernel moves the last member into the slot of the one which left the group,
+         * BIND_FLAG_REUSEPORT_CPU_AFFINITY avoids it by using SO_INCOMING_CPU of listeners (Linux >= 6.2)
+         * if the listener thread is bound to one CPU, and only falls back to this program otherwise
+         */
+        public function setReusePortCpuAffinity(int $groupSize = 0): static { }
+
         /** @return array<string, mixed> debug information for var_dump */
         public function __debugInfo(): array { }
 
@@ -1820,6 +2159,122 @@ namespace Swow
     class SocketException extends \Swow\CallException { }
 }
 
+namespace Swow
+{
+    /**
+     * @note the cache can also be configured by env CAT_DNS_CACHE_SIZE, CAT_DNS_CACHE_TTL and CAT_DNS_CACHE_NEGATIVE_TTL
+     */
+    class Dns
+    {
+        /**
+         * Resolve names by getaddrinfo() in the thread pool
+         */
+        public const RESOLVER_SYSTEM = 0;
+        /**
+         * Resolve names by DNS messages over UDP/TCP in coroutines
+         */
+        public const RESOLVER_NATIVE = 1;
+        public const TYPE_A = 1;
+        public const TYPE_CNAME = 5;
+        public const TYPE_AAAA = 28;
+        public const TYPE_SRV = 33;
+
+        /**
+         * Get statistics of the DNS cache
+         *
+         * @return array<string, int>
+         */
+        public static function getCacheStats(): array { }
+
+        /**
+         * Get all alive entries of the DNS cache, the most recently used one comes first
+         *
+         * @return array<int, array{'hostname': string, 'service': string, 'family': int, 'socktype': int, 'ttl': int, 'error': int, 'addresses': array<int, string>}>
+         */
+        public static function getCacheEntries(): array { }
+
+        /**
+         * Flush entries of the given hostname (all entries if it is null)
+         *
+         * @return int number of flushed entries
+         */
+        public static function flushCache(?string $hostname = null): int { }
+
+        /**
+         * @param int $size max number of entries, 0 means that cache is disabled
+         * @return int the original size
+         */
+        public static function setCacheSize(int $size): int { }
+
+        /**
+         * @param int $ttl milliseconds to cache a resolved name
+         * @param int|null $negativeTtl milliseconds to cache a non-existent name
+         */
+        public static function setCacheTtl(int $ttl, ?int $negativeTtl = null): void { }
+
+        /**
+         * Native resolver falls back to the system one if there is no nameserver
+         * or the query is not supported (e.g. non-numeric service)
+         *
+         * @param int $resolver one of Dns::RESOLVER_*
+         * @return int the original resolver
+         */
+        public static function setResolver(int $resolver): int { }
+
+        public static function getResolver(): int { }
+
+        /**
+         * Reload config of the native resolver
+         *
+         * @param string|null $resolvConf path of resolv.conf, null means the default one, empty string means none
+         * @param string|null $hosts path of hosts, null means the default one, empty string means none
+         */
+        public static function loadConfig(?string $resolvConf = null, ?string $hosts = null): void { }
+
+        /**
+         * @param string|array<string> $nameservers e.g. "127.0.0.1, [::1]:5353" or ["127.0.0.1", "[::1]:5353"]
+         */
+        public static function setNameservers(string|array $nameservers): void { }
+
+        /**
+         * Query records by the native resolver, CNAME records of the chain are included
+         *
+         * @return array<int, array{'name': string, 'type': int, 'ttl': int, 'address'?: string, 'target'?: string, 'priority'?: int, 'weight'?: int, 'port'?: int}>
+         */
+        public static function query(string $name, int $type = \Swow\Dns::TYPE_A, ?int $timeout = null): array { }
+    }
+}
+
+namespace Swow
+{
+    class DnsException extends \Swow\Exception { }
+}
+
+namespace Swow
+{
+    /**
+     * Settings of the runtime shared cURL multi handle (only available if extension is built with libcurl)
+     */
+    class Curl
+    {
+        /**
+         * Set the maximum number of connections to a single host
+         *
+         * @param int $max_host_connections 0 means unlimited
+         * @return int the original value
+         */
+        public static function setMaxHostConnections(int $max_host_connections): int { }
+
+        /**
+         * Set the maximum number of connections in total
+         *
+         * @param int $max_total_connections 0 means unlimited
+         * @return int the original value
+         */
+        public static function setMaxTotalConnections(int $max_total_connections): int { }
+    }
+}
+
 namespace Swow
 {
     class Signal
@@ -2107,6 +2562,73 @@ namespace Swow
     class SignalException extends \Swow\Exception { }
 }
 
+namespace Swow
+{
+    class Work
+    {
+        public const KIND_CPU = 0;
+        public const KIND_FAST_IO = 1;
+        public const KIND_SLOW_IO = 2;
+
+        public static function getPoolSize(int $kind): int { }
+
+        public static function setPoolSize(int $kind, int $size): void { }
+
+        /**
+         * @return array{'size': int, 'threads': int, 'running': int, 'queued': int, 'max_queued': int, 'submitted': int, 'completed': int, 'canceled': int, 'wait_time': int, 'max_wait_time': int, 'run_time': int, 'max_run_time': int}
+         */
+        public static function getPoolStats(int $kind): array { }
+
+        public static function hash(string $algo, string $data, bool $binary = false): string { }
+
+        /**
+         * @param array<string> $data
+         * @return array<string>
+         */
+        public static function hashMany(string $algo, array $data, bool $binary = false): array { }
+
+        public static function pbkdf2(string $algo, string $password, string $salt, int $iterations, int $length = 0, bool $binary = false): string { }
+    }
+}
+
+namespace Swow
+{
+    class WorkException extends \Swow\Exception { }
+}
+
+namespace Swow
+{
+    class Thread
+    {
+        /**
+         * @param array<mixed> $arguments
+         */
+        public function __construct(string $file, array $arguments = []) { }
+
+        public function getId(): int { }
+
+        public function isRunning(): bool { }
+
+        public function join(int $timeout = -1): int { }
+
+        public function send(mixed $value, int $timeout = -1): static { }
+
+        public static function receive(int $timeout = -1): mixed { }
+
+        public static function getParent(): ?\Swow\Thread { }
+
+        /**
+         * @return array<mixed>
+         */
+        public static function getArguments(): array { }
+    }
+}
+
+namespace Swow
+{
+    class ThreadException extends \Swow\Exception { }
+}
+
 namespace Swow
 {
     class Watchdog
@@ -2118,6 +2640,8 @@ namespace Swow
          * When it is callable, it will be called when blocking occurred, the developer can choose to suspend the coroutine or kill the coroutine;
          * when it is numeric, Coroutine will be delayed to run with sleep() in millisecond to alleviate CPU starvation;
          * when it is null, Coroutine will be delayed to run at the next round of the event loop starts to alleviate CPU starvation.
+         * Coroutine is interrupted at the next opcode, so it can not be preempted in the middle of an internal function call.
+         * Quantum and threshold can be overridden per coroutine by Coroutine::setWatchdogQuantum() and Coroutine::setWatchdogThreshold().
          * @return void
          */
         public static function run(int $quantum = 0, int $threshold = 0, callable|int|float|null $alerter = null): void { }
@@ -2399,6 +2923,13 @@ namespace Swow\Http
 
         public function reset(): static { }
 
+        /**
+         * Parse the whole request/status line and header block at once,
+         * the parser will be paused right after the headers, as if EVENT_HEADERS_COMPLETE was returned by execute().
+         * @return array{'method'?: string, 'uri'?: string, 'statusCode'?: int, 'reasonPhrase'?: string, 'protocolVersion': string, 'headers': array<string, array<string>>, 'headerNames': array<string, string>, 'contentLength': int, 'isChunked': bool, 'isUpgrade': bool, 'isMultipart': bool, 'shouldKeepAlive': bool, 'headLength': int}|null null if the head is incomplete
+         */
+        public function parseHead(\Stringable|string $data, int $start = 0, int $length = -1): ?array { }
+
         public static function getEventNameFor(int $event): string { }
     }
 }
@@ -2427,10 +2958,49 @@ namespace Swow\WebSocket
         public const DEFAULT_MASKING_KEY = '258E';
         public const PING_FRAME = "\x89\x00";
         public const PONG_FRAME = "\x8a\x80\x00\x00\x00\x00";
+        public const UTF8_ACCEPT = 0;
+        public const UTF8_REJECT = 12;
+        public const DEFLATE_EXTENSION_NAME = 'permessage-deflate';
+        public const DEFLATE_DEFAULT_OFFER = 'permessage-deflate; client_max_window_bits';
+        public const DEFAULT_MAX_MESSAGE_LENGTH = 16777216;
+        public const CODEC_FLAG_NONE = 0;
+        public const CODEC_FLAG_CLIENT = 1;
+        public const CODEC_FLAG_AUTO_PONG = 2;
+        public const CODEC_FLAG_AUTO_CLOSE = 4;
+        public const CODEC_FLAG_VALIDATE_UTF8 = 8;
+        public const CODEC_FLAG_DEFAULT = 14;
 
         public static function mask(\Stringable|string $data, int $start = 0, int $length = -1, string $maskingKey = '', int $index = 0): string { }
 
-        public static function unmask(\Swow\Buffer $data, int $start = 0, int $length = -1, string $maskingKey = '', int $index = 0): void { }
+        /**
+         * @param int|null $utf8State [optional] validate payload data as UTF-8 while unmasking if it is passed,
+         * it starts from UTF8_ACCEPT, and payload data is valid if it is still UTF8_ACCEPT at the end of the message
+         */
+        public static function unmask(\Swow\Buffer $data, int $start = 0, int $length = -1, string $maskingKey = '', int $index = 0, &$utf8State = null): void { }
+
+        /**
+         * Append unmasked data to the buffer, data is unmasked while copying
+         * @param int|null $utf8State [optional] same as unmask()
+         * @return int the length of appended data
+         */
+        public static function unmaskTo(\Swow\Buffer $buffer, \Stringable|string $data, int $start = 0, int $length = -1, string $maskingKey = '', int $index = 0, &$utf8State = null): int { }
+
+        /**
+         * @return string one of avx512, avx2, sse2, neon and scalar
+         */
+        public static function getMaskImplementation(): string { }
+
+        /**
+         * @return bool false if it is unknown or not supported by CPU
+         */
+        public static function setMaskImplementation(string $name): bool { }
+
+        /**
+         * Accept the permessage-deflate offer of client (Sec-WebSocket-Extensions value)
+         * @return string|null the Sec-WebSocket-Extensions value of response, null if there is no acceptable offer
+         * or zlib support is not enabled
+         */
+        public static function negotiateDeflate(string $offer): ?string { }
     }
 }
 
@@ -2533,3 +3103,46 @@ namespace Swow\Debug
 {
     function registerExtendedStatementHandler(callable $handler, bool $force = false): \Swow\Utils\Handler { }
 }
+
+namespace Swow\Debug
+{
+    /**
+     * @return array{'available': bool, 'running': bool, 'entries': int, 'pending': int, 'inflight': int, 'enters': int, 'submissions': int, 'completions': int, 'max_batch': int, 'recv_multishot': int, 'accept_multishot': int, 'send_zc': int, 'socket_engine': bool}
+     */
+    function getIoUringStats(): array { }
+}
+
+namespace Swow\Debug
+{
+    /**
+     * It is only for testing the lock-free channel which is shared between native threads,
+     * items are integers, and they can be pushed from a native producer thread
+     * @note it is only available if extension is built with debug
+     */
+    class ThreadChannel
+    {
+        public function __construct(int $capacity) { }
+
+        /** never block, return false if it is full or closed */
+        public function push(int $value): bool { }
+
+        public function pop(int $timeout = -1): int { }
+
+        /** never block, return null if it is empty */
+        public function tryPop(): ?int { }
+
+        public function close(): static { }
+
+        /** start a native thread which pushes [0, $count) and retries while the channel is full */
+        public function startProducer(int $count): static { }
+
+        /** @return int the number of items pushed by the producer */
+        public function joinProducer(): int { }
+
+        public function getCapacity(): int { }
+
+        public function getLength(): int { }
+
+        public function isAvailable(): bool { }
+    }
+}